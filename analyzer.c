@@ -0,0 +1,315 @@
+#include "analyzer.h"
+#include <math.h>
+#include <stdlib.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define ANALYZER_IDLE_SLEEP_MS 5
+
+// ============================================================================
+// TAP
+// ============================================================================
+
+void analyzer_tap_init(AnalyzerTap* tap, AnalyzerBlock* storage) {
+    tap->blocks = storage;
+    spsc_ring_init(&tap->ring, storage, sizeof(AnalyzerBlock), ANALYZER_RING_BLOCKS);
+    atomic_store(&tap->source, ANALYZER_SOURCE_NONE);
+    atomic_store(&tap->dropped_blocks, 0);
+}
+
+// ============================================================================
+// FFT
+// ============================================================================
+
+// In-place iterative radix-2 complex FFT of ANALYZER_FFT_SIZE on split arrays
+static void fft_forward(const Analyzer* analyzer, float* re, float* im) {
+    uint32_t n = ANALYZER_FFT_SIZE;
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t j = analyzer->bit_reverse[i];
+        if (j > i) {
+            float tr = re[i], ti = im[i];
+            re[i] = re[j];
+            im[i] = im[j];
+            re[j] = tr;
+            im[j] = ti;
+        }
+    }
+
+    for (uint32_t size = 2; size <= n; size <<= 1) {
+        uint32_t half = size >> 1;
+        uint32_t step = n / size;
+        for (uint32_t start = 0; start < n; start += size) {
+            for (uint32_t k = 0; k < half; k++) {
+                float wr = analyzer->twiddle_re[k * step];
+                float wi = analyzer->twiddle_im[k * step];
+                uint32_t a = start + k;
+                uint32_t b = a + half;
+                float xr = re[b] * wr - im[b] * wi;
+                float xi = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - xr;
+                im[b] = im[a] - xi;
+                re[a] += xr;
+                im[a] += xi;
+            }
+        }
+    }
+}
+
+// ============================================================================
+// PUBLISHING
+// ============================================================================
+
+static void publish_bands(Analyzer* analyzer, const float* bands) {
+    unsigned int seq = atomic_load_explicit(&analyzer->sequence, memory_order_relaxed);
+    atomic_store_explicit(&analyzer->sequence, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (int b = 0; b < ANALYZER_BANDS; b++) {
+        atomic_store_explicit(&analyzer->bands[b], bands[b], memory_order_relaxed);
+    }
+    atomic_store_explicit(&analyzer->sequence, seq + 2, memory_order_release);
+}
+
+static void publish_floor(Analyzer* analyzer) {
+    float bands[ANALYZER_BANDS];
+    for (int b = 0; b < ANALYZER_BANDS; b++) {
+        bands[b] = ANALYZER_FLOOR_DB;
+    }
+    publish_bands(analyzer, bands);
+}
+
+bool analyzer_read(Analyzer* analyzer, float bands[ANALYZER_BANDS]) {
+    for (int attempt = 0; attempt < 8; attempt++) {
+        unsigned int seq_begin = atomic_load_explicit(&analyzer->sequence, memory_order_acquire);
+        if (seq_begin & 1u) {
+            continue;
+        }
+        for (int b = 0; b < ANALYZER_BANDS; b++) {
+            bands[b] = atomic_load_explicit(&analyzer->bands[b], memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&analyzer->sequence, memory_order_relaxed) == seq_begin) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// ANALYSIS (worker thread)
+// ============================================================================
+
+// Window the last ANALYZER_FFT_SIZE samples (oldest first), transform and
+// fold the bins into bands: the loudest bin of a band is its level, so a
+// sine reads its amplitude whatever the band width
+static void transform(Analyzer* analyzer) {
+    uint32_t n = ANALYZER_FFT_SIZE;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t index = (analyzer->history_pos + i) & (n - 1);
+        analyzer->re[i] = analyzer->history[index] * analyzer->window[i];
+        analyzer->im[i] = 0.0f;
+    }
+    fft_forward(analyzer, analyzer->re, analyzer->im);
+
+    float bands[ANALYZER_BANDS];
+    for (int b = 0; b < ANALYZER_BANDS; b++) {
+        float power = 0.0f;
+        for (uint32_t k = analyzer->band_first[b]; k <= analyzer->band_last[b]; k++) {
+            float bin = analyzer->re[k] * analyzer->re[k] + analyzer->im[k] * analyzer->im[k];
+            power = bin > power ? bin : power;
+        }
+        float db = power > 0.0f ? 10.0f * log10f(power) : ANALYZER_FLOOR_DB;
+        bands[b] = db > ANALYZER_FLOOR_DB ? db : ANALYZER_FLOOR_DB;
+    }
+    publish_bands(analyzer, bands);
+    atomic_fetch_add_explicit(&analyzer->transforms, 1, memory_order_relaxed);
+}
+
+uint32_t analyzer_process(Analyzer* analyzer) {
+    uint32_t consumed = 0;
+    AnalyzerBlock block;
+    while (spsc_ring_pop(&analyzer->tap->ring, &block)) {
+        for (uint32_t i = 0; i < block.frames; i++) {
+            analyzer->history[analyzer->history_pos] = 0.5f * (block.left[i] + block.right[i]);
+            analyzer->history_pos = (analyzer->history_pos + 1) & (ANALYZER_FFT_SIZE - 1);
+            if (++analyzer->since_transform == ANALYZER_HOP_FRAMES) {
+                analyzer->since_transform = 0;
+                transform(analyzer);
+            }
+        }
+        consumed += block.frames;
+    }
+    return consumed;
+}
+
+static void analyzer_main(void* user_data) {
+    Analyzer* analyzer = (Analyzer*)user_data;
+    uint32_t idle_ms = 0;
+    bool floored = true;
+
+    while (atomic_load(&analyzer->running)) {
+        if (analyzer_process(analyzer) > 0) {
+            idle_ms = 0;
+            floored = false;
+            continue;
+        }
+        engine_thread_sleep_ms(ANALYZER_IDLE_SLEEP_MS);
+        idle_ms += ANALYZER_IDLE_SLEEP_MS;
+
+        // Transport stopped or source changed to something silent: let the
+        // display fall instead of freezing on the last spectrum
+        if (!floored && idle_ms >= ANALYZER_IDLE_MS) {
+            memset(analyzer->history, 0, sizeof(float) * ANALYZER_FFT_SIZE);
+            analyzer->since_transform = 0;
+            publish_floor(analyzer);
+            floored = true;
+        }
+    }
+}
+
+// ============================================================================
+// INIT / DESTROY
+// ============================================================================
+
+static void map_bands(Analyzer* analyzer) {
+    float bin_hz = (float)analyzer->sample_rate / ANALYZER_FFT_SIZE;
+    uint32_t nyquist_bin = ANALYZER_FFT_SIZE / 2;
+    float ratio = ANALYZER_MAX_HZ / ANALYZER_MIN_HZ;
+
+    for (int b = 0; b < ANALYZER_BANDS; b++) {
+        float low = ANALYZER_MIN_HZ * powf(ratio, (float)b / ANALYZER_BANDS);
+        float high = ANALYZER_MIN_HZ * powf(ratio, (float)(b + 1) / ANALYZER_BANDS);
+        float centre = sqrtf(low * high);
+        long first = (long)ceilf(low / bin_hz);
+        long last = (long)floorf(high / bin_hz);
+
+        // Bands narrower than a bin (the low end) read the nearest bin
+        if (last < first) {
+            first = last = lroundf(centre / bin_hz);
+        }
+        first = first < 1 ? 1 : first;
+        last = last < first ? first : last;
+        first = first > (long)nyquist_bin ? (long)nyquist_bin : first;
+        last = last > (long)nyquist_bin ? (long)nyquist_bin : last;
+        analyzer->band_first[b] = (uint32_t)first;
+        analyzer->band_last[b] = (uint32_t)last;
+        analyzer->band_hz[b] = centre;
+    }
+}
+
+bool analyzer_init(Analyzer* analyzer, AnalyzerTap* tap, uint32_t sample_rate) {
+    memset(analyzer, 0, sizeof(Analyzer));
+    analyzer->tap = tap;
+    analyzer->sample_rate = sample_rate;
+
+    uint32_t n = ANALYZER_FFT_SIZE;
+    analyzer->history = (float*)calloc(n, sizeof(float));
+    analyzer->window = (float*)malloc(sizeof(float) * n);
+    analyzer->re = (float*)malloc(sizeof(float) * n);
+    analyzer->im = (float*)malloc(sizeof(float) * n);
+    analyzer->twiddle_re = (float*)malloc(sizeof(float) * n / 2);
+    analyzer->twiddle_im = (float*)malloc(sizeof(float) * n / 2);
+    analyzer->bit_reverse = (uint32_t*)malloc(sizeof(uint32_t) * n);
+    if (!analyzer->history || !analyzer->window || !analyzer->re || !analyzer->im || !analyzer->twiddle_re ||
+        !analyzer->twiddle_im || !analyzer->bit_reverse) {
+        analyzer_destroy(analyzer);
+        return false;
+    }
+
+    // Hann window scaled by 2 / sum(w): a full-scale sine reads 0 dB
+    double sum = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        analyzer->window[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * (float)i / (float)n);
+        sum += analyzer->window[i];
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        analyzer->window[i] *= (float)(2.0 / sum);
+    }
+
+    for (uint32_t k = 0; k < n / 2; k++) {
+        double angle = -2.0 * M_PI * (double)k / (double)n;
+        analyzer->twiddle_re[k] = (float)cos(angle);
+        analyzer->twiddle_im[k] = (float)sin(angle);
+    }
+    uint32_t bits = 0;
+    while ((1u << bits) < n) {
+        bits++;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t reversed = 0;
+        for (uint32_t bit = 0; bit < bits; bit++) {
+            reversed |= ((i >> bit) & 1u) << (bits - 1 - bit);
+        }
+        analyzer->bit_reverse[i] = reversed;
+    }
+
+    map_bands(analyzer);
+    publish_floor(analyzer);
+    return true;
+}
+
+bool analyzer_start(Analyzer* analyzer) {
+    atomic_store(&analyzer->running, true);
+    if (!engine_thread_start(&analyzer->thread, analyzer_main, analyzer, ENGINE_THREAD_PRIORITY_LOW, -1)) {
+        atomic_store(&analyzer->running, false);
+        return false;
+    }
+    analyzer->started = true;
+    return true;
+}
+
+void analyzer_destroy(Analyzer* analyzer) {
+    if (analyzer->started) {
+        atomic_store(&analyzer->running, false);
+        engine_thread_join(&analyzer->thread);
+        analyzer->started = false;
+    }
+    free(analyzer->history);
+    free(analyzer->window);
+    free(analyzer->re);
+    free(analyzer->im);
+    free(analyzer->twiddle_re);
+    free(analyzer->twiddle_im);
+    free(analyzer->bit_reverse);
+    analyzer->history = NULL;
+    analyzer->window = NULL;
+    analyzer->re = NULL;
+    analyzer->im = NULL;
+    analyzer->twiddle_re = NULL;
+    analyzer->twiddle_im = NULL;
+    analyzer->bit_reverse = NULL;
+}
+
+// ============================================================================
+// UI BALLISTICS
+// ============================================================================
+
+void analyzer_display_init(AnalyzerDisplay* display) {
+    for (int b = 0; b < ANALYZER_BANDS; b++) {
+        display->bands[b] = ANALYZER_FLOOR_DB;
+    }
+}
+
+void analyzer_display_update(AnalyzerDisplay* display, Analyzer* analyzer, float dt) {
+    float latest[ANALYZER_BANDS];
+    if (!analyzer_read(analyzer, latest)) {
+        return;
+    }
+    float fall = ANALYZER_RELEASE_DB_PER_SEC * dt;
+    for (int b = 0; b < ANALYZER_BANDS; b++) {
+        float released = display->bands[b] - fall;
+        float level = latest[b] > released ? latest[b] : released;
+        display->bands[b] = level > ANALYZER_FLOOR_DB ? level : ANALYZER_FLOOR_DB;
+    }
+}
+
+bool analyzer_display_at_rest(const AnalyzerDisplay* display) {
+    for (int b = 0; b < ANALYZER_BANDS; b++) {
+        if (display->bands[b] > ANALYZER_FLOOR_DB) {
+            return false;
+        }
+    }
+    return true;
+}
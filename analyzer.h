@@ -0,0 +1,143 @@
+// analyzer.h - Spectrum analyzer fed by a lock-free audio tap
+// The audio thread copies raw planar blocks of one selected output (master
+// or a track) into an SPSC ring and does nothing else. A worker thread on
+// the UI side drains the ring into a sliding window, runs a Hann-windowed
+// FFT every ANALYZER_HOP_FRAMES (75% overlap), folds the bins into
+// log-spaced bands and publishes them through a seqlock. Display ballistics
+// are applied by the UI, as for the meters.
+#pragma once
+#ifndef ANALYZER_H
+#define ANALYZER_H
+
+#include "engine_thread.h"
+#include "spsc_ring.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// ============================================================================
+// CONSTANTS
+// ============================================================================
+
+#define ANALYZER_BLOCK_FRAMES 256           // Frames per ring element
+#define ANALYZER_RING_BLOCKS 64             // ~340 ms of audio at 48 kHz
+#define ANALYZER_FFT_SIZE 4096              // ~11.7 Hz bins at 48 kHz
+#define ANALYZER_HOP_FRAMES (ANALYZER_FFT_SIZE / 4)
+#define ANALYZER_BANDS 96
+#define ANALYZER_MIN_HZ 20.0f
+#define ANALYZER_MAX_HZ 20000.0f
+#define ANALYZER_FLOOR_DB -90.0f            // Reported for silence
+#define ANALYZER_IDLE_MS 200                // Worker publishes the floor after this long without audio
+
+// Tap sources (anything >= 0 is a track index)
+#define ANALYZER_SOURCE_NONE -2
+#define ANALYZER_SOURCE_MASTER -1
+
+// ============================================================================
+// TAP (audio thread writes, analyzer worker reads)
+// ============================================================================
+
+typedef struct {
+    uint32_t frames;                        // Valid frames in left/right
+    float left[ANALYZER_BLOCK_FRAMES];
+    float right[ANALYZER_BLOCK_FRAMES];
+} AnalyzerBlock;
+
+typedef struct {
+    SpscRing ring;                          // of AnalyzerBlock
+    AnalyzerBlock* blocks;                  // Ring storage (caller owned)
+    atomic_int source;                      // ANALYZER_SOURCE_* or a track index
+    atomic_uint_fast64_t dropped_blocks;    // Ring was full (worker behind)
+} AnalyzerTap;
+
+// Initialize over caller-owned storage of ANALYZER_RING_BLOCKS blocks.
+// The tap starts with ANALYZER_SOURCE_NONE selected.
+void analyzer_tap_init(AnalyzerTap* tap, AnalyzerBlock* storage);
+
+// Audio thread: copy a planar block into the ring, split into
+// ANALYZER_BLOCK_FRAMES pieces. Drops (and counts) what does not fit.
+static inline void analyzer_tap_write(AnalyzerTap* tap, const float* left, const float* right,
+                                      uint32_t frame_count) {
+    for (uint32_t offset = 0; offset < frame_count; offset += ANALYZER_BLOCK_FRAMES) {
+        AnalyzerBlock* block = (AnalyzerBlock*)spsc_ring_acquire_push(&tap->ring);
+        if (!block) {
+            atomic_fetch_add_explicit(&tap->dropped_blocks, 1, memory_order_relaxed);
+            return;
+        }
+        uint32_t frames = frame_count - offset;
+        frames = frames < ANALYZER_BLOCK_FRAMES ? frames : ANALYZER_BLOCK_FRAMES;
+        block->frames = frames;
+        memcpy(block->left, left + offset, sizeof(float) * frames);
+        memcpy(block->right, right + offset, sizeof(float) * frames);
+        spsc_ring_commit_push(&tap->ring);
+    }
+}
+
+// ============================================================================
+// ANALYZER (worker thread computes, UI reads)
+// ============================================================================
+
+typedef struct {
+    AnalyzerTap* tap;
+    uint32_t sample_rate;
+
+    // Worker state
+    float* history;                         // Last ANALYZER_FFT_SIZE mono samples (circular)
+    uint32_t history_pos;
+    uint32_t since_transform;               // Samples since the last FFT
+    float* window;                          // Hann, with amplitude normalisation folded in
+    float* re;
+    float* im;
+    float* twiddle_re;
+    float* twiddle_im;
+    uint32_t* bit_reverse;
+    uint32_t band_first[ANALYZER_BANDS];    // FFT bin range of each band
+    uint32_t band_last[ANALYZER_BANDS];
+    float band_hz[ANALYZER_BANDS];          // Band centres
+
+    // Latest spectrum (dB per band), seqlock-published like MeterChannel
+    _Alignas(64) atomic_uint sequence;
+    _Atomic float bands[ANALYZER_BANDS];
+    atomic_uint_fast64_t transforms;        // FFTs run so far
+
+    atomic_bool running;
+    bool started;
+    EngineThread thread;
+} Analyzer;
+
+// Allocate the FFT tables and band map for `sample_rate`
+bool analyzer_init(Analyzer* analyzer, AnalyzerTap* tap, uint32_t sample_rate);
+
+// Start the worker thread (optional: analyzer_process can be called directly)
+bool analyzer_start(Analyzer* analyzer);
+
+// Stop the worker and free everything
+void analyzer_destroy(Analyzer* analyzer);
+
+// Drain the tap, transforming every hop. Returns the frames consumed.
+// Worker thread only (or the owner, when no worker was started).
+uint32_t analyzer_process(Analyzer* analyzer);
+
+// Copy the latest spectrum. Returns false if the worker kept interfering.
+bool analyzer_read(Analyzer* analyzer, float bands[ANALYZER_BANDS]);
+
+// ============================================================================
+// UI BALLISTICS (UI thread only)
+// ============================================================================
+
+#define ANALYZER_RELEASE_DB_PER_SEC 40.0f   // Band fall rate (rises are instant)
+
+typedef struct {
+    float bands[ANALYZER_BANDS];            // Displayed levels, dB
+} AnalyzerDisplay;
+
+void analyzer_display_init(AnalyzerDisplay* display);
+
+// Read the latest spectrum and advance the ballistics by dt seconds
+void analyzer_display_update(AnalyzerDisplay* display, Analyzer* analyzer, float dt);
+
+// Every band has fallen to the floor
+bool analyzer_display_at_rest(const AnalyzerDisplay* display);
+
+#endif // ANALYZER_H
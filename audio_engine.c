@@ -2,403 +2,3577 @@
 #include "vendor/miniaudio/miniaudio.h"
 
 #include "audio_engine.h"
-#include <raylib.h>
+#include "automation.h"
+#include "dsp_kernels.h"
+#include "oscillator.h"
+#include "engine_log.h"
+#include "engine_thread.h"
+#include "engine_trace.h"
+#include "pdc.h"
+#include "render_graph.h"
+#include "voice_pool.h"
 #include <stdatomic.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 
+_Static_assert(ENGINE_MAX_BLOCK_FRAMES <= PDC_MAX_BLOCK_FRAMES, "Blocks must fit the compensation lines");
+
 // ============================================================================
 // LOGGING
 // ============================================================================
 
+// miniaudio logs from the device thread too (reroutes, errors); engine_log
+// keeps that off stdio while the asynchronous log is running
 static void miniaudio_log_callback(void* pUserData, unsigned int level, const char* pMessage) {
     (void)pUserData;
 
-    int raylib_level = LOG_INFO;
+    EngineLogLevel engine_level = ENGINE_LOG_INFO;
 
     switch (level) {
         case MA_LOG_LEVEL_DEBUG:
-            raylib_level = LOG_DEBUG;
+            engine_level = ENGINE_LOG_DEBUG;
             break;
         case MA_LOG_LEVEL_INFO:
-            raylib_level = LOG_INFO;
+            engine_level = ENGINE_LOG_INFO;
             break;
         case MA_LOG_LEVEL_WARNING:
-            raylib_level = LOG_WARNING;
+            engine_level = ENGINE_LOG_WARNING;
             break;
         case MA_LOG_LEVEL_ERROR:
-            raylib_level = LOG_ERROR;
+            engine_level = ENGINE_LOG_ERROR;
             break;
         default:
-            raylib_level = LOG_INFO;
+            engine_level = ENGINE_LOG_INFO;
 
     }
-    TraceLog(raylib_level, "[miniaudio]: %s", pMessage);
+    engine_log(engine_level, "[miniaudio]: %s", pMessage);
 }
 
 // ============================================================================
 // EFFECT PROCESSING
 // ============================================================================
 
-static float process_gain_effect(float sample, Effect* effect) {
-    if (!effect->enabled) { return sample; }
-    return sample * effect->gain_params.gain;
+// Run a track's or bus's effects, in the order given by the render graph.
+// Each instance processes the whole block through its type's vtable (at its
+// own rate, see effect_process), with its own state block, so stacked
+// filters no longer share memory.
+// With effect_ns set (profiling), each effect's time is added to its slot.
+static void process_effect_chain(const DspKernels* dsp, EffectChain* chain, const int* effect_slots,
+                                 int effect_count, float* left, float* right, ma_uint32 frame_count,
+                                 atomic_uint_fast64_t* effect_ns) {
+    for (int i = 0; i < effect_count; i++) {
+        Effect* effect = &chain->effects[effect_slots[i]];
+        if (!effect->enabled) {
+            // Latent effects keep their delay, or the compensation goes wrong
+            effect_bypass(effect, dsp, left, right, frame_count);
+            continue;
+        }
+        ENGINE_TRACE_BEGIN(effect_vtable(effect->type)->name);
+        uint64_t start_ns = effect_ns ? engine_thread_time_ns() : 0;
+        effect_process(effect, dsp, left, right, frame_count);
+        if (effect_ns) {
+            atomic_fetch_add_explicit(&effect_ns[effect_slots[i]], engine_thread_time_ns() - start_ns,
+                                      memory_order_relaxed);
+        }
+        ENGINE_TRACE_END(effect_vtable(effect->type)->name);
+    }
 }
 
-static float process_lowpass_effect(float sample, Effect* effect, float* state) {
-    if (!effect->enabled) { return sample; }
+// ============================================================================
+// COMMAND PROCESSING (AUDIO THREAD)
+// ============================================================================
 
-    // Simple one-pole lowpass filter
-    // alpha = cutoff / (cutoff + 1)
-    float cutoff = effect->filter_params.cutoff;
-    float alpha = cutoff / (cutoff + 1.0f);
-    *state = alpha * sample + (1.0f - alpha) * (*state);
-    return *state;
+static void effect_set_param(Effect* effect, int param_index, float value) {
+    effect_vtable(effect->type)->set_param(effect, param_index, value);
 }
 
-static float process_highpass_effect(float sample, Effect* effect, float* state) {
-    if (!effect->enabled) return sample;
+static void apply_bus_command(AudioEngine* engine, const EngineCommand* cmd) {
+    if (cmd->bus_index < 0 || cmd->bus_index >= MAX_BUSES) return;
+    Bus* bus = &engine->buses[cmd->bus_index];
 
-    // Simple one-pole highpass filter
-    float cutoff = effect->filter_params.cutoff;
-    float alpha = 1.0f / (cutoff + 1.0f);
-    float output = sample - *state;
-    *state = *state + alpha * output;
-    return output;
+    switch (cmd->type) {
+        case CMD_SET_BUS_VOLUME:
+            bus->volume = cmd->value;
+            break;
+        case CMD_SET_BUS_MUTE:
+            atomic_store_explicit(&bus->mute, cmd->flag, memory_order_relaxed);
+            break;
+        case CMD_TOGGLE_BUS_EFFECT:
+            if (cmd->effect_slot >= 0 && cmd->effect_slot < MAX_EFFECTS_PER_TRACK) {
+                bus->chain.effects[cmd->effect_slot].enabled = !bus->chain.effects[cmd->effect_slot].enabled;
+            }
+            break;
+        case CMD_SET_BUS_EFFECT_PARAM:
+            if (cmd->effect_slot >= 0 && cmd->effect_slot < MAX_EFFECTS_PER_TRACK) {
+                effect_set_param(&bus->chain.effects[cmd->effect_slot], cmd->param_index, cmd->value);
+            }
+            break;
+        default:
+            break;
+    }
 }
 
-static void process_track_effects(Track* track, int track_idx, float* left, float* right, ma_uint32 frame_count) {
-    // Static filter state per track (survives across callbacks)
-    static float filter_state_l[MAX_TRACKS] = {0};
-    static float filter_state_r[MAX_TRACKS] = {0};
+static void apply_command(AudioEngine* engine, const EngineCommand* cmd) {
+    switch (cmd->type) {
+        case CMD_SET_PLAYING:
+            atomic_store(&engine->playing, cmd->flag);
+            return;
+        case CMD_SET_MASTER_VOLUME:
+            engine->master_volume = cmd->value;
+            return;
+        case CMD_SET_TRANSPORT_POSITION:
+            engine->transport_frame = cmd->frame;
+            return;
+        case CMD_SET_BUS_VOLUME:
+        case CMD_SET_BUS_MUTE:
+        case CMD_TOGGLE_BUS_EFFECT:
+        case CMD_SET_BUS_EFFECT_PARAM:
+            apply_bus_command(engine, cmd);
+            return;
+        default:
+            break;
+    }
 
-    for (int i = 0; i < track->effect_count; i++) {
-        Effect* effect = &track->effects[i];
+    // A command is sent after its track's chunk was stored, and the queue
+    // publishes that store, so the track may not be in a graph yet (it was
+    // published after this callback acquired its graph)
+    if (cmd->track_index < 0 || cmd->track_index >= MAX_TRACKS) return;
+    TrackChunk* chunk = track_store_chunk(&engine->tracks, cmd->track_index);
+    if (!chunk) return;
+    int lane = track_lane(cmd->track_index);
+    TrackMixLanes* mix = &chunk->mix;
+    Track* track = &chunk->tracks[lane];
+
+    switch (cmd->type) {
+        case CMD_SET_TRACK_VOLUME:
+            mix->volume[lane] = cmd->value;
+            break;
+        case CMD_SET_TRACK_PAN:
+            mix->pan[lane] = cmd->value;
+            break;
+        case CMD_SET_TRACK_MUTE:
+            atomic_store_explicit(&mix->mute[lane], cmd->flag, memory_order_relaxed);
+            break;
+        case CMD_SET_TRACK_SOLO:
+            atomic_store_explicit(&mix->solo[lane], cmd->flag, memory_order_relaxed);
+            break;
+        case CMD_SET_TRACK_PLAYING:
+            atomic_store(&mix->playing[lane], cmd->flag);
+            break;
+        case CMD_SET_TRACK_SEND:
+            if (cmd->bus_index >= 0 && cmd->bus_index < MAX_BUSES) {
+                track->send_level[cmd->bus_index] = cmd->value;
+            }
+            break;
+        case CMD_TOGGLE_EFFECT:
+            if (cmd->effect_slot >= 0 && cmd->effect_slot < MAX_EFFECTS_PER_TRACK) {
+                track->chain.effects[cmd->effect_slot].enabled = !track->chain.effects[cmd->effect_slot].enabled;
+            }
+            break;
+        case CMD_SET_EFFECT_PARAM:
+            if (cmd->effect_slot >= 0 && cmd->effect_slot < MAX_EFFECTS_PER_TRACK) {
+                effect_set_param(&track->chain.effects[cmd->effect_slot], cmd->param_index, cmd->value);
+            }
+            break;
+        case CMD_NOTE_ON:
+            if (track->instrument) voice_pool_note_on(&track->voices, cmd->note, cmd->value);
+            break;
+        case CMD_NOTE_OFF:
+            if (track->instrument) voice_pool_note_off(&track->voices, cmd->note);
+            break;
+        case CMD_ALL_NOTES_OFF:
+            if (track->instrument) voice_pool_release_all(&track->voices);
+            break;
+        case CMD_SET_TRACK_ARMED:
+            atomic_store_explicit(&mix->armed[lane], cmd->flag, memory_order_relaxed);
+            if (!cmd->flag && track->instrument) voice_pool_release_all(&track->voices);
+            break;
+        case CMD_SET_TRACK_INPUT:
+            atomic_store_explicit(&mix->input[lane], cmd->flag, memory_order_relaxed);
+            break;
+        default:
+            break;
+    }
+}
 
-        switch (effect->type) {
-            case EFFECT_GAIN:
-                for (ma_uint32 f = 0; f < frame_count; f++) {
-                    left[f] = process_gain_effect(left[f], effect);
-                    right[f] = process_gain_effect(right[f], effect);
-                }
-                break;
+static void drain_commands(AudioEngine* engine) {
+    EngineCommand cmd;
+    uint32_t applied = 0;
+    while (spsc_ring_pop(&engine->command_queue, &cmd)) {
+        apply_command(engine, &cmd);
+        applied++;
+    }
+    if (applied > 0) {
+        atomic_fetch_add_explicit(&engine->commands_applied, applied, memory_order_release);
+    }
+}
 
-            case EFFECT_LOWPASS:
-                for (ma_uint32 f = 0; f < frame_count; f++) {
-                    left[f] = process_lowpass_effect(left[f], effect, &filter_state_l[track_idx]);
-                    right[f] = process_lowpass_effect(right[f], effect, &filter_state_r[track_idx]);
-                }
-                break;
+// ============================================================================
+// LIVE MIDI (REAL-TIME AUDIO THREAD)
+// ============================================================================
 
-            case EFFECT_HIGHPASS:
-                for (ma_uint32 f = 0; f < frame_count; f++) {
-                    left[f] = process_highpass_effect(left[f], effect, &filter_state_l[track_idx]);
-                    right[f] = process_highpass_effect(right[f], effect, &filter_state_r[track_idx]);
-                }
+// Play one event on a track: notes on instruments, a few controllers on
+// any track. A frozen track's fader is in its render, and thawing is the
+// control thread's to do, so volume and pan controllers leave it alone.
+static void apply_midi_to_track(TrackChunk* chunk, int lane, const MidiEvent* event, bool frozen) {
+    Track* track = &chunk->tracks[lane];
+    uint8_t type = event->status & 0xF0;
+    if (type == MIDI_NOTE_ON && track->instrument) {
+        voice_pool_note_on(&track->voices, event->data1, (float)event->data2 / 127.0F);
+    } else if (type == MIDI_NOTE_OFF && track->instrument) {
+        voice_pool_note_off(&track->voices, event->data1);
+    } else if (type == MIDI_CONTROL_CHANGE) {
+        switch (event->data1) {
+            case MIDI_CC_VOLUME:
+                if (!frozen) chunk->mix.volume[lane] = (float)event->data2 / 127.0F;
                 break;
-
-            case EFFECT_DELAY:
-                // TODO: Implement delay effect with circular buffer
+            case MIDI_CC_PAN: {
+                if (frozen) break;
+                float pan = (float)((int)event->data2 - 64) / 63.0F;
+                chunk->mix.pan[lane] = pan < -1.0F ? -1.0F : pan;
                 break;
-
-            case EFFECT_REVERB:
-                // TODO: Implement reverb effect
+            }
+            case MIDI_CC_ALL_SOUND_OFF:
+            case MIDI_CC_ALL_NOTES_OFF:
+                if (track->instrument) voice_pool_release_all(&track->voices);
                 break;
-
             default:
                 break;
         }
     }
 }
 
+// Play an event on every armed track in the graph, capturing it while the
+// transport runs
+static void apply_midi_event(AudioEngine* engine, const RenderGraph* graph, const MidiEvent* event) {
+    if (!graph) return;
+    bool recording = atomic_load_explicit(&engine->playing, memory_order_relaxed);
+    for (int t = 0; t < graph->track_count; t++) {
+        const RenderTrack* rt = &graph->tracks[t];
+        int track_index = rt->track_index;
+        if (!atomic_load_explicit(&rt->chunk->mix.armed[rt->lane], memory_order_relaxed)) continue;
+
+        apply_midi_to_track(rt->chunk, rt->lane, event, rt->frozen != NULL);
+        if (recording) {
+            RecordedMidiEvent recorded = {
+                .frame = engine->transport_frame,
+                .track_index = track_index,
+                .status = event->status,
+                .data1 = event->data1,
+                .data2 = event->data2,
+            };
+            if (!spsc_ring_push(&engine->recorded_midi, &recorded)) {
+                atomic_fetch_add_explicit(&engine->midi_record_overflows, 1, memory_order_relaxed);
+            }
+        }
+    }
+}
+
+// Start a period on the MIDI clock and return when the previous one
+// started. Events stamped before this period began are due in it, placed
+// at the same distance from its start as they arrived after the previous
+// one's. Offline-only engines run the clock on rendered frames instead of
+// wall time, so injected events land on exact frames.
+static uint64_t begin_midi_period(AudioEngine* engine, ma_uint32 frame_count) {
+    uint64_t previous_ns = engine->midi_block_ns;
+    if (engine->config.offline_only) {
+        engine->midi_block_ns += (uint64_t)frame_count * 1000000000ULL / engine->sample_rate;
+    } else {
+        engine->midi_block_ns = engine_thread_time_ns();
+    }
+    return previous_ns;
+}
+
 // ============================================================================
 // AUDIO CALLBACK (REAL-TIME AUDIO THREAD)
 // ============================================================================
 
-static void audio_callback(ma_device* device, void* output_buffer, const void* input_buffer, ma_uint32 frame_count) {
-    (void)input_buffer;
+// Publish an empty record so meters of tracks that did not render fall back
+static void publish_silent_meter(MeterChannel* channel, uint64_t block_frame) {
+    MeterRecord record = {
+        .clip_count = meter_channel_clip_count(channel),
+        .block_frame = block_frame,
+    };
+    meter_channel_publish(channel, &record);
+}
 
-    AudioEngine* engine = (AudioEngine*)device->pUserData;
-    float* out = (float*)output_buffer;
+// Meter a block; returns its peak over both channels
+static float measure_block(const DspKernels* dsp, StereoBuffer* buffer, ma_uint32 frame_count) {
+    MeterAccumulator* acc = &buffer->meter;
+    const float* channels[2] = {buffer->left, buffer->right};
+    float block_peak = 0.0F;
+    for (int c = 0; c < 2; c++) {
+        float peak = 0.0F;
+        float sum_squares = 0.0F;
+        uint32_t clips = 0;
+        dsp->measure(channels[c], frame_count, METER_CLIP_LEVEL, &peak, &sum_squares, &clips);
+        if (peak > acc->peak[c]) acc->peak[c] = peak;
+        if (peak > block_peak) block_peak = peak;
+        acc->sum_squares[c] += sum_squares;
+        acc->clips += clips;
+    }
+    acc->frames += frame_count;
+    return block_peak;
+}
 
-    if (!atomic_load(&engine->playing)) {
-        memset(out, 0, frame_count * CHANNELS * sizeof(float));
+static bool block_is_silent(const DspKernels* dsp, const float* left, const float* right, ma_uint32 frame_count) {
+    const float* channels[2] = {left, right};
+    for (int c = 0; c < 2; c++) {
+        float peak = 0.0F;
+        float sum_squares = 0.0F;
+        uint32_t clips = 0;
+        dsp->measure(channels[c], frame_count, METER_CLIP_LEVEL, &peak, &sum_squares, &clips);
+        if (peak >= ENGINE_SILENCE_LEVEL) return false;
+    }
+    return true;
+}
+
+// Idle bypass. Once a chain's input and output have both stayed silent for
+// longer than its tail, it sleeps: while its input stays silent the whole
+// track or bus is skipped, effects and metering included. Any sound on the
+// input wakes it. Big sessions are mostly silent at any one moment.
+static void update_idle(EffectChain* chain, bool input_silent, float output_peak, uint32_t tail_frames,
+                        ma_uint32 frame_count) {
+    if (!input_silent || output_peak >= ENGINE_SILENCE_LEVEL) {
+        chain->quiet_frames = 0;
+        chain->asleep = false;
         return;
     }
+    if (chain->quiet_frames <= UINT32_MAX - frame_count) {
+        chain->quiet_frames += frame_count;
+    }
+    chain->asleep = chain->quiet_frames > tail_frames;
+}
 
-    // Clear output buffer
-    memset(out, 0, frame_count * CHANNELS * sizeof(float));
+#define TRACK_OUTPUT_SCALE 0.3F     // Headroom for the test oscillators
 
-    // Reset master meters
-    engine->master_peak[0] = 0.0F;
-    engine->master_peak[1] = 0.0F;
-    engine->master_rms[0] = 0.0F;
-    engine->master_rms[1] = 0.0F;
+// Shared, read-only inputs for the per-track render jobs of one sub-block
+typedef struct {
+    AudioEngine* engine;
+    const RenderGraph* graph;
+    bool any_solo;
+    ma_uint32 frame_count;
+    uint64_t transport_frame;   // Timeline position of the sub-block's first frame
+    const float* input;         // Device input for the sub-block (interleaved), NULL if none
+} RenderContext;
 
-    // Check if any tracks are soloed
-    bool any_solo = false;
-    for (int t = 0; t < engine->track_count; t++) {
-        if (engine->tracks[t].solo) {
-            any_solo = true;
-            break;
-        }
+static void deinterleave(const float* in, float* left, float* right, ma_uint32 frame_count) {
+    for (ma_uint32 i = 0; i < frame_count; i++) {
+        left[i] = in[i * CHANNELS];
+        right[i] = in[i * CHANNELS + 1];
     }
+}
 
-    // Mix all tracks
-    for (int t = 0; t < engine->track_count; t++) {
-        Track* track = &engine->tracks[t];
+// Constant-power L/R gains of a track at a transport frame
+static void track_gains_at(const RenderTrack* rt, uint64_t frame, float gains[2]) {
+    const TrackMixLanes* mix = &rt->chunk->mix;
+    float volume = rt->volume_lane ? automation_lane_value_at(rt->volume_lane, frame) : mix->volume[rt->lane];
+    float pan = rt->pan_lane ? automation_lane_value_at(rt->pan_lane, frame) : mix->pan[rt->lane];
+    if (pan < -1.0F) pan = -1.0F;
+    if (pan > 1.0F) pan = 1.0F;
+    gains[0] = cosf((pan + 1.0F) * MA_PI / 4.0F) * volume * TRACK_OUTPUT_SCALE;
+    gains[1] = sinf((pan + 1.0F) * MA_PI / 4.0F) * volume * TRACK_OUTPUT_SCALE;
+}
 
-        if (track->mute || !atomic_load(&track->playing)) continue;
+// Automated track: set effect parameters for the block, then cut it at
+// every volume/pan breakpoint. Lanes are linear between cuts, so each
+// segment is one gain ramp from its first to its last frame's gains; a
+// breakpoint step lands on exactly the right sample. Effect parameters take
+// the lane's value at the block's last frame: effects that glide to a new
+// value across the block (gain, filters) then follow the lane whatever the
+// block size.
+static void apply_track_automation(const RenderContext* ctx, const RenderTrack* rt, Track* track, float* left,
+                                   float* right, ma_uint32 frame_count) {
+    const DspKernels* dsp = ctx->engine->dsp;
+    uint64_t last_frame = ctx->transport_frame + (frame_count > 0 ? frame_count - 1 : 0);
+    for (int i = 0; i < rt->effect_lane_count; i++) {
+        const RenderEffectLane* effect_lane = &rt->effect_lanes[i];
+        effect_set_param(&track->chain.effects[effect_lane->effect_slot], effect_lane->param_index,
+                         automation_lane_value_at(effect_lane->lane, last_frame));
+    }
 
-        if (any_solo && !track->solo) continue;
+    const AutomationLane* lanes[2] = {rt->volume_lane, rt->pan_lane};
+    uint32_t cuts[AUTOMATION_MAX_CUTS];
+    uint32_t cut_count = automation_block_cuts(lanes, 2, ctx->transport_frame, frame_count, cuts);
+    float first[2];
+    float last[2];
+    for (uint32_t c = 0; c + 1 < cut_count; c++) {
+        uint32_t start = cuts[c];
+        uint32_t length = cuts[c + 1] - start;
+        track_gains_at(rt, ctx->transport_frame + start, first);
+        track_gains_at(rt, ctx->transport_frame + start + length - 1, last);
+        float steps = length > 1 ? (float)(length - 1) : 1.0F;
+        dsp->gain_ramp(left + start, first[0], (last[0] - first[0]) / steps, length);
+        dsp->gain_ramp(right + start, first[1], (last[1] - first[1]) / steps, length);
+    }
 
-        // Reset track meters
-        track->peak_level[0] = 0.0F;
-        track->peak_level[1] = 0.0F;
-        track->rms_level[0] = 0.0F;
-        track->rms_level[1] = 0.0F;
+    // Continue from here if the lanes are removed
+    track_gains_at(rt, ctx->transport_frame + frame_count, track->output_gain);
+}
 
-        // Temporary buffers for effect processing
-        float temp_left[BUFFER_SIZE];
-        float temp_right[BUFFER_SIZE];
+// Source, fader and effect chain of a track into its buffer: what a frozen
+// track plays back instead. The live input, if any, is already in place.
+// Returns false if the track stayed silent without rendering (asleep).
+static bool render_track_chain(const RenderContext* ctx, const RenderTrack* rt, Track* track, StereoBuffer* buffer,
+                               bool input, atomic_uint_fast64_t* effect_ns) {
+    float* temp_left = buffer->left;
+    float* temp_right = buffer->right;
+    const DspKernels* dsp = ctx->engine->dsp;
+    ma_uint32 frame_count = ctx->frame_count;
+
+    // Generate audio: the live input (already in place), a streamed clip
+    // (stereo, RAM only), or the mono voice pool or oscillator bank
+    // duplicated onto both planes. A playing oscillator always sounds; an
+    // idle voice pool is silent without rendering.
+    bool source_silent = false;
+    if (input) {
+        // Monitored through the rest of the chain
+        source_silent = block_is_silent(dsp, temp_left, temp_right, frame_count);
+    } else if (rt->clip) {
+        clip_stream_read(rt->clip, temp_left, temp_right, frame_count);
+        source_silent = block_is_silent(dsp, temp_left, temp_right, frame_count);
+    } else if (track->instrument) {
+        source_silent = voice_pool_active_count(&track->voices) == 0;
+        if (!source_silent || !track->chain.asleep) {
+            voice_pool_render(&track->voices, temp_left, frame_count);
+            memcpy(temp_right, temp_left, sizeof(float) * frame_count);
+        }
+    } else {
+        oscillator_bank_render(&track->oscillator, temp_left, frame_count);
+        memcpy(temp_right, temp_left, sizeof(float) * frame_count);
+    }
+    if (source_silent && track->chain.asleep) {
+        return false;
+    }
 
-        // Generate audio (simple sine wave oscillator)
-        for (ma_uint32 i = 0; i < frame_count; i++) {
-            float sample = sinf(track->phase) * track->volume * 0.3F;
-            track->phase += 2.0F * MA_PI * track->frequency / SAMPLE_RATE;
-            if (track->phase > 2.0F * MA_PI) {
-                track->phase -= 2.0F * MA_PI;
-            }
+    if (rt->automated) {
+        apply_track_automation(ctx, rt, track, temp_left, temp_right, frame_count);
+    } else {
+        // Apply volume and panning (constant power). Gains are computed once per
+        // block and ramped from the previous block's values to avoid zipper noise.
+        float volume = rt->chunk->mix.volume[rt->lane];
+        float pan = rt->chunk->mix.pan[rt->lane];
+        float target_left = cosf((pan + 1.0F) * MA_PI / 4.0F) * volume * TRACK_OUTPUT_SCALE;
+        float target_right = sinf((pan + 1.0F) * MA_PI / 4.0F) * volume * TRACK_OUTPUT_SCALE;
+        float gain_left = track->output_gain[0];
+        float gain_right = track->output_gain[1];
+        float step_left = (target_left - gain_left) / (float)frame_count;
+        float step_right = (target_right - gain_right) / (float)frame_count;
+        dsp->gain_ramp(temp_left, gain_left + step_left, step_left, frame_count);
+        dsp->gain_ramp(temp_right, gain_right + step_right, step_right, frame_count);
+        track->output_gain[0] = target_left;
+        track->output_gain[1] = target_right;
+    }
 
-            // Apply panning (constant power)
-            float pan = track->pan;
-            float left_gain = cosf((pan + 1.0F) * MA_PI / 4.0F);
-            float right_gain = sinf((pan + 1.0F) * MA_PI / 4.0F);
-ma_panner panyi;
-            temp_left[i] = sample * left_gain;
-            temp_right[i] = sample * right_gain;
-        }
+    // Process effects chain
+    if (rt->effect_count > 0) {
+        process_effect_chain(dsp, &track->chain, rt->effect_slots, rt->effect_count, temp_left, temp_right,
+                             frame_count, effect_ns);
+    }
 
-        // Process effects chain
-        if (track->effect_count > 0) {
-            process_track_effects(track, t, temp_left, temp_right, frame_count);
-        }
+    // Track metering: accumulate locally, published once per callback
+    float peak = measure_block(dsp, buffer, frame_count);
+    update_idle(&track->chain, source_silent, peak, rt->tail_frames, frame_count);
+    return true;
+}
 
-        // Mix into output and compute meters
-        for (ma_uint32 i = 0; i < frame_count; i++) {
-            out[i * 2 + 0] += temp_left[i];
-            out[i * 2 + 1] += temp_right[i];
+// Render one track of the graph into its StereoBuffer. Runs on the device
+// thread or a pool worker; tracks share no mutable state.
+static void render_track(const RenderContext* ctx, int graph_index, atomic_uint_fast64_t* effect_ns) {
+    const RenderTrack* rt = &ctx->graph->tracks[graph_index];
+    const TrackMixLanes* mix = &rt->chunk->mix;
+    int lane = rt->lane;
+    Track* track = &rt->chunk->tracks[lane];
+    StereoBuffer* buffer = &rt->chunk->buffers[lane];
+    ma_uint32 frame_count = ctx->frame_count;
+
+    // Input tracks: take the live input first and hand it (pre-fader) to
+    // the take, so mute, solo and stopping the track never gap a recording
+    bool input = atomic_load_explicit(&mix->input[lane], memory_order_relaxed);
+    if (input) {
+        if (ctx->input) {
+            deinterleave(ctx->input, buffer->left, buffer->right, frame_count);
+        } else {
+            memset(buffer->left, 0, sizeof(float) * frame_count);
+            memset(buffer->right, 0, sizeof(float) * frame_count);
+        }
+        if (rt->recording && ctx->input) {
+            clip_recording_write(rt->recording, buffer->left, buffer->right, frame_count, ctx->transport_frame);
+        }
+    }
 
-            // Track metering
-            float abs_left = fabsf(temp_left[i]);
-            float abs_right = fabsf(temp_right[i]);
-            if (abs_left > track->peak_level[0]) track->peak_level[0] = abs_left;
-            if (abs_right > track->peak_level[1]) track->peak_level[1] = abs_right;
-            track->rms_level[0] += temp_left[i] * temp_left[i];
-            track->rms_level[1] += temp_right[i] * temp_right[i];
+    // A frozen track plays its rendered clip in place of the chain
+    ClipStream* clip = rt->frozen ? rt->frozen : rt->clip;
+    if (atomic_load_explicit(&mix->mute[lane], memory_order_relaxed) || !atomic_load(&mix->playing[lane]) ||
+        (ctx->any_solo && !atomic_load_explicit(&mix->solo[lane], memory_order_relaxed))) {
+        // A silenced but playing clip keeps consuming so it stays in time
+        if (clip && atomic_load(&mix->playing[lane])) {
+            clip_stream_read(clip, buffer->left, buffer->right, frame_count);
         }
+        buffer->active = false;
+        return;
+    }
+
+    if (rt->frozen) {
+        clip_stream_read(rt->frozen, buffer->left, buffer->right, frame_count);
+        measure_block(ctx->engine->dsp, buffer, frame_count);
+    } else if (!render_track_chain(ctx, rt, track, buffer, input, effect_ns)) {
+        buffer->active = false;
+        return;
+    }
+    if (rt->track_index == ctx->engine->analyzer_source) {
+        analyzer_tap_write(&ctx->engine->analyzer_tap, buffer->left, buffer->right, frame_count);
+    }
+    buffer->active = true;
+}
 
-        // Finalize RMS calculation
-        track->rms_level[0] = sqrtf(track->rms_level[0] / frame_count);
-        track->rms_level[1] = sqrtf(track->rms_level[1] / frame_count);
+// One track on whichever thread picked it up, timed while profiling is on
+static void render_track_job(void* context, int graph_index) {
+    const RenderContext* ctx = (const RenderContext*)context;
+    const RenderTrack* rt = &ctx->graph->tracks[graph_index];
+    TrackInfo* track = &rt->chunk->info[rt->lane];
+    ENGINE_TRACE_BEGIN(track->name);
+    if (!atomic_load_explicit(&ctx->engine->profiling, memory_order_relaxed)) {
+        render_track(ctx, graph_index, NULL);
+    } else {
+        uint64_t start_ns = engine_thread_time_ns();
+        render_track(ctx, graph_index, track->effect_profile_ns);
+        atomic_fetch_add_explicit(&track->profile_ns, engine_thread_time_ns() - start_ns, memory_order_relaxed);
     }
+    ENGINE_TRACE_END(track->name);
+}
 
-    // Apply master volume and compute master meters
-    for (ma_uint32 i = 0; i < frame_count; i++) {
-        out[i * 2 + 0] *= engine->master_volume;
-        out[i * 2 + 1] *= engine->master_volume;
+// Buffer a track or bus output lands in (BUS_MASTER is the last bus buffer)
+static StereoBuffer* mix_target(AudioEngine* engine, int bus_index) {
+    return &engine->bus_buffers[bus_index == BUS_MASTER ? MAX_BUSES : bus_index];
+}
+
+static void mix_into(const DspKernels* dsp, StereoBuffer* target, const StereoBuffer* source, float gain,
+                     ma_uint32 frame_count) {
+    if (gain == 0.0F) return;
+    dsp->mix(target->left, source->left, gain, frame_count);
+    dsp->mix(target->right, source->right, gain, frame_count);
+}
 
-        float abs_left = fabsf(out[i * 2 + 0]);
-        float abs_right = fabsf(out[i * 2 + 1]);
+// Mix one edge of the graph through its compensation delay. A silent source
+// (NULL) still feeds the line so what it holds plays out. Lines are fed
+// whenever they exist, so switching the delay in later starts from recent
+// audio rather than stale audio. Marks the target active when anything
+// reached it.
+static void mix_edge(const DspKernels* dsp, StereoBuffer* target, const StereoBuffer* source, float gain,
+                     PdcDelay* line, uint32_t delay, ma_uint32 frame_count) {
+    if (pdc_delay_ready(line)) {
+        pdc_delay_push(line, source ? source->left : NULL, source ? source->right : NULL, frame_count);
+    }
+    if (delay == 0) {
+        if (source) {
+            mix_into(dsp, target, source, gain, frame_count);
+            target->active = true;
+        }
+        return;
+    }
+    if (gain == 0.0F || pdc_delay_quiet(line, delay, frame_count)) return;
+    target->active = true;
+    PdcSpan spans[2];
+    int span_count = pdc_delay_read(line, delay, frame_count, spans);
+    for (int i = 0; i < span_count; i++) {
+        dsp->mix(target->left + spans[i].offset, spans[i].left, gain, spans[i].frames);
+        dsp->mix(target->right + spans[i].offset, spans[i].right, gain, spans[i].frames);
+    }
+}
 
-        if (abs_left > engine->master_peak[0]) engine->master_peak[0] = abs_left;
-        if (abs_right > engine->master_peak[1]) engine->master_peak[1] = abs_right;
+// Render and mix one sub-block (at most engine->block_frames) into out
+static void render_sub_block(AudioEngine* engine, const RenderGraph* graph, bool any_solo, const float* in,
+                             float* out, ma_uint32 frame_count) {
+    const DspKernels* dsp = engine->dsp;
+
+    // Render all tracks (in parallel when workers are available)
+    RenderContext ctx = {
+        .engine = engine,
+        .graph = graph,
+        .any_solo = any_solo,
+        .frame_count = frame_count,
+        .transport_frame = engine->transport_frame,
+        .input = in,
+    };
+    worker_pool_run(&engine->workers, render_track_job, &ctx, graph->track_count);
+
+    // Mixing schedule on the device thread, always in graph order so the
+    // result does not depend on which worker finished first
+    for (int b = 0; b < graph->bus_count; b++) {
+        StereoBuffer* bus_buffer = &engine->bus_buffers[graph->buses[b].bus_index];
+        memset(bus_buffer->left, 0, frame_count * sizeof(float));
+        memset(bus_buffer->right, 0, frame_count * sizeof(float));
+        bus_buffer->active = false;     // Until something is mixed in
+    }
+    StereoBuffer* master = &engine->bus_buffers[MAX_BUSES];
+    memset(master->left, 0, frame_count * sizeof(float));
+    memset(master->right, 0, frame_count * sizeof(float));
+
+    // 1. Tracks into their output bus and post-fader sends, each delayed to
+    //    meet the latest path into its destination
+    for (int t = 0; t < graph->track_count; t++) {
+        const RenderTrack* rt = &graph->tracks[t];
+        const StereoBuffer* rendered = &rt->chunk->buffers[rt->lane];
+        const StereoBuffer* buffer = rendered->active ? rendered : NULL;
+        Track* track = &rt->chunk->tracks[rt->lane];
+        mix_edge(dsp, mix_target(engine, rt->output_bus), buffer, 1.0F, &track->output_delay, rt->output_delay,
+                 frame_count);
+        for (int s = 0; s < rt->send_count; s++) {
+            int bus_index = rt->send_buses[s];
+            mix_edge(dsp, &engine->bus_buffers[bus_index], buffer, track->send_level[bus_index],
+                     &track->send_delays[bus_index], rt->send_delays[s], frame_count);
+        }
+    }
 
-        engine->master_rms[0] += out[i * 2 + 0] * out[i * 2 + 0];
-        engine->master_rms[1] += out[i * 2 + 1] * out[i * 2 + 1];
+    // 2. Buses in schedule order: every input has been summed by the time a
+    //    bus is processed. A bus nothing reached is silent; asleep, it is
+    //    skipped like a track.
+    for (int b = 0; b < graph->bus_count; b++) {
+        const RenderBus* rb = &graph->buses[b];
+        Bus* bus = &engine->buses[rb->bus_index];
+        StereoBuffer* bus_buffer = &engine->bus_buffers[rb->bus_index];
+        bool input_silent = !bus_buffer->active;
+
+        if (atomic_load_explicit(&bus->mute, memory_order_relaxed) || (input_silent && bus->chain.asleep)) {
+            mix_edge(dsp, mix_target(engine, rb->output_bus), NULL, bus->volume, &bus->output_delay,
+                     rb->output_delay, frame_count);
+            continue;
+        }
+        if (rb->effect_count > 0) {
+            process_effect_chain(dsp, &bus->chain, rb->effect_slots, rb->effect_count, bus_buffer->left,
+                                 bus_buffer->right, frame_count, NULL);
+        }
+        float peak = measure_block(dsp, bus_buffer, frame_count);
+        update_idle(&bus->chain, input_silent, peak, rb->tail_frames, frame_count);
+        mix_edge(dsp, mix_target(engine, rb->output_bus), bus_buffer, bus->volume, &bus->output_delay,
+                 rb->output_delay, frame_count);
     }
 
-    engine->master_rms[0] = sqrtf(engine->master_rms[0] / frame_count);
-    engine->master_rms[1] = sqrtf(engine->master_rms[1] / frame_count);
+    // 3. Master volume, metering and interleave
+    dsp->gain(master->left, engine->master_volume, frame_count);
+    dsp->gain(master->right, engine->master_volume, frame_count);
+    measure_block(dsp, master, frame_count);
+    if (engine->analyzer_source == ANALYZER_SOURCE_MASTER) {
+        analyzer_tap_write(&engine->analyzer_tap, master->left, master->right, frame_count);
+    }
+    dsp->interleave(out, master->left, master->right, frame_count);
+    engine->transport_frame += frame_count;
 }
 
 // ============================================================================
-// AUDIO ENGINE API
+// NODE GRAPH BACKEND (REAL-TIME AUDIO THREAD)
 // ============================================================================
 
-bool audio_engine_init(AudioEngine* engine) {
-    /* memset(engine, 0, sizeof(AudioEngine)); */
+#define TRACK_NODE_OUTPUTS (1 + MAX_BUSES)  // Main mix, then one send per bus slot
 
-    engine->master_volume = 0.75F;
-    engine->track_count = 0;
-    atomic_store(&engine->playing, false);
+// Planar block -> interleaved node output, scaled by gain, through the
+// edge's compensation delay (see mix_edge; NULL buffer: silence)
+static void write_node_output(const DspKernels* dsp, float* out, const StereoBuffer* buffer, float gain,
+                              PdcDelay* line, uint32_t delay, ma_uint32 frame_count) {
+    if (pdc_delay_ready(line)) {
+        pdc_delay_push(line, buffer ? buffer->left : NULL, buffer ? buffer->right : NULL, frame_count);
+    }
+    bool silent = delay > 0 ? pdc_delay_quiet(line, delay, frame_count) : !buffer;
+    if (silent) {
+        memset(out, 0, sizeof(float) * frame_count * CHANNELS);
+        return;
+    }
+    if (delay > 0) {
+        PdcSpan spans[2];
+        int span_count = pdc_delay_read(line, delay, frame_count, spans);
+        for (int i = 0; i < span_count; i++) {
+            dsp->interleave(out + spans[i].offset * CHANNELS, spans[i].left, spans[i].right, spans[i].frames);
+        }
+    } else {
+        dsp->interleave(out, buffer->left, buffer->right, frame_count);
+    }
+    if (gain != 1.0F) {
+        dsp->gain(out, gain, frame_count * CHANNELS);
+    }
+}
 
-    // Initialize miniaudio logging
-    ma_allocation_callbacks alloc_cb = ma_allocation_callbacks_init_default();
-    ma_log_init(&alloc_cb, &engine->log);
-    ma_log_register_callback(&engine->log,ma_log_callback_init(miniaudio_log_callback, NULL));
+static void track_node_process(ma_node* node, const float** frames_in, ma_uint32* frame_count_in,
+                               float** frames_out, ma_uint32* frame_count_out) {
+    (void)frames_in;
+    (void)frame_count_in;
+    EngineNode* track_node = (EngineNode*)node;
+    AudioEngine* engine = track_node->engine;
+    ma_uint32 frame_count = *frame_count_out;
+    const RenderGraph* graph = engine->current_graph;
+    int graph_index = track_node->graph_index;
+
+    // Only the main output and the sends in the graph are attached (and read)
+    if (graph_index < 0) {
+        memset(frames_out[0], 0, sizeof(float) * frame_count * CHANNELS);
+        return;
+    }
+    const RenderTrack* rt = &graph->tracks[graph_index];
+    EngineNodeGraph* nodes = engine->nodes;
+    uint64_t input_offset = engine->transport_frame - nodes->input_frame;
+    RenderContext ctx = {
+        .engine = engine,
+        .graph = graph,
+        .any_solo = nodes->any_solo,
+        .frame_count = frame_count,
+        .transport_frame = engine->transport_frame,
+        .input = nodes->input && input_offset + frame_count <= nodes->input_frames
+                     ? nodes->input + input_offset * CHANNELS
+                     : NULL,
+    };
+    render_track_job(&ctx, graph_index);
+
+    const StereoBuffer* rendered = &rt->chunk->buffers[rt->lane];
+    const StereoBuffer* buffer = rendered->active ? rendered : NULL;
+    Track* track = &rt->chunk->tracks[rt->lane];
+    write_node_output(engine->dsp, frames_out[0], buffer, 1.0F, &track->output_delay, rt->output_delay, frame_count);
+    for (int s = 0; s < rt->send_count; s++) {
+        int bus_index = rt->send_buses[s];
+        write_node_output(engine->dsp, frames_out[1 + bus_index], buffer, track->send_level[bus_index],
+                          &track->send_delays[bus_index], rt->send_delays[s], frame_count);
+    }
+}
 
-    // Configure miniaudio device
-    engine->device_config = ma_device_config_init(ma_device_type_playback);
-    engine->device_config.playback.format = ma_format_f32;
-    engine->device_config.playback.channels = CHANNELS;
-    engine->device_config.sampleRate = SAMPLE_RATE;
-    engine->device_config.dataCallback = audio_callback;
-    engine->device_config.pUserData = engine;
-    engine->device_config.periodSizeInFrames = BUFFER_SIZE;
+static void bus_node_process(ma_node* node, const float** frames_in, ma_uint32* frame_count_in,
+                             float** frames_out, ma_uint32* frame_count_out) {
+    (void)frame_count_in;
+    EngineNode* bus_node = (EngineNode*)node;
+    AudioEngine* engine = bus_node->engine;
+    ma_uint32 frame_count = *frame_count_out;
+    Bus* bus = &engine->buses[bus_node->slot];
 
-    // Initialize device
-    if (ma_device_init(NULL, &engine->device_config, &engine->device) != MA_SUCCESS) {
-        ma_log_post(&engine->log, MA_LOG_LEVEL_ERROR, "Failed to initialize audio device");
-        ma_log_uninit(&engine->log);
-        return false;
+    if (bus_node->graph_index < 0) {
+        memset(frames_out[0], 0, sizeof(float) * frame_count * CHANNELS);
+        return;
     }
-    engine->device.pContext->pLog = &engine->log;
-    ma_log *lg = ma_device_get_log(&engine->device);
-    ma_log_post(lg, MA_LOG_LEVEL_INFO, "TEST LOGING");
-    ma_log_postf(&engine->log, MA_LOG_LEVEL_INFO, "Audio device initialized: %s", engine->device.playback.name);
-    ma_log_postf(&engine->log, MA_LOG_LEVEL_INFO, "Format: %s, Channels: %u, Sample Rate: %u",
-             ma_get_format_name(engine->device.playback.format),
-             engine->device.playback.channels,
-             engine->device.sampleRate);
-
-    // Start device
-    if (ma_device_start(&engine->device) != MA_SUCCESS) {
-        ma_log_post(&engine->log, MA_LOG_LEVEL_ERROR, "Failed to start audio device");
-        ma_device_uninit(&engine->device);
-        ma_log_uninit(&engine->log);
-        return false;
+    const RenderBus* rb = &engine->current_graph->buses[bus_node->graph_index];
+    if (atomic_load_explicit(&bus->mute, memory_order_relaxed)) {
+        write_node_output(engine->dsp, frames_out[0], NULL, bus->volume, &bus->output_delay, rb->output_delay,
+                          frame_count);
+        return;
     }
 
-    atomic_store(&engine->initialized, true);
-    ma_log_post(&engine->log, MA_LOG_LEVEL_INFO, "Audio engine started successfully");
-    return true;
+    // The graph has already summed the inputs, so silence is measured here
+    StereoBuffer* buffer = &engine->bus_buffers[bus_node->slot];
+    deinterleave(frames_in[0], buffer->left, buffer->right, frame_count);
+    bool input_silent = block_is_silent(engine->dsp, buffer->left, buffer->right, frame_count);
+    if (input_silent && bus->chain.asleep) {
+        write_node_output(engine->dsp, frames_out[0], NULL, bus->volume, &bus->output_delay, rb->output_delay,
+                          frame_count);
+        return;
+    }
+    if (rb->effect_count > 0) {
+        process_effect_chain(engine->dsp, &bus->chain, rb->effect_slots, rb->effect_count, buffer->left,
+                             buffer->right, frame_count, NULL);
+    }
+    float peak = measure_block(engine->dsp, buffer, frame_count);
+    update_idle(&bus->chain, input_silent, peak, rb->tail_frames, frame_count);
+    write_node_output(engine->dsp, frames_out[0], buffer, bus->volume, &bus->output_delay, rb->output_delay,
+                      frame_count);
 }
 
-void audio_engine_shutdown(AudioEngine* engine) {
-    if (atomic_load(&engine->initialized)) {
-        TraceLog(LOG_INFO, "[miniaudio] Shutting down audio engine...");
+static void master_node_process(ma_node* node, const float** frames_in, ma_uint32* frame_count_in,
+                                float** frames_out, ma_uint32* frame_count_out) {
+    (void)frame_count_in;
+    AudioEngine* engine = ((EngineNode*)node)->engine;
+    ma_uint32 frame_count = *frame_count_out;
+    StereoBuffer* master = &engine->bus_buffers[MAX_BUSES];
+
+    deinterleave(frames_in[0], master->left, master->right, frame_count);
+    engine->dsp->gain(master->left, engine->master_volume, frame_count);
+    engine->dsp->gain(master->right, engine->master_volume, frame_count);
+    measure_block(engine->dsp, master, frame_count);
+    if (engine->analyzer_source == ANALYZER_SOURCE_MASTER) {
+        analyzer_tap_write(&engine->analyzer_tap, master->left, master->right, frame_count);
+    }
+    engine->dsp->interleave(frames_out[0], master->left, master->right, frame_count);
 
-        atomic_store(&engine->playing, false);
-        ma_device_uninit(&engine->device);
-        ma_log_uninit(&engine->log);
-        atomic_store(&engine->initialized, false);
+    // Master is processed after everything it pulled from, so this block's
+    // track nodes all saw the same transport frame
+    engine->transport_frame += frame_count;
+}
 
-        TraceLog(LOG_INFO, "[miniaudio] Audio engine shut down");
-    }
+// Continuous processing keeps sources running without inputs and lets bus
+// effect tails ring out after their inputs go quiet
+static ma_node_vtable track_node_vtable = {
+    track_node_process, NULL, 0, TRACK_NODE_OUTPUTS,
+    MA_NODE_FLAG_CONTINUOUS_PROCESSING | MA_NODE_FLAG_ALLOW_NULL_INPUT,
+};
+static ma_node_vtable bus_node_vtable = {bus_node_process, NULL, 1, 1, MA_NODE_FLAG_CONTINUOUS_PROCESSING};
+static ma_node_vtable master_node_vtable = {master_node_process, NULL, 1, 1, MA_NODE_FLAG_CONTINUOUS_PROCESSING};
+
+static ma_node* node_for_bus(EngineNodeGraph* nodes, int bus_index) {
+    return bus_index == BUS_MASTER ? (ma_node*)&nodes->master : (ma_node*)&nodes->buses[bus_index];
 }
 
-int audio_engine_add_track(AudioEngine* engine, const char* name, float frequency) {
-    if (engine->track_count >= MAX_TRACKS) {
-        TraceLog(LOG_WARNING, "[miniaudio] Cannot add track: maximum tracks reached (%d)", MAX_TRACKS);
-        return -1;
+// Re-attach every node to match graph. Runs between graph reads, so no node
+// is being processed while its attachments change.
+static void node_graph_wire(AudioEngine* engine, const RenderGraph* graph) {
+    EngineNodeGraph* nodes = engine->nodes;
+    for (int t = 0; t < nodes->wired_track_count; t++) {
+        EngineNode* node = &track_store_chunk(&engine->tracks, t)->nodes[track_lane(t)];
+        node->graph_index = -1;
+        ma_node_detach_all_output_buses(node);
+    }
+    for (int b = 0; b < MAX_BUSES; b++) {
+        nodes->buses[b].graph_index = -1;
+        ma_node_detach_all_output_buses(&nodes->buses[b]);
     }
 
-    int index = engine->track_count++;
-    Track* track = &engine->tracks[index];
+    for (int t = 0; t < graph->track_count; t++) {
+        const RenderTrack* rt = &graph->tracks[t];
+        EngineNode* node = &rt->chunk->nodes[rt->lane];
+        node->graph_index = t;
+        ma_node_attach_output_bus(node, 0, node_for_bus(nodes, rt->output_bus), 0);
+        for (int s = 0; s < rt->send_count; s++) {
+            ma_node_attach_output_bus(node, 1 + (ma_uint32)rt->send_buses[s], &nodes->buses[rt->send_buses[s]], 0);
+        }
+    }
+    for (int b = 0; b < graph->bus_count; b++) {
+        const RenderBus* rb = &graph->buses[b];
+        EngineNode* node = &nodes->buses[rb->bus_index];
+        node->graph_index = b;
+        ma_node_attach_output_bus(node, 0, node_for_bus(nodes, rb->output_bus), 0);
+    }
+    nodes->wired_generation = graph->generation;
+    nodes->wired_track_count = graph->track_count;
+}
 
-    snprintf(track->name, sizeof(track->name), "%s", name);
-    track->volume = 0.75F;
-    track->pan = 0.0F;
-    track->mute = false;
-    track->solo = false;
-    track->armed = false;
-    track->frequency = frequency;
-    track->phase = 0.0F;
-    track->effect_count = 0;
-    atomic_store(&track->playing, false);
+static void node_graph_render(AudioEngine* engine, const RenderGraph* graph, bool any_solo, const float* in,
+                              float* out, ma_uint32 frame_count) {
+    EngineNodeGraph* nodes = engine->nodes;
+    if (nodes->wired_generation != graph->generation) {
+        node_graph_wire(engine, graph);
+    }
+    nodes->any_solo = any_solo;
+
+    // Track nodes find their chunk of the input by transport frame. The graph
+    // renders whole block_frames chunks and serves shorter reads from its
+    // cache, so input only reaches it when periods are whole blocks (as the
+    // latency presets configure them); a shorter period reads silence
+    nodes->input = in;
+    nodes->input_frame = engine->transport_frame;
+    nodes->input_frames = frame_count;
+
+    ma_uint64 frames_read = 0;
+    ma_node_graph_read_pcm_frames(&nodes->graph, out, frame_count, &frames_read);
+    if (frames_read < frame_count) {
+        memset(out + frames_read * CHANNELS, 0, sizeof(float) * (frame_count - frames_read) * CHANNELS);
+    }
+}
 
-    TraceLog(LOG_INFO, "[miniaudio] Added track %d: %s (%.1f Hz)", index, name, frequency);
-    return index;
+// Render frames through whichever backend is active
+static void render_frames(AudioEngine* engine, const RenderGraph* graph, bool any_solo, const float* in,
+                          float* out, ma_uint32 frame_count) {
+    if (engine->nodes) {
+        // The node graph pulls in block_frames chunks on its own
+        node_graph_render(engine, graph, any_solo, in, out, frame_count);
+    } else {
+        // The device may hand us any period length; scratch buffers only hold
+        // block_frames, so process the period in sub-blocks
+        for (ma_uint32 offset = 0; offset < frame_count; offset += engine->block_frames) {
+            ma_uint32 remaining = frame_count - offset;
+            ma_uint32 sub_block = remaining < engine->block_frames ? remaining : engine->block_frames;
+            render_sub_block(engine, graph, any_solo, in ? in + offset * CHANNELS : NULL, out + offset * CHANNELS,
+                             sub_block);
+        }
+    }
 }
 
-void audio_engine_add_effect(Track* track, EffectType type) {
-    if (track->effect_count >= MAX_EFFECTS_PER_TRACK) {
-        TraceLog(LOG_WARNING, "[miniaudio] Cannot add effect: maximum effects reached (%d)", MAX_EFFECTS_PER_TRACK);
+// Render one device period (or offline chunk) of interleaved stereo. Runs on
+// the device thread, or on the caller of audio_engine_render_offline() while
+// the device is stopped. `in` is the period's device input, or NULL.
+static void engine_process(AudioEngine* engine, const float* in, float* out, ma_uint32 frame_count) {
+    // Adopt the newest graph snapshot, then apply queued UI edits. The old
+    // snapshot is only handed back once the commands sent alongside it have
+    // been applied, so the control thread can safely recycle its slots.
+    RenderGraph* previous_graph = render_graph_acquire(engine);
+    drain_commands(engine);
+    render_graph_retire(engine, previous_graph);
+
+    // One tap source per callback, so the ring only ever has one producer
+    engine->analyzer_source = atomic_load_explicit(&engine->analyzer_tap.source, memory_order_relaxed);
+
+    uint64_t block_frame = engine->frames_processed;
+    engine->frames_processed += frame_count;
+    uint64_t midi_anchor_ns = begin_midi_period(engine, frame_count);
+
+    const RenderGraph* graph = engine->current_graph;
+    if (!graph || !atomic_load(&engine->playing)) {
+        // Nothing renders, so due MIDI only updates state (held notes
+        // sound once the transport starts)
+        const MidiEvent* event;
+        while ((event = spsc_ring_peek(&engine->midi_queue)) && event->time_ns <= engine->midi_block_ns) {
+            apply_midi_event(engine, graph, event);
+            spsc_ring_skip(&engine->midi_queue);
+        }
+        memset(out, 0, frame_count * CHANNELS * sizeof(float));
+        if (graph) {
+            for (int t = 0; t < graph->track_count; t++) {
+                const RenderTrack* rt = &graph->tracks[t];
+                publish_silent_meter(&rt->chunk->tracks[rt->lane].meter, block_frame);
+            }
+            for (int b = 0; b < graph->bus_count; b++) {
+                publish_silent_meter(&engine->buses[graph->buses[b].bus_index].meter, block_frame);
+            }
+        }
+        publish_silent_meter(&engine->master_meter, block_frame);
+        atomic_store_explicit(&engine->transport_position, engine->transport_frame, memory_order_relaxed);
         return;
     }
 
-    Effect* effect = &track->effects[track->effect_count++];
-    effect->type = type;
-    effect->enabled = true;
-
-    // Set default parameters
-    switch (type) {
-        case EFFECT_GAIN:
-            effect->gain_params.gain = 1.0f;
-            break;
-        case EFFECT_LOWPASS:
-        case EFFECT_HIGHPASS:
-            effect->filter_params.cutoff = 1000.0f;
-            effect->filter_params.resonance = 1.0f;
-            break;
-        case EFFECT_DELAY:
-            effect->delay_params.time_ms = 250.0f;
-            effect->delay_params.feedback = 0.3f;
-            effect->delay_params.mix = 0.5f;
-            break;
-        case EFFECT_REVERB:
-            effect->reverb_params.room_size = 0.5f;
-            effect->reverb_params.damping = 0.5f;
-            effect->reverb_params.mix = 0.3f;
-            break;
-        default:
+    // Check if any tracks are soloed
+    bool any_solo = false;
+    for (int t = 0; t < graph->track_count; t++) {
+        const RenderTrack* rt = &graph->tracks[t];
+        if (atomic_load_explicit(&rt->chunk->mix.solo[rt->lane], memory_order_relaxed)) {
+            any_solo = true;
             break;
+        }
+    }
+
+    for (int t = 0; t < graph->track_count; t++) {
+        meter_accumulator_reset(&graph->tracks[t].chunk->buffers[graph->tracks[t].lane].meter);
+    }
+    for (int b = 0; b <= MAX_BUSES; b++) {
+        meter_accumulator_reset(&engine->bus_buffers[b].meter);
     }
 
-    TraceLog(LOG_INFO, "[miniaudio] Added effect type %d to track '%s'", type, track->name);
+    // Split the period at each due MIDI event: render up to its frame,
+    // apply it, carry on. Past the per-period cap, events wait a period.
+    ma_uint32 rendered = 0;
+    const MidiEvent* event;
+    for (int applied = 0; applied < ENGINE_MIDI_MAX_EVENTS_PER_PERIOD; applied++) {
+        event = spsc_ring_peek(&engine->midi_queue);
+        if (!event || event->time_ns > engine->midi_block_ns) break;
+
+        ma_uint32 at = midi_event_frame_offset(event->time_ns, midi_anchor_ns, frame_count, engine->sample_rate);
+        if (at > rendered) {
+            render_frames(engine, graph, any_solo, in ? in + rendered * CHANNELS : NULL, out + rendered * CHANNELS,
+                          at - rendered);
+            rendered = at;
+        }
+        apply_midi_event(engine, graph, event);
+        spsc_ring_skip(&engine->midi_queue);
+    }
+    if (rendered < frame_count) {
+        render_frames(engine, graph, any_solo, in ? in + rendered * CHANNELS : NULL, out + rendered * CHANNELS,
+                      frame_count - rendered);
+    }
+
+    // Meters are published once per callback, covering every sub-block
+    for (int t = 0; t < graph->track_count; t++) {
+        const RenderTrack* rt = &graph->tracks[t];
+        meter_accumulator_publish(&rt->chunk->buffers[rt->lane].meter, &rt->chunk->tracks[rt->lane].meter,
+                                  block_frame);
+    }
+    for (int b = 0; b < graph->bus_count; b++) {
+        int bus_index = graph->buses[b].bus_index;
+        meter_accumulator_publish(&engine->bus_buffers[bus_index].meter, &engine->buses[bus_index].meter,
+                                  block_frame);
+    }
+    meter_accumulator_publish(&engine->bus_buffers[MAX_BUSES].meter, &engine->master_meter, block_frame);
+    atomic_store_explicit(&engine->transport_position, engine->transport_frame, memory_order_relaxed);
 }
 
-void audio_engine_remove_effect(Track* track, int effect_index) {
-    if (effect_index < 0 || effect_index >= track->effect_count) {
-        TraceLog(LOG_WARNING, "[miniaudio] Invalid effect index: %d", effect_index);
+// Count a callback that overran its period. Warnings go to the log ring
+// (never to the sink directly) and at most once per report interval, with
+// the misses since the previous warning folded in.
+static void report_deadline_miss(AudioEngine* engine, uint64_t elapsed_ns, uint64_t budget_ns) {
+    uint32_t misses = atomic_fetch_add_explicit(&engine->deadline_misses, 1, memory_order_relaxed) + 1;
+    if (engine->deadline_misses_reported != 0 &&
+        engine->frames_processed - engine->deadline_report_frame <
+            (uint64_t)engine->sample_rate * ENGINE_DEADLINE_REPORT_MS / 1000) {
         return;
     }
+    engine_log_rt(ENGINE_LOG_WARNING, "[miniaudio] Audio callback missed its deadline: %.2f ms of %.2f ms (%u misses)",
+                  (double)elapsed_ns / 1e6, (double)budget_ns / 1e6, misses - engine->deadline_misses_reported);
+    engine->deadline_misses_reported = misses;
+    engine->deadline_report_frame = engine->frames_processed;
+}
 
-    // Shift effects down
-    for (int i = effect_index; i < track->effect_count - 1; i++) {
-        track->effects[i] = track->effects[i + 1];
+// Render one period, count it against its real-time budget and publish
+// the DSP load record
+static void engine_process_timed(AudioEngine* engine, const float* in, float* out, ma_uint32 frame_count) {
+    ENGINE_TRACE_BEGIN("audio_callback");
+    uint64_t start_ns = engine_thread_time_ns();
+    engine_process(engine, in, out, frame_count);
+    uint64_t elapsed_ns = engine_thread_time_ns() - start_ns;
+    ENGINE_TRACE_END("audio_callback");
+
+    uint64_t budget_ns = (uint64_t)frame_count * 1000000000ULL / engine->sample_rate;
+    if (elapsed_ns > budget_ns) {
+        report_deadline_miss(engine, elapsed_ns, budget_ns);
     }
-    track->effect_count--;
 
-    TraceLog(LOG_INFO, "[miniaudio] Removed effect %d from track '%s'", effect_index, track->name);
+    DspLoadRecord* record = &engine->dsp_load_record;
+    float load = budget_ns > 0 ? (float)((double)elapsed_ns / (double)budget_ns) : 0.0F;
+    uint32_t window_frames = engine->sample_rate * ENGINE_DSP_LOAD_WINDOW_MS / 1000;
+    dsp_load_accumulator_add(&engine->dsp_load_window, load, frame_count, window_frames, record);
+    record->late_callbacks = atomic_load_explicit(&engine->deadline_misses, memory_order_relaxed);
+    record->xruns = record->late_callbacks + atomic_load_explicit(&engine->device_glitches, memory_order_relaxed);
+    record->callbacks++;
+    dsp_load_channel_publish(&engine->dsp_load, record);
 }
 
-void audio_engine_toggle_effect(Track* track, int effect_index) {
-    if (effect_index < 0 || effect_index >= track->effect_count) {
-        TraceLog(LOG_WARNING, "[miniaudio] Invalid effect index: %d", effect_index);
-        return;
+// A device at another rate: render just the engine frames the converter
+// needs for each chunk of the period, then convert them into place
+static void process_resampled(AudioEngine* engine, float* out, ma_uint32 frame_count) {
+    ma_uint32 done = 0;
+    while (done < frame_count) {
+        uint32_t want = frame_count - done < engine->device_chunk_frames ? frame_count - done
+                                                                         : engine->device_chunk_frames;
+        uint32_t needed = resampler_input_needed(&engine->device_resampler, want);
+        if (needed > 0) {
+            engine_process_timed(engine, NULL, engine->device_scratch, needed);
+        }
+        uint32_t produced = resampler_process(&engine->device_resampler, engine->device_scratch, &needed,
+                                              out + (size_t)done * CHANNELS, want);
+        if (produced == 0) {
+            break;
+        }
+        done += produced;
     }
+    memset(out + (size_t)done * CHANNELS, 0, sizeof(float) * (frame_count - done) * CHANNELS);
+}
 
-    track->effects[effect_index].enabled = !track->effects[effect_index].enabled;
-    TraceLog(LOG_DEBUG, "[miniaudio] Toggled effect %d on track '%s': %s",
-             effect_index, track->name,
-             track->effects[effect_index].enabled ? "ON" : "OFF");
+static void audio_callback(ma_device* device, void* output_buffer, const void* input_buffer, ma_uint32 frame_count) {
+    ENGINE_TRACE_THREAD_NAME("audio");
+    AudioEngine* engine = (AudioEngine*)device->pUserData;
+    if (engine->device_resampling) {
+        process_resampled(engine, (float*)output_buffer, frame_count);
+        return;
+    }
+    engine_process_timed(engine, engine->capture_open ? (const float*)input_buffer : NULL, (float*)output_buffer,
+                         frame_count);
 }
 
-void audio_engine_set_effect_param(Effect* effect, int param_index, float value) {
-    switch (effect->type) {
-        case EFFECT_GAIN:
-            if (param_index == 0) effect->gain_params.gain = value;
-            break;
-        case EFFECT_LOWPASS:
-        case EFFECT_HIGHPASS:
-            if (param_index == 0) effect->filter_params.cutoff = value;
-            else if (param_index == 1) effect->filter_params.resonance = value;
-            break;
-        case EFFECT_DELAY:
-            if (param_index == 0) effect->delay_params.time_ms = value;
-            else if (param_index == 1) effect->delay_params.feedback = value;
-            else if (param_index == 2) effect->delay_params.mix = value;
-            break;
-        case EFFECT_REVERB:
-            if (param_index == 0) effect->reverb_params.room_size = value;
-            else if (param_index == 1) effect->reverb_params.damping = value;
-            else if (param_index == 2) effect->reverb_params.mix = value;
+// Interruptions (the OS or another app took the device) and reroutes break
+// the output without any late callback, so they count as xruns too.
+// Called on miniaudio's threads.
+static void device_notification(const ma_device_notification* notification) {
+    AudioEngine* engine = (AudioEngine*)notification->pDevice->pUserData;
+    switch (notification->type) {
+        case ma_device_notification_type_interruption_began:
+        case ma_device_notification_type_rerouted:
+            atomic_fetch_add_explicit(&engine->device_glitches, 1, memory_order_relaxed);
+            engine_log(ENGINE_LOG_WARNING, "[miniaudio] Device %s",
+                       notification->type == ma_device_notification_type_rerouted ? "rerouted" : "interrupted");
             break;
         default:
             break;
     }
 }
+
+// ============================================================================
+// EFFECT STATE (control thread)
+// ============================================================================
+
+// Every track and bus effect slot can hold one live instance
+#define EFFECT_STATE_POOL_BLOCKS ((MAX_TRACKS + MAX_BUSES) * MAX_EFFECTS_PER_TRACK)
+
+static EffectChain* engine_chain(AudioEngine* engine, int index) {
+    return index < engine->track_count ? &track_store_track(&engine->tracks, index)->chain
+                                       : &engine->buses[index - engine->track_count].chain;
+}
+
+// Return the state of removed effects to the pool once no snapshot still in
+// use can reference their slots. With `everything` set (shutdown, after the
+// device and workers have stopped) every instance is released.
+static void release_effect_states(AudioEngine* engine, bool everything) {
+    for (int i = 0; i < engine->track_count + engine->bus_count; i++) {
+        EffectChain* chain = engine_chain(engine, i);
+        for (int slot = 0; slot < MAX_EFFECTS_PER_TRACK; slot++) {
+            bool reclaimed = !chain->slot_used[slot] &&
+                             chain->slot_free_after[slot] <= engine->reclaimed_generation;
+            if (everything || reclaimed) {
+                effect_instance_destroy(&chain->effects[slot], &engine->effect_states);
+            }
+        }
+    }
+}
+
+// Close replaced clips once no snapshot still in use can reference them.
+// With `everything` set (shutdown) every clip, live or retired, is closed.
+static void release_clips(AudioEngine* engine, bool everything) {
+    int kept = 0;
+    for (int i = 0; i < engine->retired_clip_count; i++) {
+        if (everything || engine->retired_clip_after[i] <= engine->reclaimed_generation) {
+            clip_stream_close(&engine->streamer, engine->retired_clips[i]);
+        } else {
+            engine->retired_clips[kept] = engine->retired_clips[i];
+            engine->retired_clip_after[kept] = engine->retired_clip_after[i];
+            kept++;
+        }
+    }
+    engine->retired_clip_count = kept;
+
+    if (everything) {
+        for (int t = 0; t < engine->track_count; t++) {
+            TrackInfo* info = track_store_info(&engine->tracks, t);
+            clip_stream_close(&engine->streamer, info->clip);
+            clip_stream_close(&engine->streamer, info->frozen);
+            info->clip = NULL;
+            info->frozen = NULL;
+        }
+    }
+}
+
+// Free finished takes once no graph that wrote to them can still be in use
+static void release_takes(AudioEngine* engine, bool everything) {
+    int kept = 0;
+    for (int i = 0; i < engine->retired_take_count; i++) {
+        if (everything || engine->retired_take_after[i] <= engine->reclaimed_generation) {
+            clip_recording_close(&engine->recorder, engine->retired_takes[i]);
+        } else {
+            engine->retired_takes[kept] = engine->retired_takes[i];
+            engine->retired_take_after[kept] = engine->retired_take_after[i];
+            kept++;
+        }
+    }
+    engine->retired_take_count = kept;
+
+    if (everything) {
+        for (int t = 0; t < engine->track_count; t++) {
+            TrackInfo* info = track_store_info(&engine->tracks, t);
+            clip_recording_close(&engine->recorder, info->recording);
+            info->recording = NULL;
+        }
+        engine->recording = false;
+    }
+}
+
+// Free replaced automation lanes once no snapshot in use can reference them.
+// With `everything` set (shutdown) live lanes are freed too.
+static void release_lanes(AudioEngine* engine, bool everything) {
+    int kept = 0;
+    for (int i = 0; i < engine->retired_lane_count; i++) {
+        if (everything || engine->retired_lane_after[i] <= engine->reclaimed_generation) {
+            automation_lane_destroy(engine->retired_lanes[i]);
+        } else {
+            engine->retired_lanes[kept] = engine->retired_lanes[i];
+            engine->retired_lane_after[kept] = engine->retired_lane_after[i];
+            kept++;
+        }
+    }
+    engine->retired_lane_count = kept;
+
+    if (everything) {
+        for (int t = 0; t < engine->track_count; t++) {
+            TrackInfo* track = track_store_info(&engine->tracks, t);
+            automation_lane_destroy(track->volume_lane);
+            automation_lane_destroy(track->pan_lane);
+            track->volume_lane = NULL;
+            track->pan_lane = NULL;
+            for (int slot = 0; slot < MAX_EFFECTS_PER_TRACK; slot++) {
+                for (int p = 0; p < ENGINE_MAX_AUTOMATED_PARAMS; p++) {
+                    automation_lane_destroy(track->effect_lanes[slot][p]);
+                    track->effect_lanes[slot][p] = NULL;
+                }
+            }
+        }
+    }
+}
+
+// Compensation lines live as long as their track or bus (engine stopped)
+static void release_delay_lines(AudioEngine* engine) {
+    for (int t = 0; t < engine->track_count; t++) {
+        Track* track = track_store_track(&engine->tracks, t);
+        pdc_delay_free(&track->output_delay);
+        for (int b = 0; b < MAX_BUSES; b++) {
+            pdc_delay_free(&track->send_delays[b]);
+        }
+    }
+    for (int b = 0; b < engine->bus_count; b++) {
+        pdc_delay_free(&engine->buses[b].output_delay);
+    }
+}
+
+// Queue a lane the previous graph (generation N - 1) may still be reading
+static void retire_lane(AudioEngine* engine, AutomationLane* lane) {
+    engine->retired_lanes[engine->retired_lane_count] = lane;
+    engine->retired_lane_after[engine->retired_lane_count] = engine->graph_generation - 1;
+    engine->retired_lane_count++;
+}
+
+// ============================================================================
+// AUDIO ENGINE API
+// ============================================================================
+
+// Carve every scratch buffer out of one arena sized for the block length,
+// so the callback never touches the heap
+static bool alloc_render_buffers(AudioEngine* engine) {
+    size_t plane_bytes = sizeof(float) * engine->block_frames;
+    size_t bus_bytes = sizeof(StereoBuffer) * (MAX_BUSES + 1);
+    size_t tap_bytes = sizeof(AnalyzerBlock) * ANALYZER_RING_BLOCKS;
+    size_t record_bytes = sizeof(RecordedMidiEvent) * ENGINE_MIDI_RECORD_QUEUE_SIZE;
+    size_t capacity = engine_arena_footprint(bus_bytes) +
+                      (size_t)(MAX_BUSES + 1) * 2 * engine_arena_footprint(plane_bytes) +
+                      engine_arena_footprint(tap_bytes) + engine_arena_footprint(record_bytes);
+    if (!engine_arena_init(&engine->arena, capacity)) {
+        return false;
+    }
+
+    engine->bus_buffers = (StereoBuffer*)engine_arena_alloc(&engine->arena, bus_bytes);
+    if (!engine->bus_buffers) {
+        return false;
+    }
+    for (int i = 0; i < MAX_BUSES + 1; i++) {
+        StereoBuffer* buffer = &engine->bus_buffers[i];
+        buffer->left = (float*)engine_arena_alloc(&engine->arena, plane_bytes);
+        buffer->right = (float*)engine_arena_alloc(&engine->arena, plane_bytes);
+        if (!buffer->left || !buffer->right) {
+            return false;
+        }
+    }
+    AnalyzerBlock* tap_blocks = (AnalyzerBlock*)engine_arena_alloc(&engine->arena, tap_bytes);
+    if (!tap_blocks) {
+        return false;
+    }
+    analyzer_tap_init(&engine->analyzer_tap, tap_blocks);
+    engine->analyzer_source = ANALYZER_SOURCE_NONE;
+    void* record_storage = engine_arena_alloc(&engine->arena, record_bytes);
+    if (!record_storage) {
+        return false;
+    }
+    spsc_ring_init(&engine->recorded_midi, record_storage, sizeof(RecordedMidiEvent), ENGINE_MIDI_RECORD_QUEUE_SIZE);
+    return true;
+}
+
+static void free_render_buffers(AudioEngine* engine) {
+    engine_arena_destroy(&engine->arena);
+    engine->bus_buffers = NULL;
+}
+
+// Node graph backend: master and bus nodes in init order, master first so
+// every later node has something to attach to. Track nodes are initialized
+// with their storage chunk (see init_track_nodes).
+#define ENGINE_NODE_COUNT (1 + MAX_BUSES)
+
+static EngineNode* engine_node_at(EngineNodeGraph* nodes, int index) {
+    return index == 0 ? &nodes->master : &nodes->buses[index - 1];
+}
+
+static void uninit_track_nodes(TrackChunk* chunk, int node_count) {
+    for (int lane = node_count - 1; lane >= 0; lane--) {
+        ma_node_uninit(&chunk->nodes[lane], NULL);
+    }
+}
+
+// Track nodes go before the graph's own nodes, which they attach to
+static void destroy_node_graph(AudioEngine* engine, int node_count) {
+    EngineNodeGraph* nodes = engine->nodes;
+    for (int c = engine->tracks.chunk_count - 1; c >= 0; c--) {
+        uninit_track_nodes(engine->tracks.chunks[c], TRACK_CHUNK_TRACKS);
+    }
+    for (int i = node_count - 1; i >= 0; i--) {
+        ma_node_uninit(engine_node_at(nodes, i), NULL);
+    }
+    ma_node_graph_uninit(&nodes->graph, NULL);
+    free(nodes);
+    engine->nodes = NULL;
+}
+
+static bool create_node_graph(AudioEngine* engine) {
+    EngineNodeGraph* nodes = (EngineNodeGraph*)calloc(1, sizeof(EngineNodeGraph));
+    if (!nodes) {
+        return false;
+    }
+    ma_node_graph_config graph_config = ma_node_graph_config_init(CHANNELS);
+    graph_config.processingSizeInFrames = engine->block_frames;     // Node blocks fit the scratch buffers
+    if (ma_node_graph_init(&graph_config, NULL, &nodes->graph) != MA_SUCCESS) {
+        free(nodes);
+        return false;
+    }
+    engine->nodes = nodes;
+
+    ma_uint32 channels[] = {CHANNELS};
+    for (int i = 0; i < ENGINE_NODE_COUNT; i++) {
+        EngineNode* node = engine_node_at(nodes, i);
+        ma_node_config config = ma_node_config_init();
+        config.vtable = i == 0 ? &master_node_vtable : &bus_node_vtable;
+        node->slot = i == 0 ? 0 : i - 1;
+        config.pInputChannels = channels;
+        config.pOutputChannels = channels;
+        node->engine = engine;
+        node->graph_index = -1;
+        if (ma_node_init(&nodes->graph, &config, NULL, node) != MA_SUCCESS) {
+            destroy_node_graph(engine, i);
+            return false;
+        }
+    }
+    ma_node_attach_output_bus(&nodes->master, 0, ma_node_graph_get_endpoint(&nodes->graph), 0);
+    nodes->wired_generation = 0;    // Generations start at 1, so the first graph wires
+    nodes->wired_track_count = 0;
+    return true;
+}
+
+// Track nodes of a new chunk. They stay detached until a graph that holds
+// their tracks is wired, so the audio thread never sees them half made.
+static bool init_track_nodes(AudioEngine* engine, TrackChunk* chunk, int first_slot) {
+    ma_uint32 channels[TRACK_NODE_OUTPUTS];
+    for (int i = 0; i < TRACK_NODE_OUTPUTS; i++) {
+        channels[i] = CHANNELS;
+    }
+    for (int lane = 0; lane < TRACK_CHUNK_TRACKS; lane++) {
+        EngineNode* node = &chunk->nodes[lane];
+        ma_node_config config = ma_node_config_init();
+        config.vtable = &track_node_vtable;
+        config.pOutputChannels = channels;
+        node->engine = engine;
+        node->slot = first_slot + lane;
+        node->graph_index = -1;
+        if (ma_node_init(&engine->nodes->graph, &config, NULL, node) != MA_SUCCESS) {
+            uninit_track_nodes(chunk, lane);
+            return false;
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// TRACK STORAGE (control thread)
+// ============================================================================
+
+// Add a chunk of empty track slots: block planes from the chunk's own
+// arena, so a chunk's tracks render out of one contiguous region, and its
+// track nodes on the node graph backend
+static bool grow_track_store(AudioEngine* engine) {
+    TrackStore* store = &engine->tracks;
+    if (store->chunk_count >= TRACK_MAX_CHUNKS) {
+        return false;
+    }
+    TrackChunk* chunk = (TrackChunk*)dsp_aligned_alloc(sizeof(TrackChunk), ENGINE_ARENA_ALIGNMENT);
+    if (!chunk) {
+        return false;
+    }
+    memset(chunk, 0, sizeof(TrackChunk));
+
+    size_t plane_bytes = sizeof(float) * engine->block_frames;
+    if (!engine_arena_init(&chunk->arena, (size_t)TRACK_CHUNK_TRACKS * 2 * engine_arena_footprint(plane_bytes))) {
+        dsp_aligned_free(chunk);
+        return false;
+    }
+    for (int lane = 0; lane < TRACK_CHUNK_TRACKS; lane++) {
+        chunk->buffers[lane].left = (float*)engine_arena_alloc(&chunk->arena, plane_bytes);
+        chunk->buffers[lane].right = (float*)engine_arena_alloc(&chunk->arena, plane_bytes);
+    }
+    if (engine->nodes && !init_track_nodes(engine, chunk, store->chunk_count * TRACK_CHUNK_TRACKS)) {
+        engine_arena_destroy(&chunk->arena);
+        dsp_aligned_free(chunk);
+        return false;
+    }
+    store->chunks[store->chunk_count++] = chunk;
+    return true;
+}
+
+// Engine stopped; node graph already destroyed
+static void free_track_store(AudioEngine* engine) {
+    TrackStore* store = &engine->tracks;
+    for (int c = 0; c < store->chunk_count; c++) {
+        engine_arena_destroy(&store->chunks[c]->arena);
+        dsp_aligned_free(store->chunks[c]);
+        store->chunks[c] = NULL;
+    }
+    store->chunk_count = 0;
+}
+
+// The device opened at another rate than the engine's: set up the
+// converter and the scratch the callback renders engine frames into
+static bool start_device_resampling(AudioEngine* engine) {
+    uint32_t device_rate = engine->device.sampleRate;
+    if (!resampler_init(&engine->device_resampler, CHANNELS, engine->sample_rate, device_rate,
+                        engine->config.device_quality, ENGINE_DEVICE_SRC_FRAMES)) {
+        engine_log(ENGINE_LOG_ERROR, "[miniaudio] Cannot convert %u Hz to the device's %u Hz", engine->sample_rate,
+                   device_rate);
+        return false;
+    }
+    engine->device_scratch = (float*)dsp_aligned_alloc(sizeof(float) * ENGINE_DEVICE_SRC_FRAMES * CHANNELS,
+                                                       ENGINE_ARENA_ALIGNMENT);
+    if (!engine->device_scratch) {
+        resampler_destroy(&engine->device_resampler);
+        return false;
+    }
+    uint32_t input_frames = ENGINE_DEVICE_SRC_FRAMES - engine->device_resampler.taps - 2;
+    engine->device_chunk_frames = (uint32_t)((uint64_t)input_frames * device_rate / engine->sample_rate);
+    engine->device_resampling = true;
+    engine_log(ENGINE_LOG_INFO, "[miniaudio] Device runs at %u Hz, converting from %u Hz (%s, %u frames ahead)",
+               device_rate, engine->sample_rate,
+               engine->config.device_quality == RESAMPLER_SINC ? "sinc" : "linear",
+               resampler_latency(&engine->device_resampler));
+    return true;
+}
+
+static void stop_device_resampling(AudioEngine* engine) {
+    if (engine->device_resampling) {
+        resampler_destroy(&engine->device_resampler);
+        dsp_aligned_free(engine->device_scratch);
+        engine->device_scratch = NULL;
+        engine->device_resampling = false;
+    }
+}
+
+// Open and start the playback device that drives audio_callback
+static bool open_device(AudioEngine* engine, bool capture) {
+    // Configure miniaudio device. Duplex devices deliver the input period
+    // in the same callback, already in the engine's format.
+    engine->device_config = ma_device_config_init(capture ? ma_device_type_duplex : ma_device_type_playback);
+    engine->device_config.playback.format = ma_format_f32;
+    engine->device_config.playback.channels = CHANNELS;
+    engine->device_config.capture.format = ma_format_f32;
+    engine->device_config.capture.channels = CHANNELS;
+    // Playback-only devices open at their own rate, so a mismatch goes
+    // through our converter (see start_device_resampling). Duplex devices
+    // keep input and output frame-locked at the engine rate and convert in
+    // miniaudio, with its steepest low-pass for the sinc tier.
+    engine->device_config.sampleRate = capture ? engine->sample_rate : 0;
+    if (engine->config.device_quality == RESAMPLER_SINC) {
+        engine->device_config.resampling.linear.lpfOrder = MA_MAX_FILTER_ORDER;
+    }
+    engine->device_config.dataCallback = audio_callback;
+    engine->device_config.notificationCallback = device_notification;
+    engine->device_config.pUserData = engine;
+    engine->device_config.periodSizeInFrames = engine->config.period_frames;
+    engine->device_config.performanceProfile = engine->config.mode == ENGINE_LATENCY_MIXDOWN
+                                                   ? ma_performance_profile_conservative
+                                                   : ma_performance_profile_low_latency;
+
+    // Initialize device; without a usable input, fall back to playback only
+    if (ma_device_init(NULL, &engine->device_config, &engine->device) != MA_SUCCESS) {
+        if (capture) {
+            engine_log(ENGINE_LOG_WARNING, "[miniaudio] No audio input available, opening playback only");
+            return open_device(engine, false);
+        }
+        ma_log_post(&engine->log, MA_LOG_LEVEL_ERROR, "Failed to initialize audio device");
+        return false;
+    }
+    engine->capture_open = capture;
+    if (!capture && engine->device.sampleRate != engine->sample_rate && !start_device_resampling(engine)) {
+        ma_device_uninit(&engine->device);
+        return false;
+    }
+    engine->device.pContext->pLog = &engine->log;
+    ma_log *lg = ma_device_get_log(&engine->device);
+    ma_log_post(lg, MA_LOG_LEVEL_INFO, "TEST LOGING");
+    ma_log_postf(&engine->log, MA_LOG_LEVEL_INFO, "Audio device initialized: %s", engine->device.playback.name);
+    ma_log_postf(&engine->log, MA_LOG_LEVEL_INFO, "Format: %s, Channels: %u, Sample Rate: %u",
+             ma_get_format_name(engine->device.playback.format),
+             engine->device.playback.channels,
+             engine->device.sampleRate);
+    if (capture) {
+        ma_log_postf(&engine->log, MA_LOG_LEVEL_INFO, "Audio input: %s", engine->device.capture.name);
+    }
+
+    // Start device
+    if (ma_device_start(&engine->device) != MA_SUCCESS) {
+        ma_log_post(&engine->log, MA_LOG_LEVEL_ERROR, "Failed to start audio device");
+        ma_device_uninit(&engine->device);
+        stop_device_resampling(engine);
+        engine->capture_open = false;
+        return false;
+    }
+    return true;
+}
+
+AudioEngineConfig audio_engine_config_init(EngineLatencyMode mode) {
+    AudioEngineConfig config = {
+        .period_frames = BUFFER_SIZE,
+        .block_frames = 0,
+        .render_workers = -1,
+        .mode = mode,
+        .backend = ENGINE_BACKEND_CALLBACK,
+        .capture = true,
+        .sample_rate = SAMPLE_RATE,
+        .device_quality = RESAMPLER_LINEAR,
+    };
+    switch (mode) {
+        case ENGINE_LATENCY_TRACKING:
+            config.period_frames = ENGINE_TRACKING_PERIOD_FRAMES;
+            break;
+        case ENGINE_LATENCY_MIXDOWN:
+            config.period_frames = ENGINE_MIXDOWN_PERIOD_FRAMES;
+            break;
+        default:
+            break;
+    }
+    return config;
+}
+
+bool audio_engine_init(AudioEngine* engine) {
+    AudioEngineConfig config = audio_engine_config_init(ENGINE_LATENCY_DEFAULT);
+    return audio_engine_init_with_config(engine, &config);
+}
+
+bool audio_engine_init_with_config(AudioEngine* engine, const AudioEngineConfig* config) {
+    /* memset(engine, 0, sizeof(AudioEngine)); */
+
+    engine->config = *config;
+    if (engine->config.period_frames == 0) {
+        engine->config.period_frames = BUFFER_SIZE;
+    }
+    engine->sample_rate = engine->config.sample_rate ? engine->config.sample_rate : SAMPLE_RATE;
+    if (engine->sample_rate < RESAMPLER_MIN_RATE || engine->sample_rate > RESAMPLER_MAX_RATE) {
+        engine_log(ENGINE_LOG_ERROR, "[miniaudio] Unsupported engine rate: %u Hz", engine->sample_rate);
+        return false;
+    }
+    engine->device_resampling = false;
+    engine->device_scratch = NULL;
+    engine->block_frames = engine->config.block_frames ? engine->config.block_frames : engine->config.period_frames;
+    if (engine->block_frames > ENGINE_MAX_BLOCK_FRAMES) {
+        engine->block_frames = ENGINE_MAX_BLOCK_FRAMES;
+    }
+
+    engine->master_volume = 0.75F;
+    engine->track_count = 0;
+    memset(&engine->tracks, 0, sizeof(TrackStore));
+    engine->bus_count = 0;
+    engine->frames_processed = 0;
+    engine->transport_frame = 0;
+    atomic_store(&engine->transport_position, 0);
+    atomic_store(&engine->commands_applied, 0);
+    engine->retired_lane_count = 0;
+    atomic_store(&engine->deadline_misses, 0);
+    engine->deadline_misses_reported = 0;
+    engine->deadline_report_frame = 0;
+    memset(&engine->dsp_load_record, 0, sizeof(DspLoadRecord));
+    dsp_load_accumulator_reset(&engine->dsp_load_window);
+    atomic_store(&engine->dsp_load.sequence, 0);
+    dsp_load_channel_publish(&engine->dsp_load, &engine->dsp_load_record);
+    atomic_store(&engine->device_glitches, 0);
+    atomic_store(&engine->profiling, false);
+    engine->dsp = dsp_kernels_best();
+    oscillator_tables_init();
+    atomic_store(&engine->playing, false);
+    spsc_ring_init(&engine->command_queue, engine->command_storage, sizeof(EngineCommand),
+                   ENGINE_COMMAND_QUEUE_SIZE);
+    spsc_ring_init(&engine->midi_queue, engine->midi_storage, sizeof(MidiEvent), ENGINE_MIDI_QUEUE_SIZE);
+    engine->midi_block_ns = config->offline_only ? 0 : engine_thread_time_ns();
+    atomic_store(&engine->midi_record_overflows, 0);
+
+    // Preallocate track/bus scratch and effect state, then spawn render workers
+    if (!alloc_render_buffers(engine)) {
+        free_render_buffers(engine);
+        return false;
+    }
+    if (!effect_state_pool_init(&engine->effect_states, EFFECT_STATE_POOL_BLOCKS)) {
+        free_render_buffers(engine);
+        return false;
+    }
+    int worker_count = config->render_workers >= 0 ? config->render_workers : worker_pool_default_thread_count();
+    if (!worker_pool_init(&engine->workers, worker_count, 1)) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Failed to start render workers, rendering serially");
+    }
+    engine->retired_clip_count = 0;
+    if (!clip_streamer_start(&engine->streamer)) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Failed to start clip streamer, clips unavailable");
+    }
+    engine->recording = false;
+    engine->take_number = 0;
+    engine->retired_take_count = 0;
+    if (!clip_recorder_start(&engine->recorder)) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Failed to start recorder, recording unavailable");
+    }
+
+    engine->nodes = NULL;
+    if (engine->config.backend == ENGINE_BACKEND_NODE_GRAPH && !create_node_graph(engine)) {
+        engine_log(ENGINE_LOG_ERROR, "[miniaudio] Failed to build the node graph backend");
+        worker_pool_shutdown(&engine->workers);
+        clip_streamer_stop(&engine->streamer);
+        clip_recorder_stop(&engine->recorder);
+        effect_state_pool_destroy(&engine->effect_states);
+        free_render_buffers(engine);
+        return false;
+    }
+
+    // Publish an empty graph so the callback always has a snapshot to render
+    spsc_ring_init(&engine->retired_graphs, engine->retired_storage, sizeof(RenderGraph*),
+                   ENGINE_RETIRE_QUEUE_SIZE);
+    engine->current_graph = NULL;
+    engine->graph_generation = 0;
+    engine->reclaimed_generation = 0;
+    engine->graph_latency = 0;
+    atomic_store(&engine->pending_graph, NULL);
+    RenderGraph* initial_graph = render_graph_build(engine);
+    if (!initial_graph) {
+        if (engine->nodes) {
+            destroy_node_graph(engine, ENGINE_NODE_COUNT);
+        }
+        worker_pool_shutdown(&engine->workers);
+        clip_streamer_stop(&engine->streamer);
+        clip_recorder_stop(&engine->recorder);
+        effect_state_pool_destroy(&engine->effect_states);
+        free_render_buffers(engine);
+        return false;
+    }
+    render_graph_publish(engine, initial_graph);
+
+    // From here on the device, streamer and workers may log: route every
+    // message through the log ring instead of blocking on the sink
+    engine->async_log = engine_log_start_async();
+    if (!engine->async_log) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Failed to start log thread, logging synchronously");
+    }
+
+    // Initialize miniaudio logging
+    ma_allocation_callbacks alloc_cb = ma_allocation_callbacks_init_default();
+    ma_log_init(&alloc_cb, &engine->log);
+    ma_log_register_callback(&engine->log,ma_log_callback_init(miniaudio_log_callback, NULL));
+
+    // Offline-only engines never open a device; they render through
+    // audio_engine_render_offline()
+    engine->capture_open = false;
+    if (!engine->config.offline_only && !open_device(engine, engine->config.capture)) {
+        ma_log_uninit(&engine->log);
+        if (engine->async_log) {
+            engine_log_stop_async();
+        }
+        render_graph_destroy_all(engine);
+        if (engine->nodes) {
+            destroy_node_graph(engine, ENGINE_NODE_COUNT);
+        }
+        worker_pool_shutdown(&engine->workers);
+        clip_streamer_stop(&engine->streamer);
+        clip_recorder_stop(&engine->recorder);
+        effect_state_pool_destroy(&engine->effect_states);
+        free_render_buffers(engine);
+        return false;
+    }
+
+    atomic_store(&engine->initialized, true);
+    ma_log_postf(&engine->log, MA_LOG_LEVEL_INFO, "Period: %u frames, block: %u frames",
+                 engine->config.period_frames, engine->block_frames);
+    ma_log_postf(&engine->log, MA_LOG_LEVEL_INFO, "Render workers: %d, DSP kernels: %s, backend: %s",
+                 engine->workers.thread_count, engine->dsp->name, engine->nodes ? "node graph" : "callback");
+    ma_log_post(&engine->log, MA_LOG_LEVEL_INFO, "Audio engine started successfully");
+    return true;
+}
+
+void audio_engine_shutdown(AudioEngine* engine) {
+    if (atomic_load(&engine->initialized)) {
+        engine_log(ENGINE_LOG_INFO, "[miniaudio] Shutting down audio engine...");
+
+        atomic_store(&engine->playing, false);
+        if (!engine->config.offline_only) {
+            ma_device_uninit(&engine->device);
+            stop_device_resampling(engine);
+        }
+        ma_log_uninit(&engine->log);
+        render_graph_destroy_all(engine);
+        if (engine->nodes) {
+            destroy_node_graph(engine, ENGINE_NODE_COUNT);
+        }
+        worker_pool_shutdown(&engine->workers);
+        clip_streamer_stop(&engine->streamer);
+        clip_recorder_stop(&engine->recorder);     // Finishes takes still recording
+        release_clips(engine, true);
+        release_takes(engine, true);
+        release_lanes(engine, true);
+        release_delay_lines(engine);
+        release_effect_states(engine, true);
+        effect_state_pool_destroy(&engine->effect_states);
+        free_render_buffers(engine);
+        free_track_store(engine);
+        atomic_store(&engine->initialized, false);
+
+        engine_log(ENGINE_LOG_INFO, "[miniaudio] Audio engine shut down");
+        if (engine->async_log) {
+            engine_log_stop_async();
+            engine->async_log = false;
+        }
+    }
+}
+
+uint64_t audio_engine_get_model_version(AudioEngine* engine) {
+    return engine->graph_generation + atomic_load_explicit(&engine->commands_applied, memory_order_acquire);
+}
+
+void audio_engine_snapshot(AudioEngine* engine, EngineSnapshot* snapshot) {
+    // Version first: a change during the copy moves it past the stored one
+    snapshot->model_version = audio_engine_get_model_version(engine);
+    snapshot->track_count = engine->track_count;
+    snapshot->playing = atomic_load_explicit(&engine->playing, memory_order_relaxed);
+    snapshot->recording = engine->recording;
+    snapshot->master_volume = engine->master_volume;
+    snapshot->latency_frames = engine->graph_latency;
+    snapshot->sample_rate = engine->sample_rate;
+    for (int i = 0; i < engine->track_count; i++) {
+        const TrackChunk* chunk = track_store_chunk(&engine->tracks, i);
+        const TrackMixLanes* mix = &chunk->mix;
+        const TrackInfo* track = &chunk->info[track_lane(i)];
+        int lane = track_lane(i);
+        TrackSnapshot* copy = &snapshot->tracks[i];
+        memcpy(copy->name, track->name, sizeof(copy->name));
+        copy->name[sizeof(copy->name) - 1] = '\0';
+        copy->volume = mix->volume[lane];
+        copy->pan = mix->pan[lane];
+        copy->playing = atomic_load_explicit(&mix->playing[lane], memory_order_relaxed);
+        copy->mute = atomic_load_explicit(&mix->mute[lane], memory_order_relaxed);
+        copy->solo = atomic_load_explicit(&mix->solo[lane], memory_order_relaxed);
+        copy->armed = atomic_load_explicit(&mix->armed[lane], memory_order_relaxed);
+        copy->input = atomic_load_explicit(&mix->input[lane], memory_order_relaxed);
+        copy->recording = track->recording != NULL;
+        copy->instrument = chunk->tracks[lane].instrument;
+        copy->frozen = track->frozen != NULL;
+        copy->clip_cache = audio_engine_get_track_clip_cache(engine, i);
+    }
+}
+
+uint32_t audio_engine_get_deadline_misses(AudioEngine* engine) {
+    return atomic_load_explicit(&engine->deadline_misses, memory_order_relaxed);
+}
+
+bool audio_engine_read_dsp_load(AudioEngine* engine, DspLoadRecord* record) {
+    return dsp_load_channel_read(&engine->dsp_load, record);
+}
+
+void audio_engine_set_profiling(AudioEngine* engine, bool enabled) {
+    atomic_store_explicit(&engine->profiling, enabled, memory_order_relaxed);
+}
+
+bool audio_engine_get_track_profile(AudioEngine* engine, int track_index, TrackProfile* profile) {
+    if (track_index < 0 || track_index >= engine->track_count) {
+        return false;
+    }
+    const TrackInfo* track = track_store_info(&engine->tracks, track_index);
+    profile->track_ns = atomic_load_explicit(&track->profile_ns, memory_order_relaxed);
+    for (int slot = 0; slot < MAX_EFFECTS_PER_TRACK; slot++) {
+        profile->effect_ns[slot] = atomic_load_explicit(&track->effect_profile_ns[slot], memory_order_relaxed);
+    }
+    return true;
+}
+
+void audio_engine_collect_garbage(AudioEngine* engine) {
+    render_graph_collect(engine);
+    release_effect_states(engine, false);
+    release_clips(engine, false);
+    release_takes(engine, false);
+    release_lanes(engine, false);
+}
+
+// ============================================================================
+// OFFLINE RENDERING
+// ============================================================================
+
+// Switch every live effect instance and clip stream between real-time and
+// offline behaviour (nothing is rendering while this runs)
+static void set_offline_mode(AudioEngine* engine, bool offline) {
+    for (int i = 0; i < engine->track_count + engine->bus_count; i++) {
+        EffectChain* chain = engine_chain(engine, i);
+        for (int slot = 0; slot < MAX_EFFECTS_PER_TRACK; slot++) {
+            Effect* effect = &chain->effects[slot];
+            const EffectVTable* vtable = effect_vtable(effect->type);
+            if (effect->state && vtable->set_offline) {
+                vtable->set_offline(effect, offline);
+            }
+        }
+    }
+    for (int t = 0; t < engine->track_count; t++) {
+        const TrackInfo* info = track_store_info(&engine->tracks, t);
+        if (info->clip) {
+            clip_stream_set_blocking(info->clip, offline);
+        }
+        if (info->frozen) {
+            clip_stream_set_blocking(info->frozen, offline);
+        }
+        if (info->recording) {
+            clip_recording_set_blocking(info->recording, offline);
+        }
+    }
+}
+
+// The caller's thread stands in for the device thread until resume_device()
+static bool pause_device(AudioEngine* engine, bool* device_running) {
+    *device_running = !engine->config.offline_only && ma_device_is_started(&engine->device);
+    if (*device_running && ma_device_stop(&engine->device) != MA_SUCCESS) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot render offline: failed to pause the device");
+        return false;
+    }
+    return true;
+}
+
+static void resume_device(AudioEngine* engine, bool device_running) {
+    if (device_running && ma_device_start(&engine->device) != MA_SUCCESS) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Failed to restart the device after offline render");
+    }
+}
+
+bool audio_engine_render_offline(AudioEngine* engine, uint64_t frame_count, const EngineRenderSink* sink) {
+    if (!atomic_load(&engine->initialized)) {
+        return false;
+    }
+
+    bool device_running;
+    if (!pause_device(engine, &device_running)) {
+        return false;
+    }
+    float* chunk = (float*)malloc(sizeof(float) * ENGINE_OFFLINE_CHUNK_FRAMES * CHANNELS);
+    bool ok = chunk != NULL;
+
+    bool was_playing = atomic_load(&engine->playing);
+    atomic_store(&engine->playing, true);
+    set_offline_mode(engine, true);
+
+    uint64_t rendered = 0;
+    while (ok && rendered < frame_count) {
+        uint64_t remaining = frame_count - rendered;
+        ma_uint32 count = remaining < ENGINE_OFFLINE_CHUNK_FRAMES ? (ma_uint32)remaining : ENGINE_OFFLINE_CHUNK_FRAMES;
+        engine_process(engine, NULL, chunk, count);
+        ok = sink->write(sink->user_data, chunk, count);
+        rendered += count;
+        audio_engine_collect_garbage(engine);
+    }
+
+    set_offline_mode(engine, false);
+    atomic_store(&engine->playing, was_playing);
+    free(chunk);
+
+    resume_device(engine, device_running);
+    engine_log(ENGINE_LOG_INFO, "[miniaudio] Offline render %s: %llu frames", ok ? "finished" : "aborted",
+               (unsigned long long)rendered);
+    return ok;
+}
+
+// Render one track's source, fader and chain (what a frozen track plays)
+// into a clip cache writer, from the current transport position on. Only
+// that track renders; the transport and every other track stay put.
+static bool render_track_offline(AudioEngine* engine, int track_index, uint64_t frame_count, ClipCacheWriter* writer) {
+    bool device_running;
+    if (!pause_device(engine, &device_running)) {
+        return false;
+    }
+
+    // Catch up with the control thread like a callback would, so the
+    // render sees every edit made so far
+    RenderGraph* previous_graph = render_graph_acquire(engine);
+    drain_commands(engine);
+    render_graph_retire(engine, previous_graph);
+
+    const RenderGraph* graph = engine->current_graph;
+    int graph_index = -1;
+    for (int t = 0; graph && t < graph->track_count; t++) {
+        if (graph->tracks[t].track_index == track_index) {
+            graph_index = t;
+        }
+    }
+    if (graph_index < 0) {
+        resume_device(engine, device_running);
+        return false;
+    }
+
+    set_offline_mode(engine, true);
+    const RenderTrack* rt = &graph->tracks[graph_index];
+    Track* track = &rt->chunk->tracks[rt->lane];
+    StereoBuffer* buffer = &rt->chunk->buffers[rt->lane];
+    bool ok = true;
+    uint64_t rendered = 0;
+    while (ok && rendered < frame_count) {
+        uint64_t remaining = frame_count - rendered;
+        ma_uint32 count = remaining < engine->block_frames ? (ma_uint32)remaining : engine->block_frames;
+        RenderContext ctx = {
+            .engine = engine,
+            .graph = graph,
+            .frame_count = count,
+            .transport_frame = engine->transport_frame + rendered,
+        };
+        if (!render_track_chain(&ctx, rt, track, buffer, false, NULL)) {
+            memset(buffer->left, 0, sizeof(float) * count);
+            memset(buffer->right, 0, sizeof(float) * count);
+        }
+        ok = clip_cache_writer_append(writer, buffer->left, buffer->right, count);
+        rendered += count;
+    }
+    set_offline_mode(engine, false);
+
+    resume_device(engine, device_running);
+    return ok;
+}
+
+bool audio_engine_process_block(AudioEngine* engine, float* out, uint32_t frame_count) {
+    return audio_engine_process_duplex_block(engine, NULL, out, frame_count);
+}
+
+bool audio_engine_process_duplex_block(AudioEngine* engine, const float* input, float* out, uint32_t frame_count) {
+    if (!atomic_load(&engine->initialized) || !engine->config.offline_only) {
+        return false;
+    }
+    engine_process_timed(engine, input, out, frame_count);
+    return true;
+}
+
+typedef struct {
+    ma_encoder encoder;
+    ma_format format;
+    void* converted;            // Frames in `format`, unless f32
+    bool resampling;            // The file runs at another rate
+    Resampler resampler;
+    float* resampled;
+    uint32_t resampled_capacity;
+    uint64_t remaining;         // File frames still to write
+} WavRenderSink;
+
+static bool wav_sink_encode(WavRenderSink* sink, const float* frames, uint32_t frame_count) {
+    if (frame_count > sink->remaining) {
+        frame_count = (uint32_t)sink->remaining;
+    }
+    sink->remaining -= frame_count;
+    const void* data = frames;
+    if (sink->format != ma_format_f32) {
+        ma_pcm_convert(sink->converted, sink->format, frames, ma_format_f32, (ma_uint64)frame_count * CHANNELS,
+                       ma_dither_mode_triangle);
+        data = sink->converted;
+    }
+    ma_uint64 written = 0;
+    return ma_encoder_write_pcm_frames(&sink->encoder, data, frame_count, &written) == MA_SUCCESS &&
+           written == frame_count;
+}
+
+static bool wav_sink_write(void* user_data, const float* frames, uint32_t frame_count) {
+    WavRenderSink* sink = (WavRenderSink*)user_data;
+    if (!sink->resampling) {
+        return wav_sink_encode(sink, frames, frame_count);
+    }
+    uint32_t taken = frame_count;
+    uint32_t produced = resampler_process(&sink->resampler, frames, &taken, sink->resampled,
+                                          sink->resampled_capacity);
+    return wav_sink_encode(sink, sink->resampled, produced);
+}
+
+// The last file frames lie within the converter's look-ahead of the end:
+// push silence past it until they are out
+static bool wav_sink_drain(WavRenderSink* sink) {
+    bool ok = true;
+    uint32_t produced = 1;
+    while (ok && sink->resampling && sink->remaining > 0 && produced > 0) {
+        uint32_t silence = resampler_latency(&sink->resampler) + 1;
+        produced = resampler_process(&sink->resampler, NULL, &silence, sink->resampled, sink->resampled_capacity);
+        ok = wav_sink_encode(sink, sink->resampled, produced);
+    }
+    return ok;
+}
+
+bool audio_engine_render_to_wav(AudioEngine* engine, const char* path, uint64_t frame_count, ma_format format) {
+    return audio_engine_export_wav(engine, path, frame_count, format, 0, RESAMPLER_SINC);
+}
+
+bool audio_engine_export_wav(AudioEngine* engine, const char* path, uint64_t frame_count, ma_format format,
+                             uint32_t sample_rate, ResamplerQuality quality) {
+    if (format != ma_format_f32 && format != ma_format_s16 && format != ma_format_s24 && format != ma_format_s32) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Unsupported render format: %s", ma_get_format_name(format));
+        return false;
+    }
+
+    WavRenderSink wav = {.format = format, .remaining = frame_count};
+    uint32_t chunk_frames = ENGINE_OFFLINE_CHUNK_FRAMES;
+    if (sample_rate != 0 && sample_rate != engine->sample_rate) {
+        if (!resampler_init(&wav.resampler, CHANNELS, engine->sample_rate, sample_rate, quality,
+                            ENGINE_OFFLINE_CHUNK_FRAMES)) {
+            engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot convert a render to %u Hz", sample_rate);
+            return false;
+        }
+        wav.resampling = true;
+        wav.remaining = resampler_output_length(frame_count, engine->sample_rate, sample_rate);
+        wav.resampled_capacity =
+            (uint32_t)resampler_output_length(wav.resampler.capacity_frames, engine->sample_rate, sample_rate) + 1;
+        wav.resampled = (float*)malloc(sizeof(float) * wav.resampled_capacity * CHANNELS);
+        chunk_frames = wav.resampled_capacity > chunk_frames ? wav.resampled_capacity : chunk_frames;
+    } else {
+        sample_rate = engine->sample_rate;
+    }
+
+    ma_encoder_config config = ma_encoder_config_init(ma_encoding_format_wav, format, CHANNELS, sample_rate);
+    bool ok = !wav.resampling || wav.resampled;
+    if (ok && format != ma_format_f32) {
+        wav.converted = malloc((size_t)chunk_frames * CHANNELS * ma_get_bytes_per_sample(format));
+        ok = wav.converted != NULL;
+    }
+    if (ok && ma_encoder_init_file(path, &config, &wav.encoder) != MA_SUCCESS) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot open render target: %s", path);
+        free(wav.converted);
+        free(wav.resampled);
+        resampler_destroy(&wav.resampler);
+        return false;
+    }
+
+    if (ok) {
+        EngineRenderSink sink = {.write = wav_sink_write, .user_data = &wav};
+        ok = audio_engine_render_offline(engine, frame_count, &sink) && wav_sink_drain(&wav);
+        ma_encoder_uninit(&wav.encoder);
+    }
+    free(wav.converted);
+    free(wav.resampled);
+    if (wav.resampling) {
+        resampler_destroy(&wav.resampler);
+    }
+    return ok;
+}
+
+// Rebuild the render graph from the track/effect model and hand it to the
+// audio thread. Called after every structural edit.
+static bool publish_graph(AudioEngine* engine) {
+    RenderGraph* graph = render_graph_build(engine);
+    if (!graph) {
+        engine_log(ENGINE_LOG_ERROR, "[miniaudio] Failed to allocate render graph");
+        return false;
+    }
+    if (graph->latency != engine->graph_latency) {
+        engine_log(ENGINE_LOG_INFO, "[miniaudio] Latency compensation: %u frames at master", graph->latency);
+        engine->graph_latency = graph->latency;
+    }
+    render_graph_publish(engine, graph);
+    return true;
+}
+
+// Unfreeze a track before an edit that would change its frozen audio: the
+// live chain is back in the graph, the clip resumes where the frozen audio
+// had got to and the frozen clip is retired. True if the track (if valid)
+// is not frozen any more.
+static bool thaw_track(AudioEngine* engine, int track_index) {
+    if (track_index < 0 || track_index >= engine->track_count ||
+        !track_store_info(&engine->tracks, track_index)->frozen) {
+        return true;
+    }
+    audio_engine_collect_garbage(engine);
+    if (engine->retired_clip_count >= ENGINE_MAX_RETIRED_CLIPS) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot unfreeze track %d: old clips still in use", track_index);
+        return false;
+    }
+
+    TrackInfo* track = track_store_info(&engine->tracks, track_index);
+    ClipStream* frozen = track->frozen;
+    track->frozen = NULL;
+    if (!publish_graph(engine)) {
+        track->frozen = frozen;
+        return false;
+    }
+
+    ClipStreamStats stats;
+    clip_stream_get_stats(frozen, &stats);
+    if (track->clip) {
+        uint64_t frame = track->freeze_clip_frame + stats.playhead_frame;
+        uint64_t length = track->clip->length_frames;
+        if (track->clip->loop && length > 0) {
+            frame %= length;
+        } else if (frame > length) {
+            frame = length;
+        }
+        clip_stream_seek(track->clip, frame);
+    }
+    engine->retired_clips[engine->retired_clip_count] = frozen;
+    engine->retired_clip_after[engine->retired_clip_count] = engine->graph_generation - 1;
+    engine->retired_clip_count++;
+    engine_log(ENGINE_LOG_INFO, "[miniaudio] Track %d unfrozen after %llu frames", track_index,
+               (unsigned long long)stats.playhead_frame);
+    return true;
+}
+
+bool audio_engine_send_command(AudioEngine* engine, const EngineCommand* command) {
+    if (!spsc_ring_push(&engine->command_queue, command)) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Command queue full, dropping command type %d", command->type);
+        return false;
+    }
+    return true;
+}
+
+bool audio_engine_set_playing(AudioEngine* engine, bool playing) {
+    EngineCommand cmd = {.type = CMD_SET_PLAYING, .flag = playing};
+    return audio_engine_send_command(engine, &cmd);
+}
+
+bool audio_engine_set_master_volume(AudioEngine* engine, float volume) {
+    EngineCommand cmd = {.type = CMD_SET_MASTER_VOLUME, .value = volume};
+    return audio_engine_send_command(engine, &cmd);
+}
+
+// Fill the next track slot with a tone (fixed-frequency oscillator) or an
+// instrument (voice pool), without publishing it
+static int claim_track_slot(AudioEngine* engine, const char* name, float frequency, bool instrument,
+                            OscWaveform waveform) {
+    if (engine->track_count >= MAX_TRACKS) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot add track: maximum tracks reached (%d)", MAX_TRACKS);
+        return -1;
+    }
+
+    // The slot is not referenced by any published graph yet, so it can be
+    // filled in here without synchronization.
+    int index = engine->track_count;
+    if (index / TRACK_CHUNK_TRACKS >= engine->tracks.chunk_count && !grow_track_store(engine)) {
+        engine_log(ENGINE_LOG_ERROR, "[miniaudio] Cannot add track: failed to allocate track storage");
+        return -1;
+    }
+    TrackChunk* chunk = track_store_chunk(&engine->tracks, index);
+    int lane = track_lane(index);
+    Track* track = &chunk->tracks[lane];
+    TrackInfo* info = &chunk->info[lane];
+    memset(track, 0, sizeof(Track));
+    memset(info, 0, sizeof(TrackInfo));
+
+    snprintf(info->name, sizeof(info->name), "%s", name);
+    chunk->mix.volume[lane] = 0.75F;
+    chunk->mix.pan[lane] = 0.0F;
+    atomic_store(&chunk->mix.mute[lane], false);
+    atomic_store(&chunk->mix.solo[lane], false);
+    atomic_store(&chunk->mix.armed[lane], false);
+    atomic_store(&chunk->mix.input[lane], false);
+    info->frequency = frequency;
+    oscillator_bank_init(&track->oscillator, (float)engine->sample_rate);
+    track->instrument = instrument;
+    if (instrument) {
+        voice_pool_init(&track->voices, waveform, (float)engine->sample_rate);
+    } else {
+        oscillator_bank_add_voice(&track->oscillator, waveform, frequency, 1.0F);
+    }
+    track->output_gain[0] = 0.0F;    // Fades in from silence on the first block
+    track->output_gain[1] = 0.0F;
+    info->output_bus = BUS_MASTER;
+    atomic_store(&chunk->mix.playing[lane], instrument);
+
+    engine->track_count++;
+    return index;
+}
+
+static int add_track(AudioEngine* engine, const char* name, float frequency, bool instrument,
+                     OscWaveform waveform) {
+    int index = claim_track_slot(engine, name, frequency, instrument, waveform);
+    if (index < 0) {
+        return -1;
+    }
+    if (!publish_graph(engine)) {
+        engine->track_count--;
+        return -1;
+    }
+    return index;
+}
+
+int audio_engine_add_track(AudioEngine* engine, const char* name, float frequency) {
+    int index = add_track(engine, name, frequency, false, OSC_SINE);
+    if (index >= 0) {
+        engine_log(ENGINE_LOG_INFO, "[miniaudio] Added track %d: %s (%.1f Hz)", index, name, frequency);
+    }
+    return index;
+}
+
+int audio_engine_add_instrument_track(AudioEngine* engine, const char* name, OscWaveform waveform) {
+    if ((int)waveform < 0 || waveform >= OSC_WAVEFORM_COUNT) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid waveform: %d", (int)waveform);
+        return -1;
+    }
+    int index = add_track(engine, name, 0.0F, true, waveform);
+    if (index >= 0) {
+        engine_log(ENGINE_LOG_INFO, "[miniaudio] Added instrument track %d: %s (%d voices)", index, name,
+                   VOICE_POOL_MAX_VOICES);
+    }
+    return index;
+}
+
+static bool send_note_command(AudioEngine* engine, EngineCommandType type, int track_index, int note,
+                              float velocity) {
+    if (track_index < 0 || track_index >= engine->track_count ||
+        !track_store_track(&engine->tracks, track_index)->instrument) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Track %d is not an instrument track", track_index);
+        return false;
+    }
+    if (note < 0 || note >= VOICE_NOTE_COUNT) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid note: %d", note);
+        return false;
+    }
+    EngineCommand cmd = {.type = type, .track_index = track_index, .note = note, .value = velocity};
+    return audio_engine_send_command(engine, &cmd);
+}
+
+bool audio_engine_note_on(AudioEngine* engine, int track_index, int note, float velocity) {
+    return send_note_command(engine, CMD_NOTE_ON, track_index, note, velocity);
+}
+
+bool audio_engine_note_off(AudioEngine* engine, int track_index, int note) {
+    return send_note_command(engine, CMD_NOTE_OFF, track_index, note, 0.0F);
+}
+
+bool audio_engine_all_notes_off(AudioEngine* engine, int track_index) {
+    return send_note_command(engine, CMD_ALL_NOTES_OFF, track_index, 0, 0.0F);
+}
+
+bool audio_engine_push_midi(AudioEngine* engine, const MidiEvent* event) {
+    return spsc_ring_push(&engine->midi_queue, event);
+}
+
+bool audio_engine_set_track_armed(AudioEngine* engine, int track_index, bool armed) {
+    if (track_index < 0 || track_index >= engine->track_count) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid track index: %d", track_index);
+        return false;
+    }
+    EngineCommand cmd = {.type = CMD_SET_TRACK_ARMED, .track_index = track_index, .flag = armed};
+    return audio_engine_send_command(engine, &cmd);
+}
+
+uint32_t audio_engine_read_recorded_midi(AudioEngine* engine, RecordedMidiEvent* events, uint32_t max) {
+    uint32_t count = 0;
+    while (count < max && spsc_ring_pop(&engine->recorded_midi, &events[count])) {
+        count++;
+    }
+    return count;
+}
+
+bool audio_engine_set_track_volume(AudioEngine* engine, int track_index, float volume) {
+    if (!thaw_track(engine, track_index)) {
+        return false;
+    }
+    EngineCommand cmd = {.type = CMD_SET_TRACK_VOLUME, .track_index = track_index, .value = volume};
+    return audio_engine_send_command(engine, &cmd);
+}
+
+bool audio_engine_set_track_pan(AudioEngine* engine, int track_index, float pan) {
+    if (!thaw_track(engine, track_index)) {
+        return false;
+    }
+    EngineCommand cmd = {.type = CMD_SET_TRACK_PAN, .track_index = track_index, .value = pan};
+    return audio_engine_send_command(engine, &cmd);
+}
+
+bool audio_engine_set_track_mute(AudioEngine* engine, int track_index, bool mute) {
+    EngineCommand cmd = {.type = CMD_SET_TRACK_MUTE, .track_index = track_index, .flag = mute};
+    return audio_engine_send_command(engine, &cmd);
+}
+
+bool audio_engine_set_track_solo(AudioEngine* engine, int track_index, bool solo) {
+    EngineCommand cmd = {.type = CMD_SET_TRACK_SOLO, .track_index = track_index, .flag = solo};
+    return audio_engine_send_command(engine, &cmd);
+}
+
+bool audio_engine_set_track_playing(AudioEngine* engine, int track_index, bool playing) {
+    EngineCommand cmd = {.type = CMD_SET_TRACK_PLAYING, .track_index = track_index, .flag = playing};
+    return audio_engine_send_command(engine, &cmd);
+}
+
+bool audio_engine_set_track_send(AudioEngine* engine, int track_index, int bus_index, float level) {
+    if (track_index < 0 || track_index >= engine->track_count ||
+        bus_index < 0 || bus_index >= engine->bus_count) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid send: track %d -> bus %d", track_index, bus_index);
+        return false;
+    }
+
+    TrackInfo* track = track_store_info(&engine->tracks, track_index);
+    bool enable = level > 0.0F;
+    EngineCommand cmd = {
+        .type = CMD_SET_TRACK_SEND,
+        .track_index = track_index,
+        .bus_index = bus_index,
+        .value = enable ? level : 0.0F,
+    };
+
+    if (enable == track->send_enabled[bus_index]) {
+        return audio_engine_send_command(engine, &cmd);
+    }
+
+    // Adding a send: queue the level first so the graph that introduces the
+    // send never renders it with a stale gain. Removing: drop it from the
+    // graph, then zero the level for the next time it is enabled.
+    if (enable && !audio_engine_send_command(engine, &cmd)) {
+        return false;
+    }
+    track->send_enabled[bus_index] = enable;
+    if (!publish_graph(engine)) {
+        track->send_enabled[bus_index] = !enable;
+        return false;
+    }
+    if (!enable) {
+        audio_engine_send_command(engine, &cmd);
+    }
+    return true;
+}
+
+bool audio_engine_set_track_output(AudioEngine* engine, int track_index, int bus_index) {
+    if (track_index < 0 || track_index >= engine->track_count) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid track index: %d", track_index);
+        return false;
+    }
+    if (bus_index != BUS_MASTER && (bus_index < 0 || bus_index >= engine->bus_count)) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid bus index: %d", bus_index);
+        return false;
+    }
+
+    TrackInfo* track = track_store_info(&engine->tracks, track_index);
+    int previous = track->output_bus;
+    track->output_bus = bus_index;
+    if (!publish_graph(engine)) {
+        track->output_bus = previous;
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// CLIPS
+// ============================================================================
+
+// Import into the clip cache (decoded once, mapped afterwards); stream
+// through a decoder only if the cache cannot be written
+static ClipStream* open_clip(AudioEngine* engine, const char* path, bool loop) {
+    ClipStream* clip = NULL;
+    char cache_path[1024];
+    if (clip_cache_import(path, engine->sample_rate, ENGINE_CLIP_CACHE_FORMAT, cache_path, sizeof(cache_path))) {
+        clip = clip_stream_open_cache(&engine->streamer, cache_path, loop);
+    } else {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot cache '%s', decoding while streaming", path);
+    }
+    if (!clip) {
+        clip = clip_stream_open(&engine->streamer, path, engine->sample_rate, loop);
+    }
+    if (!clip) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Failed to open clip: %s", path);
+    }
+    return clip;
+}
+
+bool audio_engine_load_track_clip(AudioEngine* engine, int track_index, const char* path, bool loop) {
+    if (track_index < 0 || track_index >= engine->track_count) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid track index: %d", track_index);
+        return false;
+    }
+    if (path && !engine->streamer.started) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot load clip: streamer not running");
+        return false;
+    }
+
+    if (!thaw_track(engine, track_index)) {
+        return false;
+    }
+    TrackInfo* track = track_store_info(&engine->tracks, track_index);
+    if (track->clip) {
+        audio_engine_collect_garbage(engine);
+        if (engine->retired_clip_count >= ENGINE_MAX_RETIRED_CLIPS) {
+            engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot replace clip: old clips still in use by audio thread");
+            return false;
+        }
+    }
+
+    ClipStream* clip = path ? open_clip(engine, path, loop) : NULL;
+    if (path && !clip) {
+        return false;
+    }
+
+    ClipStream* previous = track->clip;
+    track->clip = clip;
+    if (!publish_graph(engine)) {
+        track->clip = previous;
+        clip_stream_close(&engine->streamer, clip);
+        return false;
+    }
+    snprintf(track->clip_path, sizeof(track->clip_path), "%s", path ? path : "");
+
+    // The graph before this one (generation N - 1) may still be reading the
+    // old clip; it can be closed once that graph has been handed back.
+    if (previous) {
+        engine->retired_clips[engine->retired_clip_count] = previous;
+        engine->retired_clip_after[engine->retired_clip_count] = engine->graph_generation - 1;
+        engine->retired_clip_count++;
+    }
+
+    if (clip) {
+        engine_log(ENGINE_LOG_INFO, "[miniaudio] Track %d streams '%s' (%llu frames)", track_index, path,
+                   (unsigned long long)clip->length_frames);
+    }
+    return true;
+}
+
+// Clip of a valid track, or NULL
+static ClipStream* track_clip(AudioEngine* engine, int track_index) {
+    if (track_index < 0 || track_index >= engine->track_count) {
+        return NULL;
+    }
+    return track_store_info(&engine->tracks, track_index)->clip;
+}
+
+bool audio_engine_set_track_clip_position(AudioEngine* engine, int track_index, uint64_t frame) {
+    if (!track_clip(engine, track_index)) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Track %d has no clip", track_index);
+        return false;
+    }
+    if (!thaw_track(engine, track_index)) {
+        return false;
+    }
+    clip_stream_seek(track_clip(engine, track_index), frame);
+    return true;
+}
+
+const ClipCache* audio_engine_get_track_clip_cache(AudioEngine* engine, int track_index) {
+    ClipStream* clip = track_clip(engine, track_index);
+    if (!clip || !clip->cached) {
+        return NULL;
+    }
+    return &clip->cache;
+}
+
+bool audio_engine_get_track_clip_stats(AudioEngine* engine, int track_index, ClipStreamStats* stats) {
+    ClipStream* clip = track_clip(engine, track_index);
+    if (!clip) {
+        return false;
+    }
+    clip_stream_get_stats(clip, stats);
+    return true;
+}
+
+bool audio_engine_set_track_input(AudioEngine* engine, int track_index, bool enabled) {
+    if (track_index < 0 || track_index >= engine->track_count) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid track index: %d", track_index);
+        return false;
+    }
+    if (enabled && !thaw_track(engine, track_index)) {
+        return false;
+    }
+    if (enabled && !engine->capture_open && !engine->config.offline_only) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Track %d takes input, but the device has none", track_index);
+    }
+    EngineCommand cmd = {.type = CMD_SET_TRACK_INPUT, .track_index = track_index, .flag = enabled};
+    return audio_engine_send_command(engine, &cmd);
+}
+
+bool audio_engine_start_recording(AudioEngine* engine, const char* directory) {
+    if (engine->recording) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Already recording");
+        return false;
+    }
+    if (!engine->recorder.started) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot record: recorder not running");
+        return false;
+    }
+    audio_engine_collect_garbage(engine);
+
+    // One take per armed input track, all starting with the same graph
+    int take_number = engine->take_number + 1;
+    int takes = 0;
+    for (int t = 0; t < engine->track_count; t++) {
+        TrackMixLanes* mix = track_store_mix(&engine->tracks, t);
+        TrackInfo* track = track_store_info(&engine->tracks, t);
+        if (!atomic_load(&mix->armed[track_lane(t)]) || !atomic_load(&mix->input[track_lane(t)])) continue;
+        if (engine->retired_take_count + takes >= ENGINE_MAX_RETIRED_TAKES) {
+            engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot record track %d: old takes still in use", t);
+            continue;
+        }
+        char path[512];
+        snprintf(path, sizeof(path), "%s/track%02d_take%03d%s", directory, t, take_number, CLIP_CACHE_EXTENSION);
+        track->recording = clip_recording_open(&engine->recorder, path, engine->sample_rate);
+        if (!track->recording) {
+            engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot record track %d to '%s'", t, path);
+            continue;
+        }
+        takes++;
+    }
+    if (takes == 0) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Nothing to record: no armed input tracks");
+        return false;
+    }
+    if (!publish_graph(engine)) {
+        for (int t = 0; t < engine->track_count; t++) {
+            TrackInfo* track = track_store_info(&engine->tracks, t);
+            clip_recording_close(&engine->recorder, track->recording);
+            track->recording = NULL;
+        }
+        return false;
+    }
+    engine->take_number = take_number;
+    engine->recording = true;
+    engine_log(ENGINE_LOG_INFO, "[miniaudio] Recording take %d on %d track(s)", take_number, takes);
+    return true;
+}
+
+bool audio_engine_stop_recording(AudioEngine* engine) {
+    if (!engine->recording) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Not recording");
+        return false;
+    }
+
+    // Detach the takes from the next graph; the current one may keep
+    // writing to them until the audio thread swaps it out, which finishing
+    // ignores and reclamation waits for
+    ClipRecording* takes[MAX_TRACKS] = {0};
+    for (int t = 0; t < engine->track_count; t++) {
+        TrackInfo* track = track_store_info(&engine->tracks, t);
+        takes[t] = track->recording;
+        track->recording = NULL;
+    }
+    bool published = publish_graph(engine);
+    if (!published) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Takes stay attached until the next graph is published");
+    }
+
+    bool ok = true;
+    for (int t = 0; t < engine->track_count; t++) {
+        ClipRecording* take = takes[t];
+        if (!take) continue;
+        ClipRecordingStats stats;
+        bool written = clip_recording_finish(take);
+        clip_recording_get_stats(take, &stats);
+        if (written) {
+            engine_log(ENGINE_LOG_INFO, "[miniaudio] Track %d recorded %llu frames to '%s' (%llu dropped)", t,
+                       (unsigned long long)stats.written_frames, take->path,
+                       (unsigned long long)stats.dropped_frames);
+        } else {
+            engine_log(ENGINE_LOG_WARNING, "[miniaudio] Track %d take '%s' was not written", t, take->path);
+        }
+        ok = ok && written;
+
+        // Generation N - 1 (or the still current one) may reference the take
+        engine->retired_takes[engine->retired_take_count] = take;
+        engine->retired_take_after[engine->retired_take_count] =
+            published ? engine->graph_generation - 1 : engine->graph_generation;
+        engine->retired_take_count++;
+    }
+    engine->recording = false;
+    return ok;
+}
+
+bool audio_engine_get_track_recording_stats(AudioEngine* engine, int track_index, ClipRecordingStats* stats) {
+    if (track_index < 0 || track_index >= engine->track_count) {
+        return false;
+    }
+    ClipRecording* take = track_store_info(&engine->tracks, track_index)->recording;
+    if (!take) {
+        return false;
+    }
+    clip_recording_get_stats(take, stats);
+    return true;
+}
+
+// ============================================================================
+// FREEZE
+// ============================================================================
+
+bool audio_engine_freeze_track(AudioEngine* engine, int track_index, uint64_t frame_count, const char* directory) {
+    if (track_index < 0 || track_index >= engine->track_count) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid track index: %d", track_index);
+        return false;
+    }
+    const Track* dsp = track_store_track(&engine->tracks, track_index);
+    TrackInfo* track = track_store_info(&engine->tracks, track_index);
+    bool input = atomic_load(&track_store_mix(&engine->tracks, track_index)->input[track_lane(track_index)]);
+    if (dsp->instrument || input) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot freeze track %d: its source is live", track_index);
+        return false;
+    }
+    if (!engine->streamer.started) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot freeze: streamer not running");
+        return false;
+    }
+    if (!thaw_track(engine, track_index)) {
+        return false;
+    }
+
+    // Where the clip is now is where the frozen audio starts
+    uint64_t clip_frame = 0;
+    if (track->clip) {
+        ClipStreamStats stats;
+        clip_stream_get_stats(track->clip, &stats);
+        clip_frame = stats.playhead_frame;
+    }
+    if (frame_count == 0) {
+        frame_count = (uint64_t)engine->sample_rate * ENGINE_FREEZE_DEFAULT_SECONDS;
+        if (track->clip && !track->clip->loop) {
+            frame_count = track->clip->length_frames - clip_frame;
+            for (int i = 0; i < dsp->chain.count; i++) {
+                frame_count += effect_tail(&dsp->chain.effects[dsp->chain.order[i]]);
+            }
+        }
+    }
+
+    char path[512];
+    int freeze_number = engine->freeze_number + 1;
+    snprintf(path, sizeof(path), "%s/track%02d_freeze%03d%s", directory, track_index, freeze_number,
+             CLIP_CACHE_EXTENSION);
+    ClipCacheWriter writer;
+    if (!clip_cache_writer_open(&writer, path, CHANNELS, engine->sample_rate)) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot freeze track %d to '%s'", track_index, path);
+        return false;
+    }
+    if (!render_track_offline(engine, track_index, frame_count, &writer)) {
+        clip_cache_writer_abort(&writer);
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Failed to render track %d for freezing", track_index);
+        return false;
+    }
+    ClipStream* frozen = clip_cache_writer_finish(&writer) ? clip_stream_open_cache(&engine->streamer, path, false)
+                                                           : NULL;
+    if (!frozen) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot open frozen audio '%s'", path);
+        return false;
+    }
+
+    track->frozen = frozen;
+    track->freeze_clip_frame = clip_frame;
+    if (!publish_graph(engine)) {
+        track->frozen = NULL;
+        clip_stream_close(&engine->streamer, frozen);
+        return false;
+    }
+    engine->freeze_number = freeze_number;
+    engine_log(ENGINE_LOG_INFO, "[miniaudio] Track %d frozen to '%s' (%llu frames)", track_index, path,
+               (unsigned long long)frame_count);
+    return true;
+}
+
+bool audio_engine_unfreeze_track(AudioEngine* engine, int track_index) {
+    if (track_index < 0 || track_index >= engine->track_count) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid track index: %d", track_index);
+        return false;
+    }
+    if (!track_store_info(&engine->tracks, track_index)->frozen) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Track %d is not frozen", track_index);
+        return false;
+    }
+    return thaw_track(engine, track_index);
+}
+
+// ============================================================================
+// BUSES
+// ============================================================================
+
+// Fill the next bus slot, without publishing it
+static int claim_bus_slot(AudioEngine* engine, const char* name) {
+    if (engine->bus_count >= MAX_BUSES) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot add bus: maximum buses reached (%d)", MAX_BUSES);
+        return -1;
+    }
+
+    // Not referenced by any published graph yet (see audio_engine_add_track)
+    int index = engine->bus_count;
+    Bus* bus = &engine->buses[index];
+    memset(bus, 0, sizeof(Bus));
+
+    snprintf(bus->name, sizeof(bus->name), "%s", name);
+    bus->volume = 1.0F;
+    atomic_store(&bus->mute, false);
+    bus->output_bus = BUS_MASTER;
+
+    engine->bus_count++;
+    return index;
+}
+
+int audio_engine_add_bus(AudioEngine* engine, const char* name) {
+    int index = claim_bus_slot(engine, name);
+    if (index < 0) {
+        return -1;
+    }
+    if (!publish_graph(engine)) {
+        engine->bus_count--;
+        return -1;
+    }
+
+    engine_log(ENGINE_LOG_INFO, "[miniaudio] Added bus %d: %s", index, name);
+    return index;
+}
+
+// True if routing bus_index into output_bus would make a bus feed itself
+static bool bus_route_forms_cycle(AudioEngine* engine, int bus_index, int output_bus) {
+    int current = output_bus;
+    for (int hops = 0; current != BUS_MASTER && hops <= engine->bus_count; hops++) {
+        if (current == bus_index) {
+            return true;
+        }
+        current = engine->buses[current].output_bus;
+    }
+    return current != BUS_MASTER;
+}
+
+bool audio_engine_set_bus_output(AudioEngine* engine, int bus_index, int output_bus) {
+    if (bus_index < 0 || bus_index >= engine->bus_count ||
+        (output_bus != BUS_MASTER && (output_bus < 0 || output_bus >= engine->bus_count))) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid bus route: %d -> %d", bus_index, output_bus);
+        return false;
+    }
+    if (bus_route_forms_cycle(engine, bus_index, output_bus)) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot route bus '%s' to bus %d: would form a cycle",
+                   engine->buses[bus_index].name, output_bus);
+        return false;
+    }
+
+    Bus* bus = &engine->buses[bus_index];
+    int previous = bus->output_bus;
+    bus->output_bus = output_bus;
+    if (!publish_graph(engine)) {
+        bus->output_bus = previous;
+        return false;
+    }
+    return true;
+}
+
+bool audio_engine_set_bus_volume(AudioEngine* engine, int bus_index, float volume) {
+    EngineCommand cmd = {.type = CMD_SET_BUS_VOLUME, .bus_index = bus_index, .value = volume};
+    return audio_engine_send_command(engine, &cmd);
+}
+
+bool audio_engine_set_bus_mute(AudioEngine* engine, int bus_index, bool mute) {
+    EngineCommand cmd = {.type = CMD_SET_BUS_MUTE, .bus_index = bus_index, .flag = mute};
+    return audio_engine_send_command(engine, &cmd);
+}
+
+// ============================================================================
+// EFFECT CHAINS (shared by tracks and buses)
+// ============================================================================
+
+// Find an effect slot that no snapshot still in use can reference
+static int find_free_effect_slot(AudioEngine* engine, EffectChain* chain) {
+    for (int slot = 0; slot < MAX_EFFECTS_PER_TRACK; slot++) {
+        if (!chain->slot_used[slot] &&
+            chain->slot_free_after[slot] <= engine->reclaimed_generation) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+// Create an effect at the end of a chain, without publishing it. Returns
+// its slot or -1.
+static int chain_claim_effect(AudioEngine* engine, EffectChain* chain, EffectType type,
+                              const EffectCreateInfo* info) {
+    if (chain->count >= MAX_EFFECTS_PER_TRACK) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot add effect: maximum effects reached (%d)", MAX_EFFECTS_PER_TRACK);
+        return -1;
+    }
+
+    render_graph_collect(engine);
+    int slot = find_free_effect_slot(engine, chain);
+    if (slot < 0) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot add effect: slots still in use by audio thread");
+        return -1;
+    }
+
+    // The slot is unreachable from every live snapshot, so its previous
+    // instance can be torn down before the new one takes its place
+    Effect* effect = &chain->effects[slot];
+    effect_instance_destroy(effect, &engine->effect_states);
+    if (!effect_instance_create(effect, type, &engine->effect_states, info)) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot add effect type %d: no state or resources for it", type);
+        return -1;
+    }
+
+    chain->slot_used[slot] = true;
+    chain->slot_serial[slot]++;
+    chain->order[chain->count++] = slot;
+    return slot;
+}
+
+static bool chain_add_effect(AudioEngine* engine, EffectChain* chain, EffectType type,
+                             const EffectCreateInfo* info, const char* owner) {
+    int slot = chain_claim_effect(engine, chain, type, info);
+    if (slot < 0) {
+        return false;
+    }
+    Effect* effect = &chain->effects[slot];
+    if (!publish_graph(engine)) {
+        chain->count--;
+        chain->slot_used[slot] = false;
+        effect_instance_destroy(effect, &engine->effect_states);
+        return false;
+    }
+
+    engine_log(ENGINE_LOG_INFO, "[miniaudio] Added effect type %d to '%s'", type, owner);
+    return true;
+}
+
+static bool chain_remove_effect(AudioEngine* engine, EffectChain* chain, int effect_index, const char* owner) {
+    if (effect_index < 0 || effect_index >= chain->count) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid effect index: %d", effect_index);
+        return false;
+    }
+
+    int slot = chain->order[effect_index];
+
+    // Shift effects down
+    for (int i = effect_index; i < chain->count - 1; i++) {
+        chain->order[i] = chain->order[i + 1];
+    }
+    chain->count--;
+
+    // The current graph (generation N) still references the slot; it becomes
+    // reusable once that graph has been handed back.
+    uint64_t free_after = chain->slot_free_after[slot];
+    chain->slot_used[slot] = false;
+    chain->slot_free_after[slot] = engine->graph_generation;
+    if (!publish_graph(engine)) {
+        // The audio thread keeps running the old graph, effect included
+        memmove(&chain->order[effect_index + 1], &chain->order[effect_index],
+                sizeof(int) * (size_t)(chain->count - effect_index));
+        chain->order[effect_index] = slot;
+        chain->count++;
+        chain->slot_used[slot] = true;
+        chain->slot_free_after[slot] = free_after;
+        return false;
+    }
+
+    engine_log(ENGINE_LOG_INFO, "[miniaudio] Removed effect %d from '%s'", effect_index, owner);
+    return true;
+}
+
+static bool chain_move_effect(AudioEngine* engine, EffectChain* chain, int from_index, int to_index) {
+    if (from_index < 0 || from_index >= chain->count ||
+        to_index < 0 || to_index >= chain->count) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid effect move: %d -> %d", from_index, to_index);
+        return false;
+    }
+
+    int slot = chain->order[from_index];
+    if (from_index < to_index) {
+        memmove(&chain->order[from_index], &chain->order[from_index + 1],
+                sizeof(int) * (size_t)(to_index - from_index));
+    } else if (from_index > to_index) {
+        memmove(&chain->order[to_index + 1], &chain->order[to_index],
+                sizeof(int) * (size_t)(from_index - to_index));
+    }
+    chain->order[to_index] = slot;
+
+    return publish_graph(engine);
+}
+
+static Track* find_track(AudioEngine* engine, int track_index) {
+    if (track_index < 0 || track_index >= engine->track_count) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid track index: %d", track_index);
+        return NULL;
+    }
+    return track_store_track(&engine->tracks, track_index);
+}
+
+static Bus* find_bus(AudioEngine* engine, int bus_index) {
+    if (bus_index < 0 || bus_index >= engine->bus_count) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid bus index: %d", bus_index);
+        return NULL;
+    }
+    return &engine->buses[bus_index];
+}
+
+// Latent types report their delay at the rate they run at, which would not
+// come back down as a whole number of engine frames
+static bool can_oversample(EffectType type, uint32_t oversampling) {
+    if (oversampling > 1 && (!oversampler_factor_valid(oversampling) || effect_vtable(type)->latency)) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot run effect type %d at %ux", type, oversampling);
+        return false;
+    }
+    return true;
+}
+
+bool audio_engine_add_effect(AudioEngine* engine, int track_index, EffectType type) {
+    return audio_engine_add_oversampled_effect(engine, track_index, type, 1);
+}
+
+bool audio_engine_add_oversampled_effect(AudioEngine* engine, int track_index, EffectType type,
+                                         uint32_t oversampling) {
+    Track* track = find_track(engine, track_index);
+    if (!track || !can_oversample(type, oversampling) || !thaw_track(engine, track_index)) {
+        return false;
+    }
+    EffectCreateInfo info = {.sample_rate = (float)engine->sample_rate, .dsp = engine->dsp,
+                             .oversampling = oversampling};
+    return chain_add_effect(engine, &track->chain, type, &info,
+                            track_store_info(&engine->tracks, track_index)->name);
+}
+
+bool audio_engine_add_convolution(AudioEngine* engine, int track_index, const float* ir, uint32_t ir_frames,
+                                  uint32_t ir_channels) {
+    Track* track = find_track(engine, track_index);
+    if (!track || !thaw_track(engine, track_index)) {
+        return false;
+    }
+    EffectCreateInfo info = {
+        .sample_rate = (float)engine->sample_rate,
+        .dsp = engine->dsp,
+        .ir = ir,
+        .ir_frames = ir_frames,
+        .ir_channels = ir_channels,
+    };
+    return chain_add_effect(engine, &track->chain, EFFECT_CONVOLUTION, &info,
+                            track_store_info(&engine->tracks, track_index)->name);
+}
+
+// A plugin that fails to load is refused here (sessions keep it instead)
+static EffectCreateInfo clap_create_info(AudioEngine* engine, const char* path, const struct clap_plugin_entry* entry,
+                                         const char* plugin_id) {
+    EffectCreateInfo info = {
+        .sample_rate = (float)engine->sample_rate,
+        .dsp = engine->dsp,
+        .plugin_path = path,
+        .plugin_id = plugin_id,
+        .plugin_entry = entry,
+        .max_frames = ENGINE_MAX_BLOCK_FRAMES,
+    };
+    return info;
+}
+
+bool audio_engine_add_clap_effect(AudioEngine* engine, int track_index, const char* path, const char* plugin_id) {
+    Track* track = find_track(engine, track_index);
+    if (!track || !path || !thaw_track(engine, track_index)) {
+        return false;
+    }
+    EffectCreateInfo info = clap_create_info(engine, path, NULL, plugin_id);
+    return chain_add_effect(engine, &track->chain, EFFECT_CLAP, &info,
+                            track_store_info(&engine->tracks, track_index)->name);
+}
+
+bool audio_engine_add_linked_clap_effect(AudioEngine* engine, int track_index, const struct clap_plugin_entry* entry,
+                                         const char* plugin_id) {
+    Track* track = find_track(engine, track_index);
+    if (!track || !entry || !thaw_track(engine, track_index)) {
+        return false;
+    }
+    EffectCreateInfo info = clap_create_info(engine, NULL, entry, plugin_id);
+    return chain_add_effect(engine, &track->chain, EFFECT_CLAP, &info,
+                            track_store_info(&engine->tracks, track_index)->name);
+}
+
+bool audio_engine_remove_effect(AudioEngine* engine, int track_index, int effect_index) {
+    Track* track = find_track(engine, track_index);
+    if (!track || !thaw_track(engine, track_index)) {
+        return false;
+    }
+    TrackInfo* info = track_store_info(&engine->tracks, track_index);
+
+    // The effect's automation lanes go with it: make sure they can be retired
+    int slot = effect_index >= 0 && effect_index < track->chain.count ? track->chain.order[effect_index] : -1;
+    int lane_count = 0;
+    for (int p = 0; slot >= 0 && p < ENGINE_MAX_AUTOMATED_PARAMS; p++) {
+        lane_count += info->effect_lanes[slot][p] != NULL;
+    }
+    if (lane_count > 0) {
+        audio_engine_collect_garbage(engine);
+        if (engine->retired_lane_count + lane_count > ENGINE_MAX_RETIRED_LANES) {
+            engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot remove effect: automation still in use by audio thread");
+            return false;
+        }
+    }
+
+    if (!chain_remove_effect(engine, &track->chain, effect_index, info->name)) {
+        return false;
+    }
+    for (int p = 0; lane_count > 0 && p < ENGINE_MAX_AUTOMATED_PARAMS; p++) {
+        if (info->effect_lanes[slot][p]) {
+            retire_lane(engine, info->effect_lanes[slot][p]);
+            info->effect_lanes[slot][p] = NULL;
+        }
+    }
+    return true;
+}
+
+bool audio_engine_move_effect(AudioEngine* engine, int track_index, int from_index, int to_index) {
+    Track* track = find_track(engine, track_index);
+    return track && thaw_track(engine, track_index) &&
+           chain_move_effect(engine, &track->chain, from_index, to_index);
+}
+
+// Chain of a valid track, or NULL
+static const EffectChain* track_chain(AudioEngine* engine, int track_index) {
+    if (track_index < 0 || track_index >= engine->track_count) {
+        return NULL;
+    }
+    return &track_store_track(&engine->tracks, track_index)->chain;
+}
+
+bool audio_engine_toggle_effect(AudioEngine* engine, int track_index, int effect_index) {
+    const EffectChain* chain = track_chain(engine, track_index);
+    if (!chain || effect_index < 0 || effect_index >= chain->count) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid effect index: %d", effect_index);
+        return false;
+    }
+    if (!thaw_track(engine, track_index)) {
+        return false;
+    }
+
+    EngineCommand cmd = {
+        .type = CMD_TOGGLE_EFFECT,
+        .track_index = track_index,
+        .effect_slot = chain->order[effect_index],
+    };
+    if (!audio_engine_send_command(engine, &cmd)) {
+        return false;
+    }
+    engine_log(ENGINE_LOG_DEBUG, "[miniaudio] Toggled effect %d on track '%s'", effect_index,
+               track_store_info(&engine->tracks, track_index)->name);
+    return true;
+}
+
+bool audio_engine_set_effect_param(AudioEngine* engine, int track_index, int effect_index,
+                                   int param_index, float value) {
+    const EffectChain* chain = track_chain(engine, track_index);
+    if (!chain || effect_index < 0 || effect_index >= chain->count || !thaw_track(engine, track_index)) {
+        return false;
+    }
+
+    EngineCommand cmd = {
+        .type = CMD_SET_EFFECT_PARAM,
+        .track_index = track_index,
+        .effect_slot = chain->order[effect_index],
+        .param_index = param_index,
+        .value = value,
+    };
+    return audio_engine_send_command(engine, &cmd);
+}
+
+bool audio_engine_add_bus_effect(AudioEngine* engine, int bus_index, EffectType type) {
+    return audio_engine_add_bus_oversampled_effect(engine, bus_index, type, 1);
+}
+
+bool audio_engine_add_bus_oversampled_effect(AudioEngine* engine, int bus_index, EffectType type,
+                                             uint32_t oversampling) {
+    Bus* bus = find_bus(engine, bus_index);
+    EffectCreateInfo info = {.sample_rate = (float)engine->sample_rate, .dsp = engine->dsp,
+                             .oversampling = oversampling};
+    return bus && can_oversample(type, oversampling) && chain_add_effect(engine, &bus->chain, type, &info, bus->name);
+}
+
+// The bus and its reverb are published together, so the audio thread never
+// sees one without the other
+int audio_engine_add_reverb_bus(AudioEngine* engine, const char* name) {
+    int index = claim_bus_slot(engine, name);
+    if (index < 0) {
+        return -1;
+    }
+    EffectChain* chain = &engine->buses[index].chain;
+    EffectCreateInfo info = {.sample_rate = (float)engine->sample_rate, .dsp = engine->dsp, .oversampling = 1};
+    int slot = chain_claim_effect(engine, chain, EFFECT_REVERB, &info);
+    if (slot < 0) {
+        engine->bus_count--;
+        return -1;
+    }
+
+    // Wet only, full level: the sends and the bus fader set the amount.
+    // Set on the instance, which no graph references yet.
+    Effect* reverb = &chain->effects[slot];
+    effect_set_param(reverb, 2, 1.0F);
+    effect_set_param(reverb, 3, 1.0F);
+    if (!publish_graph(engine)) {
+        chain->count--;
+        chain->slot_used[slot] = false;
+        effect_instance_destroy(reverb, &engine->effect_states);
+        engine->bus_count--;
+        return -1;
+    }
+
+    engine_log(ENGINE_LOG_INFO, "[miniaudio] Added reverb bus %d: %s", index, name);
+    return index;
+}
+
+bool audio_engine_add_bus_convolution(AudioEngine* engine, int bus_index, const float* ir, uint32_t ir_frames,
+                                      uint32_t ir_channels) {
+    Bus* bus = find_bus(engine, bus_index);
+    EffectCreateInfo info = {
+        .sample_rate = (float)engine->sample_rate,
+        .dsp = engine->dsp,
+        .ir = ir,
+        .ir_frames = ir_frames,
+        .ir_channels = ir_channels,
+    };
+    return bus && chain_add_effect(engine, &bus->chain, EFFECT_CONVOLUTION, &info, bus->name);
+}
+
+bool audio_engine_add_bus_clap_effect(AudioEngine* engine, int bus_index, const char* path, const char* plugin_id) {
+    Bus* bus = find_bus(engine, bus_index);
+    EffectCreateInfo info = clap_create_info(engine, path, NULL, plugin_id);
+    return bus && path && chain_add_effect(engine, &bus->chain, EFFECT_CLAP, &info, bus->name);
+}
+
+bool audio_engine_remove_bus_effect(AudioEngine* engine, int bus_index, int effect_index) {
+    Bus* bus = find_bus(engine, bus_index);
+    return bus && chain_remove_effect(engine, &bus->chain, effect_index, bus->name);
+}
+
+bool audio_engine_move_bus_effect(AudioEngine* engine, int bus_index, int from_index, int to_index) {
+    Bus* bus = find_bus(engine, bus_index);
+    return bus && chain_move_effect(engine, &bus->chain, from_index, to_index);
+}
+
+bool audio_engine_toggle_bus_effect(AudioEngine* engine, int bus_index, int effect_index) {
+    if (bus_index < 0 || bus_index >= engine->bus_count ||
+        effect_index < 0 || effect_index >= engine->buses[bus_index].chain.count) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid effect index: %d", effect_index);
+        return false;
+    }
+
+    EngineCommand cmd = {
+        .type = CMD_TOGGLE_BUS_EFFECT,
+        .bus_index = bus_index,
+        .effect_slot = engine->buses[bus_index].chain.order[effect_index],
+    };
+    return audio_engine_send_command(engine, &cmd);
+}
+
+bool audio_engine_set_bus_effect_param(AudioEngine* engine, int bus_index, int effect_index,
+                                       int param_index, float value) {
+    if (bus_index < 0 || bus_index >= engine->bus_count ||
+        effect_index < 0 || effect_index >= engine->buses[bus_index].chain.count) {
+        return false;
+    }
+
+    EngineCommand cmd = {
+        .type = CMD_SET_BUS_EFFECT_PARAM,
+        .bus_index = bus_index,
+        .effect_slot = engine->buses[bus_index].chain.order[effect_index],
+        .param_index = param_index,
+        .value = value,
+    };
+    return audio_engine_send_command(engine, &cmd);
+}
+
+// ============================================================================
+// AUTOMATION
+// ============================================================================
+
+// Model slot holding the lane for a target, or NULL if it does not exist
+static AutomationLane** track_lane_slot(const Track* track, TrackInfo* info, AutomationTarget target,
+                                        int effect_index, int param_index) {
+    switch (target) {
+        case AUTOMATION_TRACK_VOLUME:
+            return &info->volume_lane;
+        case AUTOMATION_TRACK_PAN:
+            return &info->pan_lane;
+        case AUTOMATION_EFFECT_PARAM: {
+            if (effect_index < 0 || effect_index >= track->chain.count) return NULL;
+            int slot = track->chain.order[effect_index];
+            int param_count = effect_vtable(track->chain.effects[slot].type)->param_count;
+            if (param_index < 0 || param_index >= param_count || param_index >= ENGINE_MAX_AUTOMATED_PARAMS) {
+                return NULL;
+            }
+            return &info->effect_lanes[slot][param_index];
+        }
+        default:
+            return NULL;
+    }
+}
+
+bool audio_engine_set_track_automation(AudioEngine* engine, int track_index, AutomationTarget target,
+                                       int effect_index, int param_index, const AutomationPoint* points,
+                                       uint32_t count) {
+    Track* track = find_track(engine, track_index);
+    if (!track) {
+        return false;
+    }
+    AutomationLane** lane_slot =
+        track_lane_slot(track, track_store_info(&engine->tracks, track_index), target, effect_index, param_index);
+    if (!lane_slot) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid automation target %d (effect %d, param %d)", target,
+                   effect_index, param_index);
+        return false;
+    }
+    if (!thaw_track(engine, track_index)) {
+        return false;
+    }
+    if (*lane_slot) {
+        audio_engine_collect_garbage(engine);
+        if (engine->retired_lane_count >= ENGINE_MAX_RETIRED_LANES) {
+            engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot replace automation: old lanes still in use by audio thread");
+            return false;
+        }
+    }
+
+    AutomationLane* lane = NULL;
+    if (count > 0) {
+        lane = automation_lane_create(points, count);
+        if (!lane) {
+            engine_log(ENGINE_LOG_ERROR, "[miniaudio] Failed to allocate automation lane (%u points)", count);
+            return false;
+        }
+    }
+
+    AutomationLane* previous = *lane_slot;
+    *lane_slot = lane;
+    if (!publish_graph(engine)) {
+        *lane_slot = previous;
+        automation_lane_destroy(lane);
+        return false;
+    }
+    if (previous) {
+        retire_lane(engine, previous);
+    }
+    return true;
+}
+
+bool audio_engine_set_transport_position(AudioEngine* engine, uint64_t frame) {
+    EngineCommand cmd = {.type = CMD_SET_TRANSPORT_POSITION, .frame = frame};
+    return audio_engine_send_command(engine, &cmd);
+}
+
+uint64_t audio_engine_get_transport_position(AudioEngine* engine) {
+    return atomic_load_explicit(&engine->transport_position, memory_order_relaxed);
+}
+
+// ============================================================================
+// ANALYZER TAP
+// ============================================================================
+
+bool audio_engine_set_analyzer_source(AudioEngine* engine, int source) {
+    if (source < ANALYZER_SOURCE_NONE || source >= engine->track_count) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Invalid analyzer source %d", source);
+        return false;
+    }
+    atomic_store_explicit(&engine->analyzer_tap.source, source, memory_order_relaxed);
+    return true;
+}
+
+AnalyzerTap* audio_engine_get_analyzer_tap(AudioEngine* engine) {
+    return &engine->analyzer_tap;
+}
+
+// ============================================================================
+// SESSIONS
+// ============================================================================
+
+_Static_assert(ENGINE_MAX_AUTOMATED_PARAMS <= EFFECT_MAX_PARAMS, "session effects hold every automated param");
+
+static uint32_t lane_point_count(const AutomationLane* lane) {
+    return lane ? lane->count : 0;
+}
+
+// Append a lane's breakpoints to the image's point array
+static SessionLane capture_lane(const SessionImage* image, uint32_t* next_point, const AutomationLane* lane) {
+    SessionLane record = {*next_point, lane_point_count(lane)};
+    SessionPoint* points = session_points(image) + *next_point;
+    for (uint32_t i = 0; i < record.point_count; i++) {
+        points[i].frame = lane->points[i].frame;
+        points[i].value = lane->points[i].value;
+    }
+    *next_point += record.point_count;
+    return record;
+}
+
+// Bytes a chain's plugin paths and ids take in the strings
+static uint32_t chain_string_bytes(const EffectChain* chain) {
+    uint32_t bytes = 0;
+    for (int e = 0; e < chain->count; e++) {
+        const char* path;
+        const char* plugin_id;
+        if (effect_plugin_source(&chain->effects[chain->order[e]], &path, &plugin_id)) {
+            bytes += (path ? (uint32_t)strlen(path) + 1 : 0) + (plugin_id ? (uint32_t)strlen(plugin_id) + 1 : 0);
+        }
+    }
+    return bytes;
+}
+
+// Append a string (or nothing for NULL) to the image's strings
+static uint32_t capture_string(const SessionImage* image, uint32_t* next_string, const char* text) {
+    if (!text) {
+        return SESSION_NO_STRING;
+    }
+    uint32_t offset = *next_string;
+    size_t bytes = strlen(text) + 1;
+    memcpy(session_strings(image) + offset, text, bytes);
+    *next_string += (uint32_t)bytes;
+    return offset;
+}
+
+static void capture_chain(const SessionImage* image, uint32_t* next_string, const EffectChain* chain,
+                          SessionEffect* effects, uint32_t* effect_count) {
+    for (int e = 0; e < chain->count; e++) {
+        const Effect* effect = &chain->effects[chain->order[e]];
+        effects[e].type = (uint32_t)effect->type;
+        effects[e].enabled = effect->enabled;
+        effects[e].oversampling = effect->oversampling;
+        for (int p = 0; p < EFFECT_MAX_PARAMS; p++) {
+            effects[e].params[p] = effect_get_param(effect, p);
+        }
+        const char* path = NULL;
+        const char* plugin_id = NULL;
+        effect_plugin_source(effect, &path, &plugin_id);
+        effects[e].plugin_path = capture_string(image, next_string, path);
+        effects[e].plugin_id = capture_string(image, next_string, plugin_id);
+    }
+    *effect_count = (uint32_t)chain->count;
+}
+
+bool audio_engine_capture_session(AudioEngine* engine, SessionImage* image) {
+    // Size the image first: every lane's points, every clip path and every
+    // plugin path and id
+    uint32_t point_count = 0;
+    uint32_t string_bytes = 0;
+    for (int t = 0; t < engine->track_count; t++) {
+        const Track* track = track_store_track(&engine->tracks, t);
+        const TrackInfo* info = track_store_info(&engine->tracks, t);
+        point_count += lane_point_count(info->volume_lane) + lane_point_count(info->pan_lane);
+        for (int e = 0; e < track->chain.count; e++) {
+            for (int p = 0; p < ENGINE_MAX_AUTOMATED_PARAMS; p++) {
+                point_count += lane_point_count(info->effect_lanes[track->chain.order[e]][p]);
+            }
+        }
+        if (info->clip) {
+            string_bytes += (uint32_t)strlen(info->clip_path) + 1;
+        }
+        string_bytes += chain_string_bytes(&track->chain);
+    }
+    for (int b = 0; b < engine->bus_count; b++) {
+        string_bytes += chain_string_bytes(&engine->buses[b].chain);
+    }
+    if (!session_image_init(image, (uint32_t)engine->track_count, (uint32_t)engine->bus_count, point_count,
+                            string_bytes)) {
+        return false;
+    }
+
+    SessionHeader* header = session_header(image);
+    header->sample_rate = engine->sample_rate;
+    header->master_volume = engine->master_volume;
+
+    uint32_t next_point = 0;
+    uint32_t next_string = 0;
+    SessionTrack* tracks = session_tracks(image);
+    for (int t = 0; t < engine->track_count; t++) {
+        const TrackChunk* chunk = track_store_chunk(&engine->tracks, t);
+        int lane = track_lane(t);
+        const Track* track = &chunk->tracks[lane];
+        const TrackInfo* info = &chunk->info[lane];
+        SessionTrack* record = &tracks[t];
+
+        memcpy(record->name, info->name, sizeof(record->name));
+        record->name[sizeof(record->name) - 1] = '\0';
+        record->flags = (track->instrument ? SESSION_TRACK_INSTRUMENT : 0) |
+                        (atomic_load(&chunk->mix.playing[lane]) ? SESSION_TRACK_PLAYING : 0) |
+                        (atomic_load(&chunk->mix.mute[lane]) ? SESSION_TRACK_MUTE : 0) |
+                        (atomic_load(&chunk->mix.solo[lane]) ? SESSION_TRACK_SOLO : 0) |
+                        (atomic_load(&chunk->mix.armed[lane]) ? SESSION_TRACK_ARMED : 0) |
+                        (atomic_load(&chunk->mix.input[lane]) ? SESSION_TRACK_INPUT : 0) |
+                        (info->clip && info->clip->loop ? SESSION_TRACK_CLIP_LOOP : 0);
+        record->waveform = (uint32_t)(track->instrument ? track->voices.waveform : OSC_SINE);
+        record->frequency = info->frequency;
+        record->volume = chunk->mix.volume[lane];
+        record->pan = chunk->mix.pan[lane];
+        record->output_bus = info->output_bus;
+        for (int b = 0; b < engine->bus_count; b++) {
+            record->send_levels[b] = info->send_enabled[b] ? track->send_level[b] : 0.0F;
+        }
+
+        record->clip_path = capture_string(image, &next_string, info->clip ? info->clip_path : NULL);
+        capture_chain(image, &next_string, &track->chain, record->effects, &record->effect_count);
+        record->volume_lane = capture_lane(image, &next_point, info->volume_lane);
+        record->pan_lane = capture_lane(image, &next_point, info->pan_lane);
+        for (int e = 0; e < track->chain.count; e++) {
+            for (int p = 0; p < ENGINE_MAX_AUTOMATED_PARAMS; p++) {
+                record->effects[e].lanes[p] =
+                    capture_lane(image, &next_point, info->effect_lanes[track->chain.order[e]][p]);
+            }
+        }
+    }
+
+    SessionBus* buses = session_buses(image);
+    for (int b = 0; b < engine->bus_count; b++) {
+        const Bus* bus = &engine->buses[b];
+        memcpy(buses[b].name, bus->name, sizeof(buses[b].name));
+        buses[b].name[sizeof(buses[b].name) - 1] = '\0';
+        buses[b].mute = atomic_load(&bus->mute);
+        buses[b].volume = bus->volume;
+        buses[b].output_bus = bus->output_bus;
+        capture_chain(image, &next_string, &bus->chain, buses[b].effects, &buses[b].effect_count);
+    }
+    return true;
+}
+
+bool audio_engine_save_session(AudioEngine* engine, const char* path) {
+    SessionImage image;
+    if (!audio_engine_capture_session(engine, &image)) {
+        engine_log(ENGINE_LOG_ERROR, "[miniaudio] Cannot save session: out of memory");
+        return false;
+    }
+    bool written = session_image_write(&image, path);
+    session_image_free(&image);
+    if (!written) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Failed to write session: %s", path);
+        return false;
+    }
+    engine_log(ENGINE_LOG_INFO, "[miniaudio] Saved session '%s' (%d tracks, %d buses)", path, engine->track_count,
+               engine->bus_count);
+    return true;
+}
+
+static bool session_chain_valid(const SessionEffect* effects, uint32_t effect_count) {
+    for (uint32_t e = 0; e < effect_count; e++) {
+        if (effects[e].type == EFFECT_NONE || effects[e].type >= EFFECT_TYPE_COUNT ||
+            (effects[e].oversampling > 1 && (!oversampler_factor_valid(effects[e].oversampling) ||
+                                              effect_vtable((EffectType)effects[e].type)->latency))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// What session_image_read leaves to the engine: counts, indices, types and
+// bus routes that would form a cycle
+static bool session_valid(const SessionImage* image) {
+    const SessionHeader* header = session_header(image);
+    if (header->track_count > MAX_TRACKS || header->bus_count > MAX_BUSES) {
+        return false;
+    }
+    int bus_count = (int)header->bus_count;
+    const SessionBus* buses = session_buses(image);
+    for (int b = 0; b < bus_count; b++) {
+        if (!session_chain_valid(buses[b].effects, buses[b].effect_count)) {
+            return false;
+        }
+        int current = buses[b].output_bus;
+        for (int hops = 0; current != BUS_MASTER; hops++) {
+            if (current < 0 || current >= bus_count || current == b || hops > bus_count) {
+                return false;
+            }
+            current = buses[current].output_bus;
+        }
+    }
+    const SessionTrack* tracks = session_tracks(image);
+    for (uint32_t t = 0; t < header->track_count; t++) {
+        int output = tracks[t].output_bus;
+        if ((output != BUS_MASTER && (output < 0 || output >= bus_count)) || tracks[t].waveform >= OSC_WAVEFORM_COUNT ||
+            !session_chain_valid(tracks[t].effects, tracks[t].effect_count)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Rebuild a chain in slots no graph references yet. Lanes are left to the
+// caller (tracks only).
+static bool restore_chain(AudioEngine* engine, const SessionImage* image, EffectChain* chain,
+                          const SessionEffect* effects, uint32_t effect_count, const char* owner) {
+    EffectCreateInfo info = {.sample_rate = (float)engine->sample_rate, .dsp = engine->dsp,
+                             .max_frames = ENGINE_MAX_BLOCK_FRAMES, .keep_missing_plugin = true};
+    for (uint32_t e = 0; e < effect_count; e++) {
+        if (effects[e].type == EFFECT_CONVOLUTION) {
+            engine_log(ENGINE_LOG_WARNING, "[miniaudio] '%s': convolution loaded with a unit impulse", owner);
+        }
+        info.oversampling = effects[e].oversampling;
+        info.plugin_path = session_string(image, effects[e].plugin_path);
+        info.plugin_id = session_string(image, effects[e].plugin_id);
+        int slot = chain_claim_effect(engine, chain, (EffectType)effects[e].type, &info);
+        if (slot < 0) {
+            return false;
+        }
+        Effect* effect = &chain->effects[slot];
+        if (effect->type == EFFECT_CLAP && !effect_plugin(effect)) {
+            engine_log(ENGINE_LOG_WARNING, "[miniaudio] '%s': CLAP plugin %s kept as a pass-through", owner,
+                       info.plugin_path ? info.plugin_path : "(linked)");
+        }
+        effect->enabled = effects[e].enabled != 0;
+        for (int p = 0; p < effect_vtable(effect->type)->param_count; p++) {
+            effect_set_param(effect, p, effects[e].params[p]);
+        }
+    }
+    return true;
+}
+
+// Lane for a run of the image's points (NULL for an empty run). False only
+// if a lane could not be allocated.
+static bool restore_lane(const SessionImage* image, SessionLane record, AutomationLane** lane) {
+    *lane = NULL;
+    if (record.point_count == 0) {
+        return true;
+    }
+    *lane = automation_lane_create(session_points(image) + record.first_point, record.point_count);
+    return *lane != NULL;
+}
+
+static bool restore_track(AudioEngine* engine, const SessionImage* image, const SessionTrack* record) {
+    char name[sizeof(record->name)];
+    memcpy(name, record->name, sizeof(name));
+    name[sizeof(name) - 1] = '\0';
+    bool instrument = (record->flags & SESSION_TRACK_INSTRUMENT) != 0;
+    OscWaveform waveform = instrument ? (OscWaveform)record->waveform : OSC_SINE;
+    int index = claim_track_slot(engine, name, record->frequency, instrument, waveform);
+    if (index < 0) {
+        return false;
+    }
+
+    // Not published yet, so everything the audio thread owns once it is can
+    // still be written here
+    TrackChunk* chunk = track_store_chunk(&engine->tracks, index);
+    int lane = track_lane(index);
+    Track* track = &chunk->tracks[lane];
+    TrackInfo* info = &chunk->info[lane];
+    chunk->mix.volume[lane] = record->volume;
+    chunk->mix.pan[lane] = record->pan;
+    atomic_store(&chunk->mix.playing[lane], (record->flags & SESSION_TRACK_PLAYING) != 0);
+    atomic_store(&chunk->mix.mute[lane], (record->flags & SESSION_TRACK_MUTE) != 0);
+    atomic_store(&chunk->mix.solo[lane], (record->flags & SESSION_TRACK_SOLO) != 0);
+    atomic_store(&chunk->mix.armed[lane], (record->flags & SESSION_TRACK_ARMED) != 0);
+    atomic_store(&chunk->mix.input[lane], (record->flags & SESSION_TRACK_INPUT) != 0);
+    info->output_bus = record->output_bus;
+    for (int b = 0; b < engine->bus_count; b++) {
+        if (record->send_levels[b] > 0.0F) {
+            track->send_level[b] = record->send_levels[b];
+            info->send_enabled[b] = true;
+        }
+    }
+
+    if (!restore_chain(engine, image, &track->chain, record->effects, record->effect_count, name) ||
+        !restore_lane(image, record->volume_lane, &info->volume_lane) ||
+        !restore_lane(image, record->pan_lane, &info->pan_lane)) {
+        return false;
+    }
+    for (int e = 0; e < track->chain.count; e++) {
+        for (int p = 0; p < ENGINE_MAX_AUTOMATED_PARAMS; p++) {
+            if (!restore_lane(image, record->effects[e].lanes[p], &info->effect_lanes[track->chain.order[e]][p])) {
+                return false;
+            }
+        }
+    }
+
+    const char* clip_path = session_string(image, record->clip_path);
+    if (clip_path) {
+        bool loop = (record->flags & SESSION_TRACK_CLIP_LOOP) != 0;
+        info->clip = engine->streamer.started ? open_clip(engine, clip_path, loop) : NULL;
+        if (info->clip) {
+            snprintf(info->clip_path, sizeof(info->clip_path), "%s", clip_path);
+        } else {
+            engine_log(ENGINE_LOG_WARNING, "[miniaudio] Track '%s' loaded without its clip: %s", name, clip_path);
+        }
+    }
+    return true;
+}
+
+static bool restore_session(AudioEngine* engine, const SessionImage* image) {
+    const SessionHeader* header = session_header(image);
+    const SessionBus* buses = session_buses(image);
+    for (uint32_t b = 0; b < header->bus_count; b++) {
+        char name[sizeof(buses[b].name)];
+        memcpy(name, buses[b].name, sizeof(name));
+        name[sizeof(name) - 1] = '\0';
+        int index = claim_bus_slot(engine, name);
+        if (index < 0) {
+            return false;
+        }
+        Bus* bus = &engine->buses[index];
+        bus->volume = buses[b].volume;
+        atomic_store(&bus->mute, buses[b].mute != 0);
+        bus->output_bus = buses[b].output_bus;
+        if (!restore_chain(engine, image, &bus->chain, buses[b].effects, buses[b].effect_count, name)) {
+            return false;
+        }
+    }
+
+    const SessionTrack* tracks = session_tracks(image);
+    for (uint32_t t = 0; t < header->track_count; t++) {
+        if (!restore_track(engine, image, &tracks[t])) {
+            return false;
+        }
+    }
+    return audio_engine_set_master_volume(engine, header->master_volume);
+}
+
+bool audio_engine_load_session(AudioEngine* engine, const char* path) {
+    if (engine->track_count > 0 || engine->bus_count > 0) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Cannot load session into an engine that has tracks or buses");
+        return false;
+    }
+    SessionImage image;
+    if (!session_image_read(&image, path) || !session_valid(&image)) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Not a valid session file: %s", path);
+        session_image_free(&image);
+        return false;
+    }
+    if (session_header(&image)->sample_rate != engine->sample_rate) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Session '%s' was saved at %u Hz; automation keeps its frames",
+                   path, session_header(&image)->sample_rate);
+    }
+
+    // Everything goes into slots no graph references yet; one graph then
+    // publishes the whole session, however many tracks it has
+    bool restored = restore_session(engine, &image);
+    session_image_free(&image);
+    bool published = publish_graph(engine);
+    if (!restored || !published) {
+        engine_log(ENGINE_LOG_WARNING, "[miniaudio] Session '%s' only partly loaded", path);
+        return false;
+    }
+    engine_log(ENGINE_LOG_INFO, "[miniaudio] Loaded session '%s' (%d tracks, %d buses)", path, engine->track_count,
+               engine->bus_count);
+    return true;
+}
@@ -3,103 +3,448 @@
 #define AUDIO_ENGINE_H
 
 #include "vendor/miniaudio/miniaudio.h"
+#include "analyzer.h"
+#include "automation.h"
+#include "bus.h"
+#include "clip_recorder.h"
+#include "clip_stream.h"
+#include "convolver.h"
+#include "dsp_kernels.h"
+#include "effects.h"
+#include "engine_arena.h"
+#include "oscillator.h"
+#include "meters.h"
+#include "midi_input.h"
+#include "pdc.h"
+#include "resampler.h"
+#include "session.h"
+#include "spsc_ring.h"
+#include "voice_pool.h"
+#include "worker_pool.h"
 #include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 // ============================================================================
 // CONSTANTS
 // ============================================================================
 
-#define MAX_TRACKS 16
-#define SAMPLE_RATE 48000
+#define MAX_TRACKS 512                  // Track storage grows chunk by chunk up to this
+#define TRACK_CHUNK_TRACKS 32           // Tracks per storage chunk, power of two
+#define SAMPLE_RATE 48000               // Default engine rate (AudioEngineConfig::sample_rate)
 #define CHANNELS 2
-#define BUFFER_SIZE 512
-#define MAX_EFFECTS_PER_TRACK 8
+#define BUFFER_SIZE 512                 // Default device period (frames)
+#define ENGINE_TRACKING_PERIOD_FRAMES 64
+#define ENGINE_MIXDOWN_PERIOD_FRAMES 2048
+#define ENGINE_MAX_BLOCK_FRAMES 4096    // Upper bound for the internal sub-block
+#define ENGINE_COMMAND_QUEUE_SIZE 1024  // Must be a power of two
+#define ENGINE_RETIRE_QUEUE_SIZE 64     // Must be a power of two
+#define ENGINE_OFFLINE_CHUNK_FRAMES 4096 // Frames per sink write when rendering offline
+#define ENGINE_MAX_RETIRED_CLIPS 32     // Replaced clips awaiting reclamation
+#define ENGINE_CLIP_CACHE_FORMAT CLIP_CACHE_F32
+#define ENGINE_MAX_AUTOMATED_PARAMS 4   // Automatable parameters per effect
+#define ENGINE_MAX_RETIRED_LANES 64     // Replaced automation lanes awaiting reclamation
+#define ENGINE_DEADLINE_REPORT_MS 1000  // At most one overrun warning per second of audio
+#define ENGINE_DSP_LOAD_WINDOW_MS 500   // DSP load min/avg/max window
+#define ENGINE_MIDI_QUEUE_SIZE 1024     // Incoming MIDI events, power of two
+#define ENGINE_MIDI_MAX_EVENTS_PER_PERIOD 256 // Splits per period; the rest wait for the next one
+#define ENGINE_MIDI_RECORD_QUEUE_SIZE 4096 // Captured events awaiting the control thread, power of two
+#define ENGINE_MAX_RETIRED_TAKES 32     // Finished recordings awaiting reclamation
+#define AUDIO_BUFFER_ALIGNMENT 64       // Cache line; covers SSE/AVX/NEON loads
+#define ENGINE_SILENCE_LEVEL 1e-5f      // -100 dBFS; quieter blocks count as silence (idle bypass)
+#define ENGINE_FREEZE_DEFAULT_SECONDS 60 // Freeze length for sources without an end
+#define ENGINE_DEVICE_SRC_FRAMES 4096  // Engine frames rendered at once ahead of the device converter
 
 // ============================================================================
-// EFFECT TYPES
+// TRACK STRUCTURE
+// ============================================================================
+
+// A track's DSP state: what its render job reads and writes every block,
+// and nothing else. Its mix controls sit in TrackMixLanes and its metadata
+// in TrackInfo, in the same storage chunk (see TRACK STORAGE).
+typedef struct {
+    // Audio generation (wavetable oscillator bank, owned by the audio thread
+    // once published)
+    OscillatorBank oscillator;
+    // Instrument tracks play notes on their voice pool instead (fixed at
+    // creation; the pool is owned by the audio thread once published)
+    bool instrument;
+    VoicePool voices;
+    float output_gain[2];   // Smoothed volume * pan gains L/R (audio thread only)
+
+    float send_level[MAX_BUSES];        // Post-fader send gain per bus (audio thread once published)
+
+    EffectChain chain;
+
+    // Latency compensation per edge: the output and each send (by bus).
+    // Allocated on the control thread the first time an edge needs it,
+    // written by the audio thread.
+    PdcDelay output_delay;
+    PdcDelay send_delays[MAX_BUSES];
+
+    // Metering (published by audio thread once per block)
+    MeterChannel meter;
+} Track;
+
+// Everything about a track the audio thread does not read while rendering
+// (it only adds to the profiling counters): the control thread's model,
+// what render graphs snapshot from it, and what views display
+typedef struct {
+    char name[64];
+    float frequency;        // Base oscillator frequency (Hz)
+
+    // Streamed audio clip; replaces the oscillator when set. Snapshotted into
+    // the render graph, read (never freed) by the audio thread.
+    ClipStream* clip;
+    char clip_path[512];    // The file it was loaded from (what sessions save)
+    // Take recording the (pre-fader) input while armed and recording;
+    // snapshotted into the render graph like the clip
+    ClipRecording* recording;
+    // Freeze: the source, fader and chain rendered ahead into a clip, played
+    // in their place until an edit would change them (see
+    // audio_engine_freeze_track). Snapshotted like the clip.
+    ClipStream* frozen;
+    uint64_t freeze_clip_frame;         // Clip playhead the frozen audio starts at
+
+    // Routing (snapshotted into the render graph)
+    int output_bus;                     // BUS_MASTER or a bus index
+    bool send_enabled[MAX_BUSES];
+
+    // Automation lanes (snapshotted into the render graph). While a lane is
+    // set it overrides the parameter's plain value.
+    AutomationLane* volume_lane;
+    AutomationLane* pan_lane;
+    AutomationLane* effect_lanes[MAX_EFFECTS_PER_TRACK][ENGINE_MAX_AUTOMATED_PARAMS];   // By effect slot
+
+    // Render time while profiling is on, cumulative (written by whichever
+    // thread rendered the track; read with audio_engine_get_track_profile)
+    atomic_uint_fast64_t profile_ns;
+    atomic_uint_fast64_t effect_profile_ns[MAX_EFFECTS_PER_TRACK];     // By effect slot
+} TrackInfo;
+
+// ============================================================================
+// ENGINE COMMANDS (UI/control thread -> audio thread)
 // ============================================================================
 
 typedef enum {
-    EFFECT_NONE = 0,
-    EFFECT_GAIN,
-    EFFECT_LOWPASS,
-    EFFECT_HIGHPASS,
-    EFFECT_DELAY,
-    EFFECT_REVERB
-} EffectType;
+    CMD_NONE = 0,
+    CMD_SET_PLAYING,        // flag: master transport
+    CMD_SET_MASTER_VOLUME,  // value
+    CMD_SET_TRACK_VOLUME,   // track_index, value
+    CMD_SET_TRACK_PAN,      // track_index, value
+    CMD_SET_TRACK_MUTE,     // track_index, flag
+    CMD_SET_TRACK_SOLO,     // track_index, flag
+    CMD_SET_TRACK_PLAYING,  // track_index, flag
+    CMD_SET_TRACK_SEND,     // track_index, bus_index, value
+    CMD_TOGGLE_EFFECT,      // track_index, effect_slot
+    CMD_SET_EFFECT_PARAM,   // track_index, effect_slot, param_index, value
+    CMD_SET_BUS_VOLUME,     // bus_index, value
+    CMD_SET_BUS_MUTE,       // bus_index, flag
+    CMD_TOGGLE_BUS_EFFECT,  // bus_index, effect_slot
+    CMD_SET_BUS_EFFECT_PARAM, // bus_index, effect_slot, param_index, value
+    CMD_SET_TRANSPORT_POSITION, // frame
+    CMD_NOTE_ON,            // track_index, note, value (velocity)
+    CMD_NOTE_OFF,           // track_index, note
+    CMD_ALL_NOTES_OFF,      // track_index
+    CMD_SET_TRACK_ARMED,    // track_index, flag
+    CMD_SET_TRACK_INPUT     // track_index, flag
+} EngineCommandType;
 
+// Structural edits (adding tracks/buses, routing, adding/removing/reordering
+// effects) are not commands: they publish a new RenderGraph snapshot instead.
 typedef struct {
-    EffectType type;
-    bool enabled;
+    EngineCommandType type;
+    int track_index;
+    int bus_index;
+    int effect_slot;
+    int param_index;
+    int note;
 
     union {
-        struct {
-            float gain;
-        } gain_params;
-
-        struct {
-            float cutoff;
-            float resonance;
-        } filter_params;
-
-        struct {
-            float time_ms;
-            float feedback;
-            float mix;
-        } delay_params;
-
-        struct {
-            float room_size;
-            float damping;
-            float mix;
-        } reverb_params;
+        float value;
+        bool flag;
+        uint64_t frame;
     };
-} Effect;
+} EngineCommand;
+
+// Immutable snapshot of tracks, buses and routing (see render_graph.h)
+typedef struct RenderGraph RenderGraph;
+
+// Planar stereo block: the engine's internal format for tracks, buses and
+// master. Both channel planes hold block_frames samples, are carved from
+// the engine arena and aligned for the SIMD kernels; audio is interleaved
+// exactly once, when master is stored into the device buffer. One per track
+// (indexed by graph position), one per bus plus master (indexed by bus slot).
+typedef struct {
+    _Alignas(AUDIO_BUFFER_ALIGNMENT) float* left;   // Aligned so buffers never share a cache line
+    float* right;
+    bool active;            // False if the track/bus was skipped this sub-block
+    MeterAccumulator meter; // Statistics over the current callback
+} StereoBuffer;
+
+// A live MIDI event as an armed track received it, captured while the
+// transport was running (audio thread -> control thread)
+typedef struct {
+    uint64_t frame;         // Transport frame the event played at
+    int track_index;
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+} RecordedMidiEvent;
 
 // ============================================================================
-// TRACK STRUCTURE
+// ENGINE CONFIGURATION
 // ============================================================================
 
+typedef enum {
+    ENGINE_LATENCY_DEFAULT = 0,     // BUFFER_SIZE period
+    ENGINE_LATENCY_TRACKING,        // 64-frame periods for recording/monitoring
+    ENGINE_LATENCY_MIXDOWN          // 2048-frame periods, lowest CPU overhead
+} EngineLatencyMode;
+
+typedef enum {
+    ENGINE_BACKEND_CALLBACK = 0,    // Flat render schedule in the device callback, tracks on the worker pool
+    ENGINE_BACKEND_NODE_GRAPH       // Tracks, buses and master as custom ma_nodes pulled by ma_node_graph
+} EngineBackend;
+
 typedef struct {
-    char name[64];
+    uint32_t period_frames;     // Device period requested from miniaudio
+    uint32_t block_frames;      // Internal processing sub-block (0 = period size)
+    int render_workers;         // Worker threads (-1 = one per spare core)
+    EngineLatencyMode mode;
+    bool offline_only;          // No playback device; render with audio_engine_render_offline()
+    EngineBackend backend;
+    bool capture;               // Open the device duplex for audio input (playback only if that fails)
+    uint32_t sample_rate;       // Internal rate, 0 = SAMPLE_RATE; everything runs at it
+    ResamplerQuality device_quality;    // Converter to a playback device at another rate
+} AudioEngineConfig;
 
-    // Mix controls
-    float volume;           // 0.0 to 1.0
-    float pan;              // -1.0 (left) to 1.0 (right)
+// Receives interleaved stereo float frames from an offline render. Return
+// false to abort the render.
+typedef struct {
+    bool (*write)(void* user_data, const float* frames, uint32_t frame_count);
+    void* user_data;
+} EngineRenderSink;
+
+// What a view displays about one track, copied in one go so the view never
+// walks the Track the audio thread mutates
+typedef struct {
+    char name[64];
+    float volume;
+    float pan;
+    bool playing;
     bool mute;
     bool solo;
     bool armed;
+    bool input;
+    bool recording;
+    bool instrument;
+    bool frozen;
+    const ClipCache* clip_cache;    // NULL unless the clip has a peak cache
+} TrackSnapshot;
 
-    // Audio generation (simple oscillator for now)
-    float frequency;        // Oscillator frequency (Hz)
-    float phase;            // Oscillator phase
-    atomic_bool playing;
+typedef struct {
+    uint64_t model_version;         // audio_engine_get_model_version() before the copy
+    int track_count;
+    bool playing;
+    bool recording;
+    float master_volume;
+    uint32_t latency_frames;        // Effect latency at master after compensation
+    uint32_t sample_rate;           // Engine rate
+    TrackSnapshot tracks[MAX_TRACKS];
+} EngineSnapshot;
 
-    // Effects chain
-    Effect effects[MAX_EFFECTS_PER_TRACK];
-    int effect_count;
+// ============================================================================
+// NODE GRAPH BACKEND
+// ============================================================================
 
-    // Metering (updated by audio thread)
-    float peak_level[2];    // Peak levels for L/R channels
-    float rms_level[2];     // RMS levels for L/R channels
-} Track;
+// In ENGINE_BACKEND_NODE_GRAPH mode every track slot, bus slot and master is
+// a custom ma_node. Track nodes have one output for the main mix plus one
+// per bus for post-fader sends; bus and master nodes sum their input bus.
+// The audio thread re-attaches nodes whenever it adopts a new render graph,
+// so the wiring always matches the snapshot being rendered. Nodes are
+// pulled serially by miniaudio; the worker pool is not used for tracks.
+typedef struct {
+    ma_node_base base;          // Must be first
+    struct AudioEngine* engine;
+    int slot;                   // Track or bus slot
+    int graph_index;            // Position in the wired render graph, -1 if absent
+} EngineNode;
+
+typedef struct {
+    ma_node_graph graph;
+    EngineNode buses[MAX_BUSES];            // Track nodes live in the track storage chunks
+    EngineNode master;
+    uint64_t wired_generation;  // Render graph the attachments reflect (audio thread)
+    int wired_track_count;      // Track nodes attached for it (audio thread)
+    bool any_solo;              // Solo state of the block being pulled (audio thread)
+    const float* input;         // Device input for the frames being pulled, or NULL (audio thread)
+    uint64_t input_frame;       // Transport frame of input[0]
+    uint32_t input_frames;
+} EngineNodeGraph;
 
 // ============================================================================
-// AUDIO ENGINE STRUCTURE
+// TRACK STORAGE
 // ============================================================================
 
+#define TRACK_MAX_CHUNKS (MAX_TRACKS / TRACK_CHUNK_TRACKS)
+
+// Mix controls of a chunk's tracks, one array per field: the per-block
+// checks every track goes through (mute, solo, playing, input, volume and
+// pan) read a few cache lines per chunk instead of one per track. Set by
+// commands on the audio thread.
+typedef struct {
+    float volume[TRACK_CHUNK_TRACKS];           // 0.0 to 1.0
+    float pan[TRACK_CHUNK_TRACKS];              // -1.0 (left) to 1.0 (right)
+    atomic_bool mute[TRACK_CHUNK_TRACKS];
+    atomic_bool solo[TRACK_CHUNK_TRACKS];
+    atomic_bool playing[TRACK_CHUNK_TRACKS];
+    atomic_bool input[TRACK_CHUNK_TRACKS];      // Source is the device input, monitored through the chain
+    atomic_bool armed[TRACK_CHUNK_TRACKS];      // Plays live MIDI input and records, captured while the transport runs
+} TrackMixLanes;
+
+// TRACK_CHUNK_TRACKS consecutive track slots. Chunks are allocated on the
+// control thread as tracks are added and never move or go away before
+// shutdown, so render graphs and the audio thread keep pointers into them
+// while the session grows. Hot data comes first; TrackInfo, which only the
+// control thread and views read, is kept out of the way at the end.
+typedef struct {
+    TrackMixLanes mix;
+    Track tracks[TRACK_CHUNK_TRACKS];
+    StereoBuffer buffers[TRACK_CHUNK_TRACKS];   // Block planes, carved from `arena`
+    EngineNode nodes[TRACK_CHUNK_TRACKS];       // ENGINE_BACKEND_NODE_GRAPH only
+    EngineArena arena;
+    TrackInfo info[TRACK_CHUNK_TRACKS];
+} TrackChunk;
+
 typedef struct {
+    TrackChunk* chunks[TRACK_MAX_CHUNKS];       // The first chunk_count are allocated
+    int chunk_count;                            // Control thread only
+} TrackStore;
+
+// Slot of a track within its chunk
+static inline int track_lane(int track_index) {
+    return track_index & (TRACK_CHUNK_TRACKS - 1);
+}
+
+static inline TrackChunk* track_store_chunk(const TrackStore* store, int track_index) {
+    return store->chunks[track_index / TRACK_CHUNK_TRACKS];
+}
+
+static inline Track* track_store_track(const TrackStore* store, int track_index) {
+    return &track_store_chunk(store, track_index)->tracks[track_lane(track_index)];
+}
+
+static inline TrackInfo* track_store_info(const TrackStore* store, int track_index) {
+    return &track_store_chunk(store, track_index)->info[track_lane(track_index)];
+}
+
+static inline TrackMixLanes* track_store_mix(const TrackStore* store, int track_index) {
+    return &track_store_chunk(store, track_index)->mix;
+}
+
+// ============================================================================
+// AUDIO ENGINE STRUCTURE
+// ============================================================================
+
+typedef struct AudioEngine {
     ma_device device;
     ma_device_config device_config;
     ma_log log;
 
-    Track tracks[MAX_TRACKS];
-    int track_count;
+    // Playback devices that run at another rate are fed through our own
+    // converter: the callback renders the engine frames it needs into
+    // device_scratch and converts them (audio thread once started)
+    bool device_resampling;
+    Resampler device_resampler;
+    float* device_scratch;                  // ENGINE_DEVICE_SRC_FRAMES interleaved, own aligned block
+    uint32_t device_chunk_frames;           // Device frames converted per render
+
+    TrackStore tracks;          // Grows as tracks are added (see TRACK STORAGE)
+    int track_count;            // Slots handed out (control thread only)
+
+    Bus buses[MAX_BUSES];
+    int bus_count;              // Slots handed out (control thread only)
+
+    // Lock-free command queue, drained at the top of every audio callback
+    SpscRing command_queue;
+    EngineCommand command_storage[ENGINE_COMMAND_QUEUE_SIZE];
+
+    // Live MIDI input: timestamped events from one producer (the MIDI
+    // driver thread), applied at their frame within the next period
+    SpscRing midi_queue;
+    MidiEvent midi_storage[ENGINE_MIDI_QUEUE_SIZE];
+    uint64_t midi_block_ns;                 // When the current period started (audio thread)
+    SpscRing recorded_midi;                 // of RecordedMidiEvent, storage in the arena
+    atomic_uint midi_record_overflows;      // Captured events lost to a full ring
+
+    // Render graph snapshots
+    _Atomic(RenderGraph*) pending_graph;    // Published by control, taken by audio
+    RenderGraph* current_graph;             // Audio thread only
+    SpscRing retired_graphs;                // Audio -> control, for reclamation
+    RenderGraph* retired_storage[ENGINE_RETIRE_QUEUE_SIZE];
+    uint64_t graph_generation;              // Last generation built (control thread)
+    uint32_t graph_latency;                 // Its compensated latency at master (control thread)
+    uint64_t reclaimed_generation;          // Newest generation handed back (control thread)
+
+    // Parallel track rendering
+    WorkerPool workers;
+    const DspKernels* dsp;                  // SIMD kernels picked at init
+    AudioEngineConfig config;
+    uint32_t sample_rate;                   // Engine rate, fixed at init
+    uint32_t block_frames;                  // Effective sub-block length
+    EffectStatePool effect_states;          // Per-instance effect state (control thread)
+    EngineNodeGraph* nodes;                 // ENGINE_BACKEND_NODE_GRAPH only
+
+    // Clip streaming. Replaced clips stay open until the graph generation
+    // that last referenced them has been handed back.
+    ClipStreamer streamer;
+    ClipStream* retired_clips[ENGINE_MAX_RETIRED_CLIPS];
+    uint64_t retired_clip_after[ENGINE_MAX_RETIRED_CLIPS];
+    int retired_clip_count;
+    EngineArena arena;                      // Owns every scratch buffer below (track planes: TrackChunk)
+    StereoBuffer* bus_buffers;              // [MAX_BUSES + 1], last one is master
+
+    // Recording. Takes are written by the recorder's thread; finished ones
+    // stay allocated until the graph that last referenced them is handed back.
+    ClipRecorder recorder;
+    bool capture_open;                      // The device delivers input
+    bool recording;                         // Control thread only
+    int take_number;                        // Control thread only
+    int freeze_number;                      // Control thread only
+    ClipRecording* retired_takes[ENGINE_MAX_RETIRED_TAKES];
+    uint64_t retired_take_after[ENGINE_MAX_RETIRED_TAKES];
+    int retired_take_count;
+
+    // Spectrum analyzer tap: one output's raw blocks, copied into a ring
+    AnalyzerTap analyzer_tap;               // Storage lives in the arena
+    int analyzer_source;                    // Tap source for the current callback (audio thread only)
 
     float master_volume;
-    float master_peak[2];
-    float master_rms[2];
+    MeterChannel master_meter;      // Published by audio thread once per block
+    uint64_t frames_processed;      // Device frames since start (audio thread only)
+    uint64_t transport_frame;       // Timeline position automation is read at (audio thread only)
+    atomic_uint_fast64_t transport_position;    // transport_frame, published once per callback
+    atomic_uint_fast64_t commands_applied;      // Bumped by the audio thread after each command drain
+
+    // Replaced automation lanes, freed like retired clips
+    AutomationLane* retired_lanes[ENGINE_MAX_RETIRED_LANES];
+    uint64_t retired_lane_after[ENGINE_MAX_RETIRED_LANES];
+    int retired_lane_count;
+
+    // Callbacks that took longer than their period. Counted by the audio
+    // thread, reported through the asynchronous log at a bounded rate.
+    atomic_uint deadline_misses;
+    uint32_t deadline_misses_reported;  // Audio thread only
+    uint64_t deadline_report_frame;     // Audio thread only
+
+    // DSP load of every callback, published through a seqlock
+    DspLoadChannel dsp_load;
+    DspLoadRecord dsp_load_record;      // Audio thread only
+    DspLoadAccumulator dsp_load_window; // Audio thread only
+    atomic_uint device_glitches;        // Interruptions and reroutes reported by the device
+    atomic_bool profiling;              // Time tracks and effects in render_track_job
+    bool async_log;                     // This engine holds an async log reference
 
     atomic_bool playing;
     atomic_bool initialized;
@@ -109,26 +454,298 @@ typedef struct {
 // AUDIO ENGINE API
 // ============================================================================
 
-// Initialize the audio engine
+// Default configuration for a latency mode
+AudioEngineConfig audio_engine_config_init(EngineLatencyMode mode);
+
+// Initialize the audio engine with the default configuration
 bool audio_engine_init(AudioEngine* engine);
 
+// Initialize the audio engine with an explicit period/block configuration
+bool audio_engine_init_with_config(AudioEngine* engine, const AudioEngineConfig* config);
+
 // Shutdown the audio engine
 void audio_engine_shutdown(AudioEngine* engine);
 
+// Render frame_count frames of the current session as fast as possible
+// (tracks still render in parallel on the worker pool) and hand them to
+// sink. The device, if any, is paused for the duration; transport is forced
+// to playing. Convolution tails and clip streams wait for their helper
+// threads instead of dropping audio, so the result is deterministic.
+bool audio_engine_render_offline(AudioEngine* engine, uint64_t frame_count, const EngineRenderSink* sink);
+
+// Offline render into a WAV file through miniaudio's streaming encoder.
+// format is ma_format_f32, ma_format_s16, ma_format_s24 or ma_format_s32.
+bool audio_engine_render_to_wav(AudioEngine* engine, const char* path, uint64_t frame_count, ma_format format);
+
+// The same at another file rate: frame_count engine frames are converted
+// to `sample_rate` (0 = the engine rate) with `quality` as they are rendered
+bool audio_engine_export_wav(AudioEngine* engine, const char* path, uint64_t frame_count, ma_format format,
+                             uint32_t sample_rate, ResamplerQuality quality);
+
+// Render one period into out (interleaved stereo) on the caller's thread,
+// exactly as the device callback would: real-time paths, no waiting on
+// helper threads, transport left as is, DSP load published. Offline-only engines; for
+// benchmarks and hosts that run their own clock.
+bool audio_engine_process_block(AudioEngine* engine, float* out, uint32_t frame_count);
+
+// Same, with a period of device input (interleaved stereo, frame_count
+// frames) for input tracks, as a duplex device delivers it
+bool audio_engine_process_duplex_block(AudioEngine* engine, const float* input, float* out, uint32_t frame_count);
+
+// Changes whenever something a view of the session depends on may have
+// changed: a structural edit was published or the audio thread applied
+// parameter/transport commands. Meter levels do not count. Control thread.
+uint64_t audio_engine_get_model_version(AudioEngine* engine);
+
+// Copy the session state a view displays. Stale once the model version
+// moves past snapshot->model_version. Control thread.
+void audio_engine_snapshot(AudioEngine* engine, EngineSnapshot* snapshot);
+
+// Device callbacks that overran their period since init
+uint32_t audio_engine_get_deadline_misses(AudioEngine* engine);
+
+// Latest DSP load: the last callback's render time over its period, the
+// min/avg/max of the last ENGINE_DSP_LOAD_WINDOW_MS and the xrun
+// counters. Any thread. Returns false if the record could not be read
+// consistently (keep the previous one).
+bool audio_engine_read_dsp_load(AudioEngine* engine, DspLoadRecord* record);
+
+// Per-track and per-effect render timers. Off by default: they cost two
+// clock reads per track and effect per callback.
+void audio_engine_set_profiling(AudioEngine* engine, bool enabled);
+
+typedef struct {
+    uint64_t track_ns;                              // Whole track, effects included
+    uint64_t effect_ns[MAX_EFFECTS_PER_TRACK];      // By effect slot
+} TrackProfile;
+
+// Cumulative render time of a track while profiling was on; the caller
+// diffs two reads for a rate. Any thread.
+bool audio_engine_get_track_profile(AudioEngine* engine, int track_index, TrackProfile* profile);
+
+// Reclaim render graph snapshots the audio thread is done with
+// Call regularly from the control thread (e.g. once per UI frame)
+void audio_engine_collect_garbage(AudioEngine* engine);
+
+// All functions below are called from the UI/control thread. Parameter
+// changes are queued as EngineCommands and structural edits publish a new
+// render graph; either way the audio thread picks them up at the start of
+// its next callback. They return false if the edit could not be queued.
+
+// Queue a raw command for the audio thread
+bool audio_engine_send_command(AudioEngine* engine, const EngineCommand* command);
+
+// Start/stop master transport
+bool audio_engine_set_playing(AudioEngine* engine, bool playing);
+
+// Set master volume (0.0 to 1.0)
+bool audio_engine_set_master_volume(AudioEngine* engine, float volume);
+
 // Add a new track with given name and frequency
 // Returns track index or -1 on failure
 int audio_engine_add_track(AudioEngine* engine, const char* name, float frequency);
 
+// Add an instrument track: notes sent with audio_engine_note_on play on a
+// preallocated pool of VOICE_POOL_MAX_VOICES voices of the given waveform
+// (the oldest voice is stolen when all are sounding). Instrument tracks
+// start playing, so notes sound as soon as the transport runs.
+// Returns track index or -1 on failure
+int audio_engine_add_instrument_track(AudioEngine* engine, const char* name, OscWaveform waveform);
+
+// Start or release a note (MIDI number 0-127, velocity 0..1) on an
+// instrument track. Notes land at the start of the next callback.
+bool audio_engine_note_on(AudioEngine* engine, int track_index, int note, float velocity);
+bool audio_engine_note_off(AudioEngine* engine, int track_index, int note);
+bool audio_engine_all_notes_off(AudioEngine* engine, int track_index);
+
+// Queue a live MIDI event (stamped with engine_thread_time_ns() on
+// arrival) for the audio thread. Single producer: the MIDI input thread.
+// Armed tracks play it at its frame in the next period (one period of
+// latency, no block quantisation): notes on instrument tracks, CC 7
+// volume, CC 10 pan (ignored while the track is frozen) and CC 120/123
+// all notes off. Returns false if the queue is full.
+bool audio_engine_push_midi(AudioEngine* engine, const MidiEvent* event);
+
+// Arm a track for live MIDI input. Disarming releases its held notes.
+bool audio_engine_set_track_armed(AudioEngine* engine, int track_index, bool armed);
+
+// Take up to max events captured on armed tracks while the transport ran,
+// oldest first. Control thread (single consumer). Returns the count taken.
+uint32_t audio_engine_read_recorded_midi(AudioEngine* engine, RecordedMidiEvent* events, uint32_t max);
+
+// Per-track mix controls
+bool audio_engine_set_track_volume(AudioEngine* engine, int track_index, float volume);
+bool audio_engine_set_track_pan(AudioEngine* engine, int track_index, float pan);
+bool audio_engine_set_track_mute(AudioEngine* engine, int track_index, bool mute);
+bool audio_engine_set_track_solo(AudioEngine* engine, int track_index, bool solo);
+bool audio_engine_set_track_playing(AudioEngine* engine, int track_index, bool playing);
+
+// Post-fader send from a track to a bus (level 0 removes the send)
+bool audio_engine_set_track_send(AudioEngine* engine, int track_index, int bus_index, float level);
+
+// Route a track's main output to a bus (or BUS_MASTER)
+bool audio_engine_set_track_output(AudioEngine* engine, int track_index, int bus_index);
+
+// Stream an audio file on a track instead of its oscillator (any format
+// miniaudio decodes). The file is imported into a clip cache next to it on
+// first use. Pass NULL to go back to the oscillator.
+bool audio_engine_load_track_clip(AudioEngine* engine, int track_index, const char* path, bool loop);
+
+// Move the clip playhead; playback resumes once the streamer has refilled
+bool audio_engine_set_track_clip_position(AudioEngine* engine, int track_index, uint64_t frame);
+
+// Mapped cache of a track's clip (samples and peak pyramids for waveform
+// drawing), or NULL if the clip streams through a decoder
+const ClipCache* audio_engine_get_track_clip_cache(AudioEngine* engine, int track_index);
+
+// Playhead, buffer fill and underrun counters of a track's clip
+bool audio_engine_get_track_clip_stats(AudioEngine* engine, int track_index, ClipStreamStats* stats);
+
+// Make the device input a track's source (monitored through its volume,
+// pan and effects) instead of its oscillator or clip. Needs a duplex
+// device (AudioEngineConfig::capture) or audio_engine_process_duplex_block.
+bool audio_engine_set_track_input(AudioEngine* engine, int track_index, bool enabled);
+
+// Start a take on every armed input track, written to
+// "<directory>/trackNN_takeNNN" CLIP_CACHE_EXTENSION. The input is captured
+// pre-fader whenever the transport runs. False if no take could be opened.
+bool audio_engine_start_recording(AudioEngine* engine, const char* directory);
+
+// End the takes: flush what is buffered and finish their clip files before
+// returning. False if any take failed to write.
+bool audio_engine_stop_recording(AudioEngine* engine);
+
+// Progress of a track's current take
+bool audio_engine_get_track_recording_stats(AudioEngine* engine, int track_index, ClipRecordingStats* stats);
+
+// Freeze a clip or oscillator track: render its source, volume, pan and
+// effect chain (automation included) from where they are now into
+// "<directory>/trackNN_freezeNNN" CLIP_CACHE_EXTENSION through the offline
+// path, then play that file instead of running them. Mute, solo, sends and
+// routing stay live. frame_count 0 renders to the end of a non-looping clip
+// plus the chain's tail, or ENGINE_FREEZE_DEFAULT_SECONDS. The device is
+// paused while rendering. Any later edit that would change the frozen audio
+// (volume, pan, effects, automation, the clip) unfreezes the track first.
+bool audio_engine_freeze_track(AudioEngine* engine, int track_index, uint64_t frame_count, const char* directory);
+
+// Go back to rendering the track live, its clip resuming where the frozen
+// audio had got to
+bool audio_engine_unfreeze_track(AudioEngine* engine, int track_index);
+
+// Replace the automation of a track parameter with count breakpoints at
+// transport frames (count 0 removes the lane). effect_index and param_index
+// are only used for AUTOMATION_EFFECT_PARAM. Volume and pan follow the lane
+// sample-accurately; effect parameters are updated once per block, to the
+// lane's value at its last frame (gain and filters glide there).
+bool audio_engine_set_track_automation(AudioEngine* engine, int track_index, AutomationTarget target,
+                                       int effect_index, int param_index, const AutomationPoint* points,
+                                       uint32_t count);
+
+// Move the transport (the timeline automation lanes are evaluated on). It
+// only advances while playing.
+bool audio_engine_set_transport_position(AudioEngine* engine, uint64_t frame);
+uint64_t audio_engine_get_transport_position(AudioEngine* engine);
+
+// Pick the output the spectrum analyzer tap copies: ANALYZER_SOURCE_MASTER,
+// a track index, or ANALYZER_SOURCE_NONE (the default) to stop tapping.
+// Takes effect at the next callback.
+bool audio_engine_set_analyzer_source(AudioEngine* engine, int source);
+
+// The tap an Analyzer drains (one consumer)
+AnalyzerTap* audio_engine_get_analyzer_tap(AudioEngine* engine);
+
+// Add a new submix bus routed to master
+// Returns bus index or -1 on failure
+int audio_engine_add_bus(AudioEngine* engine, const char* name);
+
+// Add a bus carrying one reverb in send mode (wet only, mix 1). Route any
+// number of tracks to it with audio_engine_set_track_send so they share a
+// single reverb instance. Returns bus index, or -1 with nothing added.
+int audio_engine_add_reverb_bus(AudioEngine* engine, const char* name);
+
+// Route a bus to another bus (or BUS_MASTER); fails if it would form a cycle
+bool audio_engine_set_bus_output(AudioEngine* engine, int bus_index, int output_bus);
+
+// Per-bus mix controls
+bool audio_engine_set_bus_volume(AudioEngine* engine, int bus_index, float volume);
+bool audio_engine_set_bus_mute(AudioEngine* engine, int bus_index, bool mute);
+
 // Add an effect to a track's effect chain
-void audio_engine_add_effect(Track* track, EffectType type);
+bool audio_engine_add_effect(AudioEngine* engine, int track_index, EffectType type);
+
+// Add an effect that runs at `oversampling` (2, 4 or 8) times the engine
+// rate behind half-band filters, so what it generates above Nyquist does
+// not alias back (see oversampler.h). Adds oversampler_latency() frames to
+// the track, compensated like any other latency; 1 is audio_engine_add_effect.
+// Convolution cannot be oversampled.
+bool audio_engine_add_oversampled_effect(AudioEngine* engine, int track_index, EffectType type,
+                                         uint32_t oversampling);
+
+// Add a convolution effect with an impulse response (interleaved, 1 or 2
+// channels, copied; at most CONVOLVER_MAX_IR_FRAMES). The wet signal is
+// delayed by CONVOLVER_PARTITION_FRAMES.
+bool audio_engine_add_convolution(AudioEngine* engine, int track_index, const float* ir, uint32_t ir_frames,
+                                  uint32_t ir_channels);
+
+// Add a CLAP plugin (see clap_host.h) from a .clap file: the plugin
+// `plugin_id`, or the file's first with NULL, as a stereo effect whose
+// parameters are the plugin's first EFFECT_MAX_PARAMS. Its latency is
+// compensated like any other. False (logged) if the build has no CLAP
+// support or the plugin cannot be loaded and activated. CLAP effects
+// cannot be oversampled; plugins that want it do their own.
+bool audio_engine_add_clap_effect(AudioEngine* engine, int track_index, const char* path, const char* plugin_id);
+
+// The same for a clap_entry linked into this process (not saved with a
+// session, which has no path to load it from)
+bool audio_engine_add_linked_clap_effect(AudioEngine* engine, int track_index, const struct clap_plugin_entry* entry,
+                                         const char* plugin_id);
 
 // Remove an effect from a track's effect chain
-void audio_engine_remove_effect(Track* track, int effect_index);
+bool audio_engine_remove_effect(AudioEngine* engine, int track_index, int effect_index);
+
+// Move an effect to a new position in a track's effect chain
+bool audio_engine_move_effect(AudioEngine* engine, int track_index, int from_index, int to_index);
 
 // Toggle effect enabled/disabled
-void audio_engine_toggle_effect(Track* track, int effect_index);
+bool audio_engine_toggle_effect(AudioEngine* engine, int track_index, int effect_index);
 
 // Set effect parameter (generic setter)
-void audio_engine_set_effect_param(Effect* effect, int param_index, float value);
+bool audio_engine_set_effect_param(AudioEngine* engine, int track_index, int effect_index,
+                                   int param_index, float value);
+
+// Bus effect chains (same semantics as the track versions above)
+bool audio_engine_add_bus_effect(AudioEngine* engine, int bus_index, EffectType type);
+bool audio_engine_add_bus_oversampled_effect(AudioEngine* engine, int bus_index, EffectType type,
+                                             uint32_t oversampling);
+bool audio_engine_add_bus_convolution(AudioEngine* engine, int bus_index, const float* ir, uint32_t ir_frames,
+                                      uint32_t ir_channels);
+bool audio_engine_add_bus_clap_effect(AudioEngine* engine, int bus_index, const char* path, const char* plugin_id);
+bool audio_engine_remove_bus_effect(AudioEngine* engine, int bus_index, int effect_index);
+bool audio_engine_move_bus_effect(AudioEngine* engine, int bus_index, int from_index, int to_index);
+bool audio_engine_toggle_bus_effect(AudioEngine* engine, int bus_index, int effect_index);
+bool audio_engine_set_bus_effect_param(AudioEngine* engine, int bus_index, int effect_index,
+                                       int param_index, float value);
+
+// Sessions (see session.h): tracks, buses, routing, mix controls, effect
+// chains, automation and clip paths, as the audio thread last applied them
+// (like audio_engine_snapshot). Not saved: convolution impulse responses
+// (loaded back as a unit impulse), CLAP plugin state beyond the exposed
+// parameters, plugins linked into the process, frozen renders, takes and
+// the transport. A CLAP plugin that cannot be loaded again keeps its slot
+// as a pass-through, so the chain and its automation survive.
+
+// Copy the session into a new image (release it with session_image_free).
+// A walk over the model without any I/O, so the image can be written
+// later or on another thread.
+bool audio_engine_capture_session(AudioEngine* engine, SessionImage* image);
+
+// Capture and write the session to `path` (see session_image_write)
+bool audio_engine_save_session(AudioEngine* engine, const char* path);
+
+// Rebuild a saved session in an engine without tracks or buses, published
+// as a single render graph. Clips that fail to open are reported and left
+// out. False if the file is not a valid session (the engine is left as it
+// was) or resources ran out part way (what was restored so far is kept).
+bool audio_engine_load_session(AudioEngine* engine, const char* path);
 
 #endif // AUDIO_ENGINE_H
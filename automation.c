@@ -0,0 +1,98 @@
+#include "automation.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// CONTROL THREAD
+// ============================================================================
+
+AutomationLane* automation_lane_create(const AutomationPoint* points, uint32_t count) {
+    if (count == 0) {
+        return NULL;
+    }
+    AutomationLane* lane = (AutomationLane*)malloc(sizeof(AutomationLane) + sizeof(AutomationPoint) * count);
+    if (!lane) {
+        return NULL;
+    }
+    lane->count = count;
+
+    // Insertion sort: stable, and lanes usually arrive sorted already
+    for (uint32_t i = 0; i < count; i++) {
+        AutomationPoint point = points[i];
+        uint32_t j = i;
+        while (j > 0 && lane->points[j - 1].frame > point.frame) {
+            lane->points[j] = lane->points[j - 1];
+            j--;
+        }
+        lane->points[j] = point;
+    }
+    return lane;
+}
+
+void automation_lane_destroy(AutomationLane* lane) {
+    free(lane);
+}
+
+// ============================================================================
+// EVALUATION
+// ============================================================================
+
+// Index of the first point with point.frame > frame (count if none)
+static uint32_t upper_bound(const AutomationLane* lane, uint64_t frame) {
+    uint32_t low = 0;
+    uint32_t high = lane->count;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (lane->points[mid].frame <= frame) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+float automation_lane_value_at(const AutomationLane* lane, uint64_t frame) {
+    uint32_t next = upper_bound(lane, frame);
+    if (next == 0) {
+        return lane->points[0].value;
+    }
+    if (next == lane->count) {
+        return lane->points[lane->count - 1].value;
+    }
+    const AutomationPoint* a = &lane->points[next - 1];
+    const AutomationPoint* b = &lane->points[next];
+    float t = (float)(frame - a->frame) / (float)(b->frame - a->frame);
+    return a->value + (b->value - a->value) * t;
+}
+
+uint32_t automation_block_cuts(const AutomationLane* const* lanes, int lane_count, uint64_t frame,
+                               uint32_t frame_count, uint32_t* cuts) {
+    uint32_t count = 0;
+    cuts[count++] = 0;
+
+    for (int l = 0; l < lane_count; l++) {
+        const AutomationLane* lane = lanes[l];
+        if (!lane) continue;
+
+        // Breakpoints strictly inside the block; one on the first frame is
+        // already covered by the cut at 0
+        for (uint32_t p = upper_bound(lane, frame); p < lane->count; p++) {
+            uint64_t offset = lane->points[p].frame - frame;
+            if (offset >= frame_count) break;
+            if (count >= AUTOMATION_MAX_CUTS - 1) break;
+
+            // Keep cuts sorted and unique
+            uint32_t cut = (uint32_t)offset;
+            uint32_t i = count;
+            while (i > 0 && cuts[i - 1] > cut) i--;
+            if (cuts[i - 1] == cut) continue;
+            memmove(&cuts[i + 1], &cuts[i], sizeof(uint32_t) * (count - i));
+            cuts[i] = cut;
+            count++;
+        }
+    }
+
+    cuts[count++] = frame_count;
+    return count;
+}
@@ -0,0 +1,58 @@
+// automation.h - Breakpoint automation lanes
+// A lane is an immutable, sorted list of (transport frame, value)
+// breakpoints: the value holds before the first point and after the last
+// and is linear in between. The control thread builds lanes and publishes
+// them through the render graph; the audio thread never modifies them.
+//
+// Per block, the audio thread cuts the block at every breakpoint that falls
+// inside it. Between two cuts each lane is exactly linear, so a segment is
+// one gain ramp for the SIMD kernels: sample-accurate without evaluating the
+// lane per sample. Blocks without automation never get here.
+#pragma once
+#ifndef AUTOMATION_H
+#define AUTOMATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define AUTOMATION_MAX_CUTS 17      // Segment boundaries per block (16 segments); denser lanes are approximated
+
+typedef enum {
+    AUTOMATION_TRACK_VOLUME = 0,
+    AUTOMATION_TRACK_PAN,
+    AUTOMATION_EFFECT_PARAM     // Evaluated once per block, at its last frame (effects take scalar params)
+} AutomationTarget;
+
+typedef struct {
+    uint64_t frame;             // Transport frame
+    float value;
+} AutomationPoint;
+
+typedef struct {
+    uint32_t count;
+    AutomationPoint points[];   // Sorted by frame
+} AutomationLane;
+
+// ============================================================================
+// CONTROL THREAD
+// ============================================================================
+
+// Copy count points (any order; points on the same frame keep their order)
+// into a new lane. Returns NULL if count is 0 or allocation fails.
+AutomationLane* automation_lane_create(const AutomationPoint* points, uint32_t count);
+void automation_lane_destroy(AutomationLane* lane);
+
+// ============================================================================
+// AUDIO THREAD (any thread, lanes are immutable)
+// ============================================================================
+
+float automation_lane_value_at(const AutomationLane* lane, uint64_t frame);
+
+// Offsets in [0, frame_count] where the block starting at `frame` has to be
+// cut so every listed lane is linear between consecutive cuts. Always
+// starts with 0 and ends with frame_count; NULL lanes are skipped. Returns
+// the number of cuts written (at most AUTOMATION_MAX_CUTS).
+uint32_t automation_block_cuts(const AutomationLane* const* lanes, int lane_count, uint64_t frame,
+                               uint32_t frame_count, uint32_t* cuts);
+
+#endif // AUTOMATION_H
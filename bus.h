@@ -1,11 +1,39 @@
+// bus.h - Submix buses
+// Tracks feed a bus through their main output or through post-fader sends,
+// buses feed other buses or master. One effect chain on a bus processes the
+// sum of everything routed into it, so shared effects (e.g. a single reverb)
+// cost the same no matter how many tracks use them.
 #pragma once
+#ifndef BUS_H
+#define BUS_H
 
-#include "vendor/miniaudio/miniaudio.h"
+#include "effects.h"
+#include "meters.h"
+#include "pdc.h"
 #include <stdatomic.h>
 #include <stdbool.h>
 
+#define MAX_BUSES 8
+#define BUS_MASTER -1           // Output target meaning "straight to master"
+
 typedef struct {
-    ma_data_source_node source;
-    ma_sound_group group;
-    ma_data_source_node_config config;
-}Bus;
+    char name[64];
+
+    // Mix controls (owned by the audio thread once published)
+    float volume;               // 0.0 to 1.0
+    atomic_bool mute;
+
+    // Routing model (control thread only; snapshotted into the render graph)
+    int output_bus;             // BUS_MASTER or the index of another bus
+
+    EffectChain chain;
+
+    // Latency compensation on the way out (allocated on first use, written
+    // by the audio thread)
+    PdcDelay output_delay;
+
+    // Metering (published by audio thread once per block)
+    MeterChannel meter;
+} Bus;
+
+#endif // BUS_H
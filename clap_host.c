@@ -0,0 +1,523 @@
+#include "clap_host.h"
+#include "engine_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef AIRDAW_CLAP
+
+#include <clap/clap.h>
+#include <stdatomic.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+// ============================================================================
+// LIBRARIES
+// ============================================================================
+
+#ifdef _WIN32
+
+static void* library_open(const char* path) {
+    return (void*)LoadLibraryA(path);
+}
+
+static const void* library_symbol(void* library, const char* name) {
+    return (const void*)GetProcAddress((HMODULE)library, name);
+}
+
+static void library_close(void* library) {
+    FreeLibrary((HMODULE)library);
+}
+
+#else
+
+static void* library_open(const char* path) {
+    return dlopen(path, RTLD_NOW | RTLD_LOCAL);
+}
+
+static const void* library_symbol(void* library, const char* name) {
+    return dlsym(library, name);
+}
+
+static void library_close(void* library) {
+    dlclose(library);
+}
+
+#endif
+
+struct ClapPlugin {
+    void* library;                      // NULL for an entry linked into the host
+    const clap_plugin_entry_t* entry;
+    bool entry_initialized;
+    const clap_plugin_t* plugin;
+    bool plugin_initialized;
+    bool activated;
+    clap_host_t host;
+    const clap_plugin_params_t* params;
+    char id[256];
+    double sample_rate;
+    uint32_t max_frames;
+
+    uint32_t param_count;
+    clap_id param_ids[CLAP_HOST_MAX_PARAMS];
+    float param_values[CLAP_HOST_MAX_PARAMS];     // At load
+
+    uint32_t latency;
+    uint32_t tail;
+
+    // Audio thread only
+    bool processing;                    // start_processing() has succeeded
+    bool failed;                        // The plugin returned an error
+    int64_t steady_time;
+    bool pending[CLAP_HOST_MAX_PARAMS];
+    float pending_values[CLAP_HOST_MAX_PARAMS];
+    clap_event_param_value_t events[CLAP_HOST_MAX_PARAMS];
+    uint32_t event_count;
+    float* output[2];                   // max_frames each: plugins write out of place
+    float* delay[2];                    // latency frames each: the bypass delay line
+    uint32_t delay_pos;
+
+    // Set by host callbacks from any thread. Nothing services them yet: the
+    // latency stays as activated and main-thread callbacks are not made.
+    atomic_bool restart_requested;
+    atomic_bool callback_requested;
+};
+
+// ============================================================================
+// HOST CALLBACKS (any thread)
+// ============================================================================
+
+static const void* host_get_extension(const clap_host_t* host, const char* extension_id) {
+    (void)host;
+    (void)extension_id;
+    return NULL;
+}
+
+static void host_request_restart(const clap_host_t* host) {
+    ClapPlugin* plugin = (ClapPlugin*)host->host_data;
+    atomic_store(&plugin->restart_requested, true);
+}
+
+static void host_request_process(const clap_host_t* host) {
+    (void)host;
+}
+
+static void host_request_callback(const clap_host_t* host) {
+    ClapPlugin* plugin = (ClapPlugin*)host->host_data;
+    atomic_store(&plugin->callback_requested, true);
+}
+
+// ============================================================================
+// EVENT LISTS (audio thread)
+// ============================================================================
+
+static uint32_t input_events_size(const clap_input_events_t* list) {
+    const ClapPlugin* plugin = (const ClapPlugin*)list->ctx;
+    return plugin->event_count;
+}
+
+static const clap_event_header_t* input_events_get(const clap_input_events_t* list, uint32_t index) {
+    const ClapPlugin* plugin = (const ClapPlugin*)list->ctx;
+    return index < plugin->event_count ? &plugin->events[index].header : NULL;
+}
+
+// Output events (gestures, parameter feedback) are accepted and dropped
+static bool output_events_try_push(const clap_output_events_t* list, const clap_event_header_t* event) {
+    (void)list;
+    (void)event;
+    return true;
+}
+
+// Turn the pending parameter changes into this block's event list
+static void take_pending_events(ClapPlugin* plugin) {
+    plugin->event_count = 0;
+    for (uint32_t p = 0; p < plugin->param_count; p++) {
+        if (!plugin->pending[p]) {
+            continue;
+        }
+        clap_event_param_value_t* event = &plugin->events[plugin->event_count++];
+        memset(event, 0, sizeof(*event));
+        event->header.size = sizeof(*event);
+        event->header.time = 0;
+        event->header.space_id = CLAP_CORE_EVENT_SPACE_ID;
+        event->header.type = CLAP_EVENT_PARAM_VALUE;
+        event->param_id = plugin->param_ids[p];
+        event->note_id = -1;
+        event->port_index = -1;
+        event->channel = -1;
+        event->key = -1;
+        event->value = plugin->pending_values[p];
+        plugin->pending[p] = false;
+    }
+}
+
+// ============================================================================
+// LIFECYCLE (control thread)
+// ============================================================================
+
+bool clap_host_available(void) {
+    return true;
+}
+
+// A stereo main input and output, on the first port of each
+static bool has_stereo_ports(const clap_plugin_t* instance) {
+    const clap_plugin_audio_ports_t* ports =
+        (const clap_plugin_audio_ports_t*)instance->get_extension(instance, CLAP_EXT_AUDIO_PORTS);
+    if (!ports || ports->count(instance, true) < 1 || ports->count(instance, false) < 1) {
+        return false;
+    }
+    clap_audio_port_info_t input;
+    clap_audio_port_info_t output;
+    return ports->get(instance, 0, true, &input) && ports->get(instance, 0, false, &output) &&
+           input.channel_count == 2 && output.channel_count == 2;
+}
+
+static void read_params(ClapPlugin* plugin) {
+    const clap_plugin_t* instance = plugin->plugin;
+    plugin->params = (const clap_plugin_params_t*)instance->get_extension(instance, CLAP_EXT_PARAMS);
+    if (!plugin->params) {
+        return;
+    }
+    uint32_t count = plugin->params->count(instance);
+    for (uint32_t i = 0; i < count && plugin->param_count < CLAP_HOST_MAX_PARAMS; i++) {
+        clap_param_info_t info;
+        if (!plugin->params->get_info(instance, i, &info)) {
+            continue;
+        }
+        double value = info.default_value;
+        plugin->params->get_value(instance, info.id, &value);
+        plugin->param_ids[plugin->param_count] = info.id;
+        plugin->param_values[plugin->param_count] = (float)value;
+        plugin->param_count++;
+    }
+}
+
+// Latency and tail as of activation, and the buffers they size
+static bool read_delays(ClapPlugin* plugin) {
+    const clap_plugin_t* instance = plugin->plugin;
+    const clap_plugin_latency_t* latency =
+        (const clap_plugin_latency_t*)instance->get_extension(instance, CLAP_EXT_LATENCY);
+    plugin->latency = latency ? latency->get(instance) : 0;
+    if (plugin->latency > CLAP_HOST_MAX_LATENCY) {
+        engine_log(ENGINE_LOG_WARNING, "[clap] '%s' reports %u frames of latency (at most %d)", plugin->id,
+                   plugin->latency, CLAP_HOST_MAX_LATENCY);
+        return false;
+    }
+
+    // UINT32_MAX is an infinite tail
+    const clap_plugin_tail_t* tail = (const clap_plugin_tail_t*)instance->get_extension(instance, CLAP_EXT_TAIL);
+    uint32_t max_tail = (uint32_t)(plugin->sample_rate * CLAP_HOST_MAX_TAIL_SECONDS);
+    uint32_t frames = tail ? tail->get(instance) : 0;
+    plugin->tail = (frames < max_tail ? frames : max_tail) + plugin->latency;
+
+    for (int c = 0; c < 2; c++) {
+        plugin->output[c] = (float*)calloc(plugin->max_frames, sizeof(float));
+        plugin->delay[c] = plugin->latency ? (float*)calloc(plugin->latency, sizeof(float)) : NULL;
+        if (!plugin->output[c] || (plugin->latency && !plugin->delay[c])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static ClapPlugin* load(const clap_plugin_entry_t* entry, void* library, const char* path, const char* plugin_id,
+                        double sample_rate, uint32_t max_frames) {
+    ClapPlugin* plugin = (ClapPlugin*)calloc(1, sizeof(ClapPlugin));
+    if (!plugin) {
+        if (library) {
+            library_close(library);
+        }
+        return NULL;
+    }
+    plugin->library = library;
+    plugin->entry = entry;
+    plugin->sample_rate = sample_rate;
+    plugin->max_frames = max_frames;
+    plugin->host = (clap_host_t){
+        .clap_version = CLAP_VERSION_INIT,
+        .host_data = plugin,
+        .name = "AirDAW",
+        .vendor = "AirDAW",
+        .url = "",
+        .version = "1.0",
+        .get_extension = host_get_extension,
+        .request_restart = host_request_restart,
+        .request_process = host_request_process,
+        .request_callback = host_request_callback,
+    };
+
+    if (!clap_version_is_compatible(entry->clap_version) || !entry->init(path ? path : "")) {
+        engine_log(ENGINE_LOG_WARNING, "[clap] Cannot initialize plugin library: %s", path ? path : "(linked)");
+        clap_plugin_unload(plugin);
+        return NULL;
+    }
+    plugin->entry_initialized = true;
+
+    // The requested plugin, or the library's first
+    const clap_plugin_factory_t* factory = (const clap_plugin_factory_t*)entry->get_factory(CLAP_PLUGIN_FACTORY_ID);
+    const clap_plugin_descriptor_t* descriptor = NULL;
+    uint32_t count = factory ? factory->get_plugin_count(factory) : 0;
+    for (uint32_t i = 0; i < count && !descriptor; i++) {
+        const clap_plugin_descriptor_t* candidate = factory->get_plugin_descriptor(factory, i);
+        if (candidate && (!plugin_id || strcmp(candidate->id, plugin_id) == 0)) {
+            descriptor = candidate;
+        }
+    }
+    if (!descriptor) {
+        engine_log(ENGINE_LOG_WARNING, "[clap] No plugin '%s' in %s", plugin_id ? plugin_id : "(any)",
+                   path ? path : "(linked)");
+        clap_plugin_unload(plugin);
+        return NULL;
+    }
+    snprintf(plugin->id, sizeof(plugin->id), "%s", descriptor->id);
+
+    plugin->plugin = factory->create_plugin(factory, &plugin->host, descriptor->id);
+    plugin->plugin_initialized = plugin->plugin && plugin->plugin->init(plugin->plugin);
+    if (!plugin->plugin_initialized || !has_stereo_ports(plugin->plugin)) {
+        engine_log(ENGINE_LOG_WARNING, "[clap] '%s' has no stereo effect ports", plugin->id);
+        clap_plugin_unload(plugin);
+        return NULL;
+    }
+    read_params(plugin);
+
+    plugin->activated = plugin->plugin->activate(plugin->plugin, sample_rate, 1, max_frames);
+    if (!plugin->activated || !read_delays(plugin)) {
+        engine_log(ENGINE_LOG_WARNING, "[clap] Cannot activate '%s' at %.0f Hz", plugin->id, sample_rate);
+        clap_plugin_unload(plugin);
+        return NULL;
+    }
+    engine_log(ENGINE_LOG_INFO, "[clap] Loaded '%s' (%s): %u parameters, %u frames latency", plugin->id,
+               descriptor->name ? descriptor->name : "", plugin->param_count, plugin->latency);
+    return plugin;
+}
+
+ClapPlugin* clap_plugin_load(const char* path, const char* plugin_id, double sample_rate, uint32_t max_frames) {
+    void* library = library_open(path);
+    if (!library) {
+        engine_log(ENGINE_LOG_WARNING, "[clap] Cannot open plugin: %s", path);
+        return NULL;
+    }
+    const clap_plugin_entry_t* entry = (const clap_plugin_entry_t*)library_symbol(library, "clap_entry");
+    if (!entry) {
+        engine_log(ENGINE_LOG_WARNING, "[clap] No clap_entry in %s", path);
+        library_close(library);
+        return NULL;
+    }
+    return load(entry, library, path, plugin_id, sample_rate, max_frames);
+}
+
+ClapPlugin* clap_plugin_load_entry(const struct clap_plugin_entry* entry, const char* path, const char* plugin_id,
+                                   double sample_rate, uint32_t max_frames) {
+    return entry ? load(entry, NULL, path, plugin_id, sample_rate, max_frames) : NULL;
+}
+
+// By now no chain can process the instance, so stopping it here (rather
+// than on the audio thread, as CLAP prefers) races nothing
+void clap_plugin_unload(ClapPlugin* plugin) {
+    if (!plugin) {
+        return;
+    }
+    if (plugin->processing) {
+        plugin->plugin->stop_processing(plugin->plugin);
+    }
+    if (plugin->activated) {
+        plugin->plugin->deactivate(plugin->plugin);
+    }
+    if (plugin->plugin) {
+        plugin->plugin->destroy(plugin->plugin);
+    }
+    if (plugin->entry_initialized) {
+        plugin->entry->deinit();
+    }
+    if (plugin->library) {
+        library_close(plugin->library);
+    }
+    for (int c = 0; c < 2; c++) {
+        free(plugin->output[c]);
+        free(plugin->delay[c]);
+    }
+    free(plugin);
+}
+
+void clap_plugin_set_offline(ClapPlugin* plugin, bool offline) {
+    const clap_plugin_t* instance = plugin->plugin;
+    const clap_plugin_render_t* render =
+        (const clap_plugin_render_t*)instance->get_extension(instance, CLAP_EXT_RENDER);
+    if (render) {
+        render->set(instance, offline ? CLAP_RENDER_OFFLINE : CLAP_RENDER_REALTIME);
+    }
+}
+
+const char* clap_plugin_id(const ClapPlugin* plugin) {
+    return plugin->id;
+}
+
+uint32_t clap_plugin_latency(const ClapPlugin* plugin) {
+    return plugin->latency;
+}
+
+uint32_t clap_plugin_tail(const ClapPlugin* plugin) {
+    return plugin->tail;
+}
+
+uint32_t clap_plugin_param_count(const ClapPlugin* plugin) {
+    return plugin->param_count;
+}
+
+float clap_plugin_param_value(const ClapPlugin* plugin, uint32_t index) {
+    return index < plugin->param_count ? plugin->param_values[index] : 0.0f;
+}
+
+// ============================================================================
+// PROCESSING (audio thread)
+// ============================================================================
+
+void clap_plugin_queue_param(ClapPlugin* plugin, uint32_t index, float value) {
+    if (index < plugin->param_count) {
+        plugin->pending[index] = true;
+        plugin->pending_values[index] = value;
+    }
+}
+
+void clap_plugin_process(ClapPlugin* plugin, float* left, float* right, uint32_t frame_count) {
+    if (!plugin->failed && !plugin->processing) {
+        plugin->processing = plugin->plugin->start_processing(plugin->plugin);
+        plugin->failed = !plugin->processing;
+    }
+    if (plugin->failed) {
+        clap_plugin_bypass(plugin, left, right, frame_count);
+        return;
+    }
+
+    const clap_input_events_t in_events = {.ctx = plugin, .size = input_events_size, .get = input_events_get};
+    const clap_output_events_t out_events = {.ctx = plugin, .try_push = output_events_try_push};
+    for (uint32_t offset = 0; offset < frame_count; offset += plugin->max_frames) {
+        uint32_t chunk = frame_count - offset < plugin->max_frames ? frame_count - offset : plugin->max_frames;
+        float* inputs[2] = {left + offset, right + offset};
+        clap_audio_buffer_t input = {.data32 = inputs, .channel_count = 2};
+        clap_audio_buffer_t output = {.data32 = plugin->output, .channel_count = 2};
+        take_pending_events(plugin);
+        clap_process_t process = {
+            .steady_time = plugin->steady_time,
+            .frames_count = chunk,
+            .audio_inputs = &input,
+            .audio_outputs = &output,
+            .audio_inputs_count = 1,
+            .audio_outputs_count = 1,
+            .in_events = &in_events,
+            .out_events = &out_events,
+        };
+        if (plugin->plugin->process(plugin->plugin, &process) == CLAP_PROCESS_ERROR) {
+            plugin->failed = true;
+            clap_plugin_bypass(plugin, left + offset, right + offset, frame_count - offset);
+            return;
+        }
+        memcpy(left + offset, plugin->output[0], sizeof(float) * chunk);
+        memcpy(right + offset, plugin->output[1], sizeof(float) * chunk);
+        plugin->steady_time += chunk;
+    }
+}
+
+void clap_plugin_bypass(ClapPlugin* plugin, float* left, float* right, uint32_t frame_count) {
+    uint32_t latency = plugin->latency;
+    if (latency == 0) {
+        return;
+    }
+    uint32_t pos = plugin->delay_pos;
+    for (uint32_t i = 0; i < frame_count; i++) {
+        float l = plugin->delay[0][pos];
+        float r = plugin->delay[1][pos];
+        plugin->delay[0][pos] = left[i];
+        plugin->delay[1][pos] = right[i];
+        left[i] = l;
+        right[i] = r;
+        pos = pos + 1 == latency ? 0 : pos + 1;
+    }
+    plugin->delay_pos = pos;
+}
+
+#else // !AIRDAW_CLAP
+
+bool clap_host_available(void) {
+    return false;
+}
+
+ClapPlugin* clap_plugin_load(const char* path, const char* plugin_id, double sample_rate, uint32_t max_frames) {
+    (void)plugin_id;
+    (void)sample_rate;
+    (void)max_frames;
+    engine_log(ENGINE_LOG_WARNING, "[clap] Built without CLAP support (AIRDAW_CLAP), cannot load %s", path);
+    return NULL;
+}
+
+ClapPlugin* clap_plugin_load_entry(const struct clap_plugin_entry* entry, const char* path, const char* plugin_id,
+                                   double sample_rate, uint32_t max_frames) {
+    (void)entry;
+    (void)plugin_id;
+    (void)sample_rate;
+    (void)max_frames;
+    engine_log(ENGINE_LOG_WARNING, "[clap] Built without CLAP support (AIRDAW_CLAP), cannot load %s",
+               path ? path : "(linked)");
+    return NULL;
+}
+
+void clap_plugin_unload(ClapPlugin* plugin) {
+    (void)plugin;
+}
+
+void clap_plugin_set_offline(ClapPlugin* plugin, bool offline) {
+    (void)plugin;
+    (void)offline;
+}
+
+const char* clap_plugin_id(const ClapPlugin* plugin) {
+    (void)plugin;
+    return "";
+}
+
+uint32_t clap_plugin_latency(const ClapPlugin* plugin) {
+    (void)plugin;
+    return 0;
+}
+
+uint32_t clap_plugin_tail(const ClapPlugin* plugin) {
+    (void)plugin;
+    return 0;
+}
+
+uint32_t clap_plugin_param_count(const ClapPlugin* plugin) {
+    (void)plugin;
+    return 0;
+}
+
+float clap_plugin_param_value(const ClapPlugin* plugin, uint32_t index) {
+    (void)plugin;
+    (void)index;
+    return 0.0f;
+}
+
+void clap_plugin_queue_param(ClapPlugin* plugin, uint32_t index, float value) {
+    (void)plugin;
+    (void)index;
+    (void)value;
+}
+
+void clap_plugin_process(ClapPlugin* plugin, float* left, float* right, uint32_t frame_count) {
+    (void)plugin;
+    (void)left;
+    (void)right;
+    (void)frame_count;
+}
+
+void clap_plugin_bypass(ClapPlugin* plugin, float* left, float* right, uint32_t frame_count) {
+    (void)plugin;
+    (void)left;
+    (void)right;
+    (void)frame_count;
+}
+
+#endif // AIRDAW_CLAP
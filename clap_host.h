@@ -0,0 +1,79 @@
+// clap_host.h - Hosting CLAP plugins as effects
+// Loads a CLAP plugin (a shared library exporting clap_entry, or an entry
+// linked into the host) and runs one instance of it as a stereo effect.
+// Built with AIRDAW_CLAP and the CLAP headers in vendor/clap/include;
+// without them every load fails and the rest of this API is inert.
+//
+// Threads follow CLAP's model. Loading, activation and unloading happen on
+// the control thread; clap_plugin_process() runs wherever the owning chain
+// is rendered (a render worker or the audio callback), never concurrently.
+// Parameter changes are queued on the audio thread (commands are applied
+// there), one pending value per parameter, and the next process call hands
+// them to the plugin as events, so nothing on the audio path allocates,
+// locks or waits. Host callbacks a plugin may make only set flags.
+//
+// The first CLAP_HOST_MAX_PARAMS parameters the plugin lists are the
+// effect's parameters, in the plugin's own units. Latency and tail are
+// read once at activation; the render graph compensates the latency, and
+// a disabled instance delays the dry signal by the same amount.
+#pragma once
+#ifndef CLAP_HOST_H
+#define CLAP_HOST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CLAP_HOST_MAX_PARAMS 4          // Parameters exposed per instance (EFFECT_MAX_PARAMS)
+#define CLAP_HOST_MAX_TAIL_SECONDS 30   // Longest tail reported (infinite tails included)
+#define CLAP_HOST_MAX_LATENCY 65536     // Frames; longer latencies are refused
+
+struct clap_plugin_entry;
+typedef struct ClapPlugin ClapPlugin;
+
+// True if this build can host CLAP plugins
+bool clap_host_available(void);
+
+// Load the plugin `plugin_id` (NULL: the first one) from a .clap file and
+// activate it for up to max_frames frames per block. Returns NULL (logged)
+// if the file, the plugin or a stereo activation is not available.
+ClapPlugin* clap_plugin_load(const char* path, const char* plugin_id, double sample_rate, uint32_t max_frames);
+
+// The same from an entry already in this process; `path` is what
+// clap_entry->init() is given
+ClapPlugin* clap_plugin_load_entry(const struct clap_plugin_entry* entry, const char* path, const char* plugin_id,
+                                   double sample_rate, uint32_t max_frames);
+
+// Deactivate and destroy the instance, then release the library (control
+// thread, once no chain can process it)
+void clap_plugin_unload(ClapPlugin* plugin);
+
+// Ask the plugin to render offline (or in real time again) through its
+// render extension, if it has one (control thread, while nothing renders)
+void clap_plugin_set_offline(ClapPlugin* plugin, bool offline);
+
+// Descriptor id of the loaded plugin
+const char* clap_plugin_id(const ClapPlugin* plugin);
+
+// Frames of delay the plugin reported at activation
+uint32_t clap_plugin_latency(const ClapPlugin* plugin);
+
+// Frames the output may keep sounding after the input goes silent
+uint32_t clap_plugin_tail(const ClapPlugin* plugin);
+
+// Parameters exposed (at most CLAP_HOST_MAX_PARAMS) and their values at load
+uint32_t clap_plugin_param_count(const ClapPlugin* plugin);
+float clap_plugin_param_value(const ClapPlugin* plugin, uint32_t index);
+
+// Queue a parameter change for the next block (audio thread). A later
+// change to the same parameter before then replaces it.
+void clap_plugin_queue_param(ClapPlugin* plugin, uint32_t index, float value);
+
+// Process one planar stereo block in place (audio thread). A plugin that
+// fails to start or returns an error is bypassed from then on.
+void clap_plugin_process(ClapPlugin* plugin, float* left, float* right, uint32_t frame_count);
+
+// Disabled: the block comes out delayed by the plugin's latency, and queued
+// changes wait for the next processed block (audio thread)
+void clap_plugin_bypass(ClapPlugin* plugin, float* left, float* right, uint32_t frame_count);
+
+#endif // CLAP_HOST_H
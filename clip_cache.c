@@ -0,0 +1,670 @@
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE         // fseeko, madvise
+#endif
+#if !defined(_WIN32)
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include "clip_cache.h"
+#include "resampler.h"
+#include "vendor/miniaudio/miniaudio.h"
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#define cache_fseek _fseeki64
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define cache_fseek fseeko
+#endif
+
+#define BUILD_CHUNK_FRAMES 4096
+
+// ============================================================================
+// LAYOUT
+// ============================================================================
+
+static uint64_t align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static uint32_t sample_bytes(uint32_t format) {
+    return format == CLIP_CACHE_S16 ? sizeof(int16_t) : sizeof(float);
+}
+
+static uint64_t bucket_count(uint64_t items, uint64_t per_bucket) {
+    return items == 0 ? 0 : (items + per_bucket - 1) / per_bucket;
+}
+
+// Fill in the peak pyramid offsets and counts behind the planes
+static void layout_peaks(ClipCacheHeader* header) {
+    uint64_t offset = header->data_offset + header->plane_stride * header->channels;
+    uint64_t count = bucket_count(header->frame_count, CLIP_CACHE_PEAK_FRAMES);
+    header->peak_levels = 0;
+    while (count > 0 && header->peak_levels < CLIP_CACHE_MAX_PEAK_LEVELS) {
+        header->peak_offset[header->peak_levels] = offset;
+        header->peak_count[header->peak_levels] = count;
+        header->peak_levels++;
+        offset += count * header->channels * sizeof(ClipPeak);
+        if (count == 1) break;
+        count = bucket_count(count, CLIP_CACHE_PEAK_FACTOR);
+    }
+}
+
+static bool source_identity(const char* path, uint64_t* size, int64_t* mtime) {
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        return false;
+    }
+    *size = (uint64_t)info.st_size;
+    *mtime = (int64_t)info.st_mtime;
+    return true;
+}
+
+// ============================================================================
+// BUILDING
+// ============================================================================
+
+// At the source's own rate. Keep mono sources mono; anything wider is
+// downmixed to stereo.
+static bool open_decoder(const char* path, ma_decoder* decoder) {
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 0, 0);
+    if (ma_decoder_init_file(path, &config, decoder) != MA_SUCCESS) {
+        return false;
+    }
+    if (decoder->outputChannels <= 2) {
+        return true;
+    }
+    ma_decoder_uninit(decoder);
+    config = ma_decoder_config_init(ma_format_f32, 2, 0);
+    return ma_decoder_init_file(path, &config, decoder) == MA_SUCCESS;
+}
+
+// Some decoders cannot report their length up front; count by decoding
+static uint64_t measure_length(ma_decoder* decoder, float* scratch) {
+    ma_uint64 length = 0;
+    if (ma_decoder_get_length_in_pcm_frames(decoder, &length) == MA_SUCCESS && length > 0) {
+        return length;
+    }
+    length = 0;
+    ma_uint64 decoded = 0;
+    while (ma_decoder_read_pcm_frames(decoder, scratch, BUILD_CHUNK_FRAMES, &decoded) == MA_SUCCESS && decoded > 0) {
+        length += decoded;
+    }
+    ma_decoder_seek_to_pcm_frame(decoder, 0);
+    return length;
+}
+
+// Decoded frames at the cache's rate: straight from the decoder, or through
+// a sinc converter when the source was recorded at another rate
+typedef struct {
+    ma_decoder decoder;
+    bool resampling;
+    Resampler resampler;
+    float* native;              // Decoded frames the converter has not taken yet
+    uint32_t native_offset;
+    uint32_t native_frames;
+    bool drained;               // Past the source's end: the converter reads silence
+} BuildSource;
+
+static bool source_open(BuildSource* source, const char* path, uint32_t sample_rate) {
+    memset(source, 0, sizeof(BuildSource));
+    if (!open_decoder(path, &source->decoder)) {
+        return false;
+    }
+    uint32_t native_rate = source->decoder.outputSampleRate;
+    if (native_rate == sample_rate) {
+        return true;
+    }
+    source->native = (float*)malloc(sizeof(float) * BUILD_CHUNK_FRAMES * 2);
+    if (!source->native || !resampler_init(&source->resampler, source->decoder.outputChannels, native_rate,
+                                           sample_rate, RESAMPLER_SINC, BUILD_CHUNK_FRAMES)) {
+        free(source->native);
+        ma_decoder_uninit(&source->decoder);
+        return false;
+    }
+    source->resampling = true;
+    return true;
+}
+
+static void source_close(BuildSource* source) {
+    if (source->resampling) {
+        resampler_destroy(&source->resampler);
+        free(source->native);
+    }
+    ma_decoder_uninit(&source->decoder);
+}
+
+// Frames the source converts to, from its length at its own rate
+static uint64_t source_length(BuildSource* source, uint32_t sample_rate, float* scratch) {
+    uint64_t length = measure_length(&source->decoder, scratch);
+    if (!source->resampling) {
+        return length;
+    }
+    return resampler_output_length(length, source->decoder.outputSampleRate, sample_rate);
+}
+
+static uint64_t source_read(BuildSource* source, float* out, uint64_t want) {
+    ma_uint64 decoded = 0;
+    if (!source->resampling) {
+        ma_decoder_read_pcm_frames(&source->decoder, out, want, &decoded);
+        return decoded;
+    }
+    uint32_t channels = source->decoder.outputChannels;
+    uint64_t written = 0;
+    while (written < want) {
+        if (source->native_offset == source->native_frames && !source->drained) {
+            ma_decoder_read_pcm_frames(&source->decoder, source->native, BUILD_CHUNK_FRAMES, &decoded);
+            source->native_offset = 0;
+            source->native_frames = (uint32_t)decoded;
+            source->drained = decoded == 0;
+        }
+        // The filter reads past the last frame; the tail converts from silence
+        const float* input = source->drained ? NULL : source->native + (size_t)source->native_offset * channels;
+        uint32_t taken = source->drained ? BUILD_CHUNK_FRAMES : source->native_frames - source->native_offset;
+        written += resampler_process(&source->resampler, input, &taken, out + written * channels,
+                                     (uint32_t)(want - written));
+        if (!source->drained) {
+            source->native_offset += taken;
+        }
+    }
+    return written;
+}
+
+static bool write_at(FILE* file, uint64_t offset, const void* data, size_t bytes) {
+    return cache_fseek(file, (int64_t)offset, SEEK_SET) == 0 && fwrite(data, 1, bytes, file) == bytes;
+}
+
+// Merge level-0 buckets upwards and write every level
+static bool write_peaks(FILE* file, const ClipCacheHeader* header, ClipPeak* level_peaks) {
+    ClipPeak* current = level_peaks;
+    bool ok = true;
+    for (uint32_t level = 0; level < header->peak_levels && ok; level++) {
+        uint64_t count = header->peak_count[level];
+        ok = write_at(file, header->peak_offset[level], current, sizeof(ClipPeak) * count * header->channels);
+        if (level + 1 == header->peak_levels) break;
+
+        uint64_t next_count = header->peak_count[level + 1];
+        ClipPeak* next = (ClipPeak*)malloc(sizeof(ClipPeak) * next_count * header->channels);
+        if (!next) {
+            ok = false;
+            break;
+        }
+        for (uint32_t ch = 0; ch < header->channels; ch++) {
+            const ClipPeak* src = current + ch * count;
+            ClipPeak* dst = next + ch * next_count;
+            for (uint64_t i = 0; i < next_count; i++) {
+                ClipPeak merged = {FLT_MAX, -FLT_MAX};
+                for (uint64_t j = i * CLIP_CACHE_PEAK_FACTOR; j < count && j < (i + 1) * CLIP_CACHE_PEAK_FACTOR; j++) {
+                    if (src[j].min < merged.min) merged.min = src[j].min;
+                    if (src[j].max > merged.max) merged.max = src[j].max;
+                }
+                dst[i] = merged;
+            }
+        }
+        if (current != level_peaks) free(current);
+        current = next;
+    }
+    if (current != level_peaks) free(current);
+    return ok;
+}
+
+bool clip_cache_build(const char* source_path, const char* cache_path, uint32_t sample_rate,
+                      ClipCacheFormat format) {
+    ClipCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    if (!source_identity(source_path, &header.source_size, &header.source_mtime)) {
+        return false;
+    }
+
+    BuildSource source;
+    if (!source_open(&source, source_path, sample_rate)) {
+        return false;
+    }
+
+    float* interleaved = (float*)malloc(sizeof(float) * BUILD_CHUNK_FRAMES * 2);
+    uint8_t* plane_chunk = (uint8_t*)malloc(sizeof(float) * BUILD_CHUNK_FRAMES);
+    if (!interleaved || !plane_chunk) {
+        free(interleaved);
+        free(plane_chunk);
+        source_close(&source);
+        return false;
+    }
+
+    header.version = CLIP_CACHE_VERSION;
+    header.format = (uint32_t)format;
+    header.channels = source.decoder.outputChannels;
+    header.sample_rate = sample_rate;
+    uint64_t capacity = source_length(&source, sample_rate, interleaved);
+    if (capacity == 0) {
+        free(interleaved);
+        free(plane_chunk);
+        source_close(&source);
+        return false;
+    }
+    header.data_offset = align_up(sizeof(ClipCacheHeader), CLIP_CACHE_PAGE_BYTES);
+    header.plane_stride = align_up(capacity * sample_bytes(header.format), CLIP_CACHE_PAGE_BYTES);
+
+    char temp_path[1024];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", cache_path);
+    FILE* file = fopen(temp_path, "wb");
+    uint64_t peak_capacity = bucket_count(capacity, CLIP_CACHE_PEAK_FRAMES);
+    ClipPeak* peaks = (ClipPeak*)malloc(sizeof(ClipPeak) * peak_capacity * header.channels);
+    bool ok = file && peaks;
+
+    // Decode once, scattering each chunk into its planes and folding it into
+    // the level-0 peaks
+    uint64_t frame = 0;
+    for (uint64_t i = 0; ok && i < peak_capacity * header.channels; i++) {
+        peaks[i] = (ClipPeak){FLT_MAX, -FLT_MAX};
+    }
+    while (ok && frame < capacity) {
+        uint64_t want = capacity - frame < BUILD_CHUNK_FRAMES ? capacity - frame : BUILD_CHUNK_FRAMES;
+        uint64_t decoded = source_read(&source, interleaved, want);
+        if (decoded == 0) {
+            break;
+        }
+        for (uint32_t ch = 0; ch < header.channels; ch++) {
+            ClipPeak* channel_peaks = peaks + ch * peak_capacity;
+            for (ma_uint64 i = 0; i < decoded; i++) {
+                float sample = interleaved[i * header.channels + ch];
+                ClipPeak* peak = &channel_peaks[(frame + i) / CLIP_CACHE_PEAK_FRAMES];
+                if (sample < peak->min) peak->min = sample;
+                if (sample > peak->max) peak->max = sample;
+                if (format == CLIP_CACHE_S16) {
+                    float clamped = sample < -1.0f ? -1.0f : (sample > 1.0f ? 1.0f : sample);
+                    ((int16_t*)plane_chunk)[i] = (int16_t)(clamped * 32767.0f);
+                } else {
+                    ((float*)plane_chunk)[i] = sample;
+                }
+            }
+            uint64_t offset = header.data_offset + header.plane_stride * ch + frame * sample_bytes(header.format);
+            ok = write_at(file, offset, plane_chunk, (size_t)decoded * sample_bytes(header.format));
+        }
+        frame += decoded;
+    }
+    header.frame_count = frame;
+
+    if (ok) {
+        // Pack the per-channel level-0 arrays to the pyramid's stride
+        layout_peaks(&header);
+        uint64_t count = header.peak_levels ? header.peak_count[0] : 0;
+        for (uint32_t ch = 1; ch < header.channels; ch++) {
+            memmove(peaks + ch * count, peaks + ch * peak_capacity, sizeof(ClipPeak) * count);
+        }
+        ok = write_peaks(file, &header, peaks);
+        ok = ok && write_at(file, 0, &header, sizeof(header));
+        ok = ok && fflush(file) == 0;
+        ok = ok && write_at(file, 0, CLIP_CACHE_MAGIC, 4);
+    }
+
+    if (file) fclose(file);
+    free(peaks);
+    free(interleaved);
+    free(plane_chunk);
+    source_close(&source);
+
+    if (ok && header.frame_count > 0) {
+        remove(cache_path);
+        ok = rename(temp_path, cache_path) == 0;
+    } else {
+        ok = false;
+    }
+    if (!ok) {
+        remove(temp_path);
+    }
+    return ok;
+}
+
+bool clip_cache_is_fresh(const char* cache_path, const char* source_path, uint32_t sample_rate) {
+    ClipCache cache;
+    if (!clip_cache_open(&cache, cache_path)) {
+        return false;
+    }
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    bool fresh = source_identity(source_path, &size, &mtime) && cache.header->source_size == size &&
+                 cache.header->source_mtime == mtime && cache.header->sample_rate == sample_rate;
+    clip_cache_close(&cache);
+    return fresh;
+}
+
+void clip_cache_path_for(const char* source_path, char* cache_path, size_t size) {
+    snprintf(cache_path, size, "%s%s", source_path, CLIP_CACHE_EXTENSION);
+}
+
+bool clip_cache_import(const char* source_path, uint32_t sample_rate, ClipCacheFormat format,
+                       char* cache_path, size_t size) {
+    clip_cache_path_for(source_path, cache_path, size);
+    if (clip_cache_is_fresh(cache_path, source_path, sample_rate)) {
+        return true;
+    }
+    return clip_cache_build(source_path, cache_path, sample_rate, format);
+}
+
+// ============================================================================
+// WRITING
+// ============================================================================
+
+static void plane_temp_path(const ClipCacheWriter* writer, uint32_t channel, char* path, size_t size) {
+    snprintf(path, size, "%s.plane%u.tmp", writer->cache_path, channel);
+}
+
+static void writer_release(ClipCacheWriter* writer) {
+    for (uint32_t ch = 0; ch < 2; ch++) {
+        if (writer->plane_files[ch]) {
+            fclose((FILE*)writer->plane_files[ch]);
+            char path[1024];
+            plane_temp_path(writer, ch, path, sizeof(path));
+            remove(path);
+        }
+        free(writer->peaks[ch]);
+    }
+    memset(writer, 0, sizeof(ClipCacheWriter));
+}
+
+bool clip_cache_writer_open(ClipCacheWriter* writer, const char* cache_path, uint32_t channels,
+                            uint32_t sample_rate) {
+    memset(writer, 0, sizeof(ClipCacheWriter));
+    if (channels < 1 || channels > 2) {
+        return false;
+    }
+    snprintf(writer->cache_path, sizeof(writer->cache_path), "%s", cache_path);
+    writer->channels = channels;
+    writer->sample_rate = sample_rate;
+    for (uint32_t ch = 0; ch < channels; ch++) {
+        char path[1024];
+        plane_temp_path(writer, ch, path, sizeof(path));
+        writer->plane_files[ch] = fopen(path, "w+b");
+        if (!writer->plane_files[ch]) {
+            writer_release(writer);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Make room for the level-0 buckets of `frames` frames
+static bool reserve_peaks(ClipCacheWriter* writer, uint64_t frames) {
+    uint64_t needed = bucket_count(frames, CLIP_CACHE_PEAK_FRAMES);
+    if (needed <= writer->peak_capacity) {
+        return true;
+    }
+    uint64_t capacity = writer->peak_capacity ? writer->peak_capacity : 256;
+    while (capacity < needed) capacity *= 2;
+    for (uint32_t ch = 0; ch < writer->channels; ch++) {
+        ClipPeak* grown = (ClipPeak*)realloc(writer->peaks[ch], sizeof(ClipPeak) * capacity);
+        if (!grown) {
+            return false;
+        }
+        for (uint64_t i = writer->peak_capacity; i < capacity; i++) {
+            grown[i] = (ClipPeak){FLT_MAX, -FLT_MAX};
+        }
+        writer->peaks[ch] = grown;
+    }
+    writer->peak_capacity = capacity;
+    return true;
+}
+
+bool clip_cache_writer_append(ClipCacheWriter* writer, const float* left, const float* right, uint32_t count) {
+    if (writer->failed || !reserve_peaks(writer, writer->frame_count + count)) {
+        writer->failed = true;
+        return false;
+    }
+    for (uint32_t ch = 0; ch < writer->channels; ch++) {
+        const float* samples = ch == 0 ? left : right;
+        ClipPeak* peaks = writer->peaks[ch];
+        for (uint32_t i = 0; i < count; i++) {
+            ClipPeak* peak = &peaks[(writer->frame_count + i) / CLIP_CACHE_PEAK_FRAMES];
+            if (samples[i] < peak->min) peak->min = samples[i];
+            if (samples[i] > peak->max) peak->max = samples[i];
+        }
+        if (fwrite(samples, sizeof(float), count, (FILE*)writer->plane_files[ch]) != count) {
+            writer->failed = true;
+            return false;
+        }
+    }
+    writer->frame_count += count;
+    return true;
+}
+
+// Copy a finished plane file to its place in the cache file
+static bool copy_plane(FILE* plane, FILE* file, uint64_t offset, uint64_t frames, float* chunk) {
+    if (fflush(plane) != 0 || cache_fseek(plane, 0, SEEK_SET) != 0 ||
+        cache_fseek(file, (int64_t)offset, SEEK_SET) != 0) {
+        return false;
+    }
+    for (uint64_t frame = 0; frame < frames; frame += BUILD_CHUNK_FRAMES) {
+        size_t count = frames - frame < BUILD_CHUNK_FRAMES ? (size_t)(frames - frame) : BUILD_CHUNK_FRAMES;
+        if (fread(chunk, sizeof(float), count, plane) != count || fwrite(chunk, sizeof(float), count, file) != count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool clip_cache_writer_finish(ClipCacheWriter* writer) {
+    ClipCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.version = CLIP_CACHE_VERSION;
+    header.format = CLIP_CACHE_F32;
+    header.channels = writer->channels;
+    header.sample_rate = writer->sample_rate;
+    header.frame_count = writer->frame_count;
+    header.data_offset = align_up(sizeof(ClipCacheHeader), CLIP_CACHE_PAGE_BYTES);
+    header.plane_stride = align_up(header.frame_count * sizeof(float), CLIP_CACHE_PAGE_BYTES);
+    layout_peaks(&header);
+
+    char temp_path[1024];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", writer->cache_path);
+    bool ok = !writer->failed && header.frame_count > 0;
+    FILE* file = ok ? fopen(temp_path, "wb") : NULL;
+    float* chunk = (float*)malloc(sizeof(float) * BUILD_CHUNK_FRAMES);
+    uint64_t count = header.peak_levels ? header.peak_count[0] : 0;
+    ClipPeak* peaks = (ClipPeak*)malloc(sizeof(ClipPeak) * (count ? count : 1) * header.channels);
+    ok = ok && file && chunk && peaks;
+
+    for (uint32_t ch = 0; ok && ch < header.channels; ch++) {
+        ok = copy_plane((FILE*)writer->plane_files[ch], file, header.data_offset + header.plane_stride * ch,
+                        header.frame_count, chunk);
+        memcpy(peaks + ch * count, writer->peaks[ch], sizeof(ClipPeak) * count);
+    }
+    ok = ok && write_peaks(file, &header, peaks);
+    ok = ok && write_at(file, 0, &header, sizeof(header));
+    ok = ok && fflush(file) == 0;
+    ok = ok && write_at(file, 0, CLIP_CACHE_MAGIC, 4);
+
+    if (file) fclose(file);
+    free(chunk);
+    free(peaks);
+    char cache_path[sizeof(writer->cache_path)];
+    memcpy(cache_path, writer->cache_path, sizeof(cache_path));
+    writer_release(writer);
+
+    if (ok) {
+        remove(cache_path);
+        ok = rename(temp_path, cache_path) == 0;
+    }
+    if (!ok) {
+        remove(temp_path);
+    }
+    return ok;
+}
+
+void clip_cache_writer_abort(ClipCacheWriter* writer) {
+    writer_release(writer);
+}
+
+// ============================================================================
+// MAPPING
+// ============================================================================
+
+static bool validate(const ClipCache* cache) {
+    if (cache->size < sizeof(ClipCacheHeader)) {
+        return false;
+    }
+    const ClipCacheHeader* header = (const ClipCacheHeader*)cache->base;
+    if (memcmp(header->magic, CLIP_CACHE_MAGIC, 4) != 0 || header->version != CLIP_CACHE_VERSION ||
+        header->channels < 1 || header->channels > 2 || header->format > CLIP_CACHE_S16 ||
+        header->peak_levels > CLIP_CACHE_MAX_PEAK_LEVELS) {
+        return false;
+    }
+    if (header->frame_count * sample_bytes(header->format) > header->plane_stride ||
+        header->data_offset + header->plane_stride * header->channels > cache->size) {
+        return false;
+    }
+    for (uint32_t level = 0; level < header->peak_levels; level++) {
+        uint64_t bytes = header->peak_count[level] * header->channels * sizeof(ClipPeak);
+        if (header->peak_offset[level] + bytes > cache->size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifdef _WIN32
+
+bool clip_cache_open(ClipCache* cache, const char* cache_path) {
+    memset(cache, 0, sizeof(ClipCache));
+    HANDLE file = CreateFileA(cache_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    }
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!view) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    cache->base = (const uint8_t*)view;
+    cache->size = (size_t)size.QuadPart;
+    cache->file = file;
+    cache->mapping = mapping;
+    if (!validate(cache)) {
+        clip_cache_close(cache);
+        return false;
+    }
+    cache->header = (const ClipCacheHeader*)cache->base;
+    return true;
+}
+
+void clip_cache_close(ClipCache* cache) {
+    if (cache->base) UnmapViewOfFile(cache->base);
+    if (cache->mapping) CloseHandle((HANDLE)cache->mapping);
+    if (cache->file) CloseHandle((HANDLE)cache->file);
+    memset(cache, 0, sizeof(ClipCache));
+}
+
+void clip_cache_prefetch(const ClipCache* cache, uint64_t frame, uint64_t count) {
+    // PrefetchVirtualMemory needs Windows 8 headers; the streamer's own reads
+    // fault pages in ahead of the audio thread anyway
+    (void)cache;
+    (void)frame;
+    (void)count;
+}
+
+#else
+
+bool clip_cache_open(ClipCache* cache, const char* cache_path) {
+    memset(cache, 0, sizeof(ClipCache));
+    int fd = open(cache_path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    void* view = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);      // The mapping keeps the file open
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    cache->base = (const uint8_t*)view;
+    cache->size = (size_t)info.st_size;
+    if (!validate(cache)) {
+        clip_cache_close(cache);
+        return false;
+    }
+    cache->header = (const ClipCacheHeader*)cache->base;
+    return true;
+}
+
+void clip_cache_close(ClipCache* cache) {
+    if (cache->base) munmap((void*)cache->base, cache->size);
+    memset(cache, 0, sizeof(ClipCache));
+}
+
+void clip_cache_prefetch(const ClipCache* cache, uint64_t frame, uint64_t count) {
+    uint64_t bytes_per_frame = sample_bytes(cache->header->format);
+    for (uint32_t ch = 0; ch < cache->header->channels; ch++) {
+        uint64_t start = cache->header->data_offset + cache->header->plane_stride * ch + frame * bytes_per_frame;
+        uint64_t page = start / CLIP_CACHE_PAGE_BYTES * CLIP_CACHE_PAGE_BYTES;
+        uint64_t end = start + count * bytes_per_frame;
+        if (end > cache->size) end = cache->size;
+        if (end > page) {
+            madvise((void*)(cache->base + page), (size_t)(end - page), MADV_WILLNEED);
+        }
+    }
+}
+
+#endif
+
+// ============================================================================
+// READING
+// ============================================================================
+
+static void read_plane(const ClipCache* cache, uint32_t channel, uint64_t frame, float* out, uint32_t count) {
+    if (cache->header->format == CLIP_CACHE_S16) {
+        const int16_t* plane = (const int16_t*)clip_cache_plane(cache, channel) + frame;
+        for (uint32_t i = 0; i < count; i++) {
+            out[i] = (float)plane[i] * (1.0f / 32767.0f);
+        }
+    } else {
+        memcpy(out, (const float*)clip_cache_plane(cache, channel) + frame, sizeof(float) * count);
+    }
+}
+
+void clip_cache_read(const ClipCache* cache, uint64_t frame, float* left, float* right, uint32_t count) {
+    read_plane(cache, 0, frame, left, count);
+    if (cache->header->channels > 1) {
+        read_plane(cache, 1, frame, right, count);
+    } else {
+        memcpy(right, left, sizeof(float) * count);
+    }
+}
+
+const ClipPeak* clip_cache_peaks(const ClipCache* cache, uint32_t level, uint32_t channel, uint64_t* count) {
+    const ClipCacheHeader* header = cache->header;
+    if (level >= header->peak_levels) {
+        *count = 0;
+        return NULL;
+    }
+    if (channel >= header->channels) {
+        channel = header->channels - 1;
+    }
+    *count = header->peak_count[level];
+    return (const ClipPeak*)(cache->base + header->peak_offset[level]) + (uint64_t)channel * header->peak_count[level];
+}
+
+uint32_t clip_cache_peak_level_for(const ClipCache* cache, double frames_per_pixel) {
+    uint32_t level = 0;
+    double width = CLIP_CACHE_PEAK_FRAMES * CLIP_CACHE_PEAK_FACTOR;
+    while (level + 1 < cache->header->peak_levels && width <= frames_per_pixel) {
+        level++;
+        width *= CLIP_CACHE_PEAK_FACTOR;
+    }
+    return level;
+}
@@ -0,0 +1,142 @@
+// clip_cache.h - Memory-mapped native clip cache
+// Imported clips are decoded once into a cache file next to the source:
+// a small header, one planar plane per channel (float32 or int16, already at
+// the engine rate: sources recorded at another rate go through the sinc
+// resampler once, here) and min/max peak pyramids for waveform drawing. Cache
+// files are opened with mmap, so the streamer and the UI read samples and
+// peaks straight from the page cache instead of running a decoder again.
+//
+// Layout (all offsets from the start of the file, planes page aligned):
+//   ClipCacheHeader | pad | plane 0 | plane 1 | peaks[level][channel][count]
+#pragma once
+#ifndef CLIP_CACHE_H
+#define CLIP_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CLIP_CACHE_MAGIC "ADWC"
+#define CLIP_CACHE_VERSION 2
+#define CLIP_CACHE_EXTENSION ".adwc"
+#define CLIP_CACHE_PAGE_BYTES 4096
+#define CLIP_CACHE_PEAK_FRAMES 256      // Frames per bucket in peak level 0
+#define CLIP_CACHE_PEAK_FACTOR 4        // Buckets merged per level above
+#define CLIP_CACHE_MAX_PEAK_LEVELS 8
+
+typedef enum {
+    CLIP_CACHE_F32 = 0,
+    CLIP_CACHE_S16
+} ClipCacheFormat;
+
+typedef struct {
+    float min;
+    float max;
+} ClipPeak;
+
+typedef struct {
+    char magic[4];              // Written last, so a torn file never validates
+    uint32_t version;
+    uint32_t format;            // ClipCacheFormat
+    uint32_t channels;          // 1 or 2
+    uint32_t sample_rate;
+    uint32_t peak_levels;
+    uint64_t frame_count;
+    uint64_t source_size;       // Source file identity, for staleness checks
+    int64_t source_mtime;
+    uint64_t data_offset;       // Plane 0
+    uint64_t plane_stride;      // Bytes from one plane to the next
+    uint64_t peak_offset[CLIP_CACHE_MAX_PEAK_LEVELS];
+    uint64_t peak_count[CLIP_CACHE_MAX_PEAK_LEVELS];    // Buckets per channel
+} ClipCacheHeader;
+
+typedef struct {
+    const uint8_t* base;        // Mapped file, read only
+    size_t size;
+    const ClipCacheHeader* header;
+    void* file;                 // Platform handles
+    void* mapping;
+} ClipCache;
+
+// ============================================================================
+// BUILDING (control thread, decodes the whole source once)
+// ============================================================================
+
+// Decode `source_path` at `sample_rate` into a cache file at `cache_path`.
+// The file is written to a temporary name and renamed into place.
+bool clip_cache_build(const char* source_path, const char* cache_path, uint32_t sample_rate,
+                      ClipCacheFormat format);
+
+// True if `cache_path` holds a valid cache of the current `source_path`
+bool clip_cache_is_fresh(const char* cache_path, const char* source_path, uint32_t sample_rate);
+
+// Default cache location for a source: the source path plus CLIP_CACHE_EXTENSION
+void clip_cache_path_for(const char* source_path, char* cache_path, size_t size);
+
+// Build the cache for a source unless a fresh one exists; writes its path
+bool clip_cache_import(const char* source_path, uint32_t sample_rate, ClipCacheFormat format,
+                       char* cache_path, size_t size);
+
+// ============================================================================
+// WRITING (recording, one thread; the length is unknown up front)
+// ============================================================================
+
+// Appended frames go to one raw float plane file per channel, in whatever
+// chunks the caller hands over, while the level-0 peaks are folded in
+// memory. Finishing lays the planes out as a regular f32 cache file, writes
+// the peak pyramid and renames it into place.
+typedef struct {
+    char cache_path[512];
+    void* plane_files[2];       // FILE*, "<cache_path>.plane<n>.tmp"
+    uint32_t channels;
+    uint32_t sample_rate;
+    uint64_t frame_count;
+    ClipPeak* peaks[2];         // Level 0 per channel, grown as frames arrive
+    uint64_t peak_capacity;     // Buckets allocated per channel
+    bool failed;                // A write failed; finishing gives up
+} ClipCacheWriter;
+
+bool clip_cache_writer_open(ClipCacheWriter* writer, const char* cache_path, uint32_t channels,
+                            uint32_t sample_rate);
+
+// Append planar frames (right is ignored for mono)
+bool clip_cache_writer_append(ClipCacheWriter* writer, const float* left, const float* right, uint32_t count);
+
+// Write the cache file and release the writer. False (and no file) if
+// anything failed or nothing was appended.
+bool clip_cache_writer_finish(ClipCacheWriter* writer);
+
+// Release the writer and delete its temporary files
+void clip_cache_writer_abort(ClipCacheWriter* writer);
+
+// ============================================================================
+// READING (any thread once open)
+// ============================================================================
+
+bool clip_cache_open(ClipCache* cache, const char* cache_path);
+void clip_cache_close(ClipCache* cache);
+
+static inline uint64_t clip_cache_frame_count(const ClipCache* cache) {
+    return cache->header->frame_count;
+}
+
+// First sample of a channel plane (float or int16 per header->format)
+static inline const void* clip_cache_plane(const ClipCache* cache, uint32_t channel) {
+    return cache->base + cache->header->data_offset + cache->header->plane_stride * channel;
+}
+
+// Convert `count` frames starting at `frame` to planar float. Mono caches
+// fill both outputs. The range must lie inside the clip.
+void clip_cache_read(const ClipCache* cache, uint64_t frame, float* left, float* right, uint32_t count);
+
+// Ask the OS to page in a range ahead of reading it (a hint, may be a no-op)
+void clip_cache_prefetch(const ClipCache* cache, uint64_t frame, uint64_t count);
+
+// Peak buckets of one level/channel; bucket i covers
+// CLIP_CACHE_PEAK_FRAMES * CLIP_CACHE_PEAK_FACTOR^level frames
+const ClipPeak* clip_cache_peaks(const ClipCache* cache, uint32_t level, uint32_t channel, uint64_t* count);
+
+// Coarsest level whose buckets are no wider than `frames_per_pixel`
+uint32_t clip_cache_peak_level_for(const ClipCache* cache, double frames_per_pixel);
+
+#endif // CLIP_CACHE_H
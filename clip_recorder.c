@@ -0,0 +1,216 @@
+#include "clip_recorder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// WRITER THREAD
+// ============================================================================
+
+// Append queued frames to the clip file. Full chunks only, unless
+// `everything` (the take is finishing); a partial chunk waits a poll.
+static void drain(ClipRecording* take, bool everything) {
+    size_t capacity = take->mask + 1;
+    for (;;) {
+        size_t read = atomic_load_explicit(&take->read_pos, memory_order_relaxed);
+        size_t write = atomic_load_explicit(&take->write_pos, memory_order_acquire);
+        size_t available = write - read;
+
+        // Straight out of the ring, up to its end
+        size_t offset = read & take->mask;
+        size_t count = CLIP_RECORD_CHUNK_FRAMES;
+        if (count > capacity - offset) count = capacity - offset;
+        if (available < count) {
+            if (!everything || available == 0) {
+                break;
+            }
+            count = available;
+        }
+
+        // After a failed write the frames are still consumed, so the audio
+        // side keeps its room; finishing reports the failure
+        if (!take->writer.failed) {
+            clip_cache_writer_append(&take->writer, take->ring[0] + offset, take->ring[1] + offset,
+                                     (uint32_t)count);
+        }
+        atomic_store_explicit(&take->read_pos, read + count, memory_order_release);
+    }
+}
+
+static void finish_take(ClipRecording* take) {
+    drain(take, true);
+    take->ok = clip_cache_writer_finish(&take->writer);
+    atomic_store_explicit(&take->finished, true, memory_order_release);
+}
+
+static void writer_main(void* user_data) {
+    ClipRecorder* recorder = (ClipRecorder*)user_data;
+
+    while (atomic_load(&recorder->running)) {
+        ma_mutex_lock(&recorder->lock);
+        for (int i = 0; i < recorder->take_count; i++) {
+            ClipRecording* take = recorder->takes[i];
+            if (atomic_load_explicit(&take->finished, memory_order_relaxed)) {
+                continue;
+            }
+            if (atomic_load_explicit(&take->stop_requested, memory_order_acquire)) {
+                finish_take(take);
+            } else {
+                drain(take, false);
+            }
+        }
+        ma_mutex_unlock(&recorder->lock);
+
+        engine_thread_sleep_ms(CLIP_RECORD_POLL_MS);
+    }
+}
+
+bool clip_recorder_start(ClipRecorder* recorder) {
+    memset(recorder, 0, sizeof(ClipRecorder));
+    if (ma_mutex_init(&recorder->lock) != MA_SUCCESS) {
+        return false;
+    }
+    atomic_store(&recorder->running, true);
+    if (!engine_thread_start(&recorder->thread, writer_main, recorder, ENGINE_THREAD_PRIORITY_LOW, -1)) {
+        atomic_store(&recorder->running, false);
+        ma_mutex_uninit(&recorder->lock);
+        return false;
+    }
+    recorder->started = true;
+    return true;
+}
+
+void clip_recorder_stop(ClipRecorder* recorder) {
+    if (!recorder->started) {
+        return;
+    }
+    atomic_store(&recorder->running, false);
+    engine_thread_join(&recorder->thread);
+
+    // Nothing writes any more: finish whatever was still recording
+    for (int i = 0; i < recorder->take_count; i++) {
+        if (!atomic_load(&recorder->takes[i]->finished)) {
+            finish_take(recorder->takes[i]);
+        }
+    }
+    ma_mutex_uninit(&recorder->lock);
+    recorder->started = false;
+}
+
+// ============================================================================
+// TAKES
+// ============================================================================
+
+static void take_free(ClipRecording* take) {
+    if (!atomic_load(&take->finished)) {
+        clip_cache_writer_abort(&take->writer);
+    }
+    free(take->ring[0]);
+    free(take->ring[1]);
+    free(take);
+}
+
+ClipRecording* clip_recording_open(ClipRecorder* recorder, const char* path, uint32_t sample_rate) {
+    if (!recorder->started) {
+        return NULL;
+    }
+    ClipRecording* take = (ClipRecording*)calloc(1, sizeof(ClipRecording));
+    if (!take) {
+        return NULL;
+    }
+    snprintf(take->path, sizeof(take->path), "%s", path);
+    take->mask = CLIP_RECORD_RING_FRAMES - 1;
+    take->ring[0] = (float*)calloc(CLIP_RECORD_RING_FRAMES, sizeof(float));
+    take->ring[1] = (float*)calloc(CLIP_RECORD_RING_FRAMES, sizeof(float));
+    if (!take->ring[0] || !take->ring[1] || !clip_cache_writer_open(&take->writer, path, 2, sample_rate)) {
+        atomic_store(&take->finished, true);    // Nothing for the writer to abort
+        take_free(take);
+        return NULL;
+    }
+
+    ma_mutex_lock(&recorder->lock);
+    bool registered = recorder->take_count < CLIP_RECORDER_MAX_TAKES;
+    if (registered) {
+        recorder->takes[recorder->take_count++] = take;
+    }
+    ma_mutex_unlock(&recorder->lock);
+
+    if (!registered) {
+        take_free(take);
+        return NULL;
+    }
+    return take;
+}
+
+bool clip_recording_finish(ClipRecording* take) {
+    atomic_store_explicit(&take->stop_requested, true, memory_order_release);
+    while (!atomic_load_explicit(&take->finished, memory_order_acquire)) {
+        engine_thread_sleep_ms(1);
+    }
+    return take->ok;
+}
+
+void clip_recording_close(ClipRecorder* recorder, ClipRecording* take) {
+    if (!take) {
+        return;
+    }
+    if (recorder->started) {
+        ma_mutex_lock(&recorder->lock);
+    }
+    for (int i = 0; i < recorder->take_count; i++) {
+        if (recorder->takes[i] == take) {
+            recorder->takes[i] = recorder->takes[--recorder->take_count];
+            break;
+        }
+    }
+    if (recorder->started) {
+        ma_mutex_unlock(&recorder->lock);
+    }
+    take_free(take);
+}
+
+void clip_recording_get_stats(ClipRecording* take, ClipRecordingStats* stats) {
+    size_t write = atomic_load(&take->write_pos);
+    size_t read = atomic_load(&take->read_pos);
+    stats->start_frame = atomic_load(&take->start_frame);
+    stats->written_frames = read;
+    stats->buffered_frames = write - read;
+    stats->dropped_frames = atomic_load(&take->dropped_frames);
+}
+
+// ============================================================================
+// AUDIO THREAD
+// ============================================================================
+
+void clip_recording_write(ClipRecording* take, const float* left, const float* right, uint32_t frame_count,
+                          uint64_t frame) {
+    if (!atomic_load_explicit(&take->started, memory_order_relaxed)) {
+        atomic_store_explicit(&take->start_frame, frame, memory_order_relaxed);
+        atomic_store_explicit(&take->started, true, memory_order_release);
+    }
+
+    size_t capacity = take->mask + 1;
+    size_t write = atomic_load_explicit(&take->write_pos, memory_order_relaxed);
+    size_t read = atomic_load_explicit(&take->read_pos, memory_order_acquire);
+    while (take->blocking && capacity - (write - read) < frame_count &&
+           !atomic_load_explicit(&take->finished, memory_order_relaxed)) {
+        engine_thread_sleep_ms(1);
+        read = atomic_load_explicit(&take->read_pos, memory_order_acquire);
+    }
+    size_t space = capacity - (write - read);
+    uint32_t count = space < frame_count ? (uint32_t)space : frame_count;
+    if (count < frame_count) {
+        atomic_fetch_add_explicit(&take->dropped_frames, frame_count - count, memory_order_relaxed);
+    }
+    if (count == 0) {
+        return;
+    }
+
+    size_t offset = write & take->mask;
+    size_t first = capacity - offset < count ? capacity - offset : count;
+    memcpy(take->ring[0] + offset, left, sizeof(float) * first);
+    memcpy(take->ring[1] + offset, right, sizeof(float) * first);
+    memcpy(take->ring[0], left + first, sizeof(float) * (count - first));
+    memcpy(take->ring[1], right + first, sizeof(float) * (count - first));
+    atomic_store_explicit(&take->write_pos, write + count, memory_order_release);
+}
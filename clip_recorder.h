@@ -0,0 +1,111 @@
+// clip_recorder.h - Record-to-disk takes through a writer thread
+// A ClipRecording captures one track's input into a lock-free SPSC frame
+// ring (one plane per channel): the audio thread only copies frames into
+// RAM, the writer thread drains the ring in CLIP_RECORD_CHUNK_FRAMES chunks
+// (aligned to the ring, so every write is one large contiguous run) and
+// appends them to a clip cache writer (see clip_cache.h). The finished take
+// is a regular native clip file, ready for clip_stream_open_cache().
+//
+// The audio thread never touches the filesystem and never waits; frames
+// that find the ring full are counted as dropped. The ring holds
+// CLIP_RECORD_RING_FRAMES, far more than the writer's poll interval, so
+// only a stalled disk drops audio.
+#pragma once
+#ifndef CLIP_RECORDER_H
+#define CLIP_RECORDER_H
+
+#include "clip_cache.h"
+#include "engine_thread.h"
+#include "spsc_ring.h"
+#include "vendor/miniaudio/miniaudio.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CLIP_RECORD_RING_FRAMES (1u << 18)  // ~5.5 s at 48 kHz, must be a power of two
+#define CLIP_RECORD_CHUNK_FRAMES 16384      // Frames per disk write (64 KB per plane)
+#define CLIP_RECORD_POLL_MS 5               // Writer wake-up interval
+#define CLIP_RECORDER_MAX_TAKES 64
+
+typedef struct {
+    char path[512];
+    ClipCacheWriter writer;     // Writer thread only
+
+    // Frame ring, one plane per channel. write_pos is published by the
+    // audio thread, read_pos by the writer.
+    float* ring[2];
+    size_t mask;
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t write_pos;
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t read_pos;
+    bool blocking;              // Offline: the audio side waits for room
+
+    // Audio -> control
+    _Alignas(SPSC_CACHE_LINE) _Atomic uint64_t start_frame;  // Transport frame of the first sample
+    atomic_bool started;
+    _Atomic uint64_t dropped_frames;
+
+    // Control -> writer -> control
+    atomic_bool stop_requested;
+    atomic_bool finished;       // File written (or given up); the writer is done with it
+    bool ok;                    // Valid once finished
+} ClipRecording;
+
+typedef struct {
+    uint64_t start_frame;
+    uint64_t written_frames;    // Flushed to disk so far
+    uint64_t buffered_frames;
+    uint64_t dropped_frames;
+} ClipRecordingStats;
+
+typedef struct {
+    ma_mutex lock;              // Guards the registry (control <-> writer)
+    ClipRecording* takes[CLIP_RECORDER_MAX_TAKES];
+    int take_count;
+    atomic_bool running;
+    bool started;
+    EngineThread thread;
+} ClipRecorder;
+
+// ============================================================================
+// WRITER THREAD (control thread)
+// ============================================================================
+
+bool clip_recorder_start(ClipRecorder* recorder);
+
+// Finishes every take still registered, then stops the thread
+void clip_recorder_stop(ClipRecorder* recorder);
+
+// ============================================================================
+// TAKES (control thread)
+// ============================================================================
+
+// Create the take's files at `path` and hand it to the writer. Returns
+// NULL on failure.
+ClipRecording* clip_recording_open(ClipRecorder* recorder, const char* path, uint32_t sample_rate);
+
+// Ask the writer to flush what is buffered and finish the file, and wait
+// until it has. Frames written afterwards are ignored. Returns whether the
+// file was written.
+bool clip_recording_finish(ClipRecording* take);
+
+// Unregister and free. The audio thread must no longer reference the take.
+void clip_recording_close(ClipRecorder* recorder, ClipRecording* take);
+
+void clip_recording_get_stats(ClipRecording* take, ClipRecordingStats* stats);
+
+// Offline rendering: make writes wait for the writer instead of dropping
+static inline void clip_recording_set_blocking(ClipRecording* take, bool blocking) {
+    take->blocking = blocking;
+}
+
+// ============================================================================
+// AUDIO THREAD
+// ============================================================================
+
+// Queue frame_count planar frames that start at transport frame `frame`.
+// Never blocks (unless set blocking); what does not fit is dropped and
+// counted.
+void clip_recording_write(ClipRecording* take, const float* left, const float* right, uint32_t frame_count,
+                          uint64_t frame);
+
+#endif // CLIP_RECORDER_H
@@ -0,0 +1,328 @@
+#include "clip_stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// STREAMER THREAD
+// ============================================================================
+
+// Pull up to `count` frames from the source into the ring planes at
+// `offset`. Returns the frames produced; fewer means the source ended.
+static size_t source_read(ClipStream* stream, size_t offset, size_t count) {
+    float* left = stream->ring[0] + offset;
+    float* right = stream->ring[1] + offset;
+
+    if (stream->cached) {
+        uint64_t remaining = stream->length_frames - stream->cache_frame;
+        size_t produced = remaining < count ? (size_t)remaining : count;
+        clip_cache_read(&stream->cache, stream->cache_frame, left, right, (uint32_t)produced);
+        stream->cache_frame += produced;
+        clip_cache_prefetch(&stream->cache, stream->cache_frame, CLIP_STREAM_CHUNK_FRAMES * 4);
+        return produced;
+    }
+
+    ma_uint64 decoded = 0;
+    ma_decoder_read_pcm_frames(&stream->decoder, stream->decode_scratch, count, &decoded);
+    for (ma_uint64 i = 0; i < decoded; i++) {
+        left[i] = stream->decode_scratch[i * 2];
+        right[i] = stream->decode_scratch[i * 2 + 1];
+    }
+    return (size_t)decoded;
+}
+
+static void source_seek(ClipStream* stream, uint64_t frame) {
+    if (stream->cached) {
+        stream->cache_frame = frame;
+    } else {
+        ma_decoder_seek_to_pcm_frame(&stream->decoder, frame);
+    }
+}
+
+// Handle a pending seek: reposition the source and tell the reader to drop
+// everything queued so far
+static void service_seek(ClipStream* stream) {
+    unsigned sequence = atomic_load_explicit(&stream->seek_sequence, memory_order_acquire);
+    if (sequence == stream->seek_seen) {
+        return;
+    }
+    stream->seek_seen = sequence;
+
+    uint64_t frame = atomic_load_explicit(&stream->seek_frame, memory_order_relaxed);
+    if (stream->length_frames > 0 && frame >= stream->length_frames) {
+        frame = stream->loop ? frame % stream->length_frames : stream->length_frames;
+    }
+    source_seek(stream, frame);
+    atomic_store_explicit(&stream->at_end, false, memory_order_relaxed);
+
+    size_t write = atomic_load_explicit(&stream->write_pos, memory_order_relaxed);
+    atomic_store_explicit(&stream->flush_frame, frame, memory_order_relaxed);
+    atomic_store_explicit(&stream->flush_pos, write, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stream->flush_epoch, 1, memory_order_release);
+}
+
+// Fill the ring (or until the clip ends). Returns true if any frames were
+// produced.
+static bool refill(ClipStream* stream) {
+    bool produced = false;
+    bool rewound = false;
+    size_t capacity = stream->mask + 1;
+
+    while (!atomic_load_explicit(&stream->at_end, memory_order_relaxed)) {
+        size_t write = atomic_load_explicit(&stream->write_pos, memory_order_relaxed);
+        size_t read = atomic_load_explicit(&stream->read_pos, memory_order_acquire);
+        size_t space = capacity - (write - read);
+        if (space < CLIP_STREAM_CHUNK_FRAMES) {
+            break;
+        }
+
+        // Write straight into the ring, up to its end
+        size_t offset = write & stream->mask;
+        size_t count = CLIP_STREAM_CHUNK_FRAMES;
+        if (count > capacity - offset) count = capacity - offset;
+
+        size_t got = source_read(stream, offset, count);
+        if (got > 0) {
+            atomic_store_explicit(&stream->write_pos, write + got, memory_order_release);
+            produced = true;
+            rewound = false;
+        }
+        if (got < count) {
+            // Loop back to the start, unless the source is empty or broken
+            if (stream->loop && stream->length_frames > 0 && !(got == 0 && rewound)) {
+                source_seek(stream, 0);
+                rewound = true;
+            } else {
+                atomic_store_explicit(&stream->at_end, true, memory_order_release);
+            }
+        }
+    }
+    return produced;
+}
+
+static void streamer_main(void* user_data) {
+    ClipStreamer* streamer = (ClipStreamer*)user_data;
+
+    while (atomic_load(&streamer->running)) {
+        ma_mutex_lock(&streamer->lock);
+        for (int i = 0; i < streamer->stream_count; i++) {
+            service_seek(streamer->streams[i]);
+            refill(streamer->streams[i]);
+        }
+        ma_mutex_unlock(&streamer->lock);
+
+        engine_thread_sleep_ms(CLIP_STREAM_POLL_MS);
+    }
+}
+
+bool clip_streamer_start(ClipStreamer* streamer) {
+    memset(streamer, 0, sizeof(ClipStreamer));
+    if (ma_mutex_init(&streamer->lock) != MA_SUCCESS) {
+        return false;
+    }
+    atomic_store(&streamer->running, true);
+    if (!engine_thread_start(&streamer->thread, streamer_main, streamer, ENGINE_THREAD_PRIORITY_LOW, -1)) {
+        atomic_store(&streamer->running, false);
+        ma_mutex_uninit(&streamer->lock);
+        return false;
+    }
+    streamer->started = true;
+    return true;
+}
+
+void clip_streamer_stop(ClipStreamer* streamer) {
+    if (!streamer->started) {
+        return;
+    }
+    atomic_store(&streamer->running, false);
+    engine_thread_join(&streamer->thread);
+    ma_mutex_uninit(&streamer->lock);
+    streamer->started = false;
+}
+
+// ============================================================================
+// STREAMS
+// ============================================================================
+
+static ClipStream* stream_alloc(const char* path, bool loop) {
+    ClipStream* stream = (ClipStream*)calloc(1, sizeof(ClipStream));
+    if (!stream) {
+        return NULL;
+    }
+    snprintf(stream->path, sizeof(stream->path), "%s", path);
+    stream->loop = loop;
+    stream->mask = CLIP_STREAM_RING_FRAMES - 1;
+    stream->ring[0] = (float*)calloc(CLIP_STREAM_RING_FRAMES, sizeof(float));
+    stream->ring[1] = (float*)calloc(CLIP_STREAM_RING_FRAMES, sizeof(float));
+    if (!stream->ring[0] || !stream->ring[1]) {
+        free(stream->ring[0]);
+        free(stream->ring[1]);
+        free(stream);
+        return NULL;
+    }
+    return stream;
+}
+
+static void stream_free_buffers(ClipStream* stream) {
+    free(stream->decode_scratch);
+    free(stream->ring[0]);
+    free(stream->ring[1]);
+    free(stream);
+}
+
+static void stream_free(ClipStream* stream) {
+    if (stream->cached) {
+        clip_cache_close(&stream->cache);
+    } else {
+        ma_decoder_uninit(&stream->decoder);
+    }
+    stream_free_buffers(stream);
+}
+
+// Prefill, then hand the stream to the streamer thread
+static ClipStream* stream_register(ClipStreamer* streamer, ClipStream* stream) {
+    // Prefill before the stream becomes visible so playback starts at once
+    refill(stream);
+
+    ma_mutex_lock(&streamer->lock);
+    bool registered = streamer->stream_count < CLIP_STREAMER_MAX_STREAMS;
+    if (registered) {
+        streamer->streams[streamer->stream_count++] = stream;
+    }
+    ma_mutex_unlock(&streamer->lock);
+
+    if (!registered) {
+        stream_free(stream);
+        return NULL;
+    }
+    return stream;
+}
+
+ClipStream* clip_stream_open(ClipStreamer* streamer, const char* path, uint32_t sample_rate, bool loop) {
+    ClipStream* stream = stream_alloc(path, loop);
+    if (!stream) {
+        return NULL;
+    }
+
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 2, sample_rate);
+    if (ma_decoder_init_file(path, &config, &stream->decoder) != MA_SUCCESS) {
+        stream_free_buffers(stream);
+        return NULL;
+    }
+    stream->decode_scratch = (float*)malloc(sizeof(float) * CLIP_STREAM_CHUNK_FRAMES * 2);
+    if (!stream->decode_scratch) {
+        stream_free(stream);
+        return NULL;
+    }
+    ma_uint64 length = 0;
+    if (ma_decoder_get_length_in_pcm_frames(&stream->decoder, &length) == MA_SUCCESS) {
+        stream->length_frames = length;
+    }
+    return stream_register(streamer, stream);
+}
+
+ClipStream* clip_stream_open_cache(ClipStreamer* streamer, const char* cache_path, bool loop) {
+    ClipStream* stream = stream_alloc(cache_path, loop);
+    if (!stream) {
+        return NULL;
+    }
+    stream->cached = true;
+    if (!clip_cache_open(&stream->cache, cache_path)) {
+        stream_free_buffers(stream);
+        return NULL;
+    }
+    stream->length_frames = clip_cache_frame_count(&stream->cache);
+    return stream_register(streamer, stream);
+}
+
+void clip_stream_close(ClipStreamer* streamer, ClipStream* stream) {
+    if (!stream) {
+        return;
+    }
+    if (streamer->started) {
+        ma_mutex_lock(&streamer->lock);
+    }
+    for (int i = 0; i < streamer->stream_count; i++) {
+        if (streamer->streams[i] == stream) {
+            streamer->streams[i] = streamer->streams[--streamer->stream_count];
+            break;
+        }
+    }
+    if (streamer->started) {
+        ma_mutex_unlock(&streamer->lock);
+    }
+    stream_free(stream);
+}
+
+void clip_stream_seek(ClipStream* stream, uint64_t frame) {
+    atomic_store_explicit(&stream->seek_frame, frame, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stream->seek_sequence, 1, memory_order_release);
+}
+
+void clip_stream_get_stats(ClipStream* stream, ClipStreamStats* stats) {
+    size_t write = atomic_load(&stream->write_pos);
+    size_t read = atomic_load(&stream->read_pos);
+    stats->length_frames = stream->length_frames;
+    stats->playhead_frame = atomic_load(&stream->playhead_frame);
+    stats->buffered_frames = write - read;
+    stats->underrun_frames = atomic_load(&stream->underrun_frames);
+    stats->underrun_events = atomic_load(&stream->underrun_events);
+}
+
+// ============================================================================
+// AUDIO THREAD
+// ============================================================================
+
+void clip_stream_read(ClipStream* stream, float* left, float* right, uint32_t frame_count) {
+    size_t read = atomic_load_explicit(&stream->read_pos, memory_order_relaxed);
+    uint64_t playhead = atomic_load_explicit(&stream->playhead_frame, memory_order_relaxed);
+
+    // A seek happened: skip to the first frame decoded after it. The gap
+    // until the streamer catches up is expected, not an underrun.
+    unsigned epoch = atomic_load_explicit(&stream->flush_epoch, memory_order_acquire);
+    if (epoch != stream->flush_seen) {
+        stream->flush_seen = epoch;
+        read = atomic_load_explicit(&stream->flush_pos, memory_order_relaxed);
+        playhead = atomic_load_explicit(&stream->flush_frame, memory_order_relaxed);
+        stream->seeking = true;
+    }
+
+    // at_end is read before write_pos so "ended" is never seen without the
+    // final frames it covers
+    bool ended = atomic_load_explicit(&stream->at_end, memory_order_acquire);
+    size_t write = atomic_load_explicit(&stream->write_pos, memory_order_acquire);
+    while (stream->blocking && write - read < frame_count && !ended) {
+        engine_thread_sleep_ms(1);
+        ended = atomic_load_explicit(&stream->at_end, memory_order_acquire);
+        write = atomic_load_explicit(&stream->write_pos, memory_order_acquire);
+    }
+    size_t available = write - read;
+    uint32_t count = available < frame_count ? (uint32_t)available : frame_count;
+
+    // At most two contiguous runs per plane
+    size_t offset = read & stream->mask;
+    uint32_t first = count;
+    if (first > stream->mask + 1 - offset) first = (uint32_t)(stream->mask + 1 - offset);
+    memcpy(left, stream->ring[0] + offset, sizeof(float) * first);
+    memcpy(right, stream->ring[1] + offset, sizeof(float) * first);
+    memcpy(left + first, stream->ring[0], sizeof(float) * (count - first));
+    memcpy(right + first, stream->ring[1], sizeof(float) * (count - first));
+    if (count < frame_count) {
+        memset(left + count, 0, sizeof(float) * (frame_count - count));
+        memset(right + count, 0, sizeof(float) * (frame_count - count));
+        if (!ended && !stream->seeking) {
+            atomic_fetch_add_explicit(&stream->underrun_frames, frame_count - count, memory_order_relaxed);
+            atomic_fetch_add_explicit(&stream->underrun_events, 1, memory_order_relaxed);
+        }
+    }
+
+    if (count > 0) {
+        stream->seeking = false;
+    }
+
+    atomic_store_explicit(&stream->read_pos, read + count, memory_order_release);
+
+    playhead += count;
+    if (stream->loop && stream->length_frames > 0) playhead %= stream->length_frames;
+    atomic_store_explicit(&stream->playhead_frame, playhead, memory_order_relaxed);
+}
@@ -0,0 +1,131 @@
+// clip_stream.h - Disk-streamed audio clips
+// A ClipStream plays one audio file through a lock-free SPSC frame ring:
+// the streamer thread decodes ahead of the playhead with miniaudio's
+// decoders (converted to f32 stereo at the engine rate), the audio thread
+// only copies frames out of RAM. Files are never loaded whole; each stream
+// holds CLIP_STREAM_RING_FRAMES of audio at a time. Missing frames at read
+// time are counted as underruns and played as silence.
+//
+// A stream reads either through a decoder or from a memory-mapped clip
+// cache (see clip_cache.h); with a cache, refills are plain copies out of
+// the page cache and seeks cost nothing.
+//
+// Seeks are requested by the control thread and executed by the streamer,
+// which repositions the decoder and bumps a flush epoch; the reader then
+// discards everything queued before the flush point.
+#pragma once
+#ifndef CLIP_STREAM_H
+#define CLIP_STREAM_H
+
+#include "clip_cache.h"
+#include "engine_thread.h"
+#include "spsc_ring.h"
+#include "vendor/miniaudio/miniaudio.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CLIP_STREAM_RING_FRAMES (1u << 16)  // ~1.4 s at 48 kHz, must be a power of two
+#define CLIP_STREAM_CHUNK_FRAMES 4096       // Frames decoded per refill step
+#define CLIP_STREAM_POLL_MS 5               // Streamer wake-up interval
+#define CLIP_STREAMER_MAX_STREAMS 64
+
+typedef struct {
+    char path[512];
+    uint64_t length_frames;     // Source length at the engine rate
+    bool loop;
+
+    // Source (streamer thread only)
+    bool cached;
+    ma_decoder decoder;         // When !cached
+    float* decode_scratch;      // Interleaved decoder output
+    ClipCache cache;            // When cached
+    uint64_t cache_frame;       // Next cache frame to copy
+    uint32_t seek_seen;
+
+    // Frame ring, one plane per channel. write_pos is published by the
+    // streamer, read_pos by the audio thread.
+    float* ring[2];
+    size_t mask;
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t write_pos;
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t read_pos;
+    uint32_t flush_seen;        // Audio thread only
+    bool seeking;               // Audio thread only: waiting for post-seek audio
+    bool blocking;              // Offline: the reader waits for the streamer
+
+    // Control -> streamer
+    _Alignas(SPSC_CACHE_LINE) _Atomic uint64_t seek_frame;
+    atomic_uint seek_sequence;
+
+    // Streamer -> audio
+    atomic_size_t flush_pos;    // Ring frames before this are stale after a seek
+    _Atomic uint64_t flush_frame; // Source frame the flush point starts at
+    atomic_uint flush_epoch;
+    atomic_bool at_end;         // Decoded to the end (not looping)
+
+    // Audio -> control
+    _Atomic uint64_t playhead_frame;
+    _Atomic uint64_t underrun_frames;
+    _Atomic uint64_t underrun_events;
+} ClipStream;
+
+typedef struct {
+    uint64_t length_frames;
+    uint64_t playhead_frame;
+    uint64_t buffered_frames;
+    uint64_t underrun_frames;
+    uint64_t underrun_events;
+} ClipStreamStats;
+
+typedef struct {
+    ma_mutex lock;              // Guards the registry (control <-> streamer)
+    ClipStream* streams[CLIP_STREAMER_MAX_STREAMS];
+    int stream_count;
+    atomic_bool running;
+    bool started;
+    EngineThread thread;
+} ClipStreamer;
+
+// ============================================================================
+// STREAMER (control thread)
+// ============================================================================
+
+bool clip_streamer_start(ClipStreamer* streamer);
+void clip_streamer_stop(ClipStreamer* streamer);
+
+// ============================================================================
+// STREAMS (control thread)
+// ============================================================================
+
+// Open a file and register it with the streamer, which starts prefilling
+// right away. Returns NULL on failure.
+ClipStream* clip_stream_open(ClipStreamer* streamer, const char* path, uint32_t sample_rate, bool loop);
+
+// Stream from a clip cache file instead of decoding (clip_cache_import)
+ClipStream* clip_stream_open_cache(ClipStreamer* streamer, const char* cache_path, bool loop);
+
+// Unregister and free. The audio thread must no longer reference the stream.
+void clip_stream_close(ClipStreamer* streamer, ClipStream* stream);
+
+// Ask the streamer to continue from `frame` (the reader drops queued audio)
+void clip_stream_seek(ClipStream* stream, uint64_t frame);
+
+void clip_stream_get_stats(ClipStream* stream, ClipStreamStats* stats);
+
+// Offline rendering: make reads wait for the streamer instead of playing
+// silence, so a faster-than-real-time render never underruns. Never set it
+// on a stream the device callback reads.
+static inline void clip_stream_set_blocking(ClipStream* stream, bool blocking) {
+    stream->blocking = blocking;
+}
+
+// ============================================================================
+// AUDIO THREAD
+// ============================================================================
+
+// Copy the next frame_count frames into planar buffers. Never blocks; a
+// shortfall is zero-filled and counted as an underrun unless the clip has
+// simply ended.
+void clip_stream_read(ClipStream* stream, float* left, float* right, uint32_t frame_count);
+
+#endif // CLIP_STREAM_H
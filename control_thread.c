@@ -0,0 +1,310 @@
+#include "control_thread.h"
+#include "engine_log.h"
+#include "engine_trace.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// REQUESTS
+// ============================================================================
+
+static bool track_in_range(const AudioEngine* engine, int track_index) {
+    return track_index >= 0 && track_index < engine->track_count;
+}
+
+static void add_default_track(AudioEngine* engine) {
+    char name[32];
+    float freq = 220.0F * powf(2.0F, (float)engine->track_count / 12.0F);
+    snprintf(name, sizeof(name), "Track %d", engine->track_count + 1);
+    audio_engine_add_track(engine, name, freq);
+}
+
+// Mix edits are sent through the journal, so they can be undone
+static void send_edit(ControlThread* control, EngineCommand command) {
+    engine_journal_apply(&control->journal, control->engine, &command);
+}
+
+// Capture on this thread, write on the writer's
+static bool save_session(ControlThread* control, const char* path) {
+    SessionImage image;
+    if (!audio_engine_capture_session(control->engine, &image)) {
+        engine_log(ENGINE_LOG_ERROR, "[control] Cannot save session: out of memory");
+        return false;
+    }
+    if (!session_writer_submit(&control->writer, &image, path)) {
+        engine_log(ENGINE_LOG_WARNING, "[control] Cannot save session '%s': writer busy", path);
+        return false;
+    }
+    return true;
+}
+
+// Toggles flip the engine's last applied state rather than whatever the UI
+// drew, so a press against a stale snapshot still does what it shows next
+static void apply_request(ControlThread* control, const ControlRequest* request) {
+    AudioEngine* engine = control->engine;
+    int track_index = request->track_index;
+    switch (request->type) {
+    case CONTROL_TOGGLE_PLAYING: {
+        bool playing = !atomic_load(&engine->playing);
+        audio_engine_set_playing(engine, playing);
+        engine_log(ENGINE_LOG_INFO, "[control] Master play toggled: %s", playing ? "ON" : "OFF");
+        break;
+    }
+    case CONTROL_SET_PLAYING:
+        audio_engine_set_playing(engine, request->flag);
+        break;
+    case CONTROL_TOGGLE_TRACK_PLAYING:
+        if (track_in_range(engine, track_index)) {
+            const TrackMixLanes* mix = track_store_mix(&engine->tracks, track_index);
+            bool playing = !atomic_load(&mix->playing[track_lane(track_index)]);
+            send_edit(control,
+                      (EngineCommand){.type = CMD_SET_TRACK_PLAYING, .track_index = track_index, .flag = playing});
+            engine_log(ENGINE_LOG_INFO, "[control] Track %d play toggled: %s", track_index,
+                       playing ? "ON" : "OFF");
+        }
+        break;
+    case CONTROL_TOGGLE_TRACK_MUTE:
+        if (track_in_range(engine, track_index)) {
+            const TrackMixLanes* mix = track_store_mix(&engine->tracks, track_index);
+            bool mute = !atomic_load(&mix->mute[track_lane(track_index)]);
+            send_edit(control, (EngineCommand){.type = CMD_SET_TRACK_MUTE, .track_index = track_index, .flag = mute});
+            engine_log(ENGINE_LOG_INFO, "[control] Track %d mute: %s", track_index, mute ? "ON" : "OFF");
+        }
+        break;
+    case CONTROL_TOGGLE_TRACK_SOLO:
+        if (track_in_range(engine, track_index)) {
+            const TrackMixLanes* mix = track_store_mix(&engine->tracks, track_index);
+            bool solo = !atomic_load(&mix->solo[track_lane(track_index)]);
+            send_edit(control, (EngineCommand){.type = CMD_SET_TRACK_SOLO, .track_index = track_index, .flag = solo});
+            engine_log(ENGINE_LOG_INFO, "[control] Track %d solo: %s", track_index, solo ? "ON" : "OFF");
+        }
+        break;
+    case CONTROL_TOGGLE_TRACK_ARMED:
+        if (track_in_range(engine, track_index)) {
+            const TrackMixLanes* mix = track_store_mix(&engine->tracks, track_index);
+            bool armed = !atomic_load(&mix->armed[track_lane(track_index)]);
+            audio_engine_set_track_armed(engine, track_index, armed);
+            engine_log(ENGINE_LOG_INFO, "[control] Track %d armed: %s", track_index, armed ? "ON" : "OFF");
+        }
+        break;
+    case CONTROL_TOGGLE_TRACK_INPUT:
+        if (track_in_range(engine, track_index)) {
+            const TrackMixLanes* mix = track_store_mix(&engine->tracks, track_index);
+            bool input = !atomic_load(&mix->input[track_lane(track_index)]);
+            audio_engine_set_track_input(engine, track_index, input);
+            engine_log(ENGINE_LOG_INFO, "[control] Track %d input: %s", track_index, input ? "ON" : "OFF");
+        }
+        break;
+    case CONTROL_TOGGLE_RECORDING:
+        if (engine->recording) {
+            audio_engine_stop_recording(engine);
+        } else {
+            audio_engine_start_recording(engine, CONTROL_RECORD_DIRECTORY);
+        }
+        break;
+    case CONTROL_TOGGLE_TRACK_FREEZE:
+        if (track_in_range(engine, track_index)) {
+            if (track_store_info(&engine->tracks, track_index)->frozen) {
+                audio_engine_unfreeze_track(engine, track_index);
+            } else {
+                audio_engine_freeze_track(engine, track_index, 0, CONTROL_FREEZE_DIRECTORY);
+            }
+        }
+        break;
+    case CONTROL_SET_TRACK_VOLUME:
+        send_edit(control, (EngineCommand){.type = CMD_SET_TRACK_VOLUME, .track_index = track_index,
+                                           .value = request->value});
+        break;
+    case CONTROL_SET_TRACK_PAN:
+        send_edit(control, (EngineCommand){.type = CMD_SET_TRACK_PAN, .track_index = track_index,
+                                           .value = request->value});
+        break;
+    case CONTROL_SET_MASTER_VOLUME:
+        send_edit(control, (EngineCommand){.type = CMD_SET_MASTER_VOLUME, .value = request->value});
+        break;
+    case CONTROL_ADD_TRACK:
+        if (request->name[0] == '\0') {
+            add_default_track(engine);
+        } else {
+            audio_engine_add_track(engine, request->name, request->frequency);
+        }
+        break;
+    case CONTROL_ADD_EFFECT:
+        if (audio_engine_add_effect(engine, track_index, request->effect)) {
+            engine_log(ENGINE_LOG_INFO, "[control] Added effect to track %d", track_index);
+        }
+        break;
+    case CONTROL_SET_ANALYZER_SOURCE:
+        audio_engine_set_analyzer_source(engine, track_index);
+        break;
+    case CONTROL_SAVE_SESSION:
+        if (save_session(control, CONTROL_SESSION_PATH)) {
+            engine_log(ENGINE_LOG_INFO, "[control] Saving session '%s'", CONTROL_SESSION_PATH);
+        }
+        break;
+    case CONTROL_UNDO:
+        if (!engine_journal_can_undo(&control->journal)) {
+            engine_log(ENGINE_LOG_INFO, "[control] Nothing to undo");
+        } else {
+            engine_journal_undo(&control->journal, engine);
+        }
+        break;
+    case CONTROL_REDO:
+        if (!engine_journal_can_redo(&control->journal)) {
+            engine_log(ENGINE_LOG_INFO, "[control] Nothing to redo");
+        } else {
+            engine_journal_redo(&control->journal, engine);
+        }
+        break;
+    default:
+        engine_log(ENGINE_LOG_WARNING, "[control] Unknown request type %d", (int)request->type);
+        break;
+    }
+}
+
+// ============================================================================
+// LIFECYCLE
+// ============================================================================
+
+bool control_thread_init(ControlThread* control, AudioEngine* engine) {
+    memset(control, 0, sizeof(ControlThread));
+    control->engine = engine;
+    control->request_storage = calloc(CONTROL_REQUEST_QUEUE_SIZE, sizeof(ControlRequest));
+    control->snapshot_storage = calloc(CONTROL_SNAPSHOT_QUEUE_SIZE, sizeof(EngineSnapshot));
+    if (!control->request_storage || !control->snapshot_storage || !engine_journal_init(&control->journal)) {
+        engine_log(ENGINE_LOG_ERROR, "[control] Failed to allocate queues");
+        control_thread_destroy(control);
+        return false;
+    }
+    if (!session_writer_start(&control->writer)) {
+        engine_log(ENGINE_LOG_ERROR, "[control] Failed to start session writer");
+        control_thread_destroy(control);
+        return false;
+    }
+    spsc_ring_init(&control->requests, control->request_storage, sizeof(ControlRequest),
+                   CONTROL_REQUEST_QUEUE_SIZE);
+    spsc_ring_init(&control->snapshots, control->snapshot_storage, sizeof(EngineSnapshot),
+                   CONTROL_SNAPSHOT_QUEUE_SIZE);
+    atomic_store(&control->adopted_version, 0);
+    atomic_store(&control->requests_applied, 0);
+    atomic_store(&control->requests_dropped, 0);
+    return true;
+}
+
+static void control_main(void* user_data) {
+    ControlThread* control = (ControlThread*)user_data;
+    ENGINE_TRACE_THREAD_NAME("control");
+    while (atomic_load(&control->running)) {
+        if (control_thread_process(control) == 0) {
+            engine_thread_sleep_ms(CONTROL_POLL_MS);
+        }
+    }
+    // Apply whatever was queued before the stop
+    control_thread_process(control);
+}
+
+bool control_thread_start(ControlThread* control) {
+    atomic_store(&control->running, true);
+    if (!engine_thread_start(&control->thread, control_main, control, ENGINE_THREAD_PRIORITY_NORMAL, -1)) {
+        atomic_store(&control->running, false);
+        engine_log(ENGINE_LOG_ERROR, "[control] Failed to start control thread");
+        return false;
+    }
+    control->started = true;
+    return true;
+}
+
+void control_thread_destroy(ControlThread* control) {
+    if (control->started) {
+        atomic_store(&control->running, false);
+        engine_thread_join(&control->thread);
+        control->started = false;
+    }
+    session_writer_stop(&control->writer);
+    engine_journal_destroy(&control->journal);
+    free(control->request_storage);
+    free(control->snapshot_storage);
+    control->request_storage = NULL;
+    control->snapshot_storage = NULL;
+}
+
+void control_thread_set_autosave(ControlThread* control, const char* path, uint32_t interval_ms) {
+    snprintf(control->autosave_path, sizeof(control->autosave_path), "%s", path ? path : "");
+    control->autosave_interval_ns = (uint64_t)interval_ms * 1000000u;
+    // The session as it stands counts as saved; the first change starts the clock
+    control->autosaved_version = audio_engine_get_model_version(control->engine);
+    control->autosave_time_ns = engine_thread_time_ns();
+}
+
+// ============================================================================
+// PROCESSING
+// ============================================================================
+
+bool control_thread_request(ControlThread* control, const ControlRequest* request) {
+    if (!spsc_ring_push(&control->requests, request)) {
+        atomic_fetch_add_explicit(&control->requests_dropped, 1, memory_order_relaxed);
+        engine_log(ENGINE_LOG_WARNING, "[control] Request queue full, dropping request");
+        return false;
+    }
+    return true;
+}
+
+int control_thread_process(ControlThread* control) {
+    AudioEngine* engine = control->engine;
+    int applied = 0;
+    ControlRequest request;
+    while (spsc_ring_pop(&control->requests, &request)) {
+        apply_request(control, &request);
+        applied++;
+    }
+    if (applied > 0) {
+        atomic_fetch_add_explicit(&control->requests_applied, (uint_fast64_t)applied, memory_order_relaxed);
+    }
+
+    // Publish in place; a full queue just means the UI is behind and the
+    // next pass tries again with a fresher copy
+    uint64_t version = audio_engine_get_model_version(engine);
+    if (!control->published_any || version != control->published_version) {
+        EngineSnapshot* slot = (EngineSnapshot*)spsc_ring_acquire_push(&control->snapshots);
+        if (slot) {
+            audio_engine_snapshot(engine, slot);
+            spsc_ring_commit_push(&control->snapshots);
+            control->published_version = slot->model_version;
+            control->published_any = true;
+        }
+    }
+
+    // Autosave when the model has moved, at most once per interval (a failed
+    // attempt waits for the next one too); the capture is a copy and the
+    // write happens on the writer thread
+    if (control->autosave_path[0] != '\0' && version != control->autosaved_version) {
+        uint64_t now = engine_thread_time_ns();
+        if (now - control->autosave_time_ns >= control->autosave_interval_ns) {
+            control->autosave_time_ns = now;
+            if (save_session(control, control->autosave_path)) {
+                control->autosaved_version = version;
+            }
+        }
+    }
+
+    // The UI may still be drawing from an older snapshot's clip caches
+    // until it adopts the newest one
+    if (control->published_any && version == control->published_version &&
+        atomic_load_explicit(&control->adopted_version, memory_order_acquire) == control->published_version) {
+        audio_engine_collect_garbage(engine);
+    }
+    return applied;
+}
+
+bool control_thread_poll_snapshot(ControlThread* control, EngineSnapshot* snapshot) {
+    bool any = false;
+    while (spsc_ring_pop(&control->snapshots, snapshot)) {
+        any = true;
+    }
+    if (any) {
+        atomic_store_explicit(&control->adopted_version, snapshot->model_version, memory_order_release);
+    }
+    return any;
+}
@@ -0,0 +1,139 @@
+// control_thread.h - Engine control thread between the UI and the engine
+// Owns every control-thread engine call once started: it drains requests
+// queued by the UI (or any other single producer: key shortcuts, later MIDI)
+// within CONTROL_POLL_MS, reclaims retired graphs and clips, and publishes a
+// fresh EngineSnapshot whenever the model version moves. The UI thread only
+// queues requests and draws the latest snapshot, so a slow frame no longer
+// holds back transport or track edits, and a slow edit never stalls a frame.
+//
+// Mix edits go through an undo journal (see journal.h). Sessions are saved
+// by capturing an image on this thread and handing it to a background
+// writer (see session_writer.h), on request and as a periodic autosave
+// while the model keeps changing, so neither ever waits on the disk.
+#pragma once
+#ifndef CONTROL_THREAD_H
+#define CONTROL_THREAD_H
+
+#include "audio_engine.h"
+#include "engine_thread.h"
+#include "journal.h"
+#include "session_writer.h"
+#include "spsc_ring.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// ============================================================================
+// CONSTANTS
+// ============================================================================
+
+#define CONTROL_REQUEST_QUEUE_SIZE 256      // Power of two
+#define CONTROL_SNAPSHOT_QUEUE_SIZE 4       // Power of two; the UI keeps the newest
+#define CONTROL_POLL_MS 1                   // Idle sleep between request drains
+#define CONTROL_RECORD_DIRECTORY "."        // Where recorded takes are written
+#define CONTROL_FREEZE_DIRECTORY "."        // Where frozen tracks are rendered to
+#define CONTROL_SESSION_PATH "airdaw" SESSION_EXTENSION   // Session saved on request
+#define CONTROL_AUTOSAVE_PATH "airdaw-autosave" SESSION_EXTENSION  // Crash recovery copy
+#define CONTROL_AUTOSAVE_MS 5000            // Shortest time between autosaves
+
+// ============================================================================
+// REQUESTS (UI thread -> control thread)
+// ============================================================================
+
+typedef enum {
+    CONTROL_TOGGLE_PLAYING,                 // Flip the master transport
+    CONTROL_SET_PLAYING,                    // flag
+    CONTROL_TOGGLE_TRACK_PLAYING,           // track_index
+    CONTROL_TOGGLE_TRACK_MUTE,              // track_index
+    CONTROL_TOGGLE_TRACK_SOLO,              // track_index
+    CONTROL_TOGGLE_TRACK_ARMED,             // track_index
+    CONTROL_TOGGLE_TRACK_INPUT,             // track_index
+    CONTROL_TOGGLE_RECORDING,               // Start takes on armed input tracks, or stop them
+    CONTROL_TOGGLE_TRACK_FREEZE,            // track_index
+    CONTROL_SET_TRACK_VOLUME,               // track_index, value
+    CONTROL_SET_TRACK_PAN,                  // track_index, value
+    CONTROL_SET_MASTER_VOLUME,              // value
+    CONTROL_ADD_TRACK,                      // name/frequency, or both empty for the next default
+    CONTROL_ADD_EFFECT,                     // track_index, effect
+    CONTROL_SET_ANALYZER_SOURCE,            // track_index (ANALYZER_SOURCE_* or a track)
+    CONTROL_SAVE_SESSION,                   // Write CONTROL_SESSION_PATH
+    CONTROL_UNDO,                           // Step the journal back
+    CONTROL_REDO                            // Step the journal forward
+} ControlRequestType;
+
+typedef struct {
+    ControlRequestType type;
+    int track_index;
+    bool flag;
+    float value;
+    float frequency;
+    EffectType effect;
+    char name[32];
+} ControlRequest;
+
+// ============================================================================
+// CONTROL THREAD
+// ============================================================================
+
+typedef struct {
+    AudioEngine* engine;
+
+    SpscRing requests;                      // of ControlRequest
+    ControlRequest* request_storage;
+    SpscRing snapshots;                     // of EngineSnapshot
+    EngineSnapshot* snapshot_storage;
+
+    // Snapshot handshake. Retired objects a snapshot may still point at
+    // (clip caches) are only reclaimed once the UI has adopted the newest one.
+    uint64_t published_version;             // Control thread only
+    atomic_uint_fast64_t adopted_version;   // Written by the UI on poll
+    bool published_any;
+
+    EngineJournal journal;                  // Control thread only
+    SessionWriter writer;
+
+    // Autosave (control thread only): the session is captured once the
+    // model has moved and autosave_interval_ns has passed since the last one
+    char autosave_path[512];                // Empty: no autosave
+    uint64_t autosave_interval_ns;
+    uint64_t autosaved_version;
+    uint64_t autosave_time_ns;
+
+    atomic_uint_fast64_t requests_applied;
+    atomic_uint_fast64_t requests_dropped;  // Queue was full
+
+    atomic_bool running;
+    bool started;
+    EngineThread thread;
+} ControlThread;
+
+// Set up the queues over `engine`. Nothing runs until control_thread_start;
+// control_thread_process can also be driven by hand (tests, headless hosts).
+bool control_thread_init(ControlThread* control, AudioEngine* engine);
+
+// Start the thread. From here on only it may call control-thread engine
+// functions; engine setup belongs before this call.
+bool control_thread_start(ControlThread* control);
+
+// Stop and join the thread, finish writing pending saves and free the
+// queues. The engine stays usable from the calling thread again afterwards.
+void control_thread_destroy(ControlThread* control);
+
+// Autosave the session to `path` at most every `interval_ms` while it keeps
+// changing (NULL turns autosave off). Before control_thread_start, or from
+// the control thread.
+void control_thread_set_autosave(ControlThread* control, const char* path, uint32_t interval_ms);
+
+// Queue a request (single producer). Returns false if the queue is full.
+bool control_thread_request(ControlThread* control, const ControlRequest* request);
+
+// One pass: apply queued requests, publish a snapshot if the model moved,
+// reclaim garbage if the UI holds the newest snapshot. Returns the number
+// of requests applied. Control thread only (or the owner when not started).
+int control_thread_process(ControlThread* control);
+
+// UI thread: copy the newest published snapshot into `snapshot` and mark
+// it adopted. Returns false (leaving `snapshot` alone) if nothing is new.
+bool control_thread_poll_snapshot(ControlThread* control, EngineSnapshot* snapshot);
+
+#endif // CONTROL_THREAD_H
@@ -0,0 +1,406 @@
+#include "convolver.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define CONVOLVER_ALIGNMENT 64
+
+// ============================================================================
+// FFT
+// ============================================================================
+
+// In-place iterative radix-2 complex FFT of size B on split arrays.
+// inverse = true uses the conjugate twiddles (no 1/B scaling).
+static void fft_complex(const Convolver* conv, float* re, float* im, bool inverse) {
+    uint32_t n = conv->partition_frames;
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t j = conv->bit_reverse[i];
+        if (j > i) {
+            float tr = re[i], ti = im[i];
+            re[i] = re[j];
+            im[i] = im[j];
+            re[j] = tr;
+            im[j] = ti;
+        }
+    }
+
+    float sign = inverse ? -1.0f : 1.0f;
+    for (uint32_t size = 2; size <= n; size <<= 1) {
+        uint32_t half = size >> 1;
+        uint32_t step = n / size;
+        for (uint32_t start = 0; start < n; start += size) {
+            for (uint32_t k = 0; k < half; k++) {
+                float wr = conv->twiddle_re[k * step];
+                float wi = conv->twiddle_im[k * step] * sign;
+                uint32_t a = start + k;
+                uint32_t b = a + half;
+                float xr = re[b] * wr - im[b] * wi;
+                float xi = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - xr;
+                im[b] = im[a] - xi;
+                re[a] += xr;
+                im[a] += xi;
+            }
+        }
+    }
+}
+
+// Real FFT of 2B samples -> B + 1 bins, via a size-B complex FFT of the
+// even/odd samples packed as re/im
+static void fft_real_forward(const Convolver* conv, const float* x, float* out_re, float* out_im) {
+    uint32_t n = conv->partition_frames;
+    float* zr = conv->work_re;
+    float* zi = conv->work_im;
+    for (uint32_t i = 0; i < n; i++) {
+        zr[i] = x[2 * i];
+        zi[i] = x[2 * i + 1];
+    }
+    fft_complex(conv, zr, zi, false);
+
+    for (uint32_t k = 0; k <= n; k++) {
+        uint32_t a = k == n ? 0 : k;
+        uint32_t b = k == 0 ? 0 : n - k;
+        // Even part E = (Z[k] + conj(Z[n-k])) / 2, odd part O = (Z[k] - conj(Z[n-k])) / 2i
+        float er = 0.5f * (zr[a] + zr[b]);
+        float ei = 0.5f * (zi[a] - zi[b]);
+        float or_ = 0.5f * (zi[a] + zi[b]);
+        float oi = -0.5f * (zr[a] - zr[b]);
+        float wr = conv->split_re[k];
+        float wi = conv->split_im[k];
+        out_re[k] = er + wr * or_ - wi * oi;
+        out_im[k] = ei + wr * oi + wi * or_;
+    }
+}
+
+// Inverse of fft_real_forward (scaled, so forward + inverse is identity).
+// Runs on the caller-provided work buffers.
+static void fft_real_inverse(const Convolver* conv, const float* in_re, const float* in_im, float* x,
+                             float* zr, float* zi) {
+    uint32_t n = conv->partition_frames;
+    for (uint32_t k = 0; k < n; k++) {
+        uint32_t m = n - k;
+        // E = (X[k] + conj(X[n-k])) / 2, O = (X[k] - conj(X[n-k])) * conj(W^k) / 2
+        float er = 0.5f * (in_re[k] + in_re[m]);
+        float ei = 0.5f * (in_im[k] - in_im[m]);
+        float dr = 0.5f * (in_re[k] - in_re[m]);
+        float di = 0.5f * (in_im[k] + in_im[m]);
+        float wr = conv->split_re[k];
+        float wi = -conv->split_im[k];
+        float or_ = dr * wr - di * wi;
+        float oi = dr * wi + di * wr;
+        zr[k] = er - oi;            // Z = E + iO
+        zi[k] = ei + or_;
+    }
+    fft_complex(conv, zr, zi, true);
+
+    float scale = 1.0f / (float)n;
+    for (uint32_t i = 0; i < n; i++) {
+        x[2 * i] = zr[i] * scale;
+        x[2 * i + 1] = zi[i] * scale;
+    }
+}
+
+// ============================================================================
+// TAIL THREAD
+// ============================================================================
+
+static inline uint32_t fdl_slot(const Convolver* conv, uint64_t block) {
+    return (uint32_t)(block % conv->fdl_slots);
+}
+
+// Sum the tail partitions for output block `target` into its tail slot
+static void compute_tail(Convolver* conv, uint64_t target) {
+    uint32_t stride = conv->bin_stride;
+    uint32_t slot = (uint32_t)(target % CONVOLVER_TAIL_SLOTS);
+
+    for (int c = 0; c < 2; c++) {
+        float* acc_re = conv->tail_re[c] + (size_t)slot * stride;
+        float* acc_im = conv->tail_im[c] + (size_t)slot * stride;
+        memset(acc_re, 0, sizeof(float) * stride);
+        memset(acc_im, 0, sizeof(float) * stride);
+
+        for (uint32_t p = CONVOLVER_HEAD_PARTITIONS; p < conv->partition_count && p <= target; p++) {
+            size_t in = (size_t)fdl_slot(conv, target - p) * stride;
+            size_t ir = (size_t)p * stride;
+            conv->tail_dsp->complex_mac(acc_re, acc_im, conv->fdl_re[c] + in, conv->fdl_im[c] + in,
+                                        conv->ir_re[c] + ir, conv->ir_im[c] + ir, stride);
+        }
+    }
+}
+
+static void tail_main(void* user_data) {
+    Convolver* conv = (Convolver*)user_data;
+    uint64_t next = 0;      // Next input block to compute a tail for
+
+    while (atomic_load(&conv->running)) {
+        ma_semaphore_wait(&conv->wake);
+
+        uint64_t published = atomic_load_explicit(&conv->published, memory_order_acquire);
+        while (next < published && atomic_load_explicit(&conv->running, memory_order_relaxed)) {
+            // Skip targets the audio thread has already gone past
+            if (next + CONVOLVER_HEAD_PARTITIONS < published) {
+                next = published - CONVOLVER_HEAD_PARTITIONS;
+            }
+            uint64_t target = next + CONVOLVER_HEAD_PARTITIONS;
+            compute_tail(conv, target);
+            atomic_store_explicit(&conv->tail_done, target + 1, memory_order_release);
+            next++;
+            published = atomic_load_explicit(&conv->published, memory_order_acquire);
+        }
+    }
+}
+
+// ============================================================================
+// INIT / DESTROY
+// ============================================================================
+
+static float* alloc_floats(size_t count) {
+    float* buffer = (float*)dsp_aligned_alloc(sizeof(float) * count, CONVOLVER_ALIGNMENT);
+    if (buffer) {
+        memset(buffer, 0, sizeof(float) * count);
+    }
+    return buffer;
+}
+
+bool convolver_init(Convolver* conv, const float* ir, uint32_t ir_frames, uint32_t ir_channels,
+                    const DspKernels* dsp) {
+    memset(conv, 0, sizeof(Convolver));
+
+    static const float unit_impulse = 1.0f;
+    if (!ir || ir_frames == 0) {
+        ir = &unit_impulse;
+        ir_frames = 1;
+        ir_channels = 1;
+    }
+    if (ir_channels < 1 || ir_channels > 2) {
+        return false;
+    }
+    if (ir_frames > CONVOLVER_MAX_IR_FRAMES) {
+        ir_frames = CONVOLVER_MAX_IR_FRAMES;
+    }
+
+    uint32_t n = CONVOLVER_PARTITION_FRAMES;
+    conv->partition_frames = n;
+    conv->bin_stride = (n + 1 + 15) & ~15u;
+    conv->partition_count = (ir_frames + n - 1) / n;
+    conv->fdl_slots = conv->partition_count + CONVOLVER_HEAD_PARTITIONS;
+    conv->tail_dsp = dsp;
+
+    size_t stride = conv->bin_stride;
+    conv->bit_reverse = (uint32_t*)malloc(sizeof(uint32_t) * n);
+    conv->twiddle_re = alloc_floats(n / 2);
+    conv->twiddle_im = alloc_floats(n / 2);
+    conv->split_re = alloc_floats(n + 1);
+    conv->split_im = alloc_floats(n + 1);
+    conv->work_re = alloc_floats(stride);
+    conv->work_im = alloc_floats(stride);
+    conv->acc_re = alloc_floats(stride);
+    conv->acc_im = alloc_floats(stride);
+    bool ok = conv->bit_reverse && conv->twiddle_re && conv->twiddle_im && conv->split_re && conv->split_im &&
+              conv->work_re && conv->work_im && conv->acc_re && conv->acc_im;
+    for (int c = 0; c < 2 && ok; c++) {
+        conv->ir_re[c] = alloc_floats(stride * conv->partition_count);
+        conv->ir_im[c] = alloc_floats(stride * conv->partition_count);
+        conv->fdl_re[c] = alloc_floats(stride * conv->fdl_slots);
+        conv->fdl_im[c] = alloc_floats(stride * conv->fdl_slots);
+        conv->tail_re[c] = alloc_floats(stride * CONVOLVER_TAIL_SLOTS);
+        conv->tail_im[c] = alloc_floats(stride * CONVOLVER_TAIL_SLOTS);
+        conv->input[c] = alloc_floats(2 * n);
+        conv->output[c] = alloc_floats(n);
+        ok = conv->ir_re[c] && conv->ir_im[c] && conv->fdl_re[c] && conv->fdl_im[c] && conv->tail_re[c] &&
+             conv->tail_im[c] && conv->input[c] && conv->output[c];
+    }
+    if (!ok) {
+        convolver_destroy(conv);
+        return false;
+    }
+
+    // FFT tables
+    uint32_t bits = 0;
+    while ((1u << bits) < n) bits++;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t r = 0;
+        for (uint32_t b = 0; b < bits; b++) {
+            r |= ((i >> b) & 1u) << (bits - 1 - b);
+        }
+        conv->bit_reverse[i] = r;
+    }
+    for (uint32_t k = 0; k < n / 2; k++) {
+        conv->twiddle_re[k] = (float)cos(-2.0 * M_PI * k / n);
+        conv->twiddle_im[k] = (float)sin(-2.0 * M_PI * k / n);
+    }
+    for (uint32_t k = 0; k <= n; k++) {
+        conv->split_re[k] = (float)cos(-M_PI * k / n);
+        conv->split_im[k] = (float)sin(-M_PI * k / n);
+    }
+
+    // IR partition spectra: each partition in the first half of a 2B
+    // window, zeros in the second (overlap-save)
+    float* window = conv->input[0];
+    for (int c = 0; c < 2; c++) {
+        uint32_t source = ir_channels == 2 ? (uint32_t)c : 0;
+        for (uint32_t p = 0; p < conv->partition_count; p++) {
+            memset(window, 0, sizeof(float) * 2 * n);
+            for (uint32_t i = 0; i < n && p * n + i < ir_frames; i++) {
+                window[i] = ir[(size_t)(p * n + i) * ir_channels + source];
+            }
+            fft_real_forward(conv, window, conv->ir_re[c] + p * stride, conv->ir_im[c] + p * stride);
+        }
+    }
+    memset(window, 0, sizeof(float) * 2 * n);
+
+    // Targets below the head length have no tail contribution
+    atomic_store(&conv->published, 0);
+    atomic_store(&conv->tail_done, CONVOLVER_HEAD_PARTITIONS);
+    atomic_store(&conv->late_blocks, 0);
+
+    if (conv->partition_count > CONVOLVER_HEAD_PARTITIONS) {
+        if (ma_semaphore_init(0, &conv->wake) != MA_SUCCESS) {
+            convolver_destroy(conv);
+            return false;
+        }
+        atomic_store(&conv->running, true);
+        if (!engine_thread_start(&conv->thread, tail_main, conv, ENGINE_THREAD_PRIORITY_NORMAL, -1)) {
+            atomic_store(&conv->running, false);
+            ma_semaphore_uninit(&conv->wake);
+            convolver_destroy(conv);
+            return false;
+        }
+        conv->threaded = true;
+    }
+    return true;
+}
+
+void convolver_destroy(Convolver* conv) {
+    if (conv->threaded) {
+        atomic_store(&conv->running, false);
+        ma_semaphore_release(&conv->wake);
+        engine_thread_join(&conv->thread);
+        ma_semaphore_uninit(&conv->wake);
+        conv->threaded = false;
+    }
+
+    free(conv->bit_reverse);
+    float* buffers[] = {
+        conv->twiddle_re, conv->twiddle_im, conv->split_re, conv->split_im, conv->work_re, conv->work_im,
+        conv->acc_re, conv->acc_im,
+    };
+    for (size_t i = 0; i < sizeof(buffers) / sizeof(buffers[0]); i++) {
+        dsp_aligned_free(buffers[i]);
+    }
+    for (int c = 0; c < 2; c++) {
+        dsp_aligned_free(conv->ir_re[c]);
+        dsp_aligned_free(conv->ir_im[c]);
+        dsp_aligned_free(conv->fdl_re[c]);
+        dsp_aligned_free(conv->fdl_im[c]);
+        dsp_aligned_free(conv->tail_re[c]);
+        dsp_aligned_free(conv->tail_im[c]);
+        dsp_aligned_free(conv->input[c]);
+        dsp_aligned_free(conv->output[c]);
+    }
+    memset(conv, 0, sizeof(Convolver));
+}
+
+// ============================================================================
+// PROCESSING (AUDIO THREAD)
+// ============================================================================
+
+// One full input partition is buffered: transform it, sum the head
+// partitions plus the precomputed tail, transform back
+static void process_partition(Convolver* conv, const DspKernels* dsp) {
+    uint32_t n = conv->partition_frames;
+    uint32_t stride = conv->bin_stride;
+    uint64_t block = conv->block_index;
+    uint32_t head = conv->partition_count < CONVOLVER_HEAD_PARTITIONS ? conv->partition_count
+                                                                      : CONVOLVER_HEAD_PARTITIONS;
+    bool tail_ready = !conv->threaded ||
+                      atomic_load_explicit(&conv->tail_done, memory_order_acquire) > block;
+    while (!tail_ready && conv->blocking) {
+        engine_thread_yield();
+        tail_ready = atomic_load_explicit(&conv->tail_done, memory_order_acquire) > block;
+    }
+    if (!tail_ready) {
+        atomic_fetch_add_explicit(&conv->late_blocks, 1, memory_order_relaxed);
+    }
+
+    for (int c = 0; c < 2; c++) {
+        size_t slot = (size_t)fdl_slot(conv, block) * stride;
+        float* x_re = conv->fdl_re[c] + slot;
+        float* x_im = conv->fdl_im[c] + slot;
+        fft_real_forward(conv, conv->input[c], x_re, x_im);
+
+        if (conv->threaded && tail_ready) {
+            size_t tail = (size_t)(block % CONVOLVER_TAIL_SLOTS) * stride;
+            memcpy(conv->acc_re, conv->tail_re[c] + tail, sizeof(float) * stride);
+            memcpy(conv->acc_im, conv->tail_im[c] + tail, sizeof(float) * stride);
+        } else {
+            memset(conv->acc_re, 0, sizeof(float) * stride);
+            memset(conv->acc_im, 0, sizeof(float) * stride);
+        }
+
+        for (uint32_t p = 0; p < head && p <= block; p++) {
+            size_t in = (size_t)fdl_slot(conv, block - p) * stride;
+            size_t ir = (size_t)p * stride;
+            dsp->complex_mac(conv->acc_re, conv->acc_im, conv->fdl_re[c] + in, conv->fdl_im[c] + in,
+                             conv->ir_re[c] + ir, conv->ir_im[c] + ir, stride);
+        }
+
+        // Overlap-save: the second half of the circular result is valid.
+        // The input window doubles as scratch for the inverse transform.
+        float* time = conv->input[c];
+        float saved[CONVOLVER_PARTITION_FRAMES];
+        memcpy(saved, time + n, sizeof(float) * n);
+        fft_real_inverse(conv, conv->acc_re, conv->acc_im, time, conv->work_re, conv->work_im);
+        memcpy(conv->output[c], time + n, sizeof(float) * n);
+        memcpy(time, saved, sizeof(float) * n);
+    }
+
+    // Hand the new spectrum to the tail thread
+    conv->block_index = block + 1;
+    if (conv->threaded) {
+        atomic_store_explicit(&conv->published, block + 1, memory_order_release);
+        ma_semaphore_release(&conv->wake);
+    }
+}
+
+void convolver_process(Convolver* conv, const DspKernels* dsp, float* left, float* right, uint32_t frame_count,
+                       float dry, float wet) {
+    uint32_t n = conv->partition_frames;
+    const float* prev_l = conv->input[0];
+    const float* prev_r = conv->input[1];
+    float* in_l = conv->input[0] + n;
+    float* in_r = conv->input[1] + n;
+    const float* out_l = conv->output[0];
+    const float* out_r = conv->output[1];
+
+    uint32_t done = 0;
+    while (done < frame_count) {
+        uint32_t count = n - conv->fill;
+        if (count > frame_count - done) count = frame_count - done;
+
+        // Collect input and emit the previous partition's output in one pass.
+        // The window's first half is the previous partition: the dry signal
+        // one partition back, in step with the wet output.
+        uint32_t pos = conv->fill;
+        for (uint32_t i = 0; i < count; i++) {
+            float dry_l = prev_l[pos + i];
+            float dry_r = prev_r[pos + i];
+            in_l[pos + i] = left[done + i];
+            in_r[pos + i] = right[done + i];
+            left[done + i] = dry_l * dry + out_l[pos + i] * wet;
+            right[done + i] = dry_r * dry + out_r[pos + i] * wet;
+        }
+        conv->fill += count;
+        done += count;
+
+        if (conv->fill == n) {
+            process_partition(conv, dsp);
+            conv->fill = 0;
+        }
+    }
+}
@@ -0,0 +1,93 @@
+// convolver.h - Uniformly partitioned FFT convolution
+// Overlap-save convolution with an impulse response cut into equal
+// partitions of CONVOLVER_PARTITION_FRAMES. Input spectra go into a
+// frequency-domain delay line; each output partition is the sum of
+// delayed input spectra times IR partition spectra. The first
+// CONVOLVER_HEAD_PARTITIONS are summed on the calling (audio) thread;
+// the tail is summed ahead of time on a background thread, which has
+// CONVOLVER_HEAD_PARTITIONS partitions' worth of time for each block.
+#pragma once
+#ifndef CONVOLVER_H
+#define CONVOLVER_H
+
+#include "dsp_kernels.h"
+#include "engine_thread.h"
+#include "vendor/miniaudio/miniaudio.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CONVOLVER_PARTITION_FRAMES 256      // Partition length, also the added latency
+#define CONVOLVER_HEAD_PARTITIONS 4         // Partitions computed on the audio thread
+#define CONVOLVER_TAIL_SLOTS (CONVOLVER_HEAD_PARTITIONS + 1)
+#define CONVOLVER_MAX_IR_FRAMES (48000 * 20)
+
+typedef struct {
+    uint32_t partition_frames;      // B; FFT size is 2B
+    uint32_t bin_stride;            // B + 1 bins, padded to a SIMD multiple
+    uint32_t partition_count;       // IR partitions
+    uint32_t fdl_slots;             // Input spectra kept (partition_count + head)
+
+    // FFT tables (size-B complex FFT behind the size-2B real transform)
+    uint32_t* bit_reverse;
+    float* twiddle_re;
+    float* twiddle_im;
+    float* split_re;                // exp(-2*pi*i*k / 2B), k = 0..B
+    float* split_im;
+
+    // Spectra, split-complex, [channel][partition or slot][bin_stride]
+    float* ir_re[2];
+    float* ir_im[2];
+    float* fdl_re[2];
+    float* fdl_im[2];
+    float* tail_re[2];              // [channel][CONVOLVER_TAIL_SLOTS][bin_stride]
+    float* tail_im[2];
+
+    // Audio-thread time-domain and work buffers
+    float* input[2];                // Sliding window of 2B samples
+    float* output[2];               // Latest B output samples
+    float* work_re;
+    float* work_im;
+    float* acc_re;
+    float* acc_im;
+    uint32_t fill;                  // Samples of the current partition collected
+    uint64_t block_index;
+
+    // Tail thread (only started when partition_count > head)
+    const DspKernels* tail_dsp;
+    _Atomic uint64_t published;     // Input blocks whose spectrum is in the FDL
+    _Atomic uint64_t tail_done;     // Tail targets [0, tail_done) are ready
+    _Atomic uint64_t late_blocks;   // Tail missed its deadline (tail dropped)
+    atomic_bool running;
+    bool threaded;
+    bool blocking;                  // Wait for a late tail instead of dropping it
+    ma_semaphore wake;
+    EngineThread thread;
+} Convolver;
+
+// Build a convolver for an interleaved IR of 1 (applied to both sides) or
+// 2 channels. Allocates everything and starts the tail thread; call off
+// the audio thread. Returns false on failure (nothing left allocated).
+bool convolver_init(Convolver* conv, const float* ir, uint32_t ir_frames, uint32_t ir_channels,
+                    const DspKernels* dsp);
+
+// Stop the tail thread and free all buffers
+void convolver_destroy(Convolver* conv);
+
+// Convolve a planar stereo block in place: out = in * dry + (in (*) ir) * wet,
+// both paths delayed by convolver_latency() frames so they stay aligned.
+void convolver_process(Convolver* conv, const DspKernels* dsp, float* left, float* right, uint32_t frame_count,
+                       float dry, float wet);
+
+// Offline rendering: make the audio side wait for the tail thread instead of
+// dropping a late tail, so output is deterministic. Never set it on a
+// convolver the device callback runs.
+static inline void convolver_set_blocking(Convolver* conv, bool blocking) {
+    conv->blocking = blocking;
+}
+
+static inline uint32_t convolver_latency(const Convolver* conv) {
+    return conv->partition_frames;
+}
+
+#endif // CONVOLVER_H
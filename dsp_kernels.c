@@ -0,0 +1,743 @@
+#include "dsp_kernels.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define DSP_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define DSP_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define DSP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define DSP_NEON 1
+#include <arm_neon.h>
+#endif
+
+// ============================================================================
+// SCALAR
+// ============================================================================
+
+static void gain_scalar(float* buffer, float gain, uint32_t frame_count) {
+    for (uint32_t i = 0; i < frame_count; i++) {
+        buffer[i] *= gain;
+    }
+}
+
+static void gain_ramp_scalar(float* buffer, float start, float step, uint32_t frame_count) {
+    for (uint32_t i = 0; i < frame_count; i++) {
+        buffer[i] *= start + step * (float)i;
+    }
+}
+
+static void mix_scalar(float* dst, const float* src, float gain, uint32_t frame_count) {
+    for (uint32_t i = 0; i < frame_count; i++) {
+        dst[i] += src[i] * gain;
+    }
+}
+
+static void measure_scalar(const float* buffer, uint32_t frame_count, float clip_level,
+                           float* peak, float* sum_squares, uint32_t* clips) {
+    float max_abs = 0.0F;
+    float sum = 0.0F;
+    uint32_t clip_count = 0;
+
+    for (uint32_t i = 0; i < frame_count; i++) {
+        float x = buffer[i];
+        float a = fabsf(x);
+        if (a > max_abs) max_abs = a;
+        if (a >= clip_level) clip_count++;
+        sum += x * x;
+    }
+
+    *peak = max_abs;
+    *sum_squares = sum;
+    *clips = clip_count;
+}
+
+static void interleave_scalar(float* out, const float* left, const float* right, uint32_t frame_count) {
+    for (uint32_t i = 0; i < frame_count; i++) {
+        out[i * 2 + 0] = left[i];
+        out[i * 2 + 1] = right[i];
+    }
+}
+
+static void complex_mac_scalar(float* acc_re, float* acc_im, const float* a_re, const float* a_im,
+                               const float* b_re, const float* b_im, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        acc_re[i] += a_re[i] * b_re[i] - a_im[i] * b_im[i];
+        acc_im[i] += a_re[i] * b_im[i] + a_im[i] * b_re[i];
+    }
+}
+
+static void fir_scalar(float* out, const float* in, const float* taps, uint32_t tap_count, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        float acc = 0.0F;
+        for (uint32_t k = 0; k < tap_count; k++) {
+            acc += taps[k] * in[i + k];
+        }
+        out[i] = acc;
+    }
+}
+
+#define DSP_SVF_FLUSH_LEVEL 1e-15f     // About -300 dB
+
+// One frame of one lane; m0..m2 pick the output
+static inline float svf_frame(const DspSvfCoeffs* c, float v0, float* ic1, float* ic2) {
+    float v3 = v0 - *ic2;
+    float v1 = c->a1 * *ic1 + c->a2 * v3;
+    float v2 = *ic2 + c->a2 * *ic1 + c->a3 * v3;
+    *ic1 = 2.0f * v1 - *ic1;
+    *ic2 = 2.0f * v2 - *ic2;
+    return c->m0 * v0 + c->m1 * v1 + c->m2 * v2;
+}
+
+// Per-frame increments of a glide from `from` to `to` over frame_count frames
+static DspSvfCoeffs svf_glide_step(const DspSvfCoeffs* from, const DspSvfCoeffs* to, uint32_t frame_count) {
+    float inv = 1.0f / (float)frame_count;
+    DspSvfCoeffs step = {
+        (to->a1 - from->a1) * inv, (to->a2 - from->a2) * inv, (to->a3 - from->a3) * inv,
+        (to->m0 - from->m0) * inv, (to->m1 - from->m1) * inv, (to->m2 - from->m2) * inv,
+    };
+    return step;
+}
+
+// Integrators decaying on silence (or on DC, for the band one) would end
+// up denormal and slow every later frame right down
+static void svf_store_state(float state[4], float l_ic1, float r_ic1, float l_ic2, float r_ic2) {
+    state[0] = fabsf(l_ic1) < DSP_SVF_FLUSH_LEVEL ? 0.0f : l_ic1;
+    state[1] = fabsf(r_ic1) < DSP_SVF_FLUSH_LEVEL ? 0.0f : r_ic1;
+    state[2] = fabsf(l_ic2) < DSP_SVF_FLUSH_LEVEL ? 0.0f : l_ic2;
+    state[3] = fabsf(r_ic2) < DSP_SVF_FLUSH_LEVEL ? 0.0f : r_ic2;
+}
+
+static void svf_stereo_scalar(float* left, float* right, uint32_t frame_count, const DspSvfCoeffs* from,
+                              const DspSvfCoeffs* to, float state[4]) {
+    float l_ic1 = state[0];
+    float r_ic1 = state[1];
+    float l_ic2 = state[2];
+    float r_ic2 = state[3];
+    if (from == to || frame_count == 0) {
+        const DspSvfCoeffs c = *to;
+        for (uint32_t i = 0; i < frame_count; i++) {
+            left[i] = svf_frame(&c, left[i], &l_ic1, &l_ic2);
+            right[i] = svf_frame(&c, right[i], &r_ic1, &r_ic2);
+        }
+    } else {
+        DspSvfCoeffs step = svf_glide_step(from, to, frame_count);
+        DspSvfCoeffs c = *from;
+        for (uint32_t i = 0; i < frame_count; i++) {
+            c.a1 += step.a1;
+            c.a2 += step.a2;
+            c.a3 += step.a3;
+            c.m0 += step.m0;
+            c.m1 += step.m1;
+            c.m2 += step.m2;
+            left[i] = svf_frame(&c, left[i], &l_ic1, &l_ic2);
+            right[i] = svf_frame(&c, right[i], &r_ic1, &r_ic2);
+        }
+    }
+    svf_store_state(state, l_ic1, r_ic1, l_ic2, r_ic2);
+}
+
+static const DspKernels kernels_scalar = {
+    .name = "scalar",
+    .gain = gain_scalar,
+    .gain_ramp = gain_ramp_scalar,
+    .mix = mix_scalar,
+    .measure = measure_scalar,
+    .interleave = interleave_scalar,
+    .complex_mac = complex_mac_scalar,
+    .fir = fir_scalar,
+    .svf_stereo = svf_stereo_scalar,
+};
+
+// ============================================================================
+// SSE2 / AVX2
+// ============================================================================
+
+#ifdef DSP_X86
+
+static void gain_sse2(float* buffer, float gain, uint32_t frame_count) {
+    __m128 g = _mm_set1_ps(gain);
+    uint32_t i = 0;
+    for (; i + 4 <= frame_count; i += 4) {
+        _mm_storeu_ps(buffer + i, _mm_mul_ps(_mm_loadu_ps(buffer + i), g));
+    }
+    gain_scalar(buffer + i, gain, frame_count - i);
+}
+
+static void gain_ramp_sse2(float* buffer, float start, float step, uint32_t frame_count) {
+    const __m128 s = _mm_set1_ps(step);
+    const __m128 g0 = _mm_set1_ps(start);
+    __m128 index = _mm_setr_ps(0.0F, 1.0F, 2.0F, 3.0F);
+    const __m128 four = _mm_set1_ps(4.0F);
+    uint32_t i = 0;
+    for (; i + 4 <= frame_count; i += 4) {
+        __m128 g = _mm_add_ps(g0, _mm_mul_ps(s, index));
+        _mm_storeu_ps(buffer + i, _mm_mul_ps(_mm_loadu_ps(buffer + i), g));
+        index = _mm_add_ps(index, four);
+    }
+    gain_ramp_scalar(buffer + i, start + step * (float)i, step, frame_count - i);
+}
+
+static void mix_sse2(float* dst, const float* src, float gain, uint32_t frame_count) {
+    __m128 g = _mm_set1_ps(gain);
+    uint32_t i = 0;
+    for (; i + 4 <= frame_count; i += 4) {
+        __m128 d = _mm_loadu_ps(dst + i);
+        _mm_storeu_ps(dst + i, _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+    }
+    mix_scalar(dst + i, src + i, gain, frame_count - i);
+}
+
+static void measure_sse2(const float* buffer, uint32_t frame_count, float clip_level,
+                         float* peak, float* sum_squares, uint32_t* clips) {
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 level = _mm_set1_ps(clip_level);
+    __m128 max_abs = _mm_setzero_ps();
+    __m128 sum = _mm_setzero_ps();
+    uint32_t clip_count = 0;
+    uint32_t i = 0;
+
+    for (; i + 4 <= frame_count; i += 4) {
+        __m128 x = _mm_loadu_ps(buffer + i);
+        __m128 a = _mm_and_ps(x, abs_mask);
+        max_abs = _mm_max_ps(max_abs, a);
+        sum = _mm_add_ps(sum, _mm_mul_ps(x, x));
+        int mask = _mm_movemask_ps(_mm_cmpge_ps(a, level));
+        clip_count += (uint32_t)((mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1));
+    }
+
+    float lanes_max[4];
+    float lanes_sum[4];
+    _mm_storeu_ps(lanes_max, max_abs);
+    _mm_storeu_ps(lanes_sum, sum);
+
+    float tail_peak, tail_sum;
+    uint32_t tail_clips;
+    measure_scalar(buffer + i, frame_count - i, clip_level, &tail_peak, &tail_sum, &tail_clips);
+
+    float m = tail_peak;
+    for (int l = 0; l < 4; l++) {
+        if (lanes_max[l] > m) m = lanes_max[l];
+    }
+    *peak = m;
+    *sum_squares = (lanes_sum[0] + lanes_sum[1]) + (lanes_sum[2] + lanes_sum[3]) + tail_sum;
+    *clips = clip_count + tail_clips;
+}
+
+static void interleave_sse2(float* out, const float* left, const float* right, uint32_t frame_count) {
+    uint32_t i = 0;
+    for (; i + 4 <= frame_count; i += 4) {
+        __m128 l = _mm_loadu_ps(left + i);
+        __m128 r = _mm_loadu_ps(right + i);
+        _mm_storeu_ps(out + i * 2 + 0, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(out + i * 2 + 4, _mm_unpackhi_ps(l, r));
+    }
+    interleave_scalar(out + i * 2, left + i, right + i, frame_count - i);
+}
+
+static void complex_mac_sse2(float* acc_re, float* acc_im, const float* a_re, const float* a_im,
+                             const float* b_re, const float* b_im, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 ar = _mm_loadu_ps(a_re + i);
+        __m128 ai = _mm_loadu_ps(a_im + i);
+        __m128 br = _mm_loadu_ps(b_re + i);
+        __m128 bi = _mm_loadu_ps(b_im + i);
+        __m128 re = _mm_sub_ps(_mm_mul_ps(ar, br), _mm_mul_ps(ai, bi));
+        __m128 im = _mm_add_ps(_mm_mul_ps(ar, bi), _mm_mul_ps(ai, br));
+        _mm_storeu_ps(acc_re + i, _mm_add_ps(_mm_loadu_ps(acc_re + i), re));
+        _mm_storeu_ps(acc_im + i, _mm_add_ps(_mm_loadu_ps(acc_im + i), im));
+    }
+    complex_mac_scalar(acc_re + i, acc_im + i, a_re + i, a_im + i, b_re + i, b_im + i, count - i);
+}
+
+// Four outputs per pass, one broadcast tap at a time
+static void fir_sse2(float* out, const float* in, const float* taps, uint32_t tap_count, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 acc = _mm_setzero_ps();
+        for (uint32_t k = 0; k < tap_count; k++) {
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(taps[k]), _mm_loadu_ps(in + i + k)));
+        }
+        _mm_storeu_ps(out + i, acc);
+    }
+    fir_scalar(out + i, in + i, taps, tap_count, count - i);
+}
+
+// Left and right as the two low lanes of one register, in the scalar
+// kernel's operation order
+static inline __m128 svf_frame_sse2(const __m128 c[6], __m128 v0, __m128* ic1, __m128* ic2) {
+    __m128 v3 = _mm_sub_ps(v0, *ic2);
+    __m128 v1 = _mm_add_ps(_mm_mul_ps(c[0], *ic1), _mm_mul_ps(c[1], v3));
+    __m128 v2 = _mm_add_ps(_mm_add_ps(*ic2, _mm_mul_ps(c[1], *ic1)), _mm_mul_ps(c[2], v3));
+    __m128 two = _mm_set1_ps(2.0f);
+    *ic1 = _mm_sub_ps(_mm_mul_ps(two, v1), *ic1);
+    *ic2 = _mm_sub_ps(_mm_mul_ps(two, v2), *ic2);
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[3], v0), _mm_mul_ps(c[4], v1)), _mm_mul_ps(c[5], v2));
+}
+
+static void svf_stereo_sse2(float* left, float* right, uint32_t frame_count, const DspSvfCoeffs* from,
+                            const DspSvfCoeffs* to, float state[4]) {
+    __m128 ic1 = _mm_setr_ps(state[0], state[1], 0.0F, 0.0F);
+    __m128 ic2 = _mm_setr_ps(state[2], state[3], 0.0F, 0.0F);
+    bool glide = from != to && frame_count > 0;
+    const DspSvfCoeffs* start = glide ? from : to;
+    __m128 c[6] = {
+        _mm_set1_ps(start->a1), _mm_set1_ps(start->a2), _mm_set1_ps(start->a3),
+        _mm_set1_ps(start->m0), _mm_set1_ps(start->m1), _mm_set1_ps(start->m2),
+    };
+    __m128 step[6];
+    if (glide) {
+        DspSvfCoeffs s = svf_glide_step(from, to, frame_count);
+        step[0] = _mm_set1_ps(s.a1);
+        step[1] = _mm_set1_ps(s.a2);
+        step[2] = _mm_set1_ps(s.a3);
+        step[3] = _mm_set1_ps(s.m0);
+        step[4] = _mm_set1_ps(s.m1);
+        step[5] = _mm_set1_ps(s.m2);
+    }
+    for (uint32_t i = 0; i < frame_count; i++) {
+        if (glide) {
+            for (int k = 0; k < 6; k++) {
+                c[k] = _mm_add_ps(c[k], step[k]);
+            }
+        }
+        __m128 out = svf_frame_sse2(c, _mm_setr_ps(left[i], right[i], 0.0F, 0.0F), &ic1, &ic2);
+        left[i] = _mm_cvtss_f32(out);
+        right[i] = _mm_cvtss_f32(_mm_shuffle_ps(out, out, _MM_SHUFFLE(1, 1, 1, 1)));
+    }
+
+    float l1[4], l2[4];
+    _mm_storeu_ps(l1, ic1);
+    _mm_storeu_ps(l2, ic2);
+    svf_store_state(state, l1[0], l1[1], l2[0], l2[1]);
+}
+
+static const DspKernels kernels_sse2 = {
+    .name = "sse2",
+    .gain = gain_sse2,
+    .gain_ramp = gain_ramp_sse2,
+    .mix = mix_sse2,
+    .measure = measure_sse2,
+    .interleave = interleave_sse2,
+    .complex_mac = complex_mac_sse2,
+    .fir = fir_sse2,
+    .svf_stereo = svf_stereo_sse2,
+};
+
+DSP_TARGET_AVX2 static void gain_avx2(float* buffer, float gain, uint32_t frame_count) {
+    __m256 g = _mm256_set1_ps(gain);
+    uint32_t i = 0;
+    for (; i + 8 <= frame_count; i += 8) {
+        _mm256_storeu_ps(buffer + i, _mm256_mul_ps(_mm256_loadu_ps(buffer + i), g));
+    }
+    gain_scalar(buffer + i, gain, frame_count - i);
+}
+
+DSP_TARGET_AVX2 static void gain_ramp_avx2(float* buffer, float start, float step, uint32_t frame_count) {
+    const __m256 s = _mm256_set1_ps(step);
+    const __m256 g0 = _mm256_set1_ps(start);
+    __m256 index = _mm256_setr_ps(0.0F, 1.0F, 2.0F, 3.0F, 4.0F, 5.0F, 6.0F, 7.0F);
+    const __m256 eight = _mm256_set1_ps(8.0F);
+    uint32_t i = 0;
+    for (; i + 8 <= frame_count; i += 8) {
+        __m256 g = _mm256_add_ps(g0, _mm256_mul_ps(s, index));
+        _mm256_storeu_ps(buffer + i, _mm256_mul_ps(_mm256_loadu_ps(buffer + i), g));
+        index = _mm256_add_ps(index, eight);
+    }
+    gain_ramp_scalar(buffer + i, start + step * (float)i, step, frame_count - i);
+}
+
+DSP_TARGET_AVX2 static void mix_avx2(float* dst, const float* src, float gain, uint32_t frame_count) {
+    __m256 g = _mm256_set1_ps(gain);
+    uint32_t i = 0;
+    for (; i + 8 <= frame_count; i += 8) {
+        __m256 d = _mm256_loadu_ps(dst + i);
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(d, _mm256_mul_ps(_mm256_loadu_ps(src + i), g)));
+    }
+    mix_scalar(dst + i, src + i, gain, frame_count - i);
+}
+
+DSP_TARGET_AVX2 static void measure_avx2(const float* buffer, uint32_t frame_count, float clip_level,
+                                         float* peak, float* sum_squares, uint32_t* clips) {
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const __m256 level = _mm256_set1_ps(clip_level);
+    __m256 max_abs = _mm256_setzero_ps();
+    __m256 sum = _mm256_setzero_ps();
+    uint32_t clip_count = 0;
+    uint32_t i = 0;
+
+    for (; i + 8 <= frame_count; i += 8) {
+        __m256 x = _mm256_loadu_ps(buffer + i);
+        __m256 a = _mm256_and_ps(x, abs_mask);
+        max_abs = _mm256_max_ps(max_abs, a);
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(x, x));
+        unsigned mask = (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(a, level, _CMP_GE_OQ));
+        for (; mask; mask &= mask - 1) {
+            clip_count++;
+        }
+    }
+
+    float lanes_max[8];
+    float lanes_sum[8];
+    _mm256_storeu_ps(lanes_max, max_abs);
+    _mm256_storeu_ps(lanes_sum, sum);
+
+    float tail_peak, tail_sum;
+    uint32_t tail_clips;
+    measure_scalar(buffer + i, frame_count - i, clip_level, &tail_peak, &tail_sum, &tail_clips);
+
+    float m = tail_peak;
+    float s = tail_sum;
+    for (int l = 0; l < 8; l++) {
+        if (lanes_max[l] > m) m = lanes_max[l];
+        s += lanes_sum[l];
+    }
+    *peak = m;
+    *sum_squares = s;
+    *clips = clip_count + tail_clips;
+}
+
+DSP_TARGET_AVX2 static void interleave_avx2(float* out, const float* left, const float* right, uint32_t frame_count) {
+    uint32_t i = 0;
+    for (; i + 8 <= frame_count; i += 8) {
+        __m256 l = _mm256_loadu_ps(left + i);
+        __m256 r = _mm256_loadu_ps(right + i);
+        __m256 lo = _mm256_unpacklo_ps(l, r);     // l0 r0 l1 r1 | l4 r4 l5 r5
+        __m256 hi = _mm256_unpackhi_ps(l, r);     // l2 r2 l3 r3 | l6 r6 l7 r7
+        _mm256_storeu_ps(out + i * 2 + 0, _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(out + i * 2 + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+    interleave_sse2(out + i * 2, left + i, right + i, frame_count - i);
+}
+
+DSP_TARGET_AVX2 static void complex_mac_avx2(float* acc_re, float* acc_im, const float* a_re, const float* a_im,
+                                             const float* b_re, const float* b_im, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 ar = _mm256_loadu_ps(a_re + i);
+        __m256 ai = _mm256_loadu_ps(a_im + i);
+        __m256 br = _mm256_loadu_ps(b_re + i);
+        __m256 bi = _mm256_loadu_ps(b_im + i);
+        __m256 re = _mm256_sub_ps(_mm256_mul_ps(ar, br), _mm256_mul_ps(ai, bi));
+        __m256 im = _mm256_add_ps(_mm256_mul_ps(ar, bi), _mm256_mul_ps(ai, br));
+        _mm256_storeu_ps(acc_re + i, _mm256_add_ps(_mm256_loadu_ps(acc_re + i), re));
+        _mm256_storeu_ps(acc_im + i, _mm256_add_ps(_mm256_loadu_ps(acc_im + i), im));
+    }
+    complex_mac_sse2(acc_re + i, acc_im + i, a_re + i, a_im + i, b_re + i, b_im + i, count - i);
+}
+
+DSP_TARGET_AVX2 static void fir_avx2(float* out, const float* in, const float* taps, uint32_t tap_count,
+                                     uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 acc = _mm256_setzero_ps();
+        for (uint32_t k = 0; k < tap_count; k++) {
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(taps[k]), _mm256_loadu_ps(in + i + k)));
+        }
+        _mm256_storeu_ps(out + i, acc);
+    }
+    fir_sse2(out + i, in + i, taps, tap_count, count - i);
+}
+
+static const DspKernels kernels_avx2 = {
+    .name = "avx2",
+    .gain = gain_avx2,
+    .gain_ramp = gain_ramp_avx2,
+    .mix = mix_avx2,
+    .measure = measure_avx2,
+    .interleave = interleave_avx2,
+    .complex_mac = complex_mac_avx2,
+    .fir = fir_avx2,
+    .svf_stereo = svf_stereo_sse2,
+};
+
+// AVX2 needs CPU support and the OS saving YMM state (OSXSAVE + XCR0)
+static bool cpu_has_avx2(void) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28))) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+    if (!(ecx & (1u << 27)) || !(ecx & (1u << 28))) return false;
+    unsigned int xcr0_lo, xcr0_hi;
+    __asm__ __volatile__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    (void)xcr0_hi;
+    if ((xcr0_lo & 0x6) != 0x6) return false;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+    return (ebx & (1u << 5)) != 0;
+#endif
+}
+
+#endif // DSP_X86
+
+// ============================================================================
+// NEON
+// ============================================================================
+
+#ifdef DSP_NEON
+
+static void gain_neon(float* buffer, float gain, uint32_t frame_count) {
+    float32x4_t g = vdupq_n_f32(gain);
+    uint32_t i = 0;
+    for (; i + 4 <= frame_count; i += 4) {
+        vst1q_f32(buffer + i, vmulq_f32(vld1q_f32(buffer + i), g));
+    }
+    gain_scalar(buffer + i, gain, frame_count - i);
+}
+
+static void gain_ramp_neon(float* buffer, float start, float step, uint32_t frame_count) {
+    static const float lanes[4] = {0.0F, 1.0F, 2.0F, 3.0F};
+    const float32x4_t s = vdupq_n_f32(step);
+    const float32x4_t g0 = vdupq_n_f32(start);
+    float32x4_t index = vld1q_f32(lanes);
+    const float32x4_t four = vdupq_n_f32(4.0F);
+    uint32_t i = 0;
+    for (; i + 4 <= frame_count; i += 4) {
+        float32x4_t g = vaddq_f32(g0, vmulq_f32(s, index));
+        vst1q_f32(buffer + i, vmulq_f32(vld1q_f32(buffer + i), g));
+        index = vaddq_f32(index, four);
+    }
+    gain_ramp_scalar(buffer + i, start + step * (float)i, step, frame_count - i);
+}
+
+static void mix_neon(float* dst, const float* src, float gain, uint32_t frame_count) {
+    float32x4_t g = vdupq_n_f32(gain);
+    uint32_t i = 0;
+    for (; i + 4 <= frame_count; i += 4) {
+        vst1q_f32(dst + i, vmlaq_f32(vld1q_f32(dst + i), vld1q_f32(src + i), g));
+    }
+    mix_scalar(dst + i, src + i, gain, frame_count - i);
+}
+
+static void measure_neon(const float* buffer, uint32_t frame_count, float clip_level,
+                         float* peak, float* sum_squares, uint32_t* clips) {
+    const float32x4_t level = vdupq_n_f32(clip_level);
+    float32x4_t max_abs = vdupq_n_f32(0.0F);
+    float32x4_t sum = vdupq_n_f32(0.0F);
+    uint32x4_t clip_lanes = vdupq_n_u32(0);
+    uint32_t i = 0;
+
+    for (; i + 4 <= frame_count; i += 4) {
+        float32x4_t x = vld1q_f32(buffer + i);
+        float32x4_t a = vabsq_f32(x);
+        max_abs = vmaxq_f32(max_abs, a);
+        sum = vmlaq_f32(sum, x, x);
+        clip_lanes = vsubq_u32(clip_lanes, vcgeq_f32(a, level));   // true lanes are all-ones (-1)
+    }
+
+    float tail_peak, tail_sum;
+    uint32_t tail_clips;
+    measure_scalar(buffer + i, frame_count - i, clip_level, &tail_peak, &tail_sum, &tail_clips);
+
+    float m = vmaxvq_f32(max_abs);
+    *peak = m > tail_peak ? m : tail_peak;
+    *sum_squares = vaddvq_f32(sum) + tail_sum;
+    *clips = vaddvq_u32(clip_lanes) + tail_clips;
+}
+
+static void interleave_neon(float* out, const float* left, const float* right, uint32_t frame_count) {
+    uint32_t i = 0;
+    for (; i + 4 <= frame_count; i += 4) {
+        float32x4x2_t lr = {{vld1q_f32(left + i), vld1q_f32(right + i)}};
+        vst2q_f32(out + i * 2, lr);
+    }
+    interleave_scalar(out + i * 2, left + i, right + i, frame_count - i);
+}
+
+static void complex_mac_neon(float* acc_re, float* acc_im, const float* a_re, const float* a_im,
+                             const float* b_re, const float* b_im, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t ar = vld1q_f32(a_re + i);
+        float32x4_t ai = vld1q_f32(a_im + i);
+        float32x4_t br = vld1q_f32(b_re + i);
+        float32x4_t bi = vld1q_f32(b_im + i);
+        float32x4_t re = vmlsq_f32(vmlaq_f32(vld1q_f32(acc_re + i), ar, br), ai, bi);
+        float32x4_t im = vmlaq_f32(vmlaq_f32(vld1q_f32(acc_im + i), ar, bi), ai, br);
+        vst1q_f32(acc_re + i, re);
+        vst1q_f32(acc_im + i, im);
+    }
+    complex_mac_scalar(acc_re + i, acc_im + i, a_re + i, a_im + i, b_re + i, b_im + i, count - i);
+}
+
+static void fir_neon(float* out, const float* in, const float* taps, uint32_t tap_count, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t acc = vdupq_n_f32(0.0F);
+        for (uint32_t k = 0; k < tap_count; k++) {
+            acc = vaddq_f32(acc, vmulq_n_f32(vld1q_f32(in + i + k), taps[k]));
+        }
+        vst1q_f32(out + i, acc);
+    }
+    fir_scalar(out + i, in + i, taps, tap_count, count - i);
+}
+
+// Left and right as the two lanes of one register, in the scalar kernel's
+// operation order
+static inline float32x2_t svf_frame_neon(const float32x2_t c[6], float32x2_t v0, float32x2_t* ic1,
+                                         float32x2_t* ic2) {
+    float32x2_t v3 = vsub_f32(v0, *ic2);
+    float32x2_t v1 = vadd_f32(vmul_f32(c[0], *ic1), vmul_f32(c[1], v3));
+    float32x2_t v2 = vadd_f32(vadd_f32(*ic2, vmul_f32(c[1], *ic1)), vmul_f32(c[2], v3));
+    *ic1 = vsub_f32(vmul_n_f32(v1, 2.0f), *ic1);
+    *ic2 = vsub_f32(vmul_n_f32(v2, 2.0f), *ic2);
+    return vadd_f32(vadd_f32(vmul_f32(c[3], v0), vmul_f32(c[4], v1)), vmul_f32(c[5], v2));
+}
+
+static void svf_stereo_neon(float* left, float* right, uint32_t frame_count, const DspSvfCoeffs* from,
+                            const DspSvfCoeffs* to, float state[4]) {
+    float32x2_t ic1 = vld1_f32(state);
+    float32x2_t ic2 = vld1_f32(state + 2);
+    bool glide = from != to && frame_count > 0;
+    const DspSvfCoeffs* start = glide ? from : to;
+    float32x2_t c[6] = {
+        vdup_n_f32(start->a1), vdup_n_f32(start->a2), vdup_n_f32(start->a3),
+        vdup_n_f32(start->m0), vdup_n_f32(start->m1), vdup_n_f32(start->m2),
+    };
+    float32x2_t step[6];
+    if (glide) {
+        DspSvfCoeffs s = svf_glide_step(from, to, frame_count);
+        step[0] = vdup_n_f32(s.a1);
+        step[1] = vdup_n_f32(s.a2);
+        step[2] = vdup_n_f32(s.a3);
+        step[3] = vdup_n_f32(s.m0);
+        step[4] = vdup_n_f32(s.m1);
+        step[5] = vdup_n_f32(s.m2);
+    }
+    for (uint32_t i = 0; i < frame_count; i++) {
+        if (glide) {
+            for (int k = 0; k < 6; k++) {
+                c[k] = vadd_f32(c[k], step[k]);
+            }
+        }
+        float32x2_t v0 = vset_lane_f32(right[i], vdup_n_f32(left[i]), 1);
+        float32x2_t out = svf_frame_neon(c, v0, &ic1, &ic2);
+        left[i] = vget_lane_f32(out, 0);
+        right[i] = vget_lane_f32(out, 1);
+    }
+    svf_store_state(state, vget_lane_f32(ic1, 0), vget_lane_f32(ic1, 1), vget_lane_f32(ic2, 0),
+                    vget_lane_f32(ic2, 1));
+}
+
+static const DspKernels kernels_neon = {
+    .name = "neon",
+    .gain = gain_neon,
+    .gain_ramp = gain_ramp_neon,
+    .mix = mix_neon,
+    .measure = measure_neon,
+    .interleave = interleave_neon,
+    .complex_mac = complex_mac_neon,
+    .fir = fir_neon,
+    .svf_stereo = svf_stereo_neon,
+};
+
+#endif // DSP_NEON
+
+// ============================================================================
+// DISPATCH
+// ============================================================================
+
+const DspKernels* dsp_kernels_get(DspKernelSet set) {
+    switch (set) {
+        case DSP_KERNELS_SCALAR:
+            return &kernels_scalar;
+#ifdef DSP_X86
+        case DSP_KERNELS_SSE2:
+            return &kernels_sse2;   // Baseline on every x86-64 CPU we run on
+        case DSP_KERNELS_AVX2:
+            return cpu_has_avx2() ? &kernels_avx2 : NULL;
+#endif
+#ifdef DSP_NEON
+        case DSP_KERNELS_NEON:
+            return &kernels_neon;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+const DspKernels* dsp_kernels_best(void) {
+    static const DspKernels* best = NULL;
+    if (best) {
+        return best;
+    }
+
+    const DspKernelSet preference[] = {DSP_KERNELS_AVX2, DSP_KERNELS_NEON, DSP_KERNELS_SSE2};
+    const DspKernels* found = &kernels_scalar;
+    for (size_t i = 0; i < sizeof(preference) / sizeof(preference[0]); i++) {
+        const DspKernels* k = dsp_kernels_get(preference[i]);
+        if (k) {
+            found = k;
+            break;
+        }
+    }
+    best = found;
+    return best;
+}
+
+// ============================================================================
+// ALIGNED ALLOCATION
+// ============================================================================
+
+void* dsp_aligned_alloc(size_t size, size_t alignment) {
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    void* ptr = NULL;
+    if (posix_memalign(&ptr, alignment, size) != 0) {
+        return NULL;
+    }
+    return ptr;
+#endif
+}
+
+void dsp_aligned_free(void* ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+// ============================================================================
+// FILTERS
+// ============================================================================
+
+DspSvfCoeffs dsp_svf_coeffs(DspSvfMode mode, float cutoff_hz, float q, float sample_rate) {
+    float nyquist_margin = 0.49f * sample_rate;
+    if (cutoff_hz < 1.0f) cutoff_hz = 1.0f;
+    if (cutoff_hz > nyquist_margin) cutoff_hz = nyquist_margin;
+    if (q < 0.05f) q = 0.05f;
+
+    float g = tanf(3.14159265f * cutoff_hz / sample_rate);
+    float k = 1.0f / q;
+    DspSvfCoeffs coeffs;
+    coeffs.a1 = 1.0f / (1.0f + g * (g + k));
+    coeffs.a2 = g * coeffs.a1;
+    coeffs.a3 = g * coeffs.a2;
+    if (mode == DSP_SVF_HIGHPASS) {
+        coeffs.m0 = 1.0f;
+        coeffs.m1 = -k;
+        coeffs.m2 = -1.0f;
+    } else {
+        coeffs.m0 = 0.0f;
+        coeffs.m1 = 0.0f;
+        coeffs.m2 = 1.0f;
+    }
+    return coeffs;
+}
@@ -0,0 +1,101 @@
+// dsp_kernels.h - Block-based DSP kernels with runtime SIMD dispatch
+// Hot loops of the mix path (gain, gain ramps, mix-accumulate, metering, final
+// interleave), of spectral effects (complex multiply-accumulate) and of the
+// oversampler's half-band filters (FIR) and of the filter effects (stereo
+// SVF) as whole-block kernels. Scalar, SSE2, AVX2 and NEON versions exist;
+// dsp_kernels_best() picks the widest one the CPU supports once at startup
+// and the engine calls through the returned table.
+#pragma once
+#ifndef DSP_KERNELS_H
+#define DSP_KERNELS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    DSP_KERNELS_SCALAR = 0,
+    DSP_KERNELS_SSE2,
+    DSP_KERNELS_AVX2,
+    DSP_KERNELS_NEON,
+    DSP_KERNELS_COUNT
+} DspKernelSet;
+
+// ============================================================================
+// STATE-VARIABLE FILTER
+// ============================================================================
+
+// Topology-preserving-transform (trapezoidal) state-variable filter. The
+// recurrence is the same for every mode; the output is mixed from its
+// input, band and low taps, so a mode is only a choice of m0..m2.
+typedef enum {
+    DSP_SVF_LOWPASS = 0,
+    DSP_SVF_HIGHPASS
+} DspSvfMode;
+
+typedef struct {
+    float a1, a2, a3;           // Recurrence, from g = tan(pi * cutoff / rate) and k = 1 / Q
+    float m0, m1, m2;           // Output = m0 * input + m1 * band + m2 * low
+} DspSvfCoeffs;
+
+// Coefficients for a cutoff in Hz and Q, computed once per parameter change
+// (the tan is the expensive part). The cutoff is clamped below Nyquist.
+DspSvfCoeffs dsp_svf_coeffs(DspSvfMode mode, float cutoff_hz, float q, float sample_rate);
+
+// ============================================================================
+// KERNEL SETS
+// ============================================================================
+
+typedef struct {
+    const char* name;
+
+    // buffer[i] *= gain
+    void (*gain)(float* buffer, float gain, uint32_t frame_count);
+
+    // buffer[i] *= start + step * i (a linear gain ramp, e.g. one automation segment)
+    void (*gain_ramp)(float* buffer, float start, float step, uint32_t frame_count);
+
+    // dst[i] += src[i] * gain
+    void (*mix)(float* dst, const float* src, float gain, uint32_t frame_count);
+
+    // Block statistics: max |x|, sum of x^2, samples with |x| >= clip_level
+    void (*measure)(const float* buffer, uint32_t frame_count, float clip_level,
+                    float* peak, float* sum_squares, uint32_t* clips);
+
+    // out[2i] = left[i], out[2i+1] = right[i]
+    void (*interleave)(float* out, const float* left, const float* right, uint32_t frame_count);
+
+    // Split-complex multiply-accumulate: acc[i] += a[i] * b[i]
+    void (*complex_mac)(float* acc_re, float* acc_im, const float* a_re, const float* a_im,
+                        const float* b_re, const float* b_im, uint32_t count);
+
+    // FIR as a correlation: out[i] = sum_k taps[k] * in[i + k], so `in` holds
+    // tap_count - 1 frames of history ahead of the block and callers store
+    // the taps reversed. Vectorized across outputs; each output sums its
+    // taps in order, so every set matches the scalar one closely.
+    void (*fir)(float* out, const float* in, const float* taps, uint32_t tap_count, uint32_t count);
+
+    // State-variable filter over a stereo block, in place; state holds the
+    // two integrators, L/R: {ic1[2], ic2[2]}. With from == to the
+    // coefficients are fixed, otherwise they move linearly from `from` and
+    // reach `to` on the last frame, so block-rate parameter changes glide
+    // instead of stepping. Integrators below about -300 dB are flushed to
+    // zero at the end of the block, so a decay never turns denormal. The
+    // recurrence is serial in time, so the vector sets run left and right as
+    // two lanes of one register and no wider: AVX2 uses the SSE2 kernel.
+    void (*svf_stereo)(float* left, float* right, uint32_t frame_count, const DspSvfCoeffs* from,
+                       const DspSvfCoeffs* to, float state[4]);
+} DspKernels;
+
+// Widest kernel set supported by this CPU (detected once, thread-safe after
+// the first call returns)
+const DspKernels* dsp_kernels_best(void);
+
+// A specific kernel set, or NULL if this build/CPU cannot run it
+const DspKernels* dsp_kernels_get(DspKernelSet set);
+
+// Aligned allocation for sample buffers (alignment must be a power of two)
+void* dsp_aligned_alloc(size_t size, size_t alignment);
+void dsp_aligned_free(void* ptr);
+
+#endif // DSP_KERNELS_H
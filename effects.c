@@ -0,0 +1,790 @@
+#include "effects.h"
+#include "convolver.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// PER-TYPE STATE
+// ============================================================================
+
+// Gain actually applied at the end of the last block; parameter changes
+// ramp from it across the next block instead of stepping
+typedef struct {
+    float current;
+    bool primed;                // False until the first block (starts at target)
+} GainState;
+
+// State-variable filter: integrators, and the coefficients last computed
+// with the parameters and rate they were computed for
+typedef struct {
+    float z[4];                 // DspKernels::svf_stereo state
+    DspSvfCoeffs coeffs;
+    float cutoff;
+    float resonance;
+    float sample_rate;
+    bool primed;                // False until the first block (starts at target)
+} FilterState;
+
+// Stereo delay line. Lines are a power of two long so the ring index wraps
+// with a mask; the read position trails the write position by a fractional
+// delay that glides towards the target once per block.
+typedef struct {
+    float* line[2];             // Allocated by create() on the control thread
+    uint32_t mask;              // Line length - 1
+    uint32_t write_pos;
+    float sample_rate;
+    float delay_samples;        // Current (smoothed) delay
+} DelayState;
+
+// Feedback delay network: EFFECT_REVERB_LINES lines of one power-of-two
+// length carved from a single allocation, each with a damping lowpass in
+// its feedback path. Lines are stored line-major so all taps of one frame
+// form a contiguous vector of line values.
+typedef struct {
+    float* lines;               // EFFECT_REVERB_LINES * (mask + 1), from create()
+    uint32_t mask;
+    uint32_t write_pos;
+    float sample_rate;
+    uint32_t length[EFFECT_REVERB_LINES];           // Current tap delays
+    float damp_state[EFFECT_REVERB_LINES];
+} ReverbState;
+
+// The convolver (spectra, FFT tables, tail thread) lives on the heap
+typedef struct {
+    Convolver* convolver;
+} ConvolutionState;
+
+// The plugin instance and where it came from, so a session can reload it
+// (the plugin is NULL if it could not be loaded)
+typedef struct {
+    ClapPlugin* plugin;
+    char* path;
+    char* plugin_id;
+} ClapState;
+
+_Static_assert(sizeof(GainState) <= EFFECT_STATE_BYTES, "GainState exceeds the effect state block");
+_Static_assert(sizeof(FilterState) <= EFFECT_STATE_BYTES, "FilterState exceeds the effect state block");
+_Static_assert(sizeof(DelayState) <= EFFECT_STATE_BYTES, "DelayState exceeds the effect state block");
+_Static_assert(sizeof(ReverbState) <= EFFECT_STATE_BYTES, "ReverbState exceeds the effect state block");
+_Static_assert(sizeof(ConvolutionState) <= EFFECT_STATE_BYTES, "ConvolutionState exceeds the effect state block");
+_Static_assert(sizeof(ClapState) <= EFFECT_STATE_BYTES, "ClapState exceeds the effect state block");
+_Static_assert(CLAP_HOST_MAX_PARAMS == EFFECT_MAX_PARAMS, "a plugin exposes one effect parameter block");
+
+// ============================================================================
+// PASS-THROUGH
+// ============================================================================
+
+static void none_set_defaults(Effect* effect) {
+    (void)effect;
+}
+
+static void none_set_param(Effect* effect, int param_index, float value) {
+    (void)effect;
+    (void)param_index;
+    (void)value;
+}
+
+static void none_process(Effect* effect, const DspKernels* dsp, float* left, float* right, uint32_t frame_count) {
+    (void)effect;
+    (void)dsp;
+    (void)left;
+    (void)right;
+    (void)frame_count;
+}
+
+// ============================================================================
+// GAIN
+// ============================================================================
+
+static void gain_set_defaults(Effect* effect) {
+    effect->gain_params.gain = 1.0f;
+}
+
+static void gain_set_param(Effect* effect, int param_index, float value) {
+    if (param_index == 0) effect->gain_params.gain = value;
+}
+
+static void gain_process(Effect* effect, const DspKernels* dsp, float* left, float* right, uint32_t frame_count) {
+    GainState* state = (GainState*)effect->state;
+    float target = effect->gain_params.gain;
+    if (!state->primed || state->current == target) {
+        state->current = target;
+        state->primed = true;
+        dsp->gain(left, target, frame_count);
+        dsp->gain(right, target, frame_count);
+        return;
+    }
+
+    float step = (target - state->current) / (float)frame_count;
+    dsp->gain_ramp(left, state->current + step, step, frame_count);
+    dsp->gain_ramp(right, state->current + step, step, frame_count);
+    state->current = target;
+}
+
+// ============================================================================
+// FILTERS
+// ============================================================================
+
+static void filter_set_defaults(Effect* effect) {
+    effect->filter_params.cutoff = 1000.0f;
+    effect->filter_params.resonance = 0.70710678f;
+}
+
+static void filter_set_param(Effect* effect, int param_index, float value) {
+    if (param_index == 0) effect->filter_params.cutoff = value;
+    else if (param_index == 1) effect->filter_params.resonance = value;
+}
+
+static bool filter_create(Effect* effect, const EffectCreateInfo* info) {
+    FilterState* state = (FilterState*)effect->state;
+    state->sample_rate = info->sample_rate;
+    return true;
+}
+
+// Coefficients are recomputed only when a parameter has moved since the
+// last block; the block then glides from the old ones to the new
+static void filter_process(Effect* effect, const DspKernels* dsp, DspSvfMode mode, float* left, float* right,
+                           uint32_t frame_count) {
+    FilterState* state = (FilterState*)effect->state;
+    float cutoff = effect->filter_params.cutoff;
+    float resonance = effect->filter_params.resonance;
+    if (state->primed && cutoff == state->cutoff && resonance == state->resonance) {
+        dsp->svf_stereo(left, right, frame_count, &state->coeffs, &state->coeffs, state->z);
+        return;
+    }
+
+    DspSvfCoeffs target = dsp_svf_coeffs(mode, cutoff, resonance, state->sample_rate);
+    DspSvfCoeffs from = state->primed ? state->coeffs : target;
+    dsp->svf_stereo(left, right, frame_count, &from, &target, state->z);
+    state->coeffs = target;
+    state->cutoff = cutoff;
+    state->resonance = resonance;
+    state->primed = true;
+}
+
+static void lowpass_process(Effect* effect, const DspKernels* dsp, float* left, float* right, uint32_t frame_count) {
+    filter_process(effect, dsp, DSP_SVF_LOWPASS, left, right, frame_count);
+}
+
+static void highpass_process(Effect* effect, const DspKernels* dsp, float* left, float* right, uint32_t frame_count) {
+    filter_process(effect, dsp, DSP_SVF_HIGHPASS, left, right, frame_count);
+}
+
+// ============================================================================
+// DELAY
+// ============================================================================
+
+static void delay_set_defaults(Effect* effect) {
+    effect->delay_params.time_ms = 250.0f;
+    effect->delay_params.feedback = 0.3f;
+    effect->delay_params.mix = 0.5f;
+}
+
+static void delay_set_param(Effect* effect, int param_index, float value) {
+    if (param_index == 0) effect->delay_params.time_ms = value;
+    else if (param_index == 1) effect->delay_params.feedback = value;
+    else if (param_index == 2) effect->delay_params.mix = value;
+}
+
+static bool delay_create(Effect* effect, const EffectCreateInfo* info) {
+    DelayState* state = (DelayState*)effect->state;
+    float sample_rate = info->sample_rate;
+
+    // Room for the longest delay plus the interpolation neighbour
+    uint32_t needed = (uint32_t)(EFFECT_DELAY_MAX_MS * 0.001f * sample_rate) + 2;
+    uint32_t length = 1;
+    while (length < needed) length <<= 1;
+
+    for (int c = 0; c < 2; c++) {
+        state->line[c] = (float*)dsp_aligned_alloc(sizeof(float) * length, EFFECT_STATE_ALIGNMENT);
+        if (!state->line[c]) {
+            dsp_aligned_free(state->line[0]);
+            state->line[0] = NULL;
+            return false;
+        }
+        memset(state->line[c], 0, sizeof(float) * length);
+    }
+    state->mask = length - 1;
+    state->sample_rate = sample_rate;
+    state->delay_samples = effect->delay_params.time_ms * sample_rate / 1000.0f;
+    return true;
+}
+
+// An echo can come back a whole line later
+static uint32_t delay_tail(const Effect* effect) {
+    const DelayState* state = (const DelayState*)effect->state;
+    return state->mask + 1;
+}
+
+static void delay_destroy(Effect* effect) {
+    DelayState* state = (DelayState*)effect->state;
+    dsp_aligned_free(state->line[0]);
+    dsp_aligned_free(state->line[1]);
+    state->line[0] = NULL;
+    state->line[1] = NULL;
+}
+
+static void delay_process(Effect* effect, const DspKernels* dsp, float* left, float* right, uint32_t frame_count) {
+    (void)dsp;
+    DelayState* state = (DelayState*)effect->state;
+    if (frame_count == 0) return;
+
+    // Per-block setup: clamp parameters, then glide linearly from the current
+    // delay to the target across the block so time changes never click and
+    // never touch the allocator
+    float max_delay = (float)(state->mask - 1);
+    float target = effect->delay_params.time_ms * state->sample_rate / 1000.0f;
+    if (target < 1.0f) target = 1.0f;
+    if (target > max_delay) target = max_delay;
+    float feedback = effect->delay_params.feedback;
+    if (feedback < -0.99f) feedback = -0.99f;
+    if (feedback > 0.99f) feedback = 0.99f;
+    float wet = effect->delay_params.mix;
+    float dry = 1.0f - wet;
+
+    float* line_l = state->line[0];
+    float* line_r = state->line[1];
+    uint32_t mask = state->mask;
+    uint32_t write_pos = state->write_pos;
+    float delay = state->delay_samples;
+    float step = (target - delay) / (float)frame_count;
+
+    for (uint32_t i = 0; i < frame_count; i++) {
+        delay += step;
+
+        // Linear interpolation between the samples `whole` and `whole + 1`
+        // behind the write position (integer index math keeps long lines exact)
+        uint32_t whole = (uint32_t)delay;
+        float frac = delay - (float)whole;
+        uint32_t i0 = (write_pos - whole) & mask;
+        uint32_t i1 = (i0 - 1) & mask;
+        float dl = line_l[i0] + (line_l[i1] - line_l[i0]) * frac;
+        float dr = line_r[i0] + (line_r[i1] - line_r[i0]) * frac;
+
+        line_l[write_pos] = left[i] + dl * feedback;
+        line_r[write_pos] = right[i] + dr * feedback;
+        left[i] = left[i] * dry + dl * wet;
+        right[i] = right[i] * dry + dr * wet;
+        write_pos = (write_pos + 1) & mask;
+    }
+
+    state->write_pos = write_pos;
+    state->delay_samples = target;
+}
+
+// ============================================================================
+// REVERB
+// ============================================================================
+
+// Mutually prime line lengths at 48 kHz for room_size 0.5; room_size scales
+// them by 0.5x..1.5x
+static const uint32_t reverb_base_lengths[EFFECT_REVERB_LINES] = {
+    1031, 1153, 1327, 1523, 1741, 1933, 2221, 2417,
+};
+
+// Input and output polarity per line, so stereo decorrelates
+static const float reverb_in_sign[EFFECT_REVERB_LINES] = {1, -1, 1, -1, 1, 1, -1, -1};
+static const float reverb_left_tap[EFFECT_REVERB_LINES] = {1, 0, 1, 0, -1, 0, 1, 0};
+static const float reverb_right_tap[EFFECT_REVERB_LINES] = {0, 1, 0, -1, 0, 1, 0, 1};
+
+#define REVERB_OUTPUT_GAIN 0.35f
+
+static void reverb_set_defaults(Effect* effect) {
+    effect->reverb_params.room_size = 0.5f;
+    effect->reverb_params.damping = 0.5f;
+    effect->reverb_params.mix = 0.3f;
+    effect->reverb_params.send = 0.0f;
+}
+
+static void reverb_set_param(Effect* effect, int param_index, float value) {
+    if (param_index == 0) effect->reverb_params.room_size = value;
+    else if (param_index == 1) effect->reverb_params.damping = value;
+    else if (param_index == 2) effect->reverb_params.mix = value;
+    else if (param_index == 3) effect->reverb_params.send = value;
+}
+
+static bool reverb_create(Effect* effect, const EffectCreateInfo* info) {
+    ReverbState* state = (ReverbState*)effect->state;
+    float sample_rate = info->sample_rate;
+
+    // Longest line at the largest room, scaled to the device rate
+    uint32_t needed = (uint32_t)(reverb_base_lengths[EFFECT_REVERB_LINES - 1] * 1.5f * sample_rate / 48000.0f) + 1;
+    uint32_t length = 1;
+    while (length < needed) length <<= 1;
+
+    size_t bytes = sizeof(float) * length * EFFECT_REVERB_LINES;
+    state->lines = (float*)dsp_aligned_alloc(bytes, EFFECT_STATE_ALIGNMENT);
+    if (!state->lines) {
+        return false;
+    }
+    memset(state->lines, 0, bytes);
+    state->mask = length - 1;
+    state->sample_rate = sample_rate;
+    return true;
+}
+
+// Every line must have drained through its tap
+static uint32_t reverb_tail(const Effect* effect) {
+    const ReverbState* state = (const ReverbState*)effect->state;
+    return state->mask + 1;
+}
+
+static void reverb_destroy(Effect* effect) {
+    ReverbState* state = (ReverbState*)effect->state;
+    dsp_aligned_free(state->lines);
+    state->lines = NULL;
+}
+
+static void reverb_process(Effect* effect, const DspKernels* dsp, float* left, float* right, uint32_t frame_count) {
+    (void)dsp;
+    ReverbState* state = (ReverbState*)effect->state;
+
+    // Per-block setup: line lengths, decay and damping are fixed for the
+    // block, so the cost per frame is constant whatever the parameters
+    float room = effect->reverb_params.room_size;
+    if (room < 0.0f) room = 0.0f;
+    if (room > 1.0f) room = 1.0f;
+    float damping = effect->reverb_params.damping;
+    if (damping < 0.0f) damping = 0.0f;
+    if (damping > 1.0f) damping = 1.0f;
+    float decay = 0.75f + 0.22f * room;
+    float damp = damping * 0.7f;
+    float wet = effect->reverb_params.mix * REVERB_OUTPUT_GAIN;
+    float dry = effect->reverb_params.send != 0.0f ? 0.0f : 1.0f - effect->reverb_params.mix;
+
+    float scale = (0.5f + room) * state->sample_rate / 48000.0f;
+    for (int k = 0; k < EFFECT_REVERB_LINES; k++) {
+        uint32_t length = (uint32_t)(reverb_base_lengths[k] * scale);
+        if (length < 1) length = 1;
+        if (length > state->mask) length = state->mask;
+        state->length[k] = length;
+    }
+
+    uint32_t mask = state->mask;
+    uint32_t stride = mask + 1;
+    uint32_t write_pos = state->write_pos;
+    float* lines = state->lines;
+    float damp_state[EFFECT_REVERB_LINES];
+    memcpy(damp_state, state->damp_state, sizeof(damp_state));
+
+    for (uint32_t i = 0; i < frame_count; i++) {
+        float input = (left[i] + right[i]) * 0.5f;
+
+        // Gather one tap per line
+        float tap[EFFECT_REVERB_LINES];
+        for (int k = 0; k < EFFECT_REVERB_LINES; k++) {
+            tap[k] = lines[k * stride + ((write_pos - state->length[k]) & mask)];
+        }
+
+        // Damping, Householder feedback matrix (I - 2/N * 1*1^T) and output
+        // taps: fixed-width loops over the line vector, so they compile to
+        // straight SIMD with no per-line branches
+        float sum = 0.0f;
+        float out_l = 0.0f;
+        float out_r = 0.0f;
+        for (int k = 0; k < EFFECT_REVERB_LINES; k++) {
+            damp_state[k] = tap[k] + (damp_state[k] - tap[k]) * damp;
+            sum += damp_state[k];
+            out_l += damp_state[k] * reverb_left_tap[k];
+            out_r += damp_state[k] * reverb_right_tap[k];
+        }
+        float reflect = sum * (2.0f / EFFECT_REVERB_LINES);
+        for (int k = 0; k < EFFECT_REVERB_LINES; k++) {
+            lines[k * stride + write_pos] = (damp_state[k] - reflect) * decay + input * reverb_in_sign[k];
+        }
+
+        left[i] = left[i] * dry + out_l * wet;
+        right[i] = right[i] * dry + out_r * wet;
+        write_pos = (write_pos + 1) & mask;
+    }
+
+    state->write_pos = write_pos;
+    memcpy(state->damp_state, damp_state, sizeof(damp_state));
+}
+
+// ============================================================================
+// CONVOLUTION
+// ============================================================================
+
+static void convolution_set_defaults(Effect* effect) {
+    effect->convolution_params.mix = 0.5f;
+    effect->convolution_params.send = 0.0f;
+}
+
+static void convolution_set_param(Effect* effect, int param_index, float value) {
+    if (param_index == 0) effect->convolution_params.mix = value;
+    else if (param_index == 1) effect->convolution_params.send = value;
+}
+
+static bool convolution_create(Effect* effect, const EffectCreateInfo* info) {
+    ConvolutionState* state = (ConvolutionState*)effect->state;
+    state->convolver = (Convolver*)malloc(sizeof(Convolver));
+    if (!state->convolver) {
+        return false;
+    }
+    const DspKernels* dsp = info->dsp ? info->dsp : dsp_kernels_best();
+    if (!convolver_init(state->convolver, info->ir, info->ir_frames, info->ir_channels, dsp)) {
+        free(state->convolver);
+        state->convolver = NULL;
+        return false;
+    }
+    return true;
+}
+
+static void convolution_destroy(Effect* effect) {
+    ConvolutionState* state = (ConvolutionState*)effect->state;
+    if (state->convolver) {
+        convolver_destroy(state->convolver);
+        free(state->convolver);
+        state->convolver = NULL;
+    }
+}
+
+static void convolution_process(Effect* effect, const DspKernels* dsp, float* left, float* right,
+                                uint32_t frame_count) {
+    ConvolutionState* state = (ConvolutionState*)effect->state;
+    float wet = effect->convolution_params.mix;
+    float dry = effect->convolution_params.send != 0.0f ? 0.0f : 1.0f - wet;
+    convolver_process(state->convolver, dsp, left, right, frame_count, dry, wet);
+}
+
+static void convolution_set_offline(Effect* effect, bool offline) {
+    ConvolutionState* state = (ConvolutionState*)effect->state;
+    convolver_set_blocking(state->convolver, offline);
+}
+
+static uint32_t convolution_latency(const Effect* effect) {
+    const ConvolutionState* state = (const ConvolutionState*)effect->state;
+    return convolver_latency(state->convolver);
+}
+
+// The whole impulse response, after the latency
+static uint32_t convolution_tail(const Effect* effect) {
+    const ConvolutionState* state = (const ConvolutionState*)effect->state;
+    const Convolver* conv = state->convolver;
+    return conv->partition_count * conv->partition_frames + convolver_latency(conv);
+}
+
+// Dry only: keeps the delay (and the input history, so the tail picks up
+// where it left off when re-enabled)
+static void convolution_bypass(Effect* effect, const DspKernels* dsp, float* left, float* right,
+                               uint32_t frame_count) {
+    ConvolutionState* state = (ConvolutionState*)effect->state;
+    convolver_process(state->convolver, dsp, left, right, frame_count, 1.0f, 0.0f);
+}
+
+// ============================================================================
+// CLAP PLUGIN
+// ============================================================================
+
+// Defaults come from the plugin in create()
+static void clap_set_defaults(Effect* effect) {
+    (void)effect;
+}
+
+static void clap_set_param(Effect* effect, int param_index, float value) {
+    ClapState* state = (ClapState*)effect->state;
+    if (param_index < 0 || param_index >= EFFECT_MAX_PARAMS) {
+        return;
+    }
+    effect->clap_params.values[param_index] = value;
+    if (state->plugin) {
+        clap_plugin_queue_param(state->plugin, (uint32_t)param_index, value);
+    }
+}
+
+static char* copy_string(const char* text) {
+    if (!text) {
+        return NULL;
+    }
+    size_t length = strlen(text) + 1;
+    char* copy = (char*)malloc(length);
+    if (copy) {
+        memcpy(copy, text, length);
+    }
+    return copy;
+}
+
+static void clap_destroy(Effect* effect) {
+    ClapState* state = (ClapState*)effect->state;
+    clap_plugin_unload(state->plugin);
+    free(state->path);
+    free(state->plugin_id);
+    memset(state, 0, sizeof(ClapState));
+}
+
+static bool clap_create(Effect* effect, const EffectCreateInfo* info) {
+    ClapState* state = (ClapState*)effect->state;
+    if (info->max_frames == 0) {
+        return false;
+    }
+    state->path = copy_string(info->plugin_path);
+    state->plugin_id = copy_string(info->plugin_id);
+    if ((info->plugin_path && !state->path) || (info->plugin_id && !state->plugin_id)) {
+        clap_destroy(effect);
+        return false;
+    }
+
+    if (info->plugin_entry) {
+        state->plugin = clap_plugin_load_entry(info->plugin_entry, info->plugin_path, info->plugin_id,
+                                               info->sample_rate, info->max_frames);
+    } else if (info->plugin_path) {
+        state->plugin = clap_plugin_load(info->plugin_path, info->plugin_id, info->sample_rate, info->max_frames);
+    }
+    if (!state->plugin) {
+        if (!info->keep_missing_plugin) {
+            clap_destroy(effect);
+            return false;
+        }
+        return true;
+    }
+    for (uint32_t p = 0; p < clap_plugin_param_count(state->plugin); p++) {
+        effect->clap_params.values[p] = clap_plugin_param_value(state->plugin, p);
+    }
+    return true;
+}
+
+static void clap_process(Effect* effect, const DspKernels* dsp, float* left, float* right, uint32_t frame_count) {
+    (void)dsp;
+    ClapState* state = (ClapState*)effect->state;
+    if (state->plugin) {
+        clap_plugin_process(state->plugin, left, right, frame_count);
+    }
+}
+
+static void clap_set_offline(Effect* effect, bool offline) {
+    ClapState* state = (ClapState*)effect->state;
+    if (state->plugin) {
+        clap_plugin_set_offline(state->plugin, offline);
+    }
+}
+
+static uint32_t clap_latency(const Effect* effect) {
+    const ClapState* state = (const ClapState*)effect->state;
+    return state->plugin ? clap_plugin_latency(state->plugin) : 0;
+}
+
+static uint32_t clap_tail(const Effect* effect) {
+    const ClapState* state = (const ClapState*)effect->state;
+    return state->plugin ? clap_plugin_tail(state->plugin) : 0;
+}
+
+static void clap_bypass(Effect* effect, const DspKernels* dsp, float* left, float* right, uint32_t frame_count) {
+    (void)dsp;
+    ClapState* state = (ClapState*)effect->state;
+    if (state->plugin) {
+        clap_plugin_bypass(state->plugin, left, right, frame_count);
+    }
+}
+
+// ============================================================================
+// TYPE TABLE
+// ============================================================================
+
+static const EffectVTable effect_vtables[EFFECT_TYPE_COUNT] = {
+    [EFFECT_NONE] = {"None", 0, none_set_defaults, NULL, NULL, none_set_param, none_process},
+    [EFFECT_GAIN] = {"Gain", 1, gain_set_defaults, NULL, NULL, gain_set_param, gain_process},
+    [EFFECT_LOWPASS] = {"Lowpass", 2, filter_set_defaults, filter_create, NULL, filter_set_param, lowpass_process},
+    [EFFECT_HIGHPASS] = {"Highpass", 2, filter_set_defaults, filter_create, NULL, filter_set_param, highpass_process},
+    [EFFECT_DELAY] = {"Delay", 3, delay_set_defaults, delay_create, delay_destroy, delay_set_param, delay_process,
+                      .tail = delay_tail},
+    [EFFECT_REVERB] = {"Reverb", 4, reverb_set_defaults, reverb_create, reverb_destroy, reverb_set_param, reverb_process,
+                       .tail = reverb_tail},
+    [EFFECT_CONVOLUTION] = {"Convolution", 2, convolution_set_defaults, convolution_create, convolution_destroy,
+                            convolution_set_param, convolution_process, convolution_set_offline, convolution_latency,
+                            convolution_bypass, convolution_tail},
+    [EFFECT_CLAP] = {"CLAP", EFFECT_MAX_PARAMS, clap_set_defaults, clap_create, clap_destroy, clap_set_param,
+                     clap_process, clap_set_offline, clap_latency, clap_bypass, clap_tail},
+};
+
+const EffectVTable* effect_vtable(EffectType type) {
+    if ((int)type < 0 || type >= EFFECT_TYPE_COUNT) {
+        return &effect_vtables[EFFECT_NONE];
+    }
+    return &effect_vtables[type];
+}
+
+// The block a chunk at a time: up, through the effect at the top rate
+// (unless bypassed), and back down
+static void process_oversampled(Effect* effect, const DspKernels* dsp, float* left, float* right,
+                                uint32_t frame_count, bool bypassed) {
+    const EffectVTable* vtable = effect_vtable(effect->type);
+    for (uint32_t offset = 0; offset < frame_count; offset += OVERSAMPLER_CHUNK_FRAMES) {
+        uint32_t chunk = frame_count - offset < OVERSAMPLER_CHUNK_FRAMES ? frame_count - offset
+                                                                         : OVERSAMPLER_CHUNK_FRAMES;
+        float* top[2];
+        oversampler_up(effect->oversampler, dsp, left + offset, right + offset, chunk, top);
+        if (!bypassed) {
+            vtable->process(effect, dsp, top[0], top[1], chunk * effect->oversampling);
+        }
+        oversampler_down(effect->oversampler, dsp, left + offset, right + offset, chunk);
+    }
+}
+
+void effect_process(Effect* effect, const DspKernels* dsp, float* left, float* right, uint32_t frame_count) {
+    if (effect->oversampler) {
+        process_oversampled(effect, dsp, left, right, frame_count, false);
+        return;
+    }
+    effect_vtable(effect->type)->process(effect, dsp, left, right, frame_count);
+}
+
+void effect_bypass(Effect* effect, const DspKernels* dsp, float* left, float* right, uint32_t frame_count) {
+    const EffectVTable* vtable = effect_vtable(effect->type);
+    if (effect->oversampler) {
+        process_oversampled(effect, dsp, left, right, frame_count, true);
+    } else if (vtable->bypass) {
+        vtable->bypass(effect, dsp, left, right, frame_count);
+    }
+}
+
+uint32_t effect_latency(const Effect* effect) {
+    if (effect->oversampler) {
+        return oversampler_latency(effect->oversampler);
+    }
+    const EffectVTable* vtable = effect_vtable(effect->type);
+    return vtable->latency ? vtable->latency(effect) : 0;
+}
+
+// Oversampled tails are counted at the top rate
+uint32_t effect_tail(const Effect* effect) {
+    const EffectVTable* vtable = effect_vtable(effect->type);
+    uint32_t tail = vtable->tail ? vtable->tail(effect) : 0;
+    if (effect->oversampler) {
+        tail = (tail + effect->oversampling - 1) / effect->oversampling + oversampler_latency(effect->oversampler);
+    }
+    return tail;
+}
+
+// Every parameter block is a run of floats in set_param order
+_Static_assert(sizeof(((Effect*)0)->reverb_params) == sizeof(float) * EFFECT_MAX_PARAMS,
+               "the largest parameter block sets EFFECT_MAX_PARAMS");
+
+float effect_get_param(const Effect* effect, int param_index) {
+    if (param_index < 0 || param_index >= effect_vtable(effect->type)->param_count) {
+        return 0.0f;
+    }
+    return ((const float*)&effect->gain_params)[param_index];
+}
+
+bool effect_plugin_source(const Effect* effect, const char** path, const char** plugin_id) {
+    if (effect->type != EFFECT_CLAP || !effect->state) {
+        return false;
+    }
+    const ClapState* state = (const ClapState*)effect->state;
+    *path = state->path;
+    *plugin_id = state->plugin_id;
+    return true;
+}
+
+const ClapPlugin* effect_plugin(const Effect* effect) {
+    if (effect->type != EFFECT_CLAP || !effect->state) {
+        return NULL;
+    }
+    return ((const ClapState*)effect->state)->plugin;
+}
+
+// ============================================================================
+// STATE POOL
+// ============================================================================
+
+bool effect_state_pool_init(EffectStatePool* pool, int block_count) {
+    memset(pool, 0, sizeof(EffectStatePool));
+    pool->blocks = (uint8_t*)dsp_aligned_alloc((size_t)block_count * EFFECT_STATE_BYTES, EFFECT_STATE_ALIGNMENT);
+    pool->free_list = (int*)malloc(sizeof(int) * (size_t)block_count);
+    if (!pool->blocks || !pool->free_list) {
+        effect_state_pool_destroy(pool);
+        return false;
+    }
+
+    // Hand out low blocks first so small sessions stay in few cache lines
+    pool->block_count = block_count;
+    for (int i = 0; i < block_count; i++) {
+        pool->free_list[i] = block_count - 1 - i;
+    }
+    pool->free_count = block_count;
+    return true;
+}
+
+void effect_state_pool_destroy(EffectStatePool* pool) {
+    dsp_aligned_free(pool->blocks);
+    free(pool->free_list);
+    memset(pool, 0, sizeof(EffectStatePool));
+}
+
+void* effect_state_pool_alloc(EffectStatePool* pool) {
+    if (pool->free_count == 0) {
+        return NULL;
+    }
+    int index = pool->free_list[--pool->free_count];
+    void* block = pool->blocks + (size_t)index * EFFECT_STATE_BYTES;
+    memset(block, 0, EFFECT_STATE_BYTES);
+    return block;
+}
+
+void effect_state_pool_release(EffectStatePool* pool, void* block) {
+    if (!block) {
+        return;
+    }
+    ptrdiff_t offset = (uint8_t*)block - pool->blocks;
+    if (offset < 0 || offset % EFFECT_STATE_BYTES != 0 || offset / EFFECT_STATE_BYTES >= pool->block_count) {
+        return;
+    }
+    pool->free_list[pool->free_count++] = (int)(offset / EFFECT_STATE_BYTES);
+}
+
+// ============================================================================
+// INSTANCES
+// ============================================================================
+
+bool effect_instance_create(Effect* effect, EffectType type, EffectStatePool* pool, const EffectCreateInfo* info) {
+    void* state = effect_state_pool_alloc(pool);
+    if (!state) {
+        return false;
+    }
+
+    const EffectVTable* vtable = effect_vtable(type);
+    uint32_t oversampling = info->oversampling > 1 ? info->oversampling : 1;
+    if (oversampling > 1 && (!oversampler_factor_valid(oversampling) || vtable->latency)) {
+        effect_state_pool_release(pool, state);
+        return false;
+    }
+    memset(effect, 0, sizeof(Effect));
+    effect->type = type;
+    effect->enabled = true;
+    effect->state = state;
+    effect->oversampling = oversampling;
+    vtable->set_defaults(effect);
+
+    // Oversampled instances are created for the rate they run at
+    EffectCreateInfo rate_info = *info;
+    rate_info.sample_rate = info->sample_rate * (float)oversampling;
+    if (vtable->create && !vtable->create(effect, &rate_info)) {
+        effect_state_pool_release(pool, state);
+        memset(effect, 0, sizeof(Effect));
+        return false;
+    }
+    if (oversampling > 1) {
+        effect->oversampler = oversampler_create(oversampling);
+        if (!effect->oversampler) {
+            effect_instance_destroy(effect, pool);
+            memset(effect, 0, sizeof(Effect));
+            return false;
+        }
+    }
+    return true;
+}
+
+void effect_instance_destroy(Effect* effect, EffectStatePool* pool) {
+    if (!effect->state) {
+        return;
+    }
+    const EffectVTable* vtable = effect_vtable(effect->type);
+    if (vtable->destroy) {
+        vtable->destroy(effect);
+    }
+    oversampler_destroy(effect->oversampler);
+    effect->oversampler = NULL;
+    effect_state_pool_release(pool, effect->state);
+    effect->state = NULL;
+}
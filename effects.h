@@ -0,0 +1,226 @@
+// effects.h - Effect parameters, per-instance state and effect chains
+// Every effect instance owns a cache-line-aligned state block from the
+// engine's EffectStatePool, and each effect type is processed through an
+// EffectVTable. Tracks and buses both own an EffectChain: a fixed set of
+// stable effect slots plus the chain order used to build render graph
+// snapshots.
+#pragma once
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include "clap_host.h"
+#include "dsp_kernels.h"
+#include "oversampler.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MAX_EFFECTS_PER_TRACK 8
+#define EFFECT_STATE_BYTES 128          // Per-instance state block (two cache lines)
+#define EFFECT_STATE_ALIGNMENT 64
+#define EFFECT_DELAY_MAX_MS 2000.0f     // Longest delay time; lines are sized for it at creation
+#define EFFECT_REVERB_LINES 8           // Feedback delay network order
+#define EFFECT_MAX_PARAMS 4             // Most param_count of any type
+
+// ============================================================================
+// EFFECT TYPES
+// ============================================================================
+
+typedef enum {
+    EFFECT_NONE = 0,
+    EFFECT_GAIN,
+    EFFECT_LOWPASS,
+    EFFECT_HIGHPASS,
+    EFFECT_DELAY,
+    EFFECT_REVERB,
+    EFFECT_CONVOLUTION,
+    EFFECT_CLAP,
+    EFFECT_TYPE_COUNT
+} EffectType;
+
+typedef struct {
+    EffectType type;
+    bool enabled;
+    void* state;            // EFFECT_STATE_BYTES, owned by this instance (audio thread only)
+    uint32_t oversampling;  // Rate the instance runs at, as a multiple of the engine's (1, 2, 4 or 8)
+    Oversampler* oversampler;   // Converts to and from that rate; NULL at 1
+
+    union {
+        struct {
+            float gain;
+        } gain_params;
+
+        struct {
+            float cutoff;       // Hz
+            float resonance;    // Q: 0.707 is maximally flat, higher peaks at the cutoff
+        } filter_params;
+
+        struct {
+            float time_ms;
+            float feedback;
+            float mix;
+        } delay_params;
+
+        struct {
+            float room_size;
+            float damping;
+            float mix;
+            float send;     // Non-zero: wet only, for a shared reverb on a send bus
+        } reverb_params;
+
+        struct {
+            float mix;
+            float send;     // Non-zero: wet only
+        } convolution_params;
+
+        struct {
+            float values[EFFECT_MAX_PARAMS];    // The plugin's first parameters, in its own units
+        } clap_params;
+    };
+} Effect;
+
+// ============================================================================
+// EFFECT TYPE TABLE
+// ============================================================================
+
+// Everything create() may need besides the parameters
+typedef struct {
+    float sample_rate;
+    const DspKernels* dsp;          // Kernels for background work (may be NULL: best)
+    const float* ir;                // EFFECT_CONVOLUTION: interleaved IR, copied (NULL: unit impulse)
+    uint32_t ir_frames;
+    uint32_t ir_channels;           // 1 or 2
+    uint32_t oversampling;          // 0 or 1: the engine rate; 2, 4 or 8: behind an Oversampler
+    const char* plugin_path;        // EFFECT_CLAP: .clap file, copied (NULL with plugin_entry)
+    const char* plugin_id;          // EFFECT_CLAP: descriptor id, copied (NULL: the first plugin)
+    const struct clap_plugin_entry* plugin_entry;   // EFFECT_CLAP: an entry linked into the host
+    uint32_t max_frames;            // EFFECT_CLAP: largest block process() is given (required)
+    bool keep_missing_plugin;       // EFFECT_CLAP: a plugin that fails to load passes audio through
+} EffectCreateInfo;
+
+typedef struct {
+    const char* name;
+    int param_count;
+
+    // Write default parameters
+    void (*set_defaults)(Effect* effect);
+
+    // Optional: acquire large buffers (delay lines etc.) on the control
+    // thread after the state block has been zeroed; references go in the
+    // state block. Returns false on allocation failure.
+    bool (*create)(Effect* effect, const EffectCreateInfo* info);
+
+    // Optional: release whatever create() acquired (control thread, once no
+    // render graph can reference the instance any more)
+    void (*destroy)(Effect* effect);
+
+    void (*set_param)(Effect* effect, int param_index, float value);
+
+    // Process one planar stereo block in place (audio thread)
+    void (*process)(Effect* effect, const DspKernels* dsp, float* left, float* right, uint32_t frame_count);
+
+    // Optional: switch to (or back from) offline rendering, where process()
+    // may wait on helper threads to stay deterministic. Called on the
+    // control thread while nothing is rendering.
+    void (*set_offline)(Effect* effect, bool offline);
+
+    // Optional: frames the output lags the input by (0 if NULL). Fixed once
+    // create() has run, so the control thread may ask at any time; the
+    // render graph compensates every other path for it.
+    uint32_t (*latency)(const Effect* effect);
+
+    // Required with latency: process a disabled instance, delaying the block
+    // by the same latency so the compensation stays valid (audio thread)
+    void (*bypass)(Effect* effect, const DspKernels* dsp, float* left, float* right, uint32_t frame_count);
+
+    // Optional: how long the output may go on sounding (or stay quiet and
+    // then sound again, as an echo does) once the input is silent, latency
+    // included; 0 if NULL. Fixed once create() has run, like latency.
+    uint32_t (*tail)(const Effect* effect);
+} EffectVTable;
+
+// Table for a type (EFFECT_NONE and unknown types get a pass-through entry)
+const EffectVTable* effect_vtable(EffectType type);
+
+// Process one block through an enabled instance, at its own rate (audio
+// thread)
+void effect_process(Effect* effect, const DspKernels* dsp, float* left, float* right, uint32_t frame_count);
+
+// Process one block through a disabled instance: latent types run their
+// bypass, oversampled instances go up and back down without the effect, so
+// the delay (and the filters' history) stays the same (audio thread)
+void effect_bypass(Effect* effect, const DspKernels* dsp, float* left, float* right, uint32_t frame_count);
+
+// Reported latency of an instance in frames, enabled or not
+uint32_t effect_latency(const Effect* effect);
+
+// Reported tail of an instance in frames
+uint32_t effect_tail(const Effect* effect);
+
+// Current value of a parameter by set_param index (0 if out of range)
+float effect_get_param(const Effect* effect, int param_index);
+
+// Where an EFFECT_CLAP instance was loaded from (either may be NULL, as
+// given at creation), whether or not the plugin is loaded. False for other
+// types.
+bool effect_plugin_source(const Effect* effect, const char** path, const char** plugin_id);
+
+// The loaded plugin of an EFFECT_CLAP instance (NULL if it could not be
+// loaded, or for other types)
+const ClapPlugin* effect_plugin(const Effect* effect);
+
+// ============================================================================
+// STATE POOL (control thread)
+// ============================================================================
+
+typedef struct {
+    uint8_t* blocks;            // block_count * EFFECT_STATE_BYTES, aligned
+    int block_count;
+    int* free_list;
+    int free_count;
+} EffectStatePool;
+
+bool effect_state_pool_init(EffectStatePool* pool, int block_count);
+void effect_state_pool_destroy(EffectStatePool* pool);
+
+// Zeroed state block, or NULL if the pool is exhausted
+void* effect_state_pool_alloc(EffectStatePool* pool);
+void effect_state_pool_release(EffectStatePool* pool, void* block);
+
+// ============================================================================
+// INSTANCES (control thread)
+// ============================================================================
+
+// Initialize an effect in a free slot: defaults, a fresh state block and
+// any type-specific buffers, plus the oversampler if info asks for one
+// (latent types cannot be oversampled: their delay would not be a whole
+// number of engine frames). Returns false (and leaves nothing allocated)
+// on failure.
+bool effect_instance_create(Effect* effect, EffectType type, EffectStatePool* pool, const EffectCreateInfo* info);
+
+// Release an instance's buffers and state block
+void effect_instance_destroy(Effect* effect, EffectStatePool* pool);
+
+// ============================================================================
+// EFFECT CHAIN
+// ============================================================================
+
+typedef struct {
+    // Effect slots (stable storage referenced by render graph snapshots;
+    // parameters and state are owned by the audio thread once published)
+    Effect effects[MAX_EFFECTS_PER_TRACK];
+
+    // Chain model (control thread only)
+    int order[MAX_EFFECTS_PER_TRACK];           // Chain order as effect slots
+    int count;
+    bool slot_used[MAX_EFFECTS_PER_TRACK];
+    uint64_t slot_free_after[MAX_EFFECTS_PER_TRACK]; // Last graph generation using the slot
+    uint32_t slot_serial[MAX_EFFECTS_PER_TRACK];     // Bumped each time an effect takes the slot
+
+    // Idle bypass (audio thread only): frames the chain's input and output
+    // have both been silent, and whether it has been put to sleep for that
+    uint32_t quiet_frames;
+    bool asleep;
+} EffectChain;
+
+#endif // EFFECTS_H
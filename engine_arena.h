@@ -0,0 +1,59 @@
+// engine_arena.h - Bump allocator for audio-thread scratch memory
+// Per-block scratch (bus and master planes at init, each track storage
+// chunk's planes as it is added) is carved out of aligned allocations sized
+// for the configured block length. The audio thread only ever uses memory
+// handed out here, never the heap.
+#pragma once
+#ifndef ENGINE_ARENA_H
+#define ENGINE_ARENA_H
+
+#include "dsp_kernels.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ENGINE_ARENA_ALIGNMENT 64
+
+typedef struct {
+    uint8_t* base;
+    size_t capacity;
+    size_t used;
+} EngineArena;
+
+static inline size_t engine_arena_align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Bytes to reserve for one allocation of `size` (including alignment slack)
+static inline size_t engine_arena_footprint(size_t size) {
+    return engine_arena_align_up(size, ENGINE_ARENA_ALIGNMENT);
+}
+
+static inline bool engine_arena_init(EngineArena* arena, size_t capacity) {
+    arena->capacity = engine_arena_align_up(capacity, ENGINE_ARENA_ALIGNMENT);
+    arena->used = 0;
+    arena->base = (uint8_t*)dsp_aligned_alloc(arena->capacity, ENGINE_ARENA_ALIGNMENT);
+    return arena->base != NULL;
+}
+
+static inline void engine_arena_destroy(EngineArena* arena) {
+    dsp_aligned_free(arena->base);
+    arena->base = NULL;
+    arena->capacity = 0;
+    arena->used = 0;
+}
+
+// Zeroed, ENGINE_ARENA_ALIGNMENT-aligned block, or NULL if the arena is full
+static inline void* engine_arena_alloc(EngineArena* arena, size_t size) {
+    size_t footprint = engine_arena_footprint(size);
+    if (!arena->base || arena->used + footprint > arena->capacity) {
+        return NULL;
+    }
+    void* ptr = arena->base + arena->used;
+    arena->used += footprint;
+    memset(ptr, 0, footprint);
+    return ptr;
+}
+
+#endif // ENGINE_ARENA_H
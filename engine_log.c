@@ -0,0 +1,224 @@
+#include "engine_log.h"
+#include "engine_thread.h"
+#include "spsc_ring.h"
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+// ============================================================================
+// SINK
+// ============================================================================
+
+static void stderr_sink(void* user_data, EngineLogLevel level, const char* message) {
+    (void)user_data;
+    fprintf(stderr, "%s: %s\n", engine_log_level_name(level), message);
+}
+
+static EngineLogSink log_sink = stderr_sink;
+static void* log_user_data = NULL;
+static atomic_int log_level = ENGINE_LOG_INFO;
+
+void engine_log_set_sink(EngineLogSink sink, void* user_data) {
+    log_sink = sink ? sink : stderr_sink;
+    log_user_data = sink ? user_data : NULL;
+}
+
+void engine_log_set_level(EngineLogLevel level) {
+    atomic_store_explicit(&log_level, (int)level, memory_order_relaxed);
+}
+
+// ============================================================================
+// RECORD RING
+// ============================================================================
+
+// Bounded multi-producer queue with a sequence number per slot: a producer
+// claims a slot by advancing enqueue_pos, formats into it in place and
+// publishes it by bumping the slot's sequence. A producer never waits: if
+// the slot it would claim has not been drained yet, the ring is full and
+// the record is dropped.
+
+#define LOG_RING_MASK (ENGINE_LOG_RING_CAPACITY - 1)
+
+_Static_assert((ENGINE_LOG_RING_CAPACITY & LOG_RING_MASK) == 0, "log ring capacity must be a power of two");
+
+typedef struct {
+    atomic_size_t sequence;     // == position: free, == position + 1: ready
+    EngineLogLevel level;
+    char message[ENGINE_LOG_MESSAGE_SIZE];
+} LogRecord;
+
+static struct {
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t enqueue_pos;    // Producers
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t dequeue_pos;    // Drain thread writes, flush reads
+    _Alignas(SPSC_CACHE_LINE) LogRecord records[ENGINE_LOG_RING_CAPACITY];
+    atomic_uint_fast64_t dropped;
+    uint64_t dropped_reported;      // Drain thread only
+
+    atomic_bool async;              // Producers push instead of calling the sink
+    atomic_bool running;            // Drain thread loop condition
+    bool ready;                     // Slot sequences initialised (control thread)
+    int users;                      // Nested starts (control thread)
+    EngineThread thread;
+} log_ring;
+
+static bool ring_push(EngineLogLevel level, const char* format, va_list args) {
+    size_t pos = atomic_load_explicit(&log_ring.enqueue_pos, memory_order_relaxed);
+    LogRecord* record;
+    for (;;) {
+        record = &log_ring.records[pos & LOG_RING_MASK];
+        size_t sequence = atomic_load_explicit(&record->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&log_ring.enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&log_ring.dropped, 1, memory_order_relaxed);
+            return false;
+        } else {
+            pos = atomic_load_explicit(&log_ring.enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    record->level = level;
+    vsnprintf(record->message, sizeof(record->message), format, args);
+    atomic_store_explicit(&record->sequence, pos + 1, memory_order_release);
+    return true;
+}
+
+// Hand every ready record to the sink (drain thread, or control thread
+// once the drain thread has been joined)
+static void ring_drain(void) {
+    size_t pos = atomic_load_explicit(&log_ring.dequeue_pos, memory_order_relaxed);
+    for (;;) {
+        LogRecord* record = &log_ring.records[pos & LOG_RING_MASK];
+        if (atomic_load_explicit(&record->sequence, memory_order_acquire) != pos + 1) {
+            break;
+        }
+        log_sink(log_user_data, record->level, record->message);
+        atomic_store_explicit(&record->sequence, pos + ENGINE_LOG_RING_CAPACITY, memory_order_release);
+        pos++;
+        atomic_store_explicit(&log_ring.dequeue_pos, pos, memory_order_release);
+    }
+
+    uint64_t dropped = atomic_load_explicit(&log_ring.dropped, memory_order_relaxed);
+    if (dropped != log_ring.dropped_reported) {
+        char message[64];
+        snprintf(message, sizeof(message), "[log] %llu messages dropped",
+                 (unsigned long long)(dropped - log_ring.dropped_reported));
+        log_sink(log_user_data, ENGINE_LOG_WARNING, message);
+        log_ring.dropped_reported = dropped;
+    }
+}
+
+static void drain_thread(void* user_data) {
+    (void)user_data;
+    while (atomic_load_explicit(&log_ring.running, memory_order_acquire)) {
+        ring_drain();
+        engine_thread_sleep_ms(ENGINE_LOG_DRAIN_INTERVAL_MS);
+    }
+}
+
+// ============================================================================
+// LOGGING
+// ============================================================================
+
+void engine_log(EngineLogLevel level, const char* format, ...) {
+    if ((int)level < atomic_load_explicit(&log_level, memory_order_relaxed)) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    if (atomic_load_explicit(&log_ring.async, memory_order_acquire)) {
+        ring_push(level, format, args);
+    } else {
+        char message[ENGINE_LOG_MESSAGE_SIZE];
+        vsnprintf(message, sizeof(message), format, args);
+        log_sink(log_user_data, level, message);
+    }
+    va_end(args);
+}
+
+void engine_log_rt(EngineLogLevel level, const char* format, ...) {
+    if ((int)level < atomic_load_explicit(&log_level, memory_order_relaxed)) {
+        return;
+    }
+    if (!atomic_load_explicit(&log_ring.async, memory_order_acquire)) {
+        atomic_fetch_add_explicit(&log_ring.dropped, 1, memory_order_relaxed);
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    ring_push(level, format, args);
+    va_end(args);
+}
+
+// ============================================================================
+// ASYNCHRONOUS LOGGING
+// ============================================================================
+
+bool engine_log_start_async(void) {
+    if (log_ring.users > 0) {
+        log_ring.users++;
+        return true;
+    }
+    if (!log_ring.ready) {
+        for (size_t i = 0; i < ENGINE_LOG_RING_CAPACITY; i++) {
+            atomic_store_explicit(&log_ring.records[i].sequence, i, memory_order_relaxed);
+        }
+        atomic_store_explicit(&log_ring.enqueue_pos, 0, memory_order_relaxed);
+        atomic_store_explicit(&log_ring.dequeue_pos, 0, memory_order_relaxed);
+        log_ring.ready = true;
+    }
+
+    atomic_store_explicit(&log_ring.running, true, memory_order_release);
+    if (!engine_thread_start(&log_ring.thread, drain_thread, NULL, ENGINE_THREAD_PRIORITY_LOW, -1)) {
+        atomic_store_explicit(&log_ring.running, false, memory_order_relaxed);
+        return false;
+    }
+    log_ring.users = 1;
+    atomic_store_explicit(&log_ring.async, true, memory_order_release);
+    return true;
+}
+
+void engine_log_stop_async(void) {
+    if (log_ring.users == 0) {
+        return;
+    }
+    if (--log_ring.users > 0) {
+        return;
+    }
+
+    // A producer that saw async just before this store may still push; its
+    // record stays queued and is drained by the next start
+    atomic_store_explicit(&log_ring.async, false, memory_order_release);
+    atomic_store_explicit(&log_ring.running, false, memory_order_release);
+    engine_thread_join(&log_ring.thread);
+    ring_drain();
+}
+
+void engine_log_flush(void) {
+    if (!atomic_load_explicit(&log_ring.async, memory_order_acquire)) {
+        return;
+    }
+    size_t target = atomic_load_explicit(&log_ring.enqueue_pos, memory_order_acquire);
+    while (atomic_load_explicit(&log_ring.dequeue_pos, memory_order_acquire) < target &&
+           atomic_load_explicit(&log_ring.running, memory_order_acquire)) {
+        engine_thread_sleep_ms(1);
+    }
+}
+
+uint64_t engine_log_dropped_count(void) {
+    return atomic_load_explicit(&log_ring.dropped, memory_order_relaxed);
+}
+
+const char* engine_log_level_name(EngineLogLevel level) {
+    switch (level) {
+        case ENGINE_LOG_DEBUG: return "DEBUG";
+        case ENGINE_LOG_INFO: return "INFO";
+        case ENGINE_LOG_WARNING: return "WARNING";
+        case ENGINE_LOG_ERROR: return "ERROR";
+        default: return "UNKNOWN";
+    }
+}
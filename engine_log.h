@@ -0,0 +1,73 @@
+// engine_log.h - Pluggable logging for the engine
+// The engine reports through engine_log() instead of a GUI toolkit, so it
+// links without raylib or GL. Hosts install a sink to route messages
+// (the raylib front end forwards them to TraceLog); without one, messages
+// go to stderr.
+//
+// While asynchronous logging is running, engine_log() never touches the
+// sink: it formats straight into a slot of a lock-free multi-producer ring
+// and a low-priority thread hands records to the sink. Any thread, the
+// audio callback included, can then log without ever blocking on stdio.
+#pragma once
+#ifndef ENGINE_LOG_H
+#define ENGINE_LOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ENGINE_LOG_MESSAGE_SIZE 512     // Longer messages are truncated
+#define ENGINE_LOG_RING_CAPACITY 256    // Records in flight, power of two
+#define ENGINE_LOG_DRAIN_INTERVAL_MS 10
+
+typedef enum {
+    ENGINE_LOG_DEBUG = 0,
+    ENGINE_LOG_INFO,
+    ENGINE_LOG_WARNING,
+    ENGINE_LOG_ERROR
+} EngineLogLevel;
+
+typedef void (*EngineLogSink)(void* user_data, EngineLogLevel level, const char* message);
+
+// Route messages to sink (NULL restores the stderr sink). Set it before
+// starting an engine; the sink may be called from any engine thread, or
+// only from the drain thread while asynchronous logging runs.
+void engine_log_set_sink(EngineLogSink sink, void* user_data);
+
+// Drop messages below level (default ENGINE_LOG_INFO)
+void engine_log_set_level(EngineLogLevel level);
+
+void engine_log(EngineLogLevel level, const char* format, ...)
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+// Real-time variant: pushes into the ring and never falls back to calling
+// the sink, so the message is dropped (and counted) when asynchronous
+// logging is not running or the ring is full. For the audio thread.
+void engine_log_rt(EngineLogLevel level, const char* format, ...)
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+// ============================================================================
+// ASYNCHRONOUS LOGGING (control thread)
+// ============================================================================
+
+// Start the drain thread. Calls nest: every successful start needs a
+// matching stop, and the thread runs until the last one.
+bool engine_log_start_async(void);
+
+// Drain what is queued and, on the last stop, join the drain thread
+void engine_log_stop_async(void);
+
+// Block until every record pushed before the call reached the sink
+void engine_log_flush(void);
+
+// Records lost to a full ring (or to engine_log_rt without a drain thread)
+uint64_t engine_log_dropped_count(void);
+
+const char* engine_log_level_name(EngineLogLevel level);
+
+#endif // ENGINE_LOG_H
@@ -0,0 +1,183 @@
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     // pthread_setaffinity_np, CPU_SET
+#endif
+
+#include "engine_thread.h"
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// ============================================================================
+// WIN32
+// ============================================================================
+
+#ifdef _WIN32
+
+static DWORD WINAPI thread_entry(LPVOID param) {
+    EngineThread* thread = (EngineThread*)param;
+    thread->fn(thread->user_data);
+    return 0;
+}
+
+bool engine_thread_start(EngineThread* thread, EngineThreadFn fn, void* user_data,
+                         EngineThreadPriority priority, int cpu_index) {
+    thread->fn = fn;
+    thread->user_data = user_data;
+
+    HANDLE handle = CreateThread(NULL, 0, thread_entry, thread, 0, NULL);
+    if (!handle) {
+        return false;
+    }
+
+    switch (priority) {
+        case ENGINE_THREAD_PRIORITY_REALTIME:
+            SetThreadPriority(handle, THREAD_PRIORITY_TIME_CRITICAL);
+            break;
+        case ENGINE_THREAD_PRIORITY_LOW:
+            SetThreadPriority(handle, THREAD_PRIORITY_BELOW_NORMAL);
+            break;
+        default:
+            break;
+    }
+    if (cpu_index >= 0 && cpu_index < (int)(sizeof(DWORD_PTR) * 8)) {
+        SetThreadAffinityMask(handle, (DWORD_PTR)1 << cpu_index);
+    }
+
+    thread->handle = handle;
+    return true;
+}
+
+void engine_thread_join(EngineThread* thread) {
+    if (thread->handle) {
+        WaitForSingleObject((HANDLE)thread->handle, INFINITE);
+        CloseHandle((HANDLE)thread->handle);
+        thread->handle = NULL;
+    }
+}
+
+void engine_thread_yield(void) {
+    SwitchToThread();
+}
+
+void engine_thread_sleep_ms(uint32_t milliseconds) {
+    Sleep(milliseconds);
+}
+
+uint64_t engine_thread_time_ns(void) {
+    static LARGE_INTEGER frequency;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    uint64_t seconds = (uint64_t)counter.QuadPart / (uint64_t)frequency.QuadPart;
+    uint64_t remainder = (uint64_t)counter.QuadPart % (uint64_t)frequency.QuadPart;
+    return seconds * 1000000000ULL + remainder * 1000000000ULL / (uint64_t)frequency.QuadPart;
+}
+
+int engine_thread_cpu_count(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
+// ============================================================================
+// PTHREADS
+// ============================================================================
+
+#else
+
+static void* thread_entry(void* param) {
+    EngineThread* thread = (EngineThread*)param;
+    thread->fn(thread->user_data);
+    return NULL;
+}
+
+bool engine_thread_start(EngineThread* thread, EngineThreadFn fn, void* user_data,
+                         EngineThreadPriority priority, int cpu_index) {
+    thread->fn = fn;
+    thread->user_data = user_data;
+
+    pthread_t* handle = (pthread_t*)malloc(sizeof(pthread_t));
+    if (!handle) {
+        return false;
+    }
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    bool realtime = false;
+    if (priority == ENGINE_THREAD_PRIORITY_REALTIME) {
+        struct sched_param param = {.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1};
+        realtime = pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED) == 0 &&
+                   pthread_attr_setschedpolicy(&attr, SCHED_FIFO) == 0 &&
+                   pthread_attr_setschedparam(&attr, &param) == 0;
+    }
+
+    int result = pthread_create(handle, &attr, thread_entry, thread);
+    if (result != 0 && realtime) {
+        // Not allowed to use SCHED_FIFO (no rtprio); fall back to a normal thread
+        pthread_attr_destroy(&attr);
+        pthread_attr_init(&attr);
+        result = pthread_create(handle, &attr, thread_entry, thread);
+    }
+    pthread_attr_destroy(&attr);
+
+    if (result != 0) {
+        free(handle);
+        return false;
+    }
+
+#if defined(__linux__)
+    if (cpu_index >= 0 && cpu_index < CPU_SETSIZE) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu_index, &set);
+        pthread_setaffinity_np(*handle, sizeof(set), &set);
+    }
+#else
+    (void)cpu_index;    // No portable affinity API on macOS
+#endif
+
+    thread->handle = handle;
+    return true;
+}
+
+void engine_thread_join(EngineThread* thread) {
+    if (thread->handle) {
+        pthread_join(*(pthread_t*)thread->handle, NULL);
+        free(thread->handle);
+        thread->handle = NULL;
+    }
+}
+
+void engine_thread_yield(void) {
+    sched_yield();
+}
+
+void engine_thread_sleep_ms(uint32_t milliseconds) {
+    struct timespec ts = {
+        .tv_sec = milliseconds / 1000,
+        .tv_nsec = (long)(milliseconds % 1000) * 1000000L,
+    };
+    nanosleep(&ts, NULL);
+}
+
+uint64_t engine_thread_time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int engine_thread_cpu_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+#endif
@@ -0,0 +1,53 @@
+// engine_thread.h - Minimal portable threads for engine background work
+// Win32 and pthreads behind one small API (miniaudio keeps its own thread
+// helpers private). Used by the worker pool and other engine threads.
+#pragma once
+#ifndef ENGINE_THREAD_H
+#define ENGINE_THREAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    ENGINE_THREAD_PRIORITY_NORMAL = 0,
+    ENGINE_THREAD_PRIORITY_LOW,         // Background I/O, logging
+    ENGINE_THREAD_PRIORITY_REALTIME     // Audio workers (best effort, may need privileges)
+} EngineThreadPriority;
+
+typedef void (*EngineThreadFn)(void* user_data);
+
+typedef struct {
+    void* handle;           // HANDLE or heap-allocated pthread_t
+    EngineThreadFn fn;
+    void* user_data;
+} EngineThread;
+
+// Start a thread. cpu_index >= 0 pins it to that core where supported.
+bool engine_thread_start(EngineThread* thread, EngineThreadFn fn, void* user_data,
+                         EngineThreadPriority priority, int cpu_index);
+
+// Wait for the thread to exit and release its handle
+void engine_thread_join(EngineThread* thread);
+
+// Give up the rest of the time slice
+void engine_thread_yield(void);
+
+// Sleep the calling thread
+void engine_thread_sleep_ms(uint32_t milliseconds);
+
+// Monotonic clock in nanoseconds (for timing blocks, not wall time)
+uint64_t engine_thread_time_ns(void);
+
+// Number of online logical CPUs (at least 1)
+int engine_thread_cpu_count(void);
+
+// Hint to the CPU that we're in a spin-wait loop
+static inline void engine_thread_pause(void) {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+#endif // ENGINE_THREAD_H
@@ -0,0 +1,182 @@
+#include "engine_trace.h"
+#include "engine_log.h"
+
+#ifdef AIRDAW_TRACE
+
+#include "engine_thread.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// ============================================================================
+// RINGS
+// ============================================================================
+
+typedef struct {
+    const char* name;
+    uint64_t time_ns;
+    char phase;             // 'B' or 'E'
+} TraceEvent;
+
+typedef struct {
+    TraceEvent* events;                 // ENGINE_TRACE_THREAD_EVENTS
+    atomic_uint_fast64_t written;       // Events ever written (owner thread)
+    _Atomic(const char*) thread_name;
+} TraceRing;
+
+static TraceRing trace_rings[ENGINE_TRACE_MAX_THREADS];
+static TraceEvent* trace_storage;
+static atomic_int trace_claimed;
+static atomic_bool trace_ready;
+static uint64_t trace_start_ns;
+
+// Ring of the calling thread: NULL until claimed, trace_rings_full when
+// the thread came too late to get one
+static _Thread_local TraceRing* thread_ring;
+static TraceRing trace_rings_full;
+
+static TraceRing* claim_ring(void) {
+    if (thread_ring) {
+        return thread_ring == &trace_rings_full ? NULL : thread_ring;
+    }
+    if (!atomic_load_explicit(&trace_ready, memory_order_acquire)) {
+        return NULL;
+    }
+    int index = atomic_fetch_add_explicit(&trace_claimed, 1, memory_order_relaxed);
+    thread_ring = index < ENGINE_TRACE_MAX_THREADS ? &trace_rings[index] : &trace_rings_full;
+    return claim_ring();
+}
+
+bool engine_trace_init(void) {
+    trace_storage = (TraceEvent*)calloc((size_t)ENGINE_TRACE_MAX_THREADS * ENGINE_TRACE_THREAD_EVENTS,
+                                        sizeof(TraceEvent));
+    if (!trace_storage) {
+        engine_log(ENGINE_LOG_WARNING, "[trace] Failed to allocate trace rings");
+        return false;
+    }
+    // Threads keep the ring (and name) they claimed for the life of the
+    // process; a new init only empties them
+    for (int i = 0; i < ENGINE_TRACE_MAX_THREADS; i++) {
+        trace_rings[i].events = trace_storage + (size_t)i * ENGINE_TRACE_THREAD_EVENTS;
+        atomic_store(&trace_rings[i].written, 0);
+    }
+    trace_start_ns = engine_thread_time_ns();
+    atomic_store_explicit(&trace_ready, true, memory_order_release);
+    engine_log(ENGINE_LOG_INFO, "[trace] Recording up to %d events per thread", ENGINE_TRACE_THREAD_EVENTS);
+    return true;
+}
+
+void engine_trace_shutdown(void) {
+    atomic_store(&trace_ready, false);
+    free(trace_storage);
+    trace_storage = NULL;
+}
+
+void engine_trace_event(const char* name, char phase) {
+    TraceRing* ring = claim_ring();
+    if (!ring) {
+        return;
+    }
+    uint64_t index = atomic_load_explicit(&ring->written, memory_order_relaxed);
+    TraceEvent* event = &ring->events[index & (ENGINE_TRACE_THREAD_EVENTS - 1)];
+    event->name = name;
+    event->time_ns = engine_thread_time_ns();
+    event->phase = phase;
+    atomic_store_explicit(&ring->written, index + 1, memory_order_release);
+}
+
+void engine_trace_name_thread(const char* name) {
+    TraceRing* ring = claim_ring();
+    if (ring && atomic_load_explicit(&ring->thread_name, memory_order_relaxed) != name) {
+        atomic_store_explicit(&ring->thread_name, name, memory_order_release);
+    }
+}
+
+// ============================================================================
+// CHROME TRACE EXPORT
+// ============================================================================
+
+static void write_json_string(FILE* file, const char* text) {
+    fputc('"', file);
+    for (const char* c = text ? text : "?"; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+            fputc(*c, file);
+        } else if ((unsigned char)*c >= 0x20) {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+bool engine_trace_write_json(const char* path) {
+    if (!atomic_load_explicit(&trace_ready, memory_order_acquire)) {
+        engine_log(ENGINE_LOG_WARNING, "[trace] Tracing is not initialized");
+        return false;
+    }
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        engine_log(ENGINE_LOG_WARNING, "[trace] Cannot write %s", path);
+        return false;
+    }
+
+    int threads = atomic_load(&trace_claimed);
+    threads = threads < ENGINE_TRACE_MAX_THREADS ? threads : ENGINE_TRACE_MAX_THREADS;
+    uint64_t total = 0;
+    bool first = true;
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    for (int t = 0; t < threads; t++) {
+        const TraceRing* ring = &trace_rings[t];
+        const char* thread_name = atomic_load_explicit(&ring->thread_name, memory_order_acquire);
+        if (thread_name) {
+            fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": ",
+                    first ? "" : ",\n", t);
+            write_json_string(file, thread_name);
+            fprintf(file, "}}");
+            first = false;
+        }
+
+        uint64_t written = atomic_load_explicit(&ring->written, memory_order_acquire);
+        uint64_t begin = written > ENGINE_TRACE_THREAD_EVENTS ? written - ENGINE_TRACE_THREAD_EVENTS : 0;
+        for (uint64_t i = begin; i < written; i++) {
+            const TraceEvent* event = &ring->events[i & (ENGINE_TRACE_THREAD_EVENTS - 1)];
+            uint64_t time_ns = event->time_ns > trace_start_ns ? event->time_ns - trace_start_ns : 0;
+            fprintf(file, "%s{\"name\": ", first ? "" : ",\n");
+            write_json_string(file, event->name);
+            fprintf(file, ", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": 1, \"tid\": %d}", event->phase,
+                    (double)time_ns / 1000.0, t);
+            first = false;
+        }
+        total += written - begin;
+    }
+    fprintf(file, "\n]}\n");
+    bool ok = fclose(file) == 0;
+    engine_log(ok ? ENGINE_LOG_INFO : ENGINE_LOG_WARNING, "[trace] %s %llu events from %d threads to %s",
+               ok ? "Wrote" : "Failed writing", (unsigned long long)total, threads, path);
+    return ok;
+}
+
+#else // !AIRDAW_TRACE
+
+bool engine_trace_init(void) {
+    return false;
+}
+
+void engine_trace_shutdown(void) {}
+
+void engine_trace_event(const char* name, char phase) {
+    (void)name;
+    (void)phase;
+}
+
+void engine_trace_name_thread(const char* name) {
+    (void)name;
+}
+
+bool engine_trace_write_json(const char* path) {
+    (void)path;
+    engine_log(ENGINE_LOG_WARNING, "[trace] Built without AIRDAW_TRACE; nothing to write");
+    return false;
+}
+
+#endif // AIRDAW_TRACE
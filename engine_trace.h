@@ -0,0 +1,53 @@
+// engine_trace.h - Optional Chrome trace (Perfetto) event recording
+// Built with -DAIRDAW_TRACE, ENGINE_TRACE_BEGIN/END record timestamped
+// begin/end markers into a per-thread ring: a single writer per ring, no
+// locks, no allocation after engine_trace_init, so the audio thread and the
+// render workers can trace every block. engine_trace_write_json dumps the
+// newest events of every thread as Chrome trace JSON (load it in
+// ui.perfetto.dev or chrome://tracing).
+//
+// Without AIRDAW_TRACE the macros compile to nothing and the functions are
+// stubs, so release builds pay nothing.
+#pragma once
+#ifndef ENGINE_TRACE_H
+#define ENGINE_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ENGINE_TRACE_MAX_THREADS 32
+#define ENGINE_TRACE_THREAD_EVENTS 16384    // Per thread, power of two; oldest are overwritten
+#define ENGINE_TRACE_DEFAULT_PATH "airdaw_trace.json"
+
+#ifdef AIRDAW_TRACE
+// Names must outlive the trace (string literals or stable storage)
+#define ENGINE_TRACE_BEGIN(name) engine_trace_event((name), 'B')
+#define ENGINE_TRACE_END(name) engine_trace_event((name), 'E')
+#define ENGINE_TRACE_THREAD_NAME(name) engine_trace_name_thread(name)
+#else
+#define ENGINE_TRACE_BEGIN(name) ((void)0)
+#define ENGINE_TRACE_END(name) ((void)0)
+#define ENGINE_TRACE_THREAD_NAME(name) ((void)0)
+#endif
+
+// Allocate every thread's ring up front (before the engine starts).
+// Returns false when tracing is compiled out or allocation fails; events
+// are then dropped.
+bool engine_trace_init(void);
+
+// Free the rings. No thread may still be tracing.
+void engine_trace_shutdown(void);
+
+// Record one marker on the calling thread's ring (claimed on first use;
+// threads past ENGINE_TRACE_MAX_THREADS are not traced). Use the macros.
+void engine_trace_event(const char* name, char phase);
+
+// Label the calling thread in the trace
+void engine_trace_name_thread(const char* name);
+
+// Write the events recorded so far. Rings are read while their threads
+// keep writing, so the oldest few events of a busy thread may be torn by
+// the wrap; everything newer is exact.
+bool engine_trace_write_json(const char* path);
+
+#endif // ENGINE_TRACE_H
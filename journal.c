@@ -0,0 +1,340 @@
+#include "journal.h"
+#include "engine_log.h"
+#include "engine_thread.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define JOURNAL_MERGE_NS ((uint64_t)ENGINE_JOURNAL_MERGE_MS * 1000000u)
+
+// ============================================================================
+// TARGETS
+// ============================================================================
+
+static bool is_journaled(EngineCommandType type) {
+    switch (type) {
+    case CMD_SET_MASTER_VOLUME:
+    case CMD_SET_TRACK_VOLUME:
+    case CMD_SET_TRACK_PAN:
+    case CMD_SET_TRACK_MUTE:
+    case CMD_SET_TRACK_SOLO:
+    case CMD_SET_TRACK_PLAYING:
+    case CMD_SET_TRACK_SEND:
+    case CMD_TOGGLE_EFFECT:
+    case CMD_SET_EFFECT_PARAM:
+    case CMD_SET_BUS_VOLUME:
+    case CMD_SET_BUS_MUTE:
+    case CMD_TOGGLE_BUS_EFFECT:
+    case CMD_SET_BUS_EFFECT_PARAM:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Continuous values, merged while they are being dragged
+static bool is_mergeable(EngineCommandType type) {
+    return type == CMD_SET_MASTER_VOLUME || type == CMD_SET_TRACK_VOLUME || type == CMD_SET_TRACK_PAN ||
+           type == CMD_SET_TRACK_SEND || type == CMD_SET_EFFECT_PARAM || type == CMD_SET_BUS_VOLUME ||
+           type == CMD_SET_BUS_EFFECT_PARAM;
+}
+
+// Same value of the same track, bus or effect (the value itself aside)
+static bool same_target(const EngineCommand* a, const EngineCommand* b) {
+    return a->type == b->type && a->track_index == b->track_index && a->bus_index == b->bus_index &&
+           a->effect_slot == b->effect_slot && a->param_index == b->param_index;
+}
+
+static bool track_valid(const AudioEngine* engine, int track_index) {
+    return track_index >= 0 && track_index < engine->track_count;
+}
+
+static bool bus_valid(const AudioEngine* engine, int bus_index) {
+    return bus_index >= 0 && bus_index < engine->bus_count;
+}
+
+// The chain a command's track or bus holds, or NULL
+static const EffectChain* command_chain(const AudioEngine* engine, const EngineCommand* command) {
+    switch (command->type) {
+    case CMD_TOGGLE_EFFECT:
+    case CMD_SET_EFFECT_PARAM:
+        return track_valid(engine, command->track_index)
+                   ? &track_store_track(&engine->tracks, command->track_index)->chain
+                   : NULL;
+    case CMD_TOGGLE_BUS_EFFECT:
+    case CMD_SET_BUS_EFFECT_PARAM:
+        return bus_valid(engine, command->bus_index) ? &engine->buses[command->bus_index].chain : NULL;
+    default:
+        return NULL;
+    }
+}
+
+// Chain position of a command's effect slot, or -1 if it has been removed
+static int effect_position(const AudioEngine* engine, const EngineCommand* command) {
+    const EffectChain* chain = command_chain(engine, command);
+    for (int i = 0; chain && i < chain->count; i++) {
+        if (chain->order[i] == command->effect_slot) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Slot serial and type of a command's effect, for telling the instance it
+// was recorded against from a later one in the same slot. Zero for
+// commands that target no effect; the target must be valid.
+static uint32_t effect_serial(const AudioEngine* engine, const EngineCommand* command) {
+    const EffectChain* chain = command_chain(engine, command);
+    return chain ? chain->slot_serial[command->effect_slot] : 0;
+}
+
+static EffectType effect_type(const AudioEngine* engine, const EngineCommand* command) {
+    const EffectChain* chain = command_chain(engine, command);
+    return chain ? chain->effects[command->effect_slot].type : (EffectType)0;
+}
+
+// Whether the command's target exists right now
+static bool target_valid(const AudioEngine* engine, const EngineCommand* command) {
+    switch (command->type) {
+    case CMD_SET_MASTER_VOLUME:
+        return true;
+    case CMD_SET_TRACK_VOLUME:
+    case CMD_SET_TRACK_PAN:
+    case CMD_SET_TRACK_MUTE:
+    case CMD_SET_TRACK_SOLO:
+    case CMD_SET_TRACK_PLAYING:
+        return track_valid(engine, command->track_index);
+    case CMD_SET_TRACK_SEND:
+        return track_valid(engine, command->track_index) && bus_valid(engine, command->bus_index);
+    case CMD_SET_BUS_VOLUME:
+    case CMD_SET_BUS_MUTE:
+        return bus_valid(engine, command->bus_index);
+    case CMD_TOGGLE_EFFECT:
+    case CMD_TOGGLE_BUS_EFFECT:
+        return effect_position(engine, command) >= 0;
+    case CMD_SET_EFFECT_PARAM:
+    case CMD_SET_BUS_EFFECT_PARAM:
+        return effect_position(engine, command) >= 0 && command->param_index >= 0 &&
+               command->param_index < EFFECT_MAX_PARAMS;
+    default:
+        return false;
+    }
+}
+
+// The command that would put a valid target back where the audio thread
+// last left it (read like audio_engine_snapshot does)
+static EngineCommand applied_state(const AudioEngine* engine, const EngineCommand* command) {
+    EngineCommand state = *command;
+    int track_index = command->track_index;
+    switch (command->type) {
+    case CMD_SET_MASTER_VOLUME:
+        state.value = engine->master_volume;
+        break;
+    case CMD_SET_TRACK_VOLUME:
+        state.value = track_store_mix(&engine->tracks, track_index)->volume[track_lane(track_index)];
+        break;
+    case CMD_SET_TRACK_PAN:
+        state.value = track_store_mix(&engine->tracks, track_index)->pan[track_lane(track_index)];
+        break;
+    case CMD_SET_TRACK_MUTE:
+        state.flag = atomic_load(&track_store_mix(&engine->tracks, track_index)->mute[track_lane(track_index)]);
+        break;
+    case CMD_SET_TRACK_SOLO:
+        state.flag = atomic_load(&track_store_mix(&engine->tracks, track_index)->solo[track_lane(track_index)]);
+        break;
+    case CMD_SET_TRACK_PLAYING:
+        state.flag = atomic_load(&track_store_mix(&engine->tracks, track_index)->playing[track_lane(track_index)]);
+        break;
+    case CMD_SET_TRACK_SEND:
+        state.value = track_store_info(&engine->tracks, track_index)->send_enabled[command->bus_index]
+                          ? track_store_track(&engine->tracks, track_index)->send_level[command->bus_index]
+                          : 0.0F;
+        break;
+    case CMD_SET_EFFECT_PARAM:
+    case CMD_SET_BUS_EFFECT_PARAM:
+        state.value = effect_get_param(&command_chain(engine, command)->effects[command->effect_slot],
+                                       command->param_index);
+        break;
+    case CMD_SET_BUS_VOLUME:
+        state.value = engine->buses[command->bus_index].volume;
+        break;
+    case CMD_SET_BUS_MUTE:
+        state.flag = atomic_load(&engine->buses[command->bus_index].mute);
+        break;
+    default:
+        // Toggles are their own inverse
+        break;
+    }
+    return state;
+}
+
+// ============================================================================
+// SENDING
+// ============================================================================
+
+// Through the public setters, so edits replayed from the journal thaw and
+// validate exactly like the original ones
+static bool send(AudioEngine* engine, const EngineCommand* command) {
+    switch (command->type) {
+    case CMD_SET_MASTER_VOLUME:
+        return audio_engine_set_master_volume(engine, command->value);
+    case CMD_SET_TRACK_VOLUME:
+        return audio_engine_set_track_volume(engine, command->track_index, command->value);
+    case CMD_SET_TRACK_PAN:
+        return audio_engine_set_track_pan(engine, command->track_index, command->value);
+    case CMD_SET_TRACK_MUTE:
+        return audio_engine_set_track_mute(engine, command->track_index, command->flag);
+    case CMD_SET_TRACK_SOLO:
+        return audio_engine_set_track_solo(engine, command->track_index, command->flag);
+    case CMD_SET_TRACK_PLAYING:
+        return audio_engine_set_track_playing(engine, command->track_index, command->flag);
+    case CMD_SET_TRACK_SEND:
+        return audio_engine_set_track_send(engine, command->track_index, command->bus_index, command->value);
+    case CMD_TOGGLE_EFFECT:
+        return audio_engine_toggle_effect(engine, command->track_index, effect_position(engine, command));
+    case CMD_SET_EFFECT_PARAM:
+        return audio_engine_set_effect_param(engine, command->track_index, effect_position(engine, command),
+                                             command->param_index, command->value);
+    case CMD_SET_BUS_VOLUME:
+        return audio_engine_set_bus_volume(engine, command->bus_index, command->value);
+    case CMD_SET_BUS_MUTE:
+        return audio_engine_set_bus_mute(engine, command->bus_index, command->flag);
+    case CMD_TOGGLE_BUS_EFFECT:
+        return audio_engine_toggle_bus_effect(engine, command->bus_index, effect_position(engine, command));
+    case CMD_SET_BUS_EFFECT_PARAM:
+        return audio_engine_set_bus_effect_param(engine, command->bus_index, effect_position(engine, command),
+                                                 command->param_index, command->value);
+    default:
+        return audio_engine_send_command(engine, command);
+    }
+}
+
+// ============================================================================
+// JOURNAL
+// ============================================================================
+
+bool engine_journal_init(EngineJournal* journal) {
+    memset(journal, 0, sizeof(EngineJournal));
+    journal->entries = (JournalEntry*)calloc(ENGINE_JOURNAL_CAPACITY, sizeof(JournalEntry));
+    return journal->entries != NULL;
+}
+
+void engine_journal_destroy(EngineJournal* journal) {
+    free(journal->entries);
+    memset(journal, 0, sizeof(EngineJournal));
+}
+
+void engine_journal_clear(EngineJournal* journal) {
+    journal->first = 0;
+    journal->count = 0;
+    journal->done = 0;
+    journal->version++;
+}
+
+void engine_journal_seal(EngineJournal* journal) {
+    journal->sealed = true;
+}
+
+static JournalEntry* entry_at(EngineJournal* journal, int index) {
+    return &journal->entries[(journal->first + index) % ENGINE_JOURNAL_CAPACITY];
+}
+
+// Whether an entry's command still reaches what it was recorded against
+static bool entry_valid(const AudioEngine* engine, const JournalEntry* entry, const EngineCommand* command) {
+    return target_valid(engine, command) && entry->effect_serial == effect_serial(engine, command) &&
+           entry->effect_type == effect_type(engine, command);
+}
+
+// A target's value as the journal left it, which may still be queued: the
+// newest applied step's edit, else what the oldest undone step restored.
+// NULL if the journal never touched it.
+static const EngineCommand* journaled_state(EngineJournal* journal, const AudioEngine* engine,
+                                            const EngineCommand* command) {
+    for (int i = journal->done - 1; i >= 0; i--) {
+        const JournalEntry* entry = entry_at(journal, i);
+        if (same_target(&entry->redo, command) && entry_valid(engine, entry, command)) {
+            return &entry->redo;
+        }
+    }
+    for (int i = journal->done; i < journal->count; i++) {
+        const JournalEntry* entry = entry_at(journal, i);
+        if (same_target(&entry->undo, command) && entry_valid(engine, entry, command)) {
+            return &entry->undo;
+        }
+    }
+    return NULL;
+}
+
+bool engine_journal_apply(EngineJournal* journal, AudioEngine* engine, const EngineCommand* command) {
+    if (!is_journaled(command->type) || !target_valid(engine, command)) {
+        return send(engine, command);
+    }
+
+    const EngineCommand* journaled = journaled_state(journal, engine, command);
+    EngineCommand before = journaled ? *journaled : applied_state(engine, command);
+    uint32_t serial = effect_serial(engine, command);
+    EffectType type = effect_type(engine, command);
+    if (!send(engine, command)) {
+        return false;
+    }
+
+    uint64_t now = engine_thread_time_ns();
+    journal->version++;
+    if (journal->done > 0 && journal->done == journal->count && !journal->sealed && is_mergeable(command->type)) {
+        JournalEntry* last = entry_at(journal, journal->done - 1);
+        if (same_target(&last->redo, command) && last->effect_serial == serial && last->effect_type == type &&
+            now - last->time_ns < JOURNAL_MERGE_NS) {
+            last->redo = *command;
+            last->time_ns = now;
+            return true;
+        }
+    }
+
+    // A new step replaces whatever could have been redone
+    journal->count = journal->done;
+    if (journal->count == ENGINE_JOURNAL_CAPACITY) {
+        journal->first = (journal->first + 1) % ENGINE_JOURNAL_CAPACITY;
+        journal->count--;
+        journal->done--;
+    }
+    JournalEntry* entry = entry_at(journal, journal->count);
+    entry->redo = *command;
+    entry->undo = before;
+    entry->time_ns = now;
+    entry->effect_serial = serial;
+    entry->effect_type = type;
+    journal->count++;
+    journal->done++;
+    journal->sealed = false;
+    return true;
+}
+
+static bool step(AudioEngine* engine, const JournalEntry* entry, const EngineCommand* command) {
+    if (!entry_valid(engine, entry, command)) {
+        engine_log(ENGINE_LOG_WARNING, "[journal] Skipping a step whose target is gone (command type %d)",
+                   (int)command->type);
+        return false;
+    }
+    return send(engine, command);
+}
+
+bool engine_journal_undo(EngineJournal* journal, AudioEngine* engine) {
+    if (!engine_journal_can_undo(journal)) {
+        return false;
+    }
+    journal->done--;
+    journal->sealed = true;
+    journal->version++;
+    const JournalEntry* entry = entry_at(journal, journal->done);
+    return step(engine, entry, &entry->undo);
+}
+
+bool engine_journal_redo(EngineJournal* journal, AudioEngine* engine) {
+    if (!engine_journal_can_redo(journal)) {
+        return false;
+    }
+    journal->done++;
+    journal->sealed = true;
+    journal->version++;
+    const JournalEntry* entry = entry_at(journal, journal->done - 1);
+    return step(engine, entry, &entry->redo);
+}
@@ -0,0 +1,76 @@
+// journal.h - Undo/redo journal of engine commands
+// Mix edits reach the audio thread as EngineCommands; the journal records
+// each one it forwards together with its inverse, a command of the same
+// type carrying the value the target had before (the last journaled value,
+// or the engine's applied state). Undo and redo send those commands
+// through the same setters and queue as the original edit, so they thaw
+// frozen tracks and validate like any other edit. Effect commands name
+// stable effect slots, so moving effects around does not change what an
+// entry refers to; the entry also keeps the slot's instance serial and
+// effect type, so an effect added later into a freed slot is not mistaken
+// for the one it replaced.
+//
+// Consecutive edits of the same value within ENGINE_JOURNAL_MERGE_MS (a
+// fader drag) merge into one step. Transport, notes, arming and input
+// monitoring are forwarded without being recorded, and structural edits
+// (tracks, buses, routing, effects added or removed) are not commands and
+// are not journaled: an entry whose track, bus or effect slot no longer
+// holds what it was recorded against is skipped when stepped over.
+//
+// Control thread only, like the setters it calls.
+#pragma once
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "audio_engine.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ENGINE_JOURNAL_CAPACITY 1024    // Steps kept; the oldest are dropped
+#define ENGINE_JOURNAL_MERGE_MS 500     // Window for merging edits of one value
+
+typedef struct {
+    EngineCommand redo;         // The edit as it was sent
+    EngineCommand undo;         // Restores the value it replaced
+    uint64_t time_ns;           // Last edit merged into this step
+    uint32_t effect_serial;     // Effect commands: the slot's instance when recorded
+    EffectType effect_type;
+} JournalEntry;
+
+typedef struct {
+    JournalEntry* entries;      // Ring of ENGINE_JOURNAL_CAPACITY
+    int first;                  // Oldest entry
+    int count;                  // Entries held
+    int done;                   // Entries applied; the rest can be redone
+    bool sealed;                // The next edit starts a new step
+    uint64_t version;           // Bumped by every recorded edit, undo and redo
+} EngineJournal;
+
+bool engine_journal_init(EngineJournal* journal);
+void engine_journal_destroy(EngineJournal* journal);
+
+// Forget every step (after loading a session, say)
+void engine_journal_clear(EngineJournal* journal);
+
+// Send `command` to the engine and record it if it is a journaled edit.
+// Returns whether it was sent; nothing is recorded if it was not.
+bool engine_journal_apply(EngineJournal* journal, AudioEngine* engine, const EngineCommand* command);
+
+// End the current step, so the next edit is not merged into it (a fader
+// released, say)
+void engine_journal_seal(EngineJournal* journal);
+
+// Step back or forward. Returns false if there is nothing to step over or
+// the step no longer applies (it is stepped over all the same).
+bool engine_journal_undo(EngineJournal* journal, AudioEngine* engine);
+bool engine_journal_redo(EngineJournal* journal, AudioEngine* engine);
+
+static inline bool engine_journal_can_undo(const EngineJournal* journal) {
+    return journal->done > 0;
+}
+
+static inline bool engine_journal_can_redo(const EngineJournal* journal) {
+    return journal->done < journal->count;
+}
+
+#endif // JOURNAL_H
@@ -0,0 +1,301 @@
+// main.c - AirDAW Main Entry Point (Sokol frontend)
+// Orchestrates sokol_app/sokol_gfx, the Miniaudio Audio Engine, and the
+// same Clay UI as main_raylib.c (ui_clay.c), drawn by renderer_sokol.c
+
+#define CLAY_IMPLEMENTATION
+#include "vendor/clay/clay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Backend comes from the build: SOKOL_D3D11, SOKOL_METAL or SOKOL_GLCORE
+#define SOKOL_IMPL
+#include "sokol_app.h"
+#include "sokol_gfx.h"
+#include "sokol_gl.h"
+#include "sokol_glue.h"
+#include "sokol_log.h"
+#define FONTSTASH_IMPLEMENTATION
+#include "fontstash.h"
+#include "sokol_fontstash.h"
+#define SOKOL_CLAY_IMPL
+#include "vendor/clay/renderers/sokol/sokol_clay.h"
+
+#include "audio_engine.h"
+#include "control_thread.h"
+#include "engine_trace.h"
+#include "engine_log.h"
+#include "midi_input.h"
+#include "renderer_sokol.h"
+#include "ui_clay.h"
+
+// ============================================================================
+// CONSTANTS
+// ============================================================================
+
+#define WINDOW_WIDTH 1400
+#define WINDOW_HEIGHT 900
+#define WINDOW_TITLE "AirDAW - Miniaudio + Sokol + Clay UI"
+
+#define UI_FPS_LOG_SECONDS 5.0
+#define UI_MAX_VERTICES (1 << 17)    // sokol_gl streaming buffer (text, meters, waveforms)
+#define UI_MAX_COMMANDS (1 << 14)
+
+static struct {
+  AudioEngine engine;
+  ControlThread control;
+  MidiInput midi;
+  UIState ui_state;
+  bool ui_ready;
+  double fps_log_elapsed;
+} app;
+
+// ============================================================================
+// LOGGING
+// ============================================================================
+
+// Engine and UI messages share one console format (the raylib frontend
+// routes them through TraceLog instead). While an engine runs this is only
+// called from the engine's log thread.
+static void engine_log_to_stdout(void *user_data, EngineLogLevel level,
+                                 const char *message) {
+  (void)user_data;
+  const char *level_str = "\x1B[94mINFO";
+  switch (level) {
+  case ENGINE_LOG_DEBUG:
+    level_str = "\x1B[36mDEBUG";
+    break;
+  case ENGINE_LOG_WARNING:
+    level_str = "\x1B[33mWARNING";
+    break;
+  case ENGINE_LOG_ERROR:
+    level_str = "\x1B[31mERROR";
+    break;
+  default:
+    break;
+  }
+  printf("%s\x1B[0m %s\n", level_str, message);
+}
+
+// ============================================================================
+// SOKOL CALLBACKS
+// ============================================================================
+
+static void init(void) {
+  sg_setup(&(sg_desc){.environment = sglue_environment(),
+                      .logger.func = slog_func});
+  sgl_setup(&(sgl_desc_t){.max_vertices = UI_MAX_VERTICES,
+                          .max_commands = UI_MAX_COMMANDS,
+                          .logger.func = slog_func});
+  engine_log(ENGINE_LOG_INFO, "[sokol] Window initialized: %dx%d (%s)",
+             sapp_width(), sapp_height(),
+             sg_query_backend() == SG_BACKEND_D3D11   ? "D3D11"
+             : sg_query_backend() == SG_BACKEND_METAL_MACOS ? "Metal"
+                                                            : "GL");
+
+  // Layout runs in points, so the UI keeps its size on high-DPI displays
+  int width = (int)(sapp_widthf() / sapp_dpi_scale());
+  int height = (int)(sapp_heightf() / sapp_dpi_scale());
+  if (!ui_init(&app.ui_state, width, height)) {
+    engine_log(ENGINE_LOG_ERROR, "[sokol] Failed to initialize UI");
+    ui_shutdown(&app.ui_state);
+    sapp_quit();
+    return;
+  }
+  app.ui_ready = true;
+  Clay_SetDebugModeEnabled(false);
+  ui_start_analyzer(&app.ui_state, &app.control);
+}
+
+static void frame(void) {
+  if (!app.ui_ready) {
+    return;
+  }
+  ENGINE_TRACE_THREAD_NAME("ui");
+
+  // Update UI state
+  ui_update(&app.ui_state);
+
+  // Build UI layout
+  Clay_RenderCommandArray renderCommands =
+      ui_build_layout(&app.ui_state, &app.control);
+
+  // Handle UI interactions (button clicks, etc.)
+  ui_handle_interactions(&app.ui_state, &app.control);
+
+  // Render
+  Clay_Color background = COLOR_BACKGROUND;
+  sg_begin_pass(&(sg_pass){
+      .action = {.colors[0] = {.load_action = SG_LOADACTION_CLEAR,
+                               .clear_value = {background.r / 255.0F,
+                                               background.g / 255.0F,
+                                               background.b / 255.0F, 1.0F}}},
+      .swapchain = sglue_swapchain()});
+  ui_render(&app.ui_state, renderCommands);
+  sg_end_pass();
+  sg_commit();
+
+  app.fps_log_elapsed += sapp_frame_duration();
+  if (app.fps_log_elapsed >= UI_FPS_LOG_SECONDS) {
+    engine_log(ENGINE_LOG_DEBUG, "[sokol] FPS: %.0f",
+               1.0 / sapp_frame_duration());
+    app.fps_log_elapsed = 0.0;
+  }
+}
+
+static void event(const sapp_event *ev) {
+  if (!app.ui_ready) {
+    return;
+  }
+  ui_handle_event(&app.ui_state, ev);
+  if (ev->type != SAPP_EVENTTYPE_KEY_DOWN || ev->key_repeat) {
+    return;
+  }
+
+  // Handle keyboard shortcuts
+  switch (ev->key_code) {
+  case SAPP_KEYCODE_ESCAPE:
+    sapp_request_quit();
+    break;
+  case SAPP_KEYCODE_SPACE:
+    control_thread_request(&app.control,
+                           &(ControlRequest){.type = CONTROL_TOGGLE_PLAYING});
+    break;
+  case SAPP_KEYCODE_T:
+    // Add track with 'T' key
+    control_thread_request(&app.control,
+                           &(ControlRequest){.type = CONTROL_ADD_TRACK});
+    break;
+  case SAPP_KEYCODE_R:
+    // Record armed input tracks with 'R'
+    control_thread_request(&app.control,
+                           &(ControlRequest){.type = CONTROL_TOGGLE_RECORDING});
+    break;
+  case SAPP_KEYCODE_S:
+    // Save the session with Ctrl+S
+    if (ev->modifiers & SAPP_MODIFIER_CTRL) {
+      control_thread_request(&app.control,
+                             &(ControlRequest){.type = CONTROL_SAVE_SESSION});
+    }
+    break;
+  case SAPP_KEYCODE_Z:
+    // Undo with Ctrl+Z, redo with Ctrl+Shift+Z
+    if (ev->modifiers & SAPP_MODIFIER_CTRL) {
+      ControlRequestType type = (ev->modifiers & SAPP_MODIFIER_SHIFT)
+                                    ? CONTROL_REDO
+                                    : CONTROL_UNDO;
+      control_thread_request(&app.control, &(ControlRequest){.type = type});
+    }
+    break;
+  case SAPP_KEYCODE_Y:
+    // Redo with Ctrl+Y
+    if (ev->modifiers & SAPP_MODIFIER_CTRL) {
+      control_thread_request(&app.control,
+                             &(ControlRequest){.type = CONTROL_REDO});
+    }
+    break;
+  case SAPP_KEYCODE_F9:
+    engine_trace_write_json(ENGINE_TRACE_DEFAULT_PATH);
+    break;
+  default:
+    break;
+  }
+}
+
+static void cleanup(void) {
+  if (app.ui_ready) {
+    ui_shutdown(&app.ui_state);
+    app.ui_ready = false;
+  }
+  sgl_shutdown();
+  sg_shutdown();
+  midi_input_close(&app.midi);
+  control_thread_destroy(&app.control);
+  remove(CONTROL_AUTOSAVE_PATH); // Only a crash leaves it behind
+  audio_engine_shutdown(&app.engine);
+  engine_trace_shutdown();
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+sapp_desc sokol_main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+  engine_log_set_sink(engine_log_to_stdout, NULL);
+
+  // Trace builds (-DAIRDAW_TRACE) record from here on; F9 writes the trace
+  engine_trace_init();
+
+  // Initialize audio engine first (before window, so we can fail fast)
+  // AIRDAW_BACKEND=nodes runs the mix through miniaudio's node graph
+  AudioEngineConfig config = audio_engine_config_init(ENGINE_LATENCY_DEFAULT);
+  const char *backend = getenv("AIRDAW_BACKEND");
+  if (backend && strcmp(backend, "nodes") == 0) {
+    config.backend = ENGINE_BACKEND_NODE_GRAPH;
+  }
+  if (!audio_engine_init_with_config(&app.engine, &config)) {
+    engine_log(ENGINE_LOG_ERROR, "Failed to initialize audio engine");
+    exit(1);
+  }
+
+  // Recover the autosave a crash left behind, else open the saved session
+  // (Ctrl+S writes it), else start from a demo one
+  int keys = -1;
+  bool recovered =
+      audio_engine_load_session(&app.engine, CONTROL_AUTOSAVE_PATH);
+  if (recovered) {
+    engine_log(ENGINE_LOG_WARNING, "[sokol] Recovered unsaved changes from %s",
+               CONTROL_AUTOSAVE_PATH);
+  }
+  if (!recovered &&
+      !audio_engine_load_session(&app.engine, CONTROL_SESSION_PATH)) {
+    audio_engine_add_track(&app.engine, "Bass", 110.0F);
+    audio_engine_add_track(&app.engine, "Lead", 440.0F);
+    audio_engine_add_track(&app.engine, "Pad", 220.0F);
+
+    // Add some effects to demonstrate functionality
+    audio_engine_add_effect(&app.engine, 0, EFFECT_LOWPASS);
+    audio_engine_add_effect(&app.engine, 1, EFFECT_HIGHPASS);
+    audio_engine_add_effect(&app.engine, 2, EFFECT_GAIN);
+    keys = audio_engine_add_instrument_track(&app.engine, "Keys", OSC_SAW);
+  }
+
+  // From here on engine edits go through the control thread
+  bool control_ready = control_thread_init(&app.control, &app.engine);
+  if (control_ready) {
+    control_thread_set_autosave(&app.control, CONTROL_AUTOSAVE_PATH,
+                                CONTROL_AUTOSAVE_MS);
+  }
+  if (!control_ready || !control_thread_start(&app.control)) {
+    engine_log(ENGINE_LOG_ERROR, "Failed to start control thread");
+    control_thread_destroy(&app.control);
+    audio_engine_shutdown(&app.engine);
+    exit(1);
+  }
+
+  // Play the first MIDI input, if any, on the instrument track (a loaded
+  // session keeps the tracks it had armed)
+  if (midi_input_device_count() > 0 &&
+      midi_input_open(&app.midi, &app.engine, 0) && keys >= 0) {
+    control_thread_request(&app.control,
+                           &(ControlRequest){.type = CONTROL_TOGGLE_TRACK_ARMED,
+                                             .track_index = keys});
+  }
+
+  // No frame pacer: sokol_app has no event waiting, so frames follow vsync
+  return (sapp_desc){
+      .init_cb = init,
+      .frame_cb = frame,
+      .cleanup_cb = cleanup,
+      .event_cb = event,
+      .width = WINDOW_WIDTH,
+      .height = WINDOW_HEIGHT,
+      .window_title = WINDOW_TITLE,
+      .high_dpi = true,
+      .swap_interval = 1,
+      .logger.func = slog_func,
+  };
+}
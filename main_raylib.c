@@ -5,6 +5,10 @@
 #include "vendor/clay/clay.h"
 
 #include "audio_engine.h"
+#include "control_thread.h"
+#include "engine_trace.h"
+#include "engine_log.h"
+#include "midi_input.h"
 #include "renderer.h"
 #include "renderer_utils.h"
 #include "ui_clay.h"
@@ -12,6 +16,8 @@
 #include <raylib.h>
 #include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 // ============================================================================
 // CONSTANTS
@@ -21,6 +27,88 @@
 #define WINDOW_HEIGHT 900
 #define WINDOW_TITLE "AirDAW - Miniaudio + Raylib + Clay UI"
 
+#define UI_FRAME_CAP_DEFAULT 144     // Full rate, while interacting
+#define UI_UPDATE_HZ 30              // Meter/transport rate while audio plays
+#define UI_INPUT_GRACE_SECONDS 0.25  // Full rate lingers after the last input
+#define UI_FPS_LOG_SECONDS 5.0
+
+// ============================================================================
+// FRAME PACING
+// ============================================================================
+
+// Adaptive pacing runs at the frame cap only while the user interacts,
+// at UI_UPDATE_HZ while meters or the transport move, and otherwise blocks
+// in EndDrawing until the next input event. Fixed pacing always runs at
+// the cap (AIRDAW_PACING=fixed; AIRDAW_FPS_CAP sets the cap).
+typedef enum { UI_PACING_ADAPTIVE, UI_PACING_FIXED } FramePacingMode;
+
+typedef struct {
+  FramePacingMode mode;
+  int frame_cap;
+  int target_fps;       // Currently applied SetTargetFPS value
+  bool waiting;         // Event waiting enabled
+  double last_input;    // GetTime() of the last input event
+} FramePacer;
+
+static void frame_pacer_init(FramePacer *pacer) {
+  pacer->mode = UI_PACING_ADAPTIVE;
+  pacer->frame_cap = UI_FRAME_CAP_DEFAULT;
+  pacer->target_fps = 0;
+  pacer->waiting = false;
+  pacer->last_input = 0.0;
+
+  const char *pacing = getenv("AIRDAW_PACING");
+  if (pacing && strcmp(pacing, "fixed") == 0) {
+    pacer->mode = UI_PACING_FIXED;
+  }
+  const char *cap = getenv("AIRDAW_FPS_CAP");
+  if (cap && atoi(cap) > 0) {
+    pacer->frame_cap = atoi(cap);
+  }
+}
+
+static void frame_pacer_apply(FramePacer *pacer, int fps, bool wait) {
+  if (fps > pacer->frame_cap) {
+    fps = pacer->frame_cap;
+  }
+  if (fps != pacer->target_fps) {
+    SetTargetFPS(fps);
+    pacer->target_fps = fps;
+  }
+  if (wait != pacer->waiting) {
+    if (wait) {
+      EnableEventWaiting();
+    } else {
+      DisableEventWaiting();
+    }
+    pacer->waiting = wait;
+  }
+}
+
+// Pick the rate for the next frame (call once per frame before EndDrawing)
+static void frame_pacer_update(FramePacer *pacer, const UIState *ui_state) {
+  if (pacer->mode == UI_PACING_FIXED) {
+    frame_pacer_apply(pacer, pacer->frame_cap, false);
+    return;
+  }
+
+  double now = GetTime();
+  if (ui_state->had_input) {
+    pacer->last_input = now;
+  }
+  bool interacting = ui_state->active_slider_id != 0 || ui_state->mouse_down ||
+                     now - pacer->last_input < UI_INPUT_GRACE_SECONDS;
+  bool animating = ui_state->snapshot.playing || !ui_meters_at_rest(ui_state);
+
+  if (interacting) {
+    frame_pacer_apply(pacer, pacer->frame_cap, false);
+  } else if (animating) {
+    frame_pacer_apply(pacer, UI_UPDATE_HZ, false);
+  } else {
+    frame_pacer_apply(pacer, UI_UPDATE_HZ, true);
+  }
+}
+
 // ============================================================================
 // RAYLIB LOGGING CALLBACK
 // ============================================================================
@@ -55,6 +143,28 @@ static void raylib_log_callback(int log_level, const char *text, va_list args) {
   printf("\n");
 }
 
+// Route engine messages through raylib's logger so both share one format.
+// While an engine runs this is only called from the engine's log thread.
+static void engine_log_to_raylib(void *user_data, EngineLogLevel level, const char *message) {
+  (void)user_data;
+  int raylib_level = LOG_INFO;
+  switch (level) {
+  case ENGINE_LOG_DEBUG:
+    raylib_level = LOG_DEBUG;
+    break;
+  case ENGINE_LOG_WARNING:
+    raylib_level = LOG_WARNING;
+    break;
+  case ENGINE_LOG_ERROR:
+    raylib_level = LOG_ERROR;
+    break;
+  default:
+    raylib_level = LOG_INFO;
+    break;
+  }
+  TraceLog(raylib_level, "%s", message);
+}
+
 // ============================================================================
 // MAIN
 // ============================================================================
@@ -63,42 +173,67 @@ int main(void) {
   // Set custom log callback for Raylib
   SetTraceLogCallback(raylib_log_callback);
   SetTraceLogLevel(LOG_INFO);
+  engine_log_set_sink(engine_log_to_raylib, NULL);
+
+  // Trace builds (-DAIRDAW_TRACE) record from here on; F9 writes the trace
+  engine_trace_init();
+  ENGINE_TRACE_THREAD_NAME("ui");
 
   // Initialize audio engine first (before window, so we can fail fast)
+  // AIRDAW_BACKEND=nodes runs the mix through miniaudio's node graph
   AudioEngine engine = {0};
+  AudioEngineConfig config = audio_engine_config_init(ENGINE_LATENCY_DEFAULT);
+  const char *backend = getenv("AIRDAW_BACKEND");
+  if (backend && strcmp(backend, "nodes") == 0) {
+    config.backend = ENGINE_BACKEND_NODE_GRAPH;
+  }
 
-  if (!audio_engine_init(&engine)) {
+  if (!audio_engine_init_with_config(&engine, &config)) {
     TraceLog(LOG_ERROR, "Failed to initialize audio engine");
     return 1;
   }
-    ma_engine_config config = ma_engine_config_init();
-    config.pDevice = &engine.device;
-    config.pLog = &engine.log;
-    ma_engine *ng = malloc(sizeof(ma_engine));
-    ma_result res = ma_engine_init(&config, ng);
-    if (res != MA_SUCCESS) {
-        TraceLog(LOG_ERROR, "%s", ma_result_description(res));
-        return 1;
-    }
-    if(&engine.device == ma_engine_get_device(ng)) {
-        int listeners = ma_engine_get_time(ng);
-        ma_log *lg = ma_engine_get_log(ng);
-        ma_log_postf(lg,MA_LOG_LEVEL_WARNING, "I SEE %d", listeners);
-    }
-  // Add some initial tracks
-  audio_engine_add_track(&engine, "Bass", 110.0F);
-  audio_engine_add_track(&engine, "Lead", 440.0F);
-  audio_engine_add_track(&engine, "Pad", 220.0F);
 
-  // Add some effects to demonstrate functionality
-  audio_engine_add_effect(&engine.tracks[0], EFFECT_LOWPASS);
-  audio_engine_add_effect(&engine.tracks[1], EFFECT_HIGHPASS);
-  audio_engine_add_effect(&engine.tracks[2], EFFECT_GAIN);
+  // Recover the autosave a crash left behind, else open the saved session
+  // (Ctrl+S writes it), else start from a demo one
+  int keys = -1;
+  bool recovered = audio_engine_load_session(&engine, CONTROL_AUTOSAVE_PATH);
+  if (recovered) {
+    TraceLog(LOG_WARNING, "[raylib] Recovered unsaved changes from %s",
+             CONTROL_AUTOSAVE_PATH);
+  }
+  if (!recovered && !audio_engine_load_session(&engine, CONTROL_SESSION_PATH)) {
+    audio_engine_add_track(&engine, "Bass", 110.0F);
+    audio_engine_add_track(&engine, "Lead", 440.0F);
+    audio_engine_add_track(&engine, "Pad", 220.0F);
+
+    // Add some effects to demonstrate functionality
+    audio_engine_add_effect(&engine, 0, EFFECT_LOWPASS);
+    audio_engine_add_effect(&engine, 1, EFFECT_HIGHPASS);
+    audio_engine_add_effect(&engine, 2, EFFECT_GAIN);
+    keys = audio_engine_add_instrument_track(&engine, "Keys", OSC_SAW);
+  }
+
+  // From here on engine edits go through the control thread, so transport
+  // and track commands never wait behind a frame
+  ControlThread control;
+  bool control_ready = control_thread_init(&control, &engine);
+  if (control_ready) {
+    control_thread_set_autosave(&control, CONTROL_AUTOSAVE_PATH,
+                                CONTROL_AUTOSAVE_MS);
+  }
+  if (!control_ready || !control_thread_start(&control)) {
+    TraceLog(LOG_ERROR, "Failed to start control thread");
+    control_thread_destroy(&control);
+    audio_engine_shutdown(&engine);
+    return 1;
+  }
 
   // Initialize window
   SetConfigFlags(FLAG_WINDOW_RESIZABLE);
   InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE);
-  SetTargetFPS(144);
+  FramePacer pacer;
+  frame_pacer_init(&pacer);
+  frame_pacer_apply(&pacer, pacer.frame_cap, false);
   MaximizeWindow();
   SetExitKey(KEY_NULL); // Disable ESC to quit (we'll handle it manually)
 
@@ -110,13 +245,26 @@ int main(void) {
   if (!ui_init(&ui_state, WINDOW_WIDTH, WINDOW_HEIGHT)) {
     TraceLog(LOG_ERROR, "[raylib] Failed to initialize UI");
     CloseWindow();
+    control_thread_destroy(&control);
     audio_engine_shutdown(&engine);
     return 1;
   }
   Clay_SetDebugModeEnabled(false);
+  ui_start_analyzer(&ui_state, &control);
+
+  // Play the first MIDI input, if any, on the instrument track (a loaded
+  // session keeps the tracks it had armed)
+  MidiInput midi = {0};
+  if (midi_input_device_count() > 0 && midi_input_open(&midi, &engine, 0) &&
+      keys >= 0) {
+    control_thread_request(&control,
+                           &(ControlRequest){.type = CONTROL_TOGGLE_TRACK_ARMED,
+                                             .track_index = keys});
+  }
 
   // Main loop
   bool should_quit = false;
+  double last_fps_log = 0.0;
 
   while (!WindowShouldClose() && !should_quit) {
 
@@ -125,21 +273,43 @@ int main(void) {
       should_quit = true;
     }
 
+    // Shortcuts are queued straight away, before any layout or drawing
     if (IsKeyPressed(KEY_SPACE)) {
-      bool playing = atomic_load(&engine.playing);
-      atomic_store(&engine.playing, !playing);
-      TraceLog(LOG_INFO, "[raylib] Master play toggled: %s",
-               !playing ? "ON" : "OFF");
+      control_thread_request(
+          &control, &(ControlRequest){.type = CONTROL_TOGGLE_PLAYING});
     }
 
     // Add track with 'T' key
     if (IsKeyPressed(KEY_T)) {
-      if (engine.track_count < MAX_TRACKS) {
-        char name[32];
-        float freq = 220.0F * powf(2.0F, (float)engine.track_count / 12.0F);
-        snprintf(name, sizeof(name), "Track %d", engine.track_count + 1);
-        audio_engine_add_track(&engine, name, freq);
-      }
+      control_thread_request(&control,
+                             &(ControlRequest){.type = CONTROL_ADD_TRACK});
+    }
+
+    // Record armed input tracks with 'R'
+    if (IsKeyPressed(KEY_R)) {
+      control_thread_request(
+          &control, &(ControlRequest){.type = CONTROL_TOGGLE_RECORDING});
+    }
+
+    // Save the session with Ctrl+S, undo with Ctrl+Z, redo with Ctrl+Y or
+    // Ctrl+Shift+Z
+    bool ctrl = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
+    bool shift = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
+    if (ctrl && IsKeyPressed(KEY_S)) {
+      control_thread_request(
+          &control, &(ControlRequest){.type = CONTROL_SAVE_SESSION});
+    }
+    if (ctrl && IsKeyPressed(KEY_Z) && !shift) {
+      control_thread_request(&control,
+                             &(ControlRequest){.type = CONTROL_UNDO});
+    }
+    if (ctrl && (IsKeyPressed(KEY_Y) || (IsKeyPressed(KEY_Z) && shift))) {
+      control_thread_request(&control,
+                             &(ControlRequest){.type = CONTROL_REDO});
+    }
+
+    if (IsKeyPressed(KEY_F9)) {
+      engine_trace_write_json(ENGINE_TRACE_DEFAULT_PATH);
     }
 
     // Update UI state
@@ -147,10 +317,10 @@ int main(void) {
 
     // Build UI layout
     Clay_RenderCommandArray renderCommands =
-        ui_build_layout(&ui_state, &engine);
+        ui_build_layout(&ui_state, &control);
 
     // Handle UI interactions (button clicks, etc.)
-    ui_handle_interactions(&ui_state, &engine);
+    ui_handle_interactions(&ui_state, &control);
 
     // Render
     BeginDrawing();
@@ -159,15 +329,25 @@ int main(void) {
     // Render Clay UI
     ui_render(&ui_state, renderCommands);
 
-    TraceLog(LOG_DEBUG, "[raylib] FPS: %d", GetFPS());
+    if (GetTime() - last_fps_log >= UI_FPS_LOG_SECONDS) {
+      TraceLog(LOG_DEBUG, "[raylib] FPS: %d (target %d%s)", GetFPS(),
+               pacer.target_fps, pacer.waiting ? ", waiting for input" : "");
+      last_fps_log = GetTime();
+    }
 
+    // Choose the next frame's rate; EndDrawing sleeps (or waits) accordingly
+    frame_pacer_update(&pacer, &ui_state);
     EndDrawing();
   }
 
   // Cleanup
+  midi_input_close(&midi);
   ui_shutdown(&ui_state);
   CloseWindow();
+  control_thread_destroy(&control);
+  remove(CONTROL_AUTOSAVE_PATH); // Only a crash leaves it behind
   audio_engine_shutdown(&engine);
+  engine_trace_shutdown();
 
   return 0;
 }
@@ -0,0 +1,107 @@
+#include "meters.h"
+#include <math.h>
+#include <string.h>
+
+// ============================================================================
+// ACCUMULATION
+// ============================================================================
+
+void meter_accumulator_publish(const MeterAccumulator* acc, MeterChannel* channel, uint64_t block_frame) {
+    MeterRecord record = {
+        .clip_count = meter_channel_clip_count(channel) + acc->clips,
+        .block_frame = block_frame,
+    };
+    for (int c = 0; c < 2; c++) {
+        record.peak[c] = acc->peak[c];
+        record.rms[c] = acc->frames > 0 ? sqrtf(acc->sum_squares[c] / (float)acc->frames) : 0.0f;
+    }
+    meter_channel_publish(channel, &record);
+}
+
+void dsp_load_accumulator_add(DspLoadAccumulator* acc, float load, uint32_t frames, uint64_t window_frames,
+                              DspLoadRecord* record) {
+    if (acc->count == 0 || load < acc->min) acc->min = load;
+    if (acc->count == 0 || load > acc->max) acc->max = load;
+    acc->sum += load;
+    acc->count++;
+    acc->frames += frames;
+    record->load = load;
+
+    if (acc->frames >= window_frames) {
+        record->load_min = acc->min;
+        record->load_avg = acc->sum / (float)acc->count;
+        record->load_max = acc->max;
+        dsp_load_accumulator_reset(acc);
+    }
+}
+
+// ============================================================================
+// UI BALLISTICS
+// ============================================================================
+
+static float db_release_factor(float db_per_sec, float dt) {
+    return powf(10.0f, -db_per_sec * dt / 20.0f);
+}
+
+void meter_ballistics_reset(MeterBallistics* meter) {
+    memset(meter, 0, sizeof(MeterBallistics));
+}
+
+void meter_ballistics_update(MeterBallistics* meter, const MeterRecord* record, float dt) {
+    bool new_block = record && record->block_frame != meter->last_block_frame;
+    float peak_release = db_release_factor(METER_RELEASE_DB_PER_SEC, dt);
+    float hold_release = db_release_factor(METER_HOLD_RELEASE_DB_PER_SEC, dt);
+    float rms_coeff = 1.0f - expf(-dt / METER_RMS_TIME_CONSTANT);
+
+    for (int c = 0; c < 2; c++) {
+        float block_peak = new_block ? record->peak[c] : 0.0f;
+        float block_rms = new_block ? record->rms[c] : 0.0f;
+
+        // Peak: instant attack, constant dB/s release
+        meter->peak[c] *= peak_release;
+        if (block_peak > meter->peak[c]) {
+            meter->peak[c] = block_peak;
+        }
+
+        // Hold marker: latch new maxima, release after the hold time
+        if (block_peak >= meter->hold[c]) {
+            meter->hold[c] = block_peak;
+            meter->hold_timer[c] = METER_HOLD_SECONDS;
+        } else if (meter->hold_timer[c] > 0.0f) {
+            meter->hold_timer[c] -= dt;
+        } else {
+            meter->hold[c] *= hold_release;
+        }
+        if (meter->hold[c] < meter->peak[c]) {
+            meter->hold[c] = meter->peak[c];
+        }
+
+        // RMS: one-pole integration towards the latest block value; only
+        // integrate when a block arrived so stalls read as a decay
+        if (new_block) {
+            meter->rms[c] += (block_rms - meter->rms[c]) * rms_coeff;
+        } else {
+            meter->rms[c] *= peak_release;
+        }
+    }
+
+    if (meter->clip_timer > 0.0f) {
+        meter->clip_timer -= dt;
+    }
+    if (new_block) {
+        if (record->clip_count != meter->clip_count) {
+            meter->clip_timer = METER_CLIP_HOLD_SECONDS;
+            meter->clip_count = record->clip_count;
+        }
+        meter->last_block_frame = record->block_frame;
+    }
+}
+
+void meter_ballistics_poll(MeterBallistics* meter, MeterChannel* channel, float dt) {
+    MeterRecord record;
+    if (meter_channel_read(channel, &record)) {
+        meter_ballistics_update(meter, &record, dt);
+    } else {
+        meter_ballistics_update(meter, NULL, dt);
+    }
+}
@@ -0,0 +1,245 @@
+// meters.h - Lock-free meter publishing (audio thread -> UI)
+// The audio thread computes one MeterRecord per block and publishes it through
+// a seqlock: a single writer, any number of readers, no locks and no waiting
+// on the writer side. The UI reads the latest record and applies its own
+// peak-hold/release ballistics, so display smoothing costs the audio thread
+// nothing.
+#pragma once
+#ifndef METERS_H
+#define METERS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// ============================================================================
+// METER RECORD
+// ============================================================================
+
+#define METER_CLIP_LEVEL 1.0f       // Samples at or above this count as clipped
+
+typedef struct {
+    float peak[2];          // Per-block absolute peak, L/R
+    float rms[2];           // Per-block RMS, L/R
+    uint32_t clip_count;    // Cumulative count of clipped samples
+    uint64_t block_frame;   // Engine frame position at the start of the block
+} MeterRecord;
+
+// Seqlock-protected record. Payload fields are individually atomic (relaxed)
+// so concurrent reads are well defined; the sequence counter makes the
+// record as a whole consistent.
+typedef struct {
+    _Alignas(64) atomic_uint sequence;  // Odd while a write is in progress
+    _Atomic float peak[2];
+    _Atomic float rms[2];
+    atomic_uint clip_count;
+    _Atomic uint64_t block_frame;
+} MeterChannel;
+
+// ============================================================================
+// SEQLOCK (audio thread writes, UI reads)
+// ============================================================================
+
+static inline void meter_channel_publish(MeterChannel* channel, const MeterRecord* record) {
+    unsigned int seq = atomic_load_explicit(&channel->sequence, memory_order_relaxed);
+    atomic_store_explicit(&channel->sequence, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    for (int c = 0; c < 2; c++) {
+        atomic_store_explicit(&channel->peak[c], record->peak[c], memory_order_relaxed);
+        atomic_store_explicit(&channel->rms[c], record->rms[c], memory_order_relaxed);
+    }
+    atomic_store_explicit(&channel->clip_count, record->clip_count, memory_order_relaxed);
+    atomic_store_explicit(&channel->block_frame, record->block_frame, memory_order_relaxed);
+
+    atomic_store_explicit(&channel->sequence, seq + 2, memory_order_release);
+}
+
+// Writer-side read of the cumulative clip count (no synchronization needed)
+static inline uint32_t meter_channel_clip_count(MeterChannel* channel) {
+    return atomic_load_explicit(&channel->clip_count, memory_order_relaxed);
+}
+
+// Read a consistent copy of the latest record. Returns false if the writer
+// kept interfering (the caller should keep its previous record).
+static inline bool meter_channel_read(MeterChannel* channel, MeterRecord* out) {
+    for (int attempt = 0; attempt < 8; attempt++) {
+        unsigned int seq_begin = atomic_load_explicit(&channel->sequence, memory_order_acquire);
+        if (seq_begin & 1u) {
+            continue;
+        }
+
+        for (int c = 0; c < 2; c++) {
+            out->peak[c] = atomic_load_explicit(&channel->peak[c], memory_order_relaxed);
+            out->rms[c] = atomic_load_explicit(&channel->rms[c], memory_order_relaxed);
+        }
+        out->clip_count = atomic_load_explicit(&channel->clip_count, memory_order_relaxed);
+        out->block_frame = atomic_load_explicit(&channel->block_frame, memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&channel->sequence, memory_order_relaxed) == seq_begin) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// ACCUMULATION (audio thread)
+// ============================================================================
+
+// Statistics gathered over the sub-blocks of one callback, published as a
+// single MeterRecord at the end of it
+typedef struct {
+    float peak[2];
+    float sum_squares[2];
+    uint32_t frames;
+    uint32_t clips;
+} MeterAccumulator;
+
+static inline void meter_accumulator_reset(MeterAccumulator* acc) {
+    acc->peak[0] = acc->peak[1] = 0.0f;
+    acc->sum_squares[0] = acc->sum_squares[1] = 0.0f;
+    acc->frames = 0;
+    acc->clips = 0;
+}
+
+// Publish the accumulated statistics (silence if nothing was accumulated)
+void meter_accumulator_publish(const MeterAccumulator* acc, MeterChannel* channel, uint64_t block_frame);
+
+// ============================================================================
+// DSP LOAD (audio thread writes, UI reads)
+// ============================================================================
+
+// How long each callback took against the duration of the audio it
+// rendered (1.0 = the whole period). Published after every callback through
+// the same kind of seqlock as the meters.
+typedef struct {
+    float load;                 // Last callback
+    float load_min;             // Over the last completed window
+    float load_avg;
+    float load_max;
+    uint32_t late_callbacks;    // Cumulative: callbacks that overran their period
+    uint32_t xruns;             // Cumulative: late callbacks plus device interruptions
+    uint64_t callbacks;         // Cumulative
+} DspLoadRecord;
+
+typedef struct {
+    _Alignas(64) atomic_uint sequence;  // Odd while a write is in progress
+    _Atomic float load;
+    _Atomic float load_min;
+    _Atomic float load_avg;
+    _Atomic float load_max;
+    atomic_uint late_callbacks;
+    atomic_uint xruns;
+    _Atomic uint64_t callbacks;
+} DspLoadChannel;
+
+static inline void dsp_load_channel_publish(DspLoadChannel* channel, const DspLoadRecord* record) {
+    unsigned int seq = atomic_load_explicit(&channel->sequence, memory_order_relaxed);
+    atomic_store_explicit(&channel->sequence, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    atomic_store_explicit(&channel->load, record->load, memory_order_relaxed);
+    atomic_store_explicit(&channel->load_min, record->load_min, memory_order_relaxed);
+    atomic_store_explicit(&channel->load_avg, record->load_avg, memory_order_relaxed);
+    atomic_store_explicit(&channel->load_max, record->load_max, memory_order_relaxed);
+    atomic_store_explicit(&channel->late_callbacks, record->late_callbacks, memory_order_relaxed);
+    atomic_store_explicit(&channel->xruns, record->xruns, memory_order_relaxed);
+    atomic_store_explicit(&channel->callbacks, record->callbacks, memory_order_relaxed);
+
+    atomic_store_explicit(&channel->sequence, seq + 2, memory_order_release);
+}
+
+// Read a consistent copy of the latest record. Returns false if the writer
+// kept interfering (the caller should keep its previous record).
+static inline bool dsp_load_channel_read(DspLoadChannel* channel, DspLoadRecord* out) {
+    for (int attempt = 0; attempt < 8; attempt++) {
+        unsigned int seq_begin = atomic_load_explicit(&channel->sequence, memory_order_acquire);
+        if (seq_begin & 1u) {
+            continue;
+        }
+
+        out->load = atomic_load_explicit(&channel->load, memory_order_relaxed);
+        out->load_min = atomic_load_explicit(&channel->load_min, memory_order_relaxed);
+        out->load_avg = atomic_load_explicit(&channel->load_avg, memory_order_relaxed);
+        out->load_max = atomic_load_explicit(&channel->load_max, memory_order_relaxed);
+        out->late_callbacks = atomic_load_explicit(&channel->late_callbacks, memory_order_relaxed);
+        out->xruns = atomic_load_explicit(&channel->xruns, memory_order_relaxed);
+        out->callbacks = atomic_load_explicit(&channel->callbacks, memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&channel->sequence, memory_order_relaxed) == seq_begin) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Window statistics gathered over several callbacks (audio thread)
+typedef struct {
+    float min;
+    float max;
+    float sum;
+    uint32_t count;
+    uint64_t frames;
+} DspLoadAccumulator;
+
+static inline void dsp_load_accumulator_reset(DspLoadAccumulator* acc) {
+    acc->min = 0.0f;
+    acc->max = 0.0f;
+    acc->sum = 0.0f;
+    acc->count = 0;
+    acc->frames = 0;
+}
+
+// Add one callback's load. Once window_frames have been covered the
+// window's min/avg/max are copied into record and a new window starts;
+// until then record keeps the previous window's figures.
+void dsp_load_accumulator_add(DspLoadAccumulator* acc, float load, uint32_t frames, uint64_t window_frames,
+                              DspLoadRecord* record);
+
+// ============================================================================
+// UI BALLISTICS (UI thread only)
+// ============================================================================
+
+#define METER_RELEASE_DB_PER_SEC 20.0f  // Peak bar fall rate
+#define METER_HOLD_SECONDS 1.5f         // Peak-hold marker hold time
+#define METER_HOLD_RELEASE_DB_PER_SEC 40.0f
+#define METER_RMS_TIME_CONSTANT 0.3f    // VU-style RMS integration (seconds)
+#define METER_CLIP_HOLD_SECONDS 2.0f    // Clip indicator latch time
+#define METER_REST_LEVEL 0.001f         // -60 dB: below this a meter draws nothing
+
+typedef struct {
+    float peak[2];          // Displayed peak (instant attack, dB-linear release)
+    float hold[2];          // Peak-hold marker level
+    float hold_timer[2];    // Seconds left before the hold marker releases
+    float rms[2];           // Smoothed RMS
+    float clip_timer;       // Seconds left on the clip indicator
+    uint32_t clip_count;    // Last cumulative clip count seen
+    uint64_t last_block_frame;
+} MeterBallistics;
+
+// Reset display state (e.g. when a slot is reused)
+void meter_ballistics_reset(MeterBallistics* meter);
+
+// Advance ballistics by dt seconds using the latest published record
+void meter_ballistics_update(MeterBallistics* meter, const MeterRecord* record, float dt);
+
+// Convenience: read channel and update ballistics; keeps decaying if the
+// read fails or no new block arrived
+void meter_ballistics_poll(MeterBallistics* meter, MeterChannel* channel, float dt);
+
+static inline bool meter_ballistics_clipping(const MeterBallistics* meter) {
+    return meter->clip_timer > 0.0f;
+}
+
+// Nothing left to animate: bars and hold markers have fallen below
+// METER_REST_LEVEL and the clip indicator has expired
+static inline bool meter_ballistics_at_rest(const MeterBallistics* meter) {
+    return meter->peak[0] < METER_REST_LEVEL && meter->peak[1] < METER_REST_LEVEL &&
+           meter->hold[0] < METER_REST_LEVEL && meter->hold[1] < METER_REST_LEVEL &&
+           !meter_ballistics_clipping(meter);
+}
+
+#endif // METERS_H
@@ -0,0 +1,126 @@
+#include "midi_input.h"
+#include "audio_engine.h"
+#include "engine_log.h"
+#include "engine_thread.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <mmsystem.h>
+#endif
+
+// ============================================================================
+// WIN32 (WinMM)
+// ============================================================================
+
+#ifdef _WIN32
+
+// Channel voice messages only: clock, active sensing and SysEx never
+// reach the engine
+static bool is_channel_message(uint8_t status) {
+    return status >= MIDI_NOTE_OFF && status < 0xF0;
+}
+
+// Runs on the driver's thread: stamp, filter, push. Nothing here may block.
+static void CALLBACK midi_in_callback(HMIDIIN handle, UINT message, DWORD_PTR instance, DWORD_PTR param1,
+                                      DWORD_PTR param2) {
+    (void)handle;
+    (void)param2;
+    if (message != MIM_DATA) {
+        return;
+    }
+    MidiEvent event = {
+        .time_ns = engine_thread_time_ns(),
+        .status = (uint8_t)(param1 & 0xFF),
+        .data1 = (uint8_t)((param1 >> 8) & 0x7F),
+        .data2 = (uint8_t)((param1 >> 16) & 0x7F),
+    };
+    if (!is_channel_message(event.status)) {
+        return;
+    }
+    MidiInput* input = (MidiInput*)instance;
+    atomic_fetch_add_explicit(&input->received, 1, memory_order_relaxed);
+    if (!audio_engine_push_midi(input->engine, &event)) {
+        atomic_fetch_add_explicit(&input->dropped, 1, memory_order_relaxed);
+    }
+}
+
+int midi_input_device_count(void) {
+    return (int)midiInGetNumDevs();
+}
+
+bool midi_input_device_name(int index, char* name, size_t size) {
+    MIDIINCAPSA caps;
+    if (index < 0 || midiInGetDevCapsA((UINT)index, &caps, sizeof(caps)) != MMSYSERR_NOERROR) {
+        return false;
+    }
+    snprintf(name, size, "%s", caps.szPname);
+    return true;
+}
+
+bool midi_input_open(MidiInput* input, struct AudioEngine* engine, int device_index) {
+    memset(input, 0, sizeof(MidiInput));
+    input->engine = engine;
+    HMIDIIN handle = NULL;
+    if (midiInOpen(&handle, (UINT)device_index, (DWORD_PTR)midi_in_callback, (DWORD_PTR)input,
+                   CALLBACK_FUNCTION) != MMSYSERR_NOERROR) {
+        engine_log(ENGINE_LOG_WARNING, "[midi] Failed to open input device %d", device_index);
+        return false;
+    }
+    if (midiInStart(handle) != MMSYSERR_NOERROR) {
+        midiInClose(handle);
+        engine_log(ENGINE_LOG_WARNING, "[midi] Failed to start input device %d", device_index);
+        return false;
+    }
+    input->handle = handle;
+    input->open = true;
+
+    char name[64] = "";
+    midi_input_device_name(device_index, name, sizeof(name));
+    engine_log(ENGINE_LOG_INFO, "[midi] Listening on input device %d: %s", device_index, name);
+    return true;
+}
+
+void midi_input_close(MidiInput* input) {
+    if (!input->open) {
+        return;
+    }
+    // Reset returns only once the driver has stopped calling back
+    midiInStop((HMIDIIN)input->handle);
+    midiInReset((HMIDIIN)input->handle);
+    midiInClose((HMIDIIN)input->handle);
+    input->handle = NULL;
+    input->open = false;
+    engine_log(ENGINE_LOG_INFO, "[midi] Input closed (%llu messages, %llu dropped)",
+               (unsigned long long)atomic_load(&input->received), (unsigned long long)atomic_load(&input->dropped));
+}
+
+// ============================================================================
+// OTHER PLATFORMS (no driver yet)
+// ============================================================================
+
+#else
+
+int midi_input_device_count(void) {
+    return 0;
+}
+
+bool midi_input_device_name(int index, char* name, size_t size) {
+    (void)index;
+    if (size > 0) name[0] = '\0';
+    return false;
+}
+
+bool midi_input_open(MidiInput* input, struct AudioEngine* engine, int device_index) {
+    memset(input, 0, sizeof(MidiInput));
+    input->engine = engine;
+    engine_log(ENGINE_LOG_WARNING, "[midi] No MIDI driver on this platform (device %d)", device_index);
+    return false;
+}
+
+void midi_input_close(MidiInput* input) {
+    input->open = false;
+}
+
+#endif
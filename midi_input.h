@@ -0,0 +1,78 @@
+// midi_input.h - MIDI input devices and timestamped MIDI events
+// Every event is stamped with engine_thread_time_ns() the moment the driver
+// hands it over and pushed, lock-free, onto the engine's MIDI queue. The
+// audio thread maps the stamps onto the next period at a fixed one-period
+// delay and splits rendering at each event's frame, so notes and controller
+// changes land sample-accurately instead of on block boundaries.
+//
+// Devices are opened through WinMM on Windows. Other platforms have no
+// driver yet (no devices are listed); events can still be injected with
+// audio_engine_push_midi.
+#pragma once
+#ifndef MIDI_INPUT_H
+#define MIDI_INPUT_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// EVENTS
+// ============================================================================
+
+#define MIDI_NOTE_OFF 0x80
+#define MIDI_NOTE_ON 0x90
+#define MIDI_CONTROL_CHANGE 0xB0
+#define MIDI_CC_VOLUME 7
+#define MIDI_CC_PAN 10
+#define MIDI_CC_ALL_SOUND_OFF 120
+#define MIDI_CC_ALL_NOTES_OFF 123
+
+// One short (channel voice) message
+typedef struct {
+    uint64_t time_ns;       // engine_thread_time_ns() on arrival
+    uint8_t status;         // Message type | channel
+    uint8_t data1;          // Note or controller number
+    uint8_t data2;          // Velocity or controller value
+} MidiEvent;
+
+// Frame in a period of frame_count frames at which an event stamped
+// event_ns plays, when the previous period started at previous_block_ns.
+// Events keep their spacing with one period of added latency; late ones
+// land on the first frame, early ones on the last.
+static inline uint32_t midi_event_frame_offset(uint64_t event_ns, uint64_t previous_block_ns, uint32_t frame_count,
+                                               uint32_t sample_rate) {
+    if (frame_count == 0 || event_ns <= previous_block_ns) {
+        return 0;
+    }
+    uint64_t frame = (event_ns - previous_block_ns) * sample_rate / 1000000000ULL;
+    return frame < frame_count ? (uint32_t)frame : frame_count - 1;
+}
+
+// ============================================================================
+// INPUT DEVICES
+// ============================================================================
+
+struct AudioEngine;
+
+typedef struct {
+    void* handle;                       // HMIDIIN
+    struct AudioEngine* engine;
+    atomic_uint_fast64_t received;      // Short messages taken from the driver
+    atomic_uint_fast64_t dropped;       // Lost because the engine queue was full
+    bool open;
+} MidiInput;
+
+// Input devices the driver lists
+int midi_input_device_count(void);
+bool midi_input_device_name(int index, char* name, size_t size);
+
+// Open a device and start feeding the engine's MIDI queue. The driver
+// thread becomes the queue's only producer, so open one device per engine.
+bool midi_input_open(MidiInput* input, struct AudioEngine* engine, int device_index);
+
+// Stop and close the device; no events are pushed after it returns
+void midi_input_close(MidiInput* input);
+
+#endif // MIDI_INPUT_H
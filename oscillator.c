@@ -0,0 +1,208 @@
+#include "oscillator.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define OSC_FRAC_BITS (32 - OSC_TABLE_BITS)
+#define OSC_FRAC_SCALE (1.0f / (float)(1u << OSC_FRAC_BITS))
+
+// ============================================================================
+// WAVETABLES
+// ============================================================================
+
+// [waveform][level][sample]; one guard sample so interpolation never wraps
+static float wavetables[OSC_WAVEFORM_COUNT][OSC_TABLE_LEVELS][OSC_TABLE_SIZE + 1];
+static atomic_bool tables_ready = false;
+
+// Fourier amplitude of harmonic k (1-based) for each waveform
+static double harmonic_amplitude(OscWaveform waveform, int k) {
+    switch (waveform) {
+        case OSC_SINE:
+            return k == 1 ? 1.0 : 0.0;
+        case OSC_SAW:
+            return (k % 2 ? 2.0 : -2.0) / (M_PI * k);
+        case OSC_SQUARE:
+            return k % 2 ? 4.0 / (M_PI * k) : 0.0;
+        case OSC_TRIANGLE:
+            if (k % 2 == 0) return 0.0;
+            return ((k / 2) % 2 ? -8.0 : 8.0) / (M_PI * M_PI * k * k);
+        default:
+            return 0.0;
+    }
+}
+
+// Highest harmonic a level may contain: the top fundamental of the level
+// times the harmonic number must stay below the reference Nyquist
+static int level_harmonics(int level) {
+    double top_hz = OSC_TABLE_BASE_HZ * (double)(1 << level);
+    int harmonics = (int)(OSC_TABLE_REFERENCE_RATE * 0.5 / top_hz);
+    if (harmonics > OSC_TABLE_SIZE / 2) harmonics = OSC_TABLE_SIZE / 2;
+    return harmonics < 1 ? 1 : harmonics;
+}
+
+void oscillator_tables_init(void) {
+    if (atomic_load(&tables_ready)) {
+        return;
+    }
+
+    // Additive synthesis using a single double-precision sine table:
+    // sin(2*pi*k*n/N) == sine[(k*n) mod N], so no per-term sin() calls
+    static double sine[OSC_TABLE_SIZE];
+    for (int n = 0; n < OSC_TABLE_SIZE; n++) {
+        sine[n] = sin(2.0 * M_PI * n / OSC_TABLE_SIZE);
+    }
+
+    static double accum[OSC_TABLE_SIZE];
+    for (int w = 0; w < OSC_WAVEFORM_COUNT; w++) {
+        for (int level = 0; level < OSC_TABLE_LEVELS; level++) {
+            memset(accum, 0, sizeof(accum));
+            int harmonics = level_harmonics(level);
+            for (int k = 1; k <= harmonics; k++) {
+                double amp = harmonic_amplitude((OscWaveform)w, k);
+                if (amp == 0.0) continue;
+                for (int n = 0; n < OSC_TABLE_SIZE; n++) {
+                    accum[n] += amp * sine[(k * n) & (OSC_TABLE_SIZE - 1)];
+                }
+            }
+
+            float* table = wavetables[w][level];
+            for (int n = 0; n < OSC_TABLE_SIZE; n++) {
+                table[n] = (float)accum[n];
+            }
+            table[OSC_TABLE_SIZE] = table[0];
+        }
+    }
+
+    atomic_store(&tables_ready, true);
+}
+
+// Mip level whose harmonics all stay below Nyquist for this fundamental
+static int table_level(float frequency) {
+    int level = 0;
+    float top = OSC_TABLE_BASE_HZ;
+    while (frequency > top && level < OSC_TABLE_LEVELS - 1) {
+        top *= 2.0f;
+        level++;
+    }
+    return level;
+}
+
+// ============================================================================
+// OSCILLATOR BANK
+// ============================================================================
+
+void oscillator_bank_init(OscillatorBank* bank, float sample_rate) {
+    memset(bank, 0, sizeof(OscillatorBank));
+    bank->sample_rate = sample_rate;
+}
+
+int oscillator_bank_add_voice(OscillatorBank* bank, OscWaveform waveform, float frequency, float gain) {
+    if (bank->voice_count >= OSC_BANK_MAX_VOICES) {
+        return -1;
+    }
+    int voice = bank->voice_count++;
+    bank->phase[voice] = 0;
+    bank->gain[voice] = gain;
+    bank->gain_target[voice] = gain;
+    bank->gain_step[voice] = 0.0f;
+    bank->gain_ramp_frames[voice] = 0;
+    bank->waveform[voice] = (uint8_t)waveform;
+    bank->active[voice] = 1;
+    oscillator_bank_set_frequency(bank, voice, frequency);
+    return voice;
+}
+
+void oscillator_bank_set_frequency(OscillatorBank* bank, int voice, float frequency) {
+    if (voice < 0 || voice >= bank->voice_count) return;
+    if (frequency < 0.0f) frequency = 0.0f;
+    if (frequency > bank->sample_rate * 0.5f) frequency = bank->sample_rate * 0.5f;
+    bank->frequency[voice] = frequency;
+    bank->increment[voice] = (uint32_t)((double)frequency / bank->sample_rate * 4294967296.0);
+}
+
+void oscillator_bank_set_waveform(OscillatorBank* bank, int voice, OscWaveform waveform) {
+    if (voice < 0 || voice >= bank->voice_count || waveform >= OSC_WAVEFORM_COUNT) return;
+    bank->waveform[voice] = (uint8_t)waveform;
+}
+
+void oscillator_bank_set_active(OscillatorBank* bank, int voice, bool active) {
+    if (voice < 0 || voice >= bank->voice_count) return;
+    bank->active[voice] = active ? 1 : 0;
+}
+
+void oscillator_bank_set_gain_ramp(OscillatorBank* bank, int voice, float target, uint32_t frames) {
+    if (voice < 0 || voice >= bank->voice_count) return;
+    bank->gain_target[voice] = target;
+    bank->gain_ramp_frames[voice] = frames;
+    if (frames == 0) {
+        bank->gain[voice] = target;
+        bank->gain_step[voice] = 0.0f;
+    } else {
+        bank->gain_step[voice] = (target - bank->gain[voice]) / (float)frames;
+    }
+}
+
+int oscillator_bank_remove_voice(OscillatorBank* bank, int voice) {
+    if (voice < 0 || voice >= bank->voice_count) return -1;
+    int last = --bank->voice_count;
+    if (voice == last) return -1;
+    bank->phase[voice] = bank->phase[last];
+    bank->increment[voice] = bank->increment[last];
+    bank->frequency[voice] = bank->frequency[last];
+    bank->gain[voice] = bank->gain[last];
+    bank->gain_target[voice] = bank->gain_target[last];
+    bank->gain_step[voice] = bank->gain_step[last];
+    bank->gain_ramp_frames[voice] = bank->gain_ramp_frames[last];
+    bank->waveform[voice] = bank->waveform[last];
+    bank->active[voice] = bank->active[last];
+    return last;
+}
+
+// Interpolated table read at a fixed-point phase
+static inline float table_read(const float* table, uint32_t phase) {
+    uint32_t index = phase >> OSC_FRAC_BITS;
+    float frac = (float)(phase & ((1u << OSC_FRAC_BITS) - 1)) * OSC_FRAC_SCALE;
+    float a = table[index];
+    float b = table[index + 1];
+    return a + (b - a) * frac;
+}
+
+void oscillator_bank_render(OscillatorBank* bank, float* out, uint32_t frame_count) {
+    memset(out, 0, sizeof(float) * frame_count);
+
+    for (int v = 0; v < bank->voice_count; v++) {
+        if (!bank->active[v]) continue;
+
+        // Per-block setup: table fixed for the block, phase and gain in registers
+        float reference_hz = bank->frequency[v] * (OSC_TABLE_REFERENCE_RATE / bank->sample_rate);
+        const float* table = wavetables[bank->waveform[v]][table_level(reference_hz)];
+        uint32_t phase = bank->phase[v];
+        uint32_t increment = bank->increment[v];
+        float gain = bank->gain[v];
+
+        // Ramping part (envelopes), then the rest of the block at a fixed gain
+        uint32_t ramp = bank->gain_ramp_frames[v] < frame_count ? bank->gain_ramp_frames[v] : frame_count;
+        if (ramp > 0) {
+            float gain_step = bank->gain_step[v];
+            for (uint32_t i = 0; i < ramp; i++) {
+                out[i] += table_read(table, phase) * gain;
+                phase += increment;     // Wraps modulo 2^32 == one cycle
+                gain += gain_step;
+            }
+            bank->gain_ramp_frames[v] -= ramp;
+            if (bank->gain_ramp_frames[v] == 0) {
+                gain = bank->gain_target[v];    // Land exactly, whatever the rounding
+            }
+        }
+        for (uint32_t i = ramp; i < frame_count; i++) {
+            out[i] += table_read(table, phase) * gain;
+            phase += increment;
+        }
+        bank->phase[v] = phase;
+        bank->gain[v] = gain;
+    }
+}
@@ -0,0 +1,69 @@
+// oscillator.h - Wavetable oscillator bank
+// Band-limited wavetables (sine/saw/square/triangle), one mip level per
+// octave so no level carries harmonics above Nyquist, read with a 32-bit
+// fixed-point phase accumulator and linear interpolation. Voices are stored
+// SoA and densely (removing one moves the last into its place), so a bank
+// renders all of its voices in one tight pass per block.
+#pragma once
+#ifndef OSCILLATOR_H
+#define OSCILLATOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define OSC_TABLE_BITS 11
+#define OSC_TABLE_SIZE (1 << OSC_TABLE_BITS)    // Samples per cycle (plus one guard sample)
+#define OSC_TABLE_LEVELS 10                     // Octave mip levels
+#define OSC_TABLE_BASE_HZ 40.0f                 // Level 0 covers fundamentals up to this
+#define OSC_TABLE_REFERENCE_RATE 48000.0f       // Rate the levels are band-limited for
+#define OSC_BANK_MAX_VOICES 16
+
+typedef enum {
+    OSC_SINE = 0,
+    OSC_SAW,
+    OSC_SQUARE,
+    OSC_TRIANGLE,
+    OSC_WAVEFORM_COUNT
+} OscWaveform;
+
+// Structure-of-arrays voice storage (audio thread once published)
+typedef struct {
+    int voice_count;
+    float sample_rate;
+    uint32_t phase[OSC_BANK_MAX_VOICES];        // Fixed-point cycle position (2^32 = one cycle)
+    uint32_t increment[OSC_BANK_MAX_VOICES];    // Phase step per sample
+    float frequency[OSC_BANK_MAX_VOICES];
+    float gain[OSC_BANK_MAX_VOICES];
+    float gain_target[OSC_BANK_MAX_VOICES];     // Gain a ramp ends on (envelopes)
+    float gain_step[OSC_BANK_MAX_VOICES];       // Per-sample gain change while ramping
+    uint32_t gain_ramp_frames[OSC_BANK_MAX_VOICES]; // Samples left in the ramp, 0 for a fixed gain
+    uint8_t waveform[OSC_BANK_MAX_VOICES];
+    uint8_t active[OSC_BANK_MAX_VOICES];
+} OscillatorBank;
+
+// Build the shared wavetables. Call once before any bank renders (the
+// engine does this in audio_engine_init); later calls are no-ops.
+void oscillator_tables_init(void);
+
+// Reset a bank to zero voices
+void oscillator_bank_init(OscillatorBank* bank, float sample_rate);
+
+// Add a voice. Returns its index or -1 if the bank is full.
+int oscillator_bank_add_voice(OscillatorBank* bank, OscWaveform waveform, float frequency, float gain);
+
+void oscillator_bank_set_frequency(OscillatorBank* bank, int voice, float frequency);
+void oscillator_bank_set_waveform(OscillatorBank* bank, int voice, OscWaveform waveform);
+void oscillator_bank_set_active(OscillatorBank* bank, int voice, bool active);
+
+// Ramp a voice's gain linearly from its current value to target over
+// frames samples (spanning renders if needed), then hold it; 0 frames jumps
+void oscillator_bank_set_gain_ramp(OscillatorBank* bank, int voice, float target, uint32_t frames);
+
+// Remove a voice, moving the last voice into its index. Returns the index
+// the moved voice came from, or -1 if nothing moved.
+int oscillator_bank_remove_voice(OscillatorBank* bank, int voice);
+
+// Render the sum of all active voices into out (overwrites frame_count samples)
+void oscillator_bank_render(OscillatorBank* bank, float* out, uint32_t frame_count);
+
+#endif // OSCILLATOR_H
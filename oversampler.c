@@ -0,0 +1,200 @@
+#include "oversampler.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OVERSAMPLER_ALIGNMENT 64
+
+// Filtering-branch taps per stage, first (widest transition) stage first:
+// about 80 dB rejection of the images each stage creates
+static const uint32_t stage_branch_taps[OVERSAMPLER_MAX_STAGES] = {48, 12, 8};
+
+// ============================================================================
+// DESIGN
+// ============================================================================
+
+static double bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 64; k++) {
+        double half_x = x / (2.0 * k);
+        term *= half_x * half_x;
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+// The non-zero off-centre taps of a Kaiser-windowed half-band low-pass
+// with 2 * branch_taps - 1 taps, reversed, normalized to `gain` at DC
+static void design_branch(float* taps, uint32_t branch_taps, float gain) {
+    double centre = (double)branch_taps - 1.0;
+    double values[64];
+    double sum = 0.0;
+    for (uint32_t i = 0; i < branch_taps; i++) {
+        // Tap 2i of the full filter, an odd number of half-rate frames from
+        // the centre, where sin(pi * k / 2) is +-1
+        double k = 2.0 * i - centre;
+        double x = k / (centre + 1.0);
+        double window = bessel_i0(OVERSAMPLER_KAISER_BETA * sqrt(1.0 - x * x)) / bessel_i0(OVERSAMPLER_KAISER_BETA);
+        values[i] = sin(1.5707963267948966 * k) / (1.5707963267948966 * k) * window;
+        sum += values[i];
+    }
+    for (uint32_t i = 0; i < branch_taps; i++) {
+        taps[branch_taps - 1 - i] = (float)(values[i] / sum * gain);
+    }
+}
+
+// ============================================================================
+// LIFECYCLE
+// ============================================================================
+
+typedef struct {
+    uint8_t* next;
+    size_t used;
+} Carver;
+
+// Aligned run of `count` floats; with a NULL base only counts the bytes
+static float* carve(Carver* carver, size_t count) {
+    size_t bytes = (count * sizeof(float) + OVERSAMPLER_ALIGNMENT - 1) / OVERSAMPLER_ALIGNMENT *
+                   OVERSAMPLER_ALIGNMENT;
+    float* run = carver->next ? (float*)(carver->next + carver->used) : NULL;
+    carver->used += bytes;
+    return run;
+}
+
+static void layout(Oversampler* oversampler, Carver* carver) {
+    for (uint32_t s = 0; s < oversampler->stage_count; s++) {
+        OversamplerStage* stage = &oversampler->stages[s];
+        uint32_t input = OVERSAMPLER_CHUNK_FRAMES << s;
+        stage->up_taps = carve(carver, stage->branch_taps);
+        stage->down_taps = carve(carver, stage->branch_taps);
+        for (int c = 0; c < 2; c++) {
+            stage->up_history[c] = carve(carver, stage->branch_taps - 1 + input);
+            stage->even_history[c] = carve(carver, stage->branch_taps - 1 + input);
+            stage->odd_history[c] = carve(carver, stage->branch_taps / 2 + input);
+            stage->output[c] = carve(carver, 2 * (size_t)input);
+        }
+    }
+    oversampler->scratch = carve(carver, (size_t)OVERSAMPLER_CHUNK_FRAMES << (oversampler->stage_count - 1));
+}
+
+Oversampler* oversampler_create(uint32_t factor) {
+    if (!oversampler_factor_valid(factor)) {
+        return NULL;
+    }
+    Oversampler* oversampler = (Oversampler*)calloc(1, sizeof(Oversampler));
+    if (!oversampler) {
+        return NULL;
+    }
+    oversampler->factor = factor;
+    while ((1u << oversampler->stage_count) < factor) {
+        OversamplerStage* stage = &oversampler->stages[oversampler->stage_count];
+        stage->branch_taps = stage_branch_taps[oversampler->stage_count];
+        oversampler->stage_count++;
+    }
+
+    Carver sizing = {0};
+    layout(oversampler, &sizing);
+    oversampler->memory = dsp_aligned_alloc(sizing.used, OVERSAMPLER_ALIGNMENT);
+    if (!oversampler->memory) {
+        free(oversampler);
+        return NULL;
+    }
+    memset(oversampler->memory, 0, sizing.used);
+    Carver carver = {.next = (uint8_t*)oversampler->memory};
+    layout(oversampler, &carver);
+
+    // Each stage delays by its centre tap, branch_taps - 1 frames at its
+    // output rate, on the way up and again on the way down
+    uint32_t top_frames = 0;
+    for (uint32_t s = 0; s < oversampler->stage_count; s++) {
+        OversamplerStage* stage = &oversampler->stages[s];
+        design_branch(stage->up_taps, stage->branch_taps, 1.0f);
+        design_branch(stage->down_taps, stage->branch_taps, 0.5f);
+        top_frames += 2 * (stage->branch_taps - 1) << (oversampler->stage_count - 1 - s);
+    }
+    oversampler->pad_frames = (factor - top_frames % factor) % factor;
+    oversampler->latency = (top_frames + oversampler->pad_frames) / factor;
+    return oversampler;
+}
+
+void oversampler_destroy(Oversampler* oversampler) {
+    if (oversampler) {
+        dsp_aligned_free(oversampler->memory);
+        free(oversampler);
+    }
+}
+
+// ============================================================================
+// CONVERSION
+// ============================================================================
+
+static void up_stage(OversamplerStage* stage, const DspKernels* dsp, float* scratch, int channel, const float* input,
+                     uint32_t frame_count) {
+    uint32_t history = stage->branch_taps - 1;
+    float* line = stage->up_history[channel];
+    memcpy(line + history, input, sizeof(float) * frame_count);
+
+    // Even outputs interpolate; odd ones are the input delayed to the centre tap
+    dsp->fir(scratch, line, stage->up_taps, stage->branch_taps, frame_count);
+    dsp->interleave(stage->output[channel], scratch, line + stage->branch_taps / 2, frame_count);
+    memmove(line, line + frame_count, sizeof(float) * history);
+}
+
+static void down_stage(OversamplerStage* stage, const DspKernels* dsp, int channel, const float* input, float* output,
+                       uint32_t frame_count) {
+    uint32_t even_ahead = stage->branch_taps - 1;
+    uint32_t odd_ahead = stage->branch_taps / 2;
+    float* even = stage->even_history[channel];
+    float* odd = stage->odd_history[channel];
+    for (uint32_t i = 0; i < frame_count; i++) {
+        even[even_ahead + i] = input[2 * i];
+        odd[odd_ahead + i] = input[2 * i + 1];
+    }
+    dsp->fir(output, even, stage->down_taps, stage->branch_taps, frame_count);
+    dsp->mix(output, odd, 0.5f, frame_count);
+    memmove(even, even + frame_count, sizeof(float) * even_ahead);
+    memmove(odd, odd + frame_count, sizeof(float) * odd_ahead);
+}
+
+// Delay top-rate samples by pad_frames, carried across blocks
+static void pad_top(Oversampler* oversampler, int channel, float* top, uint32_t count) {
+    uint32_t pad = oversampler->pad_frames;
+    if (pad == 0) {
+        return;
+    }
+    float carried[OVERSAMPLER_MAX_FACTOR];
+    memcpy(carried, top + count - pad, sizeof(float) * pad);
+    memmove(top + pad, top, sizeof(float) * (count - pad));
+    memcpy(top, oversampler->pad[channel], sizeof(float) * pad);
+    memcpy(oversampler->pad[channel], carried, sizeof(float) * pad);
+}
+
+void oversampler_up(Oversampler* oversampler, const DspKernels* dsp, const float* left, const float* right,
+                    uint32_t frame_count, float* top[2]) {
+    const float* inputs[2] = {left, right};
+    uint32_t last = oversampler->stage_count - 1;
+    for (int c = 0; c < 2; c++) {
+        const float* input = inputs[c];
+        for (uint32_t s = 0; s <= last; s++) {
+            up_stage(&oversampler->stages[s], dsp, oversampler->scratch, c, input, frame_count << s);
+            input = oversampler->stages[s].output[c];
+        }
+        pad_top(oversampler, c, oversampler->stages[last].output[c], frame_count * oversampler->factor);
+        top[c] = oversampler->stages[last].output[c];
+    }
+}
+
+void oversampler_down(Oversampler* oversampler, const DspKernels* dsp, float* left, float* right,
+                      uint32_t frame_count) {
+    float* outputs[2] = {left, right};
+    for (int c = 0; c < 2; c++) {
+        for (uint32_t s = oversampler->stage_count; s-- > 0;) {
+            float* output = s > 0 ? oversampler->stages[s - 1].output[c] : outputs[c];
+            down_stage(&oversampler->stages[s], dsp, c, oversampler->stages[s].output[c], output, frame_count << s);
+        }
+    }
+}
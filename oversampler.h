@@ -0,0 +1,76 @@
+// oversampler.h - Half-band oversampling for effects that alias
+// Runs an effect at 2x, 4x or 8x the engine rate, so nonlinear processing
+// (saturation, and filters near Nyquist) has room above the audio band for
+// what it generates. Each octave is one 2x stage: a linear-phase half-band
+// FIR split into its two polyphase branches. Every other tap of a half-band
+// filter is zero, so one branch is a plain delay and only the other runs
+// through the DspKernels fir kernel: upsampling interpolates the new phase
+// and copies the delayed input into the other, downsampling filters the
+// even phase and adds the odd phase's centre tap. Stages shrink up the
+// cascade, since above the first one the signal already sits far below a
+// quarter of the stage rate.
+//
+// Going up and back down delays a block by oversampler_latency() engine
+// frames, padded at the top rate to a whole frame so PDC can compensate
+// it. Blocks are converted OVERSAMPLER_CHUNK_FRAMES at a time. Everything
+// is allocated by oversampler_create (control thread); converting never
+// allocates and owns no locks.
+#pragma once
+#ifndef OVERSAMPLER_H
+#define OVERSAMPLER_H
+
+#include "dsp_kernels.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define OVERSAMPLER_MAX_FACTOR 8
+#define OVERSAMPLER_MAX_STAGES 3        // log2(OVERSAMPLER_MAX_FACTOR)
+#define OVERSAMPLER_CHUNK_FRAMES 256    // Engine frames per pass
+#define OVERSAMPLER_KAISER_BETA 8.0f    // ~80 dB stopband
+
+typedef struct {
+    uint32_t branch_taps;       // Taps of the filtering branch (even)
+    float* up_taps;             // branch_taps, reversed for the fir kernel, unity DC gain
+    float* down_taps;           // The same shape at half the gain
+    float* up_history[2];       // Per channel: branch_taps - 1 frames, then the stage input
+    float* even_history[2];     // Down: even input phase, branch_taps - 1 frames ahead
+    float* odd_history[2];      // Down: odd input phase, branch_taps / 2 frames ahead
+    float* output[2];           // Up: the stage output at twice its input rate
+} OversamplerStage;
+
+typedef struct {
+    uint32_t factor;
+    uint32_t stage_count;
+    OversamplerStage stages[OVERSAMPLER_MAX_STAGES];
+    float* scratch;             // Even outputs of an up stage before interleaving
+    uint32_t pad_frames;        // Top-rate delay that makes the latency whole
+    float pad[2][OVERSAMPLER_MAX_FACTOR];
+    uint32_t latency;           // Engine frames
+    void* memory;               // Every buffer above, one allocation
+} Oversampler;
+
+static inline bool oversampler_factor_valid(uint32_t factor) {
+    return factor == 2 || factor == 4 || factor == 8;
+}
+
+// NULL on a bad factor or allocation failure
+Oversampler* oversampler_create(uint32_t factor);
+void oversampler_destroy(Oversampler* oversampler);
+
+// Engine frames a block is delayed by going up and back down
+static inline uint32_t oversampler_latency(const Oversampler* oversampler) {
+    return oversampler->latency;
+}
+
+// Convert up to OVERSAMPLER_CHUNK_FRAMES engine frames to the top rate.
+// The factor * frame_count result frames sit in top[0] (left) and top[1]
+// (right) until the matching oversampler_down call.
+void oversampler_up(Oversampler* oversampler, const DspKernels* dsp, const float* left, const float* right,
+                    uint32_t frame_count, float* top[2]);
+
+// Convert what oversampler_up left in `top` (processed in place) back down
+// into frame_count engine frames
+void oversampler_down(Oversampler* oversampler, const DspKernels* dsp, float* left, float* right,
+                      uint32_t frame_count);
+
+#endif // OVERSAMPLER_H
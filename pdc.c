@@ -0,0 +1,72 @@
+#include "pdc.h"
+#include "dsp_kernels.h"
+#include <string.h>
+
+#define PDC_LINE_MASK (PDC_LINE_FRAMES - 1)
+#define PDC_ALIGNMENT 64
+
+_Static_assert((PDC_LINE_FRAMES & PDC_LINE_MASK) == 0, "PDC_LINE_FRAMES must be a power of two");
+
+// ============================================================================
+// CONTROL THREAD
+// ============================================================================
+
+bool pdc_delay_reserve(PdcDelay* line) {
+    if (pdc_delay_ready(line)) {
+        return true;
+    }
+    float* left = (float*)dsp_aligned_alloc(sizeof(float) * PDC_LINE_FRAMES, PDC_ALIGNMENT);
+    float* right = (float*)dsp_aligned_alloc(sizeof(float) * PDC_LINE_FRAMES, PDC_ALIGNMENT);
+    if (!left || !right) {
+        dsp_aligned_free(left);
+        dsp_aligned_free(right);
+        return false;
+    }
+    memset(left, 0, sizeof(float) * PDC_LINE_FRAMES);
+    memset(right, 0, sizeof(float) * PDC_LINE_FRAMES);
+    line->write_pos = 0;
+    line->quiet_frames = PDC_LINE_FRAMES;
+    line->right = right;
+    line->left = left;
+    return true;
+}
+
+void pdc_delay_free(PdcDelay* line) {
+    dsp_aligned_free(line->left);
+    dsp_aligned_free(line->right);
+    memset(line, 0, sizeof(PdcDelay));
+}
+
+// ============================================================================
+// AUDIO THREAD
+// ============================================================================
+
+void pdc_delay_push(PdcDelay* line, const float* left, const float* right, uint32_t frame_count) {
+    uint32_t pos = line->write_pos;
+    uint32_t first = PDC_LINE_FRAMES - pos < frame_count ? PDC_LINE_FRAMES - pos : frame_count;
+    if (left) {
+        line->quiet_frames = 0;
+        memcpy(line->left + pos, left, sizeof(float) * first);
+        memcpy(line->right + pos, right, sizeof(float) * first);
+        memcpy(line->left, left + first, sizeof(float) * (frame_count - first));
+        memcpy(line->right, right + first, sizeof(float) * (frame_count - first));
+    } else {
+        if (line->quiet_frames < PDC_LINE_FRAMES) line->quiet_frames += frame_count;
+        memset(line->left + pos, 0, sizeof(float) * first);
+        memset(line->right + pos, 0, sizeof(float) * first);
+        memset(line->left, 0, sizeof(float) * (frame_count - first));
+        memset(line->right, 0, sizeof(float) * (frame_count - first));
+    }
+    line->write_pos = (pos + frame_count) & PDC_LINE_MASK;
+}
+
+int pdc_delay_read(const PdcDelay* line, uint32_t delay, uint32_t frame_count, PdcSpan spans[2]) {
+    uint32_t start = (line->write_pos - frame_count - delay) & PDC_LINE_MASK;
+    uint32_t first = PDC_LINE_FRAMES - start < frame_count ? PDC_LINE_FRAMES - start : frame_count;
+    spans[0] = (PdcSpan){line->left + start, line->right + start, 0, first};
+    if (first == frame_count) {
+        return 1;
+    }
+    spans[1] = (PdcSpan){line->left, line->right, first, frame_count - first};
+    return 2;
+}
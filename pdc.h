@@ -0,0 +1,70 @@
+// pdc.h - Latency compensation delay lines
+// Effects that look ahead or work in blocks report a latency (see
+// EffectVTable::latency). When the render graph is built, every path into a
+// bus or master gets the delay that lines it up with the latest path into
+// the same destination; those delays run on PdcDelay lines, one per edge
+// (a track's output, each of its sends, a bus output).
+//
+// A line is allocated on the control thread the first time its edge needs
+// compensation and is kept until shutdown, so the audio thread only ever
+// copies into memory that already exists. Reads are handed out as at most
+// two contiguous spans of the ring, so the caller mixes or interleaves
+// straight from the line without a scratch buffer.
+#pragma once
+#ifndef PDC_H
+#define PDC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PDC_LINE_FRAMES 16384           // Ring length, must be a power of two
+#define PDC_MAX_BLOCK_FRAMES 4096       // Longest block pushed at once
+#define PDC_MAX_DELAY_FRAMES (PDC_LINE_FRAMES - PDC_MAX_BLOCK_FRAMES)
+
+typedef struct {
+    float* left;                // PDC_LINE_FRAMES each, NULL until reserved
+    float* right;
+    uint32_t write_pos;         // Audio thread only
+    uint32_t quiet_frames;      // Silence pushed since the last block of audio (audio thread only)
+} PdcDelay;
+
+typedef struct {
+    const float* left;
+    const float* right;
+    uint32_t offset;            // First frame of the block this span covers
+    uint32_t frames;
+} PdcSpan;
+
+// ============================================================================
+// CONTROL THREAD
+// ============================================================================
+
+// Allocate the line (silent) if it has not been yet. Returns false on
+// allocation failure.
+bool pdc_delay_reserve(PdcDelay* line);
+
+// Free the line (nothing may be rendering through it)
+void pdc_delay_free(PdcDelay* line);
+
+// ============================================================================
+// AUDIO THREAD
+// ============================================================================
+
+static inline bool pdc_delay_ready(const PdcDelay* line) {
+    return line->left != NULL;
+}
+
+// Append a planar block (NULL: silence) of at most PDC_MAX_BLOCK_FRAMES
+void pdc_delay_push(PdcDelay* line, const float* left, const float* right, uint32_t frame_count);
+
+// The block just pushed, delayed by `delay` frames (at most
+// PDC_MAX_DELAY_FRAMES): fills one or two spans and returns their count
+int pdc_delay_read(const PdcDelay* line, uint32_t delay, uint32_t frame_count, PdcSpan spans[2]);
+
+// Whether that delayed block is all pushed silence
+static inline bool pdc_delay_quiet(const PdcDelay* line, uint32_t delay, uint32_t frame_count) {
+    return line->quiet_frames >= delay + frame_count;
+}
+
+#endif // PDC_H
@@ -0,0 +1,254 @@
+#include "render_graph.h"
+#include "audio_engine.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// CONTROL THREAD
+// ============================================================================
+
+static uint32_t chain_latency(const EffectChain* chain) {
+    uint32_t latency = 0;
+    for (int i = 0; i < chain->count; i++) {
+        latency += effect_latency(&chain->effects[chain->order[i]]);
+    }
+    return latency;
+}
+
+// Tails in series add up: each effect rings on what the previous one left
+static uint32_t chain_tail(const EffectChain* chain) {
+    uint32_t tail = 0;
+    for (int i = 0; i < chain->count; i++) {
+        tail += effect_tail(&chain->effects[chain->order[i]]);
+    }
+    return tail;
+}
+
+// Order buses so every bus comes after all buses routed into it (Kahn's
+// algorithm). Routing edits reject cycles, but a bus caught in one anyway is
+// scheduled last and sent straight to master rather than dropped.
+static void schedule_buses(AudioEngine* engine, RenderGraph* graph) {
+    int pending_inputs[MAX_BUSES] = {0};
+    int ready[MAX_BUSES];
+    int ready_count = 0;
+    bool scheduled[MAX_BUSES] = {false};
+
+    for (int b = 0; b < engine->bus_count; b++) {
+        int output = engine->buses[b].output_bus;
+        if (output >= 0 && output < engine->bus_count) {
+            pending_inputs[output]++;
+        }
+    }
+    for (int b = 0; b < engine->bus_count; b++) {
+        if (pending_inputs[b] == 0) {
+            ready[ready_count++] = b;
+        }
+    }
+
+    graph->bus_count = 0;
+    for (int r = 0; r < ready_count; r++) {
+        int b = ready[r];
+        Bus* bus = &engine->buses[b];
+        RenderBus* rb = &graph->buses[graph->bus_count++];
+        scheduled[b] = true;
+
+        rb->bus_index = b;
+        rb->output_bus = (bus->output_bus >= 0 && bus->output_bus < engine->bus_count) ? bus->output_bus : BUS_MASTER;
+        rb->effect_count = bus->chain.count;
+        memcpy(rb->effect_slots, bus->chain.order, sizeof(int) * (size_t)bus->chain.count);
+        rb->tail_frames = chain_tail(&bus->chain);
+
+        if (rb->output_bus != BUS_MASTER && --pending_inputs[rb->output_bus] == 0) {
+            ready[ready_count++] = rb->output_bus;
+        }
+    }
+
+    for (int b = 0; b < engine->bus_count; b++) {
+        if (scheduled[b]) continue;
+        Bus* bus = &engine->buses[b];
+        RenderBus* rb = &graph->buses[graph->bus_count++];
+        rb->bus_index = b;
+        rb->output_bus = BUS_MASTER;
+        rb->effect_count = bus->chain.count;
+        memcpy(rb->effect_slots, bus->chain.order, sizeof(int) * (size_t)bus->chain.count);
+        rb->tail_frames = chain_tail(&bus->chain);
+    }
+}
+
+static uint32_t* arrival_at(uint32_t* arrivals, int bus_index) {
+    return &arrivals[bus_index == BUS_MASTER ? MAX_BUSES : bus_index];
+}
+
+static void arrive(uint32_t* arrivals, int bus_index, uint32_t latency) {
+    uint32_t* arrival = arrival_at(arrivals, bus_index);
+    if (latency > *arrival) *arrival = latency;
+}
+
+// Delay an edge leaving at `latency` so it meets the latest path into its
+// destination, and make sure its line exists
+static bool compensate_edge(uint32_t* arrivals, int destination, uint32_t latency, PdcDelay* line,
+                            uint32_t* delay) {
+    *delay = *arrival_at(arrivals, destination) - latency;
+    if (*delay > PDC_MAX_DELAY_FRAMES) {
+        *delay = PDC_MAX_DELAY_FRAMES;
+    }
+    return *delay == 0 || pdc_delay_reserve(line);
+}
+
+// Latency compensation. Every path's latency is the sum of the effect
+// chains along it. Tracks arrive at their destinations first; buses then
+// follow in schedule order, so each bus knows the latest of its inputs
+// before adding its own chain. Every edge is then delayed up to the latest
+// arrival at its destination, which lines everything up at master.
+static bool compensate_latency(AudioEngine* engine, RenderGraph* graph) {
+    uint32_t arrivals[MAX_BUSES + 1] = {0};    // Latest path into each bus slot, master last
+
+    for (int t = 0; t < graph->track_count; t++) {
+        RenderTrack* rt = &graph->tracks[t];
+        rt->latency = chain_latency(&rt->chunk->tracks[rt->lane].chain);
+        arrive(arrivals, rt->output_bus, rt->latency);
+        for (int s = 0; s < rt->send_count; s++) {
+            arrive(arrivals, rt->send_buses[s], rt->latency);
+        }
+    }
+    for (int b = 0; b < graph->bus_count; b++) {
+        RenderBus* rb = &graph->buses[b];
+        rb->latency = *arrival_at(arrivals, rb->bus_index) + chain_latency(&engine->buses[rb->bus_index].chain);
+        arrive(arrivals, rb->output_bus, rb->latency);
+    }
+
+    bool ok = true;
+    for (int t = 0; t < graph->track_count; t++) {
+        RenderTrack* rt = &graph->tracks[t];
+        Track* track = &rt->chunk->tracks[rt->lane];
+        ok &= compensate_edge(arrivals, rt->output_bus, rt->latency, &track->output_delay, &rt->output_delay);
+        for (int s = 0; s < rt->send_count; s++) {
+            int bus_index = rt->send_buses[s];
+            ok &= compensate_edge(arrivals, bus_index, rt->latency, &track->send_delays[bus_index],
+                                  &rt->send_delays[s]);
+        }
+    }
+    for (int b = 0; b < graph->bus_count; b++) {
+        RenderBus* rb = &graph->buses[b];
+        ok &= compensate_edge(arrivals, rb->output_bus, rb->latency, &engine->buses[rb->bus_index].output_delay,
+                              &rb->output_delay);
+    }
+    graph->latency = *arrival_at(arrivals, BUS_MASTER);
+    return ok;
+}
+
+RenderGraph* render_graph_build(AudioEngine* engine) {
+    RenderGraph* graph =
+        (RenderGraph*)calloc(1, sizeof(RenderGraph) + sizeof(RenderTrack) * (size_t)engine->track_count);
+    if (!graph) {
+        return NULL;
+    }
+
+    graph->generation = ++engine->graph_generation;
+    graph->track_count = engine->track_count;
+
+    for (int t = 0; t < engine->track_count; t++) {
+        TrackChunk* chunk = track_store_chunk(&engine->tracks, t);
+        const Track* dsp = &chunk->tracks[track_lane(t)];
+        const TrackInfo* track = &chunk->info[track_lane(t)];
+        RenderTrack* rt = &graph->tracks[t];
+
+        rt->track_index = t;
+        rt->chunk = chunk;
+        rt->lane = track_lane(t);
+        rt->clip = track->clip;
+        rt->recording = track->recording;
+        rt->frozen = track->frozen;
+        rt->effect_count = dsp->chain.count;
+        memcpy(rt->effect_slots, dsp->chain.order, sizeof(int) * (size_t)dsp->chain.count);
+        rt->tail_frames = chain_tail(&dsp->chain);
+
+        rt->output_bus = (track->output_bus >= 0 && track->output_bus < engine->bus_count) ? track->output_bus : BUS_MASTER;
+        rt->send_count = 0;
+        for (int b = 0; b < engine->bus_count; b++) {
+            if (track->send_enabled[b]) {
+                rt->send_buses[rt->send_count++] = b;
+            }
+        }
+
+        // Lanes of live effects only: a removed effect's lanes are retired
+        rt->volume_lane = track->volume_lane;
+        rt->pan_lane = track->pan_lane;
+        rt->effect_lane_count = 0;
+        for (int slot = 0; slot < MAX_EFFECTS_PER_TRACK; slot++) {
+            if (!dsp->chain.slot_used[slot]) continue;
+            for (int p = 0; p < ENGINE_MAX_AUTOMATED_PARAMS; p++) {
+                if (track->effect_lanes[slot][p]) {
+                    rt->effect_lanes[rt->effect_lane_count++] = (RenderEffectLane){
+                        .effect_slot = slot,
+                        .param_index = p,
+                        .lane = track->effect_lanes[slot][p],
+                    };
+                }
+            }
+        }
+        rt->automated = rt->volume_lane || rt->pan_lane || rt->effect_lane_count > 0;
+    }
+
+    schedule_buses(engine, graph);
+    if (!compensate_latency(engine, graph)) {
+        free(graph);
+        return NULL;
+    }
+
+    return graph;
+}
+
+void render_graph_publish(AudioEngine* engine, RenderGraph* graph) {
+    // If the audio thread never picked up the previous pending snapshot it was
+    // never referenced, so it can be freed immediately.
+    RenderGraph* skipped = atomic_exchange(&engine->pending_graph, graph);
+    free(skipped);
+
+    render_graph_collect(engine);
+}
+
+void render_graph_collect(AudioEngine* engine) {
+    RenderGraph* retired = NULL;
+    while (spsc_ring_pop(&engine->retired_graphs, &retired)) {
+        if (retired->generation > engine->reclaimed_generation) {
+            engine->reclaimed_generation = retired->generation;
+        }
+        free(retired);
+    }
+}
+
+void render_graph_destroy_all(AudioEngine* engine) {
+    render_graph_collect(engine);
+    free(atomic_exchange(&engine->pending_graph, NULL));
+    free(engine->current_graph);
+    engine->current_graph = NULL;
+}
+
+// ============================================================================
+// AUDIO THREAD
+// ============================================================================
+
+RenderGraph* render_graph_acquire(AudioEngine* engine) {
+    // Only swap when the old snapshot can be handed back; the control thread
+    // drains the retire queue every frame, so this practically never waits.
+    if (spsc_ring_count(&engine->retired_graphs) >= ENGINE_RETIRE_QUEUE_SIZE) {
+        return NULL;
+    }
+
+    RenderGraph* next = atomic_exchange(&engine->pending_graph, NULL);
+    if (!next) {
+        return NULL;
+    }
+
+    RenderGraph* previous = engine->current_graph;
+    engine->current_graph = next;
+    return previous;
+}
+
+void render_graph_retire(AudioEngine* engine, RenderGraph* graph) {
+    if (graph) {
+        spsc_ring_push(&engine->retired_graphs, &graph);
+    }
+}
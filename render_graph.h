@@ -0,0 +1,107 @@
+// render_graph.h - Immutable render graph snapshots (RCU-style)
+// The control thread builds a RenderGraph describing what to render (which
+// track slots, in what order, with which effect slots, routed to which
+// buses) and publishes it with
+// a single atomic pointer swap. The audio thread adopts the newest snapshot
+// at the top of its callback and hands the previous one back for reclamation
+// on the control thread. Published graphs are never modified.
+//
+// Buses are topologically sorted when the graph is built, so the audio
+// thread executes a flat schedule every block: render tracks, then process
+// buses in schedule order (each bus only after every bus feeding it), then
+// master.
+#pragma once
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include "audio_engine.h"
+#include <stdint.h>
+
+// ============================================================================
+// RENDER GRAPH STRUCTURE
+// ============================================================================
+
+// Automation lane driving one effect parameter
+typedef struct {
+    int effect_slot;
+    int param_index;
+    const AutomationLane* lane;
+} RenderEffectLane;
+
+typedef struct {
+    int track_index;                            // Slot in AudioEngine::tracks
+    TrackChunk* chunk;                          // Storage chunk holding the slot
+    int lane;                                   // The slot's position in it
+    ClipStream* clip;                           // Streamed source, NULL for the oscillator
+    ClipRecording* recording;                   // Take capturing the input, NULL if not recording
+    ClipStream* frozen;                         // Plays instead of source, fader and chain when set
+    int effect_count;
+    int effect_slots[MAX_EFFECTS_PER_TRACK];    // Chain order, slots in Track::chain
+    int output_bus;                             // BUS_MASTER or bus slot
+    int send_count;
+    int send_buses[MAX_BUSES];                  // Bus slots receiving a post-fader send
+
+    // Latency compensation: frames each edge is delayed by so it meets the
+    // latest path into its destination (0: straight through)
+    uint32_t latency;                           // Effect chain latency
+    uint32_t tail_frames;                       // Effect chain tail (idle bypass)
+    uint32_t output_delay;
+    uint32_t send_delays[MAX_BUSES];            // Parallel to send_buses
+
+    // Automation; `automated` is the single per-block test when none is set
+    bool automated;
+    const AutomationLane* volume_lane;
+    const AutomationLane* pan_lane;
+    int effect_lane_count;
+    RenderEffectLane effect_lanes[MAX_EFFECTS_PER_TRACK * ENGINE_MAX_AUTOMATED_PARAMS];
+} RenderTrack;
+
+typedef struct {
+    int bus_index;                              // Slot in AudioEngine::buses
+    int effect_count;
+    int effect_slots[MAX_EFFECTS_PER_TRACK];    // Chain order, slots in Bus::chain
+    int output_bus;                             // BUS_MASTER or bus slot
+    uint32_t latency;                           // Inputs' arrival plus the chain's own latency
+    uint32_t tail_frames;                       // Effect chain tail (idle bypass)
+    uint32_t output_delay;                      // Compensation into output_bus
+} RenderBus;
+
+struct RenderGraph {
+    uint64_t generation;
+    uint32_t latency;                           // Compensated latency at master, in frames
+    int bus_count;
+    RenderBus buses[MAX_BUSES];                 // Schedule order (sources before sinks)
+    int track_count;
+    RenderTrack tracks[];                       // track_count, allocated with the graph
+};
+
+// ============================================================================
+// CONTROL THREAD API
+// ============================================================================
+
+// Build a snapshot of the engine's current track/bus/effect model
+// Returns NULL on allocation failure
+RenderGraph* render_graph_build(AudioEngine* engine);
+
+// Publish a snapshot to the audio thread (takes ownership of graph)
+void render_graph_publish(AudioEngine* engine, RenderGraph* graph);
+
+// Free snapshots the audio thread has finished with
+void render_graph_collect(AudioEngine* engine);
+
+// Free every snapshot (engine must be stopped)
+void render_graph_destroy_all(AudioEngine* engine);
+
+// ============================================================================
+// AUDIO THREAD API
+// ============================================================================
+
+// Swap in the newest published snapshot, if any. Returns the snapshot that
+// was replaced (or NULL); pass it to render_graph_retire() once the audio
+// thread is done with everything that might reference it.
+RenderGraph* render_graph_acquire(AudioEngine* engine);
+
+// Hand a replaced snapshot back to the control thread for reclamation
+void render_graph_retire(AudioEngine* engine, RenderGraph* graph);
+
+#endif // RENDER_GRAPH_H
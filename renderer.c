@@ -1,5 +1,8 @@
+#include "renderer.h"
 #include "raylib.h"
+#include "renderer_batch.h"
 #include "renderer_utils.h"
+#include "engine_trace.h"
 #include "ui_clay.h"
 #include "vendor/clay/clay.h"
 #include <math.h>
@@ -10,45 +13,43 @@
 Camera Raylib_camera;
 
 bool ui_init(UIState *ui_state, int window_width, int window_height) {
-  memset(ui_state, 0, sizeof(UIState));
+  TraceLog(LOG_INFO, "[raylib][UI] Initializing UI system...");
+  if (!ui_state_init(ui_state, window_width, window_height,
+                     (Clay_ErrorHandler){HandleClayErrors, NULL})) {
+    return false;
+  }
+  UIRenderer *renderer = calloc(1, sizeof(UIRenderer));
+  if (!renderer) {
+    TraceLog(LOG_ERROR, "[raylib][UI] Failed to allocate renderer state");
+    return false;
+  }
+  ui_state->renderer = renderer;
+
+  renderer->font_count = UI_FONT_COUNT;
+  renderer->font = malloc(sizeof(Font) * renderer->font_count);
+  for (uint32_t i = 0; i < renderer->font_count; i++) {
+    renderer->font[i] = LoadFont(ui_font_paths[i]);
+    if (renderer->font[i].texture.id == 0) {
+      TraceLog(LOG_WARNING, "[raylib][UI] Failed to load font %s, using default",
+               ui_font_paths[i]);
+      renderer->font[i] = GetFontDefault();
+    } else {
+      TraceLog(LOG_INFO, "[raylib][UI] Loaded font: %s", ui_font_paths[i]);
+      SetTextureFilter(renderer->font[i].texture, TEXTURE_FILTER_BILINEAR);
+    }
+  }
 
-  ui_state->clay_memory = malloc(CLAY_MEMORY_SIZE);
-  ui_state->window_width = window_width;
-  ui_state->window_height = window_height;
-  ui_state->track_play_toggle = -1;
-  ui_state->track_mute_toggle = -1;
-  ui_state->track_solo_toggle = -1;
-  ui_state->track_add_effect = -1;
+  // Batched shape renderer (falls back to immediate draws without shaders)
+  shape_batch_init(&renderer->shape_batch);
+  waveform_renderer_init(&renderer->waveform_renderer);
 
-  TraceLog(LOG_INFO, "[raylib][UI] Initializing UI system...");
+  if (!text_measurer_init(&renderer->text_measurer, renderer->font,
+                          renderer->font_count)) {
+    TraceLog(LOG_ERROR, "[raylib][UI] Failed to allocate text measurement");
+    return false;
+  }
+  Clay_SetMeasureTextFunction(clay_measure_text, &renderer->text_measurer);
 
-  // TODO: separate font loading and make it proper array
-  const char *font_path = "C:/Users/5q/AppData/Local/Microsoft/Windows/Fonts/"
-                          "MesloLGLDZNerdFont-Regular.ttf";
-  ui_state->font_count = 1;
-  ui_state->font = malloc(sizeof(Font) * ui_state->font_count);
-  ui_state->font[0] = LoadFont(font_path);
-  if (ui_state->font[0].texture.id == 0) {
-    TraceLog(LOG_WARNING, "[raylib][UI] Failed to load font, using default");
-    ui_state->font[0] = GetFontDefault();
-  } else {
-    TraceLog(LOG_INFO, "[raylib][UI] Loaded font: %s", font_path);
-    SetTextureFilter(ui_state->font[0].texture, TEXTURE_FILTER_BILINEAR);
-  }
-
-  // Initialize Clay
-  ui_state->clay_arena = Clay_CreateArenaWithCapacityAndMemory(
-      CLAY_MEMORY_SIZE, ui_state->clay_memory);
-
-  Clay_Initialize(ui_state->clay_arena,
-                  (Clay_Dimensions){(float)window_width, (float)window_height},
-                  (Clay_ErrorHandler){HandleClayErrors, NULL});
-  Clay_SetMeasureTextFunction(
-      clay_measure_text,
-      ui_state->font); // maybe add userdata with context/state here too
-
-  TraceLog(LOG_INFO, "[raylib][UI] Clay initialized with %d bytes",
-           CLAY_MEMORY_SIZE);
   TraceLog(LOG_INFO, "[raylib][UI] UI system initialized successfully");
 
   return true;
@@ -57,9 +58,27 @@ bool ui_init(UIState *ui_state, int window_width, int window_height) {
 void ui_shutdown(UIState *ui_state) {
   TraceLog(LOG_INFO, "[raylib][UI] Shutting down UI system");
 
-  for (uint32_t i = 0; i > ui_state->font_count; ++i) {
-    UnloadFont(ui_state->font[i]);
+  UIRenderer *renderer = ui_state->renderer;
+  ui_state_shutdown(ui_state);
+  if (!renderer) {
+    return;
   }
+  if (renderer->static_layer.id != 0) {
+    UnloadRenderTexture(renderer->static_layer);
+  }
+  shape_batch_shutdown(&renderer->shape_batch);
+  waveform_renderer_shutdown(&renderer->waveform_renderer);
+  for (int i = 0; i < MAX_TRACKS; i++) {
+    waveform_texture_destroy(&renderer->waveforms[i]);
+  }
+  text_measurer_shutdown(&renderer->text_measurer);
+
+  for (uint32_t i = 0; i > renderer->font_count; ++i) {
+    UnloadFont(renderer->font[i]);
+  }
+  free(renderer->font);
+  free(renderer);
+  ui_state->renderer = NULL;
 }
 
 // ============================================================================
@@ -67,219 +86,451 @@ void ui_shutdown(UIState *ui_state) {
 // ============================================================================
 
 void ui_update(UIState *ui_state) {
-  // Update mouse state
-  ui_state->mouse_pos = GetMousePosition();
-  ui_state->mouse_pressed = IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
-  ui_state->mouse_down = IsMouseButtonDown(MOUSE_LEFT_BUTTON);
-  ui_state->mouse_released = IsMouseButtonReleased(MOUSE_LEFT_BUTTON);
-
-  // Reset per-frame action flags
-  ui_state->add_track_requested = false;
-  ui_state->track_play_toggle = -1;
-  ui_state->track_mute_toggle = -1;
-  ui_state->track_solo_toggle = -1;
-  ui_state->master_play_toggle = false;
-  ui_state->track_add_effect = -1;
-
-  if (IsWindowResized()) {
-    ui_state->window_width = GetScreenWidth();
-    ui_state->window_height = GetScreenHeight();
-  }
-
-  Clay_SetLayoutDimensions((Clay_Dimensions){(float)ui_state->window_width,
-                                             (float)ui_state->window_height});
-  // Update Clay pointer state
-  Clay_SetPointerState(
-      (Clay_Vector2){ui_state->mouse_pos.x, ui_state->mouse_pos.y},
-      ui_state->mouse_down);
-
-  // Update Clay layout
-  Clay_UpdateScrollContainers(false,                // isPointerActive
-                              (Clay_Vector2){0, 0}, // scrollDelta
-                              GetFrameTime());
+  Vector2 mouse_pos = GetMousePosition();
+  Vector2 wheel = GetMouseWheelMoveV();
+  UIInput input = {
+      .mouse_pos = {mouse_pos.x, mouse_pos.y},
+      .mouse_pressed = IsMouseButtonPressed(MOUSE_LEFT_BUTTON),
+      .mouse_down = IsMouseButtonDown(MOUSE_LEFT_BUTTON),
+      .mouse_released = IsMouseButtonReleased(MOUSE_LEFT_BUTTON),
+      .wheel = {wheel.x, wheel.y},
+      .key_pressed = GetKeyPressed() != 0,
+      .resized = IsWindowResized(),
+      .window_width = GetScreenWidth(),
+      .window_height = GetScreenHeight(),
+      .frame_seconds = GetFrameTime(),
+  };
+  ui_apply_input(ui_state, &input);
 }
 
-void ui_render(UIState *ui_state, Clay_RenderCommandArray renderCommands) {
-  for (int j = 0; j < renderCommands.length; j++) {
-    Clay_RenderCommand *renderCommand =
-        Clay_RenderCommandArray_Get(&renderCommands, j);
-    Clay_BoundingBox boundingBox = {roundf(renderCommand->boundingBox.x),
-                                    roundf(renderCommand->boundingBox.y),
-                                    roundf(renderCommand->boundingBox.width),
-                                    roundf(renderCommand->boundingBox.height)};
-    switch (renderCommand->commandType) {
-    case CLAY_RENDER_COMMAND_TYPE_TEXT: {
-      Clay_TextRenderData *textData = &renderCommand->renderData.text;
-      Font fontToUse = ui_state->font[textData->fontId];
-
-      DrawTextEx(fontToUse, textData->stringContents.baseChars,
-                 (Vector2){boundingBox.x, boundingBox.y},
-                 (float)textData->fontSize, (float)textData->letterSpacing,
-                 CLAY_COLOR_TO_RAYLIB_COLOR(textData->textColor));
-      break;
+// ============================================================================
+// UI RENDER
+// ============================================================================
+
+static Clay_BoundingBox rounded_box(const Clay_RenderCommand *renderCommand) {
+  return (Clay_BoundingBox){roundf(renderCommand->boundingBox.x),
+                            roundf(renderCommand->boundingBox.y),
+                            roundf(renderCommand->boundingBox.width),
+                            roundf(renderCommand->boundingBox.height)};
+}
+
+// Draw one command directly (one or more raylib draw calls)
+static void render_command_immediate(UIState *ui_state,
+                                     Clay_RenderCommandArray *renderCommands,
+                                     Clay_RenderCommand *renderCommand) {
+  Clay_BoundingBox boundingBox = rounded_box(renderCommand);
+  switch (renderCommand->commandType) {
+  case CLAY_RENDER_COMMAND_TYPE_TEXT: {
+    Clay_TextRenderData *textData = &renderCommand->renderData.text;
+    Font fontToUse = ui_state->renderer->font[textData->fontId];
+
+    DrawTextEx(fontToUse, textData->stringContents.baseChars,
+               (Vector2){boundingBox.x, boundingBox.y},
+               (float)textData->fontSize, (float)textData->letterSpacing,
+               CLAY_COLOR_TO_RAYLIB_COLOR(textData->textColor));
+    break;
+  }
+  case CLAY_RENDER_COMMAND_TYPE_IMAGE: {
+    Texture2D imageTexture =
+        *(Texture2D *)renderCommand->renderData.image.imageData;
+    Clay_Color tintColor = renderCommand->renderData.image.backgroundColor;
+    if (tintColor.r == 0 && tintColor.g == 0 && tintColor.b == 0 &&
+        tintColor.a == 0) {
+      tintColor = (Clay_Color){255, 255, 255, 255};
     }
-    case CLAY_RENDER_COMMAND_TYPE_IMAGE: {
-      Texture2D imageTexture =
-          *(Texture2D *)renderCommand->renderData.image.imageData;
-      Clay_Color tintColor = renderCommand->renderData.image.backgroundColor;
-      if (tintColor.r == 0 && tintColor.g == 0 && tintColor.b == 0 &&
-          tintColor.a == 0) {
-        tintColor = (Clay_Color){255, 255, 255, 255};
-      }
-      DrawTexturePro(imageTexture,
-                     (Rectangle){0.F, 0.F, (float)imageTexture.width,
-                                 (float)imageTexture.height},
-                     (Rectangle){boundingBox.x, boundingBox.y,
-                                 boundingBox.width, boundingBox.height},
-                     (Vector2){}, 0, CLAY_COLOR_TO_RAYLIB_COLOR(tintColor));
-      break;
+    DrawTexturePro(imageTexture,
+                   (Rectangle){0.F, 0.F, (float)imageTexture.width,
+                               (float)imageTexture.height},
+                   (Rectangle){boundingBox.x, boundingBox.y,
+                               boundingBox.width, boundingBox.height},
+                   (Vector2){}, 0, CLAY_COLOR_TO_RAYLIB_COLOR(tintColor));
+    break;
+  }
+  case CLAY_RENDER_COMMAND_TYPE_SCISSOR_START: {
+    BeginScissorMode((int)roundf(boundingBox.x), (int)roundf(boundingBox.y),
+                     (int)roundf(boundingBox.width),
+                     (int)roundf(boundingBox.height));
+    break;
+  }
+  case CLAY_RENDER_COMMAND_TYPE_SCISSOR_END: {
+    EndScissorMode();
+    break;
+  }
+  case CLAY_RENDER_COMMAND_TYPE_RECTANGLE: {
+    Clay_RectangleRenderData *config = &renderCommand->renderData.rectangle;
+    if (config->cornerRadius.topLeft > 0) {
+      float radius =
+          (config->cornerRadius.topLeft * 2) /
+          ((boundingBox.width > boundingBox.height) ? boundingBox.height
+                                                    : boundingBox.width);
+      DrawRectangleRounded(
+          (Rectangle){boundingBox.x, boundingBox.y, boundingBox.width,
+                      boundingBox.height},
+          radius, 8, CLAY_COLOR_TO_RAYLIB_COLOR(config->backgroundColor));
+    } else {
+      DrawRectangle((int)boundingBox.x, (int)boundingBox.y,
+                    (int)boundingBox.width, (int)boundingBox.height,
+                    CLAY_COLOR_TO_RAYLIB_COLOR(config->backgroundColor));
     }
-    case CLAY_RENDER_COMMAND_TYPE_SCISSOR_START: {
-      BeginScissorMode((int)roundf(boundingBox.x), (int)roundf(boundingBox.y),
-                       (int)roundf(boundingBox.width),
-                       (int)roundf(boundingBox.height));
-      break;
+    break;
+  }
+  case CLAY_RENDER_COMMAND_TYPE_BORDER: {
+    Clay_BorderRenderData *config = &renderCommand->renderData.border;
+    // Left border
+    if (config->width.left > 0) {
+      DrawRectangle((int)roundf(boundingBox.x),
+                    (int)roundf(boundingBox.y + config->cornerRadius.topLeft),
+                    (int)config->width.left,
+                    (int)roundf(boundingBox.height -
+                                config->cornerRadius.topLeft -
+                                config->cornerRadius.bottomLeft),
+                    CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
     }
-    case CLAY_RENDER_COMMAND_TYPE_SCISSOR_END: {
-      EndScissorMode();
-      break;
+    // Right border
+    if (config->width.right > 0) {
+      DrawRectangle(
+          (int)roundf(boundingBox.x + boundingBox.width -
+                      (float)config->width.right),
+          (int)roundf(boundingBox.y + config->cornerRadius.topRight),
+          (int)config->width.right,
+          (int)roundf(boundingBox.height - config->cornerRadius.topRight -
+                      config->cornerRadius.bottomRight),
+          CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
     }
-    case CLAY_RENDER_COMMAND_TYPE_RECTANGLE: {
-      Clay_RectangleRenderData *config = &renderCommand->renderData.rectangle;
-      if (config->cornerRadius.topLeft > 0) {
-        float radius =
-            (config->cornerRadius.topLeft * 2) /
-            ((boundingBox.width > boundingBox.height) ? boundingBox.height
-                                                      : boundingBox.width);
-        DrawRectangleRounded(
-            (Rectangle){boundingBox.x, boundingBox.y, boundingBox.width,
-                        boundingBox.height},
-            radius, 8, CLAY_COLOR_TO_RAYLIB_COLOR(config->backgroundColor));
-      } else {
-        DrawRectangle((int)boundingBox.x, (int)boundingBox.y,
-                      (int)boundingBox.width, (int)boundingBox.height,
-                      CLAY_COLOR_TO_RAYLIB_COLOR(config->backgroundColor));
-      }
-      break;
+    // Top border
+    if (config->width.top > 0) {
+      DrawRectangle(
+          (int)roundf(boundingBox.x + config->cornerRadius.topLeft),
+          (int)roundf(boundingBox.y),
+          (int)roundf(boundingBox.width - config->cornerRadius.topLeft -
+                      config->cornerRadius.topRight),
+          (int)config->width.top, CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
     }
-    case CLAY_RENDER_COMMAND_TYPE_BORDER: {
-      Clay_BorderRenderData *config = &renderCommand->renderData.border;
-      // Left border
-      if (config->width.left > 0) {
-        DrawRectangle((int)roundf(boundingBox.x),
-                      (int)roundf(boundingBox.y + config->cornerRadius.topLeft),
-                      (int)config->width.left,
-                      (int)roundf(boundingBox.height -
-                                  config->cornerRadius.topLeft -
-                                  config->cornerRadius.bottomLeft),
-                      CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
-      }
-      // Right border
-      if (config->width.right > 0) {
-        DrawRectangle(
-            (int)roundf(boundingBox.x + boundingBox.width -
-                        (float)config->width.right),
-            (int)roundf(boundingBox.y + config->cornerRadius.topRight),
-            (int)config->width.right,
-            (int)roundf(boundingBox.height - config->cornerRadius.topRight -
-                        config->cornerRadius.bottomRight),
-            CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
-      }
-      // Top border
-      if (config->width.top > 0) {
-        DrawRectangle(
-            (int)roundf(boundingBox.x + config->cornerRadius.topLeft),
-            (int)roundf(boundingBox.y),
-            (int)roundf(boundingBox.width - config->cornerRadius.topLeft -
-                        config->cornerRadius.topRight),
-            (int)config->width.top, CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
-      }
-      // Bottom border
-      if (config->width.bottom > 0) {
-        DrawRectangle(
-            (int)roundf(boundingBox.x + config->cornerRadius.bottomLeft),
-            (int)roundf(boundingBox.y + boundingBox.height -
-                        (float)config->width.bottom),
-            (int)roundf(boundingBox.width - config->cornerRadius.bottomLeft -
-                        config->cornerRadius.bottomRight),
-            (int)config->width.bottom,
-            CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
-      }
-      if (config->cornerRadius.topLeft > 0) {
-        DrawRing(
-            (Vector2){roundf(boundingBox.x + config->cornerRadius.topLeft),
-                      roundf(boundingBox.y + config->cornerRadius.topLeft)},
-            roundf(config->cornerRadius.topLeft - (float)config->width.top),
-            config->cornerRadius.topLeft, 180, 270, 10,
-            CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
-      }
-      if (config->cornerRadius.topRight > 0) {
-        DrawRing(
-            (Vector2){roundf(boundingBox.x + boundingBox.width -
-                             config->cornerRadius.topRight),
-                      roundf(boundingBox.y + config->cornerRadius.topRight)},
-            roundf(config->cornerRadius.topRight - (float)config->width.top),
-            config->cornerRadius.topRight, 270, 360, 10,
-            CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
-      }
-      if (config->cornerRadius.bottomLeft > 0) {
-        DrawRing(
-            (Vector2){roundf(boundingBox.x + config->cornerRadius.bottomLeft),
-                      roundf(boundingBox.y + boundingBox.height -
-                             config->cornerRadius.bottomLeft)},
-            roundf(config->cornerRadius.bottomLeft -
-                   (float)config->width.bottom),
-            config->cornerRadius.bottomLeft, 90, 180, 10,
-            CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
-      }
-      if (config->cornerRadius.bottomRight > 0) {
-        DrawRing((Vector2){roundf(boundingBox.x + boundingBox.width -
-                                  config->cornerRadius.bottomRight),
-                           roundf(boundingBox.y + boundingBox.height -
-                                  config->cornerRadius.bottomRight)},
-                 roundf(config->cornerRadius.bottomRight -
-                        (float)config->width.bottom),
-                 config->cornerRadius.bottomRight, 0.1F, 90, 10,
-                 CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
-      }
+    // Bottom border
+    if (config->width.bottom > 0) {
+      DrawRectangle(
+          (int)roundf(boundingBox.x + config->cornerRadius.bottomLeft),
+          (int)roundf(boundingBox.y + boundingBox.height -
+                      (float)config->width.bottom),
+          (int)roundf(boundingBox.width - config->cornerRadius.bottomLeft -
+                      config->cornerRadius.bottomRight),
+          (int)config->width.bottom,
+          CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
+    }
+    if (config->cornerRadius.topLeft > 0) {
+      DrawRing(
+          (Vector2){roundf(boundingBox.x + config->cornerRadius.topLeft),
+                    roundf(boundingBox.y + config->cornerRadius.topLeft)},
+          roundf(config->cornerRadius.topLeft - (float)config->width.top),
+          config->cornerRadius.topLeft, 180, 270, 10,
+          CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
+    }
+    if (config->cornerRadius.topRight > 0) {
+      DrawRing(
+          (Vector2){roundf(boundingBox.x + boundingBox.width -
+                           config->cornerRadius.topRight),
+                    roundf(boundingBox.y + config->cornerRadius.topRight)},
+          roundf(config->cornerRadius.topRight - (float)config->width.top),
+          config->cornerRadius.topRight, 270, 360, 10,
+          CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
+    }
+    if (config->cornerRadius.bottomLeft > 0) {
+      DrawRing(
+          (Vector2){roundf(boundingBox.x + config->cornerRadius.bottomLeft),
+                    roundf(boundingBox.y + boundingBox.height -
+                           config->cornerRadius.bottomLeft)},
+          roundf(config->cornerRadius.bottomLeft -
+                 (float)config->width.bottom),
+          config->cornerRadius.bottomLeft, 90, 180, 10,
+          CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
+    }
+    if (config->cornerRadius.bottomRight > 0) {
+      DrawRing((Vector2){roundf(boundingBox.x + boundingBox.width -
+                                config->cornerRadius.bottomRight),
+                         roundf(boundingBox.y + boundingBox.height -
+                                config->cornerRadius.bottomRight)},
+               roundf(config->cornerRadius.bottomRight -
+                      (float)config->width.bottom),
+               config->cornerRadius.bottomRight, 0.1F, 90, 10,
+               CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
+    }
+    break;
+  }
+  case CLAY_RENDER_COMMAND_TYPE_CUSTOM: {
+    Clay_CustomRenderData *config = &renderCommand->renderData.custom;
+    CustomLayoutElement *customElement =
+        (CustomLayoutElement *)config->customData;
+    if (!customElement) {
+      return;
+    }
+    // Custom elements carry their own background instead of a rectangle
+    if (config->backgroundColor.a > 0) {
+      DrawRectangleRec(
+          CLAY_RECTANGLE_TO_RAYLIB_RECTANGLE(renderCommand->boundingBox),
+          CLAY_COLOR_TO_RAYLIB_COLOR(config->backgroundColor));
+    }
+    switch (customElement->type) {
+    case CUSTOM_LAYOUT_ELEMENT_TYPE_3D_MODEL: {
+      Clay_BoundingBox rootBox = renderCommands->internalArray[0].boundingBox;
+      float scaleValue = CLAY__MIN(CLAY__MIN(1, 768 / rootBox.height) *
+                                       CLAY__MAX(1, rootBox.width / 1024),
+                                   1.5F);
+      Ray positionRay = GetScreenToWorldPointWithZDistance(
+          (Vector2){renderCommand->boundingBox.x +
+                        (renderCommand->boundingBox.width / 2),
+                    renderCommand->boundingBox.y +
+                        (renderCommand->boundingBox.height / 2) + 20},
+          Raylib_camera, (int)roundf(rootBox.width),
+          (int)roundf(rootBox.height), 140);
+      BeginMode3D(Raylib_camera);
+      DrawModel(customElement->customData.model->model, positionRay.position,
+                customElement->customData.model->scale * scaleValue,
+                WHITE); // Draw 3d model with texture
+      EndMode3D();
       break;
     }
-    case CLAY_RENDER_COMMAND_TYPE_CUSTOM: {
-      Clay_CustomRenderData *config = &renderCommand->renderData.custom;
-      CustomLayoutElement *customElement =
-          (CustomLayoutElement *)config->customData;
-      if (!customElement) {
-        continue;
-      }
-      switch (customElement->type) {
-      case CUSTOM_LAYOUT_ELEMENT_TYPE_3D_MODEL: {
-        Clay_BoundingBox rootBox = renderCommands.internalArray[0].boundingBox;
-        float scaleValue = CLAY__MIN(CLAY__MIN(1, 768 / rootBox.height) *
-                                         CLAY__MAX(1, rootBox.width / 1024),
-                                     1.5F);
-        Ray positionRay = GetScreenToWorldPointWithZDistance(
-            (Vector2){renderCommand->boundingBox.x +
-                          (renderCommand->boundingBox.width / 2),
-                      renderCommand->boundingBox.y +
-                          (renderCommand->boundingBox.height / 2) + 20},
-            Raylib_camera, (int)roundf(rootBox.width),
-            (int)roundf(rootBox.height), 140);
-        BeginMode3D(Raylib_camera);
-        DrawModel(customElement->customData.model.model, positionRay.position,
-                  customElement->customData.model.scale * scaleValue,
-                  WHITE); // Draw 3d model with texture
-        EndMode3D();
+    case CUSTOM_LAYOUT_ELEMENT_TYPE_WAVEFORM: {
+      CustomLayoutElement_Waveform *waveform =
+          &customElement->customData.waveform;
+      if (waveform->slot < 0 || waveform->slot >= MAX_TRACKS) {
         break;
       }
-      default:
-        break;
+      // Upload the peaks the first time a clip is drawn in this slot
+      WaveformTexture *texture = &ui_state->renderer->waveforms[waveform->slot];
+      if (!waveform_texture_matches(texture, waveform->cache)) {
+        waveform_texture_destroy(texture);
+        if (waveform->cache) {
+          waveform_texture_create(texture, waveform->cache);
+        }
       }
+      waveform_draw(&ui_state->renderer->waveform_renderer, texture,
+                    CLAY_RECTANGLE_TO_RAYLIB_RECTANGLE(
+                        renderCommand->boundingBox),
+                    waveform->start_frame, waveform->frame_span,
+                    CLAY_COLOR_TO_RAYLIB_COLOR(waveform->color));
+      break;
+    }
+    case CUSTOM_LAYOUT_ELEMENT_TYPE_SPECTRUM:
+      // Bars are painted live by render_spectrum, over the static layer
       break;
+    default:
+      break;
+    }
+    break;
+  }
+  default: {
+    TraceLog(LOG_ERROR, "[clay] Error: unhandled render command.");
+    exit(1);
+  }
+  }
+}
+
+// Commands a shape run can absorb
+static bool is_shape_command(const Clay_RenderCommand *renderCommand) {
+  return renderCommand->commandType == CLAY_RENDER_COMMAND_TYPE_RECTANGLE ||
+         renderCommand->commandType == CLAY_RENDER_COMMAND_TYPE_BORDER;
+}
+
+// Draw commands [first, last) that share a scissor state and z-index: all
+// shapes as one batched run, then the text on top. Text is never covered
+// by a later shape of the same region in this UI (meters are painted
+// separately), so the reordering is invisible.
+static void render_region(UIState *ui_state,
+                          Clay_RenderCommandArray *renderCommands, int first,
+                          int last) {
+  ShapeBatch *batch = &ui_state->renderer->shape_batch;
+  bool any_shape = false;
+  for (int j = first; j < last && !any_shape; j++) {
+    any_shape = is_shape_command(Clay_RenderCommandArray_Get(renderCommands, j));
+  }
+
+  if (any_shape) {
+    shape_batch_begin(batch);
+    for (int j = first; j < last; j++) {
+      Clay_RenderCommand *renderCommand =
+          Clay_RenderCommandArray_Get(renderCommands, j);
+      if (renderCommand->commandType == CLAY_RENDER_COMMAND_TYPE_RECTANGLE) {
+        Clay_RectangleRenderData *config = &renderCommand->renderData.rectangle;
+        shape_batch_rect(batch, rounded_box(renderCommand),
+                         config->cornerRadius.topLeft, config->backgroundColor);
+      } else if (renderCommand->commandType ==
+                 CLAY_RENDER_COMMAND_TYPE_BORDER) {
+        shape_batch_border(batch, rounded_box(renderCommand),
+                           &renderCommand->renderData.border);
+      }
     }
-    default: {
-      TraceLog(LOG_ERROR, "[clay] Error: unhandled render command.");
-      exit(1);
+    shape_batch_end(batch);
+  }
+
+  for (int j = first; j < last; j++) {
+    Clay_RenderCommand *renderCommand =
+        Clay_RenderCommandArray_Get(renderCommands, j);
+    if (renderCommand->commandType == CLAY_RENDER_COMMAND_TYPE_TEXT) {
+      render_command_immediate(ui_state, renderCommands, renderCommand);
     }
+  }
+}
+
+static void render_commands(UIState *ui_state,
+                            Clay_RenderCommandArray renderCommands) {
+  if (!ui_state->renderer->shape_batch.ready) {
+    for (int j = 0; j < renderCommands.length; j++) {
+      render_command_immediate(ui_state, &renderCommands,
+                               Clay_RenderCommandArray_Get(&renderCommands, j));
     }
+    return;
+  }
+
+  // Regions end at scissor changes, z-index changes and commands that are
+  // drawn on their own (images, custom elements)
+  shape_batch_reset_stats(&ui_state->renderer->shape_batch);
+  int first = 0;
+  for (int j = 0; j < renderCommands.length; j++) {
+    Clay_RenderCommand *renderCommand =
+        Clay_RenderCommandArray_Get(&renderCommands, j);
+    bool batched = is_shape_command(renderCommand) ||
+                   renderCommand->commandType == CLAY_RENDER_COMMAND_TYPE_TEXT;
+    bool same_layer =
+        j == first ||
+        renderCommand->zIndex ==
+            Clay_RenderCommandArray_Get(&renderCommands, first)->zIndex;
+    if (batched && same_layer) {
+      continue;
+    }
+
+    render_region(ui_state, &renderCommands, first, j);
+    first = j;
+    if (!batched) {
+      render_command_immediate(ui_state, &renderCommands, renderCommand);
+      first = j + 1;
+    }
+  }
+  render_region(ui_state, &renderCommands, first, renderCommands.length);
+}
+
+// ============================================================================
+// RETAINED RENDERING
+// ============================================================================
+
+static void render_meter(UIState *ui_state, const Clay_BoundingBox *box,
+                         const MeterBallistics *meter, int channel) {
+  Clay_BoundingBox boxes[2];
+  Clay_Color colors[2];
+  int count = ui_meter_boxes(box, meter, channel, boxes, colors);
+  for (int i = 0; i < count; i++) {
+    if (ui_state->renderer->shape_batch.ready) {
+      shape_batch_rect(&ui_state->renderer->shape_batch, boxes[i], 0.0F, colors[i]);
+    } else {
+      DrawRectangle((int)boxes[i].x, (int)boxes[i].y, (int)boxes[i].width,
+                    (int)boxes[i].height, CLAY_COLOR_TO_RAYLIB_COLOR(colors[i]));
+    }
+  }
+}
+
+// Levels over the meter wells of the last layout, as one shape run for
+// the strips (clipped to the strip list viewport) and one for master
+static void render_meters(UIState *ui_state) {
+  ShapeBatch *batch = &ui_state->renderer->shape_batch;
+  Clay_BoundingBox viewport = ui_state->tracks_viewport;
+  BeginScissorMode((int)roundf(viewport.x), (int)roundf(viewport.y),
+                   (int)roundf(viewport.width), (int)roundf(viewport.height));
+  if (batch->ready) {
+    shape_batch_begin(batch);
+  }
+  int end = ui_state->meter_first_track + ui_state->meter_track_count;
+  for (int i = ui_state->meter_first_track; i < end; i++) {
+    render_meter(ui_state, &ui_state->track_meter_boxes[i][0],
+                 &ui_state->track_meters[i], 0);
+    render_meter(ui_state, &ui_state->track_meter_boxes[i][1],
+                 &ui_state->track_meters[i], 1);
+  }
+  if (batch->ready) {
+    shape_batch_end(batch);
+  }
+  EndScissorMode();
+
+  if (batch->ready) {
+    shape_batch_begin(batch);
+  }
+  render_meter(ui_state, &ui_state->master_meter_boxes[0],
+               &ui_state->master_meter, 0);
+  render_meter(ui_state, &ui_state->master_meter_boxes[1],
+               &ui_state->master_meter, 1);
+  if (batch->ready) {
+    shape_batch_end(batch);
+  }
+}
+
+// Analyzer bands over the panel of the last layout, as one shape run
+static void render_spectrum(UIState *ui_state) {
+  if (!ui_state->analyzer_running) {
+    return;
+  }
+  const CustomLayoutElement_Spectrum *spectrum =
+      &ui_state->analyzer_element.customData.spectrum;
+  Clay_BoundingBox box = ui_state->analyzer_box;
+  if (box.width <= 0.0F || box.height <= 0.0F || spectrum->band_count <= 0) {
+    return;
+  }
+
+  ShapeBatch *batch = &ui_state->renderer->shape_batch;
+  if (batch->ready) {
+    shape_batch_begin(batch);
+  }
+  for (int b = 0; b < spectrum->band_count; b++) {
+    Clay_BoundingBox bar;
+    if (!ui_spectrum_bar(spectrum, &box, b, &bar)) {
+      continue;
+    }
+    if (batch->ready) {
+      shape_batch_rect(batch, bar, 0.0F, spectrum->color);
+    } else {
+      DrawRectangle((int)bar.x, (int)bar.y, (int)bar.width, (int)bar.height,
+                    CLAY_COLOR_TO_RAYLIB_COLOR(spectrum->color));
+    }
+  }
+  if (batch->ready) {
+    shape_batch_end(batch);
+  }
+}
+
+void ui_render(UIState *ui_state, Clay_RenderCommandArray renderCommands) {
+  ENGINE_TRACE_BEGIN("ui_render");
+  // Keep the static layer the size of the window
+  int width = ui_state->window_width;
+  int height = ui_state->window_height;
+  RenderTexture2D *layer = &ui_state->renderer->static_layer;
+  if (layer->id == 0 || layer->texture.width != width ||
+      layer->texture.height != height) {
+    if (layer->id != 0) {
+      UnloadRenderTexture(*layer);
+    }
+    *layer = LoadRenderTexture(width, height);
+    ui_state->static_layer_stale = true;
+  }
+
+  // No render target (e.g. FBOs unsupported): draw everything every frame
+  if (layer->id == 0) {
+    render_commands(ui_state, renderCommands);
+    render_meters(ui_state);
+    render_spectrum(ui_state);
+    ENGINE_TRACE_END("ui_render");
+    return;
+  }
+
+  // Replay the Clay commands only when the layout was rebuilt; otherwise
+  // one textured quad restores everything but the meters
+  if (ui_state->static_layer_stale) {
+    BeginTextureMode(*layer);
+    ClearBackground(CLAY_COLOR_TO_RAYLIB_COLOR(COLOR_BACKGROUND));
+    render_commands(ui_state, renderCommands);
+    EndTextureMode();
+    ui_state->static_layer_stale = false;
   }
+  DrawTextureRec(layer->texture,
+                 (Rectangle){0, 0, (float)width, -(float)height},
+                 (Vector2){0, 0}, WHITE);
+  render_meters(ui_state);
+  render_spectrum(ui_state);
+  ENGINE_TRACE_END("ui_render");
 }
@@ -1,7 +1,28 @@
 #pragma once
+#include "raylib.h"
+#include "renderer_batch.h"
+#include "renderer_utils.h"
 #include "ui_clay.h"
+#include "waveform.h"
 #include <stdbool.h>
 
+// raylib drawing state behind UIState.renderer
+struct UIRenderer {
+  // Font
+  Font *font;
+  uint32_t font_count;
+  TextMeasurer text_measurer;     // Clay's measure-text callback state
+
+  // Batched rect/border renderer used by ui_render
+  ShapeBatch shape_batch;
+
+  // Clip overviews: peak pyramids uploaded per waveform slot (track)
+  WaveformRenderer waveform_renderer;
+  WaveformTexture waveforms[MAX_TRACKS];
+
+  // Last full render of the cached commands, restored with one quad
+  RenderTexture2D static_layer;
+};
 
 bool ui_init(UIState *ui_state, int window_width, int window_height);
 
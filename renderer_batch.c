@@ -0,0 +1,178 @@
+#include "renderer_batch.h"
+#include "rlgl.h"
+#include <math.h>
+#include <string.h>
+
+// ============================================================================
+// SHADER
+// ============================================================================
+
+// Per vertex: texcoord = position relative to the quad centre (pixels),
+// normal = (half width, half height, radius + border * BORDER_SCALE).
+// Coverage comes from the rounded-box distance, so edges are anti-aliased
+// and square boxes (radius 0) stay pixel exact.
+#if defined(GRAPHICS_API_OPENGL_ES2) || defined(GRAPHICS_API_OPENGL_ES3)
+#define SHAPE_GLSL_HEADER "#version 100\nprecision mediump float;\n"
+#define SHAPE_GLSL_IN_VS "attribute"
+#define SHAPE_GLSL_OUT_VS "varying"
+#define SHAPE_GLSL_IN_FS "varying"
+#define SHAPE_GLSL_FRAG_OUT ""
+#define SHAPE_GLSL_FRAG_COLOR "gl_FragColor"
+#else
+#define SHAPE_GLSL_HEADER "#version 330\n"
+#define SHAPE_GLSL_IN_VS "in"
+#define SHAPE_GLSL_OUT_VS "out"
+#define SHAPE_GLSL_IN_FS "in"
+#define SHAPE_GLSL_FRAG_OUT "out vec4 finalColor;\n"
+#define SHAPE_GLSL_FRAG_COLOR "finalColor"
+#endif
+
+static const char *shape_vs =
+    SHAPE_GLSL_HEADER
+    SHAPE_GLSL_IN_VS " vec3 vertexPosition;\n"
+    SHAPE_GLSL_IN_VS " vec2 vertexTexCoord;\n"
+    SHAPE_GLSL_IN_VS " vec3 vertexNormal;\n"
+    SHAPE_GLSL_IN_VS " vec4 vertexColor;\n"
+    "uniform mat4 mvp;\n"
+    SHAPE_GLSL_OUT_VS " vec2 fragLocal;\n"
+    SHAPE_GLSL_OUT_VS " vec3 fragShape;\n"
+    SHAPE_GLSL_OUT_VS " vec4 fragColor;\n"
+    "void main() {\n"
+    "  fragLocal = vertexTexCoord;\n"
+    "  fragShape = vertexNormal;\n"
+    "  fragColor = vertexColor;\n"
+    "  gl_Position = mvp * vec4(vertexPosition, 1.0);\n"
+    "}\n";
+
+static const char *shape_fs =
+    SHAPE_GLSL_HEADER
+    SHAPE_GLSL_IN_FS " vec2 fragLocal;\n"
+    SHAPE_GLSL_IN_FS " vec3 fragShape;\n"
+    SHAPE_GLSL_IN_FS " vec4 fragColor;\n"
+    SHAPE_GLSL_FRAG_OUT
+    "float rounded_box(vec2 p, vec2 half_size, float radius) {\n"
+    "  vec2 q = abs(p) - half_size + radius;\n"
+    "  return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - radius;\n"
+    "}\n"
+    "void main() {\n"
+    "  float border = floor(fragShape.z / 1024.0);\n"
+    "  float radius = fragShape.z - border * 1024.0;\n"
+    "  float alpha = clamp(0.5 - rounded_box(fragLocal, fragShape.xy, radius), 0.0, 1.0);\n"
+    "  if (border > 0.0) {\n"
+    "    float inner = rounded_box(fragLocal, fragShape.xy - border, max(radius - border, 0.0));\n"
+    "    alpha *= clamp(0.5 + inner, 0.0, 1.0);\n"
+    "  }\n"
+    "  " SHAPE_GLSL_FRAG_COLOR " = vec4(fragColor.rgb, fragColor.a * alpha);\n"
+    "}\n";
+
+bool shape_batch_init(ShapeBatch *batch) {
+  memset(batch, 0, sizeof(ShapeBatch));
+  batch->shader = LoadShaderFromMemory(shape_vs, shape_fs);
+  batch->ready = batch->shader.id != 0 &&
+                 batch->shader.id != rlGetShaderIdDefault();
+  if (!batch->ready) {
+    TraceLog(LOG_WARNING,
+             "[raylib][UI] Shape shader unavailable, drawing shapes one by one");
+  }
+  return batch->ready;
+}
+
+void shape_batch_shutdown(ShapeBatch *batch) {
+  if (batch->ready) {
+    UnloadShader(batch->shader);
+  }
+  memset(batch, 0, sizeof(ShapeBatch));
+}
+
+void shape_batch_reset_stats(ShapeBatch *batch) {
+  batch->runs = 0;
+  batch->shapes = 0;
+}
+
+// ============================================================================
+// RUNS
+// ============================================================================
+
+void shape_batch_begin(ShapeBatch *batch) {
+  // Switching shaders flushes whatever raylib had queued, so the run starts
+  // on an empty batch and ends as one draw (unless it overflows the buffer)
+  BeginShaderMode(batch->shader);
+  rlSetTexture(rlGetTextureIdDefault());
+  rlBegin(RL_QUADS);
+  batch->runs++;
+}
+
+void shape_batch_end(ShapeBatch *batch) {
+  (void)batch;
+  rlEnd();
+  rlSetTexture(0);
+  EndShaderMode();
+}
+
+// One quad; packed = radius + border * SHAPE_BATCH_BORDER_SCALE
+static void push_quad(ShapeBatch *batch, float x, float y, float width,
+                      float height, float packed, Clay_Color color) {
+  if (width <= 0.0F || height <= 0.0F || color.a <= 0.0F) {
+    return;
+  }
+  float half_w = width * 0.5F;
+  float half_h = height * 0.5F;
+
+  // A full buffer flushes and restarts the run on its own
+  rlCheckRenderBatchLimit(4);
+  rlColor4ub((unsigned char)roundf(color.r), (unsigned char)roundf(color.g),
+             (unsigned char)roundf(color.b), (unsigned char)roundf(color.a));
+  rlNormal3f(half_w, half_h, packed);
+
+  // Same winding as raylib's own quads
+  rlTexCoord2f(-half_w, -half_h);
+  rlVertex2f(x, y);
+  rlTexCoord2f(-half_w, half_h);
+  rlVertex2f(x, y + height);
+  rlTexCoord2f(half_w, half_h);
+  rlVertex2f(x + width, y + height);
+  rlTexCoord2f(half_w, -half_h);
+  rlVertex2f(x + width, y);
+  batch->shapes++;
+}
+
+static float clamp_radius(float radius, float width, float height) {
+  float limit = fminf(width, height) * 0.5F;
+  if (radius < 0.0F) {
+    return 0.0F;
+  }
+  if (radius > limit) {
+    radius = limit;
+  }
+  return fminf(radius, SHAPE_BATCH_BORDER_SCALE - 1.0F);
+}
+
+void shape_batch_rect(ShapeBatch *batch, Clay_BoundingBox box, float radius,
+                      Clay_Color color) {
+  push_quad(batch, box.x, box.y, box.width, box.height,
+            clamp_radius(radius, box.width, box.height), color);
+}
+
+void shape_batch_border(ShapeBatch *batch, Clay_BoundingBox box,
+                        const Clay_BorderRenderData *border) {
+  float radius =
+      clamp_radius(border->cornerRadius.topLeft, box.width, box.height);
+  uint16_t width = border->width.left;
+  bool uniform = width > 0 && border->width.right == width &&
+                 border->width.top == width && border->width.bottom == width;
+  if (uniform) {
+    push_quad(batch, box.x, box.y, box.width, box.height,
+              radius + (float)width * SHAPE_BATCH_BORDER_SCALE, border->color);
+    return;
+  }
+
+  // Mixed widths (e.g. a top rule only): straight sides
+  push_quad(batch, box.x, box.y, (float)border->width.left, box.height, 0.0F,
+            border->color);
+  push_quad(batch, box.x + box.width - (float)border->width.right, box.y,
+            (float)border->width.right, box.height, 0.0F, border->color);
+  push_quad(batch, box.x, box.y, box.width, (float)border->width.top, 0.0F,
+            border->color);
+  push_quad(batch, box.x, box.y + box.height - (float)border->width.bottom,
+            box.width, (float)border->width.bottom, 0.0F, border->color);
+}
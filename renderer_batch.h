@@ -0,0 +1,47 @@
+// renderer_batch.h - Batched shape rendering for the Clay UI
+// Rectangles, rounded rectangles and borders are pushed as quads into
+// rlgl's render batch with one SDF shader bound, so a whole run of shapes
+// goes out in a single draw call instead of one DrawRectangle/DrawRing
+// each. Corners and border rings are resolved per pixel by the shader.
+#pragma once
+#ifndef RENDERER_BATCH_H
+#define RENDERER_BATCH_H
+
+#include "raylib.h"
+#include "vendor/clay/clay.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Border widths are packed above the corner radius in one vertex attribute
+// (radius + width * SHAPE_BATCH_BORDER_SCALE), so radii must stay below it
+#define SHAPE_BATCH_BORDER_SCALE 1024.0F
+
+typedef struct {
+  Shader shader;
+  bool ready;             // Shader compiled; false falls back to immediate draws
+  uint32_t runs;          // Shape runs submitted this frame (one draw call each)
+  uint32_t shapes;        // Quads submitted this frame
+} ShapeBatch;
+
+// Compile the SDF shader (needs a GL context)
+bool shape_batch_init(ShapeBatch *batch);
+void shape_batch_shutdown(ShapeBatch *batch);
+
+// Start a frame's statistics
+void shape_batch_reset_stats(ShapeBatch *batch);
+
+// Everything between begin and end is one run; anything else drawn in
+// between (text, textures) would split it, so draw those outside
+void shape_batch_begin(ShapeBatch *batch);
+void shape_batch_end(ShapeBatch *batch);
+
+// Filled rectangle, corners rounded by radius (0 = square)
+void shape_batch_rect(ShapeBatch *batch, Clay_BoundingBox box, float radius,
+                      Clay_Color color);
+
+// Border of a Clay element: a single SDF ring when all sides share one
+// width, otherwise one rect per side
+void shape_batch_border(ShapeBatch *batch, Clay_BoundingBox box,
+                        const Clay_BorderRenderData *border);
+
+#endif // RENDERER_BATCH_H
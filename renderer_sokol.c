@@ -0,0 +1,436 @@
+#include "renderer_sokol.h"
+#include "engine_log.h"
+#include "engine_trace.h"
+#include "ui_clay.h"
+#include "ui_elements.h"
+#include "vendor/clay/clay.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fontstash.h"
+#include "sokol_fontstash.h"
+#include "vendor/clay/renderers/sokol/sokol_clay.h"
+
+// Peaks of one clip copied out of its cache (cache layout: per level,
+// per bucket channel 0 min/max then channel 1 min/max). Drawn as one quad
+// per pixel column, so the cost follows the view width, not the clip.
+typedef struct {
+  const uint8_t *source;          // Mapped cache base the copy was taken from
+  uint64_t frame_count;
+  uint32_t channels;
+  uint32_t levels;
+  uint64_t level_offset[CLIP_CACHE_MAX_PEAK_LEVELS];  // First bucket of each level
+  uint64_t level_count[CLIP_CACHE_MAX_PEAK_LEVELS];
+  float *peaks;
+} SokolWaveform;
+
+// sokol drawing state behind UIState.renderer
+struct UIRenderer {
+  sclay_font_t fonts[UI_FONT_COUNT];
+  sgl_pipeline pipeline;          // Alpha blended, for the custom elements
+  float dpi_scale;
+  UIInput pending;                // Events since the last ui_update
+  SokolWaveform waveforms[MAX_TRACKS];
+};
+
+// ============================================================================
+// ERRORS
+// ============================================================================
+
+static void handle_clay_errors(Clay_ErrorData errorData) {
+  engine_log(ENGINE_LOG_ERROR, "[clay] %d: %.*s", (int)errorData.errorType,
+             (int)errorData.errorText.length, errorData.errorText.chars);
+}
+
+// ============================================================================
+// INIT / SHUTDOWN
+// ============================================================================
+
+bool ui_init(UIState *ui_state, int window_width, int window_height) {
+  engine_log(ENGINE_LOG_INFO, "[sokol][UI] Initializing UI system...");
+  if (!ui_state_init(ui_state, window_width, window_height,
+                     (Clay_ErrorHandler){handle_clay_errors, NULL})) {
+    return false;
+  }
+  UIRenderer *renderer = calloc(1, sizeof(UIRenderer));
+  if (!renderer) {
+    engine_log(ENGINE_LOG_ERROR, "[sokol][UI] Failed to allocate renderer state");
+    return false;
+  }
+  ui_state->renderer = renderer;
+  renderer->dpi_scale = sapp_dpi_scale();
+  renderer->pending.window_width = window_width;
+  renderer->pending.window_height = window_height;
+
+  sclay_setup();
+  renderer->pipeline = sgl_make_pipeline(&(sg_pipeline_desc){
+      .colors[0] = {.blend = {.enabled = true,
+                              .src_factor_rgb = SG_BLENDFACTOR_SRC_ALPHA,
+                              .dst_factor_rgb =
+                                  SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA}}});
+
+  for (int i = 0; i < UI_FONT_COUNT; i++) {
+    renderer->fonts[i] = sclay_add_font(ui_font_paths[i]);
+    if (renderer->fonts[i] == FONS_INVALID) {
+      engine_log(ENGINE_LOG_WARNING,
+                 "[sokol][UI] Failed to load font %s, text will not be drawn",
+                 ui_font_paths[i]);
+    } else {
+      engine_log(ENGINE_LOG_INFO, "[sokol][UI] Loaded font: %s",
+                 ui_font_paths[i]);
+    }
+  }
+  Clay_SetMeasureTextFunction(sclay_measure_text, renderer->fonts);
+
+  engine_log(ENGINE_LOG_INFO, "[sokol][UI] UI system initialized successfully");
+  return true;
+}
+
+void ui_shutdown(UIState *ui_state) {
+  engine_log(ENGINE_LOG_INFO, "[sokol][UI] Shutting down UI system");
+
+  UIRenderer *renderer = ui_state->renderer;
+  ui_state_shutdown(ui_state);
+  if (!renderer) {
+    return;
+  }
+  for (int i = 0; i < MAX_TRACKS; i++) {
+    free(renderer->waveforms[i].peaks);
+  }
+  sgl_destroy_pipeline(renderer->pipeline);
+  sclay_shutdown();
+  free(renderer);
+  ui_state->renderer = NULL;
+}
+
+// ============================================================================
+// UI UPDATE
+// ============================================================================
+
+void ui_handle_event(UIState *ui_state, const sapp_event *event) {
+  UIRenderer *renderer = ui_state->renderer;
+  UIInput *input = &renderer->pending;
+  switch (event->type) {
+  case SAPP_EVENTTYPE_MOUSE_MOVE:
+    input->mouse_pos = (Clay_Vector2){event->mouse_x / renderer->dpi_scale,
+                                      event->mouse_y / renderer->dpi_scale};
+    break;
+  case SAPP_EVENTTYPE_MOUSE_DOWN:
+    if (event->mouse_button == SAPP_MOUSEBUTTON_LEFT) {
+      input->mouse_pressed = true;
+      input->mouse_down = true;
+    }
+    break;
+  case SAPP_EVENTTYPE_MOUSE_UP:
+    if (event->mouse_button == SAPP_MOUSEBUTTON_LEFT) {
+      input->mouse_released = true;
+      input->mouse_down = false;
+    }
+    break;
+  case SAPP_EVENTTYPE_MOUSE_SCROLL:
+    input->wheel.x += event->scroll_x;
+    input->wheel.y += event->scroll_y;
+    break;
+  case SAPP_EVENTTYPE_KEY_DOWN:
+  case SAPP_EVENTTYPE_CHAR:
+    input->key_pressed = true;
+    break;
+  case SAPP_EVENTTYPE_RESIZED:
+    input->resized = true;
+    break;
+  default:
+    break;
+  }
+}
+
+void ui_update(UIState *ui_state) {
+  UIRenderer *renderer = ui_state->renderer;
+  UIInput *input = &renderer->pending;
+
+  // Layout runs in points; sokol_clay scales to the framebuffer
+  float dpi_scale = sapp_dpi_scale();
+  if (dpi_scale != renderer->dpi_scale) {
+    renderer->dpi_scale = dpi_scale;
+    input->resized = true;
+  }
+  input->window_width = (int)(sapp_widthf() / dpi_scale);
+  input->window_height = (int)(sapp_heightf() / dpi_scale);
+  input->frame_seconds = (float)sapp_frame_duration();
+  sclay_set_layout_dimensions(
+      (Clay_Dimensions){sapp_widthf(), sapp_heightf()}, dpi_scale);
+
+  ui_apply_input(ui_state, input);
+
+  // Edges and deltas belong to one frame; position and button state stay
+  input->mouse_pressed = false;
+  input->mouse_released = false;
+  input->wheel = (Clay_Vector2){0, 0};
+  input->key_pressed = false;
+  input->resized = false;
+}
+
+// ============================================================================
+// UI RENDER
+// ============================================================================
+
+static void draw_rect(Clay_BoundingBox box, Clay_Color color) {
+  sgl_c4b((uint8_t)roundf(color.r), (uint8_t)roundf(color.g),
+          (uint8_t)roundf(color.b), (uint8_t)roundf(color.a));
+  sgl_v2f(box.x, box.y);
+  sgl_v2f(box.x + box.width, box.y);
+  sgl_v2f(box.x + box.width, box.y + box.height);
+  sgl_v2f(box.x, box.y + box.height);
+}
+
+static void scissor(const UIRenderer *renderer, Clay_BoundingBox box) {
+  float scale = renderer->dpi_scale;
+  sgl_scissor_rectf(box.x * scale, box.y * scale, box.width * scale,
+                    box.height * scale, true);
+}
+
+static void scissor_reset(void) {
+  sgl_scissor_rectf(0.0F, 0.0F, sapp_widthf(), sapp_heightf(), true);
+}
+
+// Copy every peak level of `cache` into the slot
+static bool waveform_sync(SokolWaveform *waveform, const ClipCache *cache) {
+  if (cache && waveform->levels > 0 && waveform->source == cache->base &&
+      waveform->frame_count == clip_cache_frame_count(cache)) {
+    return true;
+  }
+  free(waveform->peaks);
+  memset(waveform, 0, sizeof(SokolWaveform));
+  if (!cache) {
+    return false;
+  }
+
+  const ClipCacheHeader *header = cache->header;
+  uint64_t total = 0;
+  for (uint32_t level = 0; level < header->peak_levels; level++) {
+    waveform->level_offset[level] = total;
+    waveform->level_count[level] = header->peak_count[level];
+    total += header->peak_count[level];
+  }
+  if (total == 0) {
+    return false;
+  }
+  waveform->peaks = malloc((size_t)total * 4 * sizeof(float));
+  if (!waveform->peaks) {
+    engine_log(ENGINE_LOG_WARNING, "[sokol][UI] Out of memory for waveform peaks");
+    return false;
+  }
+
+  // Mono caches hand channel 0 back for channel 1
+  for (uint32_t level = 0; level < header->peak_levels; level++) {
+    uint64_t count = 0;
+    const ClipPeak *left = clip_cache_peaks(cache, level, 0, &count);
+    const ClipPeak *right = clip_cache_peaks(cache, level, 1, &count);
+    float *peak = waveform->peaks + waveform->level_offset[level] * 4;
+    for (uint64_t i = 0; i < count; i++, peak += 4) {
+      peak[0] = left[i].min;
+      peak[1] = left[i].max;
+      peak[2] = right[i].min;
+      peak[3] = right[i].max;
+    }
+  }
+  waveform->source = cache->base;
+  waveform->frame_count = header->frame_count;
+  waveform->channels = header->channels;
+  waveform->levels = header->peak_levels;
+  return true;
+}
+
+// One quad per pixel column and channel, from the level whose buckets are
+// closest to a pixel wide (same rule as clip_cache_peak_level_for)
+static void draw_waveform(const SokolWaveform *waveform,
+                          const CustomLayoutElement_Waveform *element,
+                          Clay_BoundingBox bounds) {
+  if (waveform->levels == 0 || element->frame_span == 0 ||
+      bounds.width < 1.0F || bounds.height < 1.0F) {
+    return;
+  }
+  double frames_per_pixel = (double)element->frame_span / bounds.width;
+  uint32_t level = 0;
+  double bucket_frames = CLIP_CACHE_PEAK_FRAMES;
+  while (level + 1 < waveform->levels &&
+         bucket_frames * CLIP_CACHE_PEAK_FACTOR <= frames_per_pixel) {
+    level++;
+    bucket_frames *= CLIP_CACHE_PEAK_FACTOR;
+  }
+  double first_bucket = (double)element->start_frame / bucket_frames;
+  double buckets_per_pixel = frames_per_pixel / bucket_frames;
+
+  int columns = (int)bounds.width;
+  uint32_t lanes = waveform->channels > 1 ? 2 : 1;
+  float lane_height = bounds.height / (float)lanes;
+  int64_t count = (int64_t)waveform->level_count[level];
+  const float *peaks = waveform->peaks + waveform->level_offset[level] * 4;
+
+  for (int column = 0; column < columns; column++) {
+    int64_t first = (int64_t)floor(first_bucket + column * buckets_per_pixel);
+    int64_t last = (int64_t)ceil(first_bucket +
+                                 (column + 1) * buckets_per_pixel) - 1;
+    if (last < first) {
+      last = first;
+    }
+    if (first < 0) {
+      first = 0;
+    }
+    if (last >= count) {
+      last = count - 1;
+    }
+    if (last < first) {
+      continue;
+    }
+    for (uint32_t lane = 0; lane < lanes; lane++) {
+      float low = peaks[first * 4 + lane * 2];
+      float high = peaks[first * 4 + lane * 2 + 1];
+      for (int64_t i = first + 1; i <= last; i++) {
+        low = fminf(low, peaks[i * 4 + lane * 2]);
+        high = fmaxf(high, peaks[i * 4 + lane * 2 + 1]);
+      }
+      float centre = bounds.y + lane_height * ((float)lane + 0.5F);
+      float top = centre - high * lane_height * 0.5F;
+      float bottom = centre - low * lane_height * 0.5F;
+      draw_rect((Clay_BoundingBox){bounds.x + (float)column, top, 1.0F,
+                                   fmaxf(bottom - top, 1.0F)},
+                element->color);
+    }
+  }
+}
+
+// sokol_clay skips custom commands; draw them here under the same
+// scissors. Their backgrounds come first (no rectangle is emitted for a
+// custom element), which is safe as nothing in this UI sits on top of one.
+static void render_custom_elements(UIState *ui_state,
+                                   Clay_RenderCommandArray *renderCommands) {
+  UIRenderer *renderer = ui_state->renderer;
+  sgl_begin_quads();
+  for (int j = 0; j < renderCommands->length; j++) {
+    Clay_RenderCommand *renderCommand =
+        Clay_RenderCommandArray_Get(renderCommands, j);
+    switch (renderCommand->commandType) {
+    case CLAY_RENDER_COMMAND_TYPE_SCISSOR_START:
+      sgl_end();
+      scissor(renderer, renderCommand->boundingBox);
+      sgl_begin_quads();
+      break;
+    case CLAY_RENDER_COMMAND_TYPE_SCISSOR_END:
+      sgl_end();
+      scissor_reset();
+      sgl_begin_quads();
+      break;
+    case CLAY_RENDER_COMMAND_TYPE_CUSTOM: {
+      Clay_CustomRenderData *config = &renderCommand->renderData.custom;
+      CustomLayoutElement *customElement =
+          (CustomLayoutElement *)config->customData;
+      if (!customElement) {
+        break;
+      }
+      if (config->backgroundColor.a > 0) {
+        draw_rect(renderCommand->boundingBox, config->backgroundColor);
+      }
+      if (customElement->type == CUSTOM_LAYOUT_ELEMENT_TYPE_WAVEFORM) {
+        CustomLayoutElement_Waveform *element =
+            &customElement->customData.waveform;
+        if (element->slot >= 0 && element->slot < MAX_TRACKS &&
+            waveform_sync(&renderer->waveforms[element->slot],
+                          element->cache)) {
+          draw_waveform(&renderer->waveforms[element->slot], element,
+                        renderCommand->boundingBox);
+        }
+      }
+      // Spectrum bars are painted live by render_spectrum; 3D models are
+      // raylib only
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  sgl_end();
+  scissor_reset();
+}
+
+static void render_meter(const Clay_BoundingBox *box,
+                         const MeterBallistics *meter, int channel) {
+  Clay_BoundingBox boxes[2];
+  Clay_Color colors[2];
+  int count = ui_meter_boxes(box, meter, channel, boxes, colors);
+  for (int i = 0; i < count; i++) {
+    draw_rect(boxes[i], colors[i]);
+  }
+}
+
+// Levels over the meter wells of the last layout, the strips clipped to
+// the strip list viewport
+static void render_meters(UIState *ui_state) {
+  scissor(ui_state->renderer, ui_state->tracks_viewport);
+  sgl_begin_quads();
+  int end = ui_state->meter_first_track + ui_state->meter_track_count;
+  for (int i = ui_state->meter_first_track; i < end; i++) {
+    render_meter(&ui_state->track_meter_boxes[i][0],
+                 &ui_state->track_meters[i], 0);
+    render_meter(&ui_state->track_meter_boxes[i][1],
+                 &ui_state->track_meters[i], 1);
+  }
+  sgl_end();
+  scissor_reset();
+
+  sgl_begin_quads();
+  render_meter(&ui_state->master_meter_boxes[0], &ui_state->master_meter, 0);
+  render_meter(&ui_state->master_meter_boxes[1], &ui_state->master_meter, 1);
+  sgl_end();
+}
+
+static void render_spectrum(UIState *ui_state) {
+  if (!ui_state->analyzer_running) {
+    return;
+  }
+  const CustomLayoutElement_Spectrum *spectrum =
+      &ui_state->analyzer_element.customData.spectrum;
+  Clay_BoundingBox box = ui_state->analyzer_box;
+  if (box.width <= 0.0F || box.height <= 0.0F || spectrum->band_count <= 0) {
+    return;
+  }
+  sgl_begin_quads();
+  for (int b = 0; b < spectrum->band_count; b++) {
+    Clay_BoundingBox bar;
+    if (ui_spectrum_bar(spectrum, &box, b, &bar)) {
+      draw_rect(bar, spectrum->color);
+    }
+  }
+  sgl_end();
+}
+
+// Everything is re-recorded every frame: sokol_gl keeps the vertices in
+// one streaming buffer and replays them with a handful of draw calls, so
+// a retained texture (as in the raylib renderer) would buy little. The
+// Clay layout itself stays cached by ui_build_layout.
+void ui_render(UIState *ui_state, Clay_RenderCommandArray renderCommands) {
+  UIRenderer *renderer = ui_state->renderer;
+  ENGINE_TRACE_BEGIN("ui_render");
+
+  sgl_defaults();
+  sclay_render(renderCommands, renderer->fonts);
+
+  // sokol_clay leaves its own transform behind; draw ours in points too
+  sgl_matrix_mode_modelview();
+  sgl_load_identity();
+  sgl_translate(-1.0F, 1.0F, 0.0F);
+  sgl_scale(2.0F / ((float)sapp_widthf() / renderer->dpi_scale),
+            -2.0F / ((float)sapp_heightf() / renderer->dpi_scale), 1.0F);
+  sgl_disable_texture();
+  sgl_load_pipeline(renderer->pipeline);
+
+  render_custom_elements(ui_state, &renderCommands);
+  render_meters(ui_state);
+  render_spectrum(ui_state);
+  ui_state->static_layer_stale = false;
+
+  sgl_draw();
+  ENGINE_TRACE_END("ui_render");
+}
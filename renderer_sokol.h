@@ -0,0 +1,31 @@
+// renderer_sokol.h - Sokol frontend for the shared Clay UI
+// Same entry points as the raylib renderer (renderer.h); main.c links this
+// one instead. The generic Clay commands go through sokol_clay.h, the UI's
+// custom elements and the live meters through sokol_gl, which batches
+// everything into sokol_gfx vertex buffers and submits them once per frame
+// (sgl_draw) on the configured backend (D3D11, Metal or GL).
+#pragma once
+#ifndef RENDERER_SOKOL_H
+#define RENDERER_SOKOL_H
+
+#include "sokol_app.h"
+#include "sokol_gfx.h"
+#include "sokol_gl.h"
+#include "ui_clay.h"
+#include <stdbool.h>
+
+// Needs sg_setup and sgl_setup to have run
+bool ui_init(UIState *ui_state, int window_width, int window_height);
+
+void ui_shutdown(UIState *ui_state);
+
+// Accumulate a sokol_app event into the next frame's input
+void ui_handle_event(UIState *ui_state, const sapp_event *event);
+
+// Apply the input gathered since the last frame (once per frame)
+void ui_update(UIState *ui_state);
+
+// Record the frame into sokol_gl and draw it (inside the swapchain pass)
+void ui_render(UIState *ui_state, Clay_RenderCommandArray renderCommands);
+
+#endif // RENDERER_SOKOL_H
@@ -1,18 +1,10 @@
+#include "renderer_utils.h"
 #include "raylib.h"
 #include "raymath.h"
 #include "vendor/clay/clay.h"
 #include <math.h>
-
-#define CLAY_RECTANGLE_TO_RAYLIB_RECTANGLE(rectangle)                          \
-  (Rectangle) {                                                                \
-    .x = rectangle.x, .y = rectangle.y, .width = rectangle.width,              \
-    .height = rectangle.height                                                 \
-  }
-#define CLAY_COLOR_TO_RAYLIB_COLOR(color)                                      \
-  (Color) {                                                                    \
-    .r = (unsigned char)roundf(color.r), .g = (unsigned char)roundf(color.g),  \
-    .b = (unsigned char)roundf(color.b), .a = (unsigned char)roundf(color.a)   \
-  }
+#include <stdlib.h>
+#include <string.h>
 
 void HandleClayErrors(Clay_ErrorData errorData) {
   // See the Clay_ErrorData struct for more information
@@ -84,3 +76,227 @@ Ray GetScreenToWorldPointWithZDistance(Vector2 position, Camera camera,
 
   return ray;
 }
+
+// ============================================================================
+// TEXT MEASUREMENT
+// ============================================================================
+
+static uint32_t hash_codepoint(int codepoint) {
+  return (uint32_t)codepoint * 2654435761u;
+}
+
+static bool glyph_table_build(GlyphTable *table, const Font *font) {
+  memset(table, 0, sizeof(GlyphTable));
+  uint32_t slots = 16;
+  while (slots < (uint32_t)font->glyphCount * 2) {
+    slots <<= 1;
+  }
+  table->codepoints = malloc(sizeof(int) * slots);
+  table->indices = malloc(sizeof(int) * slots);
+  if (!table->codepoints || !table->indices) {
+    free(table->codepoints);
+    free(table->indices);
+    return false;
+  }
+  table->mask = slots - 1;
+  for (uint32_t i = 0; i < slots; i++) {
+    table->codepoints[i] = -1;
+  }
+  for (int i = 0; i < TEXT_GLYPH_DIRECT; i++) {
+    table->direct[i] = -1;
+  }
+
+  for (int i = 0; i < font->glyphCount; i++) {
+    int codepoint = font->glyphs[i].value;
+    if (codepoint >= 0 && codepoint < TEXT_GLYPH_DIRECT) {
+      if (table->direct[codepoint] < 0) {
+        table->direct[codepoint] = i;
+      }
+      continue;
+    }
+    uint32_t slot = hash_codepoint(codepoint) & table->mask;
+    while (table->codepoints[slot] != -1 &&
+           table->codepoints[slot] != codepoint) {
+      slot = (slot + 1) & table->mask;
+    }
+    if (table->codepoints[slot] == -1) {
+      table->codepoints[slot] = codepoint;
+      table->indices[slot] = i;
+    }
+  }
+
+  // Same fallback raylib uses when drawing
+  table->fallback = table->direct['?'] >= 0 ? table->direct['?'] : 0;
+  for (int i = 0; i < TEXT_GLYPH_DIRECT; i++) {
+    if (table->direct[i] < 0) {
+      table->direct[i] = table->fallback;
+    }
+  }
+  return true;
+}
+
+int glyph_table_lookup(const GlyphTable *table, int codepoint) {
+  if (codepoint >= 0 && codepoint < TEXT_GLYPH_DIRECT) {
+    return table->direct[codepoint];
+  }
+  uint32_t slot = hash_codepoint(codepoint) & table->mask;
+  while (table->codepoints[slot] != -1) {
+    if (table->codepoints[slot] == codepoint) {
+      return table->indices[slot];
+    }
+    slot = (slot + 1) & table->mask;
+  }
+  return table->fallback;
+}
+
+bool text_measurer_init(TextMeasurer *measurer, Font *fonts,
+                        uint32_t font_count) {
+  memset(measurer, 0, sizeof(TextMeasurer));
+  measurer->fonts = fonts;
+  measurer->glyphs = calloc(font_count, sizeof(GlyphTable));
+  measurer->entries =
+      calloc(TEXT_MEASURE_CACHE_SIZE, sizeof(TextMeasureEntry));
+  if (!measurer->glyphs || !measurer->entries) {
+    text_measurer_shutdown(measurer);
+    return false;
+  }
+
+  for (uint32_t i = 0; i < font_count; i++) {
+    // Fonts that failed to load measure (and draw) with the default font
+    if (!fonts[i].glyphs) {
+      fonts[i] = GetFontDefault();
+    }
+    if (!glyph_table_build(&measurer->glyphs[i], &fonts[i])) {
+      text_measurer_shutdown(measurer);
+      return false;
+    }
+    measurer->font_count++;
+  }
+  return true;
+}
+
+void text_measurer_shutdown(TextMeasurer *measurer) {
+  for (uint32_t i = 0; i < measurer->font_count; i++) {
+    free(measurer->glyphs[i].codepoints);
+    free(measurer->glyphs[i].indices);
+  }
+  free(measurer->glyphs);
+  free(measurer->entries);
+  memset(measurer, 0, sizeof(TextMeasurer));
+}
+
+// Decode one UTF-8 sequence without reading past end. Malformed bytes
+// decode as themselves, one byte at a time.
+static int next_codepoint(const char *text, int32_t remaining, int *size) {
+  const unsigned char *bytes = (const unsigned char *)text;
+  int length = bytes[0] < 0x80   ? 1
+               : bytes[0] < 0xE0 ? 2
+               : bytes[0] < 0xF0 ? 3
+                                 : 4;
+  if ((bytes[0] & 0xC0) == 0x80 || length > remaining) {
+    *size = 1;
+    return bytes[0];
+  }
+  int codepoint = length == 1   ? bytes[0]
+                  : length == 2 ? bytes[0] & 0x1F
+                  : length == 3 ? bytes[0] & 0x0F
+                                : bytes[0] & 0x07;
+  for (int i = 1; i < length; i++) {
+    if ((bytes[i] & 0xC0) != 0x80) {
+      *size = 1;
+      return bytes[0];
+    }
+    codepoint = (codepoint << 6) | (bytes[i] & 0x3F);
+  }
+  *size = length;
+  return codepoint;
+}
+
+static Clay_Dimensions measure_uncached(const TextMeasurer *measurer,
+                                        Clay_StringSlice text,
+                                        const Clay_TextElementConfig *config) {
+  uint32_t font_id = config->fontId < measurer->font_count ? config->fontId : 0;
+  const Font *font = &measurer->fonts[font_id];
+  const GlyphTable *table = &measurer->glyphs[font_id];
+
+  float max_width = 0.0F;
+  float line_width = 0.0F;
+  int line_chars = 0;
+  for (int32_t i = 0; i < text.length;) {
+    int size = 1;
+    int codepoint = next_codepoint(text.chars + i, text.length - i, &size);
+    i += size;
+    if (codepoint == '\n') {
+      max_width = fmaxf(max_width, line_width);
+      line_width = 0.0F;
+      line_chars = 0;
+      continue;
+    }
+    int index = glyph_table_lookup(table, codepoint);
+    if (font->glyphs[index].advanceX != 0) {
+      line_width += (float)font->glyphs[index].advanceX;
+    } else {
+      line_width += font->recs[index].width + (float)font->glyphs[index].offsetX;
+    }
+    line_chars++;
+  }
+  max_width = fmaxf(max_width, line_width);
+
+  float scale = (float)config->fontSize / (float)font->baseSize;
+  return (Clay_Dimensions){
+      .width = max_width * scale +
+               (float)line_chars * (float)config->letterSpacing,
+      .height = (float)config->fontSize,
+  };
+}
+
+Clay_Dimensions clay_measure_text(Clay_StringSlice text,
+                                  Clay_TextElementConfig *config,
+                                  void *userData) {
+  TextMeasurer *measurer = (TextMeasurer *)userData;
+  if (measurer->font_count == 0) {
+    return (Clay_Dimensions){0};
+  }
+
+  uint64_t hash = 14695981039346656037ull;
+  for (int32_t i = 0; i < text.length; i++) {
+    hash = (hash ^ (unsigned char)text.chars[i]) * 1099511628211ull;
+  }
+  hash ^= ((uint64_t)config->fontId << 48) ^ ((uint64_t)config->fontSize << 32);
+
+  // Linear probing; the table is wiped when it gets crowded, which only
+  // happens after a lot of distinct strings (e.g. changing status text)
+  uint32_t mask = TEXT_MEASURE_CACHE_SIZE - 1;
+  uint32_t slot = (uint32_t)(hash ^ (hash >> 32)) & mask;
+  while (measurer->entries[slot].used) {
+    TextMeasureEntry *entry = &measurer->entries[slot];
+    if (entry->hash == hash && entry->length == (uint32_t)text.length &&
+        entry->font_id == config->fontId &&
+        entry->font_size == config->fontSize &&
+        entry->letter_spacing == (float)config->letterSpacing) {
+      measurer->hits++;
+      return entry->size;
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  measurer->misses++;
+  Clay_Dimensions size = measure_uncached(measurer, text, config);
+  if (measurer->entry_count >= TEXT_MEASURE_CACHE_SIZE * 3 / 4) {
+    memset(measurer->entries, 0,
+           sizeof(TextMeasureEntry) * TEXT_MEASURE_CACHE_SIZE);
+    measurer->entry_count = 0;
+    slot = (uint32_t)(hash ^ (hash >> 32)) & mask;
+  }
+  measurer->entries[slot] = (TextMeasureEntry){
+      .hash = hash,
+      .length = (uint32_t)text.length,
+      .font_id = config->fontId,
+      .font_size = config->fontSize,
+      .letter_spacing = (float)config->letterSpacing,
+      .size = size,
+      .used = true,
+  };
+  measurer->entry_count++;
+  return size;
+}
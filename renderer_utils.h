@@ -1,8 +1,12 @@
 #pragma once
 
 #include "raylib.h"
+#include "ui_elements.h"
 #include "vendor/clay/clay.h"
+#include "waveform.h"
 #include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
 
 #define CLAY_RECTANGLE_TO_RAYLIB_RECTANGLE(rectangle)                          \
   (Rectangle) {                                                                \
@@ -15,91 +19,67 @@
     .b = (unsigned char)roundf(color.b), .a = (unsigned char)roundf(color.a)   \
   }
 
-#define CLAY_MEMORY_SIZE Clay_MinMemorySize()
-
-// UI Colors
-#define COLOR_BACKGROUND (Clay_Color){25, 25, 30, 255}
-#define COLOR_PANEL (Clay_Color){35, 35, 40, 255}
-#define COLOR_TRACK_BG (Clay_Color){45, 45, 50, 255}
-#define COLOR_TRACK_BORDER (Clay_Color){60, 60, 65, 255}
-#define COLOR_BUTTON (Clay_Color){70, 70, 75, 255}
-#define COLOR_BUTTON_HOVER (Clay_Color){90, 90, 95, 255}
-#define COLOR_BUTTON_ACTIVE (Clay_Color){50, 150, 200, 255}
-#define COLOR_SLIDER (Clay_Color){50, 150, 200, 255}
-#define COLOR_SLIDER_BG (Clay_Color){30, 30, 35, 255}
-#define COLOR_TEXT (Clay_Color){220, 220, 225, 255}
-#define COLOR_TEXT_DIM (Clay_Color){140, 140, 145, 255}
-#define COLOR_METER_GREEN (Clay_Color){50, 200, 50, 255}
-#define COLOR_METER_YELLOW (Clay_Color){220, 200, 50, 255}
-#define COLOR_METER_RED (Clay_Color){220, 50, 50, 255}
-
 void HandleClayErrors(Clay_ErrorData errorData);
 
-typedef enum { CUSTOM_LAYOUT_ELEMENT_TYPE_3D_MODEL } CustomLayoutElementType;
-
-typedef struct {
+typedef struct CustomLayoutElement_3DModel {
   Model model;
   float scale;
   Vector3 position;
   Matrix rotation;
 } CustomLayoutElement_3DModel;
 
-typedef struct {
-  CustomLayoutElementType type;
-  union {
-    CustomLayoutElement_3DModel model;
-  } customData;
-} CustomLayoutElement;
-
 Ray GetScreenToWorldPointWithZDistance(Vector2 position, Camera camera,
                                        int screenWidth, int screenHeight,
                                        float zDistance);
 
-static inline Clay_Dimensions clay_measure_text(Clay_StringSlice text,
-                                                Clay_TextElementConfig *config,
-                                                void *userData) {
-  // Measure string size for Font
-  Clay_Dimensions textSize = {0};
+// ============================================================================
+// TEXT MEASUREMENT
+// ============================================================================
 
-  float maxTextWidth = 0.0F;
-  float lineTextWidth = 0;
-  int maxLineCharCount = 0;
-  int lineCharCount = 0;
-
-  float textHeight = config->fontSize;
-  Font *fonts = (Font *)userData;
-  Font fontToUse = fonts[config->fontId];
-  // Font failed to load, likely the fonts are in the wrong place relative to
-  // the execution dir. RayLib ships with a default font, so we can continue
-  // with that built in one.
-  if (!fontToUse.glyphs) {
-    fontToUse = GetFontDefault();
-  }
+#define TEXT_GLYPH_DIRECT 128         // Codepoints below this use a flat table
+#define TEXT_MEASURE_CACHE_SIZE 1024  // Cached measurements (power of two)
 
-  float scaleFactor = config->fontSize / (float)fontToUse.baseSize;
-
-  for (int i = 0; i < text.length; ++i, lineCharCount++) {
-    if (text.chars[i] == '\n') {
-      maxTextWidth = fmax(maxTextWidth, lineTextWidth);
-      maxLineCharCount = CLAY__MAX(maxLineCharCount, lineCharCount);
-      lineTextWidth = 0;
-      lineCharCount = 0;
-      continue;
-    }
-    int index = text.chars[i] - 32;
-    if (fontToUse.glyphs[index].advanceX != 0)
-      lineTextWidth += fontToUse.glyphs[index].advanceX;
-    else
-      lineTextWidth +=
-          (fontToUse.recs[index].width + fontToUse.glyphs[index].offsetX);
-  }
-
-  maxTextWidth = fmax(maxTextWidth, lineTextWidth);
-  maxLineCharCount = CLAY__MAX(maxLineCharCount, lineCharCount);
-
-  textSize.width =
-      maxTextWidth * scaleFactor + (lineCharCount * config->letterSpacing);
-  textSize.height = textHeight;
+// Codepoint -> glyph index for one font: a flat table for ASCII, open
+// addressing for everything else. Unknown codepoints map to '?' (or 0).
+typedef struct {
+  int direct[TEXT_GLYPH_DIRECT];
+  int *codepoints;                // Hash keys, -1 = empty
+  int *indices;
+  uint32_t mask;
+  int fallback;
+} GlyphTable;
 
-  return textSize;
-}
+typedef struct {
+  uint64_t hash;                  // FNV-1a of the text bytes
+  uint32_t length;
+  uint16_t font_id;
+  uint16_t font_size;
+  float letter_spacing;
+  Clay_Dimensions size;
+  bool used;
+} TextMeasureEntry;
+
+// Clay's measure-text user data. Measurements persist across frames (Clay
+// drops its own word cache for text unseen for a couple of layouts) and
+// are only discarded when the table fills up.
+typedef struct {
+  Font *fonts;
+  uint32_t font_count;
+  GlyphTable *glyphs;             // One per font
+  TextMeasureEntry *entries;      // TEXT_MEASURE_CACHE_SIZE
+  uint32_t entry_count;
+  uint32_t hits;
+  uint32_t misses;
+} TextMeasurer;
+
+bool text_measurer_init(TextMeasurer *measurer, Font *fonts,
+                        uint32_t font_count);
+void text_measurer_shutdown(TextMeasurer *measurer);
+
+// Glyph index of a codepoint in table (never out of range)
+int glyph_table_lookup(const GlyphTable *table, int codepoint);
+
+// Clay_SetMeasureTextFunction callback; userData is a TextMeasurer
+Clay_Dimensions clay_measure_text(Clay_StringSlice text,
+                                  Clay_TextElementConfig *config,
+                                  void *userData);
@@ -0,0 +1,235 @@
+#include "resampler.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define RESAMPLER_PHASE_BITS 8          // log2(RESAMPLER_SINC_PHASES)
+#define RESAMPLER_BLEND_BITS 16         // Fraction bits between two phases
+
+_Static_assert((1 << RESAMPLER_PHASE_BITS) == RESAMPLER_SINC_PHASES, "phase bits must match the phase count");
+
+// ============================================================================
+// KERNEL
+// ============================================================================
+
+// Modified Bessel function of the first kind, order 0 (series; converges
+// quickly for the betas a window uses)
+static double bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 64; k++) {
+        double half_x = x / (2.0 * k);
+        term *= half_x * half_x;
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+// Low-passed sinc at `distance` input frames, windowed to +-half frames
+static double kernel(double distance, double cutoff, uint32_t half) {
+    double x = distance / (double)half;
+    if (x <= -1.0 || x >= 1.0) {
+        return 0.0;
+    }
+    double window = bessel_i0(RESAMPLER_SINC_KAISER_BETA * sqrt(1.0 - x * x)) /
+                    bessel_i0(RESAMPLER_SINC_KAISER_BETA);
+    double arg = M_PI * cutoff * distance;
+    double sinc = fabs(arg) < 1e-9 ? 1.0 : sin(arg) / arg;
+    return cutoff * sinc * window;
+}
+
+// One row of taps per phase, plus the row for a whole frame so every phase
+// can blend with the next. Rows are normalized to unit DC gain.
+static bool build_table(Resampler* resampler) {
+    double ratio = (double)resampler->out_rate / (double)resampler->in_rate;
+    double cutoff = RESAMPLER_SINC_CUTOFF * (ratio < 1.0 ? ratio : 1.0);
+    uint32_t taps = resampler->taps;
+    resampler->table = (float*)malloc(sizeof(float) * taps * (RESAMPLER_SINC_PHASES + 1));
+    if (!resampler->table) {
+        return false;
+    }
+    for (uint32_t phase = 0; phase <= RESAMPLER_SINC_PHASES; phase++) {
+        float* row = resampler->table + (size_t)phase * taps;
+        double fraction = (double)phase / RESAMPLER_SINC_PHASES;
+        double sum = 0.0;
+        double values[2 * RESAMPLER_SINC_MAX_HALF_TAPS];
+        for (uint32_t k = 0; k < taps; k++) {
+            // Tap k reads input frame i - half + 1 + k for an output at i + fraction
+            values[k] = kernel((double)k - (double)resampler->half + 1.0 - fraction, cutoff, resampler->half);
+            sum += values[k];
+        }
+        for (uint32_t k = 0; k < taps; k++) {
+            row[k] = (float)(values[k] / sum);
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// LIFECYCLE
+// ============================================================================
+
+bool resampler_init(Resampler* resampler, uint32_t channels, uint32_t in_rate, uint32_t out_rate,
+                    ResamplerQuality quality, uint32_t max_input_frames) {
+    memset(resampler, 0, sizeof(Resampler));
+    if (channels == 0 || channels > RESAMPLER_MAX_CHANNELS || in_rate < RESAMPLER_MIN_RATE ||
+        in_rate > RESAMPLER_MAX_RATE || out_rate < RESAMPLER_MIN_RATE || out_rate > RESAMPLER_MAX_RATE ||
+        max_input_frames == 0) {
+        return false;
+    }
+    resampler->quality = quality;
+    resampler->channels = channels;
+    resampler->in_rate = in_rate;
+    resampler->out_rate = out_rate;
+    resampler->step = ((uint64_t)in_rate << 32) / out_rate;
+
+    // Downsampling lowers the cutoff, so the kernel widens to keep its
+    // number of zero crossings
+    if (quality == RESAMPLER_SINC) {
+        uint32_t half = RESAMPLER_SINC_HALF_TAPS;
+        if (out_rate < in_rate) {
+            half = (uint32_t)ceil((double)RESAMPLER_SINC_HALF_TAPS * in_rate / out_rate);
+        }
+        resampler->half = half < RESAMPLER_SINC_MAX_HALF_TAPS ? half : RESAMPLER_SINC_MAX_HALF_TAPS;
+    } else {
+        resampler->half = 1;
+    }
+    resampler->taps = 2 * resampler->half;
+
+    // Room for a full block on top of the support the next output needs
+    uint32_t step_frames = (uint32_t)(resampler->step >> 32) + 1;
+    resampler->capacity_frames = max_input_frames + resampler->taps + step_frames;
+    resampler->history = (float*)malloc(sizeof(float) * resampler->capacity_frames * channels);
+    if (!resampler->history || (quality == RESAMPLER_SINC && !build_table(resampler))) {
+        resampler_destroy(resampler);
+        return false;
+    }
+    resampler_reset(resampler);
+    return true;
+}
+
+void resampler_destroy(Resampler* resampler) {
+    free(resampler->table);
+    free(resampler->history);
+    memset(resampler, 0, sizeof(Resampler));
+}
+
+void resampler_reset(Resampler* resampler) {
+    // The frames before the first input read as silence
+    uint32_t lead = resampler->half - 1;
+    memset(resampler->history, 0, sizeof(float) * lead * resampler->channels);
+    resampler->history_frames = lead;
+    resampler->position = (uint64_t)lead << 32;
+}
+
+// ============================================================================
+// PROCESSING
+// ============================================================================
+
+uint32_t resampler_max_output(const Resampler* resampler, uint32_t input_frames) {
+    uint64_t held = (uint64_t)resampler->history_frames + input_frames;
+    if (held <= resampler->half) {
+        return 0;
+    }
+    uint64_t limit = (held - resampler->half) << 32;
+    if (limit <= resampler->position) {
+        return 0;
+    }
+    return (uint32_t)((limit - resampler->position + resampler->step - 1) / resampler->step);
+}
+
+uint32_t resampler_input_needed(const Resampler* resampler, uint32_t output_frames) {
+    if (output_frames == 0) {
+        return 0;
+    }
+    uint64_t last = resampler->position + (uint64_t)(output_frames - 1) * resampler->step;
+    uint64_t needed = (last >> 32) + resampler->half + 1;
+    return needed > resampler->history_frames ? (uint32_t)(needed - resampler->history_frames) : 0;
+}
+
+uint64_t resampler_output_length(uint64_t input_frames, uint32_t in_rate, uint32_t out_rate) {
+    return (input_frames * out_rate + in_rate - 1) / in_rate;
+}
+
+static void produce_linear(const Resampler* resampler, const float* frames, uint32_t fraction, float* out) {
+    float t = (float)fraction * (1.0f / 4294967296.0f);
+    for (uint32_t c = 0; c < resampler->channels; c++) {
+        float a = frames[c];
+        float b = frames[resampler->channels + c];
+        out[c] = a + (b - a) * t;
+    }
+}
+
+static void produce_sinc(const Resampler* resampler, const float* frames, uint32_t fraction, float* out) {
+    uint32_t phase = fraction >> (32 - RESAMPLER_PHASE_BITS);
+    float blend = (float)((fraction >> (32 - RESAMPLER_PHASE_BITS - RESAMPLER_BLEND_BITS)) &
+                          ((1u << RESAMPLER_BLEND_BITS) - 1)) *
+                  (1.0f / (float)(1u << RESAMPLER_BLEND_BITS));
+    const float* row0 = resampler->table + (size_t)phase * resampler->taps;
+    const float* row1 = row0 + resampler->taps;
+    uint32_t channels = resampler->channels;
+    for (uint32_t c = 0; c < channels; c++) {
+        float acc0 = 0.0f;
+        float acc1 = 0.0f;
+        for (uint32_t k = 0; k < resampler->taps; k++) {
+            float x = frames[k * channels + c];
+            acc0 += row0[k] * x;
+            acc1 += row1[k] * x;
+        }
+        out[c] = acc0 + (acc1 - acc0) * blend;
+    }
+}
+
+uint32_t resampler_process(Resampler* resampler, const float* input, uint32_t* input_frames, float* output,
+                           uint32_t max_output) {
+    uint32_t channels = resampler->channels;
+    uint32_t room = resampler->capacity_frames - resampler->history_frames;
+    uint32_t take = *input_frames < room ? *input_frames : room;
+    float* tail = resampler->history + (size_t)resampler->history_frames * channels;
+    if (input) {
+        memcpy(tail, input, sizeof(float) * take * channels);
+    } else {
+        memset(tail, 0, sizeof(float) * take * channels);
+    }
+    resampler->history_frames += take;
+    *input_frames = take;
+
+    // Every output whose support [i - half + 1, i + half] is held
+    uint32_t written = 0;
+    uint64_t limit = resampler->history_frames > resampler->half
+                         ? (uint64_t)(resampler->history_frames - resampler->half) << 32
+                         : 0;
+    while (written < max_output && resampler->position < limit) {
+        uint32_t index = (uint32_t)(resampler->position >> 32);
+        uint32_t fraction = (uint32_t)resampler->position;
+        const float* frames = resampler->history + (size_t)(index - resampler->half + 1) * channels;
+        float* out = output + (size_t)written * channels;
+        if (resampler->quality == RESAMPLER_SINC) {
+            produce_sinc(resampler, frames, fraction, out);
+        } else {
+            produce_linear(resampler, frames, fraction, out);
+        }
+        resampler->position += resampler->step;
+        written++;
+    }
+
+    // Drop the frames no later output reads
+    uint32_t first = (uint32_t)(resampler->position >> 32) - (resampler->half - 1);
+    if (first > resampler->history_frames) {
+        first = resampler->history_frames;
+    }
+    if (first > 0) {
+        resampler->history_frames -= first;
+        memmove(resampler->history, resampler->history + (size_t)first * channels,
+                sizeof(float) * resampler->history_frames * channels);
+        resampler->position -= (uint64_t)first << 32;
+    }
+    return written;
+}
@@ -0,0 +1,84 @@
+// resampler.h - Streaming sample-rate conversion
+// Converts interleaved float frames between two fixed rates. Two quality
+// tiers share one streaming model:
+//   RESAMPLER_LINEAR  two-point interpolation, no anti-aliasing: cheap,
+//                     for monitoring through a device at another rate
+//   RESAMPLER_SINC    Kaiser-windowed sinc from a polyphase table (with
+//                     linear interpolation between phases), low-passed
+//                     below the lower of the two Nyquist rates: for clip
+//                     import and export
+//
+// Input is appended to a small history and every output frame whose filter
+// support is available is produced, so a stream can be fed in blocks of
+// any size. Output frame n sits at input position n * in_rate / out_rate
+// with no added delay; the filter looks resampler_latency() input frames
+// ahead, which is the latency a live stream pays. Everything is allocated
+// by resampler_init (control thread); processing never allocates and owns
+// no locks, so it may run on the audio thread.
+#pragma once
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define RESAMPLER_MAX_CHANNELS 2
+#define RESAMPLER_SINC_HALF_TAPS 16     // Input frames each side of an output at unity ratio
+#define RESAMPLER_SINC_MAX_HALF_TAPS 256 // Cap when the cutoff drops for large downsampling ratios
+#define RESAMPLER_SINC_PHASES 256       // Fractional positions in the table
+#define RESAMPLER_SINC_CUTOFF 0.93f     // Passband edge as a fraction of the lower Nyquist
+#define RESAMPLER_SINC_KAISER_BETA 8.6f // ~85 dB stopband
+#define RESAMPLER_MIN_RATE 8000
+#define RESAMPLER_MAX_RATE 384000
+
+typedef enum {
+    RESAMPLER_LINEAR = 0,
+    RESAMPLER_SINC
+} ResamplerQuality;
+
+typedef struct {
+    ResamplerQuality quality;
+    uint32_t channels;
+    uint32_t in_rate;
+    uint32_t out_rate;
+    uint64_t step;              // Input frames per output frame, 32.32 fixed point
+    uint64_t position;          // Next output's input position in `history`, 32.32
+    uint32_t half;              // Input frames each side of an output's position
+    uint32_t taps;              // 2 * half
+    float* table;               // [RESAMPLER_SINC_PHASES + 1][taps], SINC only
+    float* history;             // Interleaved input frames still needed
+    uint32_t history_frames;    // Frames held
+    uint32_t capacity_frames;   // Frames `history` can hold
+} Resampler;
+
+// Allocate a converter taking up to `max_input_frames` per call. Returns
+// false on bad rates or allocation failure (nothing is left allocated).
+bool resampler_init(Resampler* resampler, uint32_t channels, uint32_t in_rate, uint32_t out_rate,
+                    ResamplerQuality quality, uint32_t max_input_frames);
+
+void resampler_destroy(Resampler* resampler);
+
+// Forget the stream: the next output is input frame 0 of what comes next
+void resampler_reset(Resampler* resampler);
+
+// Input frames the filter looks ahead of each output
+static inline uint32_t resampler_latency(const Resampler* resampler) {
+    return resampler->half;
+}
+
+// Output frames `input_frames` more input can produce at most
+uint32_t resampler_max_output(const Resampler* resampler, uint32_t input_frames);
+
+// Input frames still missing before `output_frames` frames can be produced
+uint32_t resampler_input_needed(const Resampler* resampler, uint32_t output_frames);
+
+// Output frames `input_frames` input frames convert to in total
+uint64_t resampler_output_length(uint64_t input_frames, uint32_t in_rate, uint32_t out_rate);
+
+// Append `*input_frames` frames of `input` (NULL: silence), as many as fit,
+// and write up to `max_output` frames. `*input_frames` is set to the frames
+// taken; returns the frames written.
+uint32_t resampler_process(Resampler* resampler, const float* input, uint32_t* input_frames, float* output,
+                           uint32_t max_output);
+
+#endif // RESAMPLER_H
@@ -0,0 +1,209 @@
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE         // fseeko
+#endif
+#if !defined(_WIN32)
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include "session.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#define session_fseek _fseeki64
+#define session_ftell _ftelli64
+#else
+#define session_fseek fseeko
+#define session_ftell ftello
+#endif
+
+#define SESSION_ALIGNMENT 8
+
+// ============================================================================
+// LAYOUT
+// ============================================================================
+
+static uint64_t align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static void layout(SessionHeader* header) {
+    header->header_bytes = sizeof(SessionHeader);
+    header->track_bytes = sizeof(SessionTrack);
+    header->bus_bytes = sizeof(SessionBus);
+    header->point_bytes = sizeof(SessionPoint);
+    header->tracks_offset = align_up(sizeof(SessionHeader), SESSION_ALIGNMENT);
+    header->buses_offset = align_up(header->tracks_offset + (uint64_t)sizeof(SessionTrack) * header->track_count,
+                                    SESSION_ALIGNMENT);
+    header->points_offset = align_up(header->buses_offset + (uint64_t)sizeof(SessionBus) * header->bus_count,
+                                     SESSION_ALIGNMENT);
+    header->strings_offset = align_up(header->points_offset + (uint64_t)sizeof(SessionPoint) * header->point_count,
+                                      SESSION_ALIGNMENT);
+    header->file_bytes = align_up(header->strings_offset + header->string_bytes, SESSION_ALIGNMENT);
+}
+
+bool session_image_init(SessionImage* image, uint32_t track_count, uint32_t bus_count, uint32_t point_count,
+                        uint32_t string_bytes) {
+    memset(image, 0, sizeof(SessionImage));
+    SessionHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SESSION_MAGIC, 4);
+    header.version = SESSION_VERSION;
+    header.track_count = track_count;
+    header.bus_count = bus_count;
+    header.point_count = point_count;
+    header.string_bytes = string_bytes;
+    layout(&header);
+
+    image->data = (uint8_t*)calloc(1, (size_t)header.file_bytes);
+    if (!image->data) {
+        return false;
+    }
+    image->size = (size_t)header.file_bytes;
+    memcpy(image->data, &header, sizeof(header));
+    return true;
+}
+
+void session_image_free(SessionImage* image) {
+    free(image->data);
+    memset(image, 0, sizeof(SessionImage));
+}
+
+// ============================================================================
+// READING
+// ============================================================================
+
+static bool lane_valid(const SessionHeader* header, SessionLane lane) {
+    return lane.first_point <= header->point_count && lane.point_count <= header->point_count - lane.first_point;
+}
+
+static bool string_valid(const SessionHeader* header, uint32_t offset) {
+    return offset == SESSION_NO_STRING || offset < header->string_bytes;
+}
+
+static bool chain_valid(const SessionHeader* header, const SessionEffect* effects, uint32_t effect_count) {
+    if (effect_count > MAX_EFFECTS_PER_TRACK) {
+        return false;
+    }
+    for (uint32_t e = 0; e < effect_count; e++) {
+        for (int p = 0; p < EFFECT_MAX_PARAMS; p++) {
+            if (!lane_valid(header, effects[e].lanes[p])) {
+                return false;
+            }
+        }
+        if (!string_valid(header, effects[e].plugin_path) || !string_valid(header, effects[e].plugin_id)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Structure only: section bounds, lane ranges and string offsets. What the
+// records mean (bus indices, effect types) is the engine's to check.
+static bool validate(const SessionImage* image) {
+    if (image->size < sizeof(SessionHeader)) {
+        return false;
+    }
+    const SessionHeader* header = session_header(image);
+    if (memcmp(header->magic, SESSION_MAGIC, 4) != 0 || header->version != SESSION_VERSION ||
+        header->header_bytes != sizeof(SessionHeader) || header->track_bytes != sizeof(SessionTrack) ||
+        header->bus_bytes != sizeof(SessionBus) || header->point_bytes != sizeof(SessionPoint)) {
+        return false;
+    }
+
+    // The layout is a function of the counts, so recomputing it checks every
+    // offset at once
+    SessionHeader expected = *header;
+    layout(&expected);
+    if (expected.tracks_offset != header->tracks_offset || expected.buses_offset != header->buses_offset ||
+        expected.points_offset != header->points_offset || expected.strings_offset != header->strings_offset ||
+        expected.file_bytes != header->file_bytes || header->file_bytes != image->size) {
+        return false;
+    }
+
+    // Every string ends inside the blob if the blob itself ends with one
+    const char* strings = session_strings(image);
+    if (header->string_bytes > 0 && strings[header->string_bytes - 1] != '\0') {
+        return false;
+    }
+
+    const SessionTrack* tracks = session_tracks(image);
+    for (uint32_t t = 0; t < header->track_count; t++) {
+        const SessionTrack* track = &tracks[t];
+        if (!string_valid(header, track->clip_path) ||
+            !lane_valid(header, track->volume_lane) || !lane_valid(header, track->pan_lane) ||
+            !chain_valid(header, track->effects, track->effect_count)) {
+            return false;
+        }
+    }
+    const SessionBus* buses = session_buses(image);
+    for (uint32_t b = 0; b < header->bus_count; b++) {
+        if (!chain_valid(header, buses[b].effects, buses[b].effect_count)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool session_image_read(SessionImage* image, const char* path) {
+    memset(image, 0, sizeof(SessionImage));
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+
+    // One read of the whole file: sessions are small next to their clips
+    int64_t size = -1;
+    if (session_fseek(file, 0, SEEK_END) == 0) {
+        size = (int64_t)session_ftell(file);
+    }
+    bool ok = size >= (int64_t)sizeof(SessionHeader) && session_fseek(file, 0, SEEK_SET) == 0;
+    image->data = ok ? (uint8_t*)malloc((size_t)size) : NULL;
+    image->size = image->data ? (size_t)size : 0;
+    ok = ok && image->data && fread(image->data, 1, image->size, file) == image->size;
+    fclose(file);
+
+    if (!ok || !validate(image)) {
+        session_image_free(image);
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// WRITING
+// ============================================================================
+
+// Put the finished temp file in place of the session in one step, so a crash
+// leaves either the old file or the new one. The old file is left alone if
+// this fails.
+static bool replace_file(const char* temp_path, const char* path) {
+#ifdef _WIN32
+    return MoveFileExA(temp_path, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(temp_path, path) == 0;
+#endif
+}
+
+bool session_image_write(const SessionImage* image, const char* path) {
+    char temp_path[1024];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    FILE* file = fopen(temp_path, "wb");
+    if (!file) {
+        return false;
+    }
+
+    // Everything but the magic, then the magic once the rest is out
+    bool ok = session_fseek(file, 4, SEEK_SET) == 0 &&
+              fwrite(image->data + 4, 1, image->size - 4, file) == image->size - 4 && fflush(file) == 0;
+    ok = ok && session_fseek(file, 0, SEEK_SET) == 0 && fwrite(image->data, 1, 4, file) == 4;
+    ok = fclose(file) == 0 && ok;
+
+    ok = ok && replace_file(temp_path, path);
+    if (!ok) {
+        remove(temp_path);
+    }
+    return ok;
+}
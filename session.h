@@ -0,0 +1,158 @@
+// session.h - Binary session files
+// A session file is the engine's model as fixed-size records: tracks and
+// buses with their routing, mix controls and effect chains (in chain order),
+// automation breakpoints for every lane in one shared array, and the clip
+// source and plugin paths in a string blob. Records only hold fixed-width fields, so a
+// file is loaded with a single read of the whole image and its records are
+// used in place once the offsets have been validated; nothing is parsed
+// field by field. Files are little-endian (every platform we build for).
+//
+// Layout (all offsets from the start of the file, sections 8-byte aligned):
+//   SessionHeader | SessionTrack[track_count] | SessionBus[bus_count] |
+//   SessionPoint[point_count] | strings[string_bytes]
+//
+// The record layouts follow MAX_BUSES, MAX_EFFECTS_PER_TRACK and
+// EFFECT_MAX_PARAMS; changing one of them means bumping SESSION_VERSION.
+#pragma once
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "automation.h"
+#include "bus.h"
+#include "effects.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SESSION_MAGIC "ADWS"
+#define SESSION_VERSION 3
+#define SESSION_EXTENSION ".adws"
+#define SESSION_NO_STRING UINT32_MAX    // String offset meaning "none"
+
+// SessionTrack::flags
+#define SESSION_TRACK_INSTRUMENT (1u << 0)
+#define SESSION_TRACK_PLAYING (1u << 1)
+#define SESSION_TRACK_MUTE (1u << 2)
+#define SESSION_TRACK_SOLO (1u << 3)
+#define SESSION_TRACK_ARMED (1u << 4)
+#define SESSION_TRACK_INPUT (1u << 5)
+#define SESSION_TRACK_CLIP_LOOP (1u << 6)
+
+typedef struct {
+    char magic[4];              // Written last, so a torn file never validates
+    uint32_t version;
+    uint32_t header_bytes;      // Record sizes, checked against this build's
+    uint32_t track_bytes;
+    uint32_t bus_bytes;
+    uint32_t point_bytes;
+    uint32_t sample_rate;
+    float master_volume;
+    uint32_t track_count;
+    uint32_t bus_count;
+    uint32_t point_count;
+    uint32_t string_bytes;
+    uint64_t tracks_offset;
+    uint64_t buses_offset;
+    uint64_t points_offset;
+    uint64_t strings_offset;
+    uint64_t file_bytes;
+} SessionHeader;
+
+// A run of breakpoints in the shared point array (point_count 0: no lane)
+typedef struct {
+    uint32_t first_point;
+    uint32_t point_count;
+} SessionLane;
+
+// Breakpoints are stored as the engine's own AutomationPoint, so a lane is
+// built straight from its run of the loaded array
+typedef AutomationPoint SessionPoint;
+
+typedef struct {
+    uint32_t type;              // EffectType
+    uint32_t enabled;
+    uint32_t oversampling;      // 1, 2, 4 or 8 (0 reads as 1)
+    float params[EFFECT_MAX_PARAMS];            // By set_param index
+    SessionLane lanes[EFFECT_MAX_PARAMS];       // Automation by param index
+    uint32_t plugin_path;       // EFFECT_CLAP: offsets into the strings, or SESSION_NO_STRING
+    uint32_t plugin_id;
+} SessionEffect;
+
+typedef struct {
+    char name[64];
+    uint32_t flags;             // SESSION_TRACK_*
+    uint32_t waveform;          // OscWaveform
+    float frequency;
+    float volume;
+    float pan;
+    int32_t output_bus;         // BUS_MASTER or a bus index
+    float send_levels[MAX_BUSES];       // 0: no send
+    uint32_t clip_path;         // Offset into the strings, or SESSION_NO_STRING
+    uint32_t effect_count;
+    SessionLane volume_lane;
+    SessionLane pan_lane;
+    SessionEffect effects[MAX_EFFECTS_PER_TRACK];   // Chain order
+} SessionTrack;
+
+typedef struct {
+    char name[64];
+    uint32_t mute;
+    float volume;
+    int32_t output_bus;         // BUS_MASTER or a bus index
+    uint32_t effect_count;
+    SessionEffect effects[MAX_EFFECTS_PER_TRACK];   // Chain order, no automation
+} SessionBus;
+
+// A whole session file in memory: built by the engine and written in one
+// go, or read in one go and validated
+typedef struct {
+    uint8_t* data;
+    size_t size;
+} SessionImage;
+
+// ============================================================================
+// IMAGES (any one thread per image)
+// ============================================================================
+
+// Allocate a zeroed image with room for the given records and lay out its
+// header. Returns false on allocation failure (the image is left empty).
+bool session_image_init(SessionImage* image, uint32_t track_count, uint32_t bus_count, uint32_t point_count,
+                        uint32_t string_bytes);
+
+void session_image_free(SessionImage* image);
+
+// Read a whole file and check its header, offsets, lanes and strings.
+// Returns false (the image is left empty) if it cannot be read or is not a
+// valid session of this version.
+bool session_image_read(SessionImage* image, const char* path);
+
+// Write the image to a temporary name next to `path` (magic last) and
+// rename it into place, so an interrupted save leaves the previous file.
+bool session_image_write(const SessionImage* image, const char* path);
+
+static inline SessionHeader* session_header(const SessionImage* image) {
+    return (SessionHeader*)image->data;
+}
+
+static inline SessionTrack* session_tracks(const SessionImage* image) {
+    return (SessionTrack*)(image->data + session_header(image)->tracks_offset);
+}
+
+static inline SessionBus* session_buses(const SessionImage* image) {
+    return (SessionBus*)(image->data + session_header(image)->buses_offset);
+}
+
+static inline SessionPoint* session_points(const SessionImage* image) {
+    return (SessionPoint*)(image->data + session_header(image)->points_offset);
+}
+
+static inline char* session_strings(const SessionImage* image) {
+    return (char*)(image->data + session_header(image)->strings_offset);
+}
+
+// A string of a validated image, or NULL for SESSION_NO_STRING
+static inline const char* session_string(const SessionImage* image, uint32_t offset) {
+    return offset == SESSION_NO_STRING ? NULL : session_strings(image) + offset;
+}
+
+#endif // SESSION_H
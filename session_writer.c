@@ -0,0 +1,145 @@
+#include "session_writer.h"
+#include "engine_log.h"
+#include <stdio.h>
+#include <string.h>
+
+// ============================================================================
+// WRITER THREAD
+// ============================================================================
+
+// Take the next pending image, if any, marking its slot as being written
+static SessionWriterSlot* take_pending(SessionWriter* writer, SessionImage* image) {
+    SessionWriterSlot* taken = NULL;
+    ma_mutex_lock(&writer->lock);
+    for (int i = 0; i < SESSION_WRITER_MAX_PATHS; i++) {
+        SessionWriterSlot* slot = &writer->slots[i];
+        if (slot->image.data && !slot->writing) {
+            *image = slot->image;
+            memset(&slot->image, 0, sizeof(SessionImage));
+            slot->writing = true;
+            taken = slot;
+            break;
+        }
+    }
+    ma_mutex_unlock(&writer->lock);
+    return taken;
+}
+
+// Write one pending image. Returns false if there was none.
+static bool write_next(SessionWriter* writer) {
+    SessionImage image;
+    SessionWriterSlot* slot = take_pending(writer, &image);
+    if (!slot) {
+        return false;
+    }
+
+    // Only this thread changes the path of a slot that is being written
+    bool ok = session_image_write(&image, slot->path);
+    session_image_free(&image);
+    atomic_fetch_add_explicit(ok ? &writer->written : &writer->failed, 1, memory_order_relaxed);
+    if (!ok) {
+        engine_log(ENGINE_LOG_WARNING, "[session] Failed to write session: %s", slot->path);
+    }
+
+    ma_mutex_lock(&writer->lock);
+    slot->writing = false;
+    ma_mutex_unlock(&writer->lock);
+    return true;
+}
+
+static void writer_main(void* user_data) {
+    SessionWriter* writer = (SessionWriter*)user_data;
+    while (atomic_load(&writer->running)) {
+        if (!write_next(writer)) {
+            engine_thread_sleep_ms(SESSION_WRITER_POLL_MS);
+        }
+    }
+}
+
+bool session_writer_start(SessionWriter* writer) {
+    memset(writer, 0, sizeof(SessionWriter));
+    if (ma_mutex_init(&writer->lock) != MA_SUCCESS) {
+        return false;
+    }
+    atomic_store(&writer->running, true);
+    if (!engine_thread_start(&writer->thread, writer_main, writer, ENGINE_THREAD_PRIORITY_LOW, -1)) {
+        atomic_store(&writer->running, false);
+        ma_mutex_uninit(&writer->lock);
+        return false;
+    }
+    writer->started = true;
+    return true;
+}
+
+void session_writer_stop(SessionWriter* writer) {
+    if (!writer->started) {
+        return;
+    }
+    atomic_store(&writer->running, false);
+    engine_thread_join(&writer->thread);
+
+    // Nothing writes any more: finish here what was still pending
+    while (write_next(writer)) {
+    }
+    ma_mutex_uninit(&writer->lock);
+    writer->started = false;
+}
+
+// ============================================================================
+// IMAGES
+// ============================================================================
+
+bool session_writer_submit(SessionWriter* writer, SessionImage* image, const char* path) {
+    if (!writer->started) {
+        session_image_free(image);
+        return false;
+    }
+
+    // The slot already holding this path, else a free one
+    SessionImage replaced = {0};
+    bool queued = false;
+    ma_mutex_lock(&writer->lock);
+    SessionWriterSlot* target = NULL;
+    for (int i = 0; i < SESSION_WRITER_MAX_PATHS && !target; i++) {
+        SessionWriterSlot* slot = &writer->slots[i];
+        if ((slot->image.data || slot->writing) && strcmp(slot->path, path) == 0) {
+            target = slot;
+        }
+    }
+    for (int i = 0; i < SESSION_WRITER_MAX_PATHS && !target; i++) {
+        SessionWriterSlot* slot = &writer->slots[i];
+        if (!slot->image.data && !slot->writing) {
+            snprintf(slot->path, sizeof(slot->path), "%s", path);
+            target = slot;
+        }
+    }
+    if (target) {
+        replaced = target->image;
+        target->image = *image;
+        queued = true;
+    }
+    ma_mutex_unlock(&writer->lock);
+
+    // Freed outside the lock: the writer never waits on it
+    session_image_free(&replaced);
+    if (!queued) {
+        session_image_free(image);
+    }
+    memset(image, 0, sizeof(SessionImage));
+    return queued;
+}
+
+void session_writer_flush(SessionWriter* writer) {
+    while (writer->started) {
+        bool pending = false;
+        ma_mutex_lock(&writer->lock);
+        for (int i = 0; i < SESSION_WRITER_MAX_PATHS; i++) {
+            pending = pending || writer->slots[i].image.data || writer->slots[i].writing;
+        }
+        ma_mutex_unlock(&writer->lock);
+        if (!pending) {
+            break;
+        }
+        engine_thread_sleep_ms(1);
+    }
+}
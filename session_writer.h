@@ -0,0 +1,61 @@
+// session_writer.h - Session files written by a background thread
+// The control thread captures a session image (audio_engine_capture_session:
+// a copy of the model, no I/O) and hands it over; the writer thread owns it
+// from then on and writes it with session_image_write. The live model is
+// never locked or shared with the writer, and handing over is a pointer
+// move under a lock the writer only takes to pick up the next image, never
+// while writing, so saves and autosaves never wait on the disk. A newer
+// image for a path replaces one that has not been written yet.
+#pragma once
+#ifndef SESSION_WRITER_H
+#define SESSION_WRITER_H
+
+#include "engine_thread.h"
+#include "session.h"
+#include "vendor/miniaudio/miniaudio.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SESSION_WRITER_MAX_PATHS 4      // Files with an image in flight at once
+#define SESSION_WRITER_POLL_MS 10       // Writer wake-up interval
+
+typedef struct {
+    char path[512];
+    SessionImage image;         // Next image for `path` (data NULL: none)
+    bool writing;               // The writer is writing an earlier one
+} SessionWriterSlot;
+
+typedef struct {
+    ma_mutex lock;              // Guards the slots (control <-> writer)
+    SessionWriterSlot slots[SESSION_WRITER_MAX_PATHS];
+    atomic_uint_fast64_t written;       // Files written
+    atomic_uint_fast64_t failed;        // Writes that failed
+    atomic_bool running;
+    bool started;
+    EngineThread thread;
+} SessionWriter;
+
+// ============================================================================
+// WRITER THREAD (control thread)
+// ============================================================================
+
+bool session_writer_start(SessionWriter* writer);
+
+// Write every image still pending, then stop the thread
+void session_writer_stop(SessionWriter* writer);
+
+// ============================================================================
+// IMAGES (control thread)
+// ============================================================================
+
+// Hand `image` over to be written to `path`; the writer takes ownership and
+// `image` is left empty, whatever the result. Returns false (the image is
+// freed) if the writer is not running or SESSION_WRITER_MAX_PATHS other
+// files are still in flight.
+bool session_writer_submit(SessionWriter* writer, SessionImage* image, const char* path);
+
+// Wait until every submitted image has been written (tests, before exit)
+void session_writer_flush(SessionWriter* writer);
+
+#endif // SESSION_WRITER_H
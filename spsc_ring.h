@@ -0,0 +1,131 @@
+// spsc_ring.h - Lock-free single-producer/single-consumer ring buffer
+// Fixed-size elements, power-of-two capacity, caller-provided storage.
+// One thread may push, one (other) thread may pop. No locks, no allocation,
+// safe to use from the real-time audio thread on either side.
+#pragma once
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#define SPSC_CACHE_LINE 64
+
+typedef struct {
+    // Producer side (written by the pushing thread only)
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t write_pos;
+    size_t cached_read_pos;     // Producer's last view of read_pos
+
+    // Consumer side (written by the popping thread only)
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t read_pos;
+    size_t cached_write_pos;    // Consumer's last view of write_pos
+
+    // Immutable after init
+    _Alignas(SPSC_CACHE_LINE) unsigned char* data;
+    size_t element_size;
+    size_t capacity;            // Power of two
+    size_t mask;
+} SpscRing;
+
+// Initialize ring over caller-owned storage of capacity * element_size bytes.
+// Returns false if capacity is not a power of two.
+static inline bool spsc_ring_init(SpscRing* ring, void* storage, size_t element_size, size_t capacity) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        return false;
+    }
+
+    ring->data = (unsigned char*)storage;
+    ring->element_size = element_size;
+    ring->capacity = capacity;
+    ring->mask = capacity - 1;
+    ring->cached_read_pos = 0;
+    ring->cached_write_pos = 0;
+    atomic_store_explicit(&ring->write_pos, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->read_pos, 0, memory_order_relaxed);
+    return true;
+}
+
+// Producer: copy one element in. Returns false if the ring is full.
+static inline bool spsc_ring_push(SpscRing* ring, const void* element) {
+    size_t write = atomic_load_explicit(&ring->write_pos, memory_order_relaxed);
+
+    if (write - ring->cached_read_pos >= ring->capacity) {
+        ring->cached_read_pos = atomic_load_explicit(&ring->read_pos, memory_order_acquire);
+        if (write - ring->cached_read_pos >= ring->capacity) {
+            return false;
+        }
+    }
+
+    memcpy(ring->data + (write & ring->mask) * ring->element_size, element, ring->element_size);
+    atomic_store_explicit(&ring->write_pos, write + 1, memory_order_release);
+    return true;
+}
+
+// Producer: the next free slot, to be filled in place and published with
+// spsc_ring_commit_push (saves the copy through a temporary for large
+// elements). Returns NULL if the ring is full.
+static inline void* spsc_ring_acquire_push(SpscRing* ring) {
+    size_t write = atomic_load_explicit(&ring->write_pos, memory_order_relaxed);
+
+    if (write - ring->cached_read_pos >= ring->capacity) {
+        ring->cached_read_pos = atomic_load_explicit(&ring->read_pos, memory_order_acquire);
+        if (write - ring->cached_read_pos >= ring->capacity) {
+            return NULL;
+        }
+    }
+    return ring->data + (write & ring->mask) * ring->element_size;
+}
+
+// Producer: publish the slot returned by spsc_ring_acquire_push
+static inline void spsc_ring_commit_push(SpscRing* ring) {
+    size_t write = atomic_load_explicit(&ring->write_pos, memory_order_relaxed);
+    atomic_store_explicit(&ring->write_pos, write + 1, memory_order_release);
+}
+
+// Consumer: copy one element out. Returns false if the ring is empty.
+static inline bool spsc_ring_pop(SpscRing* ring, void* element) {
+    size_t read = atomic_load_explicit(&ring->read_pos, memory_order_relaxed);
+
+    if (read == ring->cached_write_pos) {
+        ring->cached_write_pos = atomic_load_explicit(&ring->write_pos, memory_order_acquire);
+        if (read == ring->cached_write_pos) {
+            return false;
+        }
+    }
+
+    memcpy(element, ring->data + (read & ring->mask) * ring->element_size, ring->element_size);
+    atomic_store_explicit(&ring->read_pos, read + 1, memory_order_release);
+    return true;
+}
+
+// Consumer: the oldest element, left in the ring (skip it once done), or
+// NULL if the ring is empty
+static inline const void* spsc_ring_peek(SpscRing* ring) {
+    size_t read = atomic_load_explicit(&ring->read_pos, memory_order_relaxed);
+
+    if (read == ring->cached_write_pos) {
+        ring->cached_write_pos = atomic_load_explicit(&ring->write_pos, memory_order_acquire);
+        if (read == ring->cached_write_pos) {
+            return NULL;
+        }
+    }
+    return ring->data + (read & ring->mask) * ring->element_size;
+}
+
+// Consumer: drop the element spsc_ring_peek() returned
+static inline void spsc_ring_skip(SpscRing* ring) {
+    size_t read = atomic_load_explicit(&ring->read_pos, memory_order_relaxed);
+    atomic_store_explicit(&ring->read_pos, read + 1, memory_order_release);
+}
+
+// Approximate number of queued elements (exact when called from either end
+// while the other end is idle)
+static inline size_t spsc_ring_count(SpscRing* ring) {
+    size_t write = atomic_load_explicit(&ring->write_pos, memory_order_acquire);
+    size_t read = atomic_load_explicit(&ring->read_pos, memory_order_acquire);
+    return write - read;
+}
+
+#endif // SPSC_RING_H
@@ -0,0 +1,264 @@
+// bench_engine.c - Throughput benchmark for the real engine render path
+// Drives audio_engine_process_block (the same engine_process the device
+// callback runs) headless over a matrix of backends, track counts, effect
+// chains and block sizes, and reports ns/frame, the share of the real-time
+// budget used and per-block p50/p99/p999/max times. `--json PATH` writes
+// the results for diffing between builds.
+//
+// Links only libairdaw_engine, like test_engine_offline.c.
+#include "../audio_engine.h"
+#include "../engine_log.h"
+#include "../engine_thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// BENCH CONSTANTS
+// ============================================================================
+
+#define BENCH_DEFAULT_SECONDS 5.0       // Audio rendered per case
+#define BENCH_WARMUP_SECONDS 0.25       // Rendered untimed first (ramps, caches)
+#define BENCH_MAX_CHAIN 4
+
+typedef struct {
+    const char* name;
+    int effect_count;
+    EffectType effects[BENCH_MAX_CHAIN];
+} BenchChain;
+
+static const BenchChain bench_chains[] = {
+    {"dry", 0, {EFFECT_NONE}},
+    {"filters", 3, {EFFECT_LOWPASS, EFFECT_HIGHPASS, EFFECT_GAIN}},
+    {"heavy", 4, {EFFECT_LOWPASS, EFFECT_HIGHPASS, EFFECT_DELAY, EFFECT_REVERB}},
+};
+
+static const EngineBackend bench_backends[] = {ENGINE_BACKEND_CALLBACK, ENGINE_BACKEND_NODE_GRAPH};
+static const int bench_track_counts[] = {1, 16, 256};
+static const uint32_t bench_block_sizes[] = {64, 256, 1024};
+
+#define BENCH_COUNT(array) ((int)(sizeof(array) / sizeof((array)[0])))
+
+typedef struct {
+    EngineBackend backend;
+    int track_count;
+    const BenchChain* chain;
+    uint32_t block_frames;
+} BenchCase;
+
+typedef struct {
+    double ns_per_frame;
+    double budget_percent;      // Total render time over the audio's duration
+    double p50_us;
+    double p99_us;
+    double p999_us;
+    double max_us;
+    int overruns;               // Blocks slower than their own duration
+    int block_count;
+} BenchResult;
+
+typedef struct {
+    double seconds;
+    int workers;
+    const char* json_path;
+} BenchOptions;
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static const char* backend_name(EngineBackend backend) {
+    return backend == ENGINE_BACKEND_NODE_GRAPH ? "nodes" : "callback";
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// Nearest-rank percentile of sorted block times, in microseconds
+static double percentile_us(const uint64_t* sorted, int count, double fraction) {
+    int rank = (int)(fraction * (double)count + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return (double)sorted[rank - 1] / 1000.0;
+}
+
+static bool setup_session(AudioEngine* engine, const BenchCase* bench, int workers) {
+    AudioEngineConfig config = audio_engine_config_init(ENGINE_LATENCY_DEFAULT);
+    config.period_frames = bench->block_frames;
+    config.offline_only = true;
+    config.render_workers = workers;
+    config.backend = bench->backend;
+    memset(engine, 0, sizeof(AudioEngine));
+    if (!audio_engine_init_with_config(engine, &config)) {
+        return false;
+    }
+    for (int t = 0; t < bench->track_count; t++) {
+        char name[32];
+        snprintf(name, sizeof(name), "Track %d", t + 1);
+        if (audio_engine_add_track(engine, name, 110.0F * (float)(t + 1)) < 0) {
+            return false;
+        }
+        for (int e = 0; e < bench->chain->effect_count; e++) {
+            if (!audio_engine_add_effect(engine, t, bench->chain->effects[e])) {
+                return false;
+            }
+        }
+        audio_engine_set_track_playing(engine, t, true);
+    }
+    audio_engine_set_playing(engine, true);
+    return true;
+}
+
+// ============================================================================
+// BENCHMARK
+// ============================================================================
+
+static bool run_case(const BenchCase* bench, const BenchOptions* options, BenchResult* result) {
+    static AudioEngine engine;
+    uint32_t block = bench->block_frames;
+    int block_count = (int)(options->seconds * SAMPLE_RATE / block);
+    int warmup_count = (int)(BENCH_WARMUP_SECONDS * SAMPLE_RATE / block);
+    if (block_count < 1) block_count = 1;
+
+    float* out = (float*)malloc(sizeof(float) * block * CHANNELS);
+    uint64_t* times = (uint64_t*)malloc(sizeof(uint64_t) * (size_t)block_count);
+    bool ok = out && times && setup_session(&engine, bench, options->workers);
+
+    for (int i = 0; ok && i < warmup_count; i++) {
+        ok = audio_engine_process_block(&engine, out, block);
+    }
+    audio_engine_collect_garbage(&engine);
+
+    uint64_t budget_ns = (uint64_t)block * 1000000000ULL / SAMPLE_RATE;
+    uint64_t total_ns = 0;
+    int overruns = 0;
+    for (int i = 0; ok && i < block_count; i++) {
+        uint64_t start_ns = engine_thread_time_ns();
+        ok = audio_engine_process_block(&engine, out, block);
+        times[i] = engine_thread_time_ns() - start_ns;
+        total_ns += times[i];
+        overruns += times[i] > budget_ns;
+    }
+    audio_engine_shutdown(&engine);
+
+    if (ok) {
+        qsort(times, (size_t)block_count, sizeof(uint64_t), compare_u64);
+        double frames = (double)block_count * block;
+        result->ns_per_frame = (double)total_ns / frames;
+        result->budget_percent = 100.0 * (double)total_ns / (frames * 1e9 / SAMPLE_RATE);
+        result->p50_us = percentile_us(times, block_count, 0.50);
+        result->p99_us = percentile_us(times, block_count, 0.99);
+        result->p999_us = percentile_us(times, block_count, 0.999);
+        result->max_us = (double)times[block_count - 1] / 1000.0;
+        result->overruns = overruns;
+        result->block_count = block_count;
+    }
+    free(out);
+    free(times);
+    return ok;
+}
+
+static void write_json(FILE* file, const BenchOptions* options, const BenchCase* cases,
+                       const BenchResult* results, int count) {
+    fprintf(file, "{\n  \"sample_rate\": %d,\n  \"seconds_per_case\": %.2f,\n  \"workers\": %d,\n",
+            SAMPLE_RATE, options->seconds, options->workers);
+    fprintf(file, "  \"cases\": [\n");
+    for (int i = 0; i < count; i++) {
+        const BenchCase* bench = &cases[i];
+        const BenchResult* result = &results[i];
+        fprintf(file,
+                "    {\"backend\": \"%s\", \"tracks\": %d, \"chain\": \"%s\", \"block_frames\": %u, "
+                "\"ns_per_frame\": %.2f, \"budget_percent\": %.3f, \"p50_us\": %.2f, \"p99_us\": %.2f, "
+                "\"p999_us\": %.2f, \"max_us\": %.2f, \"overruns\": %d, \"blocks\": %d}%s\n",
+                backend_name(bench->backend), bench->track_count, bench->chain->name, bench->block_frames,
+                result->ns_per_frame, result->budget_percent, result->p50_us, result->p99_us, result->p999_us,
+                result->max_us, result->overruns, result->block_count, i + 1 < count ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+}
+
+static void print_usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [--seconds S] [--workers N] [--json PATH]\n"
+            "  --seconds S   Audio rendered per case (default %.0f)\n"
+            "  --workers N   Render workers (default -1: one per spare core)\n"
+            "  --json PATH   Also write the results as JSON (- for stdout)\n",
+            program, BENCH_DEFAULT_SECONDS);
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options = {.seconds = BENCH_DEFAULT_SECONDS, .workers = -1, .json_path = NULL};
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            options.seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            options.workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            options.json_path = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (options.seconds <= 0.0) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    // Overrun warnings would interleave with the table; they are counted anyway
+    engine_log_set_level(ENGINE_LOG_ERROR);
+
+    enum {
+        CASE_COUNT = BENCH_COUNT(bench_backends) * BENCH_COUNT(bench_track_counts) *
+                     BENCH_COUNT(bench_chains) * BENCH_COUNT(bench_block_sizes)
+    };
+    static BenchCase cases[CASE_COUNT];
+    static BenchResult results[CASE_COUNT];
+    int count = 0;
+    for (int b = 0; b < BENCH_COUNT(bench_backends); b++) {
+        for (int t = 0; t < BENCH_COUNT(bench_track_counts); t++) {
+            for (int c = 0; c < BENCH_COUNT(bench_chains); c++) {
+                for (int s = 0; s < BENCH_COUNT(bench_block_sizes); s++) {
+                    cases[count++] = (BenchCase){bench_backends[b], bench_track_counts[t], &bench_chains[c],
+                                                 bench_block_sizes[s]};
+                }
+            }
+        }
+    }
+
+    // The table goes to stderr when JSON takes stdout
+    FILE* table = options.json_path && strcmp(options.json_path, "-") == 0 ? stderr : stdout;
+    fprintf(table, "%-9s %6s %-8s %6s %10s %8s %9s %9s %9s %9s %5s\n", "backend", "tracks", "chain", "block",
+            "ns/frame", "budget%", "p50 us", "p99 us", "p999 us", "max us", "over");
+    for (int i = 0; i < count; i++) {
+        if (!run_case(&cases[i], &options, &results[i])) {
+            fprintf(stderr, "Case %d (%s, %d tracks, %s, %u frames) failed to run\n", i,
+                    backend_name(cases[i].backend), cases[i].track_count, cases[i].chain->name,
+                    cases[i].block_frames);
+            return 1;
+        }
+        const BenchResult* result = &results[i];
+        fprintf(table, "%-9s %6d %-8s %6u %10.1f %8.2f %9.1f %9.1f %9.1f %9.1f %5d\n",
+                backend_name(cases[i].backend), cases[i].track_count, cases[i].chain->name, cases[i].block_frames,
+                result->ns_per_frame, result->budget_percent, result->p50_us, result->p99_us, result->p999_us,
+                result->max_us, result->overruns);
+        fflush(table);
+    }
+
+    if (options.json_path) {
+        bool to_stdout = strcmp(options.json_path, "-") == 0;
+        FILE* file = to_stdout ? stdout : fopen(options.json_path, "w");
+        if (!file) {
+            fprintf(stderr, "Cannot write %s\n", options.json_path);
+            return 1;
+        }
+        write_json(file, &options, cases, results, count);
+        if (!to_stdout) {
+            fclose(file);
+        }
+    }
+    return 0;
+}
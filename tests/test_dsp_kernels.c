@@ -0,0 +1,1166 @@
+#define CTEST_MAIN
+#define CTEST_COLOR_OK
+
+// The convolver's tail thread uses miniaudio's semaphore
+#define MINIAUDIO_IMPLEMENTATION
+#define MA_NO_DEVICE_IO
+#include "../vendor/miniaudio/miniaudio.h"
+
+#include "../vendor/ctest/ctest.h"
+#include "../convolver.h"
+#include "../dsp_kernels.h"
+#include "../effects.h"
+#include "../oscillator.h"
+#include "../oversampler.h"
+#include "../resampler.h"
+#include "../voice_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+// ============================================================================
+// TEST CONSTANTS
+// ============================================================================
+
+#define TEST_FRAMES 1027        // Not a multiple of any vector width: exercises tails
+#define TEST_EPSILON 1e-5f
+
+static const EffectCreateInfo create_info = {.sample_rate = 48000.0f};
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+// Deterministic pseudo-random signal in [-1.5, 1.5] (some samples clip)
+static void fill_signal(float* buffer, uint32_t count, uint32_t seed) {
+    uint32_t x = seed * 2654435761u + 1;
+    for (uint32_t i = 0; i < count; i++) {
+        x = x * 1664525u + 1013904223u;
+        buffer[i] = ((float)(x >> 8) / (float)(1u << 24)) * 3.0f - 1.5f;
+    }
+}
+
+static int buffers_match(const float* a, const float* b, uint32_t count, float epsilon) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (fabsf(a[i] - b[i]) > epsilon) {
+            printf("    mismatch at %u: %f vs %f\n", i, a[i], b[i]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// ============================================================================
+// KERNEL SETS AGAINST THE SCALAR REFERENCE
+// ============================================================================
+
+CTEST(dsp_kernels, best_is_available) {
+    const DspKernels* best = dsp_kernels_best();
+    ASSERT_NOT_NULL(best);
+    ASSERT_NOT_NULL(dsp_kernels_get(DSP_KERNELS_SCALAR));
+    printf("    best kernel set: %s\n", best->name);
+}
+
+CTEST(dsp_kernels, gain_and_mix_match_scalar) {
+    const DspKernels* ref = dsp_kernels_get(DSP_KERNELS_SCALAR);
+    static float src[TEST_FRAMES], expected[TEST_FRAMES], actual[TEST_FRAMES];
+
+    for (int set = 0; set < DSP_KERNELS_COUNT; set++) {
+        const DspKernels* k = dsp_kernels_get((DspKernelSet)set);
+        if (!k) continue;
+
+        for (uint32_t frames = 0; frames <= 19; frames++) {
+            fill_signal(src, TEST_FRAMES, 1);
+            fill_signal(expected, TEST_FRAMES, 2);
+            memcpy(actual, expected, sizeof(expected));
+            ref->mix(expected, src, 0.7f, frames);
+            k->mix(actual, src, 0.7f, frames);
+            ASSERT_TRUE(buffers_match(expected, actual, TEST_FRAMES, TEST_EPSILON));
+        }
+
+        fill_signal(expected, TEST_FRAMES, 3);
+        memcpy(actual, expected, sizeof(expected));
+        ref->gain(expected, 0.25f, TEST_FRAMES);
+        k->gain(actual, 0.25f, TEST_FRAMES);
+        ASSERT_TRUE(buffers_match(expected, actual, TEST_FRAMES, TEST_EPSILON));
+    }
+}
+
+// Ramps are computed as start + step * i (not accumulated), so every set
+// lands on the same values and long ramps end exactly where they should
+CTEST(dsp_kernels, gain_ramp_matches_scalar) {
+    const DspKernels* ref = dsp_kernels_get(DSP_KERNELS_SCALAR);
+    static float expected[TEST_FRAMES], actual[TEST_FRAMES];
+
+    for (int set = 0; set < DSP_KERNELS_COUNT; set++) {
+        const DspKernels* k = dsp_kernels_get((DspKernelSet)set);
+        if (!k) continue;
+
+        for (uint32_t frames = 0; frames <= 19; frames++) {
+            fill_signal(expected, TEST_FRAMES, 4);
+            memcpy(actual, expected, sizeof(expected));
+            ref->gain_ramp(expected, 0.2f, 0.03f, frames);
+            k->gain_ramp(actual, 0.2f, 0.03f, frames);
+            ASSERT_TRUE(buffers_match(expected, actual, TEST_FRAMES, TEST_EPSILON));
+        }
+
+        for (uint32_t i = 0; i < TEST_FRAMES; i++) actual[i] = 1.0f;
+        k->gain_ramp(actual, 1.0f, -1.0f / (float)TEST_FRAMES, TEST_FRAMES);
+        ASSERT_DBL_NEAR_TOL(1.0, actual[0], 1e-6);
+        ASSERT_DBL_NEAR_TOL(1.0 / TEST_FRAMES, actual[TEST_FRAMES - 1], 1e-5);
+    }
+}
+
+CTEST(dsp_kernels, measure_matches_scalar) {
+    const DspKernels* ref = dsp_kernels_get(DSP_KERNELS_SCALAR);
+    static float signal[TEST_FRAMES];
+    fill_signal(signal, TEST_FRAMES, 4);
+
+    float ref_peak, ref_sum;
+    uint32_t ref_clips;
+    ref->measure(signal, TEST_FRAMES, 1.0f, &ref_peak, &ref_sum, &ref_clips);
+    ASSERT_TRUE(ref_clips > 0);
+
+    for (int set = 0; set < DSP_KERNELS_COUNT; set++) {
+        const DspKernels* k = dsp_kernels_get((DspKernelSet)set);
+        if (!k) continue;
+
+        float peak, sum;
+        uint32_t clips;
+        k->measure(signal, TEST_FRAMES, 1.0f, &peak, &sum, &clips);
+        ASSERT_DBL_NEAR_TOL(ref_peak, peak, TEST_EPSILON);
+        ASSERT_DBL_NEAR_TOL(ref_sum, sum, ref_sum * 1e-4);
+        ASSERT_EQUAL(ref_clips, clips);
+    }
+}
+
+CTEST(dsp_kernels, complex_mac_matches_scalar) {
+    const DspKernels* ref = dsp_kernels_get(DSP_KERNELS_SCALAR);
+    static float a_re[TEST_FRAMES], a_im[TEST_FRAMES], b_re[TEST_FRAMES], b_im[TEST_FRAMES];
+    static float expected_re[TEST_FRAMES], expected_im[TEST_FRAMES], actual_re[TEST_FRAMES], actual_im[TEST_FRAMES];
+    fill_signal(a_re, TEST_FRAMES, 9);
+    fill_signal(a_im, TEST_FRAMES, 10);
+    fill_signal(b_re, TEST_FRAMES, 11);
+    fill_signal(b_im, TEST_FRAMES, 12);
+
+    for (int set = 0; set < DSP_KERNELS_COUNT; set++) {
+        const DspKernels* k = dsp_kernels_get((DspKernelSet)set);
+        if (!k) continue;
+
+        fill_signal(expected_re, TEST_FRAMES, 13);
+        fill_signal(expected_im, TEST_FRAMES, 14);
+        memcpy(actual_re, expected_re, sizeof(expected_re));
+        memcpy(actual_im, expected_im, sizeof(expected_im));
+        ref->complex_mac(expected_re, expected_im, a_re, a_im, b_re, b_im, TEST_FRAMES);
+        k->complex_mac(actual_re, actual_im, a_re, a_im, b_re, b_im, TEST_FRAMES);
+        ASSERT_TRUE(buffers_match(expected_re, actual_re, TEST_FRAMES, TEST_EPSILON));
+        ASSERT_TRUE(buffers_match(expected_im, actual_im, TEST_FRAMES, TEST_EPSILON));
+    }
+}
+
+CTEST(dsp_kernels, fir_matches_scalar) {
+    const DspKernels* ref = dsp_kernels_get(DSP_KERNELS_SCALAR);
+    static float input[TEST_FRAMES + 64], taps[64], expected[TEST_FRAMES], actual[TEST_FRAMES];
+    fill_signal(input, TEST_FRAMES + 64, 20);
+    fill_signal(taps, 64, 21);
+
+    for (int set = 0; set < DSP_KERNELS_COUNT; set++) {
+        const DspKernels* k = dsp_kernels_get((DspKernelSet)set);
+        if (!k) continue;
+
+        for (uint32_t tap_count = 1; tap_count <= 64; tap_count += 9) {
+            for (uint32_t frames = 0; frames <= 19; frames++) {
+                ref->fir(expected, input, taps, tap_count, frames);
+                k->fir(actual, input, taps, tap_count, frames);
+                ASSERT_TRUE(buffers_match(expected, actual, frames, TEST_EPSILON));
+            }
+            ref->fir(expected, input, taps, tap_count, TEST_FRAMES);
+            k->fir(actual, input, taps, tap_count, TEST_FRAMES);
+            ASSERT_TRUE(buffers_match(expected, actual, TEST_FRAMES, TEST_EPSILON));
+        }
+    }
+}
+
+CTEST(dsp_kernels, interleave_matches_scalar) {
+    const DspKernels* ref = dsp_kernels_get(DSP_KERNELS_SCALAR);
+    static float left[TEST_FRAMES], right[TEST_FRAMES];
+    static float expected[TEST_FRAMES * 2], actual[TEST_FRAMES * 2];
+    fill_signal(left, TEST_FRAMES, 5);
+    fill_signal(right, TEST_FRAMES, 6);
+    ref->interleave(expected, left, right, TEST_FRAMES);
+
+    for (int set = 0; set < DSP_KERNELS_COUNT; set++) {
+        const DspKernels* k = dsp_kernels_get((DspKernelSet)set);
+        if (!k) continue;
+
+        memset(actual, 0, sizeof(actual));
+        k->interleave(actual, left, right, TEST_FRAMES);
+        ASSERT_TRUE(buffers_match(expected, actual, TEST_FRAMES * 2, 0.0f));
+    }
+}
+
+// ============================================================================
+// FILTERS
+// ============================================================================
+
+static float block_peak(const float* buffer, uint32_t count) {
+    float peak = 0.0f;
+    for (uint32_t i = 0; i < count; i++) {
+        if (fabsf(buffer[i]) > peak) peak = fabsf(buffer[i]);
+    }
+    return peak;
+}
+
+CTEST(dsp_kernels, lowpass_settles_on_dc) {
+    static float left[TEST_FRAMES], right[TEST_FRAMES];
+    for (uint32_t i = 0; i < TEST_FRAMES; i++) {
+        left[i] = 1.0f;
+        right[i] = -0.5f;
+    }
+
+    float state[4] = {0};
+    DspSvfCoeffs coeffs = dsp_svf_coeffs(DSP_SVF_LOWPASS, 1000.0f, 0.707f, 48000.0f);
+    dsp_kernels_best()->svf_stereo(left, right, TEST_FRAMES, &coeffs, &coeffs, state);
+    ASSERT_DBL_NEAR_TOL(1.0f, left[TEST_FRAMES - 1], 1e-4);
+    ASSERT_DBL_NEAR_TOL(-0.5f, right[TEST_FRAMES - 1], 1e-4);
+}
+
+CTEST(dsp_kernels, highpass_removes_dc) {
+    static float left[TEST_FRAMES], right[TEST_FRAMES];
+    for (uint32_t i = 0; i < TEST_FRAMES; i++) {
+        left[i] = 1.0f;
+        right[i] = 1.0f;
+    }
+
+    float state[4] = {0};
+    DspSvfCoeffs coeffs = dsp_svf_coeffs(DSP_SVF_HIGHPASS, 1000.0f, 0.707f, 48000.0f);
+    dsp_kernels_best()->svf_stereo(left, right, TEST_FRAMES, &coeffs, &coeffs, state);
+    ASSERT_TRUE(left[0] > 0.8f);
+    ASSERT_DBL_NEAR_TOL(0.0f, left[TEST_FRAMES - 1], 1e-4);
+    ASSERT_DBL_NEAR_TOL(0.0f, right[TEST_FRAMES - 1], 1e-4);
+}
+
+// A resonant filter ringing out into silence ends on exact zeros, not
+// denormals
+CTEST(dsp_kernels, svf_state_flushes_on_silence) {
+    static float left[256], right[256];
+    float state[4] = {0};
+    DspSvfCoeffs coeffs = dsp_svf_coeffs(DSP_SVF_LOWPASS, 200.0f, 4.0f, 48000.0f);
+    for (int block = 0; block < 400; block++) {
+        memset(left, 0, sizeof(left));
+        memset(right, 0, sizeof(right));
+        if (block == 0) {
+            left[0] = 1.0f;
+            right[0] = -1.0f;
+        }
+        dsp_kernels_best()->svf_stereo(left, right, 256, &coeffs, &coeffs, state);
+    }
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(state[i] == 0.0f);
+    }
+}
+
+// Steady-state gain of a sine at `hz` through one filter
+static float svf_gain(DspSvfMode mode, float cutoff, float q, float hz) {
+    static float left[TEST_FRAMES * 4], right[TEST_FRAMES * 4];
+    const uint32_t count = TEST_FRAMES * 4;
+    for (uint32_t i = 0; i < count; i++) {
+        left[i] = sinf(2.0f * 3.14159265f * hz * (float)i / 48000.0f);
+        right[i] = left[i];
+    }
+    float state[4] = {0};
+    DspSvfCoeffs coeffs = dsp_svf_coeffs(mode, cutoff, q, 48000.0f);
+    dsp_kernels_best()->svf_stereo(left, right, count, &coeffs, &coeffs, state);
+    double sum = 0.0;
+    for (uint32_t i = count / 2; i < count; i++) {
+        sum += (double)left[i] * left[i];
+    }
+    return (float)sqrt(2.0 * sum / (count / 2));
+}
+
+// Cutoffs are in Hz: -3 dB there at Q 0.707, 12 dB/octave beyond, and Q
+// sets the peak at the cutoff
+CTEST(dsp_kernels, svf_response_follows_cutoff_and_q) {
+    float db_at_cutoff = 20.0f * log10f(svf_gain(DSP_SVF_LOWPASS, 1000.0f, 0.70710678f, 1000.0f));
+    float db_decade = 20.0f * log10f(svf_gain(DSP_SVF_LOWPASS, 1000.0f, 0.70710678f, 10000.0f));
+    float db_passband = 20.0f * log10f(svf_gain(DSP_SVF_LOWPASS, 1000.0f, 0.70710678f, 100.0f));
+    float db_high_cutoff = 20.0f * log10f(svf_gain(DSP_SVF_HIGHPASS, 1000.0f, 0.70710678f, 1000.0f));
+    float db_high_stop = 20.0f * log10f(svf_gain(DSP_SVF_HIGHPASS, 1000.0f, 0.70710678f, 100.0f));
+    float db_resonant = 20.0f * log10f(svf_gain(DSP_SVF_LOWPASS, 1000.0f, 8.0f, 1000.0f));
+    printf("    lowpass: %.2f dB at the cutoff, %.1f dB a decade up; Q 8 peaks at %.2f dB\n", db_at_cutoff,
+           db_decade, db_resonant);
+    ASSERT_DBL_NEAR_TOL(-3.01, db_at_cutoff, 0.1);
+    ASSERT_TRUE(db_decade < -40.0f);
+    ASSERT_DBL_NEAR_TOL(0.0, db_passband, 0.05);
+    ASSERT_DBL_NEAR_TOL(-3.01, db_high_cutoff, 0.1);
+    ASSERT_TRUE(db_high_stop < -39.0f);
+    ASSERT_DBL_NEAR_TOL(20.0 * log10(8.0), db_resonant, 0.2);
+}
+
+// A glide between very different coefficients stays bounded, and one
+// between equal coefficients is the fixed filter
+CTEST(dsp_kernels, svf_glide_reaches_the_target) {
+    static float left[TEST_FRAMES], right[TEST_FRAMES];
+    fill_signal(left, TEST_FRAMES, 11);
+    fill_signal(right, TEST_FRAMES, 12);
+    DspSvfCoeffs from = dsp_svf_coeffs(DSP_SVF_LOWPASS, 200.0f, 4.0f, 48000.0f);
+    DspSvfCoeffs to = dsp_svf_coeffs(DSP_SVF_HIGHPASS, 8000.0f, 0.5f, 48000.0f);
+    float state[4] = {0};
+    dsp_kernels_best()->svf_stereo(left, right, TEST_FRAMES, &from, &to, state);
+    ASSERT_TRUE(block_peak(left, TEST_FRAMES) < 4.0f);
+    ASSERT_TRUE(block_peak(right, TEST_FRAMES) < 4.0f);
+
+    // Equal coefficients through both paths, from the same state
+    float copy[4];
+    memcpy(copy, state, sizeof(copy));
+    static float a[256], b[256], ra[256], rb[256];
+    fill_signal(a, 256, 13);
+    fill_signal(b, 256, 14);
+    memcpy(ra, a, sizeof(a));
+    memcpy(rb, b, sizeof(b));
+    DspSvfCoeffs same = to;
+    dsp_kernels_best()->svf_stereo(a, b, 256, &to, &to, state);
+    dsp_kernels_best()->svf_stereo(ra, rb, 256, &same, &to, copy);
+    ASSERT_TRUE(buffers_match(a, ra, 256, 1e-6f));
+    ASSERT_TRUE(buffers_match(b, rb, 256, 1e-6f));
+}
+
+// Fixed and gliding, every set keeps the two channels' integrators apart
+// and lands where the scalar loop does
+CTEST(dsp_kernels, svf_stereo_matches_scalar) {
+    const DspKernels* ref = dsp_kernels_get(DSP_KERNELS_SCALAR);
+    static float left[TEST_FRAMES], right[TEST_FRAMES], ref_left[TEST_FRAMES], ref_right[TEST_FRAMES];
+    DspSvfCoeffs from = dsp_svf_coeffs(DSP_SVF_LOWPASS, 300.0f, 2.0f, 48000.0f);
+    DspSvfCoeffs to = dsp_svf_coeffs(DSP_SVF_HIGHPASS, 5000.0f, 0.7f, 48000.0f);
+
+    for (int set = 0; set < DSP_KERNELS_COUNT; set++) {
+        const DspKernels* k = dsp_kernels_get((DspKernelSet)set);
+        if (!k) continue;
+
+        for (int glide = 0; glide < 2; glide++) {
+            const DspSvfCoeffs* start = glide ? &from : &to;
+            float state[4] = {0.1f, -0.2f, 0.3f, -0.4f};
+            float ref_state[4] = {0.1f, -0.2f, 0.3f, -0.4f};
+            for (uint32_t frames = 0; frames <= 19; frames++) {
+                fill_signal(left, frames, 20 + frames);
+                fill_signal(right, frames, 40 + frames);
+                memcpy(ref_left, left, sizeof(float) * frames);
+                memcpy(ref_right, right, sizeof(float) * frames);
+                ref->svf_stereo(ref_left, ref_right, frames, start, &to, ref_state);
+                k->svf_stereo(left, right, frames, start, &to, state);
+                ASSERT_TRUE(buffers_match(ref_left, left, frames, TEST_EPSILON));
+                ASSERT_TRUE(buffers_match(ref_right, right, frames, TEST_EPSILON));
+                ASSERT_TRUE(buffers_match(ref_state, state, 4, TEST_EPSILON));
+            }
+
+            fill_signal(left, TEST_FRAMES, 60);
+            fill_signal(right, TEST_FRAMES, 61);
+            memcpy(ref_left, left, sizeof(left));
+            memcpy(ref_right, right, sizeof(right));
+            ref->svf_stereo(ref_left, ref_right, TEST_FRAMES, start, &to, ref_state);
+            k->svf_stereo(left, right, TEST_FRAMES, start, &to, state);
+            ASSERT_TRUE(buffers_match(ref_left, left, TEST_FRAMES, TEST_EPSILON));
+            ASSERT_TRUE(buffers_match(ref_right, right, TEST_FRAMES, TEST_EPSILON));
+            ASSERT_TRUE(buffers_match(ref_state, state, 4, TEST_EPSILON));
+        }
+    }
+}
+
+
+// ============================================================================
+// OSCILLATOR BANK
+// ============================================================================
+
+CTEST(oscillator, sine_matches_sinf) {
+    oscillator_tables_init();
+    OscillatorBank bank;
+    oscillator_bank_init(&bank, 48000.0f);
+    ASSERT_EQUAL(0, oscillator_bank_add_voice(&bank, OSC_SINE, 440.0f, 0.5f));
+
+    static float out[TEST_FRAMES];
+    oscillator_bank_render(&bank, out, TEST_FRAMES);
+    for (uint32_t i = 0; i < TEST_FRAMES; i++) {
+        float expected = 0.5f * sinf(2.0f * 3.14159265f * 440.0f * (float)i / 48000.0f);
+        ASSERT_DBL_NEAR_TOL(expected, out[i], 1e-3);
+    }
+}
+
+CTEST(oscillator, phase_continues_across_blocks) {
+    oscillator_tables_init();
+    OscillatorBank one_block, two_blocks;
+    oscillator_bank_init(&one_block, 48000.0f);
+    oscillator_bank_init(&two_blocks, 48000.0f);
+    oscillator_bank_add_voice(&one_block, OSC_SAW, 1234.5f, 1.0f);
+    oscillator_bank_add_voice(&two_blocks, OSC_SAW, 1234.5f, 1.0f);
+
+    static float whole[TEST_FRAMES], split[TEST_FRAMES];
+    oscillator_bank_render(&one_block, whole, TEST_FRAMES);
+    oscillator_bank_render(&two_blocks, split, 100);
+    oscillator_bank_render(&two_blocks, split + 100, TEST_FRAMES - 100);
+    ASSERT_TRUE(buffers_match(whole, split, TEST_FRAMES, 0.0f));
+}
+
+CTEST(oscillator, voices_sum_and_mute) {
+    oscillator_tables_init();
+    OscillatorBank bank;
+    oscillator_bank_init(&bank, 48000.0f);
+    int a = oscillator_bank_add_voice(&bank, OSC_SQUARE, 100.0f, 0.25f);
+    int b = oscillator_bank_add_voice(&bank, OSC_SQUARE, 100.0f, 0.25f);
+    ASSERT_TRUE(a >= 0 && b >= 0);
+
+    static float both[TEST_FRAMES], single[TEST_FRAMES];
+    oscillator_bank_render(&bank, both, TEST_FRAMES);
+
+    oscillator_bank_init(&bank, 48000.0f);
+    oscillator_bank_add_voice(&bank, OSC_SQUARE, 100.0f, 0.25f);
+    b = oscillator_bank_add_voice(&bank, OSC_SQUARE, 100.0f, 0.25f);
+    oscillator_bank_set_active(&bank, b, false);
+    oscillator_bank_render(&bank, single, TEST_FRAMES);
+
+    for (uint32_t i = 0; i < TEST_FRAMES; i++) {
+        ASSERT_DBL_NEAR_TOL(both[i], single[i] * 2.0f, 1e-6);
+    }
+}
+
+CTEST(oscillator, high_notes_stay_band_limited) {
+    oscillator_tables_init();
+    OscillatorBank bank;
+    oscillator_bank_init(&bank, 48000.0f);
+    oscillator_bank_add_voice(&bank, OSC_SAW, 12000.0f, 1.0f);
+
+    // At 12 kHz only the fundamental fits below Nyquist, so the saw must
+    // come out as a pure sine of amplitude 2/pi
+    static float out[TEST_FRAMES];
+    oscillator_bank_render(&bank, out, TEST_FRAMES);
+    float peak = 0.0f;
+    for (uint32_t i = 0; i < TEST_FRAMES; i++) {
+        if (fabsf(out[i]) > peak) peak = fabsf(out[i]);
+    }
+    ASSERT_DBL_NEAR_TOL(2.0 / 3.14159265, peak, 0.02);
+}
+
+CTEST(oscillator, removing_a_voice_keeps_the_rest_dense) {
+    oscillator_tables_init();
+    OscillatorBank bank;
+    oscillator_bank_init(&bank, 48000.0f);
+    oscillator_bank_add_voice(&bank, OSC_SINE, 100.0f, 1.0f);
+    oscillator_bank_add_voice(&bank, OSC_SINE, 200.0f, 1.0f);
+    oscillator_bank_add_voice(&bank, OSC_SINE, 300.0f, 1.0f);
+    ASSERT_EQUAL(2, oscillator_bank_remove_voice(&bank, 0));
+    ASSERT_EQUAL(2, bank.voice_count);
+    ASSERT_DBL_NEAR_TOL(300.0f, bank.frequency[0], 1e-6);
+    ASSERT_EQUAL(-1, oscillator_bank_remove_voice(&bank, 1));
+    ASSERT_EQUAL(1, bank.voice_count);
+
+    // A gain ramp spans renders, lands exactly on its target and holds it
+    static float out[TEST_FRAMES];
+    oscillator_bank_set_gain_ramp(&bank, 0, 0.0f, 0);
+    oscillator_bank_set_gain_ramp(&bank, 0, 0.5f, 200);
+    oscillator_bank_render(&bank, out, 100);
+    ASSERT_DBL_NEAR_TOL(0.25f, bank.gain[0], 1e-5);
+    ASSERT_DBL_NEAR_TOL(0.0f, out[0], 1e-6);
+    oscillator_bank_render(&bank, out, TEST_FRAMES);
+    ASSERT_EQUAL(0, (int)bank.gain_ramp_frames[0]);
+    ASSERT_DBL_NEAR_TOL(0.5f, bank.gain[0], 0.0);
+    ASSERT_DBL_NEAR_TOL(0.5f, block_peak(out + 100, TEST_FRAMES - 100), 1e-3);
+}
+
+// ============================================================================
+// VOICE POOL
+// ============================================================================
+
+CTEST(voice_pool, notes_attack_sustain_and_release) {
+    oscillator_tables_init();
+    static VoicePool pool;
+    voice_pool_init(&pool, OSC_SINE, 48000.0f);
+    voice_pool_set_envelope(&pool, 1.0f, 10.0f);     // 48 and 480 frames at full scale
+
+    static float out[TEST_FRAMES];
+    voice_pool_render(&pool, out, TEST_FRAMES);
+    ASSERT_DBL_NEAR_TOL(0.0f, block_peak(out, TEST_FRAMES), 1e-9);
+
+    voice_pool_note_on(&pool, 69, 1.0f);
+    ASSERT_EQUAL(1, voice_pool_active_count(&pool));
+    voice_pool_render(&pool, out, 256);
+    ASSERT_TRUE(block_peak(out, 24) < 0.5f);              // Still in the attack
+    ASSERT_DBL_NEAR_TOL(1.0f, block_peak(out + 48, 208), 0.01);
+
+    // Releasing a note that is not playing changes nothing
+    voice_pool_note_off(&pool, 70);
+    ASSERT_EQUAL(1, voice_pool_active_count(&pool));
+
+    voice_pool_note_off(&pool, 69);
+    voice_pool_render(&pool, out, 256);
+    ASSERT_EQUAL(1, voice_pool_active_count(&pool));
+    voice_pool_render(&pool, out, 256);      // 512 frames > 480: silent, dropped
+    ASSERT_EQUAL(0, voice_pool_active_count(&pool));
+    voice_pool_render(&pool, out, 256);
+    ASSERT_DBL_NEAR_TOL(0.0f, block_peak(out, 256), 1e-9);
+}
+
+CTEST(voice_pool, chord_sums_its_notes) {
+    oscillator_tables_init();
+    static VoicePool pool;
+    static OscillatorBank reference;
+    voice_pool_init(&pool, OSC_SAW, 48000.0f);
+    voice_pool_set_envelope(&pool, 0.0f, 0.0f);
+    oscillator_bank_init(&reference, 48000.0f);
+    const int notes[3] = {60, 64, 67};
+    for (int n = 0; n < 3; n++) {
+        voice_pool_note_on(&pool, notes[n], 1.0f);
+        oscillator_bank_add_voice(&reference, OSC_SAW, voice_note_frequency(notes[n]), 1.0f);
+    }
+    ASSERT_EQUAL(3, voice_pool_active_count(&pool));
+
+    // A step envelope is at full level from the first sample
+    static float voices[TEST_FRAMES], expected[TEST_FRAMES];
+    voice_pool_render(&pool, voices, TEST_FRAMES);
+    oscillator_bank_render(&reference, expected, TEST_FRAMES);
+    ASSERT_TRUE(buffers_match(expected, voices, TEST_FRAMES, 1e-5f));
+    ASSERT_DBL_NEAR_TOL(440.0f, voice_note_frequency(69), 1e-3);
+}
+
+CTEST(voice_pool, retrigger_reuses_the_voice) {
+    static VoicePool pool;
+    voice_pool_init(&pool, OSC_SINE, 48000.0f);
+    voice_pool_note_on(&pool, 60, 1.0f);
+    voice_pool_note_on(&pool, 60, 0.5f);
+    ASSERT_EQUAL(1, voice_pool_active_count(&pool));
+    ASSERT_DBL_NEAR_TOL(0.5f, pool.velocity[0], 1e-9);
+
+    // Velocity 0 is a note-off
+    voice_pool_note_on(&pool, 60, 0.0f);
+    ASSERT_EQUAL(VOICE_RELEASE, pool.stage[0]);
+    voice_pool_note_on(&pool, 128, 1.0f);
+    voice_pool_note_on(&pool, -1, 1.0f);
+    ASSERT_EQUAL(1, voice_pool_active_count(&pool));
+}
+
+CTEST(voice_pool, full_pool_steals_released_then_oldest) {
+    static VoicePool pool;
+    static float out[64];
+    voice_pool_init(&pool, OSC_SINE, 48000.0f);
+    for (int n = 0; n < VOICE_POOL_MAX_VOICES; n++) {
+        voice_pool_note_on(&pool, 40 + n, 1.0f);
+    }
+    voice_pool_render(&pool, out, 64);
+    ASSERT_EQUAL(VOICE_POOL_MAX_VOICES, voice_pool_active_count(&pool));
+
+    // A releasing voice is taken before the oldest held one
+    voice_pool_note_off(&pool, 45);
+    voice_pool_note_on(&pool, 100, 1.0f);
+    ASSERT_EQUAL(VOICE_POOL_MAX_VOICES, voice_pool_active_count(&pool));
+    ASSERT_EQUAL(-1, pool.note_voice[45]);
+    ASSERT_TRUE(pool.note_voice[100] >= 0);
+    ASSERT_TRUE(pool.note_voice[40] >= 0);
+
+    // With everything held, the oldest note goes
+    voice_pool_note_on(&pool, 101, 1.0f);
+    ASSERT_EQUAL(-1, pool.note_voice[40]);
+    ASSERT_TRUE(pool.note_voice[41] >= 0);
+    ASSERT_EQUAL(2, (int)pool.steals);
+
+    // The note table keeps pointing at the right voices through removals
+    voice_pool_set_envelope(&pool, 0.0f, 0.0f);
+    voice_pool_note_off(&pool, 41);
+    voice_pool_note_off(&pool, 100);
+    voice_pool_render(&pool, out, 64);
+    ASSERT_EQUAL(VOICE_POOL_MAX_VOICES - 2, voice_pool_active_count(&pool));
+    for (int v = 0; v < voice_pool_active_count(&pool); v++) {
+        ASSERT_EQUAL(v, pool.note_voice[pool.note[v]]);
+    }
+}
+
+// ============================================================================
+// EFFECT INSTANCES
+// ============================================================================
+
+CTEST(effects, state_blocks_are_aligned_and_recycled) {
+    EffectStatePool pool;
+    ASSERT_TRUE(effect_state_pool_init(&pool, 2));
+
+    Effect a, b, c;
+    ASSERT_TRUE(effect_instance_create(&a, EFFECT_LOWPASS, &pool, &create_info));
+    ASSERT_TRUE(effect_instance_create(&b, EFFECT_GAIN, &pool, &create_info));
+    ASSERT_FALSE(effect_instance_create(&c, EFFECT_GAIN, &pool, &create_info));
+    ASSERT_TRUE(a.state != b.state);
+    ASSERT_EQUAL(0, (int)((uintptr_t)a.state % EFFECT_STATE_ALIGNMENT));
+    ASSERT_EQUAL(0, (int)((uintptr_t)b.state % EFFECT_STATE_ALIGNMENT));
+    ASSERT_DBL_NEAR_TOL(1000.0f, a.filter_params.cutoff, 1e-6);
+
+    void* released = a.state;
+    effect_instance_destroy(&a, &pool);
+    ASSERT_NULL(a.state);
+    ASSERT_TRUE(effect_instance_create(&c, EFFECT_HIGHPASS, &pool, &create_info));
+    ASSERT_TRUE(c.state == released);
+
+    effect_instance_destroy(&b, &pool);
+    effect_instance_destroy(&c, &pool);
+    effect_state_pool_destroy(&pool);
+}
+
+CTEST(effects, stacked_filters_keep_separate_state) {
+    EffectStatePool pool;
+    ASSERT_TRUE(effect_state_pool_init(&pool, 2));
+    Effect first, second;
+    effect_instance_create(&first, EFFECT_LOWPASS, &pool, &create_info);
+    effect_instance_create(&second, EFFECT_LOWPASS, &pool, &create_info);
+    first.filter_params.cutoff = 800.0f;
+    second.filter_params.cutoff = 800.0f;
+
+    // Two chained instances must equal the same filter applied twice with
+    // independent memory
+    static float left[TEST_FRAMES], right[TEST_FRAMES];
+    static float ref_left[TEST_FRAMES], ref_right[TEST_FRAMES];
+    fill_signal(left, TEST_FRAMES, 7);
+    fill_signal(right, TEST_FRAMES, 8);
+    memcpy(ref_left, left, sizeof(left));
+    memcpy(ref_right, right, sizeof(right));
+
+    const DspKernels* dsp = dsp_kernels_get(DSP_KERNELS_SCALAR);
+    const EffectVTable* vtable = effect_vtable(EFFECT_LOWPASS);
+    for (uint32_t offset = 0; offset < TEST_FRAMES; offset += 256) {
+        uint32_t n = TEST_FRAMES - offset < 256 ? TEST_FRAMES - offset : 256;
+        vtable->process(&first, dsp, left + offset, right + offset, n);
+        vtable->process(&second, dsp, left + offset, right + offset, n);
+    }
+
+    DspSvfCoeffs coeffs = dsp_svf_coeffs(DSP_SVF_LOWPASS, 800.0f, first.filter_params.resonance, 48000.0f);
+    float state_a[4] = {0}, state_b[4] = {0};
+    dsp_kernels_best()->svf_stereo(ref_left, ref_right, TEST_FRAMES, &coeffs, &coeffs, state_a);
+    dsp_kernels_best()->svf_stereo(ref_left, ref_right, TEST_FRAMES, &coeffs, &coeffs, state_b);
+    ASSERT_TRUE(buffers_match(ref_left, left, TEST_FRAMES, TEST_EPSILON));
+    ASSERT_TRUE(buffers_match(ref_right, right, TEST_FRAMES, TEST_EPSILON));
+
+    effect_instance_destroy(&first, &pool);
+    effect_instance_destroy(&second, &pool);
+    effect_state_pool_destroy(&pool);
+}
+
+// Level of a 1 kHz tone through a lowpass instance, in the second half
+static float lowpass_tone_db(uint32_t oversampling, float cutoff, float resonance) {
+    EffectStatePool pool;
+    if (!effect_state_pool_init(&pool, 1)) return 0.0f;
+    EffectCreateInfo info = create_info;
+    info.oversampling = oversampling;
+    Effect filter;
+    if (!effect_instance_create(&filter, EFFECT_LOWPASS, &pool, &info)) return 0.0f;
+    filter.filter_params.cutoff = cutoff;
+    filter.filter_params.resonance = resonance;
+
+    static float left[TEST_FRAMES * 4], right[TEST_FRAMES * 4];
+    const uint32_t count = TEST_FRAMES * 4;
+    for (uint32_t i = 0; i < count; i++) {
+        left[i] = sinf(2.0f * 3.14159265f * 1000.0f * (float)i / 48000.0f);
+        right[i] = left[i];
+    }
+    for (uint32_t offset = 0; offset < count; offset += 512) {
+        effect_process(&filter, dsp_kernels_best(), left + offset, right + offset, 512);
+    }
+    effect_instance_destroy(&filter, &pool);
+    effect_state_pool_destroy(&pool);
+
+    double sum = 0.0;
+    for (uint32_t i = count / 2; i < count; i++) {
+        sum += (double)left[i] * left[i];
+    }
+    return 20.0f * log10f((float)sqrt(2.0 * sum / (count / 2)));
+}
+
+// The cutoff parameter is in Hz and resonance is Q, at the rate the
+// instance runs at
+CTEST(effects, filter_cutoff_is_in_hz) {
+    for (uint32_t oversampling = 1; oversampling <= 2; oversampling++) {
+        float at_cutoff = lowpass_tone_db(oversampling, 1000.0f, 0.70710678f);
+        float below = lowpass_tone_db(oversampling, 100.0f, 0.70710678f);
+        float above = lowpass_tone_db(oversampling, 10000.0f, 0.70710678f);
+        float resonant = lowpass_tone_db(oversampling, 1000.0f, 4.0f);
+        printf("    %ux: %.2f dB at the cutoff, %.1f dB a decade below it, Q 4 %.2f dB\n", oversampling, at_cutoff,
+               below, resonant);
+        ASSERT_DBL_NEAR_TOL(-3.01, at_cutoff, 0.1);
+        ASSERT_TRUE(below < -39.0f);
+        ASSERT_DBL_NEAR_TOL(0.0, above, 0.05);
+        ASSERT_DBL_NEAR_TOL(20.0 * log10(4.0), resonant, 0.2);
+    }
+}
+
+CTEST(effects, delay_echoes_impulse_after_time) {
+    EffectStatePool pool;
+    ASSERT_TRUE(effect_state_pool_init(&pool, 1));
+    Effect delay;
+    ASSERT_TRUE(effect_instance_create(&delay, EFFECT_DELAY, &pool, &create_info));
+    delay.delay_params.time_ms = 10.0f;     // 480 samples
+    delay.delay_params.feedback = 0.5f;
+    delay.delay_params.mix = 1.0f;
+
+    // Prime the smoothed delay time with a silent block, then feed an impulse
+    // in blocks that do not line up with the delay
+    const DspKernels* dsp = dsp_kernels_get(DSP_KERNELS_SCALAR);
+    const EffectVTable* vtable = effect_vtable(EFFECT_DELAY);
+    static float left[2048], right[2048];
+    memset(left, 0, sizeof(left));
+    memset(right, 0, sizeof(right));
+    vtable->process(&delay, dsp, left, right, 64);
+    left[0] = 1.0f;
+    for (uint32_t offset = 0; offset < 2048; offset += 100) {
+        uint32_t n = 2048 - offset < 100 ? 2048 - offset : 100;
+        vtable->process(&delay, dsp, left + offset, right + offset, n);
+    }
+
+    ASSERT_DBL_NEAR_TOL(0.0f, left[0], 1e-6);
+    ASSERT_DBL_NEAR_TOL(1.0f, left[480], 1e-6);
+    ASSERT_DBL_NEAR_TOL(0.5f, left[960], 1e-6);
+    ASSERT_DBL_NEAR_TOL(0.25f, left[1440], 1e-6);
+    ASSERT_DBL_NEAR_TOL(0.0f, left[479], 1e-6);
+    ASSERT_DBL_NEAR_TOL(0.0f, right[480], 1e-6);
+
+    effect_instance_destroy(&delay, &pool);
+    effect_state_pool_destroy(&pool);
+}
+
+CTEST(effects, delay_time_changes_glide) {
+    EffectStatePool pool;
+    ASSERT_TRUE(effect_state_pool_init(&pool, 1));
+    Effect delay;
+    ASSERT_TRUE(effect_instance_create(&delay, EFFECT_DELAY, &pool, &create_info));
+    delay.delay_params.time_ms = 10.0f;
+    delay.delay_params.mix = 1.0f;
+    delay.delay_params.feedback = 0.0f;
+
+    // A slow ramp through a pure delay stays a slow ramp only if the read
+    // point glides; a jump of 960 samples would step the output by ~0.1
+    const DspKernels* dsp = dsp_kernels_get(DSP_KERNELS_SCALAR);
+    const EffectVTable* vtable = effect_vtable(EFFECT_DELAY);
+    static float left[4 * TEST_FRAMES], right[4 * TEST_FRAMES];
+    for (uint32_t i = 0; i < 4 * TEST_FRAMES; i++) left[i] = right[i] = (float)i * 1e-4f;
+    for (int block = 0; block < 4; block++) {
+        if (block == 3) delay.delay_params.time_ms = 30.0f;
+        vtable->process(&delay, dsp, left + block * TEST_FRAMES, right + block * TEST_FRAMES, TEST_FRAMES);
+    }
+
+    float largest_step = 0.0f;
+    for (uint32_t i = 2 * TEST_FRAMES; i < 4 * TEST_FRAMES; i++) {
+        float step = fabsf(left[i] - left[i - 1]);
+        if (step > largest_step) largest_step = step;
+    }
+    ASSERT_TRUE(largest_step < 1e-3f);
+    ASSERT_DBL_NEAR_TOL((4 * TEST_FRAMES - 1 - 1440) * 1e-4, left[4 * TEST_FRAMES - 1], 1e-4);
+
+    effect_instance_destroy(&delay, &pool);
+    effect_state_pool_destroy(&pool);
+}
+
+// Energy of a block of the reverb's left output
+static double block_energy(const float* buffer, uint32_t count) {
+    double energy = 0.0;
+    for (uint32_t i = 0; i < count; i++) energy += (double)buffer[i] * buffer[i];
+    return energy;
+}
+
+CTEST(effects, reverb_tail_decays) {
+    EffectStatePool pool;
+    ASSERT_TRUE(effect_state_pool_init(&pool, 1));
+    Effect reverb;
+    ASSERT_TRUE(effect_instance_create(&reverb, EFFECT_REVERB, &pool, &create_info));
+    reverb.reverb_params.room_size = 1.0f;
+    reverb.reverb_params.damping = 0.0f;
+    reverb.reverb_params.mix = 1.0f;
+
+    // Impulse, then silence: a tail must appear and keep shrinking
+    const DspKernels* dsp = dsp_kernels_get(DSP_KERNELS_SCALAR);
+    const EffectVTable* vtable = effect_vtable(EFFECT_REVERB);
+    static float left[4800], right[4800];
+    double energy[40];
+    for (int block = 0; block < 40; block++) {
+        memset(left, 0, sizeof(left));
+        memset(right, 0, sizeof(right));
+        if (block == 0) left[0] = right[0] = 1.0f;
+        vtable->process(&reverb, dsp, left, right, 4800);
+        energy[block] = block_energy(left, 4800) + block_energy(right, 4800);
+    }
+
+    ASSERT_TRUE(energy[0] > 1e-4);
+    ASSERT_TRUE(energy[39] < energy[5] * 0.1);
+    ASSERT_TRUE(isfinite(energy[39]));
+
+    effect_instance_destroy(&reverb, &pool);
+    effect_state_pool_destroy(&pool);
+}
+
+CTEST(effects, reverb_send_mode_is_wet_only) {
+    EffectStatePool pool;
+    ASSERT_TRUE(effect_state_pool_init(&pool, 1));
+    Effect reverb;
+    ASSERT_TRUE(effect_instance_create(&reverb, EFFECT_REVERB, &pool, &create_info));
+    reverb.reverb_params.send = 1.0f;
+
+    // Before the shortest line comes round, a send reverb is silent
+    const DspKernels* dsp = dsp_kernels_get(DSP_KERNELS_SCALAR);
+    static float left[256], right[256];
+    for (uint32_t i = 0; i < 256; i++) left[i] = right[i] = 0.8f;
+    effect_vtable(EFFECT_REVERB)->process(&reverb, dsp, left, right, 256);
+    for (uint32_t i = 0; i < 256; i++) {
+        ASSERT_DBL_NEAR_TOL(0.0f, left[i], 1e-9);
+        ASSERT_DBL_NEAR_TOL(0.0f, right[i], 1e-9);
+    }
+
+    effect_instance_destroy(&reverb, &pool);
+    effect_state_pool_destroy(&pool);
+}
+
+// ============================================================================
+// CONVOLVER
+// ============================================================================
+
+#define TEST_IR_FRAMES 3000     // 12 partitions: head plus a threaded tail
+#define TEST_CONV_FRAMES 8000
+
+CTEST(convolver, matches_direct_convolution) {
+    static float ir[TEST_IR_FRAMES * 2], ir_l[TEST_IR_FRAMES], ir_r[TEST_IR_FRAMES];
+    fill_signal(ir_l, TEST_IR_FRAMES, 15);
+    fill_signal(ir_r, TEST_IR_FRAMES, 16);
+    for (uint32_t i = 0; i < TEST_IR_FRAMES; i++) {
+        float decay = expf(-(float)i / 600.0f) * 0.1f;
+        ir[i * 2 + 0] = ir_l[i] *= decay;
+        ir[i * 2 + 1] = ir_r[i] *= decay;
+    }
+
+    Convolver conv;
+    ASSERT_TRUE(convolver_init(&conv, ir, TEST_IR_FRAMES, 2, dsp_kernels_best()));
+    ASSERT_TRUE(conv.threaded);
+    convolver_set_blocking(&conv, true);
+
+    static float in_l[TEST_CONV_FRAMES], in_r[TEST_CONV_FRAMES];
+    static float left[TEST_CONV_FRAMES], right[TEST_CONV_FRAMES];
+    fill_signal(in_l, TEST_CONV_FRAMES, 17);
+    fill_signal(in_r, TEST_CONV_FRAMES, 18);
+    memcpy(left, in_l, sizeof(left));
+    memcpy(right, in_r, sizeof(right));
+
+    // Block sizes that never line up with the partition length
+    for (uint32_t offset = 0; offset < TEST_CONV_FRAMES; offset += 333) {
+        uint32_t n = TEST_CONV_FRAMES - offset < 333 ? TEST_CONV_FRAMES - offset : 333;
+        convolver_process(&conv, dsp_kernels_best(), left + offset, right + offset, n, 0.0f, 1.0f);
+    }
+
+    uint32_t latency = convolver_latency(&conv);
+    float worst = 0.0f;
+    for (uint32_t i = latency; i < TEST_CONV_FRAMES; i += 7) {
+        double expect_l = 0.0, expect_r = 0.0;
+        for (uint32_t k = 0; k < TEST_IR_FRAMES && k <= i - latency; k++) {
+            expect_l += (double)ir_l[k] * in_l[i - latency - k];
+            expect_r += (double)ir_r[k] * in_r[i - latency - k];
+        }
+        float err = fmaxf(fabsf((float)expect_l - left[i]), fabsf((float)expect_r - right[i]));
+        if (err > worst) worst = err;
+    }
+    for (uint32_t i = 0; i < latency; i++) {
+        ASSERT_DBL_NEAR_TOL(0.0f, left[i], 1e-6);
+    }
+    printf("    worst error vs direct form: %g\n", worst);
+    ASSERT_TRUE(worst < 1e-4f);
+    ASSERT_EQUAL(0, (int)atomic_load(&conv.late_blocks));
+
+    convolver_destroy(&conv);
+}
+
+CTEST(convolver, effect_without_ir_is_delayed_dry) {
+    EffectStatePool pool;
+    ASSERT_TRUE(effect_state_pool_init(&pool, 1));
+    Effect effect;
+    ASSERT_TRUE(effect_instance_create(&effect, EFFECT_CONVOLUTION, &pool, &create_info));
+    effect.convolution_params.mix = 1.0f;
+
+    static float left[1024], right[1024];
+    for (uint32_t i = 0; i < 1024; i++) {
+        left[i] = (float)i;
+        right[i] = -(float)i;
+    }
+    effect_vtable(EFFECT_CONVOLUTION)->process(&effect, dsp_kernels_best(), left, right, 1024);
+    for (uint32_t i = CONVOLVER_PARTITION_FRAMES; i < 1024; i++) {
+        ASSERT_DBL_NEAR_TOL((float)(i - CONVOLVER_PARTITION_FRAMES), left[i], 1e-2);
+        ASSERT_DBL_NEAR_TOL(-(float)(i - CONVOLVER_PARTITION_FRAMES), right[i], 1e-2);
+    }
+
+    effect_instance_destroy(&effect, &pool);
+    effect_state_pool_destroy(&pool);
+}
+
+// Dry and wet both arrive one partition late, so a half-wet unit impulse
+// is still a clean delay; bypassed, the instance keeps the same delay
+CTEST(convolver, effect_reports_latency_and_keeps_dry_aligned) {
+    EffectStatePool pool;
+    ASSERT_TRUE(effect_state_pool_init(&pool, 2));
+    Effect effect;
+    ASSERT_TRUE(effect_instance_create(&effect, EFFECT_CONVOLUTION, &pool, &create_info));
+    ASSERT_EQUAL(CONVOLVER_PARTITION_FRAMES, (int)effect_latency(&effect));
+    effect.convolution_params.mix = 0.5f;
+
+    static float left[2048], right[2048];
+    for (uint32_t i = 0; i < 2048; i++) {
+        left[i] = (float)i;
+        right[i] = -(float)i;
+    }
+    const EffectVTable* vtable = effect_vtable(EFFECT_CONVOLUTION);
+    vtable->process(&effect, dsp_kernels_best(), left, right, 1024);
+    vtable->bypass(&effect, dsp_kernels_best(), left + 1024, right + 1024, 1024);
+    for (uint32_t i = 0; i < 2048; i++) {
+        float expected = i < CONVOLVER_PARTITION_FRAMES ? 0.0f : (float)(i - CONVOLVER_PARTITION_FRAMES);
+        ASSERT_DBL_NEAR_TOL(expected, left[i], 1e-2);
+        ASSERT_DBL_NEAR_TOL(-expected, right[i], 1e-2);
+    }
+
+    Effect gain;
+    ASSERT_TRUE(effect_instance_create(&gain, EFFECT_GAIN, &pool, &create_info));
+    ASSERT_EQUAL(0, (int)effect_latency(&gain));
+
+    effect_instance_destroy(&gain, &pool);
+    effect_instance_destroy(&effect, &pool);
+    effect_state_pool_destroy(&pool);
+}
+
+// ============================================================================
+// RESAMPLER
+// ============================================================================
+
+#define TEST_SRC_FRAMES 4410
+
+// Convert a whole stereo buffer in blocks of `block` frames, then drain the
+// filter with silence. Returns the frames written.
+static uint32_t resample_all(Resampler* resampler, const float* input, uint32_t frames, float* output,
+                             uint32_t capacity, uint32_t block) {
+    uint32_t written = 0;
+    uint32_t offset = 0;
+    while (written < capacity) {
+        uint32_t taken = frames - offset < block ? frames - offset : block;
+        const float* chunk = taken > 0 ? input + (size_t)offset * 2 : NULL;
+        if (!chunk) {
+            taken = block;
+        }
+        written += resampler_process(resampler, chunk, &taken, output + (size_t)written * 2, capacity - written);
+        if (chunk) {
+            offset += taken;
+        }
+    }
+    return written;
+}
+
+CTEST(resampler, sinc_converts_a_sine) {
+    static float input[TEST_SRC_FRAMES * 2], output[TEST_SRC_FRAMES * 2];
+    for (uint32_t i = 0; i < TEST_SRC_FRAMES; i++) {
+        input[i * 2 + 0] = sinf(2.0f * 3.14159265f * 1000.0f * (float)i / 44100.0f);
+        input[i * 2 + 1] = -input[i * 2 + 0];
+    }
+
+    Resampler resampler;
+    ASSERT_TRUE(resampler_init(&resampler, 2, 44100, 48000, RESAMPLER_SINC, 333));
+    uint32_t length = (uint32_t)resampler_output_length(TEST_SRC_FRAMES, 44100, 48000);
+    ASSERT_EQUAL(4800, (int)length);
+    ASSERT_EQUAL(4800, (int)resample_all(&resampler, input, TEST_SRC_FRAMES, output, length, 333));
+
+    // Away from the edges, where the filter reads the silence around the clip
+    float worst = 0.0f;
+    for (uint32_t n = 2 * resampler.taps; n < length - 2 * resampler.taps; n++) {
+        float expected = sinf(2.0f * 3.14159265f * 1000.0f * (float)n / 48000.0f);
+        worst = fmaxf(worst, fmaxf(fabsf(expected - output[n * 2]), fabsf(expected + output[n * 2 + 1])));
+    }
+    printf("    worst error vs the ideal sine: %g\n", worst);
+    ASSERT_TRUE(worst < 1e-3f);
+    resampler_destroy(&resampler);
+}
+
+// Downsampling: the sinc tier filters out what would alias below the new
+// Nyquist, the linear tier does not; both keep DC
+CTEST(resampler, sinc_rejects_aliases_linear_does_not) {
+    static float tone[TEST_SRC_FRAMES * 2], dc[TEST_SRC_FRAMES * 2], output[TEST_SRC_FRAMES * 2];
+    for (uint32_t i = 0; i < TEST_SRC_FRAMES * 2; i++) {
+        tone[i] = sinf(2.0f * 3.14159265f * 18000.0f * (float)(i / 2) / 48000.0f);
+        dc[i] = 0.5f;
+    }
+    const uint32_t length = TEST_SRC_FRAMES / 2;
+    ResamplerQuality qualities[2] = {RESAMPLER_SINC, RESAMPLER_LINEAR};
+    float rms[2];
+    for (int q = 0; q < 2; q++) {
+        Resampler resampler;
+        ASSERT_TRUE(resampler_init(&resampler, 2, 48000, 24000, qualities[q], 512));
+        resample_all(&resampler, tone, TEST_SRC_FRAMES, output, length, 512);
+        double sum = 0.0;
+        uint32_t count = 0;
+        for (uint32_t n = resampler.taps; n < length - resampler.taps; n++, count++) {
+            sum += (double)output[n * 2] * output[n * 2];
+        }
+        rms[q] = (float)sqrt(sum / count);
+
+        resampler_reset(&resampler);
+        resample_all(&resampler, dc, TEST_SRC_FRAMES, output, length, 512);
+        ASSERT_DBL_NEAR_TOL(0.5f, output[length], 1e-4);
+        resampler_destroy(&resampler);
+    }
+    printf("    18 kHz residue at 24 kHz: sinc %g, linear %g\n", rms[0], rms[1]);
+    ASSERT_TRUE(rms[0] < 1e-3f);
+    ASSERT_TRUE(rms[1] > 0.1f);
+}
+
+// A device callback asks for whole periods: input_needed says exactly how
+// much to render for each one
+CTEST(resampler, input_needed_fills_whole_periods) {
+    static float input[1024 * 2], output[256 * 2];
+    fill_signal(input, 1024 * 2, 19);
+    Resampler resampler;
+    ASSERT_TRUE(resampler_init(&resampler, 2, 48000, 44100, RESAMPLER_LINEAR, 1024));
+    uint64_t consumed = 0;
+    for (int period = 0; period < 64; period++) {
+        uint32_t needed = resampler_input_needed(&resampler, 256);
+        ASSERT_TRUE(needed <= 1024);
+        uint32_t taken = needed;
+        ASSERT_EQUAL(256, (int)resampler_process(&resampler, input, &taken, output, 256));
+        ASSERT_EQUAL((int)needed, (int)taken);
+        ASSERT_EQUAL(0, (int)resampler_input_needed(&resampler, 0));
+        consumed += taken;
+    }
+    // 64 periods at 44.1 kHz span this many 48 kHz frames, give or take one
+    ASSERT_TRUE(consumed + 1 >= 64 * 256 * 48000 / 44100 && consumed <= 64 * 256 * 48000 / 44100 + 2);
+    resampler_destroy(&resampler);
+}
+
+// ============================================================================
+// OVERSAMPLER
+// ============================================================================
+
+#define TEST_OS_FRAMES 9600
+
+// Tone at `hz` (48 kHz), left, and its inverse, right
+static void fill_tone(float* left, float* right, uint32_t count, float hz) {
+    for (uint32_t i = 0; i < count; i++) {
+        left[i] = sinf(2.0f * 3.14159265f * hz * (float)i / 48000.0f);
+        right[i] = -left[i];
+    }
+}
+
+// Magnitude of one frequency over a whole number of its cycles
+static float tone_level(const float* buffer, uint32_t count, float hz) {
+    double re = 0.0, im = 0.0;
+    for (uint32_t i = 0; i < count; i++) {
+        double phase = 2.0 * 3.14159265358979 * hz * i / 48000.0;
+        re += buffer[i] * cos(phase);
+        im += buffer[i] * sin(phase);
+    }
+    return (float)(2.0 * sqrt(re * re + im * im) / count);
+}
+
+static void hard_clip(float* buffer, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        buffer[i] = buffer[i] > 0.5f ? 0.5f : (buffer[i] < -0.5f ? -0.5f : buffer[i]);
+    }
+}
+
+// Up and straight back down is a pure delay of a whole number of frames
+CTEST(oversampler, round_trip_is_a_whole_frame_delay) {
+    static float in_l[TEST_OS_FRAMES], in_r[TEST_OS_FRAMES], left[TEST_OS_FRAMES], right[TEST_OS_FRAMES];
+    fill_tone(in_l, in_r, TEST_OS_FRAMES, 1000.0f);
+    for (uint32_t factor = 2; factor <= OVERSAMPLER_MAX_FACTOR; factor *= 2) {
+        Oversampler* oversampler = oversampler_create(factor);
+        ASSERT_NOT_NULL(oversampler);
+        uint32_t latency = oversampler_latency(oversampler);
+        ASSERT_TRUE(latency > 0 && latency < 64);
+
+        memcpy(left, in_l, sizeof(left));
+        memcpy(right, in_r, sizeof(right));
+        for (uint32_t offset = 0; offset < TEST_OS_FRAMES; offset += 200) {
+            float* top[2];
+            oversampler_up(oversampler, dsp_kernels_best(), left + offset, right + offset, 200, top);
+            oversampler_down(oversampler, dsp_kernels_best(), left + offset, right + offset, 200);
+        }
+        float worst = 0.0f;
+        for (uint32_t i = 200; i < TEST_OS_FRAMES; i++) {
+            worst = fmaxf(worst, fmaxf(fabsf(left[i] - in_l[i - latency]), fabsf(right[i] - in_r[i - latency])));
+        }
+        printf("    %ux: %u frames, worst error %g\n", factor, latency, worst);
+        ASSERT_TRUE(worst < 1e-3f);
+        oversampler_destroy(oversampler);
+    }
+    ASSERT_NULL(oversampler_create(3));
+}
+
+// Clipping a 15 kHz tone makes a 45 kHz harmonic: at the engine rate it
+// folds back to 3 kHz, at 4x it is filtered out on the way down. Only the
+// much weaker 13th harmonic (195 kHz) still folds onto 3 kHz at 4x.
+CTEST(oversampler, clipping_at_4x_does_not_alias) {
+    static float plain[TEST_OS_FRAMES], plain_r[TEST_OS_FRAMES];
+    static float left[TEST_OS_FRAMES], right[TEST_OS_FRAMES];
+    fill_tone(plain, plain_r, TEST_OS_FRAMES, 15000.0f);
+    memcpy(left, plain, sizeof(left));
+    memcpy(right, plain_r, sizeof(right));
+    hard_clip(plain, TEST_OS_FRAMES);
+
+    Oversampler* oversampler = oversampler_create(4);
+    ASSERT_NOT_NULL(oversampler);
+    for (uint32_t offset = 0; offset < TEST_OS_FRAMES; offset += OVERSAMPLER_CHUNK_FRAMES) {
+        uint32_t chunk = TEST_OS_FRAMES - offset < OVERSAMPLER_CHUNK_FRAMES ? TEST_OS_FRAMES - offset
+                                                                            : OVERSAMPLER_CHUNK_FRAMES;
+        float* top[2];
+        oversampler_up(oversampler, dsp_kernels_best(), left + offset, right + offset, chunk, top);
+        hard_clip(top[0], chunk * 4);
+        hard_clip(top[1], chunk * 4);
+        oversampler_down(oversampler, dsp_kernels_best(), left + offset, right + offset, chunk);
+    }
+    oversampler_destroy(oversampler);
+
+    // The second half, past the filters' start-up
+    float plain_alias = tone_level(plain + TEST_OS_FRAMES / 2, TEST_OS_FRAMES / 2, 3000.0f);
+    float alias = tone_level(left + TEST_OS_FRAMES / 2, TEST_OS_FRAMES / 2, 3000.0f);
+    float fundamental = tone_level(left + TEST_OS_FRAMES / 2, TEST_OS_FRAMES / 2, 15000.0f);
+    printf("    3 kHz alias: %g at 1x, %g at 4x (fundamental %g)\n", plain_alias, alias, fundamental);
+    ASSERT_TRUE(plain_alias > 0.05f);
+    ASSERT_TRUE(alias < plain_alias * 0.05f);
+    ASSERT_TRUE(fundamental > 0.5f);
+}
+
+// An oversampled instance reports the oversampler's delay and keeps it
+// when disabled; latent types cannot be oversampled
+CTEST(oversampler, effect_reports_latency_and_keeps_it_bypassed) {
+    EffectStatePool pool;
+    ASSERT_TRUE(effect_state_pool_init(&pool, 2));
+    EffectCreateInfo info = create_info;
+    info.oversampling = 2;
+    Effect effect;
+    ASSERT_FALSE(effect_instance_create(&effect, EFFECT_CONVOLUTION, &pool, &info));
+    ASSERT_TRUE(effect_instance_create(&effect, EFFECT_GAIN, &pool, &info));
+    ASSERT_EQUAL(2, (int)effect.oversampling);
+    uint32_t latency = effect_latency(&effect);
+    ASSERT_TRUE(latency > 0);
+    effect.gain_params.gain = 0.5f;
+
+    static float in_l[TEST_OS_FRAMES], in_r[TEST_OS_FRAMES], left[TEST_OS_FRAMES], right[TEST_OS_FRAMES];
+    fill_tone(in_l, in_r, TEST_OS_FRAMES, 440.0f);
+    memcpy(left, in_l, sizeof(left));
+    memcpy(right, in_r, sizeof(right));
+
+    // Blocks longer than a chunk, the second half bypassed
+    const uint32_t block = 600;
+    for (uint32_t offset = 0; offset < TEST_OS_FRAMES; offset += block) {
+        if (offset < TEST_OS_FRAMES / 2) {
+            effect_process(&effect, dsp_kernels_best(), left + offset, right + offset, block);
+        } else {
+            effect_bypass(&effect, dsp_kernels_best(), left + offset, right + offset, block);
+        }
+    }
+    for (uint32_t i = block; i < TEST_OS_FRAMES; i++) {
+        // The gain ramps within the first top-rate block; bypassing switches at the top rate too
+        if (i >= TEST_OS_FRAMES / 2 && i < TEST_OS_FRAMES / 2 + 2 * latency) continue;
+        float gain = i < TEST_OS_FRAMES / 2 ? 0.5f : 1.0f;
+        ASSERT_DBL_NEAR_TOL(gain * in_l[i - latency], left[i], 1e-3);
+        ASSERT_DBL_NEAR_TOL(gain * in_r[i - latency], right[i], 1e-3);
+    }
+
+    effect_instance_destroy(&effect, &pool);
+    ASSERT_NULL(effect.oversampler);
+    effect_state_pool_destroy(&pool);
+}
+
+int main(int argc, const char* argv[]) {
+    return ctest_main(argc, argv);
+}
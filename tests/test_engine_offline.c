@@ -0,0 +1,2239 @@
+#define CTEST_MAIN
+#define CTEST_COLOR_OK
+
+// Links libairdaw_engine (which carries the miniaudio implementation) and
+// nothing GUI related: this file failing to link means the engine picked up
+// a raylib/GL dependency again.
+#include "../vendor/ctest/ctest.h"
+#include "../audio_engine.h"
+#include "../control_thread.h"
+#include "../engine_log.h"
+#include "../engine_thread.h"
+#include "../journal.h"
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// TEST CONSTANTS
+// ============================================================================
+
+#define RENDER_FRAMES 20000     // Not a multiple of the offline chunk
+#define TEST_WAV_PATH "test_engine_offline.wav"
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+typedef struct {
+    float* frames;          // Interleaved stereo
+    uint64_t count;
+    uint64_t capacity;
+    uint64_t abort_after;   // Fail the write once this many frames arrived (0 = never)
+} MemorySink;
+
+static bool memory_sink_write(void* user_data, const float* frames, uint32_t frame_count) {
+    MemorySink* sink = (MemorySink*)user_data;
+    if (sink->abort_after && sink->count >= sink->abort_after) {
+        return false;
+    }
+    if (sink->count + frame_count > sink->capacity) {
+        return false;
+    }
+    memcpy(sink->frames + sink->count * CHANNELS, frames, sizeof(float) * frame_count * CHANNELS);
+    sink->count += frame_count;
+    return true;
+}
+
+static MemorySink memory_sink_create(uint64_t capacity) {
+    MemorySink sink = {.capacity = capacity};
+    sink.frames = (float*)calloc((size_t)capacity * CHANNELS, sizeof(float));
+    return sink;
+}
+
+static bool init_offline_engine_with_backend(AudioEngine* engine, EngineBackend backend) {
+    memset(engine, 0, sizeof(AudioEngine));
+    AudioEngineConfig config = audio_engine_config_init(ENGINE_LATENCY_MIXDOWN);
+    config.offline_only = true;
+    config.render_workers = 1;
+    config.backend = backend;
+    return audio_engine_init_with_config(engine, &config);
+}
+
+static bool init_offline_engine(AudioEngine* engine) {
+    return init_offline_engine_with_backend(engine, ENGINE_BACKEND_CALLBACK);
+}
+
+// Two tone tracks with effects, one routed through the node-heavy path of a
+// send to a shared reverb bus
+static void build_bus_session(AudioEngine* engine) {
+    audio_engine_add_track(engine, "A", 110.0f);
+    audio_engine_add_track(engine, "B", 330.0f);
+    audio_engine_add_effect(engine, 0, EFFECT_LOWPASS);
+    audio_engine_add_effect(engine, 1, EFFECT_DELAY);
+    int reverb = audio_engine_add_reverb_bus(engine, "Verb");
+    audio_engine_set_track_send(engine, 0, reverb, 0.5f);
+    audio_engine_set_track_send(engine, 1, reverb, 0.25f);
+    audio_engine_set_track_playing(engine, 0, true);
+    audio_engine_set_track_playing(engine, 1, true);
+}
+
+static float peak_of(const MemorySink* sink) {
+    float peak = 0.0f;
+    for (uint64_t i = 0; i < sink->count * CHANNELS; i++) {
+        if (fabsf(sink->frames[i]) > peak) peak = fabsf(sink->frames[i]);
+    }
+    return peak;
+}
+
+typedef struct {
+    int messages;
+    int warnings;
+    char last[ENGINE_LOG_MESSAGE_SIZE];
+} LogCapture;
+
+static void capture_log(void* user_data, EngineLogLevel level, const char* message) {
+    LogCapture* capture = (LogCapture*)user_data;
+    capture->messages++;
+    if (level >= ENGINE_LOG_WARNING) capture->warnings++;
+    snprintf(capture->last, sizeof(capture->last), "%s", message);
+}
+
+// The asynchronous sink runs on the drain thread
+typedef struct {
+    atomic_int messages;
+    atomic_int dropped_reports;
+    atomic_int per_thread[4];
+    atomic_bool hold;           // Park the drain thread inside the sink
+} AsyncCapture;
+
+static void async_capture_log(void* user_data, EngineLogLevel level, const char* message) {
+    AsyncCapture* capture = (AsyncCapture*)user_data;
+    while (atomic_load(&capture->hold)) {
+        engine_thread_sleep_ms(1);
+    }
+    int thread_index = 0;
+    if (strstr(message, "dropped")) {
+        atomic_fetch_add(&capture->dropped_reports, 1);
+        return;
+    }
+    if (level == ENGINE_LOG_INFO && sscanf(message, "thread %d", &thread_index) == 1 && thread_index < 4) {
+        atomic_fetch_add(&capture->per_thread[thread_index], 1);
+    }
+    atomic_fetch_add(&capture->messages, 1);
+}
+
+typedef struct {
+    int index;
+    int count;
+} LogProducer;
+
+static void log_producer(void* user_data) {
+    const LogProducer* producer = (const LogProducer*)user_data;
+    for (int i = 0; i < producer->count; i++) {
+        engine_log_rt(ENGINE_LOG_INFO, "thread %d message %d", producer->index, i);
+        if (i % 8 == 7) engine_thread_sleep_ms(1);   // Let the drain thread keep up
+    }
+}
+
+// ============================================================================
+// LOGGING
+// ============================================================================
+
+CTEST(engine_log, sink_receives_engine_messages) {
+    LogCapture capture = {0};
+    engine_log_set_sink(capture_log, &capture);
+    engine_log_set_level(ENGINE_LOG_INFO);
+
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    engine_log_flush();     // A running engine logs through the drain thread
+    ASSERT_TRUE(capture.messages > 0);
+
+    int before = capture.warnings;
+    ASSERT_FALSE(audio_engine_set_track_output(&engine, 7, BUS_MASTER));
+    engine_log_flush();
+    ASSERT_EQUAL(before + 1, capture.warnings);
+    ASSERT_NOT_NULL(strstr(capture.last, "Invalid track index"));
+
+    audio_engine_shutdown(&engine);
+    engine_log_set_level(ENGINE_LOG_WARNING);
+    engine_log_set_sink(NULL, NULL);
+}
+
+CTEST(engine_log, level_filters_messages) {
+    LogCapture capture = {0};
+    engine_log_set_sink(capture_log, &capture);
+    engine_log_set_level(ENGINE_LOG_WARNING);
+
+    engine_log(ENGINE_LOG_INFO, "dropped %d", 1);
+    engine_log(ENGINE_LOG_ERROR, "kept %d", 2);
+    ASSERT_EQUAL(1, capture.messages);
+    ASSERT_STR("kept 2", capture.last);
+
+    engine_log_set_sink(NULL, NULL);
+}
+
+CTEST(engine_log, async_delivers_from_many_threads) {
+    static AsyncCapture capture;
+    memset(&capture, 0, sizeof(capture));
+    engine_log_set_sink(async_capture_log, &capture);
+    engine_log_set_level(ENGINE_LOG_INFO);
+    uint64_t dropped_before = engine_log_dropped_count();
+    ASSERT_TRUE(engine_log_start_async());
+
+    EngineThread threads[4];
+    LogProducer producers[4];
+    for (int t = 0; t < 4; t++) {
+        producers[t] = (LogProducer){.index = t, .count = 64};
+        ASSERT_TRUE(engine_thread_start(&threads[t], log_producer, &producers[t], ENGINE_THREAD_PRIORITY_NORMAL, -1));
+    }
+    for (int t = 0; t < 4; t++) {
+        engine_thread_join(&threads[t]);
+    }
+    engine_log_flush();
+
+    ASSERT_EQUAL(dropped_before, engine_log_dropped_count());
+    ASSERT_EQUAL(4 * 64, atomic_load(&capture.messages));
+    for (int t = 0; t < 4; t++) {
+        ASSERT_EQUAL(64, atomic_load(&capture.per_thread[t]));
+    }
+
+    engine_log_stop_async();
+    engine_log_set_level(ENGINE_LOG_WARNING);
+    engine_log_set_sink(NULL, NULL);
+}
+
+CTEST(engine_log, full_ring_drops_and_reports) {
+    static AsyncCapture capture;
+    memset(&capture, 0, sizeof(capture));
+    atomic_store(&capture.hold, true);
+    engine_log_set_sink(async_capture_log, &capture);
+    engine_log_set_level(ENGINE_LOG_INFO);
+    uint64_t dropped_before = engine_log_dropped_count();
+    ASSERT_TRUE(engine_log_start_async());
+
+    // The drain thread is parked on (at most) the first record, which keeps
+    // its slot claimed, so exactly the excess is dropped
+    for (int i = 0; i < ENGINE_LOG_RING_CAPACITY + 10; i++) {
+        engine_log(ENGINE_LOG_INFO, "record %d", i);
+    }
+    ASSERT_EQUAL(dropped_before + 10, engine_log_dropped_count());
+
+    atomic_store(&capture.hold, false);
+    engine_log_flush();
+    engine_log_stop_async();
+    ASSERT_EQUAL(ENGINE_LOG_RING_CAPACITY, atomic_load(&capture.messages));
+    ASSERT_EQUAL(1, atomic_load(&capture.dropped_reports));
+
+    engine_log_set_level(ENGINE_LOG_WARNING);
+    engine_log_set_sink(NULL, NULL);
+}
+
+CTEST(engine_log, realtime_messages_need_the_drain_thread) {
+    LogCapture capture = {0};
+    engine_log_set_sink(capture_log, &capture);
+    uint64_t dropped_before = engine_log_dropped_count();
+
+    // Without a drain thread the real-time path drops instead of printing
+    engine_log_rt(ENGINE_LOG_ERROR, "from the audio thread");
+    ASSERT_EQUAL(0, capture.messages);
+    ASSERT_EQUAL(dropped_before + 1, engine_log_dropped_count());
+
+    engine_log_set_sink(NULL, NULL);
+}
+
+// ============================================================================
+// OFFLINE RENDERING
+// ============================================================================
+
+CTEST(offline_render, renders_exact_length_without_device) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_EQUAL(0, audio_engine_add_track(&engine, "Tone", 220.0f));
+    ASSERT_TRUE(audio_engine_set_track_playing(&engine, 0, true));
+
+    MemorySink sink = memory_sink_create(RENDER_FRAMES);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+    ASSERT_TRUE(audio_engine_render_offline(&engine, RENDER_FRAMES, &render_sink));
+    ASSERT_EQUAL(RENDER_FRAMES, (int)sink.count);
+    ASSERT_TRUE(peak_of(&sink) > 0.05f);
+
+    // Transport is forced on only for the render
+    ASSERT_FALSE(atomic_load(&engine.playing));
+
+    free(sink.frames);
+    audio_engine_shutdown(&engine);
+}
+
+CTEST(offline_render, stopped_tracks_render_silence) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_EQUAL(0, audio_engine_add_track(&engine, "Tone", 220.0f));
+
+    MemorySink sink = memory_sink_create(4096);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+    ASSERT_TRUE(audio_engine_render_offline(&engine, 4096, &render_sink));
+    ASSERT_DBL_NEAR_TOL(0.0, peak_of(&sink), 1e-9);
+
+    free(sink.frames);
+    audio_engine_shutdown(&engine);
+}
+
+CTEST(offline_render, identical_sessions_render_identically) {
+    static AudioEngine engines[2];
+    MemorySink sinks[2];
+    for (int e = 0; e < 2; e++) {
+        ASSERT_TRUE(init_offline_engine(&engines[e]));
+        ASSERT_EQUAL(0, audio_engine_add_track(&engines[e], "A", 110.0f));
+        ASSERT_EQUAL(1, audio_engine_add_track(&engines[e], "B", 330.0f));
+        ASSERT_TRUE(audio_engine_add_effect(&engines[e], 1, EFFECT_DELAY));
+        ASSERT_TRUE(audio_engine_add_convolution(&engines[e], 0, NULL, 0, 0));
+        audio_engine_set_track_playing(&engines[e], 0, true);
+        audio_engine_set_track_playing(&engines[e], 1, true);
+
+        sinks[e] = memory_sink_create(RENDER_FRAMES);
+        EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sinks[e]};
+        ASSERT_TRUE(audio_engine_render_offline(&engines[e], RENDER_FRAMES, &render_sink));
+    }
+    ASSERT_EQUAL(0, memcmp(sinks[0].frames, sinks[1].frames, sizeof(float) * RENDER_FRAMES * CHANNELS));
+
+    for (int e = 0; e < 2; e++) {
+        free(sinks[e].frames);
+        audio_engine_shutdown(&engines[e]);
+    }
+}
+
+CTEST(offline_render, node_graph_backend_matches_callback) {
+    static AudioEngine engines[2];
+    const EngineBackend backends[2] = {ENGINE_BACKEND_CALLBACK, ENGINE_BACKEND_NODE_GRAPH};
+    MemorySink sinks[2];
+    for (int e = 0; e < 2; e++) {
+        ASSERT_TRUE(init_offline_engine_with_backend(&engines[e], backends[e]));
+        build_bus_session(&engines[e]);
+        sinks[e] = memory_sink_create(RENDER_FRAMES);
+        EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sinks[e]};
+        ASSERT_TRUE(audio_engine_render_offline(&engines[e], RENDER_FRAMES, &render_sink));
+    }
+    ASSERT_NOT_NULL(engines[1].nodes);
+    ASSERT_TRUE(peak_of(&sinks[1]) > 0.05f);
+
+    // Same processing per block; only the summing order differs
+    float max_error = 0.0f;
+    for (int i = 0; i < RENDER_FRAMES * CHANNELS; i++) {
+        float error = fabsf(sinks[0].frames[i] - sinks[1].frames[i]);
+        if (error > max_error) max_error = error;
+    }
+    ASSERT_DBL_NEAR_TOL(0.0, max_error, 1e-5);
+
+    for (int e = 0; e < 2; e++) {
+        free(sinks[e].frames);
+        audio_engine_shutdown(&engines[e]);
+    }
+}
+
+CTEST(offline_render, node_graph_follows_routing_edits) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine_with_backend(&engine, ENGINE_BACKEND_NODE_GRAPH));
+    ASSERT_EQUAL(0, audio_engine_add_track(&engine, "Tone", 220.0f));
+    int bus = audio_engine_add_bus(&engine, "Group");
+    ASSERT_TRUE(audio_engine_set_track_output(&engine, 0, bus));
+    audio_engine_set_track_playing(&engine, 0, true);
+
+    MemorySink sink = memory_sink_create(4096);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+    ASSERT_TRUE(audio_engine_render_offline(&engine, 4096, &render_sink));
+    ASSERT_TRUE(peak_of(&sink) > 0.05f);
+
+    // Muting the group silences the track routed through it
+    ASSERT_TRUE(audio_engine_set_bus_mute(&engine, bus, true));
+    sink.count = 0;
+    ASSERT_TRUE(audio_engine_render_offline(&engine, 4096, &render_sink));
+    ASSERT_DBL_NEAR_TOL(0.0, peak_of(&sink), 1e-9);
+
+    // Routed straight to master it plays again
+    ASSERT_TRUE(audio_engine_set_track_output(&engine, 0, BUS_MASTER));
+    sink.count = 0;
+    ASSERT_TRUE(audio_engine_render_offline(&engine, 4096, &render_sink));
+    ASSERT_TRUE(peak_of(&sink) > 0.05f);
+
+    free(sink.frames);
+    audio_engine_shutdown(&engine);
+}
+
+// A reverb bus arrives with its reverb already wet only, without waiting
+// on the command queue, and a bus that cannot be added is not half there
+CTEST(offline_render, reverb_bus_is_added_whole_or_not_at_all) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    int reverb = audio_engine_add_reverb_bus(&engine, "Verb");
+    ASSERT_EQUAL(0, reverb);
+    const EffectChain* chain = &engine.buses[reverb].chain;
+    ASSERT_EQUAL(1, chain->count);
+    const Effect* effect = &chain->effects[chain->order[0]];
+    ASSERT_EQUAL(EFFECT_REVERB, effect->type);
+    ASSERT_DBL_NEAR_TOL(1.0, effect->reverb_params.mix, 1e-9);
+    ASSERT_DBL_NEAR_TOL(1.0, effect->reverb_params.send, 1e-9);
+
+    for (int b = 1; b < MAX_BUSES; b++) {
+        ASSERT_EQUAL(b, audio_engine_add_bus(&engine, "Group"));
+    }
+    ASSERT_EQUAL(-1, audio_engine_add_reverb_bus(&engine, "Verb 2"));
+    ASSERT_EQUAL(MAX_BUSES, engine.bus_count);
+
+    audio_engine_shutdown(&engine);
+}
+
+// Every slot up to MAX_TRACKS, across all storage chunks: the first and the
+// last track sound like a two-track session of the same tones, on both
+// backends, and commands reach tracks in later chunks
+CTEST(offline_render, full_track_capacity_renders_like_a_small_session) {
+    static AudioEngine engines[3];
+    const EngineBackend backends[3] = {ENGINE_BACKEND_CALLBACK, ENGINE_BACKEND_NODE_GRAPH, ENGINE_BACKEND_CALLBACK};
+    MemorySink sinks[3];
+    for (int e = 0; e < 3; e++) {
+        ASSERT_TRUE(init_offline_engine_with_backend(&engines[e], backends[e]));
+        int last = e < 2 ? MAX_TRACKS - 1 : 1;
+        char name[16];
+        for (int t = 0; t <= last; t++) {
+            snprintf(name, sizeof(name), "T%d", t);
+            ASSERT_EQUAL(t, audio_engine_add_track(&engines[e], name, t == last ? 330.0f : 110.0f));
+        }
+        audio_engine_set_track_playing(&engines[e], 0, true);
+        audio_engine_set_track_playing(&engines[e], last, true);
+        audio_engine_set_track_pan(&engines[e], last, 0.5f);
+
+        sinks[e] = memory_sink_create(8192);
+        EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sinks[e]};
+        ASSERT_TRUE(audio_engine_render_offline(&engines[e], 8192, &render_sink));
+    }
+    ASSERT_EQUAL(-1, audio_engine_add_track(&engines[0], "One too many", 220.0f));
+    ASSERT_EQUAL(MAX_TRACKS / TRACK_CHUNK_TRACKS, engines[0].tracks.chunk_count);
+
+    static EngineSnapshot snapshot;
+    audio_engine_snapshot(&engines[0], &snapshot);
+    ASSERT_EQUAL(MAX_TRACKS, snapshot.track_count);
+    ASSERT_TRUE(snapshot.tracks[MAX_TRACKS - 1].playing);
+    ASSERT_DBL_NEAR_TOL(0.5, snapshot.tracks[MAX_TRACKS - 1].pan, 1e-6);
+    ASSERT_FALSE(snapshot.tracks[MAX_TRACKS - 2].playing);
+
+    ASSERT_TRUE(peak_of(&sinks[2]) > 0.05f);
+    ASSERT_EQUAL(0, memcmp(sinks[0].frames, sinks[2].frames, sizeof(float) * 8192 * CHANNELS));
+    float max_error = 0.0f;
+    for (int i = 0; i < 8192 * CHANNELS; i++) {
+        float error = fabsf(sinks[1].frames[i] - sinks[2].frames[i]);
+        if (error > max_error) max_error = error;
+    }
+    ASSERT_DBL_NEAR_TOL(0.0, max_error, 1e-5);
+
+    for (int e = 0; e < 3; e++) {
+        free(sinks[e].frames);
+        audio_engine_shutdown(&engines[e]);
+    }
+}
+
+CTEST(offline_render, model_version_tracks_edits_not_meters) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    uint64_t version = audio_engine_get_model_version(&engine);
+    ASSERT_EQUAL(0, audio_engine_add_track(&engine, "Tone", 220.0f));
+    ASSERT_TRUE(audio_engine_get_model_version(&engine) > version);
+
+    // Commands count once the audio side has applied them
+    version = audio_engine_get_model_version(&engine);
+    audio_engine_set_track_playing(&engine, 0, true);
+    ASSERT_EQUAL((int)version, (int)audio_engine_get_model_version(&engine));
+    MemorySink sink = memory_sink_create(4096);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+    ASSERT_TRUE(audio_engine_render_offline(&engine, 4096, &render_sink));
+    ASSERT_TRUE(audio_engine_get_model_version(&engine) > version);
+
+    // Rendering alone (meters moving) leaves it alone
+    version = audio_engine_get_model_version(&engine);
+    sink.count = 0;
+    ASSERT_TRUE(audio_engine_render_offline(&engine, 4096, &render_sink));
+    ASSERT_EQUAL((int)version, (int)audio_engine_get_model_version(&engine));
+
+    free(sink.frames);
+    audio_engine_shutdown(&engine);
+}
+
+CTEST(offline_render, snapshot_copies_applied_state) {
+    static AudioEngine engine;
+    static EngineSnapshot snapshot;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_EQUAL(0, audio_engine_add_track(&engine, "Bass", 110.0f));
+    ASSERT_EQUAL(1, audio_engine_add_track(&engine, "Lead", 440.0f));
+    audio_engine_snapshot(&engine, &snapshot);
+    ASSERT_EQUAL(2, snapshot.track_count);
+    ASSERT_STR("Lead", snapshot.tracks[1].name);
+    ASSERT_FALSE(snapshot.tracks[0].mute);
+    ASSERT_NULL((void*)snapshot.tracks[0].clip_cache);
+    ASSERT_EQUAL((int)audio_engine_get_model_version(&engine), (int)snapshot.model_version);
+
+    // Queued commands show up once applied, and the old copy reads as stale
+    audio_engine_set_track_mute(&engine, 0, true);
+    audio_engine_set_track_volume(&engine, 1, 0.25f);
+    MemorySink sink = memory_sink_create(4096);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+    ASSERT_TRUE(audio_engine_render_offline(&engine, 4096, &render_sink));
+    ASSERT_NOT_EQUAL((int)audio_engine_get_model_version(&engine), (int)snapshot.model_version);
+    audio_engine_snapshot(&engine, &snapshot);
+    ASSERT_TRUE(snapshot.tracks[0].mute);
+    ASSERT_DBL_NEAR_TOL(0.25, snapshot.tracks[1].volume, 1e-6);
+
+    free(sink.frames);
+    audio_engine_shutdown(&engine);
+}
+
+CTEST(offline_render, control_thread_applies_requests_and_publishes) {
+    static AudioEngine engine;
+    static ControlThread control;
+    static EngineSnapshot snapshot;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_EQUAL(0, audio_engine_add_track(&engine, "Bass", 110.0f));
+    ASSERT_TRUE(control_thread_init(&control, &engine));
+
+    // Driven by hand: the first pass publishes the initial model
+    ASSERT_EQUAL(0, control_thread_process(&control));
+    ASSERT_TRUE(control_thread_poll_snapshot(&control, &snapshot));
+    ASSERT_EQUAL(1, snapshot.track_count);
+    ASSERT_FALSE(control_thread_poll_snapshot(&control, &snapshot));
+
+    ASSERT_TRUE(control_thread_request(&control, &(ControlRequest){.type = CONTROL_ADD_TRACK}));
+    ASSERT_TRUE(control_thread_request(&control, &(ControlRequest){.type = CONTROL_TOGGLE_TRACK_MUTE,
+                                                                   .track_index = 0}));
+    ASSERT_EQUAL(2, control_thread_process(&control));
+    ASSERT_TRUE(control_thread_poll_snapshot(&control, &snapshot));
+    ASSERT_EQUAL(2, snapshot.track_count);
+    ASSERT_STR("Track 2", snapshot.tracks[1].name);
+
+    // The mute lands once the audio side drains it, and the next pass
+    // publishes the moved version
+    MemorySink sink = memory_sink_create(4096);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+    ASSERT_TRUE(audio_engine_render_offline(&engine, 4096, &render_sink));
+    ASSERT_EQUAL(0, control_thread_process(&control));
+    ASSERT_TRUE(control_thread_poll_snapshot(&control, &snapshot));
+    ASSERT_TRUE(snapshot.tracks[0].mute);
+    ASSERT_EQUAL((int)audio_engine_get_model_version(&engine), (int)snapshot.model_version);
+    ASSERT_EQUAL(2, (int)atomic_load(&control.requests_applied));
+
+    control_thread_destroy(&control);
+    free(sink.frames);
+    audio_engine_shutdown(&engine);
+}
+
+CTEST(offline_render, dsp_load_and_profiling) {
+    static AudioEngine engine;
+    static float block[256 * CHANNELS];
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_EQUAL(0, audio_engine_add_track(&engine, "Tone", 440.0f));
+    ASSERT_TRUE(audio_engine_add_effect(&engine, 0, EFFECT_LOWPASS));
+    audio_engine_set_track_playing(&engine, 0, true);
+    audio_engine_set_playing(&engine, true);
+
+    DspLoadRecord load;
+    ASSERT_TRUE(audio_engine_read_dsp_load(&engine, &load));
+    ASSERT_EQUAL(0, (int)load.callbacks);
+
+    // Timers stay at zero until profiling is switched on
+    ASSERT_TRUE(audio_engine_process_block(&engine, block, 256));
+    TrackProfile profile;
+    ASSERT_TRUE(audio_engine_get_track_profile(&engine, 0, &profile));
+    ASSERT_EQUAL(0, (int)profile.track_ns);
+
+    audio_engine_set_profiling(&engine, true);
+    int blocks = SAMPLE_RATE * ENGINE_DSP_LOAD_WINDOW_MS / 1000 / 256 + 1;
+    for (int i = 0; i < blocks; i++) {
+        ASSERT_TRUE(audio_engine_process_block(&engine, block, 256));
+    }
+    ASSERT_TRUE(audio_engine_read_dsp_load(&engine, &load));
+    ASSERT_EQUAL(blocks + 1, (int)load.callbacks);
+    ASSERT_TRUE(load.load > 0.0f);
+    ASSERT_TRUE(load.load_max >= load.load_avg && load.load_avg >= load.load_min);
+    ASSERT_TRUE(load.load_max > 0.0f);
+    ASSERT_EQUAL((int)audio_engine_get_deadline_misses(&engine), (int)load.late_callbacks);
+
+    ASSERT_TRUE(audio_engine_get_track_profile(&engine, 0, &profile));
+    ASSERT_TRUE(profile.track_ns > 0);
+    ASSERT_TRUE(profile.effect_ns[0] > 0);
+    ASSERT_TRUE(profile.effect_ns[0] <= profile.track_ns);
+    ASSERT_FALSE(audio_engine_get_track_profile(&engine, MAX_TRACKS, &profile));
+
+    audio_engine_shutdown(&engine);
+}
+
+CTEST(offline_render, failing_sink_aborts) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+
+    MemorySink sink = memory_sink_create(RENDER_FRAMES);
+    sink.abort_after = ENGINE_OFFLINE_CHUNK_FRAMES;
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+    ASSERT_FALSE(audio_engine_render_offline(&engine, RENDER_FRAMES, &render_sink));
+    ASSERT_EQUAL(ENGINE_OFFLINE_CHUNK_FRAMES, (int)sink.count);
+
+    free(sink.frames);
+    audio_engine_shutdown(&engine);
+}
+
+CTEST(offline_render, writes_wav_file) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_EQUAL(0, audio_engine_add_track(&engine, "Tone", 440.0f));
+    audio_engine_set_track_playing(&engine, 0, true);
+    ASSERT_TRUE(audio_engine_render_to_wav(&engine, TEST_WAV_PATH, RENDER_FRAMES, ma_format_s16));
+    ASSERT_FALSE(audio_engine_render_to_wav(&engine, TEST_WAV_PATH, RENDER_FRAMES, ma_format_u8));
+    audio_engine_shutdown(&engine);
+
+    ma_decoder decoder;
+    ASSERT_EQUAL(MA_SUCCESS, ma_decoder_init_file(TEST_WAV_PATH, NULL, &decoder));
+    ma_uint64 length = 0;
+    ma_decoder_get_length_in_pcm_frames(&decoder, &length);
+    ASSERT_EQUAL(RENDER_FRAMES, (int)length);
+    ASSERT_EQUAL(ma_format_s16, decoder.outputFormat);
+    ASSERT_EQUAL(CHANNELS, (int)decoder.outputChannels);
+    ma_decoder_uninit(&decoder);
+    remove(TEST_WAV_PATH);
+}
+
+// Rendered at the engine rate and converted on the way out
+CTEST(offline_render, exports_wav_at_another_rate) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_EQUAL(0, audio_engine_add_track(&engine, "Tone", 440.0f));
+    audio_engine_set_track_playing(&engine, 0, true);
+    ASSERT_TRUE(audio_engine_export_wav(&engine, TEST_WAV_PATH, RENDER_FRAMES, ma_format_f32, 44100, RESAMPLER_SINC));
+    audio_engine_shutdown(&engine);
+
+    ma_decoder decoder;
+    ASSERT_EQUAL(MA_SUCCESS, ma_decoder_init_file(TEST_WAV_PATH, NULL, &decoder));
+    ma_uint64 length = 0;
+    ma_decoder_get_length_in_pcm_frames(&decoder, &length);
+    ASSERT_EQUAL((int)resampler_output_length(RENDER_FRAMES, SAMPLE_RATE, 44100), (int)length);
+    ASSERT_EQUAL(44100, (int)decoder.outputSampleRate);
+    static float frames[RENDER_FRAMES * CHANNELS];
+    ma_uint64 decoded = 0;
+    ma_decoder_read_pcm_frames(&decoder, frames, length, &decoded);
+    ma_decoder_uninit(&decoder);
+    remove(TEST_WAV_PATH);
+
+    // Still the tone: its period is 44100 / 440 frames at the new rate
+    float peak = 0.0f;
+    double correlation = 0.0, energy = 0.0;
+    for (ma_uint64 i = 1000; i + 100 < decoded; i++) {
+        float sample = frames[i * CHANNELS];
+        float period_later = frames[(i + 100) * CHANNELS];
+        if (fabsf(sample) > peak) peak = fabsf(sample);
+        correlation += (double)sample * period_later;
+        energy += (double)sample * sample;
+    }
+    ASSERT_TRUE(peak > 0.1f);
+    ASSERT_TRUE(correlation > 0.99 * energy);
+}
+
+CTEST(offline_render, engine_runs_at_the_configured_rate) {
+    static AudioEngine engine;
+    memset(&engine, 0, sizeof(AudioEngine));
+    AudioEngineConfig config = audio_engine_config_init(ENGINE_LATENCY_MIXDOWN);
+    config.offline_only = true;
+    config.render_workers = 1;
+    config.sample_rate = 1000;
+    ASSERT_FALSE(audio_engine_init_with_config(&engine, &config));
+
+    config.sample_rate = 96000;
+    ASSERT_TRUE(audio_engine_init_with_config(&engine, &config));
+    ASSERT_EQUAL(0, audio_engine_add_track(&engine, "Tone", 440.0f));
+    audio_engine_set_track_playing(&engine, 0, true);
+    ASSERT_TRUE(audio_engine_render_to_wav(&engine, TEST_WAV_PATH, RENDER_FRAMES, ma_format_f32));
+    EngineSnapshot snapshot;
+    audio_engine_snapshot(&engine, &snapshot);
+    ASSERT_EQUAL(96000, (int)snapshot.sample_rate);
+    audio_engine_shutdown(&engine);
+
+    ma_decoder decoder;
+    ASSERT_EQUAL(MA_SUCCESS, ma_decoder_init_file(TEST_WAV_PATH, NULL, &decoder));
+    ma_uint64 length = 0;
+    ma_decoder_get_length_in_pcm_frames(&decoder, &length);
+    ASSERT_EQUAL(RENDER_FRAMES, (int)length);
+    ASSERT_EQUAL(96000, (int)decoder.outputSampleRate);
+    ma_decoder_uninit(&decoder);
+    remove(TEST_WAV_PATH);
+}
+
+// ============================================================================
+// AUTOMATION
+// ============================================================================
+
+#define RAMP_FRAMES 8192
+
+CTEST(automation, lane_interpolates_and_holds) {
+    const AutomationPoint points[] = {{200, 1.0f}, {100, 0.0f}, {300, 0.5f}};
+    AutomationLane* lane = automation_lane_create(points, 3);
+    ASSERT_NOT_NULL(lane);
+    ASSERT_DBL_NEAR_TOL(0.0, automation_lane_value_at(lane, 0), 1e-9);
+    ASSERT_DBL_NEAR_TOL(0.5, automation_lane_value_at(lane, 150), 1e-6);
+    ASSERT_DBL_NEAR_TOL(1.0, automation_lane_value_at(lane, 200), 1e-9);
+    ASSERT_DBL_NEAR_TOL(0.75, automation_lane_value_at(lane, 250), 1e-6);
+    ASSERT_DBL_NEAR_TOL(0.5, automation_lane_value_at(lane, 100000), 1e-9);
+
+    // Breakpoints inside [50, 250) cut the block; ends are always present
+    const AutomationLane* lanes[2] = {lane, NULL};
+    uint32_t cuts[AUTOMATION_MAX_CUTS];
+    ASSERT_EQUAL(4, (int)automation_block_cuts(lanes, 2, 50, 200, cuts));
+    ASSERT_EQUAL(0, (int)cuts[0]);
+    ASSERT_EQUAL(50, (int)cuts[1]);
+    ASSERT_EQUAL(150, (int)cuts[2]);
+    ASSERT_EQUAL(200, (int)cuts[3]);
+    ASSERT_EQUAL(2, (int)automation_block_cuts(lanes, 2, 400, 200, cuts));
+
+    ASSERT_NULL(automation_lane_create(points, 0));
+    automation_lane_destroy(lane);
+}
+
+CTEST(automation, volume_step_lands_on_its_frame) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_EQUAL(0, audio_engine_add_track(&engine, "Tone", 220.0f));
+    audio_engine_set_track_playing(&engine, 0, true);
+    const AutomationPoint step[] = {{0, 0.0f}, {1000, 0.0f}, {1000, 1.0f}};
+    ASSERT_TRUE(audio_engine_set_track_automation(&engine, 0, AUTOMATION_TRACK_VOLUME, 0, 0, step, 3));
+
+    MemorySink sink = memory_sink_create(4096);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+    ASSERT_TRUE(audio_engine_render_offline(&engine, 4096, &render_sink));
+    for (int i = 0; i < 1000 * CHANNELS; i++) {
+        ASSERT_DBL_NEAR_TOL(0.0, sink.frames[i], 1e-9);
+    }
+    ASSERT_TRUE(fabsf(sink.frames[1001 * CHANNELS]) > 0.0f);
+    ASSERT_EQUAL(4096, (int)audio_engine_get_transport_position(&engine));
+
+    free(sink.frames);
+    audio_engine_shutdown(&engine);
+}
+
+// A volume ramp from 0 to 1 scales a plain full-volume render frame by frame
+CTEST(automation, linear_ramp_is_sample_accurate) {
+    static AudioEngine engines[2];
+    MemorySink sinks[2];
+    const AutomationPoint ramp[] = {{0, 0.0f}, {RAMP_FRAMES, 1.0f}};
+    for (int e = 0; e < 2; e++) {
+        ASSERT_TRUE(init_offline_engine(&engines[e]));
+        ASSERT_EQUAL(0, audio_engine_add_track(&engines[e], "Tone", 330.0f));
+        audio_engine_set_track_volume(&engines[e], 0, 1.0f);
+        audio_engine_set_track_playing(&engines[e], 0, true);
+        sinks[e] = memory_sink_create(RAMP_FRAMES);
+    }
+    ASSERT_TRUE(audio_engine_set_track_automation(&engines[1], 0, AUTOMATION_TRACK_VOLUME, 0, 0, ramp, 2));
+    for (int e = 0; e < 2; e++) {
+        EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sinks[e]};
+        ASSERT_TRUE(audio_engine_render_offline(&engines[e], RAMP_FRAMES, &render_sink));
+    }
+
+    // Skip the plain render's fade-in from silence on its first block
+    for (uint32_t i = engines[0].block_frames; i < RAMP_FRAMES; i++) {
+        float expected = sinks[0].frames[i * CHANNELS] * ((float)i / (float)RAMP_FRAMES);
+        ASSERT_DBL_NEAR_TOL(expected, sinks[1].frames[i * CHANNELS], 1e-5);
+    }
+
+    for (int e = 0; e < 2; e++) {
+        free(sinks[e].frames);
+        audio_engine_shutdown(&engines[e]);
+    }
+}
+
+CTEST(automation, effect_param_follows_lane) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_EQUAL(0, audio_engine_add_track(&engine, "Tone", 220.0f));
+    ASSERT_TRUE(audio_engine_add_effect(&engine, 0, EFFECT_GAIN));
+    audio_engine_set_track_playing(&engine, 0, true);
+
+    // Effect parameters land on the lane at each block's last frame: a fade
+    // over the second block is silent from the third on
+    const AutomationPoint fade[] = {{ENGINE_MIXDOWN_PERIOD_FRAMES, 1.0f}, {2 * ENGINE_MIXDOWN_PERIOD_FRAMES - 1, 0.0f}};
+    ASSERT_FALSE(audio_engine_set_track_automation(&engine, 0, AUTOMATION_EFFECT_PARAM, 1, 0, fade, 2));
+    ASSERT_FALSE(audio_engine_set_track_automation(&engine, 0, AUTOMATION_EFFECT_PARAM, 0, 1, fade, 2));
+    ASSERT_TRUE(audio_engine_set_track_automation(&engine, 0, AUTOMATION_EFFECT_PARAM, 0, 0, fade, 2));
+
+    MemorySink sink = memory_sink_create(RAMP_FRAMES);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+    ASSERT_TRUE(audio_engine_render_offline(&engine, RAMP_FRAMES, &render_sink));
+    ASSERT_TRUE(peak_of(&sink) > 0.05f);
+    for (int i = 2 * ENGINE_MIXDOWN_PERIOD_FRAMES * CHANNELS; i < RAMP_FRAMES * CHANNELS; i++) {
+        ASSERT_DBL_NEAR_TOL(0.0, sink.frames[i], 1e-9);
+    }
+
+    // Replacing, clearing and removing the effect retire the old lanes
+    ASSERT_TRUE(audio_engine_set_track_automation(&engine, 0, AUTOMATION_EFFECT_PARAM, 0, 0, fade, 2));
+    ASSERT_TRUE(audio_engine_set_track_automation(&engine, 0, AUTOMATION_TRACK_PAN, 0, 0, fade, 2));
+    ASSERT_TRUE(audio_engine_set_track_automation(&engine, 0, AUTOMATION_TRACK_PAN, 0, 0, NULL, 0));
+    ASSERT_TRUE(audio_engine_remove_effect(&engine, 0, 0));
+
+    free(sink.frames);
+    audio_engine_shutdown(&engine);
+}
+
+// ============================================================================
+// INSTRUMENT TRACKS
+// ============================================================================
+
+CTEST(instrument, notes_sound_and_release_to_silence) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_EQUAL(0, audio_engine_add_track(&engine, "Tone", 220.0f));
+    ASSERT_EQUAL(1, audio_engine_add_instrument_track(&engine, "Keys", OSC_SAW));
+    ASSERT_FALSE(audio_engine_note_on(&engine, 0, 60, 1.0f));
+    ASSERT_FALSE(audio_engine_note_on(&engine, 1, 128, 1.0f));
+    ASSERT_EQUAL(-1, audio_engine_add_instrument_track(&engine, "Bad", OSC_WAVEFORM_COUNT));
+
+    EngineSnapshot snapshot;
+    audio_engine_snapshot(&engine, &snapshot);
+    ASSERT_FALSE(snapshot.tracks[0].instrument);
+    ASSERT_TRUE(snapshot.tracks[1].instrument);
+    ASSERT_TRUE(snapshot.tracks[1].playing);
+
+    // No notes: silent, although the track is playing
+    MemorySink sink = memory_sink_create(4 * 4096);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+    ASSERT_TRUE(audio_engine_render_offline(&engine, 4096, &render_sink));
+    ASSERT_DBL_NEAR_TOL(0.0, peak_of(&sink), 1e-9);
+
+    // A chord; the pool renders every voice
+    ASSERT_TRUE(audio_engine_note_on(&engine, 1, 60, 1.0f));
+    ASSERT_TRUE(audio_engine_note_on(&engine, 1, 64, 0.8f));
+    ASSERT_TRUE(audio_engine_note_on(&engine, 1, 67, 0.6f));
+    sink.count = 0;
+    ASSERT_TRUE(audio_engine_render_offline(&engine, 4096, &render_sink));
+    ASSERT_TRUE(peak_of(&sink) > 0.1f);
+    ASSERT_EQUAL(3, voice_pool_active_count(&track_store_track(&engine.tracks, 1)->voices));
+
+    // Released voices fade out within the release time and leave the pool
+    ASSERT_TRUE(audio_engine_all_notes_off(&engine, 1));
+    sink.count = 0;
+    ASSERT_TRUE(audio_engine_render_offline(&engine, 2 * 4096, &render_sink));
+    ASSERT_EQUAL(0, voice_pool_active_count(&track_store_track(&engine.tracks, 1)->voices));
+    for (int i = 6144 * CHANNELS; i < 2 * 4096 * CHANNELS; i++) {     // Release is 5760 frames
+        ASSERT_DBL_NEAR_TOL(0.0, sink.frames[i], 1e-9);
+    }
+
+    free(sink.frames);
+    audio_engine_shutdown(&engine);
+}
+
+// ============================================================================
+// LIVE MIDI
+// ============================================================================
+
+#define MIDI_PERIOD 4096        // One offline chunk per period
+
+// Stamp for an event arriving frames after the current period started
+static uint64_t midi_stamp(const AudioEngine* engine, uint32_t frames) {
+    return engine->midi_block_ns + ((uint64_t)frames * 1000000000ULL + SAMPLE_RATE - 1) / SAMPLE_RATE;
+}
+
+static int first_sounding_frame(const MemorySink* sink) {
+    for (uint64_t i = 0; i < sink->count; i++) {
+        if (sink->frames[i * CHANNELS] != 0.0f) return (int)i;
+    }
+    return -1;
+}
+
+CTEST(midi, event_offsets_keep_spacing_and_clamp) {
+    uint64_t anchor = 1000000;
+    ASSERT_EQUAL_U(0, midi_event_frame_offset(anchor - 5, anchor, 256, 48000));        // Late
+    ASSERT_EQUAL_U(0, midi_event_frame_offset(anchor + 1000, anchor, 256, 48000));
+    ASSERT_EQUAL_U(48, midi_event_frame_offset(anchor + 1000000, anchor, 256, 48000)); // 1 ms
+    ASSERT_EQUAL_U(255, midi_event_frame_offset(anchor + 500000000, anchor, 256, 48000));
+    ASSERT_EQUAL_U(0, midi_event_frame_offset(anchor + 1000000, anchor, 0, 48000));
+}
+
+CTEST(midi, note_lands_on_its_frame_on_armed_tracks) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_EQUAL(0, audio_engine_add_instrument_track(&engine, "Keys", OSC_SAW));
+    ASSERT_EQUAL(1, audio_engine_add_instrument_track(&engine, "Pad", OSC_SAW));
+    ASSERT_FALSE(audio_engine_set_track_armed(&engine, 2, true));
+    ASSERT_TRUE(audio_engine_set_track_armed(&engine, 0, true));
+    voice_pool_set_envelope(&track_store_track(&engine.tracks, 0)->voices, 0.0f, 0.0f);
+
+    MemorySink sink = memory_sink_create(MIDI_PERIOD);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+    ASSERT_TRUE(audio_engine_render_offline(&engine, MIDI_PERIOD, &render_sink));
+
+    // Arrives 100 frames into a period, plays 100 frames into the next
+    MidiEvent note_on = {.time_ns = midi_stamp(&engine, 100), .status = MIDI_NOTE_ON, .data1 = 69, .data2 = 127};
+    ASSERT_TRUE(audio_engine_push_midi(&engine, &note_on));
+    sink.count = 0;
+    ASSERT_TRUE(audio_engine_render_offline(&engine, MIDI_PERIOD, &render_sink));
+    int first = first_sounding_frame(&sink);
+    ASSERT_TRUE(first >= 100 && first <= 102);
+    ASSERT_EQUAL(1, voice_pool_active_count(&track_store_track(&engine.tracks, 0)->voices));
+    ASSERT_EQUAL(0, voice_pool_active_count(&track_store_track(&engine.tracks, 1)->voices));
+
+    // Controllers and note-off; disarming stops input reaching the track
+    MidiEvent volume = {.time_ns = midi_stamp(&engine, 10), .status = MIDI_CONTROL_CHANGE,
+                        .data1 = MIDI_CC_VOLUME, .data2 = 127};
+    MidiEvent note_off = {.time_ns = midi_stamp(&engine, 20), .status = MIDI_NOTE_OFF, .data1 = 69};
+    ASSERT_TRUE(audio_engine_push_midi(&engine, &volume));
+    ASSERT_TRUE(audio_engine_push_midi(&engine, &note_off));
+    sink.count = 0;
+    ASSERT_TRUE(audio_engine_render_offline(&engine, MIDI_PERIOD, &render_sink));
+    ASSERT_DBL_NEAR_TOL(1.0, track_store_mix(&engine.tracks, 0)->volume[0], 1e-6);
+    ASSERT_EQUAL(0, voice_pool_active_count(&track_store_track(&engine.tracks, 0)->voices));
+
+    ASSERT_TRUE(audio_engine_set_track_armed(&engine, 0, false));
+    note_on.time_ns = midi_stamp(&engine, 0);
+    ASSERT_TRUE(audio_engine_push_midi(&engine, &note_on));
+    sink.count = 0;
+    ASSERT_TRUE(audio_engine_render_offline(&engine, MIDI_PERIOD, &render_sink));
+    ASSERT_EQUAL(0, voice_pool_active_count(&track_store_track(&engine.tracks, 0)->voices));
+    ASSERT_EQUAL(-1, first_sounding_frame(&sink));
+
+    free(sink.frames);
+    audio_engine_shutdown(&engine);
+}
+
+CTEST(midi, armed_input_is_recorded_at_transport_frames) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_EQUAL(0, audio_engine_add_instrument_track(&engine, "Keys", OSC_SINE));
+    ASSERT_TRUE(audio_engine_set_track_armed(&engine, 0, true));
+
+    MemorySink sink = memory_sink_create(MIDI_PERIOD);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+    ASSERT_TRUE(audio_engine_render_offline(&engine, MIDI_PERIOD, &render_sink));
+
+    MidiEvent events[2] = {
+        {.time_ns = midi_stamp(&engine, 100), .status = MIDI_NOTE_ON | 3, .data1 = 60, .data2 = 90},
+        {.time_ns = midi_stamp(&engine, 300), .status = MIDI_NOTE_OFF | 3, .data1 = 60},
+    };
+    ASSERT_TRUE(audio_engine_push_midi(&engine, &events[0]));
+    ASSERT_TRUE(audio_engine_push_midi(&engine, &events[1]));
+    sink.count = 0;
+    ASSERT_TRUE(audio_engine_render_offline(&engine, MIDI_PERIOD, &render_sink));
+
+    RecordedMidiEvent recorded[4];
+    ASSERT_EQUAL_U(2, audio_engine_read_recorded_midi(&engine, recorded, 4));
+    ASSERT_EQUAL_U(MIDI_PERIOD + 100, recorded[0].frame);
+    ASSERT_EQUAL_U(MIDI_PERIOD + 300, recorded[1].frame);
+    ASSERT_EQUAL(0, recorded[0].track_index);
+    ASSERT_EQUAL(MIDI_NOTE_ON | 3, recorded[0].status);
+    ASSERT_EQUAL(90, recorded[0].data2);
+    ASSERT_EQUAL_U(0, audio_engine_read_recorded_midi(&engine, recorded, 4));
+
+    EngineSnapshot snapshot;
+    audio_engine_snapshot(&engine, &snapshot);
+    ASSERT_TRUE(snapshot.tracks[0].armed);
+
+    free(sink.frames);
+    audio_engine_shutdown(&engine);
+}
+
+// ============================================================================
+// AUDIO INPUT AND RECORDING
+// ============================================================================
+
+#define INPUT_BLOCK 512
+#define TEST_TAKE_PATH(track) "./track0" #track "_take001" CLIP_CACHE_EXTENSION
+
+// A distinct, reproducible input sample for every frame and channel
+static float input_sample(uint64_t frame, int channel) {
+    float value = (float)(frame % 1000) * 0.0005f;
+    return channel == 0 ? value : -value;
+}
+
+static void fill_input(float* input, uint64_t first_frame, uint32_t frame_count) {
+    for (uint32_t i = 0; i < frame_count; i++) {
+        input[i * CHANNELS] = input_sample(first_frame + i, 0);
+        input[i * CHANNELS + 1] = input_sample(first_frame + i, 1);
+    }
+}
+
+static void add_input_track(AudioEngine* engine, const char* name) {
+    int track = audio_engine_add_track(engine, name, 0.0f);
+    audio_engine_set_track_input(engine, track, true);
+    audio_engine_set_track_armed(engine, track, true);
+    audio_engine_set_track_playing(engine, track, true);
+}
+
+// Every frame of a recorded take matches the input fed from `first_frame`
+static bool take_matches_input(const char* path, uint64_t frames, uint64_t first_frame) {
+    ClipCache cache;
+    if (!clip_cache_open(&cache, path)) {
+        return false;
+    }
+    bool ok = clip_cache_frame_count(&cache) == frames && cache.header->channels == 2;
+    float left[INPUT_BLOCK];
+    float right[INPUT_BLOCK];
+    for (uint64_t frame = 0; ok && frame < frames; frame += INPUT_BLOCK) {
+        uint32_t count = frames - frame < INPUT_BLOCK ? (uint32_t)(frames - frame) : INPUT_BLOCK;
+        clip_cache_read(&cache, frame, left, right, count);
+        for (uint32_t i = 0; ok && i < count; i++) {
+            ok = left[i] == input_sample(first_frame + frame + i, 0) &&
+                 right[i] == input_sample(first_frame + frame + i, 1);
+        }
+    }
+    clip_cache_close(&cache);
+    return ok;
+}
+
+CTEST(recording, input_is_monitored_and_recorded_to_a_clip) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_FALSE(audio_engine_start_recording(&engine, "."));     // No armed input tracks
+    ASSERT_FALSE(audio_engine_stop_recording(&engine));
+    add_input_track(&engine, "Mic");
+    audio_engine_set_playing(&engine, true);
+
+    // Commands (the arming) are applied by the first block; recording
+    // starts with the second
+    float input[INPUT_BLOCK * CHANNELS];
+    float out[INPUT_BLOCK * CHANNELS];
+    fill_input(input, 0, INPUT_BLOCK);
+    ASSERT_TRUE(audio_engine_process_duplex_block(&engine, input, out, INPUT_BLOCK));
+    ASSERT_TRUE(audio_engine_start_recording(&engine, "."));
+    EngineSnapshot snapshot;
+    audio_engine_snapshot(&engine, &snapshot);
+    ASSERT_TRUE(snapshot.recording);
+    ASSERT_TRUE(snapshot.tracks[0].input);
+    ASSERT_TRUE(snapshot.tracks[0].recording);
+
+    float peak = 0.0f;
+    for (int block = 1; block <= 40; block++) {
+        fill_input(input, (uint64_t)block * INPUT_BLOCK, INPUT_BLOCK);
+        ASSERT_TRUE(audio_engine_process_duplex_block(&engine, input, out, INPUT_BLOCK));
+        for (int i = 0; i < INPUT_BLOCK * CHANNELS; i++) {
+            if (fabsf(out[i]) > peak) peak = fabsf(out[i]);
+        }
+    }
+    ASSERT_TRUE(peak > 0.05f);
+    ClipRecordingStats stats;
+    ASSERT_TRUE(audio_engine_get_track_recording_stats(&engine, 0, &stats));
+    ASSERT_EQUAL_U(INPUT_BLOCK, stats.start_frame);
+    ASSERT_EQUAL_U(0, stats.dropped_frames);
+
+    // Stopping flushes the buffered tail and finishes the file
+    ASSERT_TRUE(audio_engine_stop_recording(&engine));
+    ASSERT_FALSE(audio_engine_get_track_recording_stats(&engine, 0, &stats));
+    ASSERT_TRUE(take_matches_input(TEST_TAKE_PATH(0), 40 * INPUT_BLOCK, INPUT_BLOCK));
+
+    ClipCache cache;
+    ASSERT_TRUE(clip_cache_open(&cache, TEST_TAKE_PATH(0)));
+    uint64_t peak_count = 0;
+    const ClipPeak* peaks = clip_cache_peaks(&cache, 0, 0, &peak_count);
+    ASSERT_EQUAL_U((40 * INPUT_BLOCK + CLIP_CACHE_PEAK_FRAMES - 1) / CLIP_CACHE_PEAK_FRAMES, peak_count);
+    ASSERT_DBL_NEAR_TOL(input_sample(INPUT_BLOCK, 0), peaks[0].min, 1e-9);
+    clip_cache_close(&cache);
+
+    audio_engine_shutdown(&engine);
+    remove(TEST_TAKE_PATH(0));
+}
+
+CTEST(recording, multitrack_takes_wrap_the_ring_without_drops) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    add_input_track(&engine, "Left");
+    add_input_track(&engine, "Right");
+    audio_engine_set_playing(&engine, true);
+    float input[INPUT_BLOCK * CHANNELS];
+    float out[INPUT_BLOCK * CHANNELS];
+    fill_input(input, 0, INPUT_BLOCK);
+    ASSERT_TRUE(audio_engine_process_duplex_block(&engine, input, out, INPUT_BLOCK));     // Applies the arming
+    ASSERT_TRUE(audio_engine_start_recording(&engine, "."));
+
+    // Longer than the ring, at no more than a few times real time
+    const int blocks = CLIP_RECORD_RING_FRAMES / INPUT_BLOCK + 64;
+    for (int block = 1; block <= blocks; block++) {
+        fill_input(input, (uint64_t)block * INPUT_BLOCK, INPUT_BLOCK);
+        ASSERT_TRUE(audio_engine_process_duplex_block(&engine, input, out, INPUT_BLOCK));
+        if (block % 8 == 7) engine_thread_sleep_ms(1);
+    }
+    ClipRecordingStats stats[2];
+    ASSERT_TRUE(audio_engine_get_track_recording_stats(&engine, 0, &stats[0]));
+    ASSERT_TRUE(audio_engine_get_track_recording_stats(&engine, 1, &stats[1]));
+    ASSERT_EQUAL_U(0, stats[0].dropped_frames + stats[1].dropped_frames);
+    ASSERT_TRUE(stats[0].written_frames > 0);
+
+    ASSERT_TRUE(audio_engine_stop_recording(&engine));
+    ASSERT_TRUE(take_matches_input(TEST_TAKE_PATH(0), (uint64_t)blocks * INPUT_BLOCK, INPUT_BLOCK));
+    ASSERT_TRUE(take_matches_input(TEST_TAKE_PATH(1), (uint64_t)blocks * INPUT_BLOCK, INPUT_BLOCK));
+
+    audio_engine_shutdown(&engine);
+    remove(TEST_TAKE_PATH(0));
+    remove(TEST_TAKE_PATH(1));
+}
+
+// The node graph renders whole blocks and reads ahead within them, so it is
+// fed device-sized periods here: a period equal to the block, as on a device
+#define NODE_INPUT_BLOCK ENGINE_MIXDOWN_PERIOD_FRAMES
+
+CTEST(recording, node_graph_monitors_input_like_callback) {
+    static AudioEngine engines[2];
+    static float outputs[2][4 * NODE_INPUT_BLOCK * CHANNELS];
+    static float input[NODE_INPUT_BLOCK * CHANNELS];
+    for (int e = 0; e < 2; e++) {
+        ASSERT_TRUE(init_offline_engine_with_backend(&engines[e], e ? ENGINE_BACKEND_NODE_GRAPH
+                                                                    : ENGINE_BACKEND_CALLBACK));
+        ASSERT_EQUAL(NODE_INPUT_BLOCK, (int)engines[e].block_frames);
+        add_input_track(&engines[e], "Mic");
+        audio_engine_add_effect(&engines[e], 0, EFFECT_LOWPASS);
+        audio_engine_set_playing(&engines[e], true);
+        for (int block = 0; block < 4; block++) {
+            fill_input(input, (uint64_t)block * NODE_INPUT_BLOCK, NODE_INPUT_BLOCK);
+            ASSERT_TRUE(audio_engine_process_duplex_block(&engines[e], input,
+                                                          outputs[e] + block * NODE_INPUT_BLOCK * CHANNELS,
+                                                          NODE_INPUT_BLOCK));
+        }
+        audio_engine_shutdown(&engines[e]);
+    }
+    float peak = 0.0f;
+    for (int i = 0; i < 4 * NODE_INPUT_BLOCK * CHANNELS; i++) {
+        ASSERT_DBL_NEAR_TOL(outputs[0][i], outputs[1][i], 1e-5);
+        if (fabsf(outputs[0][i]) > peak) peak = fabsf(outputs[0][i]);
+    }
+    ASSERT_TRUE(peak > 0.01f);
+}
+
+// ============================================================================
+// LATENCY COMPENSATION
+// ============================================================================
+
+#define PDC_FRAMES 6000
+#define PDC_TONE_HZ 440.0f
+
+// One plain tone, as every path should deliver it to master
+static bool render_reference_tone(MemorySink* sink) {
+    static AudioEngine engine;
+    if (!init_offline_engine(&engine)) return false;
+    audio_engine_add_track(&engine, "Tone", PDC_TONE_HZ);
+    audio_engine_set_track_playing(&engine, 0, true);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = sink};
+    bool ok = audio_engine_render_offline(&engine, PDC_FRAMES, &render_sink);
+    audio_engine_shutdown(&engine);
+    return ok;
+}
+
+// Both tracks play the reference tone: aligned at master, the mix is the
+// reference doubled and delayed by the compensated latency
+static bool paths_are_aligned(const MemorySink* mix, const MemorySink* reference, uint32_t latency, float tolerance) {
+    for (uint64_t i = 0; i < mix->count * CHANNELS; i++) {
+        uint64_t frame = i / CHANNELS;
+        float expected = frame < latency ? 0.0f : 2.0f * reference->frames[i - (uint64_t)latency * CHANNELS];
+        if (fabsf(mix->frames[i] - expected) > tolerance) {
+            printf("  frame %llu: %g, expected %g\n", (unsigned long long)frame, mix->frames[i], expected);
+            return false;
+        }
+    }
+    return true;
+}
+
+CTEST(latency, latent_track_delays_the_others) {
+    MemorySink reference = memory_sink_create(PDC_FRAMES);
+    ASSERT_TRUE(render_reference_tone(&reference));
+
+    for (int backend = 0; backend < 2; backend++) {
+        static AudioEngine engine;
+        ASSERT_TRUE(init_offline_engine_with_backend(&engine, backend ? ENGINE_BACKEND_NODE_GRAPH
+                                                                      : ENGINE_BACKEND_CALLBACK));
+        audio_engine_add_track(&engine, "Latent", PDC_TONE_HZ);
+        audio_engine_add_track(&engine, "Plain", PDC_TONE_HZ);
+        ASSERT_TRUE(audio_engine_add_effect(&engine, 0, EFFECT_CONVOLUTION));    // Unit impulse
+        audio_engine_set_track_playing(&engine, 0, true);
+        audio_engine_set_track_playing(&engine, 1, true);
+
+        EngineSnapshot snapshot;
+        audio_engine_snapshot(&engine, &snapshot);
+        ASSERT_EQUAL(CONVOLVER_PARTITION_FRAMES, (int)snapshot.latency_frames);
+
+        MemorySink mix = memory_sink_create(PDC_FRAMES);
+        EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &mix};
+        ASSERT_TRUE(audio_engine_render_offline(&engine, PDC_FRAMES, &render_sink));
+        audio_engine_shutdown(&engine);
+        ASSERT_TRUE(paths_are_aligned(&mix, &reference, CONVOLVER_PARTITION_FRAMES, 1e-4f));
+        free(mix.frames);
+    }
+    free(reference.frames);
+}
+
+// The oversampler's filters are not exact: closely aligned, not bit-exact
+CTEST(latency, oversampled_effect_delays_the_other_tracks) {
+    MemorySink reference = memory_sink_create(PDC_FRAMES);
+    ASSERT_TRUE(render_reference_tone(&reference));
+
+    for (uint32_t factor = 2; factor <= OVERSAMPLER_MAX_FACTOR; factor *= 2) {
+        static AudioEngine engine;
+        ASSERT_TRUE(init_offline_engine(&engine));
+        audio_engine_add_track(&engine, "Oversampled", PDC_TONE_HZ);
+        audio_engine_add_track(&engine, "Plain", PDC_TONE_HZ);
+        ASSERT_FALSE(audio_engine_add_oversampled_effect(&engine, 0, EFFECT_CONVOLUTION, factor));
+        ASSERT_FALSE(audio_engine_add_oversampled_effect(&engine, 0, EFFECT_GAIN, 3));
+        ASSERT_TRUE(audio_engine_add_oversampled_effect(&engine, 0, EFFECT_GAIN, factor));
+        audio_engine_set_track_playing(&engine, 0, true);
+        audio_engine_set_track_playing(&engine, 1, true);
+
+        Oversampler* probe = oversampler_create(factor);
+        ASSERT_NOT_NULL(probe);
+        uint32_t latency = oversampler_latency(probe);
+        oversampler_destroy(probe);
+        EngineSnapshot snapshot;
+        audio_engine_snapshot(&engine, &snapshot);
+        ASSERT_EQUAL((int)latency, (int)snapshot.latency_frames);
+
+        MemorySink mix = memory_sink_create(PDC_FRAMES);
+        EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &mix};
+        ASSERT_TRUE(audio_engine_render_offline(&engine, PDC_FRAMES, &render_sink));
+        audio_engine_shutdown(&engine);
+        ASSERT_TRUE(paths_are_aligned(&mix, &reference, latency, 1e-3f));
+        free(mix.frames);
+    }
+    free(reference.frames);
+}
+
+CTEST(latency, bus_latency_delays_direct_paths_even_bypassed) {
+    MemorySink reference = memory_sink_create(PDC_FRAMES);
+    ASSERT_TRUE(render_reference_tone(&reference));
+
+    for (int backend = 0; backend < 2; backend++) {
+        for (int bypassed = 0; bypassed < 2; bypassed++) {
+            static AudioEngine engine;
+            ASSERT_TRUE(init_offline_engine_with_backend(&engine, backend ? ENGINE_BACKEND_NODE_GRAPH
+                                                                          : ENGINE_BACKEND_CALLBACK));
+            audio_engine_add_track(&engine, "Bussed", PDC_TONE_HZ);
+            audio_engine_add_track(&engine, "Direct", PDC_TONE_HZ);
+            int bus = audio_engine_add_bus(&engine, "FFT");
+            ASSERT_TRUE(audio_engine_add_bus_effect(&engine, bus, EFFECT_CONVOLUTION));
+            ASSERT_TRUE(audio_engine_set_track_output(&engine, 0, bus));
+            if (bypassed) {
+                ASSERT_TRUE(audio_engine_toggle_bus_effect(&engine, bus, 0));
+            }
+            audio_engine_set_track_playing(&engine, 0, true);
+            audio_engine_set_track_playing(&engine, 1, true);
+
+            MemorySink mix = memory_sink_create(PDC_FRAMES);
+            EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &mix};
+            ASSERT_TRUE(audio_engine_render_offline(&engine, PDC_FRAMES, &render_sink));
+            EngineSnapshot snapshot;
+            audio_engine_snapshot(&engine, &snapshot);
+            audio_engine_shutdown(&engine);
+            ASSERT_EQUAL(CONVOLVER_PARTITION_FRAMES, (int)snapshot.latency_frames);
+            ASSERT_TRUE(paths_are_aligned(&mix, &reference, CONVOLVER_PARTITION_FRAMES, 1e-4f));
+            free(mix.frames);
+        }
+    }
+    free(reference.frames);
+}
+
+// ============================================================================
+// IDLE BYPASS
+// ============================================================================
+
+#define IDLE_NOTE_FRAMES 2048
+#define IDLE_ECHO_FRAMES 12000      // Default delay time, 250 ms
+#define IDLE_SLEEP_FRAMES (192 * ENGINE_MIXDOWN_PERIOD_FRAMES)   // ~8 s in whole node graph blocks
+
+static uint64_t effect_time_ns(AudioEngine* engine, int track_index) {
+    TrackProfile profile;
+    audio_engine_get_track_profile(engine, track_index, &profile);
+    return profile.effect_ns[0];
+}
+
+CTEST(idle, silent_track_sleeps_after_its_tail_and_wakes_on_a_note) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_EQUAL(0, audio_engine_add_instrument_track(&engine, "Keys", OSC_SAW));
+    ASSERT_TRUE(audio_engine_add_effect(&engine, 0, EFFECT_DELAY));
+    audio_engine_set_profiling(&engine, true);
+
+    // The echo comes back after a silent gap: the tail keeps the track awake
+    MemorySink sink = memory_sink_create(2 * IDLE_ECHO_FRAMES);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+    ASSERT_TRUE(audio_engine_note_on(&engine, 0, 60, 1.0f));
+    ASSERT_TRUE(audio_engine_render_offline(&engine, IDLE_NOTE_FRAMES, &render_sink));
+    ASSERT_TRUE(audio_engine_note_off(&engine, 0, 60));
+    ASSERT_TRUE(audio_engine_render_offline(&engine, 2 * IDLE_ECHO_FRAMES - IDLE_NOTE_FRAMES, &render_sink));
+    float gap = 0.0f;
+    float echo = 0.0f;
+    for (int i = 8192 * CHANNELS; i < 2 * IDLE_ECHO_FRAMES * CHANNELS; i++) {   // Release ends by 7808
+        float* peak = i < IDLE_ECHO_FRAMES * CHANNELS ? &gap : &echo;
+        if (fabsf(sink.frames[i]) > *peak) *peak = fabsf(sink.frames[i]);
+    }
+    ASSERT_TRUE(gap < 1e-6f);
+    ASSERT_TRUE(echo > 0.01f);
+
+    // Once the echoes have died away the delay no longer runs
+    MemorySink long_sink = memory_sink_create(IDLE_SLEEP_FRAMES);
+    render_sink.user_data = &long_sink;
+    ASSERT_TRUE(audio_engine_render_offline(&engine, IDLE_SLEEP_FRAMES, &render_sink));
+    uint64_t asleep_ns = effect_time_ns(&engine, 0);
+    ASSERT_TRUE(asleep_ns > 0);
+    long_sink.count = 0;
+    ASSERT_TRUE(audio_engine_render_offline(&engine, SAMPLE_RATE, &render_sink));
+    ASSERT_TRUE(effect_time_ns(&engine, 0) == asleep_ns);
+    ASSERT_TRUE(peak_of(&long_sink) < ENGINE_SILENCE_LEVEL);
+
+    // A note wakes it on the spot
+    sink.count = 0;
+    render_sink.user_data = &sink;
+    ASSERT_TRUE(audio_engine_note_on(&engine, 0, 60, 1.0f));
+    ASSERT_TRUE(audio_engine_render_offline(&engine, IDLE_NOTE_FRAMES, &render_sink));
+    ASSERT_TRUE(peak_of(&sink) > 0.01f);
+    ASSERT_TRUE(effect_time_ns(&engine, 0) > asleep_ns);
+
+    audio_engine_shutdown(&engine);
+    free(sink.frames);
+    free(long_sink.frames);
+}
+
+// A note on a session that slept through a long silence, tracks and the
+// reverb bus alike, sounds the same as on a fresh session (given one silent
+// block first, for the volume ramp to settle)
+CTEST(idle, woken_session_matches_a_fresh_one) {
+    for (int backend = 0; backend < 2; backend++) {
+        static AudioEngine engines[2];
+        MemorySink sinks[2] = {memory_sink_create(IDLE_SLEEP_FRAMES), memory_sink_create(IDLE_SLEEP_FRAMES)};
+        for (int e = 0; e < 2; e++) {
+            ASSERT_TRUE(init_offline_engine_with_backend(&engines[e], backend ? ENGINE_BACKEND_NODE_GRAPH
+                                                                              : ENGINE_BACKEND_CALLBACK));
+            ASSERT_EQUAL(0, audio_engine_add_instrument_track(&engines[e], "Keys", OSC_SAW));
+            ASSERT_TRUE(audio_engine_add_effect(&engines[e], 0, EFFECT_LOWPASS));
+            int reverb = audio_engine_add_reverb_bus(&engines[e], "Verb");
+            ASSERT_TRUE(audio_engine_set_track_send(&engines[e], 0, reverb, 0.5f));
+        }
+        EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sinks[0]};
+        ASSERT_TRUE(audio_engine_note_on(&engines[0], 0, 60, 1.0f));
+        ASSERT_TRUE(audio_engine_render_offline(&engines[0], IDLE_NOTE_FRAMES, &render_sink));
+        ASSERT_TRUE(audio_engine_note_off(&engines[0], 0, 60));
+        ASSERT_TRUE(audio_engine_render_offline(&engines[0], IDLE_SLEEP_FRAMES - IDLE_NOTE_FRAMES, &render_sink));
+        render_sink.user_data = &sinks[1];
+        ASSERT_TRUE(audio_engine_render_offline(&engines[1], IDLE_NOTE_FRAMES, &render_sink));
+
+        for (int e = 0; e < 2; e++) {
+            sinks[e].count = 0;
+            render_sink.user_data = &sinks[e];
+            ASSERT_TRUE(audio_engine_note_on(&engines[e], 0, 64, 1.0f));
+            ASSERT_TRUE(audio_engine_render_offline(&engines[e], 4 * IDLE_NOTE_FRAMES, &render_sink));
+            audio_engine_shutdown(&engines[e]);
+        }
+        ASSERT_TRUE(peak_of(&sinks[1]) > 0.1f);
+        for (int i = 0; i < 4 * IDLE_NOTE_FRAMES * CHANNELS; i++) {
+            ASSERT_DBL_NEAR_TOL(sinks[1].frames[i], sinks[0].frames[i], 1e-4);
+        }
+        free(sinks[0].frames);
+        free(sinks[1].frames);
+    }
+}
+
+// ============================================================================
+// FREEZE
+// ============================================================================
+
+#define FREEZE_FRAMES (8 * ENGINE_MIXDOWN_PERIOD_FRAMES)
+#define TEST_FREEZE_PATH "./track00_freeze001" CLIP_CACHE_EXTENSION
+
+// A tone through a delay, the track panned so the fader is in the render
+static void build_freeze_session(AudioEngine* engine) {
+    audio_engine_add_track(engine, "Heavy", 220.0f);
+    audio_engine_add_effect(engine, 0, EFFECT_DELAY);
+    audio_engine_set_track_pan(engine, 0, -0.5f);
+    audio_engine_set_track_playing(engine, 0, true);
+}
+
+CTEST(freeze, frozen_track_plays_what_the_chain_would) {
+    for (int backend = 0; backend < 2; backend++) {
+        static AudioEngine engines[2];
+        MemorySink sinks[2] = {memory_sink_create(FREEZE_FRAMES), memory_sink_create(FREEZE_FRAMES)};
+        for (int e = 0; e < 2; e++) {
+            ASSERT_TRUE(init_offline_engine_with_backend(&engines[e], backend ? ENGINE_BACKEND_NODE_GRAPH
+                                                                              : ENGINE_BACKEND_CALLBACK));
+            build_freeze_session(&engines[e]);
+        }
+        ASSERT_TRUE(audio_engine_freeze_track(&engines[1], 0, FREEZE_FRAMES, "."));
+        EngineSnapshot snapshot;
+        audio_engine_snapshot(&engines[1], &snapshot);
+        ASSERT_TRUE(snapshot.tracks[0].frozen);
+        ClipCache cache;
+        ASSERT_TRUE(clip_cache_open(&cache, TEST_FREEZE_PATH));
+        ASSERT_EQUAL(FREEZE_FRAMES, (int)clip_cache_frame_count(&cache));
+        clip_cache_close(&cache);
+
+        // The chain no longer runs, yet the track sounds the same
+        audio_engine_set_profiling(&engines[1], true);
+        for (int e = 0; e < 2; e++) {
+            EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sinks[e]};
+            ASSERT_TRUE(audio_engine_render_offline(&engines[e], FREEZE_FRAMES, &render_sink));
+        }
+        ASSERT_TRUE(effect_time_ns(&engines[1], 0) == 0);
+        for (int e = 0; e < 2; e++) {
+            audio_engine_shutdown(&engines[e]);
+        }
+        ASSERT_TRUE(peak_of(&sinks[0]) > 0.1f);
+        for (int i = 0; i < FREEZE_FRAMES * CHANNELS; i++) {
+            ASSERT_DBL_NEAR_TOL(sinks[0].frames[i], sinks[1].frames[i], 1e-6);
+        }
+        remove(TEST_FREEZE_PATH);
+        free(sinks[0].frames);
+        free(sinks[1].frames);
+    }
+}
+
+CTEST(freeze, edits_that_change_the_audio_unfreeze) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    build_freeze_session(&engine);
+    audio_engine_set_profiling(&engine, true);
+    MemorySink sink = memory_sink_create(FREEZE_FRAMES);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+
+    // Mute and sends play the frozen audio differently, but keep it
+    EngineSnapshot snapshot;
+    ASSERT_TRUE(audio_engine_freeze_track(&engine, 0, FREEZE_FRAMES, "."));
+    ASSERT_TRUE(audio_engine_set_track_mute(&engine, 0, true));
+    ASSERT_TRUE(audio_engine_set_track_mute(&engine, 0, false));
+    audio_engine_snapshot(&engine, &snapshot);
+    ASSERT_TRUE(snapshot.tracks[0].frozen);
+
+    // A parameter edit brings the chain back
+    ASSERT_TRUE(audio_engine_set_effect_param(&engine, 0, 0, 1, 0.2f));
+    audio_engine_snapshot(&engine, &snapshot);
+    ASSERT_FALSE(snapshot.tracks[0].frozen);
+    ASSERT_TRUE(audio_engine_render_offline(&engine, ENGINE_MIXDOWN_PERIOD_FRAMES, &render_sink));
+    ASSERT_TRUE(effect_time_ns(&engine, 0) > 0);
+    ASSERT_FALSE(audio_engine_unfreeze_track(&engine, 0));
+
+    // Volume does too; live sources cannot be frozen at all
+    ASSERT_TRUE(audio_engine_freeze_track(&engine, 0, FREEZE_FRAMES, "."));
+    ASSERT_TRUE(audio_engine_set_track_volume(&engine, 0, 0.5f));
+    audio_engine_snapshot(&engine, &snapshot);
+    ASSERT_FALSE(snapshot.tracks[0].frozen);
+    ASSERT_EQUAL(1, audio_engine_add_instrument_track(&engine, "Keys", OSC_SAW));
+    ASSERT_FALSE(audio_engine_freeze_track(&engine, 1, FREEZE_FRAMES, "."));
+
+    audio_engine_shutdown(&engine);
+    remove(TEST_FREEZE_PATH);
+    remove("./track00_freeze002" CLIP_CACHE_EXTENSION);
+    free(sink.frames);
+}
+
+// MIDI controllers cannot thaw a track from the audio thread, so the fader
+// they would move stays where the frozen render has it
+CTEST(freeze, midi_controllers_leave_a_frozen_fader_alone) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    build_freeze_session(&engine);
+    ASSERT_TRUE(audio_engine_set_track_armed(&engine, 0, true));
+    ASSERT_TRUE(audio_engine_freeze_track(&engine, 0, FREEZE_FRAMES, "."));
+    MemorySink sink = memory_sink_create(MIDI_PERIOD);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+    ASSERT_TRUE(audio_engine_render_offline(&engine, MIDI_PERIOD, &render_sink));
+    float volume = track_store_mix(&engine.tracks, 0)->volume[0];
+
+    MidiEvent fader = {.time_ns = midi_stamp(&engine, 10), .status = MIDI_CONTROL_CHANGE,
+                       .data1 = MIDI_CC_VOLUME, .data2 = 20};
+    MidiEvent pan = {.time_ns = midi_stamp(&engine, 20), .status = MIDI_CONTROL_CHANGE,
+                     .data1 = MIDI_CC_PAN, .data2 = 127};
+    ASSERT_TRUE(audio_engine_push_midi(&engine, &fader));
+    ASSERT_TRUE(audio_engine_push_midi(&engine, &pan));
+    sink.count = 0;
+    ASSERT_TRUE(audio_engine_render_offline(&engine, MIDI_PERIOD, &render_sink));
+    ASSERT_DBL_NEAR_TOL(volume, track_store_mix(&engine.tracks, 0)->volume[0], 1e-6);
+    ASSERT_DBL_NEAR_TOL(-0.5, track_store_mix(&engine.tracks, 0)->pan[0], 1e-6);
+    EngineSnapshot snapshot;
+    audio_engine_snapshot(&engine, &snapshot);
+    ASSERT_TRUE(snapshot.tracks[0].frozen);
+
+    // Thawed, the same controllers move it again
+    ASSERT_TRUE(audio_engine_unfreeze_track(&engine, 0));
+    fader.time_ns = midi_stamp(&engine, 10);
+    ASSERT_TRUE(audio_engine_push_midi(&engine, &fader));
+    sink.count = 0;
+    ASSERT_TRUE(audio_engine_render_offline(&engine, MIDI_PERIOD, &render_sink));
+    ASSERT_DBL_NEAR_TOL(20.0 / 127.0, track_store_mix(&engine.tracks, 0)->volume[0], 1e-6);
+
+    audio_engine_shutdown(&engine);
+    remove(TEST_FREEZE_PATH);
+    free(sink.frames);
+}
+
+// ============================================================================
+// SPECTRUM ANALYZER TAP
+// ============================================================================
+
+#define TAP_FRAMES 12000    // Fits the tap ring without a consumer
+
+CTEST(analyzer, master_tap_finds_the_tone) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_EQUAL(0, audio_engine_add_track(&engine, "Tone", 1000.0f));
+    audio_engine_set_track_playing(&engine, 0, true);
+    ASSERT_TRUE(audio_engine_set_analyzer_source(&engine, ANALYZER_SOURCE_MASTER));
+
+    MemorySink sink = memory_sink_create(TAP_FRAMES);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+    ASSERT_TRUE(audio_engine_render_offline(&engine, TAP_FRAMES, &render_sink));
+
+    static Analyzer analyzer;
+    ASSERT_TRUE(analyzer_init(&analyzer, audio_engine_get_analyzer_tap(&engine), SAMPLE_RATE));
+    ASSERT_EQUAL(TAP_FRAMES, analyzer_process(&analyzer));
+    ASSERT_EQUAL(TAP_FRAMES / ANALYZER_HOP_FRAMES, (int)atomic_load(&analyzer.transforms));
+
+    float bands[ANALYZER_BANDS];
+    ASSERT_TRUE(analyzer_read(&analyzer, bands));
+    int loudest = 0;
+    int below = 0;
+    for (int b = 0; b < ANALYZER_BANDS; b++) {
+        loudest = bands[b] > bands[loudest] ? b : loudest;
+        below = analyzer.band_hz[b] < 100.0f ? b : below;
+    }
+    ASSERT_TRUE(analyzer.band_hz[loudest] > 900.0f && analyzer.band_hz[loudest] < 1100.0f);
+    ASSERT_TRUE(bands[loudest] > -40.0f);
+    ASSERT_TRUE(bands[below] < bands[loudest] - 40.0f);
+    ASSERT_EQUAL(0, (int)atomic_load(&engine.analyzer_tap.dropped_blocks));
+
+    analyzer_destroy(&analyzer);
+    free(sink.frames);
+    audio_engine_shutdown(&engine);
+}
+
+CTEST(analyzer, tap_follows_source_and_drops_when_full) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_EQUAL(0, audio_engine_add_track(&engine, "Tone", 440.0f));
+    audio_engine_set_track_playing(&engine, 0, true);
+    AnalyzerTap* tap = audio_engine_get_analyzer_tap(&engine);
+    ASSERT_FALSE(audio_engine_set_analyzer_source(&engine, 1));
+    ASSERT_FALSE(audio_engine_set_analyzer_source(&engine, -3));
+
+    // Nothing selected: the audio thread copies nothing
+    MemorySink sink = memory_sink_create(RENDER_FRAMES);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+    ASSERT_TRUE(audio_engine_render_offline(&engine, 4096, &render_sink));
+    ASSERT_EQUAL(0, (int)spsc_ring_count(&tap->ring));
+
+    // A track source, rendered past the ring with no consumer, drops
+    ASSERT_TRUE(audio_engine_set_analyzer_source(&engine, 0));
+    sink.count = 0;
+    ASSERT_TRUE(audio_engine_render_offline(&engine, RENDER_FRAMES, &render_sink));
+    ASSERT_EQUAL(ANALYZER_RING_BLOCKS, (int)spsc_ring_count(&tap->ring));
+    ASSERT_TRUE(atomic_load(&tap->dropped_blocks) > 0);
+
+    free(sink.frames);
+    audio_engine_shutdown(&engine);
+}
+
+// ============================================================================
+// SESSIONS
+// ============================================================================
+
+#define TEST_SESSION_PATH "test_engine_offline" SESSION_EXTENSION
+#define TEST_SESSION_CLIP_PATH "test_engine_session_clip.wav"
+#define SESSION_FRAMES 16384        // Whole blocks
+
+// Routing, effects (one bypassed), automation, an instrument and a looping
+// clip on a group bus that feeds the reverb bus
+static void build_saved_session(AudioEngine* engine) {
+    build_bus_session(engine);
+    int group = audio_engine_add_bus(engine, "Group");
+    audio_engine_set_bus_output(engine, group, 0);
+    audio_engine_add_bus_effect(engine, group, EFFECT_GAIN);
+    audio_engine_set_bus_effect_param(engine, group, 0, 0, 0.5f);
+    audio_engine_set_bus_volume(engine, group, 0.8f);
+
+    audio_engine_add_instrument_track(engine, "Keys", OSC_SQUARE);
+    audio_engine_set_track_armed(engine, 2, true);
+    audio_engine_add_track(engine, "Loop", 0.0f);
+    audio_engine_load_track_clip(engine, 3, TEST_SESSION_CLIP_PATH, true);
+    audio_engine_set_track_output(engine, 3, group);
+    audio_engine_set_track_playing(engine, 3, true);
+
+    audio_engine_set_track_volume(engine, 0, 0.6f);
+    audio_engine_set_track_pan(engine, 1, 0.4f);
+    audio_engine_set_effect_param(engine, 1, 0, 0, 120.0f);
+    audio_engine_add_effect(engine, 0, EFFECT_GAIN);
+    audio_engine_toggle_effect(engine, 0, 1);
+    audio_engine_add_oversampled_effect(engine, 1, EFFECT_GAIN, 2);
+    const AutomationPoint swell[] = {{0, 0.2f}, {6000, 1.0f}, {12000, 0.5f}};
+    const AutomationPoint sweep[] = {{0, 0.9f}, {SESSION_FRAMES, 0.1f}};
+    audio_engine_set_track_automation(engine, 1, AUTOMATION_TRACK_VOLUME, 0, 0, swell, 3);
+    audio_engine_set_track_automation(engine, 0, AUTOMATION_EFFECT_PARAM, 0, 0, sweep, 2);
+    audio_engine_set_master_volume(engine, 0.9f);
+}
+
+CTEST(session, saved_session_loads_and_renders_identically) {
+    // The clip: a second of tone rendered by the engine itself
+    static AudioEngine engines[3];
+    ASSERT_TRUE(init_offline_engine(&engines[0]));
+    audio_engine_add_track(&engines[0], "Source", 550.0f);
+    audio_engine_set_track_playing(&engines[0], 0, true);
+    ASSERT_TRUE(audio_engine_render_to_wav(&engines[0], TEST_SESSION_CLIP_PATH, SAMPLE_RATE, ma_format_f32));
+    audio_engine_shutdown(&engines[0]);
+
+    // Saved once the audio side has applied the commands
+    ASSERT_TRUE(init_offline_engine(&engines[0]));
+    build_saved_session(&engines[0]);
+    MemorySink sink = memory_sink_create(4096);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+    ASSERT_TRUE(audio_engine_render_offline(&engines[0], 4096, &render_sink));
+    ASSERT_TRUE(audio_engine_save_session(&engines[0], TEST_SESSION_PATH));
+    audio_engine_shutdown(&engines[0]);
+    free(sink.frames);
+
+    // A fresh build and the loaded file render the same
+    ASSERT_TRUE(init_offline_engine(&engines[1]));
+    build_saved_session(&engines[1]);
+    ASSERT_TRUE(init_offline_engine(&engines[2]));
+    ASSERT_TRUE(audio_engine_load_session(&engines[2], TEST_SESSION_PATH));
+    ASSERT_EQUAL(4, engines[2].track_count);
+    ASSERT_EQUAL(2, engines[2].bus_count);
+    ASSERT_FALSE(audio_engine_load_session(&engines[2], TEST_SESSION_PATH));
+
+    MemorySink sinks[2];
+    for (int e = 0; e < 2; e++) {
+        sinks[e] = memory_sink_create(SESSION_FRAMES);
+        EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sinks[e]};
+        ASSERT_TRUE(audio_engine_render_offline(&engines[e + 1], SESSION_FRAMES, &render_sink));
+    }
+    ASSERT_TRUE(peak_of(&sinks[0]) > 0.05f);
+    ASSERT_EQUAL(0, memcmp(sinks[0].frames, sinks[1].frames, sizeof(float) * SESSION_FRAMES * CHANNELS));
+
+    static EngineSnapshot snapshot;
+    audio_engine_snapshot(&engines[2], &snapshot);
+    ASSERT_STR("Loop", snapshot.tracks[3].name);
+    ASSERT_TRUE(snapshot.tracks[2].instrument);
+    ASSERT_TRUE(snapshot.tracks[2].armed);
+    ASSERT_NOT_NULL((void*)snapshot.tracks[3].clip_cache);
+    ASSERT_DBL_NEAR_TOL(0.9, snapshot.master_volume, 1e-6);
+
+    for (int e = 0; e < 2; e++) {
+        free(sinks[e].frames);
+        audio_engine_shutdown(&engines[e + 1]);
+    }
+    remove(TEST_SESSION_PATH);
+    remove(TEST_SESSION_CLIP_PATH);
+    remove(TEST_SESSION_CLIP_PATH CLIP_CACHE_EXTENSION);
+}
+
+// Rewrite the saved file with one byte changed, or cut short
+static bool rewrite_session(const SessionImage* image, size_t offset, uint8_t value, size_t size) {
+    FILE* file = fopen(TEST_SESSION_PATH, "wb");
+    if (!file) return false;
+    size_t head = offset < size ? offset : size;
+    bool ok = fwrite(image->data, 1, head, file) == head;
+    if (offset < size) {
+        ok = ok && fputc(value, file) != EOF;
+        ok = ok && fwrite(image->data + offset + 1, 1, size - offset - 1, file) == size - offset - 1;
+    }
+    return fclose(file) == 0 && ok;
+}
+
+CTEST(session, damaged_files_are_rejected_without_touching_the_engine) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    build_bus_session(&engine);
+    const AutomationPoint fade[] = {{0, 1.0f}, {4096, 0.0f}};
+    audio_engine_set_track_automation(&engine, 0, AUTOMATION_TRACK_PAN, 0, 0, fade, 2);
+    SessionImage image;
+    ASSERT_TRUE(audio_engine_capture_session(&engine, &image));
+    audio_engine_shutdown(&engine);
+
+    const SessionHeader* header = session_header(&image);
+    const size_t lane = header->tracks_offset + offsetof(SessionTrack, pan_lane.first_point);
+    const size_t route = header->buses_offset + offsetof(SessionBus, output_bus);
+    const size_t effect = header->tracks_offset + offsetof(SessionTrack, effects[0].type);
+    struct {
+        size_t offset;
+        uint8_t value;
+        size_t size;
+    } damage[] = {
+        {0, 'X', image.size},                   // Magic
+        {4, SESSION_VERSION + 1, image.size},   // Version
+        {image.size, 0, image.size - 8},        // Truncated
+        {lane, 0xFF, image.size},               // Lane runs past the points
+        {route, 0, image.size},                 // Bus routed to itself
+        {effect, EFFECT_TYPE_COUNT, image.size},
+    };
+    for (size_t i = 0; i < sizeof(damage) / sizeof(damage[0]); i++) {
+        ASSERT_TRUE(rewrite_session(&image, damage[i].offset, damage[i].value, damage[i].size));
+        ASSERT_TRUE(init_offline_engine(&engine));
+        ASSERT_FALSE(audio_engine_load_session(&engine, TEST_SESSION_PATH));
+        ASSERT_EQUAL(0, engine.track_count);
+        ASSERT_EQUAL(0, engine.bus_count);
+        audio_engine_shutdown(&engine);
+    }
+
+    // Unchanged, it loads; missing, it does not
+    ASSERT_TRUE(session_image_write(&image, TEST_SESSION_PATH));
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_TRUE(audio_engine_load_session(&engine, TEST_SESSION_PATH));
+    audio_engine_shutdown(&engine);
+    remove(TEST_SESSION_PATH);
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_FALSE(audio_engine_load_session(&engine, TEST_SESSION_PATH));
+    audio_engine_shutdown(&engine);
+    session_image_free(&image);
+}
+
+CTEST(session, full_session_loads_well_under_a_second) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    char name[16];
+    const AutomationPoint ramp[] = {{0, 0.0f}, {48000, 1.0f}};
+    for (int b = 0; b < MAX_BUSES; b++) {
+        snprintf(name, sizeof(name), "Bus %d", b);
+        ASSERT_EQUAL(b, audio_engine_add_bus(&engine, name));
+    }
+    for (int t = 0; t < MAX_TRACKS; t++) {
+        snprintf(name, sizeof(name), "T%d", t);
+        ASSERT_EQUAL(t, audio_engine_add_track(&engine, name, 110.0f + (float)t));
+        ASSERT_TRUE(audio_engine_add_effect(&engine, t, EFFECT_LOWPASS));
+        ASSERT_TRUE(audio_engine_add_effect(&engine, t, EFFECT_GAIN));
+        ASSERT_TRUE(audio_engine_set_track_output(&engine, t, t % MAX_BUSES));
+        ASSERT_TRUE(audio_engine_set_track_automation(&engine, t, AUTOMATION_TRACK_VOLUME, 0, 0, ramp, 2));
+    }
+    uint64_t start = engine_thread_time_ns();
+    ASSERT_TRUE(audio_engine_save_session(&engine, TEST_SESSION_PATH));
+    uint64_t saved = engine_thread_time_ns();
+    audio_engine_shutdown(&engine);
+
+    ASSERT_TRUE(init_offline_engine(&engine));
+    uint64_t load_start = engine_thread_time_ns();
+    ASSERT_TRUE(audio_engine_load_session(&engine, TEST_SESSION_PATH));
+    uint64_t loaded = engine_thread_time_ns();
+    ASSERT_EQUAL(MAX_TRACKS, engine.track_count);
+    ASSERT_EQUAL(2, track_store_track(&engine.tracks, MAX_TRACKS - 1)->chain.count);
+    ASSERT_NOT_NULL(track_store_info(&engine.tracks, MAX_TRACKS - 1)->volume_lane);
+    ASSERT_TRUE(saved - start < 1000000000ull);
+    ASSERT_TRUE(loaded - load_start < 1000000000ull);
+
+    audio_engine_shutdown(&engine);
+    remove(TEST_SESSION_PATH);
+}
+
+// ============================================================================
+// UNDO JOURNAL AND AUTOSAVE
+// ============================================================================
+
+#define TEST_AUTOSAVE_PATH "test_engine_autosave" SESSION_EXTENSION
+
+// Let the audio side apply whatever is queued
+static void apply_queued(AudioEngine* engine) {
+    MemorySink sink = memory_sink_create(4096);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sink};
+    audio_engine_render_offline(engine, 4096, &render_sink);
+    free(sink.frames);
+}
+
+static float applied_volume(const AudioEngine* engine, int track_index) {
+    return track_store_mix(&engine->tracks, track_index)->volume[track_lane(track_index)];
+}
+
+CTEST(journal, undo_and_redo_step_through_mix_edits) {
+    static AudioEngine engine;
+    static EngineJournal journal;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_TRUE(engine_journal_init(&journal));
+    audio_engine_add_track(&engine, "Bass", 110.0f);
+    audio_engine_add_track(&engine, "Lead", 440.0f);
+    audio_engine_add_effect(&engine, 0, EFFECT_LOWPASS);
+    audio_engine_add_effect(&engine, 0, EFFECT_GAIN);
+    apply_queued(&engine);
+    const float volume = applied_volume(&engine, 0);
+    const EffectChain* chain = &track_store_track(&engine.tracks, 0)->chain;
+    const float gain = effect_get_param(&chain->effects[chain->order[1]], 0);
+
+    // The gain is addressed by slot, so moving it to the front does not
+    // change what its step refers to
+    EngineCommand edits[] = {
+        {.type = CMD_SET_TRACK_VOLUME, .track_index = 0, .value = 0.5f},
+        {.type = CMD_SET_TRACK_MUTE, .track_index = 1, .flag = true},
+        {.type = CMD_SET_EFFECT_PARAM, .track_index = 0, .effect_slot = chain->order[1], .value = 0.25f},
+    };
+    for (size_t i = 0; i < sizeof(edits) / sizeof(edits[0]); i++) {
+        ASSERT_TRUE(engine_journal_apply(&journal, &engine, &edits[i]));
+    }
+    ASSERT_TRUE(audio_engine_move_effect(&engine, 0, 1, 0));
+    apply_queued(&engine);
+    ASSERT_EQUAL(3, journal.count);
+    ASSERT_DBL_NEAR_TOL(0.5, applied_volume(&engine, 0), 1e-6);
+    ASSERT_DBL_NEAR_TOL(0.25, effect_get_param(&chain->effects[chain->order[0]], 0), 1e-6);
+
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(engine_journal_undo(&journal, &engine));
+    }
+    ASSERT_FALSE(engine_journal_undo(&journal, &engine));
+    apply_queued(&engine);
+    ASSERT_DBL_NEAR_TOL(volume, applied_volume(&engine, 0), 1e-6);
+    ASSERT_FALSE(atomic_load(&track_store_mix(&engine.tracks, 1)->mute[1]));
+    ASSERT_DBL_NEAR_TOL(gain, effect_get_param(&chain->effects[chain->order[0]], 0), 1e-6);
+
+    ASSERT_TRUE(engine_journal_redo(&journal, &engine));
+    apply_queued(&engine);
+    ASSERT_DBL_NEAR_TOL(0.5, applied_volume(&engine, 0), 1e-6);
+
+    // A new edit replaces what could have been redone
+    ASSERT_TRUE(engine_journal_can_redo(&journal));
+    EngineCommand pan = {.type = CMD_SET_TRACK_PAN, .track_index = 1, .value = -0.5f};
+    ASSERT_TRUE(engine_journal_apply(&journal, &engine, &pan));
+    ASSERT_FALSE(engine_journal_can_redo(&journal));
+    ASSERT_EQUAL(2, journal.count);
+
+    // Transport is forwarded, not recorded
+    EngineCommand play = {.type = CMD_SET_PLAYING, .flag = true};
+    ASSERT_TRUE(engine_journal_apply(&journal, &engine, &play));
+    ASSERT_EQUAL(2, journal.count);
+
+    engine_journal_destroy(&journal);
+    audio_engine_shutdown(&engine);
+}
+
+CTEST(journal, a_drag_is_one_step_and_removed_targets_are_skipped) {
+    static AudioEngine engine;
+    static EngineJournal journal;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_TRUE(engine_journal_init(&journal));
+    audio_engine_add_track(&engine, "Bass", 110.0f);
+    audio_engine_add_effect(&engine, 0, EFFECT_GAIN);
+    apply_queued(&engine);
+    const float volume = applied_volume(&engine, 0);
+
+    // Every value of the drag is sent, but undo goes back to before it
+    for (int i = 1; i <= 10; i++) {
+        EngineCommand drag = {.type = CMD_SET_TRACK_VOLUME, .track_index = 0, .value = 0.05f * (float)i};
+        ASSERT_TRUE(engine_journal_apply(&journal, &engine, &drag));
+    }
+    ASSERT_EQUAL(1, journal.count);
+    engine_journal_seal(&journal);
+    EngineCommand release = {.type = CMD_SET_TRACK_VOLUME, .track_index = 0, .value = 0.75f};
+    ASSERT_TRUE(engine_journal_apply(&journal, &engine, &release));
+    ASSERT_EQUAL(2, journal.count);
+    apply_queued(&engine);
+    ASSERT_DBL_NEAR_TOL(0.75, applied_volume(&engine, 0), 1e-6);
+    ASSERT_TRUE(engine_journal_undo(&journal, &engine));
+    apply_queued(&engine);
+    ASSERT_DBL_NEAR_TOL(0.5, applied_volume(&engine, 0), 1e-6);
+    ASSERT_TRUE(engine_journal_undo(&journal, &engine));
+    apply_queued(&engine);
+    ASSERT_DBL_NEAR_TOL(volume, applied_volume(&engine, 0), 1e-6);
+
+    // A toggle of an effect that has since been removed is stepped over
+    const EffectChain* chain = &track_store_track(&engine.tracks, 0)->chain;
+    EngineCommand toggle = {.type = CMD_TOGGLE_EFFECT, .track_index = 0, .effect_slot = chain->order[0]};
+    ASSERT_TRUE(engine_journal_apply(&journal, &engine, &toggle));
+    ASSERT_TRUE(audio_engine_remove_effect(&engine, 0, 0));
+    ASSERT_FALSE(engine_journal_undo(&journal, &engine));
+    ASSERT_FALSE(engine_journal_can_undo(&journal));
+    ASSERT_TRUE(engine_journal_can_redo(&journal));
+
+    engine_journal_destroy(&journal);
+    audio_engine_shutdown(&engine);
+}
+
+// An effect added into the slot a removed one freed is a different target,
+// even when it is of the same type
+CTEST(journal, steps_of_a_removed_effect_skip_its_slots_next_occupant) {
+    static AudioEngine engine;
+    static EngineJournal journal;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    ASSERT_TRUE(engine_journal_init(&journal));
+    audio_engine_add_track(&engine, "Bass", 110.0f);
+    audio_engine_add_effect(&engine, 0, EFFECT_GAIN);
+    apply_queued(&engine);
+    const EffectChain* chain = &track_store_track(&engine.tracks, 0)->chain;
+    const int slot = chain->order[0];
+    EngineCommand edit = {.type = CMD_SET_EFFECT_PARAM, .track_index = 0, .effect_slot = slot, .value = 0.25f};
+    ASSERT_TRUE(engine_journal_apply(&journal, &engine, &edit));
+    apply_queued(&engine);
+
+    ASSERT_TRUE(audio_engine_remove_effect(&engine, 0, 0));
+    apply_queued(&engine);
+    ASSERT_TRUE(audio_engine_add_effect(&engine, 0, EFFECT_GAIN));
+    apply_queued(&engine);
+    ASSERT_EQUAL(slot, chain->order[0]);
+    const float gain = effect_get_param(&chain->effects[slot], 0);
+
+    ASSERT_FALSE(engine_journal_undo(&journal, &engine));
+    apply_queued(&engine);
+    ASSERT_DBL_NEAR_TOL(gain, effect_get_param(&chain->effects[slot], 0), 1e-6);
+    ASSERT_FALSE(engine_journal_redo(&journal, &engine));
+    apply_queued(&engine);
+    ASSERT_DBL_NEAR_TOL(gain, effect_get_param(&chain->effects[slot], 0), 1e-6);
+
+    // Its own edits are journaled afresh, from its own value
+    edit.value = 0.5f;
+    ASSERT_TRUE(engine_journal_apply(&journal, &engine, &edit));
+    ASSERT_TRUE(engine_journal_undo(&journal, &engine));
+    apply_queued(&engine);
+    ASSERT_DBL_NEAR_TOL(gain, effect_get_param(&chain->effects[slot], 0), 1e-6);
+
+    engine_journal_destroy(&journal);
+    audio_engine_shutdown(&engine);
+}
+
+CTEST(journal, control_thread_undoes_and_autosaves_in_the_background) {
+    static AudioEngine engine;
+    static ControlThread control;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    audio_engine_add_track(&engine, "Bass", 110.0f);
+    apply_queued(&engine);
+    const float volume = applied_volume(&engine, 0);
+    ASSERT_TRUE(control_thread_init(&control, &engine));
+    control_thread_set_autosave(&control, TEST_AUTOSAVE_PATH, 0);
+
+    // Nothing has changed yet, so nothing is autosaved
+    control_thread_process(&control);
+    session_writer_flush(&control.writer);
+    ASSERT_EQUAL(0, (int)atomic_load(&control.writer.written));
+
+    ControlRequest edit = {.type = CONTROL_SET_TRACK_VOLUME, .track_index = 0, .value = 0.3f};
+    ASSERT_TRUE(control_thread_request(&control, &edit));
+    ASSERT_EQUAL(1, control_thread_process(&control));
+    apply_queued(&engine);
+    control_thread_process(&control);
+    session_writer_flush(&control.writer);
+    ASSERT_EQUAL(1, (int)atomic_load(&control.writer.written));
+
+    static AudioEngine recovered;
+    ASSERT_TRUE(init_offline_engine(&recovered));
+    ASSERT_TRUE(audio_engine_load_session(&recovered, TEST_AUTOSAVE_PATH));
+    apply_queued(&recovered);
+    ASSERT_DBL_NEAR_TOL(0.3, applied_volume(&recovered, 0), 1e-6);
+    audio_engine_shutdown(&recovered);
+
+    ASSERT_TRUE(control_thread_request(&control, &(ControlRequest){.type = CONTROL_UNDO}));
+    ASSERT_TRUE(control_thread_request(&control, &(ControlRequest){.type = CONTROL_SAVE_SESSION}));
+    ASSERT_EQUAL(2, control_thread_process(&control));
+    apply_queued(&engine);
+    ASSERT_DBL_NEAR_TOL(volume, applied_volume(&engine, 0), 1e-6);
+
+    // Destroying finishes the pending writes: the undone autosave, and the
+    // save requested before the undo had been applied
+    control_thread_process(&control);
+    control_thread_destroy(&control);
+    ASSERT_TRUE(init_offline_engine(&recovered));
+    ASSERT_TRUE(audio_engine_load_session(&recovered, TEST_AUTOSAVE_PATH));
+    apply_queued(&recovered);
+    ASSERT_DBL_NEAR_TOL(volume, applied_volume(&recovered, 0), 1e-6);
+    audio_engine_shutdown(&recovered);
+    ASSERT_TRUE(init_offline_engine(&recovered));
+    ASSERT_TRUE(audio_engine_load_session(&recovered, CONTROL_SESSION_PATH));
+    audio_engine_shutdown(&recovered);
+
+    audio_engine_shutdown(&engine);
+    remove(TEST_AUTOSAVE_PATH);
+    remove(CONTROL_SESSION_PATH);
+}
+
+// ============================================================================
+// CLAP PLUGINS
+// ============================================================================
+
+// Without AIRDAW_CLAP every load fails; with it a missing file does. Either
+// way nothing is added.
+CTEST(clap, unloadable_plugins_are_refused) {
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    audio_engine_add_track(&engine, "Tone", PDC_TONE_HZ);
+    int bus = audio_engine_add_bus(&engine, "Bus");
+    ASSERT_FALSE(audio_engine_add_clap_effect(&engine, 0, "missing.clap", NULL));
+    ASSERT_FALSE(audio_engine_add_bus_clap_effect(&engine, bus, "missing.clap", NULL));
+    ASSERT_FALSE(audio_engine_add_effect(&engine, 0, EFFECT_CLAP));
+    ASSERT_FALSE(audio_engine_add_linked_clap_effect(&engine, 0, NULL, NULL));
+    ASSERT_EQUAL(0, track_store_track(&engine.tracks, 0)->chain.count);
+    ASSERT_EQUAL(0, engine.buses[bus].chain.count);
+    audio_engine_shutdown(&engine);
+}
+
+#ifdef AIRDAW_CLAP
+
+#include <clap/clap.h>
+
+#define TEST_CLAP_GAIN_ID 7             // The plugins' only parameter
+#define TEST_CLAP_LATENCY 300           // Frames, for "test.delay"
+
+// A gain plugin linked into the test, and a variant that also delays its
+// output (reporting it as latency)
+typedef struct {
+    clap_plugin_t plugin;
+    uint32_t latency;
+    double gain;
+    float line[2][TEST_CLAP_LATENCY];
+    uint32_t pos;
+} TestClapPlugin;
+
+static const clap_plugin_descriptor_t test_clap_descriptors[] = {
+    {.clap_version = CLAP_VERSION_INIT, .id = "test.gain", .name = "Test gain"},
+    {.clap_version = CLAP_VERSION_INIT, .id = "test.delay", .name = "Test delay"},
+};
+
+static bool test_clap_init(const clap_plugin_t* plugin) {
+    (void)plugin;
+    return true;
+}
+
+static void test_clap_destroy(const clap_plugin_t* plugin) {
+    free(plugin->plugin_data);
+}
+
+static bool test_clap_activate(const clap_plugin_t* plugin, double sample_rate, uint32_t min_frames,
+                               uint32_t max_frames) {
+    (void)plugin;
+    (void)sample_rate;
+    return min_frames <= max_frames;
+}
+
+static void test_clap_deactivate(const clap_plugin_t* plugin) {
+    (void)plugin;
+}
+
+static bool test_clap_start(const clap_plugin_t* plugin) {
+    (void)plugin;
+    return true;
+}
+
+static void test_clap_stop(const clap_plugin_t* plugin) {
+    (void)plugin;
+}
+
+static void test_clap_reset(const clap_plugin_t* plugin) {
+    (void)plugin;
+}
+
+static clap_process_status test_clap_process(const clap_plugin_t* plugin, const clap_process_t* process) {
+    TestClapPlugin* test = (TestClapPlugin*)plugin->plugin_data;
+    for (uint32_t e = 0; e < process->in_events->size(process->in_events); e++) {
+        const clap_event_header_t* header = process->in_events->get(process->in_events, e);
+        const clap_event_param_value_t* event = (const clap_event_param_value_t*)header;
+        if (header->type == CLAP_EVENT_PARAM_VALUE && event->param_id == TEST_CLAP_GAIN_ID) {
+            test->gain = event->value;
+        }
+    }
+    for (uint32_t i = 0; i < process->frames_count; i++) {
+        for (int c = 0; c < 2; c++) {
+            float input = process->audio_inputs[0].data32[c][i];
+            float output = input;
+            if (test->latency) {
+                output = test->line[c][test->pos];
+                test->line[c][test->pos] = input;
+            }
+            process->audio_outputs[0].data32[c][i] = output * (float)test->gain;
+        }
+        test->pos = test->latency ? (test->pos + 1) % test->latency : 0;
+    }
+    return CLAP_PROCESS_CONTINUE;
+}
+
+static uint32_t test_clap_port_count(const clap_plugin_t* plugin, bool is_input) {
+    (void)plugin;
+    (void)is_input;
+    return 1;
+}
+
+static bool test_clap_port_get(const clap_plugin_t* plugin, uint32_t index, bool is_input,
+                               clap_audio_port_info_t* info) {
+    (void)plugin;
+    (void)is_input;
+    memset(info, 0, sizeof(*info));
+    info->channel_count = 2;
+    return index == 0;
+}
+
+static uint32_t test_clap_param_count(const clap_plugin_t* plugin) {
+    (void)plugin;
+    return 1;
+}
+
+static bool test_clap_param_info(const clap_plugin_t* plugin, uint32_t index, clap_param_info_t* info) {
+    (void)plugin;
+    memset(info, 0, sizeof(*info));
+    info->id = TEST_CLAP_GAIN_ID;
+    info->max_value = 2.0;
+    info->default_value = 1.0;
+    return index == 0;
+}
+
+static bool test_clap_param_value(const clap_plugin_t* plugin, clap_id id, double* value) {
+    *value = ((const TestClapPlugin*)plugin->plugin_data)->gain;
+    return id == TEST_CLAP_GAIN_ID;
+}
+
+static uint32_t test_clap_latency(const clap_plugin_t* plugin) {
+    return ((const TestClapPlugin*)plugin->plugin_data)->latency;
+}
+
+static const clap_plugin_audio_ports_t test_clap_ports = {test_clap_port_count, test_clap_port_get};
+static const clap_plugin_params_t test_clap_params = {
+    .count = test_clap_param_count, .get_info = test_clap_param_info, .get_value = test_clap_param_value};
+static const clap_plugin_latency_t test_clap_latency_ext = {test_clap_latency};
+
+static const void* test_clap_extension(const clap_plugin_t* plugin, const char* id) {
+    (void)plugin;
+    if (strcmp(id, CLAP_EXT_AUDIO_PORTS) == 0) return &test_clap_ports;
+    if (strcmp(id, CLAP_EXT_PARAMS) == 0) return &test_clap_params;
+    if (strcmp(id, CLAP_EXT_LATENCY) == 0) return &test_clap_latency_ext;
+    return NULL;
+}
+
+static uint32_t test_clap_plugin_count(const clap_plugin_factory_t* factory) {
+    (void)factory;
+    return 2;
+}
+
+static const clap_plugin_descriptor_t* test_clap_descriptor(const clap_plugin_factory_t* factory, uint32_t index) {
+    (void)factory;
+    return index < 2 ? &test_clap_descriptors[index] : NULL;
+}
+
+static const clap_plugin_t* test_clap_create(const clap_plugin_factory_t* factory, const clap_host_t* host,
+                                             const char* plugin_id) {
+    (void)factory;
+    (void)host;
+    bool delay = strcmp(plugin_id, "test.delay") == 0;
+    TestClapPlugin* test = (TestClapPlugin*)calloc(1, sizeof(TestClapPlugin));
+    test->latency = delay ? TEST_CLAP_LATENCY : 0;
+    test->gain = 1.0;
+    test->plugin = (clap_plugin_t){
+        .desc = &test_clap_descriptors[delay],
+        .plugin_data = test,
+        .init = test_clap_init,
+        .destroy = test_clap_destroy,
+        .activate = test_clap_activate,
+        .deactivate = test_clap_deactivate,
+        .start_processing = test_clap_start,
+        .stop_processing = test_clap_stop,
+        .reset = test_clap_reset,
+        .process = test_clap_process,
+        .get_extension = test_clap_extension,
+    };
+    return &test->plugin;
+}
+
+static const clap_plugin_factory_t test_clap_factory = {test_clap_plugin_count, test_clap_descriptor,
+                                                        test_clap_create};
+
+static bool test_clap_entry_init(const char* path) {
+    (void)path;
+    return true;
+}
+
+static void test_clap_entry_deinit(void) {
+}
+
+static const void* test_clap_get_factory(const char* id) {
+    return strcmp(id, CLAP_PLUGIN_FACTORY_ID) == 0 ? &test_clap_factory : NULL;
+}
+
+static const clap_plugin_entry_t test_clap_entry = {
+    CLAP_VERSION_INIT, test_clap_entry_init, test_clap_entry_deinit, test_clap_get_factory};
+
+CTEST(clap, linked_plugin_processes_and_takes_params) {
+    MemorySink reference = memory_sink_create(PDC_FRAMES);
+    ASSERT_TRUE(render_reference_tone(&reference));
+
+    static AudioEngine engine;
+    ASSERT_TRUE(init_offline_engine(&engine));
+    audio_engine_add_track(&engine, "Tone", PDC_TONE_HZ);
+    ASSERT_FALSE(audio_engine_add_linked_clap_effect(&engine, 0, &test_clap_entry, "test.none"));
+    ASSERT_TRUE(audio_engine_add_linked_clap_effect(&engine, 0, &test_clap_entry, NULL));
+    const Effect* effect = &track_store_track(&engine.tracks, 0)->chain.effects[0];
+    ASSERT_STR("test.gain", clap_plugin_id(effect_plugin(effect)));
+    ASSERT_DBL_NEAR_TOL(1.0, effect_get_param(effect, 0), 1e-6);
+    ASSERT_TRUE(audio_engine_set_effect_param(&engine, 0, 0, 0, 0.25f));
+    audio_engine_set_track_playing(&engine, 0, true);
+
+    MemorySink mix = memory_sink_create(PDC_FRAMES);
+    EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &mix};
+    ASSERT_TRUE(audio_engine_render_offline(&engine, PDC_FRAMES, &render_sink));
+    audio_engine_shutdown(&engine);
+    for (uint64_t i = 0; i < mix.count * CHANNELS; i++) {
+        ASSERT_DBL_NEAR_TOL(0.25 * reference.frames[i], mix.frames[i], 1e-6);
+    }
+    free(mix.frames);
+    free(reference.frames);
+}
+
+CTEST(clap, latent_plugin_delays_the_other_tracks_even_bypassed) {
+    MemorySink reference = memory_sink_create(PDC_FRAMES);
+    ASSERT_TRUE(render_reference_tone(&reference));
+
+    for (int bypassed = 0; bypassed < 2; bypassed++) {
+        static AudioEngine engine;
+        ASSERT_TRUE(init_offline_engine(&engine));
+        audio_engine_add_track(&engine, "Plugin", PDC_TONE_HZ);
+        audio_engine_add_track(&engine, "Plain", PDC_TONE_HZ);
+        ASSERT_TRUE(audio_engine_add_linked_clap_effect(&engine, 0, &test_clap_entry, "test.delay"));
+        if (bypassed) {
+            ASSERT_TRUE(audio_engine_toggle_effect(&engine, 0, 0));
+        }
+        audio_engine_set_track_playing(&engine, 0, true);
+        audio_engine_set_track_playing(&engine, 1, true);
+
+        EngineSnapshot snapshot;
+        audio_engine_snapshot(&engine, &snapshot);
+        ASSERT_EQUAL(TEST_CLAP_LATENCY, (int)snapshot.latency_frames);
+
+        MemorySink mix = memory_sink_create(PDC_FRAMES);
+        EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &mix};
+        ASSERT_TRUE(audio_engine_render_offline(&engine, PDC_FRAMES, &render_sink));
+        audio_engine_shutdown(&engine);
+        ASSERT_TRUE(paths_are_aligned(&mix, &reference, TEST_CLAP_LATENCY, 1e-4f));
+        free(mix.frames);
+    }
+    free(reference.frames);
+}
+
+// A linked plugin has no path to be reloaded from: the loaded session
+// keeps its slot, parameters and automation, and passes audio through (as
+// the same session without the plugin plays; both automated, so neither
+// ramps its fader in)
+CTEST(clap, session_keeps_a_plugin_it_cannot_load) {
+    MemorySink sinks[2];
+    for (int with_plugin = 0; with_plugin < 2; with_plugin++) {
+        static AudioEngine engine;
+        ASSERT_TRUE(init_offline_engine(&engine));
+        audio_engine_add_track(&engine, "Tone", PDC_TONE_HZ);
+        const AutomationPoint level[] = {{0, 0.8f}};
+        ASSERT_TRUE(audio_engine_set_track_automation(&engine, 0, AUTOMATION_TRACK_VOLUME, 0, 0, level, 1));
+        if (with_plugin) {
+            ASSERT_TRUE(audio_engine_add_linked_clap_effect(&engine, 0, &test_clap_entry, NULL));
+            const AutomationPoint sweep[] = {{0, 0.5f}, {PDC_FRAMES, 0.1f}};
+            ASSERT_TRUE(audio_engine_set_track_automation(&engine, 0, AUTOMATION_EFFECT_PARAM, 0, 0, sweep, 2));
+        }
+        audio_engine_set_track_playing(&engine, 0, true);
+        sinks[with_plugin] = memory_sink_create(PDC_FRAMES);
+        EngineRenderSink render_sink = {.write = memory_sink_write, .user_data = &sinks[with_plugin]};
+        ASSERT_TRUE(audio_engine_render_offline(&engine, ENGINE_MIXDOWN_PERIOD_FRAMES, &render_sink));
+        ASSERT_TRUE(audio_engine_save_session(&engine, TEST_SESSION_PATH));
+        audio_engine_shutdown(&engine);
+
+        ASSERT_TRUE(init_offline_engine(&engine));
+        ASSERT_TRUE(audio_engine_load_session(&engine, TEST_SESSION_PATH));
+        const EffectChain* chain = &track_store_track(&engine.tracks, 0)->chain;
+        ASSERT_EQUAL(with_plugin, chain->count);
+        if (with_plugin) {
+            const Effect* effect = &chain->effects[chain->order[0]];
+            ASSERT_EQUAL(EFFECT_CLAP, effect->type);
+            ASSERT_NULL(effect_plugin(effect));
+            ASSERT_NOT_NULL(track_store_info(&engine.tracks, 0)->effect_lanes[chain->order[0]][0]);
+        }
+        sinks[with_plugin].count = 0;
+        ASSERT_TRUE(audio_engine_render_offline(&engine, PDC_FRAMES, &render_sink));
+        audio_engine_shutdown(&engine);
+        remove(TEST_SESSION_PATH);
+    }
+    ASSERT_TRUE(peak_of(&sinks[0]) > 0.05f);
+    ASSERT_EQUAL(0, memcmp(sinks[0].frames, sinks[1].frames, sizeof(float) * PDC_FRAMES * CHANNELS));
+    free(sinks[0].frames);
+    free(sinks[1].frames);
+}
+
+#endif // AIRDAW_CLAP
+
+int main(int argc, const char* argv[]) {
+    // Keep engine chatter out of the test report
+    engine_log_set_level(ENGINE_LOG_WARNING);
+    return ctest_main(argc, argv);
+}
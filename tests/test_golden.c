@@ -0,0 +1,287 @@
+#define CTEST_MAIN
+#define CTEST_COLOR_OK
+
+// Golden renders: fixed sessions rendered offline through the real engine
+// (libairdaw_engine) and compared sample by sample with reference WAVs in
+// tests/golden. Every session is checked on the callback backend with one
+// and several render workers and on the node graph backend, so kernel,
+// scheduling and summing-order changes have to stay within
+// GOLDEN_TOLERANCE of the references.
+//
+// After an intentional change to the sound, regenerate the references
+// with AIRDAW_UPDATE_GOLDEN=1 and commit them with the change.
+#include "../vendor/ctest/ctest.h"
+#include "../audio_engine.h"
+#include "../engine_log.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// TEST CONSTANTS
+// ============================================================================
+
+#define GOLDEN_FRAMES 6000          // Crosses an offline chunk boundary
+#define GOLDEN_TOLERANCE 1e-4       // Max per-sample error (-80 dBFS)
+#define GOLDEN_DIR "tests/golden"   // Relative to the repository root (AIRDAW_GOLDEN_DIR overrides)
+#define GOLDEN_MANY_WORKERS 4
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+typedef struct {
+    float* frames;          // Interleaved stereo
+    uint64_t count;
+    uint64_t capacity;
+} GoldenSink;
+
+static bool golden_sink_write(void* user_data, const float* frames, uint32_t frame_count) {
+    GoldenSink* sink = (GoldenSink*)user_data;
+    if (sink->count + frame_count > sink->capacity) {
+        return false;
+    }
+    memcpy(sink->frames + sink->count * CHANNELS, frames, sizeof(float) * frame_count * CHANNELS);
+    sink->count += frame_count;
+    return true;
+}
+
+typedef void (*GoldenBuildFn)(AudioEngine* engine);
+
+static void golden_path(const char* name, char* path, size_t size) {
+    const char* dir = getenv("AIRDAW_GOLDEN_DIR");
+    snprintf(path, size, "%s/%s.wav", dir ? dir : GOLDEN_DIR, name);
+}
+
+static bool golden_update_requested(void) {
+    const char* update = getenv("AIRDAW_UPDATE_GOLDEN");
+    return update && strcmp(update, "0") != 0;
+}
+
+// Render a session on a fresh offline engine; frames must hold
+// GOLDEN_FRAMES stereo frames
+static bool render_golden(GoldenBuildFn build, EngineBackend backend, int workers, float* frames) {
+    static AudioEngine engine;
+    memset(&engine, 0, sizeof(AudioEngine));
+    AudioEngineConfig config = audio_engine_config_init(ENGINE_LATENCY_DEFAULT);
+    config.offline_only = true;
+    config.render_workers = workers;
+    config.backend = backend;
+    if (!audio_engine_init_with_config(&engine, &config)) {
+        return false;
+    }
+    build(&engine);
+    GoldenSink sink = {.frames = frames, .capacity = GOLDEN_FRAMES};
+    EngineRenderSink render_sink = {.write = golden_sink_write, .user_data = &sink};
+    bool ok = audio_engine_render_offline(&engine, GOLDEN_FRAMES, &render_sink) && sink.count == GOLDEN_FRAMES;
+    audio_engine_shutdown(&engine);
+    return ok;
+}
+
+static bool write_reference(const char* path, const float* frames) {
+    ma_encoder_config config = ma_encoder_config_init(ma_encoding_format_wav, ma_format_f32, CHANNELS, SAMPLE_RATE);
+    ma_encoder encoder;
+    if (ma_encoder_init_file(path, &config, &encoder) != MA_SUCCESS) {
+        return false;
+    }
+    ma_uint64 written = 0;
+    ma_result result = ma_encoder_write_pcm_frames(&encoder, frames, GOLDEN_FRAMES, &written);
+    ma_encoder_uninit(&encoder);
+    return result == MA_SUCCESS && written == GOLDEN_FRAMES;
+}
+
+static bool read_reference(const char* path, float* frames) {
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, CHANNELS, SAMPLE_RATE);
+    ma_decoder decoder;
+    if (ma_decoder_init_file(path, &config, &decoder) != MA_SUCCESS) {
+        return false;
+    }
+    ma_uint64 read = 0;
+    ma_result result = ma_decoder_read_pcm_frames(&decoder, frames, GOLDEN_FRAMES, &read);
+    ma_uint64 length = 0;
+    ma_decoder_get_length_in_pcm_frames(&decoder, &length);
+    ma_decoder_uninit(&decoder);
+    return result == MA_SUCCESS && read == GOLDEN_FRAMES && length == GOLDEN_FRAMES;
+}
+
+static double max_error(const float* a, const float* b) {
+    double error = 0.0;
+    for (int i = 0; i < GOLDEN_FRAMES * CHANNELS; i++) {
+        double diff = fabs((double)a[i] - (double)b[i]);
+        if (diff > error) error = diff;
+    }
+    return error;
+}
+
+static double peak(const float* frames) {
+    double level = 0.0;
+    for (int i = 0; i < GOLDEN_FRAMES * CHANNELS; i++) {
+        if (fabs((double)frames[i]) > level) level = fabs((double)frames[i]);
+    }
+    return level;
+}
+
+// Compare every backend/worker variant of a session with its reference, or
+// rewrite the reference from the single-worker callback render
+static void check_golden(const char* name, GoldenBuildFn build) {
+    static float reference[GOLDEN_FRAMES * CHANNELS];
+    static float rendered[GOLDEN_FRAMES * CHANNELS];
+    char path[512];
+    golden_path(name, path, sizeof(path));
+
+    if (golden_update_requested()) {
+        ASSERT_TRUE(render_golden(build, ENGINE_BACKEND_CALLBACK, 1, reference));
+        ASSERT_TRUE(write_reference(path, reference));
+        printf("  updated %s\n", path);
+        return;
+    }
+    if (!read_reference(path, reference)) {
+        CTEST_ERR("missing or short reference %s (run with AIRDAW_UPDATE_GOLDEN=1)", path);
+    }
+    ASSERT_TRUE(peak(reference) > 0.01);
+
+    const struct {
+        EngineBackend backend;
+        int workers;
+    } variants[] = {
+        {ENGINE_BACKEND_CALLBACK, 1},
+        {ENGINE_BACKEND_CALLBACK, GOLDEN_MANY_WORKERS},
+        {ENGINE_BACKEND_NODE_GRAPH, 1},
+    };
+    for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+        ASSERT_TRUE(render_golden(build, variants[v].backend, variants[v].workers, rendered));
+        double error = max_error(reference, rendered);
+        if (error > GOLDEN_TOLERANCE) {
+            CTEST_ERR("%s: %s backend with %d workers is off the reference by %g", name,
+                      variants[v].backend == ENGINE_BACKEND_NODE_GRAPH ? "node graph" : "callback",
+                      variants[v].workers, error);
+        }
+    }
+}
+
+// ============================================================================
+// SESSIONS
+// ============================================================================
+
+// Volume, pan, mute and master volume on plain tones
+static void build_mix_session(AudioEngine* engine) {
+    const float frequencies[3] = {110.0f, 220.0f, 330.0f};
+    const float volumes[3] = {0.9f, 0.5f, 0.7f};
+    const float pans[3] = {-0.8f, 0.3f, 0.0f};
+    for (int t = 0; t < 3; t++) {
+        audio_engine_add_track(engine, "Tone", frequencies[t]);
+        audio_engine_set_track_volume(engine, t, volumes[t]);
+        audio_engine_set_track_pan(engine, t, pans[t]);
+        audio_engine_set_track_playing(engine, t, true);
+    }
+    audio_engine_set_track_mute(engine, 2, true);
+    audio_engine_set_master_volume(engine, 0.6f);
+}
+
+static void build_solo_session(AudioEngine* engine) {
+    audio_engine_add_track(engine, "Low", 110.0f);
+    audio_engine_add_track(engine, "High", 880.0f);
+    audio_engine_set_track_playing(engine, 0, true);
+    audio_engine_set_track_playing(engine, 1, true);
+    audio_engine_set_track_solo(engine, 1, true);
+}
+
+// Stacked filters and gain with non-default parameters
+static void build_filter_session(AudioEngine* engine) {
+    audio_engine_add_track(engine, "Filtered", 440.0f);
+    audio_engine_add_effect(engine, 0, EFFECT_LOWPASS);
+    audio_engine_add_effect(engine, 0, EFFECT_HIGHPASS);
+    audio_engine_add_effect(engine, 0, EFFECT_GAIN);
+    audio_engine_set_effect_param(engine, 0, 0, 0, 2500.0f);
+    audio_engine_set_effect_param(engine, 0, 1, 0, 150.0f);
+    audio_engine_set_effect_param(engine, 0, 2, 0, 1.5f);
+    audio_engine_set_track_playing(engine, 0, true);
+}
+
+// A delay track and a lowpass track sending to a shared reverb bus
+static void build_bus_session(AudioEngine* engine) {
+    audio_engine_add_track(engine, "A", 110.0f);
+    audio_engine_add_track(engine, "B", 330.0f);
+    audio_engine_add_effect(engine, 0, EFFECT_LOWPASS);
+    audio_engine_add_effect(engine, 1, EFFECT_DELAY);
+    audio_engine_set_effect_param(engine, 1, 0, 0, 40.0f);
+    audio_engine_set_effect_param(engine, 1, 0, 1, 0.5f);
+    int reverb = audio_engine_add_reverb_bus(engine, "Verb");
+    audio_engine_set_track_send(engine, 0, reverb, 0.5f);
+    audio_engine_set_track_send(engine, 1, reverb, 0.25f);
+    audio_engine_set_track_playing(engine, 0, true);
+    audio_engine_set_track_playing(engine, 1, true);
+}
+
+// Sample-accurate volume and pan lanes plus a block-rate cutoff lane
+static void build_automation_session(AudioEngine* engine) {
+    audio_engine_add_track(engine, "Swept", 220.0f);
+    audio_engine_add_effect(engine, 0, EFFECT_LOWPASS);
+    const AutomationPoint volume[] = {{0, 0.0f}, {GOLDEN_FRAMES / 2, 1.0f}, {GOLDEN_FRAMES, 0.25f}};
+    const AutomationPoint pan[] = {{0, -1.0f}, {GOLDEN_FRAMES, 1.0f}};
+    const AutomationPoint cutoff[] = {{0, 200.0f}, {GOLDEN_FRAMES, 4000.0f}};
+    audio_engine_set_track_automation(engine, 0, AUTOMATION_TRACK_VOLUME, 0, 0, volume, 3);
+    audio_engine_set_track_automation(engine, 0, AUTOMATION_TRACK_PAN, 0, 0, pan, 2);
+    audio_engine_set_track_automation(engine, 0, AUTOMATION_EFFECT_PARAM, 0, 0, cutoff, 2);
+    audio_engine_set_track_playing(engine, 0, true);
+}
+
+// Partitioned convolution with a short decaying stereo IR
+static void build_convolution_session(AudioEngine* engine) {
+    static float ir[512 * 2];
+    for (int i = 0; i < 512; i++) {
+        float decay = expf(-(float)i / 80.0f);
+        ir[i * 2] = (i % 7 == 0 ? 0.5f : -0.1f) * decay;
+        ir[i * 2 + 1] = (i % 5 == 0 ? 0.4f : 0.05f) * decay;
+    }
+    audio_engine_add_track(engine, "Convolved", 330.0f);
+    audio_engine_add_convolution(engine, 0, ir, 512, 2);
+    audio_engine_set_track_playing(engine, 0, true);
+}
+
+// A chord on an instrument track (voice pool with attack envelopes)
+static void build_instrument_session(AudioEngine* engine) {
+    audio_engine_add_instrument_track(engine, "Keys", OSC_SAW);
+    audio_engine_note_on(engine, 0, 48, 0.9f);
+    audio_engine_note_on(engine, 0, 55, 0.7f);
+    audio_engine_note_on(engine, 0, 64, 0.5f);
+}
+
+// ============================================================================
+// TESTS
+// ============================================================================
+
+CTEST(golden, mix) {
+    check_golden("mix", build_mix_session);
+}
+
+CTEST(golden, solo) {
+    check_golden("solo", build_solo_session);
+}
+
+CTEST(golden, filters) {
+    check_golden("filters", build_filter_session);
+}
+
+CTEST(golden, bus_sends) {
+    check_golden("bus_sends", build_bus_session);
+}
+
+CTEST(golden, automation) {
+    check_golden("automation", build_automation_session);
+}
+
+CTEST(golden, convolution) {
+    check_golden("convolution", build_convolution_session);
+}
+
+CTEST(golden, instrument) {
+    check_golden("instrument", build_instrument_session);
+}
+
+int main(int argc, const char* argv[]) {
+    engine_log_set_level(ENGINE_LOG_WARNING);
+    return ctest_main(argc, argv);
+}
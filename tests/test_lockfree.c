@@ -0,0 +1,390 @@
+#define CTEST_MAIN
+#define CTEST_COLOR_OK
+
+#include "../vendor/ctest/ctest.h"
+#include "../meters.h"
+#include "../spsc_ring.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE test_thread;
+#define TEST_THREAD_PROC DWORD WINAPI
+static int test_thread_start(test_thread* t, LPTHREAD_START_ROUTINE fn, void* arg) {
+    *t = CreateThread(NULL, 0, fn, arg, 0, NULL);
+    return *t != NULL;
+}
+static void test_thread_join(test_thread t) { WaitForSingleObject(t, INFINITE); CloseHandle(t); }
+static void test_thread_yield(void) { SwitchToThread(); }
+#else
+#include <pthread.h>
+#include <sched.h>
+typedef pthread_t test_thread;
+#define TEST_THREAD_PROC void*
+static int test_thread_start(test_thread* t, void* (*fn)(void*), void* arg) {
+    return pthread_create(t, NULL, fn, arg) == 0;
+}
+static void test_thread_join(test_thread t) { pthread_join(t, NULL); }
+static void test_thread_yield(void) { sched_yield(); }
+#endif
+
+// ============================================================================
+// TEST CONSTANTS
+// ============================================================================
+
+#define TEST_RING_SIZE 8
+#define TEST_STRESS_COUNT 200000
+
+typedef struct {
+    int type;
+    int track_index;
+    float value;
+} TestCommand;
+
+// ============================================================================
+// TESTS: SPSC Ring Basics
+// ============================================================================
+
+CTEST(spsc_ring, rejects_non_power_of_two) {
+    SpscRing ring;
+    TestCommand storage[6];
+    ASSERT_FALSE(spsc_ring_init(&ring, storage, sizeof(TestCommand), 6));
+    ASSERT_FALSE(spsc_ring_init(&ring, storage, sizeof(TestCommand), 0));
+}
+
+CTEST(spsc_ring, empty_pop_fails) {
+    SpscRing ring;
+    TestCommand storage[TEST_RING_SIZE];
+    TestCommand out;
+    ASSERT_TRUE(spsc_ring_init(&ring, storage, sizeof(TestCommand), TEST_RING_SIZE));
+    ASSERT_FALSE(spsc_ring_pop(&ring, &out));
+    ASSERT_EQUAL_U(0, spsc_ring_count(&ring));
+}
+
+CTEST(spsc_ring, fifo_order) {
+    SpscRing ring;
+    TestCommand storage[TEST_RING_SIZE];
+    spsc_ring_init(&ring, storage, sizeof(TestCommand), TEST_RING_SIZE);
+
+    for (int i = 0; i < 5; i++) {
+        TestCommand cmd = {.type = 1, .track_index = i, .value = (float)i * 0.5f};
+        ASSERT_TRUE(spsc_ring_push(&ring, &cmd));
+    }
+    ASSERT_EQUAL_U(5, spsc_ring_count(&ring));
+
+    for (int i = 0; i < 5; i++) {
+        TestCommand out;
+        ASSERT_TRUE(spsc_ring_pop(&ring, &out));
+        ASSERT_EQUAL(i, out.track_index);
+        ASSERT_DBL_NEAR_TOL((double)i * 0.5, out.value, 1e-6);
+    }
+}
+
+CTEST(spsc_ring, peek_leaves_element_until_skipped) {
+    SpscRing ring;
+    TestCommand storage[TEST_RING_SIZE];
+    spsc_ring_init(&ring, storage, sizeof(TestCommand), TEST_RING_SIZE);
+    ASSERT_NULL(spsc_ring_peek(&ring));
+
+    for (int i = 0; i < 2; i++) {
+        TestCommand cmd = {.track_index = i};
+        spsc_ring_push(&ring, &cmd);
+    }
+    const TestCommand* head = spsc_ring_peek(&ring);
+    ASSERT_NOT_NULL(head);
+    ASSERT_EQUAL(0, head->track_index);
+    ASSERT_EQUAL(0, ((const TestCommand*)spsc_ring_peek(&ring))->track_index);
+
+    spsc_ring_skip(&ring);
+    TestCommand out;
+    ASSERT_TRUE(spsc_ring_pop(&ring, &out));
+    ASSERT_EQUAL(1, out.track_index);
+    ASSERT_NULL(spsc_ring_peek(&ring));
+}
+
+CTEST(spsc_ring, full_push_fails) {
+    SpscRing ring;
+    TestCommand storage[TEST_RING_SIZE];
+    spsc_ring_init(&ring, storage, sizeof(TestCommand), TEST_RING_SIZE);
+
+    TestCommand cmd = {0};
+    for (int i = 0; i < TEST_RING_SIZE; i++) {
+        ASSERT_TRUE(spsc_ring_push(&ring, &cmd));
+    }
+    ASSERT_FALSE(spsc_ring_push(&ring, &cmd));
+
+    // Freeing one slot makes room again
+    TestCommand out;
+    ASSERT_TRUE(spsc_ring_pop(&ring, &out));
+    ASSERT_TRUE(spsc_ring_push(&ring, &cmd));
+}
+
+CTEST(spsc_ring, wraps_around) {
+    SpscRing ring;
+    TestCommand storage[TEST_RING_SIZE];
+    spsc_ring_init(&ring, storage, sizeof(TestCommand), TEST_RING_SIZE);
+
+    for (int i = 0; i < TEST_RING_SIZE * 10; i++) {
+        TestCommand cmd = {.track_index = i};
+        TestCommand out;
+        ASSERT_TRUE(spsc_ring_push(&ring, &cmd));
+        ASSERT_TRUE(spsc_ring_pop(&ring, &out));
+        ASSERT_EQUAL(i, out.track_index);
+    }
+}
+
+CTEST(spsc_ring, in_place_push) {
+    SpscRing ring;
+    TestCommand storage[TEST_RING_SIZE];
+    spsc_ring_init(&ring, storage, sizeof(TestCommand), TEST_RING_SIZE);
+
+    for (int i = 0; i < TEST_RING_SIZE; i++) {
+        TestCommand* slot = (TestCommand*)spsc_ring_acquire_push(&ring);
+        ASSERT_NOT_NULL(slot);
+        slot->track_index = i;
+        spsc_ring_commit_push(&ring);
+    }
+    ASSERT_NULL(spsc_ring_acquire_push(&ring));
+
+    // Acquiring without committing publishes nothing
+    TestCommand out;
+    ASSERT_TRUE(spsc_ring_pop(&ring, &out));
+    ASSERT_EQUAL(0, out.track_index);
+    ASSERT_NOT_NULL(spsc_ring_acquire_push(&ring));
+    ASSERT_EQUAL(TEST_RING_SIZE - 1, (int)spsc_ring_count(&ring));
+    for (int i = 1; i < TEST_RING_SIZE; i++) {
+        ASSERT_TRUE(spsc_ring_pop(&ring, &out));
+        ASSERT_EQUAL(i, out.track_index);
+    }
+    ASSERT_FALSE(spsc_ring_pop(&ring, &out));
+}
+
+// ============================================================================
+// TESTS: SPSC Ring Across Threads
+// ============================================================================
+
+typedef struct {
+    SpscRing* ring;
+    atomic_int failures;
+} ConsumerContext;
+
+static TEST_THREAD_PROC consumer_thread(void* user_data) {
+    ConsumerContext* ctx = (ConsumerContext*)user_data;
+    int expected = 0;
+    while (expected < TEST_STRESS_COUNT) {
+        TestCommand out;
+        if (spsc_ring_pop(ctx->ring, &out)) {
+            if (out.track_index != expected || out.value != (float)expected) {
+                atomic_fetch_add(&ctx->failures, 1);
+            }
+            expected++;
+        } else {
+            test_thread_yield();
+        }
+    }
+    return 0;
+}
+
+CTEST(spsc_ring, producer_consumer_threads) {
+    SpscRing ring;
+    TestCommand* storage = malloc(sizeof(TestCommand) * 64);
+    spsc_ring_init(&ring, storage, sizeof(TestCommand), 64);
+
+    ConsumerContext ctx = {.ring = &ring};
+    atomic_store(&ctx.failures, 0);
+
+    test_thread thread;
+    ASSERT_TRUE(test_thread_start(&thread, consumer_thread, &ctx));
+
+    for (int i = 0; i < TEST_STRESS_COUNT; i++) {
+        TestCommand cmd = {.track_index = i, .value = (float)i};
+        while (!spsc_ring_push(&ring, &cmd)) {
+            test_thread_yield(); // Wait for consumer to free a slot
+        }
+    }
+
+    test_thread_join(thread);
+    ASSERT_EQUAL(0, atomic_load(&ctx.failures));
+    free(storage);
+}
+
+// ============================================================================
+// TESTS: Meter Seqlock
+// ============================================================================
+
+CTEST(meters, publish_and_read) {
+    MeterChannel channel = {0};
+    MeterRecord record = {.peak = {0.5f, 0.25f}, .rms = {0.3f, 0.1f}, .clip_count = 3, .block_frame = 1024};
+    meter_channel_publish(&channel, &record);
+
+    MeterRecord out;
+    ASSERT_TRUE(meter_channel_read(&channel, &out));
+    ASSERT_DBL_NEAR_TOL(0.5, out.peak[0], 1e-6);
+    ASSERT_DBL_NEAR_TOL(0.25, out.peak[1], 1e-6);
+    ASSERT_DBL_NEAR_TOL(0.3, out.rms[0], 1e-6);
+    ASSERT_EQUAL_U(3, out.clip_count);
+    ASSERT_EQUAL_U(1024, out.block_frame);
+    ASSERT_EQUAL_U(0, atomic_load(&channel.sequence) & 1u);
+}
+
+CTEST(meters, accumulator_covers_all_sub_blocks) {
+    MeterChannel channel = {0};
+    MeterAccumulator acc;
+    meter_accumulator_reset(&acc);
+
+    // Two sub-blocks: a loud one, then a quiet one; the published record
+    // must keep the first block's peak and average RMS over both
+    acc.peak[0] = 0.9f;
+    acc.sum_squares[0] = 64 * 0.5f * 0.5f;
+    acc.clips = 2;
+    acc.frames = 64;
+    acc.sum_squares[0] += 64 * 0.1f * 0.1f;
+    acc.frames += 64;
+    meter_accumulator_publish(&acc, &channel, 128);
+
+    MeterRecord out;
+    ASSERT_TRUE(meter_channel_read(&channel, &out));
+    ASSERT_DBL_NEAR_TOL(0.9, out.peak[0], 1e-6);
+    ASSERT_DBL_NEAR_TOL(sqrt((0.25 + 0.01) / 2.0), out.rms[0], 1e-5);
+    ASSERT_DBL_NEAR_TOL(0.0, out.rms[1], 1e-9);
+    ASSERT_EQUAL_U(2, out.clip_count);
+    ASSERT_EQUAL_U(128, out.block_frame);
+
+    // Clip counts stay cumulative; an empty accumulator publishes silence
+    meter_accumulator_reset(&acc);
+    meter_accumulator_publish(&acc, &channel, 256);
+    ASSERT_TRUE(meter_channel_read(&channel, &out));
+    ASSERT_DBL_NEAR_TOL(0.0, out.peak[0], 1e-9);
+    ASSERT_EQUAL_U(2, out.clip_count);
+}
+
+CTEST(meters, dsp_load_window_rolls_over) {
+    DspLoadChannel channel = {0};
+    DspLoadAccumulator acc;
+    DspLoadRecord record = {0};
+    dsp_load_accumulator_reset(&acc);
+
+    // Until a window completes only the last load moves
+    dsp_load_accumulator_add(&acc, 0.2f, 256, 1024, &record);
+    dsp_load_accumulator_add(&acc, 0.6f, 256, 1024, &record);
+    ASSERT_DBL_NEAR_TOL(0.6, record.load, 1e-6);
+    ASSERT_DBL_NEAR_TOL(0.0, record.load_max, 1e-9);
+
+    dsp_load_accumulator_add(&acc, 0.1f, 256, 1024, &record);
+    dsp_load_accumulator_add(&acc, 0.3f, 256, 1024, &record);
+    record.xruns = 3;
+    record.callbacks = 4;
+    dsp_load_channel_publish(&channel, &record);
+
+    DspLoadRecord out;
+    ASSERT_TRUE(dsp_load_channel_read(&channel, &out));
+    ASSERT_DBL_NEAR_TOL(0.3, out.load, 1e-6);
+    ASSERT_DBL_NEAR_TOL(0.1, out.load_min, 1e-6);
+    ASSERT_DBL_NEAR_TOL(0.3, out.load_avg, 1e-6);
+    ASSERT_DBL_NEAR_TOL(0.6, out.load_max, 1e-6);
+    ASSERT_EQUAL_U(3, out.xruns);
+    ASSERT_EQUAL_U(4, out.callbacks);
+
+    // The next window starts from scratch
+    dsp_load_accumulator_add(&acc, 0.05f, 1024, 1024, &record);
+    ASSERT_DBL_NEAR_TOL(0.05, record.load_max, 1e-6);
+    ASSERT_DBL_NEAR_TOL(0.05, record.load_min, 1e-6);
+}
+
+typedef struct {
+    MeterChannel* channel;
+    atomic_bool done;
+} MeterWriterContext;
+
+static TEST_THREAD_PROC meter_writer_thread(void* user_data) {
+    MeterWriterContext* ctx = (MeterWriterContext*)user_data;
+    for (uint64_t i = 1; i <= 50000; i++) {
+        // Every field carries the same value so torn reads are detectable
+        float v = (float)(i % 1000);
+        MeterRecord record = {.peak = {v, v}, .rms = {v, v}, .clip_count = (uint32_t)(i % 1000), .block_frame = i % 1000};
+        meter_channel_publish(ctx->channel, &record);
+        if ((i & 63) == 0) {
+            test_thread_yield();
+        }
+    }
+    atomic_store(&ctx->done, true);
+    return 0;
+}
+
+CTEST(meters, reads_are_never_torn) {
+    MeterChannel channel = {0};
+    MeterWriterContext ctx = {.channel = &channel};
+    atomic_store(&ctx.done, false);
+
+    test_thread thread;
+    ASSERT_TRUE(test_thread_start(&thread, meter_writer_thread, &ctx));
+
+    int torn = 0;
+    while (!atomic_load(&ctx.done)) {
+        MeterRecord out;
+        if (meter_channel_read(&channel, &out)) {
+            float v = out.peak[0];
+            if (out.peak[1] != v || out.rms[0] != v || out.rms[1] != v ||
+                out.clip_count != (uint32_t)v || out.block_frame != (uint64_t)v) {
+                torn++;
+            }
+        }
+        test_thread_yield();
+    }
+    test_thread_join(thread);
+    ASSERT_EQUAL(0, torn);
+}
+
+// ============================================================================
+// TESTS: Meter Ballistics
+// ============================================================================
+
+CTEST(meters, ballistics_instant_attack_and_release) {
+    MeterBallistics meter;
+    meter_ballistics_reset(&meter);
+
+    MeterRecord loud = {.peak = {0.8f, 0.8f}, .block_frame = 512};
+    meter_ballistics_update(&meter, &loud, 0.01f);
+    ASSERT_DBL_NEAR_TOL(0.8, meter.peak[0], 1e-6);
+    ASSERT_DBL_NEAR_TOL(0.8, meter.hold[0], 1e-6);
+
+    // One second of silence releases the bar by the configured dB/s
+    MeterRecord silent = {.block_frame = 1024};
+    for (int i = 0; i < 100; i++) {
+        silent.block_frame += 512;
+        meter_ballistics_update(&meter, &silent, 0.01f);
+    }
+    double expected = 0.8 * pow(10.0, -METER_RELEASE_DB_PER_SEC / 20.0);
+    ASSERT_DBL_NEAR_TOL(expected, meter.peak[0], 1e-3);
+
+    // The hold marker is still latched within the hold time
+    ASSERT_DBL_NEAR_TOL(0.8, meter.hold[0], 1e-6);
+}
+
+CTEST(meters, ballistics_clip_latch) {
+    MeterBallistics meter;
+    meter_ballistics_reset(&meter);
+    ASSERT_FALSE(meter_ballistics_clipping(&meter));
+
+    MeterRecord clipped = {.peak = {1.2f, 0.5f}, .clip_count = 4, .block_frame = 512};
+    meter_ballistics_update(&meter, &clipped, 0.01f);
+    ASSERT_TRUE(meter_ballistics_clipping(&meter));
+
+    MeterRecord quiet = {.clip_count = 4, .block_frame = 1024};
+    meter_ballistics_update(&meter, &quiet, METER_CLIP_HOLD_SECONDS + 0.1f);
+    ASSERT_FALSE(meter_ballistics_clipping(&meter));
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+int main(int argc, const char* argv[]) {
+    return ctest_main(argc, argv);
+}
@@ -0,0 +1,421 @@
+#define CTEST_MAIN
+#define CTEST_COLOR_OK
+
+// Decoders, encoder (to write fixtures) and the streamer's mutex
+#define MINIAUDIO_IMPLEMENTATION
+#define MA_NO_DEVICE_IO
+#include "../vendor/miniaudio/miniaudio.h"
+
+#include "../vendor/ctest/ctest.h"
+#include "../clip_cache.h"
+#include "../clip_stream.h"
+#include "../engine_thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// ============================================================================
+// TEST CONSTANTS
+// ============================================================================
+
+#define TEST_SAMPLE_RATE 48000
+#define TEST_BLOCK 512
+#define TEST_CLIP_PATH "test_streaming_clip.wav"
+#define TEST_CACHE_PATH "test_streaming_clip.wav" CLIP_CACHE_EXTENSION
+#define LONG_CLIP_FRAMES (CLIP_STREAM_RING_FRAMES * 2 + 1234)   // Never fits in the ring
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static float expected_left(uint64_t frame) {
+    return (float)(frame % 1000) / 1000.0f;
+}
+
+// Write a float stereo WAV whose samples identify their frame
+static bool write_clip(const char* path, uint64_t frames) {
+    ma_encoder_config config = ma_encoder_config_init(ma_encoding_format_wav, ma_format_f32, 2, TEST_SAMPLE_RATE);
+    ma_encoder encoder;
+    if (ma_encoder_init_file(path, &config, &encoder) != MA_SUCCESS) {
+        return false;
+    }
+    float chunk[1024 * 2];
+    for (uint64_t start = 0; start < frames; start += 1024) {
+        uint64_t count = frames - start < 1024 ? frames - start : 1024;
+        for (uint64_t i = 0; i < count; i++) {
+            chunk[i * 2] = expected_left(start + i);
+            chunk[i * 2 + 1] = -expected_left(start + i);
+        }
+        ma_encoder_write_pcm_frames(&encoder, chunk, count, NULL);
+    }
+    ma_encoder_uninit(&encoder);
+    return true;
+}
+
+// Wait (bounded) until the streamer has queued at least `frames`
+static void wait_buffered(ClipStream* stream, uint64_t frames) {
+    ClipStreamStats stats;
+    for (int i = 0; i < 2000; i++) {
+        clip_stream_get_stats(stream, &stats);
+        if (stats.buffered_frames >= frames) return;
+        engine_thread_sleep_ms(1);
+    }
+}
+
+// ============================================================================
+// STREAMING
+// ============================================================================
+
+CTEST(clip_stream, plays_long_file_through_small_ring) {
+    ASSERT_TRUE(write_clip(TEST_CLIP_PATH, LONG_CLIP_FRAMES));
+    ClipStreamer streamer;
+    ASSERT_TRUE(clip_streamer_start(&streamer));
+    ClipStream* stream = clip_stream_open(&streamer, TEST_CLIP_PATH, TEST_SAMPLE_RATE, false);
+    ASSERT_NOT_NULL(stream);
+    ASSERT_EQUAL(LONG_CLIP_FRAMES, (int)stream->length_frames);
+
+    // Consume like the audio thread, giving the streamer time to keep up
+    float left[TEST_BLOCK], right[TEST_BLOCK];
+    uint64_t frame = 0;
+    bool match = true;
+    while (frame < LONG_CLIP_FRAMES) {
+        uint64_t remaining = LONG_CLIP_FRAMES - frame;
+        wait_buffered(stream, remaining < TEST_BLOCK ? remaining : TEST_BLOCK);
+        clip_stream_read(stream, left, right, TEST_BLOCK);
+        for (uint32_t i = 0; i < TEST_BLOCK && frame + i < LONG_CLIP_FRAMES; i++) {
+            match = match && left[i] == expected_left(frame + i) && right[i] == -expected_left(frame + i);
+        }
+        frame += TEST_BLOCK;
+    }
+    ASSERT_TRUE(match);
+
+    // Past the end: silence, and not an underrun
+    clip_stream_read(stream, left, right, TEST_BLOCK);
+    ASSERT_EQUAL(0, (int)(left[0] * 1000.0f));
+    ClipStreamStats stats;
+    clip_stream_get_stats(stream, &stats);
+    ASSERT_EQUAL(0, (int)stats.underrun_events);
+
+    clip_stream_close(&streamer, stream);
+    clip_streamer_stop(&streamer);
+    remove(TEST_CLIP_PATH);
+}
+
+CTEST(clip_stream, looping_clip_wraps) {
+    ASSERT_TRUE(write_clip(TEST_CLIP_PATH, 3000));
+    ClipStreamer streamer;
+    ASSERT_TRUE(clip_streamer_start(&streamer));
+    ClipStream* stream = clip_stream_open(&streamer, TEST_CLIP_PATH, TEST_SAMPLE_RATE, true);
+    ASSERT_NOT_NULL(stream);
+
+    float left[TEST_BLOCK], right[TEST_BLOCK];
+    bool match = true;
+    for (uint64_t frame = 0; frame < 20000; frame += TEST_BLOCK) {
+        wait_buffered(stream, TEST_BLOCK);
+        clip_stream_read(stream, left, right, TEST_BLOCK);
+        for (uint32_t i = 0; i < TEST_BLOCK; i++) {
+            match = match && left[i] == expected_left((frame + i) % 3000);
+        }
+    }
+    ASSERT_TRUE(match);
+
+    ClipStreamStats stats;
+    clip_stream_get_stats(stream, &stats);
+    ASSERT_EQUAL((20000 / TEST_BLOCK + 1) * TEST_BLOCK % 3000, (int)stats.playhead_frame);
+
+    clip_stream_close(&streamer, stream);
+    clip_streamer_stop(&streamer);
+    remove(TEST_CLIP_PATH);
+}
+
+CTEST(clip_stream, seek_drops_queued_audio) {
+    ASSERT_TRUE(write_clip(TEST_CLIP_PATH, LONG_CLIP_FRAMES));
+    ClipStreamer streamer;
+    ASSERT_TRUE(clip_streamer_start(&streamer));
+    ClipStream* stream = clip_stream_open(&streamer, TEST_CLIP_PATH, TEST_SAMPLE_RATE, false);
+    ASSERT_NOT_NULL(stream);
+
+    float left[TEST_BLOCK], right[TEST_BLOCK];
+    clip_stream_read(stream, left, right, TEST_BLOCK);
+
+    // Keep reading until the post-seek audio shows up. Until the streamer
+    // services the seek, reads continue from the old position (frames that
+    // are multiples of the block, which never alias the target), then the
+    // refill gap is silence.
+    clip_stream_seek(stream, 100123);
+    bool found = false;
+    for (int attempt = 0; attempt < 2000 && !found; attempt++) {
+        engine_thread_sleep_ms(1);
+        clip_stream_read(stream, left, right, TEST_BLOCK);
+        found = left[0] == expected_left(100123);
+    }
+    ASSERT_TRUE(found);
+    ASSERT_DBL_NEAR_TOL(expected_left(100123 + TEST_BLOCK - 1), left[TEST_BLOCK - 1], 1e-6);
+
+    ClipStreamStats stats;
+    clip_stream_get_stats(stream, &stats);
+    ASSERT_EQUAL(100123 + TEST_BLOCK, (int)stats.playhead_frame);
+    ASSERT_EQUAL(0, (int)stats.underrun_events);
+
+    clip_stream_close(&streamer, stream);
+    clip_streamer_stop(&streamer);
+    remove(TEST_CLIP_PATH);
+}
+
+CTEST(clip_stream, starved_reader_counts_underruns) {
+    ASSERT_TRUE(write_clip(TEST_CLIP_PATH, LONG_CLIP_FRAMES));
+    ClipStreamer streamer;
+    ASSERT_TRUE(clip_streamer_start(&streamer));
+    ClipStream* stream = clip_stream_open(&streamer, TEST_CLIP_PATH, TEST_SAMPLE_RATE, false);
+    ASSERT_NOT_NULL(stream);
+
+    // Stop the streamer: only the prefilled ring is left to play
+    wait_buffered(stream, CLIP_STREAM_RING_FRAMES);
+    clip_streamer_stop(&streamer);
+
+    float left[TEST_BLOCK], right[TEST_BLOCK];
+    for (uint32_t frame = 0; frame < CLIP_STREAM_RING_FRAMES; frame += TEST_BLOCK) {
+        clip_stream_read(stream, left, right, TEST_BLOCK);
+    }
+    ClipStreamStats stats;
+    clip_stream_get_stats(stream, &stats);
+    ASSERT_EQUAL(0, (int)stats.underrun_events);
+
+    clip_stream_read(stream, left, right, TEST_BLOCK);
+    clip_stream_read(stream, left, right, TEST_BLOCK);
+    clip_stream_get_stats(stream, &stats);
+    ASSERT_EQUAL(2, (int)stats.underrun_events);
+    ASSERT_EQUAL(2 * TEST_BLOCK, (int)stats.underrun_frames);
+    ASSERT_EQUAL(0, (int)stats.buffered_frames);
+
+    clip_stream_close(&streamer, stream);
+    remove(TEST_CLIP_PATH);
+}
+
+CTEST(clip_stream, blocking_reader_waits_instead_of_underrunning) {
+    ASSERT_TRUE(write_clip(TEST_CLIP_PATH, LONG_CLIP_FRAMES));
+    ClipStreamer streamer;
+    ASSERT_TRUE(clip_streamer_start(&streamer));
+    ClipStream* stream = clip_stream_open(&streamer, TEST_CLIP_PATH, TEST_SAMPLE_RATE, false);
+    ASSERT_NOT_NULL(stream);
+    clip_stream_set_blocking(stream, true);
+
+    // Drain as fast as possible, as an offline render would
+    float left[TEST_BLOCK], right[TEST_BLOCK];
+    bool match = true;
+    for (uint64_t frame = 0; frame + TEST_BLOCK <= LONG_CLIP_FRAMES; frame += TEST_BLOCK) {
+        clip_stream_read(stream, left, right, TEST_BLOCK);
+        match = match && left[0] == expected_left(frame) && right[TEST_BLOCK - 1] == -expected_left(frame + TEST_BLOCK - 1);
+    }
+    ASSERT_TRUE(match);
+
+    // The end of the clip still returns instead of waiting forever
+    clip_stream_read(stream, left, right, TEST_BLOCK);
+    clip_stream_read(stream, left, right, TEST_BLOCK);
+    ClipStreamStats stats;
+    clip_stream_get_stats(stream, &stats);
+    ASSERT_EQUAL(0, (int)stats.underrun_events);
+
+    clip_stream_close(&streamer, stream);
+    clip_streamer_stop(&streamer);
+    remove(TEST_CLIP_PATH);
+}
+
+CTEST(clip_stream, missing_file_fails) {
+    ClipStreamer streamer;
+    ASSERT_TRUE(clip_streamer_start(&streamer));
+    ASSERT_NULL(clip_stream_open(&streamer, "no_such_clip.wav", TEST_SAMPLE_RATE, false));
+    clip_streamer_stop(&streamer);
+}
+
+// ============================================================================
+// CLIP CACHE
+// ============================================================================
+
+CTEST(clip_cache, float_planes_are_sample_exact) {
+    ASSERT_TRUE(write_clip(TEST_CLIP_PATH, 70001));
+    ASSERT_TRUE(clip_cache_build(TEST_CLIP_PATH, TEST_CACHE_PATH, TEST_SAMPLE_RATE, CLIP_CACHE_F32));
+
+    ClipCache cache;
+    ASSERT_TRUE(clip_cache_open(&cache, TEST_CACHE_PATH));
+    ASSERT_EQUAL(70001, (int)clip_cache_frame_count(&cache));
+    ASSERT_EQUAL(2, (int)cache.header->channels);
+    ASSERT_EQUAL(0, (int)(cache.header->data_offset % CLIP_CACHE_PAGE_BYTES));
+
+    // Planes are read in place from the mapping
+    const float* left_plane = (const float*)clip_cache_plane(&cache, 0);
+    const float* right_plane = (const float*)clip_cache_plane(&cache, 1);
+    bool match = true;
+    for (uint64_t i = 0; i < 70001; i++) {
+        match = match && left_plane[i] == expected_left(i) && right_plane[i] == -expected_left(i);
+    }
+    ASSERT_TRUE(match);
+
+    float left[TEST_BLOCK], right[TEST_BLOCK];
+    clip_cache_read(&cache, 70001 - TEST_BLOCK, left, right, TEST_BLOCK);
+    ASSERT_DBL_NEAR_TOL(expected_left(70000), left[TEST_BLOCK - 1], 1e-7);
+    ASSERT_DBL_NEAR_TOL(-expected_left(70000), right[TEST_BLOCK - 1], 1e-7);
+
+    clip_cache_close(&cache);
+    remove(TEST_CACHE_PATH);
+    remove(TEST_CLIP_PATH);
+}
+
+// A source recorded at another rate is converted once, on import: the
+// cache holds the clip's length at the engine rate
+CTEST(clip_cache, other_rates_are_converted_on_build) {
+    ma_encoder_config config = ma_encoder_config_init(ma_encoding_format_wav, ma_format_f32, 2, 44100);
+    ma_encoder encoder;
+    ASSERT_EQUAL(MA_SUCCESS, ma_encoder_init_file(TEST_CLIP_PATH, &config, &encoder));
+    float chunk[1000 * 2];
+    for (uint32_t i = 0; i < 1000; i++) {
+        chunk[i * 2] = 0.25f;
+        chunk[i * 2 + 1] = -0.25f;
+    }
+    for (int i = 0; i < 441; i++) {
+        ma_encoder_write_pcm_frames(&encoder, chunk, 1000, NULL);
+    }
+    ma_encoder_uninit(&encoder);
+    ASSERT_TRUE(clip_cache_build(TEST_CLIP_PATH, TEST_CACHE_PATH, TEST_SAMPLE_RATE, CLIP_CACHE_F32));
+
+    ClipCache cache;
+    ASSERT_TRUE(clip_cache_open(&cache, TEST_CACHE_PATH));
+    ASSERT_EQUAL(TEST_SAMPLE_RATE * 10, (int)clip_cache_frame_count(&cache));
+    ASSERT_EQUAL(TEST_SAMPLE_RATE, (int)cache.header->sample_rate);
+    float left[TEST_BLOCK], right[TEST_BLOCK];
+    clip_cache_read(&cache, 200000, left, right, TEST_BLOCK);
+    for (uint32_t i = 0; i < TEST_BLOCK; i++) {
+        ASSERT_DBL_NEAR_TOL(0.25f, left[i], 1e-4);
+        ASSERT_DBL_NEAR_TOL(-0.25f, right[i], 1e-4);
+    }
+
+    clip_cache_close(&cache);
+    remove(TEST_CACHE_PATH);
+    remove(TEST_CLIP_PATH);
+}
+
+CTEST(clip_cache, int16_planes_round_trip) {
+    ASSERT_TRUE(write_clip(TEST_CLIP_PATH, 5000));
+    ASSERT_TRUE(clip_cache_build(TEST_CLIP_PATH, TEST_CACHE_PATH, TEST_SAMPLE_RATE, CLIP_CACHE_S16));
+
+    ClipCache cache;
+    ASSERT_TRUE(clip_cache_open(&cache, TEST_CACHE_PATH));
+    ASSERT_EQUAL(CLIP_CACHE_S16, (int)cache.header->format);
+    float left[1000], right[1000];
+    clip_cache_read(&cache, 2000, left, right, 1000);
+    for (uint32_t i = 0; i < 1000; i++) {
+        ASSERT_DBL_NEAR_TOL(expected_left(2000 + i), left[i], 1.0 / 32767.0);
+        ASSERT_DBL_NEAR_TOL(-expected_left(2000 + i), right[i], 1.0 / 32767.0);
+    }
+
+    clip_cache_close(&cache);
+    remove(TEST_CACHE_PATH);
+    remove(TEST_CLIP_PATH);
+}
+
+CTEST(clip_cache, peak_pyramid_covers_clip) {
+    ASSERT_TRUE(write_clip(TEST_CLIP_PATH, 100000));
+    ASSERT_TRUE(clip_cache_build(TEST_CLIP_PATH, TEST_CACHE_PATH, TEST_SAMPLE_RATE, CLIP_CACHE_F32));
+    ClipCache cache;
+    ASSERT_TRUE(clip_cache_open(&cache, TEST_CACHE_PATH));
+
+    // Level 0: one bucket per CLIP_CACHE_PEAK_FRAMES, last one partial
+    uint64_t count = 0;
+    const ClipPeak* peaks = clip_cache_peaks(&cache, 0, 0, &count);
+    ASSERT_EQUAL((100000 + CLIP_CACHE_PEAK_FRAMES - 1) / CLIP_CACHE_PEAK_FRAMES, (int)count);
+    ASSERT_DBL_NEAR_TOL(expected_left(256), peaks[1].min, 1e-7);
+    ASSERT_DBL_NEAR_TOL(expected_left(511), peaks[1].max, 1e-7);
+
+    // The top level is a single bucket over the whole clip
+    uint32_t top = cache.header->peak_levels - 1;
+    peaks = clip_cache_peaks(&cache, top, 1, &count);
+    ASSERT_EQUAL(1, (int)count);
+    ASSERT_DBL_NEAR_TOL(-0.999, peaks[0].min, 1e-6);
+    ASSERT_DBL_NEAR_TOL(0.0, peaks[0].max, 1e-6);
+
+    ASSERT_EQUAL(0, (int)clip_cache_peak_level_for(&cache, 1.0));
+    ASSERT_EQUAL(1, (int)clip_cache_peak_level_for(&cache, CLIP_CACHE_PEAK_FRAMES * CLIP_CACHE_PEAK_FACTOR));
+    ASSERT_EQUAL((int)top, (int)clip_cache_peak_level_for(&cache, 1e12));
+
+    clip_cache_close(&cache);
+    remove(TEST_CACHE_PATH);
+    remove(TEST_CLIP_PATH);
+}
+
+CTEST(clip_cache, import_reuses_fresh_cache_and_rebuilds_stale) {
+    ASSERT_TRUE(write_clip(TEST_CLIP_PATH, 3000));
+    char cache_path[256];
+    ASSERT_TRUE(clip_cache_import(TEST_CLIP_PATH, TEST_SAMPLE_RATE, CLIP_CACHE_F32, cache_path, sizeof(cache_path)));
+    ASSERT_STR(TEST_CACHE_PATH, cache_path);
+    ASSERT_TRUE(clip_cache_is_fresh(cache_path, TEST_CLIP_PATH, TEST_SAMPLE_RATE));
+    ASSERT_FALSE(clip_cache_is_fresh(cache_path, TEST_CLIP_PATH, 44100));
+
+    // A different source invalidates the cache; import rebuilds it
+    ASSERT_TRUE(write_clip(TEST_CLIP_PATH, 4000));
+    ASSERT_FALSE(clip_cache_is_fresh(cache_path, TEST_CLIP_PATH, TEST_SAMPLE_RATE));
+    ASSERT_TRUE(clip_cache_import(TEST_CLIP_PATH, TEST_SAMPLE_RATE, CLIP_CACHE_F32, cache_path, sizeof(cache_path)));
+    ClipCache cache;
+    ASSERT_TRUE(clip_cache_open(&cache, cache_path));
+    ASSERT_EQUAL(4000, (int)clip_cache_frame_count(&cache));
+    clip_cache_close(&cache);
+
+    remove(TEST_CACHE_PATH);
+    remove(TEST_CLIP_PATH);
+}
+
+CTEST(clip_cache, rejects_truncated_file) {
+    ASSERT_TRUE(write_clip(TEST_CLIP_PATH, 10000));
+    ASSERT_TRUE(clip_cache_build(TEST_CLIP_PATH, TEST_CACHE_PATH, TEST_SAMPLE_RATE, CLIP_CACHE_F32));
+
+    // Keep only the header and part of the first plane
+    FILE* file = fopen(TEST_CACHE_PATH, "rb");
+    ASSERT_NOT_NULL(file);
+    static uint8_t head[CLIP_CACHE_PAGE_BYTES * 2];
+    size_t bytes = fread(head, 1, sizeof(head), file);
+    fclose(file);
+    file = fopen(TEST_CACHE_PATH, "wb");
+    fwrite(head, 1, bytes, file);
+    fclose(file);
+
+    ClipCache cache;
+    ASSERT_FALSE(clip_cache_open(&cache, TEST_CACHE_PATH));
+    ASSERT_FALSE(clip_cache_open(&cache, "no_such_cache" CLIP_CACHE_EXTENSION));
+
+    remove(TEST_CACHE_PATH);
+    remove(TEST_CLIP_PATH);
+}
+
+CTEST(clip_cache, stream_reads_from_mapping) {
+    ASSERT_TRUE(write_clip(TEST_CLIP_PATH, LONG_CLIP_FRAMES));
+    ASSERT_TRUE(clip_cache_build(TEST_CLIP_PATH, TEST_CACHE_PATH, TEST_SAMPLE_RATE, CLIP_CACHE_F32));
+    ClipStreamer streamer;
+    ASSERT_TRUE(clip_streamer_start(&streamer));
+    ClipStream* stream = clip_stream_open_cache(&streamer, TEST_CACHE_PATH, false);
+    ASSERT_NOT_NULL(stream);
+    ASSERT_EQUAL(LONG_CLIP_FRAMES, (int)stream->length_frames);
+
+    float left[TEST_BLOCK], right[TEST_BLOCK];
+    clip_stream_read(stream, left, right, TEST_BLOCK);
+    ASSERT_DBL_NEAR_TOL(expected_left(TEST_BLOCK - 1), left[TEST_BLOCK - 1], 1e-7);
+
+    clip_stream_seek(stream, LONG_CLIP_FRAMES - 1000);
+    bool found = false;
+    for (int attempt = 0; attempt < 2000 && !found; attempt++) {
+        engine_thread_sleep_ms(1);
+        clip_stream_read(stream, left, right, TEST_BLOCK);
+        found = left[0] == expected_left(LONG_CLIP_FRAMES - 1000);   // See seek_drops_queued_audio
+    }
+    ASSERT_TRUE(found);
+    ASSERT_DBL_NEAR_TOL(-expected_left(LONG_CLIP_FRAMES - 1000 + 7), right[7], 1e-7);
+
+    clip_stream_close(&streamer, stream);
+    clip_streamer_stop(&streamer);
+    remove(TEST_CACHE_PATH);
+    remove(TEST_CLIP_PATH);
+}
+
+int main(int argc, const char* argv[]) {
+    return ctest_main(argc, argv);
+}
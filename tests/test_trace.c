@@ -0,0 +1,111 @@
+#define CTEST_MAIN
+#define CTEST_COLOR_OK
+
+// Built with -DAIRDAW_TRACE against engine_trace.c, engine_thread.c and
+// engine_log.c only
+#include "../vendor/ctest/ctest.h"
+#include "../engine_thread.h"
+#include "../engine_trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// TEST CONSTANTS
+// ============================================================================
+
+#define TEST_TRACE_PATH "test_trace.json"
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static char* read_file(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* text = (char*)malloc((size_t)size + 1);
+    if (text) {
+        size_t read = fread(text, 1, (size_t)size, file);
+        text[read] = '\0';
+    }
+    fclose(file);
+    return text;
+}
+
+static int count_occurrences(const char* text, const char* needle) {
+    int count = 0;
+    for (const char* at = strstr(text, needle); at; at = strstr(at + 1, needle)) {
+        count++;
+    }
+    return count;
+}
+
+static void traced_worker(void* user_data) {
+    (void)user_data;
+    ENGINE_TRACE_THREAD_NAME("worker \"a\"");
+    for (int i = 0; i < 10; i++) {
+        ENGINE_TRACE_BEGIN("job");
+        ENGINE_TRACE_END("job");
+    }
+}
+
+// ============================================================================
+// TESTS
+// ============================================================================
+
+CTEST(trace, events_from_every_thread_reach_the_json) {
+    ASSERT_TRUE(engine_trace_init());
+    ENGINE_TRACE_THREAD_NAME("main");
+    ENGINE_TRACE_BEGIN("outer");
+    ENGINE_TRACE_BEGIN("inner");
+    ENGINE_TRACE_END("inner");
+    ENGINE_TRACE_END("outer");
+
+    EngineThread thread;
+    ASSERT_TRUE(engine_thread_start(&thread, traced_worker, NULL, ENGINE_THREAD_PRIORITY_NORMAL, -1));
+    engine_thread_join(&thread);
+
+    ASSERT_TRUE(engine_trace_write_json(TEST_TRACE_PATH));
+    char* json = read_file(TEST_TRACE_PATH);
+    ASSERT_NOT_NULL(json);
+    ASSERT_NOT_NULL(strstr(json, "\"traceEvents\""));
+    ASSERT_EQUAL(2, count_occurrences(json, "\"thread_name\""));
+    ASSERT_NOT_NULL(strstr(json, "\"name\": \"worker \\\"a\\\"\""));
+    ASSERT_EQUAL(2, count_occurrences(json, "\"name\": \"outer\""));
+    ASSERT_EQUAL(20, count_occurrences(json, "\"name\": \"job\""));
+    ASSERT_EQUAL(12, count_occurrences(json, "\"ph\": \"B\""));
+    ASSERT_EQUAL(12, count_occurrences(json, "\"ph\": \"E\""));
+    ASSERT_NOT_NULL(strstr(json, "\"tid\": 1"));
+
+    free(json);
+    remove(TEST_TRACE_PATH);
+    engine_trace_shutdown();
+}
+
+CTEST(trace, full_ring_keeps_the_newest_events) {
+    ASSERT_TRUE(engine_trace_init());
+    for (int i = 0; i < ENGINE_TRACE_THREAD_EVENTS; i++) {
+        ENGINE_TRACE_BEGIN("old");
+    }
+    for (int i = 0; i < 100; i++) {
+        ENGINE_TRACE_BEGIN("new");
+    }
+
+    ASSERT_TRUE(engine_trace_write_json(TEST_TRACE_PATH));
+    char* json = read_file(TEST_TRACE_PATH);
+    ASSERT_NOT_NULL(json);
+    ASSERT_EQUAL(100, count_occurrences(json, "\"new\""));
+    ASSERT_EQUAL(ENGINE_TRACE_THREAD_EVENTS - 100, count_occurrences(json, "\"old\""));
+
+    free(json);
+    remove(TEST_TRACE_PATH);
+    engine_trace_shutdown();
+}
+
+int main(int argc, const char* argv[]) {
+    return ctest_main(argc, argv);
+}
@@ -9,8 +9,14 @@
 #include "vendor/clay/clay.h"
 
 #include "audio_engine.h"
-#include "raylib.h"
-#include "renderer_utils.h"
+#include "engine_log.h"
+#include "engine_trace.h"
+#include "ui_elements.h"
+
+const char *const ui_font_paths[UI_FONT_COUNT] = {
+    "C:/Users/5q/AppData/Local/Microsoft/Windows/Fonts/"
+    "MesloLGLDZNerdFont-Regular.ttf",
+};
 
 // UI COMPONENTS
 // ============================================================================
@@ -66,27 +72,17 @@ static void build_vertical_fader(float value, uint32_t id, float height) {
   }
 }
 
-void build_meter(float level, uint32_t id, float height, bool is_left) {
-  Clay_Color meter_color = level > 0.9F   ? COLOR_METER_RED
-                           : level > 0.7F ? COLOR_METER_YELLOW
-                                          : COLOR_METER_GREEN;
-  const char *meter_name_id = is_left ? "MeterL" : "MeterR";
-  const char *meter_fill_id = is_left ? "MeterLFill" : "MeterRFill";
-  CLAY({.id = CLAY_IDI("Meter", id),
-        .layout = {.sizing = {CLAY_SIZING_FIXED(15), CLAY_SIZING_FIXED(height)},
-                   .childAlignment = {.y = CLAY_ALIGN_Y_BOTTOM}},
-        .backgroundColor = COLOR_SLIDER_BG}) {
-    float fill_height = level * height;
-    if (fill_height > 1.0F) {
-      CLAY({.id = CLAY_IDI("MeterFill", id),
-            .backgroundColor = meter_color,
-            .layout = {.sizing = {CLAY_SIZING_FIXED(15),
-                                  CLAY_SIZING_FIXED(fill_height)}}}) {}
-    }
-  }
+// Empty meter well. Levels are painted over it every frame by
+// ui_render_meters, so meter movement never invalidates the layout.
+void build_meter(int channel, uint32_t id, float height) {
+  Clay_String name = channel == 0 ? CLAY_STRING("MeterL") : CLAY_STRING("MeterR");
+  CLAY({.id = CLAY_SIDI(name, id),
+        .layout = {.sizing = {CLAY_SIZING_FIXED(15), CLAY_SIZING_FIXED(height)}},
+        .backgroundColor = COLOR_SLIDER_BG}) {}
 }
 
-void build_track_ui(UIState *ui_state, Track *track, int track_index) {
+void build_track_ui(UIState *ui_state, const TrackSnapshot *track,
+                    int track_index) {
   int clicked = 0;
   Clay_String text = {.isStaticallyAllocated = false,
                       .chars = track->name,
@@ -95,7 +91,8 @@ void build_track_ui(UIState *ui_state, Track *track, int track_index) {
       .id = CLAY_IDI("Track", track_index),
       .layout =
           {
-              .sizing = {CLAY_SIZING_FIXED(180), CLAY_SIZING_FIXED(450)},
+              .sizing = {CLAY_SIZING_FIXED(UI_TRACK_STRIP_WIDTH),
+                         CLAY_SIZING_FIXED(450)},
               .layoutDirection = CLAY_TOP_TO_BOTTOM,
               .padding = {10, 10, 10, 10},
               .childGap = 10,
@@ -116,7 +113,7 @@ void build_track_ui(UIState *ui_state, Track *track, int track_index) {
                    .sizing = {CLAY_SIZING_GROW(), CLAY_SIZING_FIXED(25)}},
     }) {
       // Play button
-      bool playing = atomic_load(&track->playing);
+      bool playing = track->playing;
       clicked = 0;
       build_button(playing ? "STOP" : "PLAY", track_index, playing, &clicked,
                    ui_state);
@@ -138,6 +135,40 @@ void build_track_ui(UIState *ui_state, Track *track, int track_index) {
       if (clicked) {
         ui_state->track_solo_toggle = track_index;
       }
+
+      // Input button (monitor the audio input through the track)
+      clicked = 0;
+      build_button("I", track_index, track->input, &clicked, ui_state);
+      if (clicked) {
+        ui_state->track_input_toggle = track_index;
+      }
+
+      // Record-arm button (live MIDI, and audio input into takes)
+      clicked = 0;
+      build_button("R", track_index, track->armed, &clicked, ui_state);
+      if (clicked) {
+        ui_state->track_arm_toggle = track_index;
+      }
+
+      // Freeze button (play the rendered chain instead of running it)
+      clicked = 0;
+      build_button("F", track_index, track->frozen, &clicked, ui_state);
+      if (clicked) {
+        ui_state->track_freeze_toggle = track_index;
+      }
+    }
+
+    // Clip overview (whole clip across the strip). Clips that stream
+    // through a decoder have no peaks and get no overview.
+    const ClipCache *cache = ui_state->track_waveform_elements[track_index]
+                                 .customData.waveform.cache;
+    if (cache && clip_cache_frame_count(cache) > 0) {
+      CustomLayoutElement *overview =
+          &ui_state->track_waveform_elements[track_index];
+      CLAY({.id = CLAY_IDI("Overview", track_index),
+            .layout = {.sizing = {CLAY_SIZING_GROW(), CLAY_SIZING_FIXED(60)}},
+            .backgroundColor = COLOR_SLIDER_BG,
+            .custom = {.customData = overview}}) {}
     }
 
     // Controls row (volume + meters)
@@ -189,14 +220,15 @@ void build_track_ui(UIState *ui_state, Track *track, int track_index) {
                 .layoutDirection = CLAY_LEFT_TO_RIGHT,
                 .childGap = 5,
                 .sizing = {CLAY_SIZING_GROW(), CLAY_SIZING_FIXED(200)}}}) {
-        build_meter(track->peak_level[0], track_index * 10, 200, true);
-        build_meter(track->peak_level[1], track_index * 10, 200, false);
+        build_meter(0, track_index + 1, 200);
+        build_meter(1, track_index + 1, 200);
       }
     }
   }
 }
 
-static void build_master_section(AudioEngine *engine, UIState *ui_state) {
+static void build_master_section(const EngineSnapshot *snapshot,
+                                 UIState *ui_state) {
   int clicked = 0;
 
   CLAY(
@@ -213,7 +245,7 @@ static void build_master_section(AudioEngine *engine, UIState *ui_state) {
               CLAY_TEXT_CONFIG({.textColor = COLOR_TEXT, .fontSize = 24}));
 
     // Master play/stop button
-    bool playing = atomic_load(&engine->playing);
+    bool playing = snapshot->playing;
     clicked = 0;
     build_button(playing ? "STOP ALL" : "PLAY ALL", 0, playing, &clicked,
                  ui_state);
@@ -232,7 +264,7 @@ static void build_master_section(AudioEngine *engine, UIState *ui_state) {
            .layout = {.layoutDirection = CLAY_TOP_TO_BOTTOM,
                       .childGap = 5,
                       .sizing = {CLAY_SIZING_FIXED(40), CLAY_SIZING_GROW()}}}) {
-        build_vertical_fader(engine->master_volume, 9999, 250);
+        build_vertical_fader(snapshot->master_volume, 9999, 250);
         CLAY_TEXT(
             CLAY_STRING("MASTER"),
             CLAY_TEXT_CONFIG({.textColor = COLOR_TEXT_DIM, .fontSize = 12}));
@@ -244,8 +276,8 @@ static void build_master_section(AudioEngine *engine, UIState *ui_state) {
                 .layoutDirection = CLAY_LEFT_TO_RIGHT,
                 .childGap = 10,
                 .sizing = {CLAY_SIZING_GROW(), CLAY_SIZING_FIXED(250)}}}) {
-        build_meter(engine->master_peak[0], 0, 250, true);
-        build_meter(engine->master_peak[1], 0, 250, false);
+        build_meter(0, 0, 250);
+        build_meter(1, 0, 250);
       }
     }
 
@@ -260,10 +292,38 @@ static void build_master_section(AudioEngine *engine, UIState *ui_state) {
       CLAY_TEXT(CLAY_STRING("R"), CLAY_TEXT_CONFIG({.textColor = COLOR_TEXT_DIM,
                                                     .fontSize = 12}));
     }
+
+    // Spectrum analyzer: source picker, then the band display
+    if (ui_state->analyzer_running) {
+      const char *source =
+          ui_state->analyzer_source >= 0 &&
+                  ui_state->analyzer_source < snapshot->track_count
+              ? snapshot->tracks[ui_state->analyzer_source].name
+              : "MASTER";
+      snprintf(ui_state->analyzer_label, sizeof(ui_state->analyzer_label),
+               "FFT: %s", source);
+      clicked = 0;
+      build_button(ui_state->analyzer_label, 0, false, &clicked, ui_state);
+      if (clicked) {
+        ui_state->analyzer_source_next = true;
+      }
+
+      ui_state->analyzer_element = (CustomLayoutElement){
+          .type = CUSTOM_LAYOUT_ELEMENT_TYPE_SPECTRUM,
+          .customData.spectrum = {.bands = ui_state->analyzer_display.bands,
+                                  .band_count = ANALYZER_BANDS,
+                                  .floor_db = ANALYZER_FLOOR_DB,
+                                  .color = COLOR_SLIDER}};
+      CLAY({.id = CLAY_ID("Analyzer"),
+            .layout = {.sizing = {CLAY_SIZING_GROW(),
+                                  CLAY_SIZING_GROW(.min = 60)}},
+            .backgroundColor = COLOR_SLIDER_BG,
+            .custom = {.customData = &ui_state->analyzer_element}}) {}
+    }
   }
 }
 
-static void build_toolbar(AudioEngine *engine, UIState *ui_state) {
+static void build_toolbar(const EngineSnapshot *snapshot, UIState *ui_state) {
   int clicked = 0;
 
   CLAY({.id = CLAY_ID("Toolbar"),
@@ -280,25 +340,337 @@ static void build_toolbar(AudioEngine *engine, UIState *ui_state) {
       ui_state->add_track_requested = true;
 }
 
-    // Status text
-    char *status = malloc(sizeof(char) * 255);
-    int len = sprintf(
-        status, "Tracks: %d/%d | %s | %u Hz", engine->track_count, MAX_TRACKS,
-        atomic_load(&engine->playing) ? "PLAYING" : "STOPPED", SAMPLE_RATE);
+    // Status text (lives in ui_state: cached commands point at it)
+    int len = snprintf(
+        ui_state->status_text, sizeof(ui_state->status_text),
+        "Tracks: %d/%d | %s | %u Hz", snapshot->track_count, MAX_TRACKS,
+        snapshot->playing ? "PLAYING" : "STOPPED", snapshot->sample_rate);
 
-    Clay_String text = {
-        .isStaticallyAllocated = false, .chars = status, .length = len};
+    Clay_String text = {.isStaticallyAllocated = false,
+                        .chars = ui_state->status_text,
+                        .length = len};
     CLAY_TEXT(text,
               CLAY_TEXT_CONFIG({.textColor = COLOR_TEXT, .fontSize = 20}));
+
+    // DSP load: window average and peak, plus xruns since start
+    const DspLoadRecord *load = &ui_state->dsp_load;
+    len = snprintf(ui_state->dsp_load_text, sizeof(ui_state->dsp_load_text),
+                   "DSP %d%% (peak %d%%) | Xruns: %u",
+                   (int)roundf(load->load_avg * 100.0F),
+                   (int)roundf(load->load_max * 100.0F), load->xruns);
+    Clay_String load_text = {.isStaticallyAllocated = false,
+                             .chars = ui_state->dsp_load_text,
+                             .length = len};
+    Clay_Color load_color = load->load_max >= UI_DSP_LOAD_WARNING ||
+                                    load->xruns > 0
+                                ? COLOR_METER_RED
+                                : COLOR_TEXT_DIM;
+    CLAY_TEXT(load_text,
+              CLAY_TEXT_CONFIG({.textColor = load_color, .fontSize = 20}));
+  }
+}
+
+// ============================================================================
+// UI STATE AND INPUT
+// ============================================================================
+
+bool ui_state_init(UIState *ui_state, int window_width, int window_height,
+                   Clay_ErrorHandler error_handler) {
+  memset(ui_state, 0, sizeof(UIState));
+
+  ui_state->clay_memory = malloc(CLAY_MEMORY_SIZE);
+  if (!ui_state->clay_memory) {
+    engine_log(ENGINE_LOG_ERROR, "[UI] Failed to allocate Clay memory");
+    return false;
+  }
+  ui_state->window_width = window_width;
+  ui_state->window_height = window_height;
+  ui_state->track_play_toggle = -1;
+  ui_state->track_mute_toggle = -1;
+  ui_state->track_solo_toggle = -1;
+  ui_state->track_input_toggle = -1;
+  ui_state->track_arm_toggle = -1;
+  ui_state->track_freeze_toggle = -1;
+  ui_state->track_add_effect = -1;
+
+  ui_state->clay_arena = Clay_CreateArenaWithCapacityAndMemory(
+      CLAY_MEMORY_SIZE, ui_state->clay_memory);
+  Clay_Initialize(ui_state->clay_arena,
+                  (Clay_Dimensions){(float)window_width, (float)window_height},
+                  error_handler);
+  engine_log(ENGINE_LOG_INFO, "[UI] Clay initialized with %u bytes",
+             (unsigned)CLAY_MEMORY_SIZE);
+  return true;
+}
+
+void ui_state_shutdown(UIState *ui_state) {
+  if (ui_state->analyzer_running) {
+    analyzer_destroy(&ui_state->analyzer);
+    ui_state->analyzer_running = false;
   }
+  free(ui_state->clay_memory);
+  ui_state->clay_memory = NULL;
+}
+
+void ui_apply_input(UIState *ui_state, const UIInput *input) {
+  bool mouse_moved = input->mouse_pos.x != ui_state->mouse_pos.x ||
+                     input->mouse_pos.y != ui_state->mouse_pos.y;
+  ui_state->mouse_pos = input->mouse_pos;
+  ui_state->mouse_pressed = input->mouse_pressed;
+  ui_state->mouse_down = input->mouse_down;
+  ui_state->mouse_released = input->mouse_released;
+  ui_state->frame_seconds = input->frame_seconds;
+
+  // Hover colours and clicks are resolved while building the layout, so
+  // any pointer activity needs a fresh one
+  bool pointer_activity = mouse_moved || input->mouse_pressed ||
+                          input->mouse_released || input->wheel.x != 0.0F ||
+                          input->wheel.y != 0.0F;
+  if (pointer_activity) {
+    ui_invalidate_layout(ui_state);
+  }
+  ui_state->had_input =
+      pointer_activity || input->key_pressed || input->resized;
+
+  // Reset per-frame action flags
+  ui_state->add_track_requested = false;
+  ui_state->track_play_toggle = -1;
+  ui_state->track_mute_toggle = -1;
+  ui_state->track_solo_toggle = -1;
+  ui_state->track_input_toggle = -1;
+  ui_state->track_arm_toggle = -1;
+  ui_state->track_freeze_toggle = -1;
+  ui_state->master_play_toggle = false;
+  ui_state->track_add_effect = -1;
+  ui_state->analyzer_source_next = false;
+
+  if (input->resized) {
+    ui_state->window_width = input->window_width;
+    ui_state->window_height = input->window_height;
+    ui_invalidate_layout(ui_state);
+  }
+
+  Clay_SetLayoutDimensions((Clay_Dimensions){(float)ui_state->window_width,
+                                             (float)ui_state->window_height});
+  // Update Clay pointer state
+  Clay_SetPointerState(ui_state->mouse_pos, ui_state->mouse_down);
+
+  // Scroll the strip list: either wheel axis scrolls it horizontally
+  Clay_UpdateScrollContainers(false, // isPointerActive
+                              (Clay_Vector2){input->wheel.x + input->wheel.y, 0},
+                              input->frame_seconds);
 }
 
 // ============================================================================
 // UI LAYOUT
 // ============================================================================
 
+// Re-read the DSP load now and then; the toolbar text only changes (and
+// costs a layout) when a shown figure does
+static void update_dsp_load(UIState *ui_state, AudioEngine *engine) {
+  ui_state->dsp_load_timer -= ui_state->frame_seconds;
+  if (ui_state->dsp_load_timer > 0.0F) {
+    return;
+  }
+  ui_state->dsp_load_timer = UI_DSP_LOAD_REFRESH_SECONDS;
+
+  DspLoadRecord record;
+  if (!audio_engine_read_dsp_load(engine, &record)) {
+    return;
+  }
+  const DspLoadRecord *shown = &ui_state->dsp_load;
+  bool changed =
+      roundf(record.load_avg * 100.0F) != roundf(shown->load_avg * 100.0F) ||
+      roundf(record.load_max * 100.0F) != roundf(shown->load_max * 100.0F) ||
+      record.xruns != shown->xruns;
+  ui_state->dsp_load = record;
+  if (changed) {
+    ui_invalidate_layout(ui_state);
+  }
+}
+
+// Read the latest meter records once per frame and advance ballistics
+static void update_meters(UIState *ui_state, AudioEngine *engine) {
+  float dt = ui_state->frame_seconds;
+  for (int i = 0; i < ui_state->snapshot.track_count; i++) {
+    meter_ballistics_poll(&ui_state->track_meters[i],
+                          &track_store_track(&engine->tracks, i)->meter, dt);
+  }
+  meter_ballistics_poll(&ui_state->master_meter, &engine->master_meter, dt);
+  if (ui_state->analyzer_running) {
+    analyzer_display_update(&ui_state->analyzer_display, &ui_state->analyzer,
+                            dt);
+  }
+}
+
+// Where the meter wells ended up, for painting levels over the layout
+static void record_meter_boxes(UIState *ui_state, int first, int count) {
+  for (int i = first; i < first + count; i++) {
+    ui_state->track_meter_boxes[i][0] =
+        Clay_GetElementData(CLAY_IDI("MeterL", i + 1)).boundingBox;
+    ui_state->track_meter_boxes[i][1] =
+        Clay_GetElementData(CLAY_IDI("MeterR", i + 1)).boundingBox;
+  }
+  ui_state->meter_first_track = first;
+  ui_state->meter_track_count = count;
+  ui_state->tracks_viewport =
+      Clay_GetElementData(CLAY_ID("TracksContainer")).boundingBox;
+  ui_state->master_meter_boxes[0] =
+      Clay_GetElementData(CLAY_IDI("MeterL", 0)).boundingBox;
+  ui_state->master_meter_boxes[1] =
+      Clay_GetElementData(CLAY_IDI("MeterR", 0)).boundingBox;
+  ui_state->analyzer_box =
+      Clay_GetElementData(CLAY_ID("Analyzer")).boundingBox;
+}
+
+// Strips [first, first + count) intersecting the strip list viewport, from
+// the scroll position and size of the previous layout (the whole window
+// before the first one)
+static void visible_track_range(UIState *ui_state, int track_count,
+                                int *first, int *count) {
+  Clay_ScrollContainerData scroll =
+      Clay_GetScrollContainerData(CLAY_ID("TracksContainer"));
+  float offset = 0.0F;
+  float width = (float)ui_state->window_width;
+  if (scroll.found) {
+    offset = -scroll.scrollPosition->x;
+    width = scroll.scrollContainerDimensions.width;
+  }
+
+  int start = (int)floorf(offset / UI_TRACK_STRIP_STRIDE) - UI_TRACK_OVERSCAN;
+  int end = (int)ceilf((offset + width) / UI_TRACK_STRIP_STRIDE) +
+            UI_TRACK_OVERSCAN;
+  start = start < 0 ? 0 : start;
+  end = end > track_count ? track_count : end;
+  *first = start;
+  *count = end > start ? end - start : 0;
+}
+
+// Point a track's overview element at its current clip cache; the
+// renderer rebuilds its per-clip resources when the cache changes
+static void sync_track_waveform(UIState *ui_state, int track_index) {
+  const ClipCache *cache = ui_state->snapshot.tracks[track_index].clip_cache;
+  ui_state->track_waveform_elements[track_index] = (CustomLayoutElement){
+      .type = CUSTOM_LAYOUT_ELEMENT_TYPE_WAVEFORM,
+      .customData.waveform = {.cache = cache,
+                              .slot = track_index,
+                              .start_frame = 0,
+                              .frame_span =
+                                  cache ? clip_cache_frame_count(cache) : 0,
+                              .color = COLOR_SLIDER}};
+}
+
+// Fixed-width stand-in for `strips` strips that are not built. The
+// container's child gap follows it, so the spacer itself is one gap short.
+static void build_strip_spacer(const char *name, int strips) {
+  if (strips <= 0) {
+    return;
+  }
+  Clay_String id = {.chars = name, .length = (int32_t)strlen(name)};
+  CLAY({.id = CLAY_SID(id),
+        .layout = {.sizing = {CLAY_SIZING_FIXED(
+                                  (float)(strips * UI_TRACK_STRIP_STRIDE -
+                                          UI_TRACK_STRIP_GAP)),
+                              CLAY_SIZING_FIXED(1)}}}) {}
+}
+
+int ui_meter_boxes(const Clay_BoundingBox *box, const MeterBallistics *meter,
+                   int channel, Clay_BoundingBox out[2], Clay_Color colors[2]) {
+  int count = 0;
+  float level = fminf(meter->peak[channel], 1.0F);
+  float hold = fminf(meter->hold[channel], 1.0F);
+  float x = roundf(box->x);
+  float bottom = roundf(box->y + box->height);
+  float width = roundf(box->width);
+
+  float fill_height = roundf(level * box->height);
+  if (fill_height > 1.0F) {
+    out[count] = (Clay_BoundingBox){x, bottom - fill_height, width, fill_height};
+    colors[count++] = meter_ballistics_clipping(meter) ? COLOR_METER_RED
+                      : level > 0.7F ? COLOR_METER_YELLOW
+                                     : COLOR_METER_GREEN;
+  }
+  float hold_height = roundf(hold * box->height);
+  if (hold_height > fill_height + 3.0F) {
+    out[count] = (Clay_BoundingBox){x, bottom - hold_height, width, 2.0F};
+    colors[count++] = COLOR_TEXT_DIM;
+  }
+  return count;
+}
+
+bool ui_spectrum_bar(const CustomLayoutElement_Spectrum *spectrum,
+                     const Clay_BoundingBox *box, int band,
+                     Clay_BoundingBox *out) {
+  float bar_width = box->width / (float)spectrum->band_count;
+  float level = 1.0F - spectrum->bands[band] / spectrum->floor_db;
+  float height = roundf(fminf(fmaxf(level, 0.0F), 1.0F) * box->height);
+  if (height < 1.0F) {
+    return false;
+  }
+  *out = (Clay_BoundingBox){roundf(box->x + (float)band * bar_width),
+                            box->y + box->height - height,
+                            fmaxf(floorf(bar_width) - 1.0F, 1.0F), height};
+  return true;
+}
+
+bool ui_meters_at_rest(const UIState *ui_state) {
+  int end = ui_state->meter_first_track + ui_state->meter_track_count;
+  for (int i = ui_state->meter_first_track; i < end; i++) {
+    if (!meter_ballistics_at_rest(&ui_state->track_meters[i])) {
+      return false;
+    }
+  }
+  if (ui_state->analyzer_running &&
+      !analyzer_display_at_rest(&ui_state->analyzer_display)) {
+    return false;
+  }
+  return meter_ballistics_at_rest(&ui_state->master_meter);
+}
+
+bool ui_start_analyzer(UIState *ui_state, ControlThread *control) {
+  if (!analyzer_init(&ui_state->analyzer,
+                     audio_engine_get_analyzer_tap(control->engine),
+                     control->engine->sample_rate) ||
+      !analyzer_start(&ui_state->analyzer)) {
+    analyzer_destroy(&ui_state->analyzer);
+    engine_log(ENGINE_LOG_WARNING, "[UI] Spectrum analyzer unavailable");
+    return false;
+  }
+  analyzer_display_init(&ui_state->analyzer_display);
+  ui_state->analyzer_source = ANALYZER_SOURCE_MASTER;
+  ControlRequest request = {.type = CONTROL_SET_ANALYZER_SOURCE,
+                            .track_index = ui_state->analyzer_source};
+  control_thread_request(control, &request);
+  ui_state->analyzer_running = true;
+  ui_invalidate_layout(ui_state);
+  return true;
+}
+
 Clay_RenderCommandArray ui_build_layout(UIState *ui_state,
-                                        AudioEngine *engine) {
+                                        ControlThread *control) {
+  ENGINE_TRACE_BEGIN("ui_build_layout");
+  // Adopt the newest snapshot the control thread published; everything
+  // below reads it, never the Tracks the audio thread writes
+  const EngineSnapshot *snapshot = &ui_state->snapshot;
+  if (control_thread_poll_snapshot(control, &ui_state->snapshot) ||
+      ui_state->layout_builds == 0) {
+    ui_invalidate_layout(ui_state);
+  }
+  update_meters(ui_state, control->engine);
+  update_dsp_load(ui_state, control->engine);
+
+  // Nothing the layout depends on changed: replay the last one
+  if (!ui_state->layout_dirty) {
+    ENGINE_TRACE_END("ui_build_layout");
+    return ui_state->cached_commands;
+  }
+  ui_state->layout_dirty = false;
+
+  int first_track = 0;
+  int visible_tracks = 0;
+  visible_track_range(ui_state, snapshot->track_count, &first_track,
+                      &visible_tracks);
+
   Clay_BeginLayout();
 
   CLAY({
@@ -331,83 +703,106 @@ Clay_RenderCommandArray ui_build_layout(UIState *ui_state,
                      .sizing = {CLAY_SIZING_GROW(), CLAY_SIZING_GROW()},
                      .padding = {10, 10, 10, 10},
                      .childGap = 10}}) {
-      // Tracks container (scrollable)
+      // Tracks container (scrolls horizontally; only visible strips are
+      // built, spacers keep the content width of the full list)
       CLAY({.id = CLAY_ID("TracksContainer"),
             .layout = {.layoutDirection = CLAY_LEFT_TO_RIGHT,
                        .sizing = {CLAY_SIZING_GROW(), CLAY_SIZING_GROW()},
-                       .childGap = 10}}) {
-        // Draw all tracks
-        for (int i = 0; i < engine->track_count; i++) {
-          build_track_ui(ui_state, &engine->tracks[i], i);
+                       .childGap = UI_TRACK_STRIP_GAP},
+            .clip = {.horizontal = true,
+                     .childOffset = Clay_GetScrollOffset()}}) {
+        build_strip_spacer("StripsBefore", first_track);
+        for (int i = first_track; i < first_track + visible_tracks; i++) {
+          sync_track_waveform(ui_state, i);
+          build_track_ui(ui_state, &snapshot->tracks[i], i);
         }
+        build_strip_spacer("StripsAfter", snapshot->track_count - first_track -
+                                              visible_tracks);
       }
 
       // Master section (fixed on right)
-      build_master_section(engine, ui_state);
+      build_master_section(snapshot, ui_state);
     }
 
     // Toolbar at bottom
-    build_toolbar(engine, ui_state);
+    build_toolbar(snapshot, ui_state);
   }
 
-  return Clay_EndLayout();
+  ENGINE_TRACE_BEGIN("Clay_EndLayout");
+  ui_state->cached_commands = Clay_EndLayout();
+  ENGINE_TRACE_END("Clay_EndLayout");
+  ui_state->static_layer_stale = true;
+  ui_state->layout_builds++;
+  record_meter_boxes(ui_state, first_track, visible_tracks);
+  ENGINE_TRACE_END("ui_build_layout");
+  return ui_state->cached_commands;
 }
 
 // ============================================================================
 // UI INTERACTION HANDLING
 // ============================================================================
 
-void ui_handle_interactions(UIState *ui_state, AudioEngine *engine) {
-  // Handle track play toggle
-  if (ui_state->track_play_toggle >= 0 &&
-      ui_state->track_play_toggle < engine->track_count) {
-    Track *track = &engine->tracks[ui_state->track_play_toggle];
-    bool playing = atomic_load(&track->playing);
-    atomic_store(&track->playing, !playing);
-    TraceLog(LOG_INFO, "[raylib][UI] Track %d play toggled: %s",
-             ui_state->track_play_toggle, !playing ? "ON" : "OFF");
+// Queue a request without blocking the frame (a full queue drops it and
+// logs a warning)
+static void queue_request(ControlThread *control, ControlRequestType type,
+                          int track_index) {
+  ControlRequest request = {.type = type, .track_index = track_index};
+  control_thread_request(control, &request);
+}
+
+void ui_handle_interactions(UIState *ui_state, ControlThread *control) {
+  // Engine edits are queued for the control thread, which applies them
+  // within a millisecond and publishes the result as a new snapshot
+  const EngineSnapshot *snapshot = &ui_state->snapshot;
+
+  if (ui_state->track_play_toggle >= 0) {
+    queue_request(control, CONTROL_TOGGLE_TRACK_PLAYING,
+                  ui_state->track_play_toggle);
+  }
+  if (ui_state->track_mute_toggle >= 0) {
+    queue_request(control, CONTROL_TOGGLE_TRACK_MUTE,
+                  ui_state->track_mute_toggle);
+  }
+  if (ui_state->track_solo_toggle >= 0) {
+    queue_request(control, CONTROL_TOGGLE_TRACK_SOLO,
+                  ui_state->track_solo_toggle);
+  }
+  if (ui_state->track_input_toggle >= 0) {
+    queue_request(control, CONTROL_TOGGLE_TRACK_INPUT,
+                  ui_state->track_input_toggle);
+  }
+  if (ui_state->track_arm_toggle >= 0) {
+    queue_request(control, CONTROL_TOGGLE_TRACK_ARMED,
+                  ui_state->track_arm_toggle);
+  }
+  if (ui_state->track_freeze_toggle >= 0) {
+    queue_request(control, CONTROL_TOGGLE_TRACK_FREEZE,
+                  ui_state->track_freeze_toggle);
+  }
+  if (ui_state->master_play_toggle) {
+    queue_request(control, CONTROL_TOGGLE_PLAYING, -1);
   }
 
-  // Handle track mute toggle
-  if (ui_state->track_mute_toggle >= 0 &&
-      ui_state->track_mute_toggle < engine->track_count) {
-    Track *track = &engine->tracks[ui_state->track_mute_toggle];
-    track->mute = !track->mute;
-    TraceLog(LOG_INFO, "[raylib][UI] Track %d mute: %s",
-             ui_state->track_mute_toggle, track->mute ? "ON" : "OFF");
+  // Cycle the analyzer tap: master, then each track in turn
+  if (ui_state->analyzer_source_next && ui_state->analyzer_running) {
+    int next = ui_state->analyzer_source + 1;
+    if (next >= snapshot->track_count) {
+      next = ANALYZER_SOURCE_MASTER;
+    }
+    queue_request(control, CONTROL_SET_ANALYZER_SOURCE, next);
+    ui_state->analyzer_source = next;
+    ui_invalidate_layout(ui_state);
   }
 
-  // Handle track solo toggle
-  if (ui_state->track_solo_toggle >= 0 &&
-      ui_state->track_solo_toggle < engine->track_count) {
-    Track *track = &engine->tracks[ui_state->track_solo_toggle];
-    track->solo = !track->solo;
-    TraceLog(LOG_INFO, "[raylib][UI] Track %d solo: %s",
-             ui_state->track_solo_toggle, track->solo ? "ON" : "OFF");
+  // Named "Track N" by the control thread, which knows the real count
+  if (ui_state->add_track_requested) {
+    queue_request(control, CONTROL_ADD_TRACK, -1);
   }
 
-  // Handle master play toggle
-  if (ui_state->master_play_toggle) {
-    bool playing = atomic_load(&engine->playing);
-    atomic_store(&engine->playing, !playing);
-    TraceLog(LOG_INFO, "[raylib][UI] Master play toggled: %s",
-             !playing ? "ON" : "OFF");
-  }
-
-  // Handle add track request
-  if (ui_state->add_track_requested && engine->track_count < MAX_TRACKS) {
-    char name[32];
-    float freq = 220.0F * powf(2.0F, (float)engine->track_count / 12.0F);
-    snprintf(name, sizeof(name), "Track %d", engine->track_count + 1);
-    audio_engine_add_track(engine, name, freq);
-  }
-
-  // Handle add effect request
-  if (ui_state->track_add_effect >= 0 &&
-      ui_state->track_add_effect < engine->track_count) {
-    Track *track = &engine->tracks[ui_state->track_add_effect];
-    audio_engine_add_effect(track, ui_state->effect_to_add);
-    TraceLog(LOG_INFO, "[raylib][UI] Added effect to track %d",
-             ui_state->track_add_effect);
+  if (ui_state->track_add_effect >= 0) {
+    ControlRequest request = {.type = CONTROL_ADD_EFFECT,
+                              .track_index = ui_state->track_add_effect,
+                              .effect = ui_state->effect_to_add};
+    control_thread_request(control, &request);
   }
 }
@@ -1,12 +1,15 @@
 // ui_clay.h - Clay UI Components for AirDAW
-// Declarative UI layout with Clay, rendered with Raylib
+// Declarative UI layout with Clay, shared by the raylib and Sokol frontends
 #pragma once
 #ifndef UI_CLAY_H
 #define UI_CLAY_H
 
 #include "vendor/clay/clay.h"
+#include "analyzer.h"
 #include "audio_engine.h"
-#include <raylib.h>
+#include "control_thread.h"
+#include "meters.h"
+#include "ui_elements.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -14,48 +17,165 @@
 // UI STATE
 // ============================================================================
 
+// The mixer is a horizontally scrolling list of fixed-width strips. Only
+// strips that intersect the viewport (plus UI_TRACK_OVERSCAN either side)
+// get Clay elements; spacers stand in for the rest.
+#define UI_TRACK_STRIP_WIDTH 180
+#define UI_TRACK_STRIP_GAP 10
+#define UI_TRACK_STRIP_STRIDE (UI_TRACK_STRIP_WIDTH + UI_TRACK_STRIP_GAP)
+#define UI_TRACK_OVERSCAN 1
+
+// The toolbar's DSP load readout is part of the retained layout, so it is
+// re-read at this rate and only rebuilds the layout when the text changes
+#define UI_DSP_LOAD_REFRESH_SECONDS 0.5F
+#define UI_DSP_LOAD_WARNING 0.8F    // Window peak load drawn in red from here
+
+// Fonts both renderers load, indexed by Clay fontId. One that fails to load
+// is replaced by the backend's default font (raylib) or draws no text
+// (sokol).
+#define UI_FONT_COUNT 1
+extern const char* const ui_font_paths[UI_FONT_COUNT];
+
+typedef struct UIRenderer UIRenderer;
+
 typedef struct {
     // Clay memory arena
     Clay_Arena clay_arena;
     void* clay_memory;
 
-    // Font
-    Font* font;
-    uint32_t font_count;
+    // Frontend drawing state (fonts, batches, textures, the static layer):
+    // defined by whichever renderer is linked (renderer.h, renderer_sokol.h)
+    UIRenderer* renderer;
+
+    // Clip overviews, one per track, drawn by the waveform custom element
+    CustomLayoutElement track_waveform_elements[MAX_TRACKS];
+
+    // Spectrum analyzer panel. A worker drains the engine's tap; the
+    // bands are painted over the static layer each frame, like the meters.
+    Analyzer analyzer;
+    bool analyzer_running;
+    int analyzer_source;                    // ANALYZER_SOURCE_MASTER or a track index
+    AnalyzerDisplay analyzer_display;
+    CustomLayoutElement analyzer_element;
+    Clay_BoundingBox analyzer_box;          // Filled at layout time
+    char analyzer_label[48];                // Referenced by the cached commands
 
     // Window dimensions
     int window_width;
     int window_height;
+    float frame_seconds;        // Duration of the last frame (ballistics, scrolling)
 
    // Interaction state
     uint32_t active_slider_id;
     float slider_drag_start_value;
-    Vector2 slider_drag_start_pos;
+    Clay_Vector2 slider_drag_start_pos;
 
     // Mouse state
-    Vector2 mouse_pos;
+    Clay_Vector2 mouse_pos;
     bool mouse_pressed;
     bool mouse_down;
     bool mouse_released;
+    bool had_input;             // Pointer, key or window activity this frame
 
     // UI actions (set by UI, read by main)
     bool add_track_requested;
     int track_play_toggle;      // -1 = none, >= 0 = track index
     int track_mute_toggle;      // -1 = none, >= 0 = track index
     int track_solo_toggle;      // -1 = none, >= 0 = track index
+    int track_input_toggle;     // -1 = none, >= 0 = track index
+    int track_arm_toggle;       // -1 = none, >= 0 = track index
+    int track_freeze_toggle;    // -1 = none, >= 0 = track index
     bool master_play_toggle;
 
+    bool analyzer_source_next;  // Cycle the analyzer through master and tracks
+
     // Effect actions
     int track_add_effect;       // -1 = none, >= 0 = track index
     EffectType effect_to_add;
+
+    // Meter display state (ballistics applied on the UI side)
+    MeterBallistics track_meters[MAX_TRACKS];
+    MeterBallistics master_meter;
+
+    // Engine DSP load as last shown in the toolbar
+    DspLoadRecord dsp_load;
+    float dsp_load_timer;       // Seconds until the next read
+
+    // What the layout displays: the newest snapshot the control thread
+    // published. Layout and interaction code read only this.
+    EngineSnapshot snapshot;
+
+    // Retained layout. The Clay layout is only rebuilt when input arrives,
+    // the window resizes or the engine model version moves; otherwise the
+    // cached commands stand and only the meters are repainted on top of a
+    // texture holding the last full render.
+    bool layout_dirty;                      // Set by ui_update on input/resize
+    Clay_RenderCommandArray cached_commands;
+    bool static_layer_stale;                // Commands changed since the renderer's static layer was drawn
+    Clay_BoundingBox track_meter_boxes[MAX_TRACKS][2];  // Meter wells, filled at render time
+    Clay_BoundingBox master_meter_boxes[2];
+    int meter_first_track;                  // Strips laid out in track_meter_boxes:
+    int meter_track_count;                  // [first, first + count)
+    Clay_BoundingBox tracks_viewport;       // Visible part of the strip list (meter scissor)
+    uint32_t layout_builds;                 // Full rebuilds so far (diagnostics)
+    char status_text[128];                  // Referenced by the cached commands
+    char dsp_load_text[64];                 // Likewise
 } UIState;
 
+// One frame of platform input, filled by the frontend from its own events
+typedef struct {
+    Clay_Vector2 mouse_pos;
+    bool mouse_pressed;         // Left button went down this frame
+    bool mouse_down;
+    bool mouse_released;
+    Clay_Vector2 wheel;
+    bool key_pressed;           // Any key this frame
+    bool resized;
+    int window_width;           // Current size (read when resized)
+    int window_height;
+    float frame_seconds;
+} UIInput;
+
+// The last layout no longer matches the session (control thread)
+static inline void ui_invalidate_layout(UIState* ui_state) {
+    ui_state->layout_dirty = true;
+}
+
+// Reset the state, allocate Clay's arena and initialize Clay. Frontends
+// call this from their ui_init, then install a text measurement function.
+bool ui_state_init(UIState* ui_state, int window_width, int window_height,
+                   Clay_ErrorHandler error_handler);
+
+// Stop the analyzer and free Clay's arena (from the frontend's ui_shutdown)
+void ui_state_shutdown(UIState* ui_state);
+
+// Apply one frame of input: pointer, scrolling, resizes and the per-frame
+// action flags (call once per frame before ui_build_layout)
+void ui_apply_input(UIState* ui_state, const UIInput* input);
+
+// Build the UI layout (call in main loop) from the newest snapshot the
+// control thread published. Returns the cached commands without running
+// Clay when nothing but the meters changed.
+Clay_RenderCommandArray ui_build_layout(UIState* ui_state, ControlThread* control);
+
+// Turn this frame's UI actions into control thread requests
+void ui_handle_interactions(UIState* ui_state, ControlThread* control);
+
+// Every meter on screen has decayed to rest (nothing to animate)
+bool ui_meters_at_rest(const UIState* ui_state);
+
+// Level and hold marker of one meter channel over its well, as at most two
+// boxes (shared by the renderers)
+int ui_meter_boxes(const Clay_BoundingBox* box, const MeterBallistics* meter,
+                   int channel, Clay_BoundingBox out[2], Clay_Color colors[2]);
 
-// Build the UI layout (call in main loop)
-Clay_RenderCommandArray ui_build_layout(UIState* ui_state, AudioEngine* engine);
+// Bar of one analyzer band across `box`. False if it rounds to nothing.
+bool ui_spectrum_bar(const CustomLayoutElement_Spectrum* spectrum,
+                     const Clay_BoundingBox* box, int band, Clay_BoundingBox* out);
 
-// Handle UI interactions and update audio engine
-void ui_handle_interactions(UIState* ui_state, AudioEngine* engine);
+// Start the analyzer worker on the engine's tap, tapping master (call once
+// after ui_init). The panel stays hidden if this fails.
+bool ui_start_analyzer(UIState* ui_state, ControlThread* control);
 
 
 #endif // UI_CLAY_H
@@ -0,0 +1,70 @@
+// ui_elements.h - Backend-neutral UI vocabulary shared by every frontend
+// The palette and the custom element payloads the Clay layout (ui_clay.c)
+// emits. Each renderer (renderer.c for raylib, renderer_sokol.c for Sokol)
+// decides how to draw them; nothing here depends on a graphics library.
+#pragma once
+#ifndef UI_ELEMENTS_H
+#define UI_ELEMENTS_H
+
+#include "clip_cache.h"
+#include "vendor/clay/clay.h"
+#include <stdint.h>
+
+#define CLAY_MEMORY_SIZE Clay_MinMemorySize()
+
+// UI Colors
+#define COLOR_BACKGROUND (Clay_Color){25, 25, 30, 255}
+#define COLOR_PANEL (Clay_Color){35, 35, 40, 255}
+#define COLOR_TRACK_BG (Clay_Color){45, 45, 50, 255}
+#define COLOR_TRACK_BORDER (Clay_Color){60, 60, 65, 255}
+#define COLOR_BUTTON (Clay_Color){70, 70, 75, 255}
+#define COLOR_BUTTON_HOVER (Clay_Color){90, 90, 95, 255}
+#define COLOR_BUTTON_ACTIVE (Clay_Color){50, 150, 200, 255}
+#define COLOR_SLIDER (Clay_Color){50, 150, 200, 255}
+#define COLOR_SLIDER_BG (Clay_Color){30, 30, 35, 255}
+#define COLOR_TEXT (Clay_Color){220, 220, 225, 255}
+#define COLOR_TEXT_DIM (Clay_Color){140, 140, 145, 255}
+#define COLOR_METER_GREEN (Clay_Color){50, 200, 50, 255}
+#define COLOR_METER_YELLOW (Clay_Color){220, 200, 50, 255}
+#define COLOR_METER_RED (Clay_Color){220, 50, 50, 255}
+
+typedef enum {
+  CUSTOM_LAYOUT_ELEMENT_TYPE_3D_MODEL,
+  CUSTOM_LAYOUT_ELEMENT_TYPE_WAVEFORM,
+  CUSTOM_LAYOUT_ELEMENT_TYPE_SPECTRUM
+} CustomLayoutElementType;
+
+// raylib only (renderer_utils.h)
+struct CustomLayoutElement_3DModel;
+
+// Frames [start_frame, start_frame + frame_span) of a clip drawn across the
+// element's box; the zoom (frames per pixel) follows from the box width.
+// `slot` names the renderer's per-clip resources (a track index), rebuilt
+// whenever the cache behind it changes.
+typedef struct {
+  const ClipCache *cache;
+  int slot;
+  uint64_t start_frame;
+  uint64_t frame_span;
+  Clay_Color color;
+} CustomLayoutElement_Waveform;
+
+// Analyzer bands (dB) as bars across the box, floor_db at the bottom. They
+// move every frame, so the renderer paints them outside the static layer.
+typedef struct {
+  const float *bands;
+  int band_count;
+  float floor_db;
+  Clay_Color color;
+} CustomLayoutElement_Spectrum;
+
+typedef struct {
+  CustomLayoutElementType type;
+  union {
+    struct CustomLayoutElement_3DModel *model;
+    CustomLayoutElement_Waveform waveform;
+    CustomLayoutElement_Spectrum spectrum;
+  } customData;
+} CustomLayoutElement;
+
+#endif // UI_ELEMENTS_H
@@ -0,0 +1,129 @@
+#include "voice_pool.h"
+#include <math.h>
+#include <string.h>
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+// Level change per sample for an envelope segment of ms (full scale)
+static float envelope_rate(float ms, float sample_rate) {
+    float frames = ms * 0.001f * sample_rate;
+    return frames < 1.0f ? 0.0f : 1.0f / frames;
+}
+
+// Ramp a voice's gain to target at rate per sample (0 = step)
+static void ramp_voice(VoicePool* pool, int voice, float target, float rate) {
+    float distance = fabsf(target - pool->bank.gain[voice]);
+    uint32_t frames = rate > 0.0f ? (uint32_t)ceilf(distance / rate) : 0;
+    oscillator_bank_set_gain_ramp(&pool->bank, voice, target, frames);
+}
+
+// A voice to reuse when every voice is sounding: the quietest releasing
+// voice, else the oldest. Only this pool's sounding voices are looked at.
+static int pick_stolen_voice(const VoicePool* pool) {
+    int quietest = -1;
+    int oldest = 0;
+    for (int v = 0; v < pool->bank.voice_count; v++) {
+        if (pool->stage[v] == VOICE_RELEASE &&
+            (quietest < 0 || pool->bank.gain[v] < pool->bank.gain[quietest])) {
+            quietest = v;
+        }
+        if (pool->started[v] - pool->started[oldest] > UINT32_MAX / 2) {   // Older, modulo wrap
+            oldest = v;
+        }
+    }
+    return quietest >= 0 ? quietest : oldest;
+}
+
+// Drop a voice, keeping the dense range and the note table consistent
+static void remove_voice(VoicePool* pool, int voice) {
+    pool->note_voice[pool->note[voice]] = -1;
+    int moved = oscillator_bank_remove_voice(&pool->bank, voice);
+    if (moved < 0) {
+        return;
+    }
+    pool->note[voice] = pool->note[moved];
+    pool->stage[voice] = pool->stage[moved];
+    pool->velocity[voice] = pool->velocity[moved];
+    pool->started[voice] = pool->started[moved];
+    pool->note_voice[pool->note[voice]] = (int8_t)voice;
+}
+
+// ============================================================================
+// VOICE POOL
+// ============================================================================
+
+void voice_pool_init(VoicePool* pool, OscWaveform waveform, float sample_rate) {
+    memset(pool, 0, sizeof(VoicePool));
+    oscillator_bank_init(&pool->bank, sample_rate);
+    memset(pool->note_voice, -1, sizeof(pool->note_voice));
+    pool->waveform = waveform;
+    pool->sample_rate = sample_rate;
+    voice_pool_set_envelope(pool, VOICE_DEFAULT_ATTACK_MS, VOICE_DEFAULT_RELEASE_MS);
+}
+
+void voice_pool_set_envelope(VoicePool* pool, float attack_ms, float release_ms) {
+    pool->attack_rate = envelope_rate(attack_ms, pool->sample_rate);
+    pool->release_rate = envelope_rate(release_ms, pool->sample_rate);
+}
+
+void voice_pool_note_on(VoicePool* pool, int note, float velocity) {
+    if (note < 0 || note >= VOICE_NOTE_COUNT) return;
+    if (velocity <= 0.0f) {
+        voice_pool_note_off(pool, note);
+        return;
+    }
+    if (velocity > 1.0f) velocity = 1.0f;
+
+    // Same note: retrigger its voice from the current level (no click).
+    // Otherwise the next free voice, or a stolen one when the pool is full;
+    // a stolen voice keeps its phase and level and ramps into the new note.
+    int voice = pool->note_voice[note];
+    if (voice < 0) {
+        if (pool->bank.voice_count < VOICE_POOL_MAX_VOICES) {
+            voice = oscillator_bank_add_voice(&pool->bank, pool->waveform, voice_note_frequency(note), 0.0f);
+        } else {
+            voice = pick_stolen_voice(pool);
+            pool->note_voice[pool->note[voice]] = -1;
+            oscillator_bank_set_frequency(&pool->bank, voice, voice_note_frequency(note));
+            pool->steals++;
+        }
+        pool->note[voice] = (uint8_t)note;
+        pool->note_voice[note] = (int8_t)voice;
+    }
+    pool->stage[voice] = VOICE_HELD;
+    pool->velocity[voice] = velocity;
+    pool->started[voice] = pool->note_ons++;
+    ramp_voice(pool, voice, velocity, pool->attack_rate);
+}
+
+void voice_pool_note_off(VoicePool* pool, int note) {
+    if (note < 0 || note >= VOICE_NOTE_COUNT) return;
+    int voice = pool->note_voice[note];
+    if (voice >= 0 && pool->stage[voice] != VOICE_RELEASE) {
+        pool->stage[voice] = VOICE_RELEASE;
+        ramp_voice(pool, voice, 0.0f, pool->release_rate);
+    }
+}
+
+void voice_pool_release_all(VoicePool* pool) {
+    for (int v = 0; v < pool->bank.voice_count; v++) {
+        voice_pool_note_off(pool, pool->note[v]);
+    }
+}
+
+void voice_pool_render(VoicePool* pool, float* out, uint32_t frame_count) {
+    oscillator_bank_render(&pool->bank, out, frame_count);
+
+    // Downwards, so the voice swapped into a freed index was already checked
+    for (int v = pool->bank.voice_count - 1; v >= 0; v--) {
+        if (pool->stage[v] == VOICE_RELEASE && pool->bank.gain_ramp_frames[v] == 0) {
+            remove_voice(pool, v);
+        }
+    }
+}
+
+float voice_note_frequency(int note) {
+    return 440.0f * powf(2.0f, (float)(note - 69) / 12.0f);
+}
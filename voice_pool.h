@@ -0,0 +1,79 @@
+// voice_pool.h - Preallocated polyphonic voices for instrument tracks
+// Every instrument track owns a fixed pool of VOICE_POOL_MAX_VOICES voices,
+// embedded in the Track, so playing notes never allocates. Sounding voices
+// are kept dense at the front of an OscillatorBank (SoA), so a block renders
+// exactly the active voices in one pass and finished voices are dropped by
+// swapping the last one into their place.
+//
+// A note-to-voice table makes note-on/off O(1): a free voice is the one past
+// the end of the dense range, a repeated note retriggers its own voice, and
+// only a full pool looks for a voice to steal (the quietest releasing voice,
+// else the oldest), scanning this track's sounding voices and nothing else.
+//
+// Audio thread only once the track is published; the engine feeds it
+// CMD_NOTE_ON/CMD_NOTE_OFF commands.
+#pragma once
+#ifndef VOICE_POOL_H
+#define VOICE_POOL_H
+
+#include "oscillator.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define VOICE_POOL_MAX_VOICES OSC_BANK_MAX_VOICES
+#define VOICE_NOTE_COUNT 128                // MIDI note numbers
+#define VOICE_DEFAULT_ATTACK_MS 5.0f
+#define VOICE_DEFAULT_RELEASE_MS 120.0f
+
+typedef enum {
+    VOICE_HELD = 0,         // Attack ramp to the note's velocity, then sustain
+    VOICE_RELEASE           // Ramping to silence, then dropped
+} VoiceStage;
+
+// Voice state by dense index, parallel to the bank's voices. The envelope
+// is the bank's per-voice gain ramp, so its level is bank.gain.
+typedef struct {
+    OscillatorBank bank;                        // Voices [0, bank.voice_count) are sounding
+    uint8_t note[VOICE_POOL_MAX_VOICES];
+    uint8_t stage[VOICE_POOL_MAX_VOICES];       // VoiceStage
+    float velocity[VOICE_POOL_MAX_VOICES];      // Sustain level (0..1)
+    uint32_t started[VOICE_POOL_MAX_VOICES];    // Note-on order, for stealing the oldest
+    int8_t note_voice[VOICE_NOTE_COUNT];        // Dense index holding a note, -1 if none
+
+    OscWaveform waveform;
+    float sample_rate;
+    float attack_rate;                          // Level change per sample
+    float release_rate;
+    uint32_t note_ons;
+    uint32_t steals;                            // Note-ons that took a sounding voice
+} VoicePool;
+
+// Empty pool with the default envelope
+void voice_pool_init(VoicePool* pool, OscWaveform waveform, float sample_rate);
+
+// Linear attack and release times (0 ms is a step)
+void voice_pool_set_envelope(VoicePool* pool, float attack_ms, float release_ms);
+
+// Start (or retrigger) a note; velocity 0..1, where 0 releases it like a
+// MIDI note-on with velocity 0. Out-of-range notes are ignored.
+void voice_pool_note_on(VoicePool* pool, int note, float velocity);
+
+// Release a note; its voice fades out over the release time
+void voice_pool_note_off(VoicePool* pool, int note);
+
+// Release every sounding voice
+void voice_pool_release_all(VoicePool* pool);
+
+// Render the sum of all sounding voices into out (overwrites frame_count
+// samples). Envelopes are sample-accurate linear ramps; voices whose
+// release reached silence are dropped afterwards.
+void voice_pool_render(VoicePool* pool, float* out, uint32_t frame_count);
+
+static inline int voice_pool_active_count(const VoicePool* pool) {
+    return pool->bank.voice_count;
+}
+
+// Equal-tempered frequency of a MIDI note (A4 = note 69 = 440 Hz)
+float voice_note_frequency(int note);
+
+#endif // VOICE_POOL_H
@@ -0,0 +1,276 @@
+#include "waveform.h"
+#include "rlgl.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// SHADER
+// ============================================================================
+
+// Runs on raylib's default vertex shader (fragTexCoord spans the quad 0..1).
+// Each pixel column maps to a bucket range of the chosen level, reduces the
+// min/max of those buckets and keeps the pixels between them.
+#if defined(GRAPHICS_API_OPENGL_ES2) || defined(GRAPHICS_API_OPENGL_ES3)
+#define WAVEFORM_GLSL_HEADER "#version 100\nprecision highp float;\n"
+#define WAVEFORM_GLSL_IN_FS "varying"
+#define WAVEFORM_GLSL_FRAG_OUT ""
+#define WAVEFORM_GLSL_FRAG_COLOR "gl_FragColor"
+#define WAVEFORM_GLSL_TEXTURE "texture2D"
+#else
+#define WAVEFORM_GLSL_HEADER "#version 330\n"
+#define WAVEFORM_GLSL_IN_FS "in"
+#define WAVEFORM_GLSL_FRAG_OUT "out vec4 finalColor;\n"
+#define WAVEFORM_GLSL_FRAG_COLOR "finalColor"
+#define WAVEFORM_GLSL_TEXTURE "texture"
+#endif
+
+#define WAVEFORM_STRINGIFY_(x) #x
+#define WAVEFORM_STRINGIFY(x) WAVEFORM_STRINGIFY_(x)
+
+static const char *waveform_fs =
+    WAVEFORM_GLSL_HEADER
+    WAVEFORM_GLSL_IN_FS " vec2 fragTexCoord;\n"
+    WAVEFORM_GLSL_IN_FS " vec4 fragColor;\n"
+    "uniform sampler2D texture0;\n"
+    "uniform vec2 size;\n"
+    "uniform vec2 textureSize;\n"
+    "uniform vec2 level;\n"
+    "uniform vec2 range;\n"
+    "uniform float channels;\n"
+    WAVEFORM_GLSL_FRAG_OUT
+    "vec4 bucket(float index) {\n"
+    "  float texel = level.x + index;\n"
+    "  float row = floor(texel / textureSize.x);\n"
+    "  vec2 uv = (vec2(texel - row * textureSize.x, row) + 0.5) / textureSize;\n"
+    "  return " WAVEFORM_GLSL_TEXTURE "(texture0, uv);\n"
+    "}\n"
+    "void main() {\n"
+    "  float column = floor(fragTexCoord.x * size.x);\n"
+    "  float first = floor(range.x + column * range.y);\n"
+    "  float last = max(first, ceil(range.x + (column + 1.0) * range.y) - 1.0);\n"
+    "  first = max(first, 0.0);\n"
+    "  last = min(last, level.y - 1.0);\n"
+    "  if (last < first) discard;\n"
+    "  vec4 peak = bucket(first);\n"
+    "  for (int tap = 1; tap < " WAVEFORM_STRINGIFY(WAVEFORM_MAX_TAPS) "; tap++) {\n"
+    "    float index = first + float(tap);\n"
+    "    if (index > last) break;\n"
+    "    vec4 next = bucket(index);\n"
+    "    peak = vec4(min(peak.xz, next.xz), max(peak.yw, next.yw)).xzyw;\n"
+    "  }\n"
+    "  float lane_pos = fragTexCoord.y * channels;\n"
+    "  float lane = min(floor(lane_pos), channels - 1.0);\n"
+    "  vec2 span = mix(peak.xy, peak.zw, step(0.5, lane));\n"
+    "  float y = 1.0 - 2.0 * (lane_pos - lane);\n"
+    "  float half_pixel = channels / size.y;\n"
+    "  if (y < span.x - half_pixel || y > span.y + half_pixel) discard;\n"
+    "  " WAVEFORM_GLSL_FRAG_COLOR " = fragColor;\n"
+    "}\n";
+
+bool waveform_renderer_init(WaveformRenderer *renderer) {
+  memset(renderer, 0, sizeof(WaveformRenderer));
+  renderer->shader = LoadShaderFromMemory(NULL, waveform_fs);
+  renderer->ready = renderer->shader.id != 0 &&
+                    renderer->shader.id != rlGetShaderIdDefault();
+  if (!renderer->ready) {
+    TraceLog(LOG_WARNING,
+             "[raylib][UI] Waveform shader unavailable, drawing on the CPU");
+    return false;
+  }
+  renderer->loc_size = GetShaderLocation(renderer->shader, "size");
+  renderer->loc_texture_size =
+      GetShaderLocation(renderer->shader, "textureSize");
+  renderer->loc_level = GetShaderLocation(renderer->shader, "level");
+  renderer->loc_range = GetShaderLocation(renderer->shader, "range");
+  renderer->loc_channels = GetShaderLocation(renderer->shader, "channels");
+  return true;
+}
+
+void waveform_renderer_shutdown(WaveformRenderer *renderer) {
+  if (renderer->ready) {
+    UnloadShader(renderer->shader);
+  }
+  memset(renderer, 0, sizeof(WaveformRenderer));
+}
+
+// ============================================================================
+// TEXTURES
+// ============================================================================
+
+bool waveform_texture_create(WaveformTexture *waveform,
+                             const ClipCache *cache) {
+  memset(waveform, 0, sizeof(WaveformTexture));
+  const ClipCacheHeader *header = cache->header;
+
+  uint64_t total = 0;
+  for (uint32_t level = 0; level < header->peak_levels; level++) {
+    waveform->level_offset[level] = total;
+    waveform->level_count[level] = header->peak_count[level];
+    total += header->peak_count[level];
+  }
+  if (total == 0) {
+    return false;
+  }
+
+  int width = total < WAVEFORM_TEXTURE_WIDTH ? (int)total
+                                             : WAVEFORM_TEXTURE_WIDTH;
+  int height = (int)((total + (uint64_t)width - 1) / (uint64_t)width);
+  float *texels = calloc((size_t)width * (size_t)height * 4, sizeof(float));
+  if (!texels) {
+    TraceLog(LOG_WARNING, "[raylib][UI] Out of memory for waveform peaks");
+    return false;
+  }
+
+  // Mono caches hand channel 0 back for channel 1
+  for (uint32_t level = 0; level < header->peak_levels; level++) {
+    uint64_t count = 0;
+    const ClipPeak *left = clip_cache_peaks(cache, level, 0, &count);
+    const ClipPeak *right = clip_cache_peaks(cache, level, 1, &count);
+    float *texel = texels + waveform->level_offset[level] * 4;
+    for (uint64_t i = 0; i < count; i++, texel += 4) {
+      texel[0] = left[i].min;
+      texel[1] = left[i].max;
+      texel[2] = right[i].min;
+      texel[3] = right[i].max;
+    }
+  }
+
+  Image image = {.data = texels,
+                 .width = width,
+                 .height = height,
+                 .mipmaps = 1,
+                 .format = PIXELFORMAT_UNCOMPRESSED_R32G32B32A32};
+  waveform->texture = LoadTextureFromImage(image);
+  if (waveform->texture.id == 0) {
+    TraceLog(LOG_WARNING,
+             "[raylib][UI] Float textures unavailable, drawing waveform on "
+             "the CPU");
+    waveform->texels = texels;
+  } else {
+    SetTextureFilter(waveform->texture, TEXTURE_FILTER_POINT);
+    free(texels);
+  }
+
+  waveform->source = cache->base;
+  waveform->frame_count = header->frame_count;
+  waveform->channels = header->channels;
+  waveform->levels = header->peak_levels;
+  return true;
+}
+
+void waveform_texture_destroy(WaveformTexture *waveform) {
+  if (waveform->texture.id != 0) {
+    UnloadTexture(waveform->texture);
+  }
+  free(waveform->texels);
+  memset(waveform, 0, sizeof(WaveformTexture));
+}
+
+// ============================================================================
+// DRAWING
+// ============================================================================
+
+// Same rule as clip_cache_peak_level_for, without touching the cache
+static uint32_t level_for(const WaveformTexture *waveform,
+                          double frames_per_pixel) {
+  uint32_t level = 0;
+  double width = CLIP_CACHE_PEAK_FRAMES * CLIP_CACHE_PEAK_FACTOR;
+  while (level + 1 < waveform->levels && width <= frames_per_pixel) {
+    level++;
+    width *= CLIP_CACHE_PEAK_FACTOR;
+  }
+  return level;
+}
+
+// Fallback: one rectangle per pixel column and channel, still bounded by
+// the width of the view rather than the length of the clip
+static void draw_columns(const WaveformTexture *waveform, uint32_t level,
+                         Rectangle bounds, double first_bucket,
+                         double buckets_per_pixel, Color color) {
+  int columns = (int)bounds.width;
+  uint32_t lanes = waveform->channels > 1 ? 2 : 1;
+  float lane_height = bounds.height / (float)lanes;
+  int64_t count = (int64_t)waveform->level_count[level];
+  const float *texels = waveform->texels + waveform->level_offset[level] * 4;
+
+  for (int column = 0; column < columns; column++) {
+    int64_t first = (int64_t)floor(first_bucket + column * buckets_per_pixel);
+    int64_t last = (int64_t)ceil(first_bucket +
+                                 (column + 1) * buckets_per_pixel) - 1;
+    if (last < first) {
+      last = first;
+    }
+    if (first < 0) {
+      first = 0;
+    }
+    if (last >= count) {
+      last = count - 1;
+    }
+    if (last < first) {
+      continue;
+    }
+    for (uint32_t lane = 0; lane < lanes; lane++) {
+      float low = texels[first * 4 + lane * 2];
+      float high = texels[first * 4 + lane * 2 + 1];
+      for (int64_t i = first + 1; i <= last; i++) {
+        low = fminf(low, texels[i * 4 + lane * 2]);
+        high = fmaxf(high, texels[i * 4 + lane * 2 + 1]);
+      }
+      float centre = bounds.y + lane_height * ((float)lane + 0.5F);
+      float top = centre - high * lane_height * 0.5F;
+      float bottom = centre - low * lane_height * 0.5F;
+      DrawRectangleRec((Rectangle){bounds.x + (float)column, top, 1.0F,
+                                   fmaxf(bottom - top, 1.0F)},
+                       color);
+    }
+  }
+}
+
+void waveform_draw(const WaveformRenderer *renderer,
+                   const WaveformTexture *waveform, Rectangle bounds,
+                   uint64_t start_frame, uint64_t frame_span, Color color) {
+  if (waveform->levels == 0 || frame_span == 0 || bounds.width < 1.0F ||
+      bounds.height < 1.0F) {
+    return;
+  }
+  double frames_per_pixel = (double)frame_span / bounds.width;
+  uint32_t level = level_for(waveform, frames_per_pixel);
+  double bucket_frames =
+      CLIP_CACHE_PEAK_FRAMES * pow(CLIP_CACHE_PEAK_FACTOR, level);
+  double first_bucket = (double)start_frame / bucket_frames;
+  double buckets_per_pixel = frames_per_pixel / bucket_frames;
+
+  if (!renderer->ready || waveform->texture.id == 0) {
+    if (waveform->texels) {
+      draw_columns(waveform, level, bounds, first_bucket, buckets_per_pixel,
+                   color);
+    }
+    return;
+  }
+
+  float size[2] = {bounds.width, bounds.height};
+  float texture_size[2] = {(float)waveform->texture.width,
+                           (float)waveform->texture.height};
+  float level_range[2] = {(float)waveform->level_offset[level],
+                          (float)waveform->level_count[level]};
+  float bucket_range[2] = {(float)first_bucket, (float)buckets_per_pixel};
+  float channels = waveform->channels > 1 ? 2.0F : 1.0F;
+
+  // Uniforms change per waveform; Begin/End flush around this one quad
+  BeginShaderMode(renderer->shader);
+  SetShaderValue(renderer->shader, renderer->loc_size, size,
+                 SHADER_UNIFORM_VEC2);
+  SetShaderValue(renderer->shader, renderer->loc_texture_size, texture_size,
+                 SHADER_UNIFORM_VEC2);
+  SetShaderValue(renderer->shader, renderer->loc_level, level_range,
+                 SHADER_UNIFORM_VEC2);
+  SetShaderValue(renderer->shader, renderer->loc_range, bucket_range,
+                 SHADER_UNIFORM_VEC2);
+  SetShaderValue(renderer->shader, renderer->loc_channels, &channels,
+                 SHADER_UNIFORM_FLOAT);
+  DrawTexturePro(waveform->texture,
+                 (Rectangle){0, 0, texture_size[0], texture_size[1]}, bounds,
+                 (Vector2){0, 0}, 0.0F, color);
+  EndShaderMode();
+}
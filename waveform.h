@@ -0,0 +1,66 @@
+// waveform.h - GPU waveform drawing from clip cache peak pyramids
+// Every peak level of a clip cache is uploaded once into a float texture
+// (one texel per bucket: channel 0 min/max, channel 1 min/max). A draw
+// picks the level whose buckets are closest to one pixel wide and shades
+// a single quad, so an hour-long clip costs the same at any zoom.
+#pragma once
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+#include "clip_cache.h"
+#include "raylib.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Buckets are laid out row-major in rows of this many texels, keeping
+// long clips inside every GPU's texture size limit
+#define WAVEFORM_TEXTURE_WIDTH 4096
+
+// Bucket reads per pixel column in the shader. Level selection keeps a
+// column under CLIP_CACHE_PEAK_FACTOR buckets (+1 for straddling).
+#define WAVEFORM_MAX_TAPS 8
+
+typedef struct {
+  Texture2D texture;              // id 0 = upload failed, draw from texels
+  float *texels;                  // CPU copy, kept only when texture is 0
+  const uint8_t *source;          // Mapped cache base the texture was built from
+  uint64_t frame_count;
+  uint32_t channels;
+  uint32_t levels;
+  uint64_t level_offset[CLIP_CACHE_MAX_PEAK_LEVELS];  // First texel of each level
+  uint64_t level_count[CLIP_CACHE_MAX_PEAK_LEVELS];   // Buckets in each level
+} WaveformTexture;
+
+typedef struct {
+  Shader shader;
+  bool ready;                     // Shader compiled; false draws on the CPU
+  int loc_size;
+  int loc_texture_size;
+  int loc_level;                  // (first texel, bucket count)
+  int loc_range;                  // (first bucket, buckets per pixel)
+  int loc_channels;
+} WaveformRenderer;
+
+// Compile the waveform shader (needs a GL context)
+bool waveform_renderer_init(WaveformRenderer *renderer);
+void waveform_renderer_shutdown(WaveformRenderer *renderer);
+
+// Upload every peak level of `cache`. The texture owns its data, so the
+// cache may be closed afterwards.
+bool waveform_texture_create(WaveformTexture *waveform, const ClipCache *cache);
+void waveform_texture_destroy(WaveformTexture *waveform);
+
+// True if `waveform` was built from this cache mapping
+static inline bool waveform_texture_matches(const WaveformTexture *waveform,
+                                            const ClipCache *cache) {
+  return cache && waveform->levels > 0 && waveform->source == cache->base &&
+         waveform->frame_count == clip_cache_frame_count(cache);
+}
+
+// Draw frames [start_frame, start_frame + frame_span) across `bounds`,
+// channels stacked top to bottom
+void waveform_draw(const WaveformRenderer *renderer,
+                   const WaveformTexture *waveform, Rectangle bounds,
+                   uint64_t start_frame, uint64_t frame_span, Color color);
+
+#endif // WAVEFORM_H
@@ -0,0 +1,174 @@
+#include "worker_pool.h"
+#include "engine_thread.h"
+#include "engine_trace.h"
+#include <stdatomic.h>
+#include <string.h>
+
+// ============================================================================
+// TICKETS
+// ============================================================================
+
+// Ticket layout: [batch:32][job_count:16][next_index:16]. Packing the count
+// with the batch id means a worker can never claim a job from a batch it
+// did not observe, and never reads a job count being rewritten.
+#define TICKET_MAX_JOBS 0xFFFF
+
+static inline uint64_t make_ticket(uint32_t batch, uint32_t job_count, uint32_t index) {
+    return ((uint64_t)batch << 32) | ((uint64_t)(job_count & 0xFFFF) << 16) | (uint64_t)(index & 0xFFFF);
+}
+
+static inline uint32_t ticket_batch(uint64_t ticket) { return (uint32_t)(ticket >> 32); }
+static inline uint32_t ticket_count(uint64_t ticket) { return (uint32_t)(ticket >> 16) & 0xFFFF; }
+static inline uint32_t ticket_index(uint64_t ticket) { return (uint32_t)ticket & 0xFFFF; }
+
+// Claim and run jobs of the given batch until none are left
+static void claim_and_run(WorkerPool* pool, uint32_t batch) {
+    uint64_t ticket = atomic_load_explicit(&pool->ticket, memory_order_acquire);
+    for (;;) {
+        if (ticket_batch(ticket) != batch || ticket_index(ticket) >= ticket_count(ticket)) {
+            return;
+        }
+        if (atomic_compare_exchange_weak_explicit(&pool->ticket, &ticket, ticket + 1,
+                                                  memory_order_acq_rel, memory_order_acquire)) {
+            pool->job_fn(pool->job_context, (int)ticket_index(ticket));
+            atomic_fetch_add_explicit(&pool->jobs_done, 1, memory_order_release);
+            ticket = atomic_load_explicit(&pool->ticket, memory_order_acquire);
+        }
+    }
+}
+
+// ============================================================================
+// WORKER THREADS
+// ============================================================================
+
+// Wait until a batch newer than `seen` is issued (or the pool stops)
+static uint32_t wait_for_batch(WorkerPool* pool, uint32_t seen) {
+    for (;;) {
+        for (int spin = 0; spin < WORKER_POOL_SPIN_COUNT; spin++) {
+            uint32_t batch = ticket_batch(atomic_load_explicit(&pool->ticket, memory_order_acquire));
+            if (batch != seen || !atomic_load_explicit(&pool->running, memory_order_relaxed)) {
+                return batch;
+            }
+            engine_thread_pause();
+        }
+
+        // Announce that we're going to sleep, then re-check so a batch issued
+        // in between is not missed. A stale announcement only causes one
+        // spurious wake-up later.
+        atomic_fetch_add(&pool->sleepers, 1);
+        uint32_t batch = ticket_batch(atomic_load(&pool->ticket));
+        if (batch != seen || !atomic_load(&pool->running)) {
+            return batch;
+        }
+        ma_semaphore_wait(&pool->wake);
+    }
+}
+
+static void worker_main(void* user_data) {
+    WorkerSlot* slot = (WorkerSlot*)user_data;
+    WorkerPool* pool = slot->pool;
+    ENGINE_TRACE_THREAD_NAME("render worker");
+    uint32_t seen = ticket_batch(atomic_load(&pool->ticket));
+
+    while (atomic_load(&pool->running)) {
+        uint32_t batch = wait_for_batch(pool, seen);
+        if (!atomic_load(&pool->running)) {
+            break;
+        }
+        claim_and_run(pool, batch);
+        seen = batch;
+    }
+}
+
+// ============================================================================
+// POOL API
+// ============================================================================
+
+int worker_pool_default_thread_count(void) {
+    int workers = engine_thread_cpu_count() - 1;   // Leave a core for the device thread
+    if (workers < 0) workers = 0;
+    if (workers > WORKER_POOL_MAX_THREADS) workers = WORKER_POOL_MAX_THREADS;
+    return workers;
+}
+
+bool worker_pool_init(WorkerPool* pool, int thread_count, int first_cpu) {
+    memset(pool, 0, sizeof(WorkerPool));
+    if (thread_count > WORKER_POOL_MAX_THREADS) {
+        thread_count = WORKER_POOL_MAX_THREADS;
+    }
+    if (thread_count <= 0) {
+        return true;    // Inline mode
+    }
+
+    if (ma_semaphore_init(0, &pool->wake) != MA_SUCCESS) {
+        return false;
+    }
+    atomic_store(&pool->ticket, make_ticket(0, 0, 0));
+    atomic_store(&pool->running, true);
+
+    for (int i = 0; i < thread_count; i++) {
+        pool->slots[i].pool = pool;
+        pool->slots[i].index = i;
+        int cpu = first_cpu >= 0 ? first_cpu + i : -1;
+        if (!engine_thread_start(&pool->threads[i], worker_main, &pool->slots[i],
+                                 ENGINE_THREAD_PRIORITY_REALTIME, cpu)) {
+            break;
+        }
+        pool->thread_count++;
+    }
+
+    if (pool->thread_count == 0) {
+        atomic_store(&pool->running, false);
+        ma_semaphore_uninit(&pool->wake);
+    }
+    return true;
+}
+
+void worker_pool_shutdown(WorkerPool* pool) {
+    if (pool->thread_count == 0) {
+        return;
+    }
+
+    atomic_store(&pool->running, false);
+    for (int i = 0; i < pool->thread_count; i++) {
+        ma_semaphore_release(&pool->wake);
+    }
+    for (int i = 0; i < pool->thread_count; i++) {
+        engine_thread_join(&pool->threads[i]);
+    }
+    ma_semaphore_uninit(&pool->wake);
+    pool->thread_count = 0;
+}
+
+void worker_pool_run(WorkerPool* pool, WorkerJobFn fn, void* context, int job_count) {
+    if (job_count <= 0) {
+        return;
+    }
+
+    // Nothing to share: run inline
+    if (pool->thread_count == 0 || job_count == 1 || job_count > TICKET_MAX_JOBS) {
+        for (int i = 0; i < job_count; i++) {
+            fn(context, i);
+        }
+        return;
+    }
+
+    // Fan-out: publish the batch with a single release store
+    pool->job_fn = fn;
+    pool->job_context = context;
+    atomic_store_explicit(&pool->jobs_done, 0, memory_order_relaxed);
+    uint32_t batch = ticket_batch(atomic_load_explicit(&pool->ticket, memory_order_relaxed)) + 1;
+    atomic_store_explicit(&pool->ticket, make_ticket(batch, (uint32_t)job_count, 0), memory_order_release);
+
+    // Wake workers that went to sleep since the last batch
+    int sleepers = atomic_exchange(&pool->sleepers, 0);
+    for (int i = 0; i < sleepers; i++) {
+        ma_semaphore_release(&pool->wake);
+    }
+
+    // The issuing thread works too, then waits for stragglers (fan-in)
+    claim_and_run(pool, batch);
+    while (atomic_load_explicit(&pool->jobs_done, memory_order_acquire) < job_count) {
+        engine_thread_pause();
+    }
+}
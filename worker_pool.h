@@ -0,0 +1,63 @@
+// worker_pool.h - Real-time worker pool for parallel rendering
+// A fixed set of pre-spawned, pinned threads that execute batches of jobs
+// issued from the audio callback. Fan-out is a single atomic store; workers
+// claim jobs with a CAS on a batch-tagged ticket and the issuing thread
+// works on the batch too, then spins on a completion counter (fan-in).
+// Idle workers spin briefly before sleeping so back-to-back callbacks never
+// pay a wake-up.
+#pragma once
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include "engine_thread.h"
+#include "vendor/miniaudio/miniaudio.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WORKER_POOL_MAX_THREADS 8
+#define WORKER_POOL_SPIN_COUNT 20000    // Spins before an idle worker sleeps
+
+typedef void (*WorkerJobFn)(void* context, int job_index);
+
+typedef struct WorkerPool WorkerPool;
+
+typedef struct {
+    WorkerPool* pool;
+    int index;
+} WorkerSlot;
+
+struct WorkerPool {
+    int thread_count;
+    EngineThread threads[WORKER_POOL_MAX_THREADS];
+    WorkerSlot slots[WORKER_POOL_MAX_THREADS];
+    ma_semaphore wake;
+    atomic_bool running;
+    atomic_int sleepers;
+
+    // Current batch (written by the issuing thread before the ticket store)
+    WorkerJobFn job_fn;
+    void* job_context;
+    int job_count;
+
+    // High 32 bits: batch id, low 32 bits: next job index
+    _Alignas(64) _Atomic uint64_t ticket;
+    _Alignas(64) atomic_int jobs_done;
+};
+
+// Spawn thread_count workers (0 = run every batch inline on the caller).
+// Workers are pinned to cores first_cpu, first_cpu + 1, ... (or unpinned
+// when first_cpu < 0).
+bool worker_pool_init(WorkerPool* pool, int thread_count, int first_cpu);
+
+// Stop and join all workers
+void worker_pool_shutdown(WorkerPool* pool);
+
+// Run fn(context, 0..job_count-1) across the pool and the calling thread.
+// Returns once every job has finished. Real-time safe; never allocates.
+void worker_pool_run(WorkerPool* pool, WorkerJobFn fn, void* context, int job_count);
+
+// Suggested worker count for this machine (cores minus the audio thread)
+int worker_pool_default_thread_count(void);
+
+#endif // WORKER_POOL_H